@@ -171,6 +171,7 @@ extern const char trap_git_version[];
 #define TRAP_IFC_TYPE_UNIX      'u' ///< trap_ifc_tcpip via UNIX socket(input&output part)
 #define TRAP_IFC_TYPE_SERVICE   's' ///< service ifc
 #define TRAP_IFC_TYPE_FILE      'f' ///< trap_ifc_file (input&output part)
+#define TRAP_IFC_TYPE_SHM       'm' ///< trap_ifc_shm via shared memory (input&output part)
 extern char trap_ifc_type_supported[];
 
 /**
@@ -194,12 +195,14 @@ enum trap_ifc_type {
 enum trap_ifcctl_request {
    TRAPCTL_AUTOFLUSH_TIMEOUT = 1,  ///< Set timeout of automatic buffer flushing for interface, expects uint64_t argument with number of microseconds. It can be set to #TRAP_NO_AUTO_FLUSH to disable autoflush.
    TRAPCTL_BUFFERSWITCH = 2,       ///< Enable/disable buffering - could be dangerous on input interface!!! expects char argument with value 1 (default value after libtrap initialization - enabled) or 0 (for disabling buffering on interface).
-   TRAPCTL_SETTIMEOUT = 3          ///< Set interface timeout (int32_t): in microseconds for non-blocking mode; timeout can be also: TRAP_WAIT, TRAP_HALFWAIT, or TRAP_NO_WAIT.
+   TRAPCTL_SETTIMEOUT = 3,         ///< Set interface timeout (int32_t): in microseconds for non-blocking mode; timeout can be also: TRAP_WAIT, TRAP_HALFWAIT, or TRAP_NO_WAIT.
+   TRAPCTL_RECV_QUOTA = 4,         ///< Set maximal number (uint32_t) of consecutive messages returned from input interface by trap_ctx_recv_any() while other interfaces have data, 0 (default) means the whole buffer.
+   TRAPCTL_MPSC = 5                ///< Enable multi-producer sending on output interface (see #trap_ctx_send()), expects uint32_t argument with number of staging buffers per thread (1 to 64). It cannot be disabled.
 };
 /**@}*/
 
 #ifndef TRAP_IFC_MESSAGEQ_SIZE
-#define TRAP_IFC_MESSAGEQ_SIZE 100000 ///< size of message queue used for buffering
+#define TRAP_IFC_MESSAGEQ_SIZE 100000 ///< default size of message queue used for buffering (incl. buffer header), see setter "bufsize"
 #endif
 
 /**
@@ -536,6 +539,38 @@ int trap_send_data(unsigned int ifcidx, const void *data, uint16_t size, int tim
  */
 int trap_recv(uint32_t ifcidx, const void **data, uint16_t *size);
 
+/**
+ * \brief Receive all messages of the current buffer from input interface.
+ *
+ * Like trap_recv() but it returns up to `max` messages at once, the rest
+ * of messages (if any) is returned by the next call.
+ *
+ * @param[in] ifcidx    Index of input IFC.
+ * @param[out] data     Array of (at least `max`) pointers to received messages.
+ * @param[out] sizes    Array of (at least `max`) sizes of received messages.
+ * @param[in] max       Maximal number of messages to return.
+ * @param[out] count    Number of returned messages.
+ * @return Error code - #TRAP_E_OK on success, #TRAP_E_TIMEOUT if timeout elapses.
+ *
+ * \note Data are valid until the next call of trap_recv() or trap_recv_bulk().
+ * \see trap_ctx_recv_bulk()
+ */
+int trap_recv_bulk(uint32_t ifcidx, const void **data, uint16_t *sizes, uint32_t max, uint32_t *count);
+
+/**
+ * \brief Receive a message from any of selected input interfaces.
+ *
+ * @param[in] ifc_mask  Mask of interfaces (if *i*-th bit is set, interface *i* is selected).
+ * @param[out] ifcidx   Index of input IFC the message was received from.
+ * @param[out] data     Pointer to received data.
+ * @param[out] size     Size of received data in bytes of data.
+ * @param[in] timeout   Timeout in microseconds, #TRAP_WAIT or #TRAP_NO_WAIT.
+ * @return Error code - #TRAP_E_OK on success, #TRAP_E_TIMEOUT if timeout elapses.
+ *
+ * \see trap_ctx_recv_any()
+ */
+int trap_recv_any(uint32_t ifc_mask, uint32_t *ifcidx, const void **data, uint16_t *size, int timeout);
+
 /**
  * \brief Send data via output interface.
  *
@@ -678,6 +713,29 @@ int trap_ctx_terminate(trap_ctx_t *ctx);
  */
 int trap_ctx_recv(trap_ctx_t *ctx, uint32_t ifc, const void **data, uint16_t *size);
 
+/**
+ * \brief Read all messages of the current buffer from input interface.
+ *
+ * Messages that remain in the buffer of input interface are parsed under
+ * one lock and returned as an array, counters of received messages are
+ * updated once per call.  If the buffer is empty, new data are received
+ * at first (respecting timeout of the interface).  At most `max` messages
+ * are returned, the rest stays in the buffer for the next call.
+ *
+ * \param[in] ctx    Pointer to the private libtrap context data (#trap_ctx_init()).
+ * \param[in] ifc    Index of input interface (counted from 0).
+ * \param[out] data  Array of (at least `max`) pointers to received messages.
+ * \param[out] sizes Array of (at least `max`) sizes of received messages in bytes.
+ * \param[in] max    Maximal number of messages to return.
+ * \param[out] count Number of returned messages.
+ *
+ * \return Error code - TRAP_E_OK on success, TRAP_E_TIMEOUT if timeout elapses,
+ * TRAP_E_FORMAT_CHANGED when the messages are valid but data format has changed.
+ * \note Data are valid until the next call of #trap_ctx_recv() or #trap_ctx_recv_bulk() on the interface.
+ * \see #trap_ctx_ifcctl
+ */
+int trap_ctx_recv_bulk(trap_ctx_t *ctx, uint32_t ifc, const void **data, uint16_t *sizes, uint32_t max, uint32_t *count);
+
 /**
  * \brief Read data from input interfaces according to ifc_mask.
  *
@@ -700,6 +758,37 @@ int trap_ctx_recv(trap_ctx_t *ctx, uint32_t ifc, const void **data, uint16_t *si
  */
 int trap_ctx_multi_recv(trap_ctx_t *ctx, uint32_t ifc_mask, const void **data, uint16_t *size);
 
+/**
+ * \brief Read a message from whichever of selected input interfaces has data first.
+ *
+ * Messages that remain in buffers of the interfaces are returned without
+ * any syscall.  When the buffers are empty, descriptors of all selected
+ * interfaces are waited for in one epoll set by the calling thread (no
+ * reader threads are involved).  Interfaces without a descriptor (e.g.
+ * shared memory or file) are polled every 10 ms while waiting.
+ *
+ * Interfaces are served in turn by buffers: all messages of the current
+ * buffer of an interface are returned before the next interface.  Setting
+ * #TRAPCTL_RECV_QUOTA on an input interface limits the number of its
+ * consecutive messages when other interfaces have data, so a busy
+ * interface cannot delay a quiet one by whole buffers.
+ *
+ * \param[in] ctx       Pointer to the private libtrap context data (#trap_ctx_init()).
+ * \param[in] ifc_mask  Mask of interfaces (if *i*-th bit is set, interface *i* is selected).
+ * \param[out] ifc      Index of interface the message (or error) comes from.
+ * \param[out] data     Pointer to received message.
+ * \param[out] size     Size of received message in bytes.
+ * \param[in] timeout   Timeout in microseconds, #TRAP_WAIT to wait indefinitely, #TRAP_NO_WAIT to return immediately.
+ *
+ * \return Error code - TRAP_E_OK on success, TRAP_E_TIMEOUT if timeout elapses,
+ * TRAP_E_FORMAT_CHANGED when the message is valid but data format of `ifc` has changed,
+ * other errors of trap_ctx_recv() are returned with `ifc` set.
+ * \note Data are valid until the next receive call on the interface.  Timeouts
+ * of interfaces (#TRAPCTL_SETTIMEOUT) are not used.  The function must not be
+ * called concurrently with other receive functions on the same interfaces.
+ */
+int trap_ctx_recv_any(trap_ctx_t *ctx, uint32_t ifc_mask, uint32_t *ifc, const void **data, uint16_t *size, int timeout);
+
 /**
  * \brief Send data via output interface.
  *
@@ -708,6 +797,14 @@ int trap_ctx_multi_recv(trap_ctx_t *ctx, uint32_t ifc_mask, const void **data, u
  * lost connection), wait until write is possible or `timeout` microseconds
  * elapses. If `timeout` < 0, wait indefinitely.
  *
+ * Threads that send into the same interface are serialized by its lock.
+ * With multi-producer sending (#TRAPCTL_MPSC or setter `mpsc=N`), every
+ * thread stores messages into its own staging buffers that are sent by
+ * a sender thread of the interface, so threads do not wait for each other.
+ * Messages of one thread keep their order, messages of different threads
+ * are interleaved by whole buffers.  Timeout then limits waiting for a free
+ * staging buffer of the thread.
+ *
  * \param[in] ctx    Pointer to the private libtrap context data (#trap_ctx_init()).
  * \param[in] ifc    Index of interface to write into.
  * \param[in] data   Pointer to data.
@@ -717,6 +814,41 @@ int trap_ctx_multi_recv(trap_ctx_t *ctx, uint32_t ifc_mask, const void **data, u
  */
 int trap_ctx_send(trap_ctx_t *ctx, unsigned int ifc, const void *data, uint16_t size);
 
+/**
+ * \brief Reserve space for a message directly in the buffer of output interface.
+ *
+ * Instead of building a message in own memory and copying it by
+ * #trap_ctx_send(), a module can obtain a pointer into the output buffer,
+ * write up to `max_size` bytes of the message there and finish it by
+ * #trap_ctx_send_commit().  If there is not enough space in the buffer,
+ * the buffer is sent at first (the same way as by #trap_ctx_send()).
+ *
+ * The interface stays locked until #trap_ctx_send_commit() is called
+ * from the same thread, therefore no other libtrap function must be
+ * called on this interface in the meantime.  With multi-producer sending,
+ * only the staging buffers of the calling thread are locked.
+ *
+ * \param[in] ctx       Pointer to the private libtrap context data (#trap_ctx_init()).
+ * \param[in] ifc       Index of interface to write into.
+ * \param[in] max_size  Maximal size of the message in bytes.
+ * \param[out] data     Pointer to reserved space, NULL on error.
+ * \return Error code - 0 on success, TRAP_E_TIMEOUT if timeout elapses
+ * (nothing is reserved and commit must not be called).
+ * \see #trap_ctx_send_commit
+ */
+int trap_ctx_send_reserve(trap_ctx_t *ctx, unsigned int ifc, uint16_t max_size, void **data);
+
+/**
+ * \brief Finish message written into space reserved by #trap_ctx_send_reserve().
+ *
+ * \param[in] ctx    Pointer to the private libtrap context data (#trap_ctx_init()).
+ * \param[in] ifc    Index of interface to write into.
+ * \param[in] size   Real size of the message in bytes, it must not exceed the reserved size.
+ * \return Error code - 0 on success, TRAP_E_TIMEOUT if timeout elapses (when buffering is disabled),
+ * TRAP_E_BAD_FPARAMS if nothing was reserved or `size` is too big (the message is discarded).
+ */
+int trap_ctx_send_commit(trap_ctx_t *ctx, unsigned int ifc, uint16_t size);
+
 /**
  * \brief Set verbosity level of library functions.
  *
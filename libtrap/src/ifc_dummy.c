@@ -46,18 +46,90 @@
 #include <stdint.h>
 #include <inttypes.h>
 #include <assert.h>
+#include <time.h>
+#include <errno.h>
+#include <arpa/inet.h>
 
 #include "../include/libtrap/trap.h"
 #include "trap_ifc.h"
+#include "trap_internal.h"
 #include "trap_error.h"
+#include "ifc_dummy.h"
+#include "ifc_file.h"
 
 /***** Generator *****/
 
+/**
+ * \defgroup generator Generator input IFC
+ *
+ * Generator replays messages of a capture written by file output IFC
+ * (file=) or UniRec records synthesised from a template with random
+ * values (template=).  All messages are loaded into memory when the first
+ * buffer is requested (the required data format is known then) and they
+ * are cut into chunks that fill whole buffers.  Pacing (rate= in records/s,
+ * mbps= in Mbit/s of messages) schedules chunks, so there is at most one
+ * sleep per buffer; a chunk holds at most 10 ms of traffic to keep the
+ * output smooth at low rates.
+ * @{
+ */
+
+#define GENERATOR_DEFAULT_RECORDS 10000 ///< Number of synthesised records when count= is not given
+#define GENERATOR_CHUNKS_PER_SECOND 100 ///< Paced chunk holds at most 1/100 s of traffic
+#define GENERATOR_MAX_SLEEP 100000000ULL ///< Maximal sleep (ns) between checks of termination
+
+#ifndef MAX
+#define MAX(a,b) ((a)<(b)?(b):(a))
+#endif
+#ifndef MIN
+#define MIN(a,b) ((a)>(b)?(b):(a))
+#endif
+
+/**
+ * Part of messages that is returned as one buffer.
+ */
+typedef struct generator_chunk_s {
+   uint64_t offset; ///< Offset of the first message in messages
+   uint32_t size; ///< Size of messages including their headers
+   uint32_t count; ///< Number of messages
+} generator_chunk_t;
+
+/**
+ * Field of synthesised records.
+ */
+typedef struct generator_field_s {
+   const char *type; ///< UniRec type (points into template, not terminated)
+   const char *name; ///< Name of field (points into template, not terminated)
+   uint32_t type_len; ///< Length of type
+   uint32_t name_len; ///< Length of name
+   int32_t size; ///< Size of static field, -1 for dynamic field
+} generator_field_t;
+
 typedef struct generator_private_s {
    trap_ctx_priv_t *ctx;
+   uint32_t ifc_idx;
    char *data_to_send;
    int data_size;
    char is_terminated;
+
+   char *file; ///< Capture to replay (file=), NULL for synthesised records
+   char *template; ///< Fields of synthesised records (template=)
+   uint32_t records; ///< Number of synthesised records (count=)
+   uint64_t seed; ///< State of random generator (seed=)
+   uint64_t loops; ///< Number of passes over messages, 0 means infinite (loop)
+   double rate; ///< Records per second, 0 for unlimited (rate=)
+   double mbps; ///< Mbit/s of messages, 0 for unlimited (mbps=)
+
+   char loaded; ///< Messages were loaded
+   uint8_t *messages; ///< Messages with their headers, i.e. payload of buffers
+   uint64_t messages_size; ///< Size of messages
+   uint64_t messages_allocated; ///< Allocated size of messages
+   generator_chunk_t *chunks; ///< Chunks of messages
+   uint32_t chunk_count; ///< Number of chunks
+   uint32_t next_chunk; ///< Chunk returned by the next recv()
+   uint64_t pass; ///< Number of finished passes
+   uint64_t start; ///< Time of the first paced chunk (CLOCK_MONOTONIC, ns)
+   uint64_t sent_records; ///< Records returned since start
+   uint64_t sent_bytes; ///< Bytes of messages returned since start
 } generator_private_t;
 
 static void create_dump(void *priv, uint32_t idx, const char *path)
@@ -66,6 +138,367 @@ static void create_dump(void *priv, uint32_t idx, const char *path)
    return;
 }
 
+/**
+ * Get current time of CLOCK_MONOTONIC in nanoseconds.
+ *
+ * \return current time
+ */
+static inline uint64_t generator_now(void)
+{
+   struct timespec ts;
+
+   clock_gettime(CLOCK_MONOTONIC, &ts);
+   return (uint64_t) ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+/**
+ * Get next pseudo-random number (xorshift64*).
+ *
+ * \param[in,out] c  private data
+ * \return random number
+ */
+static inline uint64_t generator_random(generator_private_t *c)
+{
+   c->seed ^= c->seed >> 12;
+   c->seed ^= c->seed << 25;
+   c->seed ^= c->seed >> 27;
+   return c->seed * 0x2545F4914F6CDD1DULL;
+}
+
+/**
+ * Append messages to the end of messages.
+ *
+ * \param[in,out] c  private data
+ * \param[in] data   messages with their headers
+ * \param[in] size   size of data
+ * \return TRAP_E_OK on success, TRAP_E_MEMORY
+ */
+static int generator_append(generator_private_t *c, const void *data, uint32_t size)
+{
+   uint64_t new_size;
+   uint8_t *p;
+
+   if (c->messages_size + size > c->messages_allocated) {
+      new_size = (c->messages_allocated == 0) ? (1 << 20) : c->messages_allocated;
+      while (new_size < c->messages_size + size) {
+         new_size *= 2;
+      }
+      p = realloc(c->messages, new_size);
+      if (p == NULL) {
+         return TRAP_E_MEMORY;
+      }
+      c->messages = p;
+      c->messages_allocated = new_size;
+   }
+   memcpy(c->messages + c->messages_size, data, size);
+   c->messages_size += size;
+   return TRAP_E_OK;
+}
+
+/**
+ * Load messages of capture using file input IFC.
+ *
+ * The file IFC negotiates the data format of this IFC, so the module gets
+ * the format of capture.  Compressed captures and captures with latency
+ * trace are not supported.
+ *
+ * \param[in,out] c  private data
+ * \return TRAP_E_OK on success, error code of file IFC, TRAP_E_FORMAT_MISMATCH, TRAP_E_MEMORY
+ */
+static int generator_load_file(generator_private_t *c)
+{
+   trap_input_ifc_t *in = &c->ctx->in_ifc_list[c->ifc_idx];
+   trap_input_ifc_t file;
+   uint32_t size;
+   int result;
+
+   memset(&file, 0, sizeof(file));
+   result = create_file_recv_ifc(c->ctx, c->file, &file, c->ifc_idx);
+   if (result != TRAP_E_OK) {
+      VERBOSE(CL_ERROR, "Generator IFC could not open capture %s.", c->file);
+      return result;
+   }
+   while (1) {
+      result = file.recv(file.priv, in->buffer, &size, TRAP_WAIT);
+      if (result != TRAP_E_OK) {
+         break;
+      }
+      if ((size == sizeof(uint16_t)) && (*((uint16_t *) in->buffer) == 0)) {
+         /* end of capture */
+         break;
+      }
+      if ((in->codec != TRAP_CODEC_NONE) || (in->trace != 0)) {
+         VERBOSE(CL_ERROR, "Generator IFC cannot replay compressed capture or capture with latency trace.");
+         result = TRAP_E_FORMAT_MISMATCH;
+         break;
+      }
+      result = generator_append(c, in->buffer, size);
+      if (result != TRAP_E_OK) {
+         break;
+      }
+   }
+   file.destroy(file.priv);
+   return result;
+}
+
+/**
+ * Parse template of synthesised records.
+ *
+ * Fields are sorted like UniRec sorts fields of template: static fields
+ * from the biggest one, dynamic fields at the end, fields of the same size
+ * by name.
+ *
+ * \param[in] template  fields "type NAME+type NAME+..."
+ * \param[out] count    number of fields
+ * \return array of fields, NULL on error
+ */
+static generator_field_t *generator_parse_template(const char *template, uint32_t *count)
+{
+   generator_field_t *fields, f;
+   const char *p, *next, *space;
+   uint32_t i, j, n = 1, len;
+
+   for (p = template; *p != '\0'; p++) {
+      n += (*p == '+');
+   }
+   fields = calloc(n, sizeof(generator_field_t));
+   if (fields == NULL) {
+      return NULL;
+   }
+   for (i = 0, p = template; i < n; i++, p = next + 1) {
+      next = strchr(p, '+');
+      len = (next == NULL) ? strlen(p) : (uint32_t) (next - p);
+      space = memchr(p, ' ', len);
+      if ((space == NULL) || (space == p) || (space == p + len - 1)) {
+         VERBOSE(CL_ERROR, "Field of generator template must be \"type NAME\": %.*s", (int) len, p);
+         free(fields);
+         return NULL;
+      }
+      f.type = p;
+      f.type_len = space - p;
+      f.name = space + 1;
+      f.name_len = len - f.type_len - 1;
+      f.size = trap_ur_type_size(f.type, f.type_len);
+      if ((f.size < 0) && (f.type[f.type_len - 1] != '*') &&
+          !((f.type_len == 6) && (strncmp(f.type, "string", 6) == 0)) &&
+          !((f.type_len == 5) && (strncmp(f.type, "bytes", 5) == 0))) {
+         VERBOSE(CL_ERROR, "Unknown type of field of generator template: %.*s", (int) f.type_len, f.type);
+         free(fields);
+         return NULL;
+      }
+      /* insertion sort, there are only a few fields */
+      for (j = i; (j > 0) && ((fields[j - 1].size < f.size) || ((fields[j - 1].size == f.size) &&
+           (strncmp(fields[j - 1].name, f.name, MAX(fields[j - 1].name_len, f.name_len)) > 0))); j--) {
+         fields[j] = fields[j - 1];
+      }
+      fields[j] = f;
+      if (next == NULL) {
+         n = i + 1;
+         break;
+      }
+   }
+   *count = n;
+   return fields;
+}
+
+/**
+ * Synthesise UniRec records from template with random values.
+ *
+ * IPv4 addresses are taken from 10.0.0.0/8, times are around the current
+ * time, dynamic fields are empty.  Data format of this IFC is set to the
+ * template and it is checked against the required format.
+ *
+ * \param[in,out] c  private data
+ * \return TRAP_E_OK on success, TRAP_E_FORMAT_MISMATCH, TRAP_E_MEMORY, TRAP_E_BADPARAMS
+ */
+static int generator_synthesise(generator_private_t *c)
+{
+   trap_input_ifc_t *in = &c->ctx->in_ifc_list[c->ifc_idx];
+   generator_field_t *fields;
+   uint32_t count, i, j, record_size = 0;
+   uint8_t *record = NULL, *p;
+   uint64_t now = (uint64_t) time(NULL), v;
+   char *spec = NULL;
+   size_t spec_len = 1;
+   uint16_t header;
+   int result = TRAP_E_MEMORY;
+
+   fields = generator_parse_template(c->template, &count);
+   if (fields == NULL) {
+      return TRAP_E_BADPARAMS;
+   }
+   for (i = 0; i < count; i++) {
+      record_size += (fields[i].size < 0) ? 4 : fields[i].size;
+      spec_len += fields[i].type_len + fields[i].name_len + 2;
+   }
+   spec = calloc(1, spec_len);
+   record = calloc(1, sizeof(header) + record_size);
+   if ((spec == NULL) || (record == NULL) || (record_size > UINT16_MAX)) {
+      goto exit;
+   }
+   for (i = 0; i < count; i++) {
+      sprintf(spec + strlen(spec), "%s%.*s %.*s", (i == 0) ? "" : ",", (int) fields[i].type_len, fields[i].type,
+              (int) fields[i].name_len, fields[i].name);
+   }
+
+   /* the same check as negotiation of data format does */
+   if ((in->req_data_type != TRAP_FMT_UNIREC) || (trap_ctx_cmp_data_fmt(spec, in->req_data_fmt_spec) == TRAP_E_FIELDS_MISMATCH)) {
+      VERBOSE(CL_ERROR, "Records of generator IFC (%s) do not match the required data format.", spec);
+      in->client_state = FMT_MISMATCH;
+      result = TRAP_E_FORMAT_MISMATCH;
+      goto exit;
+   }
+   in->client_state = (trap_ctx_cmp_data_fmt(spec, in->req_data_fmt_spec) == TRAP_E_FIELDS_SUBSET) ? FMT_CHANGED : FMT_OK;
+   in->data_type = TRAP_FMT_UNIREC;
+   free(in->data_fmt_spec);
+   in->data_fmt_spec = spec;
+   spec = NULL;
+
+   header = record_size;
+   memcpy(record, &header, sizeof(header));
+   for (j = 0; j < c->records; j++) {
+      p = record + sizeof(header);
+      for (i = 0; i < count; i++) {
+         v = generator_random(c);
+         if (fields[i].size < 0) {
+            /* empty dynamic field: offset and length 0 */
+            memset(p, 0, 4);
+            p += 4;
+            continue;
+         }
+         if ((fields[i].type_len == 6) && (strncmp(fields[i].type, "ipaddr", 6) == 0)) {
+            memset(p, 0, 8);
+            *((uint32_t *) (p + 8)) = htonl(0x0a000000 | (v & 0x00ffffff));
+            *((uint32_t *) (p + 12)) = 0xffffffff;
+         } else if ((fields[i].type_len == 4) && (strncmp(fields[i].type, "time", 4) == 0)) {
+            /* UniRec time: seconds and fraction, at most 1 minute before now */
+            v = ((now - (v % 60)) << 32) | (v & 0xffffffff);
+            memcpy(p, &v, sizeof(v));
+         } else if ((fields[i].type_len == 5) && (strncmp(fields[i].type, "float", 5) == 0)) {
+            *((float *) p) = (float) (v % 100000) / 100;
+         } else if ((fields[i].type_len == 6) && (strncmp(fields[i].type, "double", 6) == 0)) {
+            *((double *) p) = (double) (v % 100000) / 100;
+         } else if ((fields[i].type_len == 4) && (strncmp(fields[i].type, "char", 4) == 0)) {
+            *p = 'a' + v % 26;
+         } else {
+            memcpy(p, &v, fields[i].size);
+         }
+         p += fields[i].size;
+      }
+      result = generator_append(c, record, sizeof(header) + record_size);
+      if (result != TRAP_E_OK) {
+         goto exit;
+      }
+   }
+   result = TRAP_E_OK;
+exit:
+   free(spec);
+   free(record);
+   free(fields);
+   return result;
+}
+
+/**
+ * Cut messages into chunks that fit into the buffer of IFC.
+ *
+ * \param[in,out] c  private data
+ * \return TRAP_E_OK on success, TRAP_E_MEMORY, TRAP_E_IO_ERROR for malformed messages
+ */
+static int generator_make_chunks(generator_private_t *c)
+{
+   uint32_t capacity = c->ctx->in_ifc_list[c->ifc_idx].buffer_size;
+   uint64_t offset = 0, max_count = UINT32_MAX, max_size = capacity, allocated = 0;
+   uint32_t msize;
+   generator_chunk_t *ch = NULL, *p;
+
+   if (c->rate > 0) {
+      max_count = MAX(1, c->rate / GENERATOR_CHUNKS_PER_SECOND);
+   }
+   if (c->mbps > 0) {
+      max_size = MIN(max_size, MAX(1, c->mbps * 1000000 / 8 / GENERATOR_CHUNKS_PER_SECOND));
+   }
+   while (offset + sizeof(uint16_t) <= c->messages_size) {
+      msize = sizeof(uint16_t) + *((uint16_t *) (c->messages + offset));
+      if ((offset + msize > c->messages_size) || (msize > capacity)) {
+         VERBOSE(CL_ERROR, "Generator IFC: malformed message at offset %"PRIu64", the rest is skipped.", offset);
+         break;
+      }
+      if ((ch == NULL) || (ch->count >= max_count) || ((ch->size + msize > max_size) && (ch->count > 0)) ||
+          (ch->size + msize > capacity)) {
+         if (c->chunk_count == allocated) {
+            allocated = (allocated == 0) ? 1024 : allocated * 2;
+            p = realloc(c->chunks, allocated * sizeof(generator_chunk_t));
+            if (p == NULL) {
+               return TRAP_E_MEMORY;
+            }
+            c->chunks = p;
+         }
+         ch = &c->chunks[c->chunk_count++];
+         ch->offset = offset;
+         ch->size = ch->count = 0;
+      }
+      ch->size += msize;
+      ch->count++;
+      offset += msize;
+   }
+   return TRAP_E_OK;
+}
+
+/**
+ * Wait until the next chunk is due according to rate and mbps.
+ *
+ * \param[in,out] c   private data
+ * \param[in] timeout  TRAP_WAIT | TRAP_HALFWAIT | TRAP_NO_WAIT | timeout in microseconds
+ * \return TRAP_E_OK when the chunk can be returned, TRAP_E_TIMEOUT, TRAP_E_TERMINATED
+ */
+static int generator_pace(generator_private_t *c, int timeout)
+{
+   uint64_t due = 0, now, deadline = UINT64_MAX, wait;
+   struct timespec ts;
+
+   if ((c->rate <= 0) && (c->mbps <= 0)) {
+      return TRAP_E_OK;
+   }
+   now = generator_now();
+   if (c->start == 0) {
+      c->start = now;
+   }
+   if (c->rate > 0) {
+      due = c->start + (uint64_t) (c->sent_records * 1e9 / c->rate);
+   }
+   if (c->mbps > 0) {
+      due = MAX(due, c->start + (uint64_t) (c->sent_bytes * 8e3 / c->mbps));
+   }
+   if (timeout >= 0) {
+      deadline = now + (uint64_t) timeout * 1000;
+   }
+   while (now < due) {
+      if (c->is_terminated) {
+         return TRAP_E_TERMINATED;
+      }
+      if (now >= deadline) {
+         return TRAP_E_TIMEOUT;
+      }
+      wait = MIN(MIN(due, deadline) - now, GENERATOR_MAX_SLEEP);
+      ts.tv_sec = wait / 1000000000ULL;
+      ts.tv_nsec = wait % 1000000000ULL;
+      nanosleep(&ts, NULL);
+      now = generator_now();
+   }
+   return TRAP_E_OK;
+}
+
+/**
+ * \brief Receive next buffer of generated messages.
+ *
+ * When the last pass is finished, a message of size 0 (end of data) is returned.
+ *
+ * \param[in] priv   pointer to module private data
+ * \param[out] data  pointer to a memory block in which data is to be stored
+ * \param[out] size  pointer to a memory block in which size of data is to be stored
+ * \param[in] timeout  timeout used for pacing
+ * \return TRAP_E_OK, TRAP_E_TIMEOUT, TRAP_E_TERMINATED, TRAP_E_FORMAT_MISMATCH, TRAP_E_MEMORY
+ */
 int generator_recv(void *priv, void *data, uint32_t *size, int timeout)
 {
    assert(data != NULL);
@@ -73,14 +506,54 @@ int generator_recv(void *priv, void *data, uint32_t *size, int timeout)
 
    uint16_t *mh = data;
    void *p = (void *) (mh + 1);
+   generator_chunk_t *ch;
+   int result;
 
    generator_private_t *config = (generator_private_t*) priv;
    if (config->is_terminated) {
       return trap_error(config->ctx, TRAP_E_TERMINATED);
    }
-   *mh = config->data_size;
-   memcpy(p, config->data_to_send, config->data_size);
-   *size = config->data_size;
+   if ((config->file == NULL) && (config->template == NULL)) {
+      *mh = config->data_size;
+      memcpy(p, config->data_to_send, config->data_size);
+      *size = config->data_size;
+      return TRAP_E_OK;
+   }
+
+   if (config->loaded == 0) {
+      result = (config->file != NULL) ? generator_load_file(config) : generator_synthesise(config);
+      if (result == TRAP_E_OK) {
+         result = generator_make_chunks(config);
+      }
+      if (result != TRAP_E_OK) {
+         return result;
+      }
+      VERBOSE(CL_VERBOSE_LIBRARY, "Generator IFC %"PRIu32": %"PRIu64" B of messages in %"PRIu32" buffers.",
+              config->ifc_idx, config->messages_size, config->chunk_count);
+      config->loaded = 1;
+   }
+   /* loading may have reallocated the buffer of IFC */
+   data = config->ctx->in_ifc_list[config->ifc_idx].buffer;
+
+   if (config->next_chunk == config->chunk_count) {
+      config->pass++;
+      config->next_chunk = 0;
+   }
+   if ((config->chunk_count == 0) || ((config->loops != 0) && (config->pass >= config->loops))) {
+      /* end of data */
+      *((uint16_t *) data) = 0;
+      *size = sizeof(uint16_t);
+      return TRAP_E_OK;
+   }
+   result = generator_pace(config, timeout);
+   if (result != TRAP_E_OK) {
+      return result;
+   }
+   ch = &config->chunks[config->next_chunk++];
+   memcpy(data, config->messages + ch->offset, ch->size);
+   *size = ch->size;
+   config->sent_records += ch->count;
+   config->sent_bytes += ch->size - ch->count * sizeof(uint16_t);
    return TRAP_E_OK;
 }
 
@@ -94,14 +567,82 @@ void generator_terminate(void *priv)
 
 void generator_destroy(void *priv)
 {
+   generator_private_t *c = (generator_private_t *) priv;
+
    // Free private data
-   if (priv) {
-      free(((generator_private_t*)priv)->data_to_send);
-      free(priv);
+   if (c) {
+      free(c->data_to_send);
+      free(c->file);
+      free(c->template);
+      free(c->messages);
+      free(c->chunks);
+      free(c);
+   }
+}
+
+/**
+ * Parse key=value parameters of generator.
+ *
+ * \param[in,out] priv  private data
+ * \param[in] params    parameters of IFC
+ * \return TRAP_E_OK on success, TRAP_E_BADPARAMS, TRAP_E_MEMORY
+ */
+static int generator_parse_params(generator_private_t *priv, char *params)
+{
+   char *param_iterator = params, *param = NULL;
+   int ret = TRAP_E_OK;
+
+   while ((param_iterator != NULL) && (ret == TRAP_E_OK)) {
+      param_iterator = trap_get_param_by_delimiter(param_iterator, &param, TRAP_IFC_PARAM_DELIMITER);
+      if (param == NULL) {
+         break;
+      }
+      if (strncmp(param, "file=", 5) == 0) {
+         free(priv->file);
+         priv->file = strdup(param + 5);
+      } else if (strncmp(param, "template=", 9) == 0) {
+         free(priv->template);
+         priv->template = strdup(param + 9);
+      } else if (strncmp(param, "count=", 6) == 0) {
+         if ((sscanf(param + 6, "%"SCNu32, &priv->records) != 1) || (priv->records == 0)) {
+            ret = TRAP_E_BADPARAMS;
+         }
+      } else if (strncmp(param, "seed=", 5) == 0) {
+         if ((sscanf(param + 5, "%"SCNu64, &priv->seed) != 1) || (priv->seed == 0)) {
+            ret = TRAP_E_BADPARAMS;
+         }
+      } else if (strncmp(param, "rate=", 5) == 0) {
+         if ((sscanf(param + 5, "%lf", &priv->rate) != 1) || (priv->rate < 0)) {
+            ret = TRAP_E_BADPARAMS;
+         }
+      } else if (strncmp(param, "mbps=", 5) == 0) {
+         if ((sscanf(param + 5, "%lf", &priv->mbps) != 1) || (priv->mbps < 0)) {
+            ret = TRAP_E_BADPARAMS;
+         }
+      } else if (strcmp(param, "loop") == 0) {
+         priv->loops = 0;
+      } else if (strncmp(param, "loop=", 5) == 0) {
+         if (sscanf(param + 5, "%"SCNu64, &priv->loops) != 1) {
+            ret = TRAP_E_BADPARAMS;
+         }
+      } else {
+         VERBOSE(CL_ERROR, "Unknown parameter '%s' of generator IFC.", param);
+         ret = TRAP_E_BADPARAMS;
+      }
+      if (ret == TRAP_E_BADPARAMS) {
+         VERBOSE(CL_ERROR, "Bad value of parameter '%s' of generator IFC.", param);
+      }
+      free(param);
+      param = NULL;
    }
+   if ((ret == TRAP_E_OK) && ((priv->file == NULL) == (priv->template == NULL))) {
+      VERBOSE(CL_ERROR, "Generator IFC needs either file= or template=.");
+      ret = TRAP_E_BADPARAMS;
+   }
+   return ret;
 }
 
-int create_generator_ifc(trap_ctx_priv_t *ctx, char *params, trap_input_ifc_t *ifc)
+int create_generator_ifc(trap_ctx_priv_t *ctx, char *params, trap_input_ifc_t *ifc, uint32_t idx)
 {
    generator_private_t *priv = NULL;
    char *param_iterator = NULL;
@@ -114,6 +655,27 @@ int create_generator_ifc(trap_ctx_priv_t *ctx, char *params, trap_input_ifc_t *i
       return TRAP_E_BADPARAMS;
    }
 
+   // Create structure to store private data
+   priv = calloc(1, sizeof(generator_private_t));
+   if (!priv) {
+      ret = TRAP_E_MEMORY;
+      goto failure;
+   }
+   priv->ctx = ctx;
+   priv->ifc_idx = idx;
+   priv->is_terminated = 0;
+
+   if (strchr(params, '=') != NULL) {
+      priv->records = GENERATOR_DEFAULT_RECORDS;
+      priv->seed = 1;
+      priv->loops = 1;
+      ret = generator_parse_params(priv, params);
+      if (ret != TRAP_E_OK) {
+         goto failure;
+      }
+      goto done;
+   }
+
    /* Parsing params */
    param_iterator = trap_get_param_by_delimiter(params, &n_str, TRAP_IFC_PARAM_DELIMITER);
    if (n_str == NULL) {
@@ -129,12 +691,6 @@ int create_generator_ifc(trap_ctx_priv_t *ctx, char *params, trap_input_ifc_t *i
       goto failure;
    }
 
-   // Create structure to store private data
-   priv = calloc(1, sizeof(generator_private_t));
-   if (!priv) {
-      ret = TRAP_E_MEMORY;
-      goto failure;
-   }
    param_iterator = trap_get_param_by_delimiter(param_iterator, &priv->data_to_send, TRAP_IFC_PARAM_DELIMITER);
 
    // Store data to send (param) into private data
@@ -149,10 +705,9 @@ int create_generator_ifc(trap_ctx_priv_t *ctx, char *params, trap_input_ifc_t *i
       goto failure;
    }
 
-   priv->ctx = ctx;
-   priv->is_terminated = 0;
    priv->data_size = n;
 
+done:
    // Fill struct defining the interface
    ifc->recv = generator_recv;
    ifc->terminate = generator_terminate;
@@ -162,13 +717,13 @@ int create_generator_ifc(trap_ctx_priv_t *ctx, char *params, trap_input_ifc_t *i
 
    return TRAP_E_OK;
 failure:
-   if (priv != NULL) {
-      free(priv->data_to_send);
-   }
-   free(priv);
+   generator_destroy(priv);
    return ret;
 }
 
+/**
+ * @}
+ */
 
 
 /***** Blackhole *****/
@@ -47,15 +47,17 @@
 #include "trap_ifc.h"
 
 /** Create Generator interface (input ifc).
- *  Receive function of this interface returns always the same data. These data
- *  are given in params on creation.
+ *  Receive function of this interface replays messages of a capture (file=)
+ *  or of UniRec records synthesised from a template (template=), whole
+ *  buffers are filled and paced by rate= or mbps=.  The old form "n:data"
+ *  returns always the same data given in params.
  *  @param[in] ctx   Pointer to the private libtrap context data (#trap_ctx_init()).
- *  @param[in] params Array of n+1 bytes. First byte is equal to n, other bytes
- *                    are data the generator should generate.
+ *  @param[in] params Parameters of the interface, see README.ifcspec.md.
  *  @param[out] ifc Created interface.
+ *  @param[in] idx  Index of the interface.
  *  @return Error code (0 on success). Generated interface is returned in ifc.
  */
-int create_generator_ifc(trap_ctx_priv_t *ctx, char *params, trap_input_ifc_t *ifc);
+int create_generator_ifc(trap_ctx_priv_t *ctx, char *params, trap_input_ifc_t *ifc, uint32_t idx);
 
 
 /** Create Blackhole interface (output ifc).
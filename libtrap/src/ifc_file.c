@@ -49,6 +49,14 @@
 #include <arpa/inet.h>
 #include <wordexp.h>
 #include <unistd.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <dirent.h>
+#include <limits.h>
+#include <time.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 
 #include "../include/libtrap/trap.h"
 #include "trap_ifc.h"
@@ -66,6 +74,1161 @@
  */
 
 
+/**
+ * \brief Parse io=<engine> parameter.
+ * \param[in] param   parameter of IFC
+ * \param[out] io     parsed engine
+ * \return 1 if param is io=<engine> and engine is known, 0 if param is not io=..., -1 on unknown engine
+ */
+static int file_parse_io(const char *param, enum file_io_engine *io)
+{
+   if (strncmp(param, "io=", 3) != 0) {
+      return 0;
+   }
+   if (strcmp(param + 3, "stdio") == 0) {
+      *io = FILE_IO_STDIO;
+   } else if (strcmp(param + 3, "mmap") == 0) {
+      *io = FILE_IO_MMAP;
+   } else if (strcmp(param + 3, "batch") == 0) {
+      *io = FILE_IO_BATCH;
+   } else {
+      VERBOSE(CL_ERROR, "FILE IFC: unknown I/O engine: %s", param + 3);
+      return -1;
+   }
+   return 1;
+}
+
+/**
+ * \brief Unmap input file mapped by file_map_input().
+ * \param[in] c   pointer to module private data
+ */
+static void file_unmap(file_private_t *c)
+{
+   if (c->map != NULL) {
+      munmap(c->map, c->map_size);
+      c->map = NULL;
+   }
+   c->map_size = 0;
+   c->map_pos = 0;
+   c->mapped = 0;
+}
+
+/**
+ * \brief Map the rest of opened input file, i.e. everything after the hello message.
+ * \param[in] c   pointer to module private data
+ * \return TRAP_E_OK on success, TRAP_E_IO_ERROR otherwise
+ */
+static int file_map_input(file_private_t *c)
+{
+   struct stat st;
+   long pos;
+   int fd = fileno(c->fd);
+
+   pos = ftell(c->fd);
+   if ((pos < 0) || (fstat(fd, &st) == -1)) {
+      VERBOSE(CL_ERROR, "INPUT FILE IFC: unable to get size of file: %s", c->filename);
+      return TRAP_E_IO_ERROR;
+   }
+   c->mapped = 1;
+   c->map_pos = pos;
+   c->map_size = st.st_size;
+   if (c->map_size <= c->map_pos) {
+      /* nothing to map, EOF */
+      return TRAP_E_OK;
+   }
+   c->map = mmap(NULL, c->map_size, PROT_READ, MAP_PRIVATE, fd, 0);
+   if (c->map == MAP_FAILED) {
+      VERBOSE(CL_ERROR, "INPUT FILE IFC: mmap of file %s failed: %s", c->filename, strerror(errno));
+      c->map = NULL;
+      c->map_size = 0;
+      return TRAP_E_IO_ERROR;
+   }
+   madvise(c->map, c->map_size, MADV_SEQUENTIAL);
+   posix_fadvise(fd, c->map_pos, 0, POSIX_FADV_SEQUENTIAL);
+   return TRAP_E_OK;
+}
+
+/**
+ * \brief Read one buffer from mapped file (FILE_IO_MMAP engine).
+ * \param[in] c   pointer to module private data
+ * \param[out] data   pointer to a memory block in which data is to be stored
+ * \param[out] size   size of read data
+ * \param[out] eof    set to 1 when the end of file was reached
+ * \return TRAP_E_OK on success, TRAP_E_IO_ERROR otherwise
+ */
+static int file_recv_mmap(file_private_t *c, void *data, uint32_t *size, int *eof)
+{
+   size_t remaining;
+   uint32_t length;
+
+   if ((c->mapped == 0) && (file_map_input(c) != TRAP_E_OK)) {
+      return trap_errorf(c->ctx, TRAP_E_IO_ERROR, "INPUT FILE IFC: mmap failed");
+   }
+   remaining = (c->map_size > c->map_pos ? c->map_size - c->map_pos : 0);
+   if (remaining < sizeof(uint32_t)) {
+      *eof = 1;
+      return TRAP_E_OK;
+   }
+   /* data_length is stored in host byte order */
+   memcpy(&length, c->map + c->map_pos, sizeof(uint32_t));
+   c->map_pos += sizeof(uint32_t);
+   remaining -= sizeof(uint32_t);
+   if (remaining < length) {
+      VERBOSE(CL_ERROR, "INPUT FILE IFC: Attempting to read %"PRIu32" bytes from file: %s, but there are only %zu bytes remaining. Read %zu bytes instead.", length, c->filename, remaining, remaining);
+      length = remaining;
+   }
+   if (length > c->ctx->in_ifc_list[c->ifc_idx].buffer_size) {
+      VERBOSE(CL_ERROR, "INPUT FILE IFC: buffer of %"PRIu32" bytes in file %s is too big.", length, c->filename);
+      return trap_errorf(c->ctx, TRAP_E_IO_ERROR, "INPUT FILE IFC: bad buffer size");
+   }
+   memcpy(data, c->map + c->map_pos, length);
+   c->map_pos += length;
+   *size = length;
+   return TRAP_E_OK;
+}
+
+/**
+ * \brief Batch thread of FILE_IO_BATCH engine, writes pending blocks.
+ * \param[in] arg   pointer to module private data
+ */
+static void *file_batch_thread(void *arg)
+{
+   file_batch_t *b = ((file_private_t *) arg)->batch;
+   uint32_t written, length;
+   ssize_t ret;
+   int idx, fd, err;
+
+   pthread_mutex_lock(&b->lock);
+   while (1) {
+      while ((b->pending == -1) && (b->terminate == 0)) {
+         pthread_cond_wait(&b->cond, &b->lock);
+      }
+      if (b->pending == -1) {
+         break;
+      }
+      idx = b->pending;
+      fd = b->pending_fd;
+      length = b->used[idx];
+      pthread_mutex_unlock(&b->lock);
+
+      err = 0;
+      for (written = 0; written < length; written += ret) {
+         ret = write(fd, b->block[idx] + written, length - written);
+         if (ret < 0) {
+            if (errno == EINTR) {
+               ret = 0;
+               continue;
+            }
+            err = errno;
+            break;
+         }
+      }
+
+      pthread_mutex_lock(&b->lock);
+      if (err != 0) {
+         b->error = err;
+      }
+      b->used[idx] = 0;
+      b->pending = -1;
+      pthread_cond_broadcast(&b->cond);
+   }
+   pthread_mutex_unlock(&b->lock);
+   return NULL;
+}
+
+/**
+ * \brief Pass the current block to the batch thread and continue with the other one.
+ * Waits until the previous block is written.
+ * \param[in] c   pointer to module private data
+ * \return TRAP_E_OK on success, TRAP_E_IO_ERROR if some of previous writes failed
+ */
+static int file_batch_handoff(file_private_t *c)
+{
+   file_batch_t *b = c->batch;
+   int result = TRAP_E_OK;
+
+   pthread_mutex_lock(&b->lock);
+   while (b->pending != -1) {
+      pthread_cond_wait(&b->cond, &b->lock);
+   }
+   if (b->error != 0) {
+      VERBOSE(CL_ERROR, "OUTPUT FILE IFC: unable to write to file: %s (%s)", c->filename, strerror(b->error));
+      b->error = 0;
+      result = TRAP_E_IO_ERROR;
+   }
+   if (b->used[b->cur] != 0) {
+      b->pending = b->cur;
+      b->pending_fd = fileno(c->fd);
+      b->cur ^= 1;
+      pthread_cond_broadcast(&b->cond);
+   }
+   pthread_mutex_unlock(&b->lock);
+   return result;
+}
+
+/**
+ * \brief Write all stored data of FILE_IO_BATCH engine and wait for it.
+ * \param[in] c   pointer to module private data
+ * \return TRAP_E_OK on success, TRAP_E_IO_ERROR if some write failed
+ */
+static int file_batch_flush(file_private_t *c)
+{
+   file_batch_t *b = c->batch;
+   int result;
+
+   if (b == NULL) {
+      return TRAP_E_OK;
+   }
+   result = file_batch_handoff(c);
+   pthread_mutex_lock(&b->lock);
+   while (b->pending != -1) {
+      pthread_cond_wait(&b->cond, &b->lock);
+   }
+   if (b->error != 0) {
+      VERBOSE(CL_ERROR, "OUTPUT FILE IFC: unable to write to file: %s (%s)", c->filename, strerror(b->error));
+      b->error = 0;
+      result = TRAP_E_IO_ERROR;
+   }
+   pthread_mutex_unlock(&b->lock);
+   return result;
+}
+
+/**
+ * \brief Start FILE_IO_BATCH engine.
+ * \param[in] c   pointer to module private data
+ * \return TRAP_E_OK on success, TRAP_E_MEMORY otherwise
+ */
+static int file_batch_create(file_private_t *c)
+{
+   file_batch_t *b;
+
+   b = (file_batch_t *) calloc(1, sizeof(file_batch_t));
+   if (b == NULL) {
+      return TRAP_E_MEMORY;
+   }
+   /* aligned blocks allow the kernel to copy whole pages */
+   if ((posix_memalign((void **) &b->block[0], 4096, FILE_BATCH_SIZE) != 0) ||
+       (posix_memalign((void **) &b->block[1], 4096, FILE_BATCH_SIZE) != 0)) {
+      free(b->block[0]);
+      free(b);
+      return TRAP_E_MEMORY;
+   }
+   b->pending = -1;
+   pthread_mutex_init(&b->lock, NULL);
+   pthread_cond_init(&b->cond, NULL);
+   c->batch = b;
+   if (pthread_create(&b->thread, NULL, file_batch_thread, c) != 0) {
+      pthread_mutex_destroy(&b->lock);
+      pthread_cond_destroy(&b->cond);
+      free(b->block[0]);
+      free(b->block[1]);
+      free(b);
+      c->batch = NULL;
+      return TRAP_E_MEMORY;
+   }
+   return TRAP_E_OK;
+}
+
+/**
+ * \brief Write stored data and stop FILE_IO_BATCH engine.
+ * \param[in] c   pointer to module private data
+ */
+static void file_batch_destroy(file_private_t *c)
+{
+   file_batch_t *b = c->batch;
+
+   if (b == NULL) {
+      return;
+   }
+   file_batch_flush(c);
+   pthread_mutex_lock(&b->lock);
+   b->terminate = 1;
+   pthread_cond_broadcast(&b->cond);
+   pthread_mutex_unlock(&b->lock);
+   pthread_join(b->thread, NULL);
+   pthread_mutex_destroy(&b->lock);
+   pthread_cond_destroy(&b->cond);
+   free(b->block[0]);
+   free(b->block[1]);
+   free(b);
+   c->batch = NULL;
+}
+
+/**
+ * \brief Store one buffer into the current block of FILE_IO_BATCH engine.
+ * \param[in] c   pointer to module private data
+ * \param[in] data     data of buffer
+ * \param[in] length   size of data
+ * \return TRAP_E_OK on success, TRAP_E_IO_ERROR if some of previous writes failed
+ */
+static int file_batch_append(file_private_t *c, const void *data, uint32_t length)
+{
+   file_batch_t *b = c->batch;
+   uint8_t *p;
+   int result = TRAP_E_OK;
+
+   if (b->used[b->cur] + sizeof(uint32_t) + length > FILE_BATCH_SIZE) {
+      result = file_batch_handoff(c);
+   }
+   /* the same format as the stdio engine: data_length in host byte order followed by data */
+   p = b->block[b->cur] + b->used[b->cur];
+   memcpy(p, &length, sizeof(uint32_t));
+   memcpy(p + sizeof(uint32_t), data, length);
+   b->used[b->cur] += sizeof(uint32_t) + length;
+   if (result != TRAP_E_OK) {
+      return trap_errorf(c->ctx, TRAP_E_IO_ERROR, "OUTPUT FILE IFC: unable to write");
+   }
+   return TRAP_E_OK;
+}
+
+/**
+ * \brief Get offset of FILE_INDEX_TIME_FIELD in UniRec record.
+ * \param[in] spec   data format specifier ("type NAME,type NAME,...")
+ * \return offset of the field or -1 if it is not a static field of type time
+ */
+static int32_t file_time_field_offset(const char *spec)
+{
+   const char *type;
+   int32_t offset;
+
+   offset = trap_ur_field_offset(spec, FILE_INDEX_TIME_FIELD, &type, NULL);
+   if ((offset < 0) || (strncmp(type, "time ", 5) != 0)) {
+      return -1;
+   }
+   return offset;
+}
+
+/**
+ * \brief Current time in the format of UniRec time.
+ */
+static uint64_t file_ur_time_now(void)
+{
+   struct timespec ts;
+
+   clock_gettime(CLOCK_REALTIME, &ts);
+   return ((uint64_t) ts.tv_sec << 32) | (((uint64_t) ts.tv_nsec << 32) / 1000000000ULL);
+}
+
+/**
+ * \brief Count messages of buffer and get minimal and maximal time of them.
+ * \param[in] data   payload of buffer (messages with uint16_t header)
+ * \param[in] size   size of payload
+ * \param[in] ts_offset   offset of time in message or -1 to count messages only
+ * \param[out] e   entry with first, last and messages filled
+ */
+static void file_buffer_times(const uint8_t *data, uint32_t size, int32_t ts_offset, file_index_entry_t *e)
+{
+   uint32_t pos = 0;
+   uint16_t msize;
+   uint64_t t;
+
+   e->first = UINT64_MAX;
+   e->last = 0;
+   e->messages = 0;
+   while (pos + sizeof(uint16_t) <= size) {
+      memcpy(&msize, data + pos, sizeof(uint16_t));
+      pos += sizeof(uint16_t);
+      if ((ts_offset >= 0) && (msize >= ts_offset + sizeof(uint64_t)) && (pos + msize <= size)) {
+         memcpy(&t, data + pos + ts_offset, sizeof(uint64_t));
+         if (t < e->first) {
+            e->first = t;
+         }
+         if (t > e->last) {
+            e->last = t;
+         }
+      }
+      pos += msize;
+      e->messages++;
+   }
+}
+
+/**
+ * \brief Get name of index of data file.
+ * \param[in] name   name of data file
+ * \return newly allocated name or NULL
+ */
+static char *file_index_path(const char *name)
+{
+   char *path = NULL;
+
+   if (asprintf(&path, "%s%s", name, FILE_INDEX_SUFFIX) < 0) {
+      return NULL;
+   }
+   return path;
+}
+
+/**
+ * \brief Create index of output data file.
+ * \param[in] name   name of data file
+ * \return opened index or NULL on error (the data file is not indexed then)
+ */
+static FILE *file_index_open(const char *name)
+{
+   char *path = file_index_path(name);
+   FILE *f = NULL;
+
+   if (path != NULL) {
+      f = fopen(path, "wb");
+   }
+   if (f == NULL) {
+      VERBOSE(CL_ERROR, "OUTPUT FILE IFC: unable to create index of file: %s", name);
+   }
+   free(path);
+   return f;
+}
+
+/**
+ * \brief Add entry of buffer into index of output file, the header is written with the first entry.
+ * \param[in] c   pointer to module private data
+ * \param[in] data   payload of buffer
+ * \param[in] length   size of payload
+ */
+static void file_index_append(file_private_t *c, const void *data, uint32_t length)
+{
+   trap_output_ifc_t *ifc = &c->ctx->out_ifc_list[c->ifc_idx];
+   file_index_header_t hdr;
+   file_index_entry_t e;
+
+   if (c->index_hdr == 0) {
+      /* compressed buffers can not be parsed, write time is used instead */
+      c->ts_offset = -1;
+      if ((ifc->compress == NULL) && (ifc->data_type == TRAP_FMT_UNIREC) && (ifc->data_fmt_spec != NULL)) {
+         c->ts_offset = file_time_field_offset(ifc->data_fmt_spec);
+      }
+      memset(&hdr, 0, sizeof(hdr));
+      memcpy(hdr.magic, FILE_INDEX_MAGIC, sizeof(hdr.magic));
+      hdr.key = (c->ts_offset >= 0 ? FILE_INDEX_KEY_TIME_FIRST : FILE_INDEX_KEY_WRITE_TIME);
+      fwrite(&hdr, sizeof(hdr), 1, c->index);
+      c->index_hdr = 1;
+   }
+
+   memset(&e, 0, sizeof(e));
+   if ((ifc->trace != 0) && (length >= TRAP_TRACE_SIZE)) {
+      /* trace record follows the messages */
+      length -= TRAP_TRACE_SIZE;
+   }
+   if (ifc->compress == NULL) {
+      file_buffer_times(data, length, c->ts_offset, &e);
+   }
+   if (c->ts_offset < 0) {
+      e.first = e.last = file_ur_time_now();
+   }
+   e.offset = c->offset;
+   if (fwrite(&e, sizeof(e), 1, c->index) != 1) {
+      VERBOSE(CL_ERROR, "OUTPUT FILE IFC: unable to write index of file: %s", c->filename);
+   }
+}
+
+/**
+ * \brief Continue with index of a new output file.
+ * \param[in] c   pointer to module private data
+ * \param[in] index   index of the new file, can be NULL
+ * \return index of the previous file
+ */
+static FILE *file_index_switch(file_private_t *c, FILE *index)
+{
+   FILE *old = c->index;
+
+   c->index = index;
+   c->index_hdr = 0;
+   c->offset = 0;
+   return old;
+}
+
+/**
+ * \brief Parse value of start= or end= parameter.
+ * Accepted formats: seconds since the epoch, YYYYmmddTHHMMSS (local time), YYYYmmddTHHMMSSZ (UTC).
+ * \param[in] value   value of parameter
+ * \param[out] t   time in the format of UniRec time
+ * \return 0 on success, -1 on invalid value
+ */
+static int file_parse_time(const char *value, uint64_t *t)
+{
+   struct tm tm;
+   const char *end;
+   char *num_end;
+   unsigned long long sec;
+   time_t tt;
+
+   memset(&tm, 0, sizeof(tm));
+   end = strptime(value, "%Y%m%dT%H%M%S", &tm);
+   if (end != NULL) {
+      if (strcmp(end, "Z") == 0) {
+         tt = timegm(&tm);
+      } else if (*end == '\0') {
+         tm.tm_isdst = -1;
+         tt = mktime(&tm);
+      } else {
+         return -1;
+      }
+      if (tt == (time_t) -1) {
+         return -1;
+      }
+      *t = (uint64_t) tt << 32;
+      return 0;
+   }
+   errno = 0;
+   sec = strtoull(value, &num_end, 10);
+   if ((errno != 0) || (num_end == value) || (*num_end != '\0') || (sec > UINT32_MAX)) {
+      return -1;
+   }
+   *t = (uint64_t) sec << 32;
+   return 0;
+}
+
+/**
+ * \brief Free index of the current input file.
+ * \param[in] c   pointer to module private data
+ */
+static void file_free_index(file_private_t *c)
+{
+   free(c->entries);
+   c->entries = NULL;
+   c->entry_cnt = 0;
+   c->entry_idx = 0;
+   c->index_state = FILE_INDEX_UNKNOWN;
+}
+
+/**
+ * \brief Load index of the current input file.
+ * When there is no index, messages of every buffer are checked after it is read.
+ * \param[in] c   pointer to module private data
+ */
+static void file_load_index(file_private_t *c)
+{
+   trap_input_ifc_t *ifc = &c->ctx->in_ifc_list[c->ifc_idx];
+   file_index_header_t hdr;
+   struct stat st;
+   FILE *f = NULL;
+   size_t cnt;
+
+   file_free_index(c);
+   c->index_state = FILE_INDEX_NONE;
+   if (c->index_name != NULL) {
+      f = fopen(c->index_name, "rb");
+   }
+   if ((f != NULL) && (fstat(fileno(f), &st) == 0) &&
+       (fread(&hdr, sizeof(hdr), 1, f) == 1) && (memcmp(hdr.magic, FILE_INDEX_MAGIC, sizeof(hdr.magic)) == 0)) {
+      cnt = (st.st_size - sizeof(hdr)) / sizeof(file_index_entry_t);
+      c->entries = (file_index_entry_t *) malloc((cnt > 0 ? cnt : 1) * sizeof(file_index_entry_t));
+      if (c->entries != NULL) {
+         c->entry_cnt = fread(c->entries, sizeof(file_index_entry_t), cnt, f);
+         c->index_state = FILE_INDEX_LOADED;
+         VERBOSE(CL_VERBOSE_LIBRARY, "INPUT FILE IFC %"PRIu32": loaded index %s (%"PRIu32" buffers)", c->ifc_idx, c->index_name, c->entry_cnt);
+      }
+   }
+   if (f != NULL) {
+      fclose(f);
+   }
+
+   if (c->index_state == FILE_INDEX_NONE) {
+      c->ts_offset = -1;
+      if ((ifc->codec == TRAP_CODEC_NONE) && (ifc->data_type == TRAP_FMT_UNIREC) && (ifc->data_fmt_spec != NULL)) {
+         c->ts_offset = file_time_field_offset(ifc->data_fmt_spec);
+      }
+      if (c->ts_offset < 0) {
+         VERBOSE(CL_WARNING, "INPUT FILE IFC %"PRIu32": file %s has no index and no %s field, start/end is ignored.", c->ifc_idx, c->filename, FILE_INDEX_TIME_FIELD);
+      } else {
+         VERBOSE(CL_VERBOSE_LIBRARY, "INPUT FILE IFC %"PRIu32": file %s has no index, buffers are checked while reading.", c->ifc_idx, c->filename);
+      }
+   }
+}
+
+/**
+ * \brief Check whether time range overlaps the window of input IFC.
+ */
+static inline int file_in_window(const file_private_t *c, uint64_t first, uint64_t last)
+{
+   return (first <= c->end) && (last >= c->start);
+}
+
+/**
+ * \brief Move to the next buffer that overlaps the time window according to the index.
+ * \param[in] c   pointer to module private data
+ * \param[out] eof   set to 1 when no other buffer of the current file is in the window
+ * \return TRAP_E_OK on success, TRAP_E_IO_ERROR otherwise
+ */
+static int file_window_seek(file_private_t *c, int *eof)
+{
+   uint64_t offset;
+
+   if (c->index_state == FILE_INDEX_UNKNOWN) {
+      file_load_index(c);
+   }
+   if (c->index_state != FILE_INDEX_LOADED) {
+      return TRAP_E_OK;
+   }
+   while ((c->entry_idx < c->entry_cnt) &&
+          !file_in_window(c, c->entries[c->entry_idx].first, c->entries[c->entry_idx].last)) {
+      c->entry_idx++;
+   }
+   if (c->entry_idx == c->entry_cnt) {
+      *eof = 1;
+      return TRAP_E_OK;
+   }
+   offset = c->entries[c->entry_idx++].offset;
+
+   if (c->io == FILE_IO_MMAP) {
+      if ((c->mapped == 0) && (file_map_input(c) != TRAP_E_OK)) {
+         return TRAP_E_IO_ERROR;
+      }
+      c->map_pos = offset;
+   } else if ((ftell(c->fd) != (long) offset) && (fseek(c->fd, offset, SEEK_SET) != 0)) {
+      VERBOSE(CL_ERROR, "INPUT FILE IFC: fseek failed in file: %s", c->filename);
+      return TRAP_E_IO_ERROR;
+   }
+   return TRAP_E_OK;
+}
+
+/**
+ * \brief Check buffer read from file without index against the time window.
+ * \param[in] c   pointer to module private data
+ * \param[in] data   payload of buffer
+ * \param[in] size   size of payload
+ * \return 1 if the buffer should be returned, 0 if it is skipped
+ */
+static int file_buffer_in_window(const file_private_t *c, const void *data, uint32_t size)
+{
+   file_index_entry_t e;
+
+   if ((c->index_state != FILE_INDEX_NONE) || (c->ts_offset < 0)) {
+      return 1;
+   }
+   if ((c->ctx->in_ifc_list[c->ifc_idx].trace != 0) && (size >= TRAP_TRACE_SIZE)) {
+      /* trace record follows the messages */
+      size -= TRAP_TRACE_SIZE;
+   }
+   file_buffer_times(data, size, c->ts_offset, &e);
+   return file_in_window(c, e.first, e.last);
+}
+
+/**
+ * \brief Parse value of size= parameter, optional suffix k, M, G or T multiplies it by powers of 1024.
+ * \param[in] value   value of parameter
+ * \param[out] size   parsed size in bytes
+ * \return 0 on success, -1 on invalid value
+ */
+static int file_parse_size(const char *value, uint64_t *size)
+{
+   char *end;
+   unsigned long long v;
+
+   errno = 0;
+   v = strtoull(value, &end, 10);
+   if ((errno != 0) || (end == value) || (v == 0)) {
+      return -1;
+   }
+   switch (*end) {
+   case 'T':
+   case 't':
+      v <<= 10;
+      /* fallthrough */
+   case 'G':
+   case 'g':
+      v <<= 10;
+      /* fallthrough */
+   case 'M':
+   case 'm':
+      v <<= 10;
+      /* fallthrough */
+   case 'K':
+   case 'k':
+      v <<= 10;
+      end++;
+      break;
+   }
+   if (*end != '\0') {
+      return -1;
+   }
+   *size = v;
+   return 0;
+}
+
+/**
+ * \brief Create missing directories of path (like mkdir -p of dirname).
+ * \param[in] path   path of a file
+ */
+static void file_make_dirs(const char *path)
+{
+   char *dir, *p;
+
+   dir = strdup(path);
+   if (dir == NULL) {
+      return;
+   }
+   for (p = strchr(dir + 1, '/'); p != NULL; p = strchr(p + 1, '/')) {
+      *p = '\0';
+      if ((mkdir(dir, 0777) == -1) && (errno != EEXIST)) {
+         VERBOSE(CL_ERROR, "OUTPUT FILE IFC: unable to create directory: %s (%s)", dir, strerror(errno));
+      }
+      *p = '/';
+   }
+   free(dir);
+}
+
+/**
+ * \brief Expand name of slice that starts at the given time.
+ * \param[in] c   pointer to module private data
+ * \param[in] t   start of slice
+ * \return newly allocated name or NULL on error
+ */
+static char *file_slice_name(file_private_t *c, time_t t)
+{
+   char name[PATH_MAX];
+   struct tm tm;
+
+   localtime_r(&t, &tm);
+   if (strftime(name, sizeof(name), c->filename, &tm) == 0) {
+      VERBOSE(CL_ERROR, "OUTPUT FILE IFC: unable to expand name of slice: %s", c->filename);
+      return NULL;
+   }
+   return strdup(name);
+}
+
+/**
+ * \brief Get name that does not collide with an existing file, <name>.<n> is used when <name> exists.
+ * Missing directories of the name are created.
+ * \param[in] name   expanded name of slice
+ * \return newly allocated name or NULL on error
+ */
+static char *file_unique_name(const char *name)
+{
+   char *unique = NULL;
+   uint32_t i;
+
+   file_make_dirs(name);
+   if (access(name, F_OK) == -1) {
+      return strdup(name);
+   }
+   for (i = 1; ; i++) {
+      if (asprintf(&unique, "%s.%"PRIu32, name, i) < 0) {
+         return NULL;
+      }
+      if (access(unique, F_OK) == -1) {
+         return unique;
+      }
+      free(unique);
+   }
+}
+
+/**
+ * \brief Open a new spare file of rotation under a temporary (hidden) name.
+ * \param[in] c   pointer to module private data
+ * \param[out] name   temporary name of the file
+ * \return opened file or NULL on error (errno is set)
+ */
+static FILE *file_open_spare(file_private_t *c, char **name)
+{
+   file_rotate_t *r = c->rotate;
+   FILE *f;
+   int fd, err;
+
+   if (asprintf(name, "%s.trap-%d-%"PRIu32"-%"PRIu32".tmp", r->tmp_prefix, (int) getpid(), c->ifc_idx, r->tmp_cnt++) < 0) {
+      *name = NULL;
+      errno = ENOMEM;
+      return NULL;
+   }
+   fd = open(*name, O_WRONLY | O_CREAT | O_EXCL, 0666);
+   if (fd == -1) {
+      err = errno;
+      free(*name);
+      *name = NULL;
+      errno = err;
+      return NULL;
+   }
+   f = fdopen(fd, "wb");
+   if (f == NULL) {
+      err = errno;
+      close(fd);
+      unlink(*name);
+      free(*name);
+      *name = NULL;
+      errno = err;
+   } else if (c->index_on) {
+      /* a slice without index is still usable, failure is not fatal */
+      r->spare_index = file_index_open(*name);
+   }
+   return f;
+}
+
+/**
+ * \brief Close finished slice and rename the new one.
+ * Called by the rotation thread without the lock held.
+ * \param[in] c   pointer to module private data
+ * \param[in] old   finished slice
+ * \param[in] old_index   index of finished slice, can be NULL
+ * \param[in] from   temporary name of the new slice
+ * \param[in] to   name of the new slice
+ */
+static void file_rotate_finish(file_private_t *c, FILE *old, FILE *old_index, char *from, char *to)
+{
+   file_batch_t *b = c->batch;
+   char *name, *index_from, *index_to;
+
+   name = file_unique_name(to);
+   if ((name == NULL) || (rename(from, name) == -1)) {
+      VERBOSE(CL_ERROR, "OUTPUT FILE IFC: unable to rename slice %s to %s (%s)", from, to, strerror(errno));
+   } else {
+      VERBOSE(CL_VERBOSE_LIBRARY, "OUTPUT FILE IFC %"PRIu32": new slice %s", c->ifc_idx, name);
+      if (c->index_on) {
+         index_from = file_index_path(from);
+         index_to = file_index_path(name);
+         if ((index_from != NULL) && (index_to != NULL) && (rename(index_from, index_to) == -1) && (errno != ENOENT)) {
+            VERBOSE(CL_ERROR, "OUTPUT FILE IFC: unable to rename index %s (%s)", index_from, strerror(errno));
+         }
+         free(index_from);
+         free(index_to);
+      }
+   }
+
+   if (b != NULL) {
+      /* the last block of the finished slice can be still written by the batch thread */
+      pthread_mutex_lock(&b->lock);
+      while ((b->pending != -1) && (b->pending_fd == fileno(old))) {
+         pthread_cond_wait(&b->cond, &b->lock);
+      }
+      pthread_mutex_unlock(&b->lock);
+   }
+   if (fclose(old) != 0) {
+      VERBOSE(CL_ERROR, "OUTPUT FILE IFC: unable to close slice (%s)", strerror(errno));
+   }
+   if (old_index != NULL) {
+      fclose(old_index);
+   }
+   free(name);
+   free(from);
+   free(to);
+}
+
+/**
+ * \brief Rotation thread, closes finished slices and prepares spare files.
+ * \param[in] arg   pointer to module private data
+ */
+static void *file_rotate_thread(void *arg)
+{
+   file_private_t *c = (file_private_t *) arg;
+   file_rotate_t *r = c->rotate;
+   FILE *old, *old_index, *spare;
+   char *from, *to, *name;
+   int err;
+
+   pthread_mutex_lock(&r->lock);
+   while (1) {
+      if (r->close_fd != NULL) {
+         old = r->close_fd;
+         old_index = r->close_index;
+         from = r->rename_from;
+         to = r->rename_to;
+         r->close_fd = NULL;
+         r->close_index = NULL;
+         r->rename_from = r->rename_to = NULL;
+         pthread_mutex_unlock(&r->lock);
+         file_rotate_finish(c, old, old_index, from, to);
+         pthread_mutex_lock(&r->lock);
+         continue;
+      }
+      if (r->terminate) {
+         break;
+      }
+      if ((r->spare == NULL) && (r->error == 0)) {
+         pthread_mutex_unlock(&r->lock);
+         spare = file_open_spare(c, &name);
+         err = errno;
+         pthread_mutex_lock(&r->lock);
+         if (spare == NULL) {
+            r->error = err;
+         } else {
+            r->spare = spare;
+            r->spare_name = name;
+         }
+         pthread_cond_broadcast(&r->cond);
+         continue;
+      }
+      pthread_cond_wait(&r->cond, &r->lock);
+   }
+   pthread_mutex_unlock(&r->lock);
+   return NULL;
+}
+
+/**
+ * \brief Start rotation of output file IFC.
+ * \param[in] c   pointer to module private data
+ * \return TRAP_E_OK on success, TRAP_E_MEMORY otherwise
+ */
+static int file_rotate_create(file_private_t *c)
+{
+   file_rotate_t *r;
+   const char *conv, *slash;
+
+   r = (file_rotate_t *) calloc(1, sizeof(file_rotate_t));
+   if (r == NULL) {
+      return TRAP_E_MEMORY;
+   }
+   /* spare files are created in the longest directory of the name that does not depend on time */
+   conv = strchr(c->filename, '%');
+   for (slash = conv; (slash != NULL) && (slash > c->filename) && (*slash != '/'); slash--);
+   if ((slash == NULL) || (*slash != '/')) {
+      slash = (conv == NULL ? strrchr(c->filename, '/') : NULL);
+   }
+   r->tmp_prefix = (slash == NULL ? strdup("") : strndup(c->filename, slash - c->filename + 1));
+   if (r->tmp_prefix == NULL) {
+      free(r);
+      return TRAP_E_MEMORY;
+   }
+   pthread_mutex_init(&r->lock, NULL);
+   pthread_cond_init(&r->cond, NULL);
+   c->rotate = r;
+   if (pthread_create(&r->thread, NULL, file_rotate_thread, c) != 0) {
+      pthread_mutex_destroy(&r->lock);
+      pthread_cond_destroy(&r->cond);
+      free(r->tmp_prefix);
+      free(r);
+      c->rotate = NULL;
+      return TRAP_E_MEMORY;
+   }
+   return TRAP_E_OK;
+}
+
+/**
+ * \brief Stop rotation thread and remove the spare file.
+ * \param[in] c   pointer to module private data
+ */
+static void file_rotate_destroy(file_private_t *c)
+{
+   file_rotate_t *r = c->rotate;
+   char *index_name;
+
+   if (r == NULL) {
+      return;
+   }
+   pthread_mutex_lock(&r->lock);
+   r->terminate = 1;
+   pthread_cond_broadcast(&r->cond);
+   pthread_mutex_unlock(&r->lock);
+   pthread_join(r->thread, NULL);
+   if (r->spare != NULL) {
+      fclose(r->spare);
+      unlink(r->spare_name);
+      if (r->spare_index != NULL) {
+         fclose(r->spare_index);
+         index_name = file_index_path(r->spare_name);
+         if (index_name != NULL) {
+            unlink(index_name);
+            free(index_name);
+         }
+      }
+      free(r->spare_name);
+   }
+   pthread_mutex_destroy(&r->lock);
+   pthread_cond_destroy(&r->cond);
+   free(r->tmp_prefix);
+   free(r);
+   c->rotate = NULL;
+}
+
+/**
+ * \brief Start time of slice that contains the given time.
+ * Slices of time= are aligned to multiples of their length since the epoch.
+ * \param[in] c   pointer to module private data
+ * \param[in] now   current time
+ * \return start of slice
+ */
+static time_t file_slice_start(file_private_t *c, time_t now)
+{
+   if (c->rotate_time == 0) {
+      return now;
+   }
+   now -= now % c->rotate_time;
+   c->next_rotation = now + c->rotate_time;
+   return now;
+}
+
+/**
+ * \brief Switch output to a new slice.
+ * Only swaps the file with the spare one, opening and closing is done by the rotation thread.
+ * When no spare file is available, writing continues into the current slice.
+ * \param[in] c   pointer to module private data
+ * \param[in] now   current time
+ * \return TRAP_E_OK on success, TRAP_E_IO_ERROR if the spare file could not be opened
+ */
+static int file_rotate(file_private_t *c, time_t now)
+{
+   file_rotate_t *r = c->rotate;
+   char *name;
+   int err;
+
+   c->written = 0;
+   name = file_slice_name(c, file_slice_start(c, now));
+   if (name == NULL) {
+      return TRAP_E_IO_ERROR;
+   }
+   if (c->batch != NULL) {
+      /* rest of the finished slice must be written into its file */
+      file_batch_handoff(c);
+   }
+
+   pthread_mutex_lock(&r->lock);
+   while ((r->spare == NULL) && (r->error == 0)) {
+      pthread_cond_wait(&r->cond, &r->lock);
+   }
+   if (r->spare == NULL) {
+      err = r->error;
+      /* let the thread try again before the next rotation */
+      r->error = 0;
+      pthread_cond_broadcast(&r->cond);
+      pthread_mutex_unlock(&r->lock);
+      VERBOSE(CL_ERROR, "OUTPUT FILE IFC %"PRIu32": unable to open a new slice, continuing in the current one (%s)", c->ifc_idx, strerror(err));
+      free(name);
+      return TRAP_E_IO_ERROR;
+   }
+   r->close_fd = c->fd;
+   r->close_index = file_index_switch(c, r->spare_index);
+   r->rename_from = r->spare_name;
+   r->rename_to = name;
+   c->fd = r->spare;
+   r->spare = NULL;
+   r->spare_index = NULL;
+   r->spare_name = NULL;
+   pthread_cond_broadcast(&r->cond);
+   pthread_mutex_unlock(&r->lock);
+
+   /* the new slice starts with its own hello message */
+   c->neg_initialized = 0;
+   return TRAP_E_OK;
+}
+
+/**
+ * \brief Check whether the file is a sidecar index.
+ */
+static int file_is_index(const char *name)
+{
+   size_t len = strlen(name), suffix_len = strlen(FILE_INDEX_SUFFIX);
+
+   return (len > suffix_len) && (strcmp(name + len - suffix_len, FILE_INDEX_SUFFIX) == 0);
+}
+
+/**
+ * \brief Compare names of slices, numbers inside names are compared by value.
+ */
+static int file_slice_cmp(const void *a, const void *b)
+{
+   return strverscmp(*(char * const *) a, *(char * const *) b);
+}
+
+/**
+ * \brief Fill the list of input slices, i.e. files in directory or files matched by glob pattern.
+ * \param[in] c   pointer to module private data
+ * \param[in] exp   result of wordexp() of the file name
+ * \return TRAP_E_OK on success, TRAP_E_BADPARAMS when directory is empty or can not be read, TRAP_E_MEMORY
+ */
+static int file_list_slices(file_private_t *c, const wordexp_t *exp)
+{
+   struct dirent **entries = NULL;
+   struct stat st;
+   const char *dir = exp->we_wordv[0];
+   int i, n, cnt = 0;
+
+   if (exp->we_wordc > 1) {
+      c->slices = (char **) calloc(exp->we_wordc, sizeof(char *));
+      if (c->slices == NULL) {
+         return TRAP_E_MEMORY;
+      }
+      for (i = 0; i < exp->we_wordc; i++) {
+         if (file_is_index(exp->we_wordv[i])) {
+            continue;
+         }
+         c->slices[c->slice_cnt] = strdup(exp->we_wordv[i]);
+         if (c->slices[c->slice_cnt] == NULL) {
+            return TRAP_E_MEMORY;
+         }
+         c->slice_cnt++;
+      }
+      if (c->slice_cnt == 0) {
+         VERBOSE(CL_ERROR, "CREATE INPUT FILE IFC: no data file matched: %s", exp->we_wordv[0]);
+         return TRAP_E_BADPARAMS;
+      }
+      qsort(c->slices, c->slice_cnt, sizeof(char *), file_slice_cmp);
+      return TRAP_E_OK;
+   }
+
+   n = scandir(dir, &entries, NULL, versionsort);
+   if (n < 0) {
+      VERBOSE(CL_ERROR, "CREATE INPUT FILE IFC: unable to read directory: %s", dir);
+      return TRAP_E_BADPARAMS;
+   }
+   c->slices = (char **) calloc(n + 1, sizeof(char *));
+   for (i = 0; i < n; i++) {
+      /* hidden files are skipped, spare files of rotation are hidden */
+      if ((c->slices != NULL) && (entries[i]->d_name[0] != '.') && !file_is_index(entries[i]->d_name)) {
+         if (asprintf(&c->slices[cnt], "%s/%s", dir, entries[i]->d_name) < 0) {
+            c->slices[cnt] = NULL;
+         } else if ((stat(c->slices[cnt], &st) == 0) && S_ISREG(st.st_mode)) {
+            cnt++;
+         } else {
+            free(c->slices[cnt]);
+            c->slices[cnt] = NULL;
+         }
+      }
+      free(entries[i]);
+   }
+   free(entries);
+   c->slice_cnt = cnt;
+   if (c->slices == NULL) {
+      return TRAP_E_MEMORY;
+   }
+   if (cnt == 0) {
+      VERBOSE(CL_ERROR, "CREATE INPUT FILE IFC: no file found in directory: %s", dir);
+      return TRAP_E_BADPARAMS;
+   }
+   return TRAP_E_OK;
+}
+
+/**
+ * \brief Free the list of input slices.
+ * \param[in] c   pointer to module private data
+ */
+static void file_free_slices(file_private_t *c)
+{
+   uint32_t i;
+
+   if (c->slices != NULL) {
+      for (i = 0; i < c->slice_cnt; i++) {
+         free(c->slices[i]);
+      }
+      free(c->slices);
+      c->slices = NULL;
+   }
+   c->slice_cnt = 0;
+}
+
+/**
+ * \brief Continue with the next input slice, slices that can not be opened are skipped.
+ * \param[in] c   pointer to module private data
+ * \return 0 on success, -2 if there is no other slice, -1 on error
+ */
+static int file_next_slice(file_private_t *c)
+{
+   while (c->slice_idx + 1 < c->slice_cnt) {
+      c->slice_idx++;
+      free(c->filename);
+      c->filename = strdup(c->slices[c->slice_idx]);
+      if (c->filename == NULL) {
+         return -1;
+      }
+      c->fd = fopen(c->filename, c->mode);
+      if (c->fd != NULL) {
+         if (c->window) {
+            free(c->index_name);
+            c->index_name = file_index_path(c->filename);
+         }
+         VERBOSE(CL_VERBOSE_LIBRARY, "INPUT FILE IFC %"PRIu32": next slice %s", c->ifc_idx, c->filename);
+         return 0;
+      }
+      VERBOSE(CL_ERROR, "INPUT FILE IFC %"PRIu32": unable to open slice %s, skipping it.", c->ifc_idx, c->filename);
+   }
+   return -2;
+}
+
 /**
  * \brief Close file and free allocated memory.
  * \param[in] priv   pointer to module private data
@@ -75,9 +1238,18 @@ void file_destroy(void *priv)
    file_private_t *config = (file_private_t*) priv;
 
    if (config) {
+      file_rotate_destroy(config);
+      file_batch_destroy(config);
+      file_unmap(config);
       if (config->fd) {
          fclose(config->fd);
       }
+      if (config->index) {
+         fclose(config->index);
+      }
+      file_free_index(config);
+      file_free_slices(config);
+      free(config->index_name);
       free(config->filename);
       free(config);
    } else {
@@ -139,11 +1311,21 @@ int open_next_file(file_private_t *c)
    }
 
    if (c->fd != NULL) {
+      file_batch_flush(c);
+      file_unmap(c);
       fclose(c->fd);
       c->fd = NULL;
    }
 
    c->neg_initialized = 0;
+   file_free_index(c);
+   if (c->index != NULL) {
+      fclose(file_index_switch(c, NULL));
+   }
+
+   if (c->slices != NULL) {
+      return file_next_slice(c);
+   }
 
    if (asprintf(&buffer, "%s%d", c->filename, c->file_cnt) < 0) {
       VERBOSE(CL_ERROR, "FILE IFC: asprintf failed.");
@@ -163,6 +1345,14 @@ int open_next_file(file_private_t *c)
       return -1;
    }
 
+   if (c->mode[0] == 'r') {
+      if (c->window) {
+         free(c->index_name);
+         c->index_name = file_index_path(buffer);
+      }
+   } else if (c->index_on) {
+      file_index_switch(c, file_index_open(buffer));
+   }
    free(buffer);
    return 0;
 }
@@ -186,6 +1376,7 @@ int file_recv(void *priv, void *data, uint32_t *size, int timeout)
 {
    size_t loaded;
    long int current_position, remaining_bytes;
+   int result, eof = 0;
 
    /* header of message inside the buffer */
    uint16_t *m_head = data;
@@ -242,31 +1433,68 @@ neg_start:
          VERBOSE(CL_VERBOSE_LIBRARY, "Input_ifc_negotiation result: default case");
          break;
       }
+      /* negotiation may have reallocated buffer of input IFC for bigger buffers */
+      data = config->ctx->in_ifc_list[config->ifc_idx].buffer;
+      m_head = data;
    }
+#else
+next_slice:
 #endif
 
-   /* Reads 4 bytes from the file, determining the length of bytes to be read to @param[out] data */
-   loaded = fread(size, sizeof(uint32_t), 1, config->fd);
+next_buffer:
+   if ((config->window != 0) && (file_window_seek(config, &eof) != TRAP_E_OK)) {
+      return trap_errorf(config->ctx, TRAP_E_IO_ERROR, "INPUT FILE IFC: seek failed");
+   }
 
-   if (loaded != 1) {
-      if (feof(config->fd)) {
-#ifdef ENABLE_NEGOTIATION
-         if (open_next_file(config) == 0) {
-            goto neg_start;
-         } else {
-            VERBOSE(CL_VERBOSE_LIBRARY, "File input ifc negotiation: eof, could not open next input file.")
+   if (eof) {
+      /* no other buffer of this file is in the time window */
+   } else if (config->io == FILE_IO_MMAP) {
+      result = file_recv_mmap(config, data, size, &eof);
+      if (result != TRAP_E_OK) {
+         return result;
+      }
+      if (eof == 0) {
+         if ((config->window != 0) && !file_buffer_in_window(config, data, *size)) {
+            goto next_buffer;
          }
-#endif
-         /* set size of buffer to the size of 1 message (including its header) */
-         (*size) = 2;
-         /* set the header of message to 0B */
-         *m_head = 0;
-
          return TRAP_E_OK;
       }
+   } else {
+      /* Reads 4 bytes from the file, determining the length of bytes to be read to @param[out] data */
+      loaded = fread(size, sizeof(uint32_t), 1, config->fd);
 
-      VERBOSE(CL_ERROR, "INPUT FILE IFC: read error occurred in file: %s", config->filename);
-      return trap_errorf(config->ctx, TRAP_E_IO_ERROR, "INPUT FILE IFC: unable to read");
+      if (loaded != 1) {
+         if (!feof(config->fd)) {
+            VERBOSE(CL_ERROR, "INPUT FILE IFC: read error occurred in file: %s", config->filename);
+            return trap_errorf(config->ctx, TRAP_E_IO_ERROR, "INPUT FILE IFC: unable to read");
+         }
+         eof = 1;
+      } else if ((*size) > config->ctx->in_ifc_list[config->ifc_idx].buffer_size) {
+         VERBOSE(CL_ERROR, "INPUT FILE IFC: buffer of %"PRIu32" bytes in file %s is too big.", (*size), config->filename);
+         return trap_errorf(config->ctx, TRAP_E_IO_ERROR, "INPUT FILE IFC: bad buffer size");
+      }
+   }
+
+   if (eof) {
+      /* the next file is read from its beginning */
+      eof = 0;
+#ifdef ENABLE_NEGOTIATION
+      if (open_next_file(config) == 0) {
+         goto neg_start;
+      } else {
+         VERBOSE(CL_VERBOSE_LIBRARY, "File input ifc negotiation: eof, could not open next input file.")
+      }
+#else
+      if ((config->slices != NULL) && (open_next_file(config) == 0)) {
+         goto next_slice;
+      }
+#endif
+      /* set size of buffer to the size of 1 message (including its header) */
+      (*size) = 2;
+      /* set the header of message to 0B */
+      *m_head = 0;
+
+      return TRAP_E_OK;
    }
 
    current_position = ftell(config->fd);
@@ -310,6 +1538,9 @@ neg_start:
       }
    }
 
+   if ((config->window != 0) && !file_buffer_in_window(config, data, *size)) {
+      goto next_buffer;
+   }
 
    return TRAP_E_OK;
 }
@@ -320,7 +1551,10 @@ neg_start:
  *
  * \param[in,out] ctx   Pointer to the private libtrap context data (trap_ctx_init()).
  * \param[in] params    Configuration string containing *file_name*,
- * where file_name is a path to a file from which data is to be read
+ * where file_name is a path to a file from which data is to be read,
+ * a glob pattern or a directory; files (slices) are then read one after another in version-sort order.
+ * Optional start=*time* and end=*time* select buffers that contain messages of the time window,
+ * sidecar index of the file is used to skip other buffers when it exists.
  * \param[in,out] ifc   IFC interface used for calling file module.
  * \param[in] idx       Index of IFC that is created.
  * \return 0 on success (TRAP_E_OK), TRAP_E_MEMORY, TRAP_E_BADPARAMS on error
@@ -330,19 +1564,55 @@ int create_file_recv_ifc(trap_ctx_priv_t *ctx, const char *params, trap_input_if
    file_private_t *priv;
    size_t name_length;
    wordexp_t exp_result;
+   enum file_io_engine io = FILE_IO_STDIO;
+   const char *first;
+   struct stat st;
+   char *dest, *opt;
+   uint64_t start = 0, end = UINT64_MAX;
+   uint8_t window = 0;
+   int ret;
 
    if (params == NULL) {
       return trap_errorf(ctx, TRAP_E_BADPARAMS, "parameter is null pointer");
    }
 
+   dest = strdup(params);
+   if (dest == NULL) {
+      return trap_error(ctx, TRAP_E_MEMORY);
+   }
+
+   /* Optional parameters follow the file name, file name can contain ':' */
+   while ((opt = strrchr(dest, ':')) != NULL) {
+      if (strncmp(opt + 1, "start=", 6) == 0) {
+         ret = file_parse_time(opt + 7, &start);
+         window = 1;
+      } else if (strncmp(opt + 1, "end=", 4) == 0) {
+         ret = file_parse_time(opt + 5, &end);
+         window = 1;
+      } else if ((ret = file_parse_io(opt + 1, &io)) != 0) {
+         if (io == FILE_IO_BATCH) {
+            VERBOSE(CL_ERROR, "CREATE INPUT FILE IFC: I/O engine batch is available for output IFC only.");
+            ret = -1;
+         }
+      } else {
+         break;
+      }
+      if (ret == -1) {
+         VERBOSE(CL_ERROR, "CREATE INPUT FILE IFC: bad parameter: %s", opt + 1);
+         free(dest);
+         return trap_errorf(ctx, TRAP_E_BADPARAMS, "CREATE INPUT FILE IFC: bad parameter");
+      }
+      *opt = '\0';
+   }
+
    /* Perform shell-like expansion of ~ */
-   if (wordexp(params, &exp_result, 0) != 0) {
-      VERBOSE(CL_ERROR, "CREATE INPUT FILE IFC: unable to perform shell-like expand of: %s", params);
+   if (wordexp(dest, &exp_result, 0) != 0) {
+      VERBOSE(CL_ERROR, "CREATE INPUT FILE IFC: unable to perform shell-like expand of: %s", dest);
+      free(dest);
       wordfree(&exp_result);
       return trap_errorf(ctx, TRAP_E_BADPARAMS, "CREATE INPUT FILE IFC: unable to perform shell-like expand");
    }
-
-   name_length = strlen(exp_result.we_wordv[0]);
+   free(dest);
 
    /* Create structure to store private data */
    priv = calloc(1, sizeof(file_private_t));
@@ -353,8 +1623,28 @@ int create_file_recv_ifc(trap_ctx_priv_t *ctx, const char *params, trap_input_if
 
    priv->ctx = ctx;
    priv->ifc_idx = idx;
+   priv->io = io;
+   priv->window = window;
+   priv->start = start;
+   priv->end = end;
+
+   /* Glob pattern matching more files or a directory is read as a sequence of slices */
+   first = exp_result.we_wordv[0];
+   if ((exp_result.we_wordc > 1) || ((stat(first, &st) == 0) && S_ISDIR(st.st_mode))) {
+      ret = file_list_slices(priv, &exp_result);
+      if (ret != TRAP_E_OK) {
+         file_free_slices(priv);
+         free(priv);
+         wordfree(&exp_result);
+         return trap_errorf(ctx, ret, "CREATE INPUT FILE IFC: unable to list slices");
+      }
+      first = priv->slices[0];
+   }
+
+   name_length = strlen(first);
    priv->filename = (char *) calloc(name_length + 1, sizeof(char));
    if (!priv->filename) {
+      file_free_slices(priv);
       free(priv);
       wordfree(&exp_result);
       return trap_error(ctx, TRAP_E_MEMORY);
@@ -364,13 +1654,18 @@ int create_file_recv_ifc(trap_ctx_priv_t *ctx, const char *params, trap_input_if
    priv->mode[0] = 'r';
    priv->mode[1] = 'b';
    priv->mode[2] = '\0';
-   strncpy(priv->filename, exp_result.we_wordv[0], name_length + 1);
+   strncpy(priv->filename, first, name_length + 1);
    wordfree(&exp_result);
+   if (priv->window) {
+      priv->index_name = file_index_path(priv->filename);
+   }
 
    /* Attempts to open the file */
    priv->fd = fopen(priv->filename, priv->mode);
    if (priv->fd == NULL) {
       VERBOSE(CL_ERROR, "CREATE INPUT FILE IFC: unable to open file \"%s\". Possible reasons: non-existing file, bad permission.", priv->filename);
+      file_free_slices(priv);
+      free(priv->index_name);
       free(priv->filename);
       free(priv);
       return trap_errorf(ctx, TRAP_E_BADPARAMS, "unable to open file");
@@ -397,6 +1692,11 @@ int create_file_recv_ifc(trap_ctx_priv_t *ctx, const char *params, trap_input_if
 void create_next_file(void *priv)
 {
    file_private_t *c = (file_private_t *) priv;
+   if (c->rotate != NULL) {
+      /* sliced output continues with a new slice */
+      file_rotate(c, time(NULL));
+      return;
+   }
    if (open_next_file(c) != 0) {
       VERBOSE(CL_ERROR, "OUTPUT FILE IFC %d: creating and opening of a new file failed.", c->ifc_idx);
    }
@@ -426,6 +1726,7 @@ int file_send(void *priv, const void *data, uint32_t size, int timeout)
    const trap_buffer_header_t *data_struct = (trap_buffer_header_t *) data;
    size_t written;
    uint32_t size_little_e;
+   time_t now;
 
    if (config->is_terminated) {
       return trap_error(config->ctx, TRAP_E_TERMINATED);
@@ -436,6 +1737,22 @@ int file_send(void *priv, const void *data, uint32_t size, int timeout)
       return trap_error(config->ctx, TRAP_E_NOT_INITIALIZED);
    }
 
+   /* Converts data_length to host byte order (little endian) */
+   size_little_e = ntohl(data_struct->data_length);
+
+   if (config->rotate != NULL) {
+      now = time(NULL);
+      if (((config->rotate_time != 0) && (now >= config->next_rotation)) ||
+          ((config->rotate_size != 0) && (config->written != 0) &&
+           (config->written + sizeof(uint32_t) + size_little_e > config->rotate_size))) {
+         if (file_rotate(config, now) != TRAP_E_OK) {
+            /* do not try again with every buffer */
+            config->written = 0;
+         }
+      }
+      config->written += sizeof(uint32_t) + size_little_e;
+   }
+
 #ifdef ENABLE_NEGOTIATION
    if (config->neg_initialized == 0) {
       ret_val = output_ifc_negotiation((void *) config, TRAP_IFC_TYPE_FILE, 0);
@@ -443,6 +1760,8 @@ int file_send(void *priv, const void *data, uint32_t size, int timeout)
          VERBOSE(CL_VERBOSE_LIBRARY, "File output_ifc_negotiation result: success.");
          config->neg_initialized = 1;
          fflush(config->fd);
+         /* buffers follow the hello message */
+         config->offset = ftell(config->fd);
       } else if (ret_val == NEG_RES_FMT_UNKNOWN) {
          VERBOSE(CL_VERBOSE_LIBRARY, "File output_ifc_negotiation result: failed (unknown data format of this output interface -> refuse client).");
          return trap_error(config->ctx, TRAP_E_NOT_INITIALIZED);
@@ -453,8 +1772,14 @@ int file_send(void *priv, const void *data, uint32_t size, int timeout)
    }
 #endif
 
-   /* Converts data_length to host byte order (little endian) */
-   size_little_e = ntohl(data_struct->data_length);
+   if (config->index != NULL) {
+      file_index_append(config, data_struct->data, size_little_e);
+   }
+   config->offset += sizeof(uint32_t) + size_little_e;
+
+   if (config->batch != NULL) {
+      return file_batch_append(config, data_struct->data, size_little_e);
+   }
 
    /* Writes data_length to the file in host file order (little endian) */
    written = fwrite(&size_little_e, sizeof(uint32_t), 1, config->fd);
@@ -485,6 +1810,9 @@ int32_t file_get_client_count(void *priv)
  * \param[in] params    Configuration string containing colon separated values of these parameters (in this exact order): *file_name*:*open_mode*,
  * where file_name is a path to a file in which data is to be written and
  * open_mode is either a - append or w - write, if no mode is specified, the file will be opened in append mode.
+ * Optional time=*seconds* and size=*bytes* (suffix k, M, G, T) split the output into slices,
+ * file_name is a strftime() format of the name of slice then (timestamp suffix is appended when it contains no conversion).
+ * Optional index enables sidecar index (file_name.idx) of every output file.
  * \param[in,out] ifc   IFC interface used for calling file module.
  * \param[in] idx       Index of IFC that is created.
  * \return 0 on success (TRAP_E_OK), TRAP_E_MEMORY, TRAP_E_BADPARAMS on error
@@ -492,9 +1820,11 @@ int32_t file_get_client_count(void *priv)
 int create_file_send_ifc(trap_ctx_priv_t *ctx, const char *params, trap_output_ifc_t *ifc, uint32_t idx)
 {
    file_private_t *priv;
-   char *dest, *dest2, *ret;
+   char *dest, *dest2, *ret, *end, *first_name = NULL;
    wordexp_t exp_result;
    size_t name_length;
+   unsigned long seconds;
+   int io_parsed, opt_idx;
 
    if (params == NULL) {
       return trap_errorf(ctx, TRAP_E_BADPARAMS, "parameter is null pointer");
@@ -511,38 +1841,57 @@ int create_file_send_ifc(trap_ctx_priv_t *ctx, const char *params, trap_output_i
    /* Parses and sets filename and mode */
    priv->filename = dest = dest2 = NULL;
    ret = trap_get_param_by_delimiter(params, &dest, ':');
+   if (!dest) {
+      free(priv);
+      return trap_error(ctx, TRAP_E_MEMORY);
+   }
+   priv->mode[0] = 'a';
 
-   if (!ret) {
-      if (dest) {
-         priv->mode[0] = 'a';
-      } else {
-         free(priv);
-         return trap_error(ctx, TRAP_E_MEMORY);
-      }
-   } else {
-      trap_get_param_by_delimiter(ret, &dest2, ':');
+   /* mode is optional and must be the first one, other parameters can follow in any order */
+   for (opt_idx = 0; ret != NULL; opt_idx++) {
+      ret = trap_get_param_by_delimiter(ret, &dest2, ':');
       if (!dest2) {
          free(priv);
          free(dest);
          return trap_error(ctx, TRAP_E_MEMORY);
       }
 
-      if (dest2[0] != 'a' && dest2[0] != 'w') {
-         VERBOSE(CL_ERROR, "OUTPUT FILE IFC: bad mode: %c", dest2[0]);
+      io_parsed = 0;
+      if (strncmp(dest2, "time=", 5) == 0) {
+         errno = 0;
+         seconds = strtoul(dest2 + 5, &end, 10);
+         if ((errno != 0) || (*end != '\0') || (seconds == 0) || (seconds > UINT32_MAX)) {
+            io_parsed = -1;
+         }
+         priv->rotate_time = seconds;
+      } else if (strncmp(dest2, "size=", 5) == 0) {
+         io_parsed = file_parse_size(dest2 + 5, &priv->rotate_size);
+      } else if (strcmp(dest2, "index") == 0) {
+         priv->index_on = 1;
+      } else if ((io_parsed = file_parse_io(dest2, &priv->io)) != 0) {
+         if (priv->io == FILE_IO_MMAP) {
+            io_parsed = -1;
+         }
+      } else if ((opt_idx == 0) && (dest2[0] == 'a' || dest2[0] == 'w')) {
+         priv->mode[0] = dest2[0];
+      } else {
+         io_parsed = -1;
+      }
+
+      if (io_parsed == -1) {
+         VERBOSE(CL_ERROR, "OUTPUT FILE IFC: bad parameter: %s", dest2);
          free(priv);
          free(dest);
          free(dest2);
-         return trap_errorf(ctx, TRAP_E_BADPARAMS, "OUTPUT FILE IFC: bad mode");
+         return trap_errorf(ctx, TRAP_E_BADPARAMS, "OUTPUT FILE IFC: bad parameter");
       }
-
-      priv->mode[0] = dest2[0];
+      free(dest2);
+      dest2 = NULL;
    }
 
    priv->mode[1] = 'b';
    priv->mode[2] = '\0';
 
-   free(dest2);
-
    /* Perform shell-like expansion of ~ */
    if (wordexp(dest, &exp_result, 0) != 0) {
       VERBOSE(CL_ERROR, "CREATE OUTPUT FILE IFC: unable to perform shell-like expand of: %s", dest);
@@ -565,7 +1914,29 @@ int create_file_send_ifc(trap_ctx_priv_t *ctx, const char *params, trap_output_i
    strncpy(priv->filename, exp_result.we_wordv[0], name_length + 1);
    wordfree(&exp_result);
 
-   if (priv->mode[0] == 'a' && access(priv->filename, F_OK) != -1) {
+   if ((priv->rotate_time != 0) || (priv->rotate_size != 0)) {
+      /* name of slice is strftime() format, names without conversion get a timestamp suffix */
+      if ((strchr(priv->filename, '%') == NULL) && (asprintf(&dest, "%s.%%Y%%m%%d%%H%%M%%S", priv->filename) >= 0)) {
+         free(priv->filename);
+         priv->filename = dest;
+      }
+      /* existing slices are never overwritten, mode is not used */
+      dest = file_slice_name(priv, file_slice_start(priv, time(NULL)));
+      if (dest != NULL) {
+         first_name = file_unique_name(dest);
+         free(dest);
+      }
+      if (first_name == NULL) {
+         free(priv->filename);
+         free(priv);
+         return trap_error(ctx, TRAP_E_MEMORY);
+      }
+      priv->fd = fopen(first_name, "wb");
+      if ((priv->fd != NULL) && priv->index_on) {
+         priv->index = file_index_open(first_name);
+      }
+      free(first_name);
+   } else if (priv->mode[0] == 'a' && access(priv->filename, F_OK) != -1) {
       char *buffer = NULL;
       do{
          if (buffer != NULL) {
@@ -584,10 +1955,16 @@ int create_file_send_ifc(trap_ctx_priv_t *ctx, const char *params, trap_output_i
       } while (access(buffer, F_OK) != -1);
 
       priv->fd = fopen(buffer, priv->mode);
+      if ((priv->fd != NULL) && priv->index_on) {
+         priv->index = file_index_open(buffer);
+      }
       free(buffer);
    } else {
       /* Attempts to open the file */
       priv->fd = fopen(priv->filename, priv->mode);
+      if ((priv->fd != NULL) && priv->index_on) {
+         priv->index = file_index_open(priv->filename);
+      }
    }
 
    if (priv->fd == NULL) {
@@ -597,6 +1974,29 @@ int create_file_send_ifc(trap_ctx_priv_t *ctx, const char *params, trap_output_i
       return trap_errorf(ctx, TRAP_E_BADPARAMS, "unable to open file");
    }
 
+   if ((priv->io == FILE_IO_BATCH) && (file_batch_create(priv) != TRAP_E_OK)) {
+      VERBOSE(CL_ERROR, "CREATE OUTPUT FILE IFC: unable to start batch writing.");
+      if (priv->index != NULL) {
+         fclose(priv->index);
+      }
+      fclose(priv->fd);
+      free(priv->filename);
+      free(priv);
+      return trap_error(ctx, TRAP_E_MEMORY);
+   }
+
+   if (((priv->rotate_time != 0) || (priv->rotate_size != 0)) && (file_rotate_create(priv) != TRAP_E_OK)) {
+      VERBOSE(CL_ERROR, "CREATE OUTPUT FILE IFC: unable to start rotation of slices.");
+      file_batch_destroy(priv);
+      if (priv->index != NULL) {
+         fclose(priv->index);
+      }
+      fclose(priv->fd);
+      free(priv->filename);
+      free(priv);
+      return trap_error(ctx, TRAP_E_MEMORY);
+   }
+
    priv->is_terminated = 0;
 
    /* Fills interface structure */
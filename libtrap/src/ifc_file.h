@@ -43,8 +43,102 @@
 #ifndef _TRAP_IFC_FILE_H_
 #define _TRAP_IFC_FILE_H_
 
+#include <pthread.h>
+#include <time.h>
 #include "trap_ifc.h"
 
+/** I/O engine of file IFC selected by io=<engine> parameter */
+enum file_io_engine {
+   FILE_IO_STDIO = 0, ///< fread()/fwrite() of every buffer (default)
+   FILE_IO_MMAP,      ///< input: file is mapped into memory and buffers are copied from the mapping
+   FILE_IO_BATCH      ///< output: buffers are collected into large blocks written by a separate thread
+};
+
+/** Size of one block of FILE_IO_BATCH engine */
+#define FILE_BATCH_SIZE (4 * 1024 * 1024)
+
+/**
+ * Write-behind batching of output file IFC.
+ *
+ * send() appends buffers into one block while the other block is being
+ * written by the batch thread.
+ */
+typedef struct file_batch_s {
+   uint8_t *block[2];    ///< Blocks of FILE_BATCH_SIZE bytes
+   uint32_t used[2];     ///< Number of bytes stored in blocks
+   int cur;              ///< Index of block filled by send()
+   int pending;          ///< Index of block waiting for write, -1 if none
+   int pending_fd;       ///< Descriptor the pending block is written to
+   int error;            ///< errno of the last failed write, 0 if none
+   char terminate;       ///< Stop the batch thread
+   pthread_mutex_t lock;
+   pthread_cond_t cond;
+   pthread_t thread;
+} file_batch_t;
+
+/**
+ * Sidecar index of file IFC (<file>.idx).
+ *
+ * The index starts with file_index_header_t followed by one entry per buffer
+ * of the data file.  Times are in the format of UniRec time (seconds in the
+ * upper 32 bits, fraction of second in the lower 32 bits).
+ */
+#define FILE_INDEX_MAGIC "TRAPIDX1"
+#define FILE_INDEX_SUFFIX ".idx"
+#define FILE_INDEX_TIME_FIELD "TIME_FIRST" ///< UniRec field used as the key of index
+
+/** Key of index entries */
+enum file_index_key {
+   FILE_INDEX_KEY_WRITE_TIME = 0, ///< time when the buffer was written
+   FILE_INDEX_KEY_TIME_FIRST = 1  ///< min/max of FILE_INDEX_TIME_FIELD of messages in the buffer
+};
+
+typedef struct file_index_header_s {
+   char magic[8];        ///< FILE_INDEX_MAGIC
+   uint32_t key;         ///< enum file_index_key
+   uint32_t reserved;
+} file_index_header_t;
+
+typedef struct file_index_entry_s {
+   uint64_t offset;      ///< Offset of the buffer (its data_length) in data file
+   uint64_t first;       ///< Minimal time of messages in the buffer
+   uint64_t last;        ///< Maximal time of messages in the buffer
+   uint32_t messages;    ///< Number of messages in the buffer, 0 for compressed buffers
+   uint32_t reserved;
+} file_index_entry_t;
+
+/** State of index of the current input file */
+enum file_index_state {
+   FILE_INDEX_UNKNOWN = 0, ///< index was not loaded yet
+   FILE_INDEX_LOADED,      ///< entries are loaded
+   FILE_INDEX_NONE         ///< there is no usable index, buffers are checked while they are read
+};
+
+/**
+ * Rotation of output file IFC into slices (time= and size= parameters).
+ *
+ * The rotation thread keeps one spare file opened under a temporary name.
+ * send() switches to the spare file when the current slice is full and
+ * hands the old file over to the thread, which closes it, renames the
+ * spare file to the name of the new slice and opens another spare file.
+ */
+typedef struct file_rotate_s {
+   char *tmp_prefix;     ///< Directory of spare files incl. trailing '/', empty for current directory
+   uint32_t tmp_cnt;     ///< Counter used in names of spare files
+   FILE *spare;          ///< Spare file prepared for the next slice, NULL if not ready
+   FILE *spare_index;    ///< Index of spare file (if index is enabled)
+   char *spare_name;     ///< Temporary name of spare file
+   FILE *close_fd;       ///< Finished slice to be closed by the thread, NULL if none
+   FILE *close_index;    ///< Index of finished slice
+   char *rename_from;    ///< Temporary name of the new slice
+   char *rename_to;      ///< Name of the new slice (strftime already applied)
+   int error;            ///< errno of the last failed opening of spare file, 0 if none
+   char terminate;       ///< Stop the rotation thread
+   pthread_mutex_t lock;
+   pthread_cond_t cond;
+   pthread_t thread;
+} file_rotate_t;
+
 typedef struct file_private_s {
    trap_ctx_priv_t *ctx;
    FILE *fd;
@@ -54,12 +148,39 @@ typedef struct file_private_s {
    uint8_t neg_initialized;
    uint32_t file_cnt;
    uint32_t ifc_idx;
+   enum file_io_engine io;  ///< Selected I/O engine
+   uint8_t *map;            ///< FILE_IO_MMAP: mapped input file
+   size_t map_size;         ///< FILE_IO_MMAP: size of the mapping
+   size_t map_pos;          ///< FILE_IO_MMAP: offset of the next buffer
+   uint8_t mapped;          ///< FILE_IO_MMAP: current file was already mapped (map is NULL for empty file)
+   file_batch_t *batch;     ///< FILE_IO_BATCH: write-behind state
+   uint32_t rotate_time;    ///< time=: length of slice in seconds, 0 if not set
+   uint64_t rotate_size;    ///< size=: maximal size of slice in bytes, 0 if not set
+   time_t next_rotation;    ///< time=: start of the next slice
+   uint64_t written;        ///< size=: bytes written into the current slice
+   file_rotate_t *rotate;   ///< Rotation state, NULL if output is not sliced
+   char **slices;           ///< Input: sorted list of files matched by glob or found in directory
+   uint32_t slice_cnt;      ///< Input: number of items in slices
+   uint32_t slice_idx;      ///< Input: index of the current slice
+   uint8_t index_on;        ///< Output: write sidecar index (index parameter)
+   FILE *index;             ///< Output: index of the current file
+   uint8_t index_hdr;       ///< Output: header of the current index was written
+   uint64_t offset;         ///< Output: offset of the next buffer in the current file
+   int32_t ts_offset;       ///< Offset of FILE_INDEX_TIME_FIELD in UniRec record, -1 if not known
+   uint8_t window;          ///< Input: start= or end= is set
+   uint64_t start;          ///< Input: start of time window
+   uint64_t end;            ///< Input: end of time window
+   char *index_name;        ///< Input: name of index of the current file
+   enum file_index_state index_state; ///< Input: state of index of the current file
+   file_index_entry_t *entries; ///< Input: loaded index entries
+   uint32_t entry_cnt;      ///< Input: number of loaded entries
+   uint32_t entry_idx;      ///< Input: next entry to be checked
 } file_private_t;
 
 /** Create file receive interface (input ifc).
  *  Receive function of this interface reads data from defined file.
  *  @param[in] ctx   Pointer to the private libtrap context data (#trap_ctx_init()).
- *  @param[in] params <filename> expected.
+ *  @param[in] params <filename>[:start=<time>][:end=<time>][:io=mmap] expected, <filename> can be a glob pattern or a directory of slices.
  *  @param[out] ifc Created interface.
  *  @return Error code (0 on success). Generated interface is returned in ifc.
  */
@@ -69,8 +190,9 @@ int create_file_recv_ifc(trap_ctx_priv_t *ctx, const char *params, trap_input_if
 /** Create file send interface (output ifc).
  *  Send function of this interface stores data into defined file.
  *  @param[in] ctx   Pointer to the private libtrap context data (#trap_ctx_init()).
- *  @param[in] params <filename>:<mode>
+ *  @param[in] params <filename>[:<mode>][:time=<sec>][:size=<bytes>][:index][:io=batch]
  *                    <mode> is optional, w - write, a - append. Append is set as default mode.
+ *                    time= and size= split output into slices, <filename> is a strftime() format then.
  *  @param[out] ifc Created interface.
  *  @return Error code (0 on success). Generated interface is returned in ifc.
  */
@@ -0,0 +1,1160 @@
+/**
+ * \file ifc_shm.c
+ * \brief TRAP shared memory interfaces (ring buffer of TRAP buffers)
+ */
+/*
+ * Copyright (C) 2026 CESNET
+ *
+ * LICENSE TERMS
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name of the Company nor the names of its contributors
+ *    may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ *
+ * ALTERNATIVELY, provided that this notice is retained in full, this
+ * product may be distributed under the terms of the GNU General Public
+ * License (GPL) version 2 or later, in which case the provisions
+ * of the GPL apply INSTEAD OF those given above.
+ *
+ * This software is provided ``as is'', and any express or implied
+ * warranties, including, but not limited to, the implied warranties of
+ * merchantability and fitness for a particular purpose are disclaimed.
+ * In no event shall the company or contributors be liable for any
+ * direct, indirect, incidental, special, exemplary, or consequential
+ * damages (including, but not limited to, procurement of substitute
+ * goods or services; loss of use, data, or profits; or business
+ * interruption) however caused and on any theory of liability, whether
+ * in contract, strict liability, or tort (including negligence or
+ * otherwise) arising in any way out of the use of this software, even
+ * if advised of the possibility of such damage.
+ *
+ */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <inttypes.h>
+#include <limits.h>
+#include <time.h>
+#include <errno.h>
+#include <assert.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <pthread.h>
+#include <arpa/inet.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <sys/un.h>
+
+#include "../include/libtrap/trap.h"
+#include "trap_internal.h"
+#include "trap_ifc.h"
+#include "trap_error.h"
+#include "ifc_shm.h"
+
+#ifdef HAVE_LINUX_FUTEX_H
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#endif
+
+/**
+ * \addtogroup trap_ifc TRAP communication module interface
+ * @{
+ */
+/**
+ * \defgroup shm_ifc Shared memory interface module
+ *
+ * Output IFC creates POSIX shared memory with a ring of TRAP buffers and
+ * every connected input IFC (reader) gets all buffers, i.e. it behaves like
+ * TCPIP IFC but buffers are copied only once into the ring and once out of it.
+ * Writer waits for the slowest reader when the ring is full.
+ *
+ * UNIX socket is used to negotiate data format and to pass the name of
+ * shared memory and index of reader entry.  Writer recognizes disconnected
+ * readers by closing of this socket.  Waiting for data/space uses futex(2)
+ * on counters in the shared memory, or short sleep when futex is not available.
+ * @{
+ */
+
+/** Maximal time (in usec) of one wait, termination and peer state are checked between waits. */
+#define SHM_WAIT_SLICE     100000
+
+/** Polling interval (in usec) used instead of futex. */
+#define SHM_POLL_INTERVAL  50
+
+/** Timeout (in msec) of operations on control socket. */
+#define SHM_CTRL_TIMEOUT   1000
+
+#define SHM_ALIGN(x) ((((x) + SHM_CACHELINE - 1) / SHM_CACHELINE) * SHM_CACHELINE)
+
+/** Get array of reader entries. */
+#define SHM_RING_READERS(ring) ((shm_ring_reader_t *) (((uint8_t *) (ring)) + sizeof(shm_ring_header_t)))
+
+/** Get slot for sequence number seq. */
+#define SHM_RING_SLOT(ring, seq) ((trap_buffer_header_t *) (((uint8_t *) (ring)) + sizeof(shm_ring_header_t) + \
+                                  (ring)->max_readers * sizeof(shm_ring_reader_t) + \
+                                  ((seq) % (ring)->slot_count) * (uint64_t) (ring)->slot_size))
+
+static inline size_t shm_ring_size(uint32_t slot_count, uint32_t slot_size, uint32_t max_readers)
+{
+   return sizeof(shm_ring_header_t) + max_readers * sizeof(shm_ring_reader_t) + slot_count * (size_t) slot_size;
+}
+
+static inline uint64_t shm_now_us(void)
+{
+   struct timespec ts;
+   clock_gettime(CLOCK_MONOTONIC, &ts);
+   return ts.tv_sec * 1000000ULL + ts.tv_nsec / 1000;
+}
+
+/**
+ * Compute how long the next wait can be.
+ *
+ * \param[in] timeout  libtrap timeout of the current call
+ * \param[in] entry_time  time of entry into the current call (shm_now_us())
+ * \return time to wait in usec, 0 when timeout elapsed
+ */
+static inline int shm_wait_slice(int timeout, uint64_t entry_time)
+{
+   uint64_t elapsed;
+
+   if (timeout == TRAP_WAIT) {
+      return SHM_WAIT_SLICE;
+   } else if (timeout <= 0) {
+      return 0;
+   }
+   elapsed = shm_now_us() - entry_time;
+   if (elapsed >= (uint64_t) timeout) {
+      return 0;
+   }
+   elapsed = timeout - elapsed;
+   return (elapsed < SHM_WAIT_SLICE ? (int) elapsed : SHM_WAIT_SLICE);
+}
+
+/**
+ * Sleep until value of addr differs from val, it is woken up or usec elapsed.
+ */
+static inline void shm_futex_wait(uint32_t *addr, uint32_t val, int usec)
+{
+#ifdef HAVE_LINUX_FUTEX_H
+   struct timespec ts = { usec / 1000000, (usec % 1000000) * 1000 };
+   syscall(SYS_futex, addr, FUTEX_WAIT, val, &ts, NULL, 0);
+#else
+   struct timespec ts = { 0, (usec < SHM_POLL_INTERVAL ? usec : SHM_POLL_INTERVAL) * 1000 };
+   if (__atomic_load_n(addr, __ATOMIC_ACQUIRE) == val) {
+      nanosleep(&ts, NULL);
+   }
+#endif
+}
+
+/**
+ * Increment futex counter and wake up waiting processes if there are any.
+ * \param[in] futex  counter the waiters sleep on
+ * \param[in] waiting  number of waiters
+ */
+static inline void shm_futex_kick(uint32_t *futex, uint32_t *waiting)
+{
+   __atomic_add_fetch(futex, 1, __ATOMIC_SEQ_CST);
+#ifdef HAVE_LINUX_FUTEX_H
+   if (__atomic_load_n(waiting, __ATOMIC_SEQ_CST) != 0) {
+      syscall(SYS_futex, futex, FUTEX_WAKE, INT_MAX, NULL, NULL, 0);
+   }
+#else
+   (void) waiting;
+#endif
+}
+
+/**
+ * Send or receive the whole message via control socket.
+ *
+ * \param[in] sd  control socket
+ * \param[in,out] buf  message
+ * \param[in] size  size of message
+ * \param[in] sending  1 to send, 0 to receive
+ * \return TRAP_E_OK on success, TRAP_E_TIMEOUT or TRAP_E_IO_ERROR otherwise
+ */
+static int shm_ctrl_xfer(int sd, void *buf, size_t size, char sending)
+{
+   struct pollfd pfd;
+   size_t done = 0;
+   ssize_t n;
+
+   pfd.fd = sd;
+   pfd.events = (sending ? POLLOUT : POLLIN);
+   while (done < size) {
+      pfd.revents = 0;
+      if (poll(&pfd, 1, SHM_CTRL_TIMEOUT) <= 0) {
+         return TRAP_E_TIMEOUT;
+      }
+      if (sending) {
+         n = send(sd, (uint8_t *) buf + done, size - done, MSG_NOSIGNAL | MSG_DONTWAIT);
+      } else {
+         n = recv(sd, (uint8_t *) buf + done, size - done, MSG_DONTWAIT);
+         if (n == 0) {
+            return TRAP_E_IO_ERROR;
+         }
+      }
+      if (n < 0) {
+         if ((errno == EAGAIN) || (errno == EWOULDBLOCK) || (errno == EINTR)) {
+            continue;
+         }
+         return TRAP_E_IO_ERROR;
+      }
+      done += n;
+   }
+   return TRAP_E_OK;
+}
+
+/**
+ * \defgroup shm_sender SHM output IFC
+ * @{
+ */
+
+/**
+ * Release reader entry, writer does not wait for it anymore.
+ * Caller must hold c->lock.
+ */
+static void shm_sender_detach_reader(shm_sender_private_t *c, uint32_t idx)
+{
+   shm_ring_reader_t *r = &SHM_RING_READERS(c->ring)[idx];
+
+   __atomic_store_n(&r->state, SHM_READER_FREE, __ATOMIC_SEQ_CST);
+   __atomic_add_fetch(&r->generation, 1, __ATOMIC_SEQ_CST);
+   /* reader that is copying a slot must see the new generation before the slot is overwritten */
+   __atomic_thread_fence(__ATOMIC_SEQ_CST);
+   shm_futex_kick(&c->ring->data_futex, &c->ring->readers_waiting);
+}
+
+/**
+ * Assign free reader entry to negotiated reader and send it the attach message.
+ */
+static int shm_sender_attach_reader(shm_sender_private_t *c, int sd)
+{
+   shm_attach_msg_t msg;
+   shm_ring_reader_t *r;
+   size_t name_len;
+   uint32_t i;
+
+   name_len = strlen(c->shm_name);
+   if (name_len >= sizeof(msg.shm_name)) {
+      VERBOSE(CL_ERROR, "SHM IFC: name of shared memory %s is too long, refusing reader.", c->shm_name);
+      return TRAP_E_BADPARAMS;
+   }
+
+   pthread_mutex_lock(&c->lock);
+   for (i = 0; i < c->ring->max_readers; i++) {
+      if (c->readers[i].sd == -1) {
+         break;
+      }
+   }
+   if (i == c->ring->max_readers) {
+      pthread_mutex_unlock(&c->lock);
+      VERBOSE(CL_VERBOSE_LIBRARY, "SHM IFC: maximal number of readers reached, refusing reader.");
+      return TRAP_E_IO_ERROR;
+   }
+   r = &SHM_RING_READERS(c->ring)[i];
+   /* new reader starts with the next published buffer */
+   __atomic_store_n(&r->read_seq, __atomic_load_n(&c->ring->write_seq, __ATOMIC_SEQ_CST), __ATOMIC_SEQ_CST);
+   msg.generation = __atomic_add_fetch(&r->generation, 1, __ATOMIC_SEQ_CST);
+   __atomic_store_n(&r->state, SHM_READER_ACTIVE, __ATOMIC_SEQ_CST);
+   c->readers[i].sd = sd;
+   c->readers[i].closing = 0;
+   pthread_mutex_unlock(&c->lock);
+
+   msg.reader_idx = i;
+   memset(msg.shm_name, 0, sizeof(msg.shm_name));
+   memcpy(msg.shm_name, c->shm_name, name_len + 1);
+   if (shm_ctrl_xfer(sd, &msg, sizeof(msg), 1) != TRAP_E_OK) {
+      VERBOSE(CL_VERBOSE_LIBRARY, "SHM IFC: sending of attach message failed, refusing reader.");
+      pthread_mutex_lock(&c->lock);
+      shm_sender_detach_reader(c, i);
+      c->readers[i].sd = -1;
+      pthread_mutex_unlock(&c->lock);
+      return TRAP_E_IO_ERROR;
+   }
+   VERBOSE(CL_VERBOSE_LIBRARY, "SHM IFC: reader %"PRIu32" attached.", i);
+
+   /* writer may wait for the first reader */
+   shm_futex_kick(&c->ring->space_futex, &c->ring->writer_waiting);
+   return TRAP_E_OK;
+}
+
+/**
+ * Negotiate and attach new reader, close its socket on failure.
+ */
+static void shm_sender_new_reader(shm_sender_private_t *c, int sd)
+{
+#ifdef ENABLE_NEGOTIATION
+   int ret_val = output_ifc_negotiation(c, TRAP_IFC_TYPE_SHM, sd);
+   if (ret_val == NEG_RES_OK) {
+      VERBOSE(CL_VERBOSE_LIBRARY, "Output_ifc_negotiation result: success.");
+   } else if (ret_val == NEG_RES_FMT_UNKNOWN) {
+      VERBOSE(CL_VERBOSE_LIBRARY, "Output_ifc_negotiation result: failed (unknown data format of this output interface -> refuse client).");
+      close(sd);
+      return;
+   } else { // ret_val == NEG_RES_FAILED, sending the data to input interface failed, refuse client
+      VERBOSE(CL_VERBOSE_LIBRARY, "Output_ifc_negotiation result: failed (error while sending hello message to input interface).");
+      close(sd);
+      return;
+   }
+#endif
+   if (shm_sender_attach_reader(c, sd) != TRAP_E_OK) {
+      close(sd);
+   }
+}
+
+/**
+ * Accept thread: accepts readers on control socket and detaches readers
+ * whose control socket was closed.
+ */
+static void *shm_sender_accept_thread(void *arg)
+{
+   shm_sender_private_t *c = (shm_sender_private_t *) arg;
+   uint32_t max_readers = c->ring->max_readers;
+   struct pollfd *fds;
+   uint32_t *fd_reader;
+   uint32_t i, nfds;
+   char drain[16];
+   int sd;
+
+   fds = (struct pollfd *) calloc(max_readers + 2, sizeof(struct pollfd));
+   fd_reader = (uint32_t *) calloc(max_readers + 2, sizeof(uint32_t));
+   if ((fds == NULL) || (fd_reader == NULL)) {
+      VERBOSE(CL_ERROR, "SHM IFC: not enough memory for accept thread.");
+      goto exit;
+   }
+
+   while (c->is_terminated == 0) {
+      fds[0].fd = c->server_sd;
+      fds[0].events = POLLIN;
+      fds[1].fd = c->wake_pipe[0];
+      fds[1].events = POLLIN;
+      nfds = 2;
+      pthread_mutex_lock(&c->lock);
+      for (i = 0; i < max_readers; i++) {
+         if (c->readers[i].sd == -1) {
+            continue;
+         }
+         if (c->readers[i].closing) {
+            /* already detached by disconn_clients() */
+            close(c->readers[i].sd);
+            c->readers[i].sd = -1;
+            c->readers[i].closing = 0;
+            continue;
+         }
+         fds[nfds].fd = c->readers[i].sd;
+         fds[nfds].events = POLLIN;
+         fd_reader[nfds] = i;
+         nfds++;
+      }
+      pthread_mutex_unlock(&c->lock);
+      for (i = 0; i < nfds; i++) {
+         fds[i].revents = 0;
+      }
+
+      if (poll(fds, nfds, -1) < 0) {
+         if (errno == EINTR) {
+            continue;
+         }
+         VERBOSE(CL_ERROR, "SHM IFC: poll() failed: %s", strerror(errno));
+         break;
+      }
+      if (fds[1].revents != 0) {
+         if (read(c->wake_pipe[0], drain, sizeof(drain)) < 0) {
+            VERBOSE(CL_VERBOSE_LIBRARY, "SHM IFC: reading of wake pipe failed.");
+         }
+      }
+      for (i = 2; i < nfds; i++) {
+         if (fds[i].revents == 0) {
+            continue;
+         }
+         /* reader never sends anything after attach, so this is hangup */
+         pthread_mutex_lock(&c->lock);
+         if ((c->readers[fd_reader[i]].sd == fds[i].fd) && (c->readers[fd_reader[i]].closing == 0)) {
+            shm_sender_detach_reader(c, fd_reader[i]);
+            close(c->readers[fd_reader[i]].sd);
+            c->readers[fd_reader[i]].sd = -1;
+            VERBOSE(CL_VERBOSE_LIBRARY, "SHM IFC: reader %"PRIu32" disconnected.", fd_reader[i]);
+         }
+         pthread_mutex_unlock(&c->lock);
+         shm_futex_kick(&c->ring->space_futex, &c->ring->writer_waiting);
+      }
+      if ((fds[0].revents & POLLIN) && (c->is_terminated == 0)) {
+         sd = accept(c->server_sd, NULL, NULL);
+         if (sd == -1) {
+            continue;
+         }
+         shm_sender_new_reader(c, sd);
+      }
+   }
+
+exit:
+   free(fds);
+   free(fd_reader);
+   return NULL;
+}
+
+/**
+ * Check whether the buffer with sequence number c->write_seq can be written.
+ *
+ * \return TRAP_E_OK when all readers released the slot,
+ * TRAP_E_IO_ERROR when there is no reader, TRAP_E_TIMEOUT when the ring is full
+ */
+static int shm_sender_check_space(shm_sender_private_t *c)
+{
+   shm_ring_reader_t *r = SHM_RING_READERS(c->ring);
+   uint32_t i, readers = 0;
+   int result = TRAP_E_OK;
+
+   pthread_mutex_lock(&c->lock);
+   for (i = 0; i < c->ring->max_readers; i++) {
+      if (__atomic_load_n(&r[i].state, __ATOMIC_SEQ_CST) != SHM_READER_ACTIVE) {
+         continue;
+      }
+      readers++;
+      if (c->write_seq - __atomic_load_n(&r[i].read_seq, __ATOMIC_SEQ_CST) >= c->ring->slot_count) {
+         result = TRAP_E_TIMEOUT;
+         break;
+      }
+   }
+   pthread_mutex_unlock(&c->lock);
+   if (readers == 0) {
+      return TRAP_E_IO_ERROR;
+   }
+   return result;
+}
+
+/**
+ * \brief Publish TRAP buffer in the ring.
+ *
+ * Without readers, TRAP_HALFWAIT behaves like TRAP_NO_WAIT, with readers
+ * like TRAP_WAIT, i.e. the same way as TCPIP IFC.
+ *
+ * \param[in,out] priv  pointer to module private data
+ * \param[in] data  TRAP buffer (header and data)
+ * \param[in] size  size of data
+ * \param[in] timeout  timeout in usec, TRAP_WAIT, TRAP_HALFWAIT or TRAP_NO_WAIT
+ * \return TRAP_E_OK on success, TRAP_E_TIMEOUT, TRAP_E_TERMINATED
+ */
+static int shm_sender_send(void *priv, const void *data, uint32_t size, int timeout)
+{
+   shm_sender_private_t *c = (shm_sender_private_t *) priv;
+   shm_ring_header_t *ring = c->ring;
+   uint64_t entry_time = shm_now_us();
+   uint32_t val;
+   int slice, result;
+
+   assert(timeout >= TRAP_HALFWAIT);
+
+   if (size > ring->slot_size) {
+      return trap_errorf(c->ctx, TRAP_E_BADPARAMS, "SHM IFC: message of %"PRIu32" B does not fit into slot.", size);
+   }
+
+   while ((result = shm_sender_check_space(c)) != TRAP_E_OK) {
+      if (c->is_terminated) {
+         return TRAP_E_TERMINATED;
+      }
+      if ((timeout == TRAP_HALFWAIT) && (result == TRAP_E_TIMEOUT)) {
+         slice = SHM_WAIT_SLICE;
+      } else {
+         slice = shm_wait_slice(timeout, entry_time);
+      }
+      if (slice == 0) {
+         return TRAP_E_TIMEOUT;
+      }
+      __atomic_add_fetch(&ring->writer_waiting, 1, __ATOMIC_SEQ_CST);
+      val = __atomic_load_n(&ring->space_futex, __ATOMIC_SEQ_CST);
+      if ((shm_sender_check_space(c) != TRAP_E_OK) && (c->is_terminated == 0)) {
+         shm_futex_wait(&ring->space_futex, val, slice);
+      }
+      __atomic_sub_fetch(&ring->writer_waiting, 1, __ATOMIC_SEQ_CST);
+   }
+   if (c->is_terminated) {
+      return TRAP_E_TERMINATED;
+   }
+
+   memcpy(SHM_RING_SLOT(ring, c->write_seq), data, size);
+   c->write_seq++;
+   __atomic_store_n(&ring->write_seq, c->write_seq, __ATOMIC_SEQ_CST);
+   shm_futex_kick(&ring->data_futex, &ring->readers_waiting);
+   return TRAP_E_OK;
+}
+
+/**
+ * Detach all readers, they reconnect and negotiate again.
+ */
+static void shm_sender_disconnect_all_readers(void *priv)
+{
+   shm_sender_private_t *c = (shm_sender_private_t *) priv;
+   uint32_t i;
+   char b = 0;
+
+   pthread_mutex_lock(&c->lock);
+   for (i = 0; i < c->ring->max_readers; i++) {
+      if ((c->readers[i].sd != -1) && (c->readers[i].closing == 0)) {
+         shm_sender_detach_reader(c, i);
+         c->readers[i].closing = 1;
+      }
+   }
+   pthread_mutex_unlock(&c->lock);
+   if (write(c->wake_pipe[1], &b, 1) != 1) {
+      VERBOSE(CL_ERROR, "SHM IFC: waking of accept thread failed.");
+   }
+}
+
+static int32_t shm_sender_get_client_count(void *priv)
+{
+   shm_sender_private_t *c = (shm_sender_private_t *) priv;
+   int32_t count = 0;
+   uint32_t i;
+
+   if (c == NULL) {
+      return 0;
+   }
+   pthread_mutex_lock(&c->lock);
+   for (i = 0; i < c->ring->max_readers; i++) {
+      if ((c->readers[i].sd != -1) && (c->readers[i].closing == 0)) {
+         count++;
+      }
+   }
+   pthread_mutex_unlock(&c->lock);
+   return count;
+}
+
+static void shm_sender_terminate(void *priv)
+{
+   shm_sender_private_t *c = (shm_sender_private_t *) priv;
+   char b = 0;
+
+   if (c == NULL) {
+      VERBOSE(CL_ERROR, "SHM IFC: attempt to terminate IFC that is probably not initialized.");
+      return;
+   }
+   c->is_terminated = 1;
+   shm_futex_kick(&c->ring->space_futex, &c->ring->writer_waiting);
+   if (write(c->wake_pipe[1], &b, 1) != 1) {
+      VERBOSE(CL_ERROR, "SHM IFC: waking of accept thread failed.");
+   }
+}
+
+/**
+ * Free everything allocated by create_shm_sender_ifc(), it is used also on failure of constructor.
+ */
+static void shm_sender_free(shm_sender_private_t *c)
+{
+   uint32_t i;
+
+   if (c->ring != NULL) {
+      /* readers drain the ring and disconnect */
+      __atomic_store_n(&c->ring->writer_closed, 1, __ATOMIC_SEQ_CST);
+      shm_futex_kick(&c->ring->data_futex, &c->ring->readers_waiting);
+      if (c->readers != NULL) {
+         for (i = 0; i < c->ring->max_readers; i++) {
+            if (c->readers[i].sd != -1) {
+               close(c->readers[i].sd);
+            }
+         }
+      }
+      munmap(c->ring, c->ring_size);
+   }
+   if (c->shm_name[0] != 0) {
+      shm_unlink(c->shm_name);
+   }
+   if (c->server_sd != -1) {
+      close(c->server_sd);
+      unlink(c->sock_path);
+   }
+   if (c->wake_pipe[0] != -1) {
+      close(c->wake_pipe[0]);
+      close(c->wake_pipe[1]);
+   }
+   pthread_mutex_destroy(&c->lock);
+   free(c->readers);
+   free(c->sock_path);
+   free(c->name);
+   free(c);
+}
+
+static void shm_sender_destroy(void *priv)
+{
+   shm_sender_private_t *c = (shm_sender_private_t *) priv;
+   char b = 0;
+
+   if (c == NULL) {
+      VERBOSE(CL_ERROR, "SHM IFC: attempt to destroy IFC that is probably not initialized.");
+      return;
+   }
+   if (c->accept_thread_running) {
+      c->is_terminated = 1;
+      if (write(c->wake_pipe[1], &b, 1) != 1) {
+         VERBOSE(CL_ERROR, "SHM IFC: waking of accept thread failed.");
+      }
+      pthread_join(c->accept_thread, NULL);
+   }
+   shm_sender_free(c);
+}
+
+static void shm_sender_create_dump(void *priv, uint32_t idx, const char *path)
+{
+   shm_sender_private_t *c = (shm_sender_private_t *) priv;
+   shm_ring_reader_t *r = SHM_RING_READERS(c->ring);
+   char *conf_file = NULL;
+   FILE *f = NULL;
+   uint32_t i;
+
+   if (asprintf(&conf_file, "%s/trap-o%02"PRIu32"-config.txt", path, idx) == -1) {
+      VERBOSE(CL_ERROR, "Not enough memory, dump failed. (%s:%d)", __FILE__, __LINE__);
+      return;
+   }
+   f = fopen(conf_file, "w");
+   if (f == NULL) {
+      VERBOSE(CL_ERROR, "Opening of dump file %s failed.", conf_file);
+      free(conf_file);
+      return;
+   }
+   fprintf(f, "Name: %s\nShared memory: %s\nControl socket: %s\nSlots: %"PRIu32" x %"PRIu32" B\n"
+           "Max readers: %"PRIu32"\nWrite seq: %"PRIu64"\nTerminated: %d\n",
+           c->name, c->shm_name, c->sock_path, c->ring->slot_count, c->ring->slot_size,
+           c->ring->max_readers, c->write_seq, c->is_terminated);
+   for (i = 0; i < c->ring->max_readers; i++) {
+      fprintf(f, "Reader %"PRIu32": state %"PRIu32" generation %"PRIu32" read_seq %"PRIu64"\n",
+              i, r[i].state, r[i].generation, r[i].read_seq);
+   }
+   fclose(f);
+   free(conf_file);
+}
+
+int create_shm_sender_ifc(trap_ctx_priv_t *ctx, const char *params, trap_output_ifc_t *ifc, uint32_t idx)
+{
+   int result = TRAP_E_OK;
+   char *param_iterator = NULL;
+   char *param = NULL;
+   shm_sender_private_t *c = NULL;
+   uint32_t slot_count = SHM_DEFAULT_SLOTS;
+   uint32_t max_readers = SHM_DEFAULT_READERS;
+   uint32_t i;
+   struct sockaddr_un addr;
+   int fd;
+
+#define X(pointer) free(pointer); \
+   pointer = NULL;
+
+   if (params == NULL) {
+      VERBOSE(CL_ERROR, "SHM IFC requires at least one parameter (name).");
+      return TRAP_E_BADPARAMS;
+   }
+
+   c = (shm_sender_private_t *) calloc(1, sizeof(shm_sender_private_t));
+   if (c == NULL) {
+      VERBOSE(CL_ERROR, "Failed to allocate internal memory for output IFC.");
+      return TRAP_E_MEMORY;
+   }
+   c->ctx = ctx;
+   c->ifc_idx = idx;
+   c->server_sd = -1;
+   c->wake_pipe[0] = c->wake_pipe[1] = -1;
+   pthread_mutex_init(&c->lock, NULL);
+
+   /* Parsing params */
+   param_iterator = trap_get_param_by_delimiter(params, &c->name, TRAP_IFC_PARAM_DELIMITER);
+   if ((c->name == NULL) || (strlen(c->name) == 0)) {
+      VERBOSE(CL_ERROR, "Missing 'name' for SHM IFC.");
+      result = TRAP_E_BADPARAMS;
+      goto failsafe_cleanup;
+   }
+   while (param_iterator != NULL) {
+      param_iterator = trap_get_param_by_delimiter(param_iterator, &param, TRAP_IFC_PARAM_DELIMITER);
+      if (param == NULL) {
+         break;
+      }
+      if (strncmp(param, "slots=", 6) == 0) {
+         if ((sscanf(param + 6, "%"SCNu32, &slot_count) != 1) || (slot_count == 0)) {
+            VERBOSE(CL_ERROR, "Number of slots given, but it is probably in wrong format.");
+            slot_count = SHM_DEFAULT_SLOTS;
+         }
+      } else if ((sscanf(param, "%"SCNu32, &max_readers) != 1) || (max_readers == 0)) {
+         VERBOSE(CL_ERROR, "Optional max readers number given, but it is probably in wrong format.");
+         max_readers = SHM_DEFAULT_READERS;
+      }
+      X(param);
+   }
+   /* Parsing params ended */
+
+   if (snprintf(c->shm_name, sizeof(c->shm_name), SHM_NAME_FORMAT, c->name, (int) getpid()) >= (int) sizeof(c->shm_name)) {
+      VERBOSE(CL_ERROR, "Name of SHM IFC is too long.");
+      c->shm_name[0] = 0;
+      result = TRAP_E_BADPARAMS;
+      goto failsafe_cleanup;
+   }
+   c->readers = (shm_reader_conn_t *) calloc(max_readers, sizeof(shm_reader_conn_t));
+   if (c->readers == NULL) {
+      result = TRAP_E_MEMORY;
+      goto failsafe_cleanup;
+   }
+   for (i = 0; i < max_readers; i++) {
+      c->readers[i].sd = -1;
+   }
+
+   /* create the ring */
+   shm_unlink(c->shm_name); /* leftover of crashed module with the same PID */
+   fd = shm_open(c->shm_name, O_RDWR | O_CREAT | O_EXCL, S_IRUSR | S_IWUSR | S_IRGRP | S_IWGRP | S_IROTH | S_IWOTH);
+   if (fd == -1) {
+      VERBOSE(CL_ERROR, "SHM IFC: shm_open(%s) failed: %s", c->shm_name, strerror(errno));
+      c->shm_name[0] = 0;
+      result = TRAP_E_IO_ERROR;
+      goto failsafe_cleanup;
+   }
+   if (fchmod(fd, S_IRUSR | S_IWUSR | S_IRGRP | S_IWGRP | S_IROTH | S_IWOTH) == -1) {
+      VERBOSE(CL_ERROR, "Failed to set permissions to shared memory (%s).", c->shm_name);
+   }
+   c->ring_size = shm_ring_size(slot_count, SHM_ALIGN(ifc->buffer_size), max_readers);
+   if (ftruncate(fd, c->ring_size) == -1) {
+      VERBOSE(CL_ERROR, "SHM IFC: allocation of %zu B of shared memory failed: %s", c->ring_size, strerror(errno));
+      close(fd);
+      result = TRAP_E_MEMORY;
+      goto failsafe_cleanup;
+   }
+   c->ring = (shm_ring_header_t *) mmap(NULL, c->ring_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+   close(fd);
+   if (c->ring == MAP_FAILED) {
+      VERBOSE(CL_ERROR, "SHM IFC: mmap() failed: %s", strerror(errno));
+      c->ring = NULL;
+      result = TRAP_E_MEMORY;
+      goto failsafe_cleanup;
+   }
+   c->ring->slot_count = slot_count;
+   c->ring->slot_size = SHM_ALIGN(ifc->buffer_size);
+   c->ring->max_readers = max_readers;
+   c->ring->version = SHM_RING_VERSION;
+   __atomic_store_n(&c->ring->magic, SHM_RING_MAGIC, __ATOMIC_SEQ_CST);
+
+   /* control socket */
+   if (asprintf(&c->sock_path, SHM_CTRL_PATH_FORMAT, c->name) == -1) {
+      c->sock_path = NULL;
+      result = TRAP_E_MEMORY;
+      goto failsafe_cleanup;
+   }
+   memset(&addr, 0, sizeof(addr));
+   addr.sun_family = AF_UNIX;
+   strncpy(addr.sun_path, c->sock_path, sizeof(addr.sun_path) - 1);
+   unlink(addr.sun_path); /* error when file does not exist is not a problem */
+   c->server_sd = socket(AF_UNIX, SOCK_STREAM, 0);
+   if (c->server_sd == -1) {
+      VERBOSE(CL_ERROR, "SHM IFC: socket() failed: %s", strerror(errno));
+      result = TRAP_E_IO_ERROR;
+      goto failsafe_cleanup;
+   }
+   if ((bind(c->server_sd, (struct sockaddr *) &addr, sizeof(addr)) == -1) ||
+       (listen(c->server_sd, max_readers) == -1)) {
+      VERBOSE(CL_ERROR, "SHM IFC: socket %s could not be opened: %s", c->sock_path, strerror(errno));
+      close(c->server_sd);
+      c->server_sd = -1;
+      result = TRAP_E_IO_ERROR;
+      goto failsafe_cleanup;
+   }
+   if (chmod(addr.sun_path, S_IRUSR | S_IWUSR | S_IRGRP | S_IWGRP | S_IROTH | S_IWOTH) == -1) {
+      VERBOSE(CL_ERROR, "Failed to set permissions to socket (%s).", addr.sun_path);
+   }
+
+   if (pipe(c->wake_pipe) != 0) {
+      VERBOSE(CL_ERROR, "SHM IFC: opening of pipe failed.");
+      c->wake_pipe[0] = c->wake_pipe[1] = -1;
+      result = TRAP_E_IO_ERROR;
+      goto failsafe_cleanup;
+   }
+
+   VERBOSE(CL_VERBOSE_ADVANCED, "config:\nname=\"%s\"\nshm=\"%s\"\nslots=%"PRIu32" x %"PRIu32" B\nmax_readers=%"PRIu32,
+           c->name, c->shm_name, c->ring->slot_count, c->ring->slot_size, c->ring->max_readers);
+
+   if (pthread_create(&c->accept_thread, NULL, shm_sender_accept_thread, c) != 0) {
+      VERBOSE(CL_ERROR, "SHM IFC: creation of accept thread failed.");
+      result = TRAP_E_IO_ERROR;
+      goto failsafe_cleanup;
+   }
+   c->accept_thread_running = 1;
+
+   ifc->disconn_clients = shm_sender_disconnect_all_readers;
+   ifc->send = shm_sender_send;
+   ifc->terminate = shm_sender_terminate;
+   ifc->destroy = shm_sender_destroy;
+   ifc->get_client_count = shm_sender_get_client_count;
+   ifc->create_dump = shm_sender_create_dump;
+   ifc->priv = c;
+
+   return TRAP_E_OK;
+
+failsafe_cleanup:
+   X(param);
+   shm_sender_free(c);
+#undef X
+   return result;
+}
+
+/**
+ * @}
+ *//* shm_sender */
+
+/**
+ * \defgroup shm_receiver SHM input IFC
+ * @{
+ */
+
+/**
+ * Close control socket and unmap shared memory.
+ */
+static void shm_receiver_detach(shm_receiver_private_t *c)
+{
+   if (c->sd != -1) {
+      close(c->sd);
+      c->sd = -1;
+   }
+   if (c->ring != NULL) {
+      munmap(c->ring, c->ring_size);
+      c->ring = NULL;
+   }
+   c->attached = 0;
+}
+
+/**
+ * Check that writer still considers our reader entry to be attached.
+ */
+static inline int shm_receiver_valid(shm_receiver_private_t *c)
+{
+   shm_ring_reader_t *r = &SHM_RING_READERS(c->ring)[c->reader_idx];
+
+   return ((__atomic_load_n(&r->generation, __ATOMIC_SEQ_CST) == c->generation) &&
+           (__atomic_load_n(&r->state, __ATOMIC_SEQ_CST) == SHM_READER_ACTIVE));
+}
+
+/**
+ * Check whether the writer closed control socket (e.g. it crashed).
+ */
+static int shm_receiver_peer_closed(shm_receiver_private_t *c)
+{
+   char b;
+   ssize_t n = recv(c->sd, &b, 1, MSG_PEEK | MSG_DONTWAIT);
+
+   return ((n == 0) || ((n < 0) && (errno != EAGAIN) && (errno != EWOULDBLOCK) && (errno != EINTR)));
+}
+
+/**
+ * Connect to output IFC, negotiate and map its ring.
+ *
+ * \return TRAP_E_OK on success, TRAP_E_FIELDS_MISMATCH when negotiation failed,
+ * TRAP_E_TIMEOUT when attach should be tried later
+ */
+static int shm_receiver_attach(shm_receiver_private_t *c)
+{
+   struct sockaddr_un addr;
+   shm_attach_msg_t msg;
+   shm_ring_header_t *ring = NULL;
+   struct stat st;
+   int result = TRAP_E_TIMEOUT;
+   int fd;
+
+   memset(&addr, 0, sizeof(addr));
+   addr.sun_family = AF_UNIX;
+   snprintf(addr.sun_path, sizeof(addr.sun_path) - 1, SHM_CTRL_PATH_FORMAT, c->name);
+   c->sd = socket(AF_UNIX, SOCK_STREAM, 0);
+   if (c->sd == -1) {
+      return TRAP_E_IO_ERROR;
+   }
+   if (connect(c->sd, (struct sockaddr *) &addr, sizeof(addr)) == -1) {
+      DEBUG_IFC(VERBOSE(CL_VERBOSE_LIBRARY, "SHM IFC: connect to %s failed: %s", addr.sun_path, strerror(errno)));
+      goto failed;
+   }
+
+#ifdef ENABLE_NEGOTIATION
+   switch(input_ifc_negotiation(c, TRAP_IFC_TYPE_SHM)) {
+   case NEG_RES_FMT_UNKNOWN:
+      VERBOSE(CL_VERBOSE_LIBRARY, "Input_ifc_negotiation result: failed (unknown data format of the output interface).");
+      goto failed;
+
+   case NEG_RES_CONT:
+      VERBOSE(CL_VERBOSE_LIBRARY, "Input_ifc_negotiation result: success.");
+      break;
+
+   case NEG_RES_FMT_CHANGED: // used on format change with JSON
+      VERBOSE(CL_VERBOSE_LIBRARY, "Input_ifc_negotiation result: success (format has changed; it was not first negotiation).");
+      break;
+
+   case NEG_RES_RECEIVER_FMT_SUBSET: // used on format change with UniRec
+      VERBOSE(CL_VERBOSE_LIBRARY, "Input_ifc_negotiation result: success (required set of fields of the input interface is subset of the recevied format).");
+      break;
+
+   case NEG_RES_SENDER_FMT_SUBSET: // used on format change with UniRec
+      VERBOSE(CL_VERBOSE_LIBRARY, "Input_ifc_negotiation result: success (new recevied format specifier is subset of the old one; it was not first negotiation).");
+      break;
+
+   case NEG_RES_FAILED:
+      VERBOSE(CL_VERBOSE_LIBRARY, "Input_ifc_negotiation result: failed (error while receiving hello message from output interface).");
+      result = TRAP_E_FIELDS_MISMATCH;
+      goto failed;
+
+   case NEG_RES_FMT_MISMATCH:
+      VERBOSE(CL_VERBOSE_LIBRARY, "Input_ifc_negotiation result: failed (data type or data format specifier mismatch).");
+      result = TRAP_E_FIELDS_MISMATCH;
+      goto failed;
+
+   default:
+      VERBOSE(CL_VERBOSE_LIBRARY, "Input_ifc_negotiation result: default case");
+      break;
+   }
+#endif
+
+   if (shm_ctrl_xfer(c->sd, &msg, sizeof(msg), 0) != TRAP_E_OK) {
+      VERBOSE(CL_VERBOSE_LIBRARY, "SHM IFC: attach message was not received (too many readers?).");
+      goto failed;
+   }
+   msg.shm_name[sizeof(msg.shm_name) - 1] = 0;
+
+   fd = shm_open(msg.shm_name, O_RDWR, 0);
+   if (fd == -1) {
+      VERBOSE(CL_ERROR, "SHM IFC: shm_open(%s) failed: %s", msg.shm_name, strerror(errno));
+      goto failed;
+   }
+   if ((fstat(fd, &st) == -1) || (st.st_size < (off_t) sizeof(shm_ring_header_t))) {
+      close(fd);
+      goto failed;
+   }
+   ring = (shm_ring_header_t *) mmap(NULL, st.st_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+   close(fd);
+   if (ring == MAP_FAILED) {
+      VERBOSE(CL_ERROR, "SHM IFC: mmap() failed: %s", strerror(errno));
+      goto failed;
+   }
+   c->ring = ring;
+   c->ring_size = st.st_size;
+   if ((__atomic_load_n(&ring->magic, __ATOMIC_SEQ_CST) != SHM_RING_MAGIC) || (ring->version != SHM_RING_VERSION) ||
+       (shm_ring_size(ring->slot_count, ring->slot_size, ring->max_readers) > c->ring_size) ||
+       (msg.reader_idx >= ring->max_readers)) {
+      VERBOSE(CL_ERROR, "SHM IFC: unexpected content of shared memory %s.", msg.shm_name);
+      goto failed;
+   }
+   c->reader_idx = msg.reader_idx;
+   c->generation = msg.generation;
+   if (shm_receiver_valid(c) == 0) {
+      goto failed;
+   }
+   c->read_seq = __atomic_load_n(&SHM_RING_READERS(ring)[c->reader_idx].read_seq, __ATOMIC_SEQ_CST);
+   strcpy(c->shm_name, msg.shm_name);
+   c->attached = 1;
+   VERBOSE(CL_VERBOSE_LIBRARY, "SHM IFC: attached to %s as reader %"PRIu32".", c->shm_name, c->reader_idx);
+   return TRAP_E_OK;
+
+failed:
+   shm_receiver_detach(c);
+   return result;
+}
+
+/**
+ * \brief Receive one TRAP buffer from the ring.
+ *
+ * Reader is (re)attached automatically, it happens also after change of
+ * data format (writer detaches all readers) or restart of the writer.
+ *
+ * \param [in,out] priv  private configuration structure
+ * \param [out] data  where received data are stored
+ * \param [out] size  size of received data
+ * \param [in] timeout  timeout in usec, can be TRAP_WAIT or TRAP_NO_WAIT
+ * \return TRAP_E_OK (0) on success
+ */
+static int shm_receiver_recv(void *priv, void *data, uint32_t *size, int timeout)
+{
+   shm_receiver_private_t *c = (shm_receiver_private_t *) priv;
+   uint64_t entry_time = shm_now_us();
+   shm_ring_header_t *ring;
+   shm_ring_reader_t *r;
+   trap_buffer_header_t *h;
+   uint32_t len, max_len, val;
+   int slice, result;
+   struct timespec ts;
+
+   assert(timeout > TRAP_HALFWAIT);
+
+   if ((c == NULL) || (data == NULL) || (size == NULL)) {
+      return TRAP_E_BAD_FPARAMS;
+   }
+   (*size) = 0;
+
+   while (c->is_terminated == 0) {
+      if (c->attached == 0) {
+         result = shm_receiver_attach(c);
+         if (result == TRAP_E_FIELDS_MISMATCH) {
+            return TRAP_E_FORMAT_MISMATCH;
+         } else if (result != TRAP_E_OK) {
+            slice = shm_wait_slice(timeout, entry_time);
+            if (slice == 0) {
+               return TRAP_E_TIMEOUT;
+            }
+            ts.tv_sec = 0;
+            ts.tv_nsec = slice * 1000;
+            nanosleep(&ts, NULL);
+            continue;
+         }
+         /* negotiation may have reallocated buffer of input IFC for bigger buffers */
+         data = c->ctx->in_ifc_list[c->ifc_idx].buffer;
+      }
+      ring = c->ring;
+      r = &SHM_RING_READERS(ring)[c->reader_idx];
+      max_len = ring->slot_size - sizeof(trap_buffer_header_t);
+      if (max_len > c->ctx->in_ifc_list[c->ifc_idx].buffer_size) {
+         max_len = c->ctx->in_ifc_list[c->ifc_idx].buffer_size;
+      }
+
+      if (c->read_seq < __atomic_load_n(&ring->write_seq, __ATOMIC_SEQ_CST)) {
+         h = SHM_RING_SLOT(ring, c->read_seq);
+         len = ntohl(h->data_length);
+         if (len <= max_len) {
+            memcpy(data, h->data, len);
+         }
+         /* the slot could have been overwritten if we were detached meanwhile */
+         __atomic_thread_fence(__ATOMIC_SEQ_CST);
+         if ((shm_receiver_valid(c) == 0) || (len > max_len)) {
+            shm_receiver_detach(c);
+            continue;
+         }
+         c->read_seq++;
+         __atomic_store_n(&r->read_seq, c->read_seq, __ATOMIC_SEQ_CST);
+         shm_futex_kick(&ring->space_futex, &ring->writer_waiting);
+         (*size) = len;
+         return TRAP_E_OK;
+      }
+
+      if (shm_receiver_valid(c) == 0) {
+         /* detached by writer, e.g. data format changed */
+         shm_receiver_detach(c);
+         continue;
+      }
+      if (__atomic_load_n(&ring->writer_closed, __ATOMIC_SEQ_CST)) {
+         if (c->read_seq == __atomic_load_n(&ring->write_seq, __ATOMIC_SEQ_CST)) {
+            shm_receiver_detach(c);
+         }
+         continue;
+      }
+
+      slice = shm_wait_slice(timeout, entry_time);
+      if (slice == 0) {
+         return TRAP_E_TIMEOUT;
+      }
+      __atomic_add_fetch(&ring->readers_waiting, 1, __ATOMIC_SEQ_CST);
+      val = __atomic_load_n(&ring->data_futex, __ATOMIC_SEQ_CST);
+      if ((c->read_seq == __atomic_load_n(&ring->write_seq, __ATOMIC_SEQ_CST)) && (c->is_terminated == 0)) {
+         shm_futex_wait(&ring->data_futex, val, slice);
+      }
+      __atomic_sub_fetch(&ring->readers_waiting, 1, __ATOMIC_SEQ_CST);
+
+      if ((c->read_seq == __atomic_load_n(&ring->write_seq, __ATOMIC_SEQ_CST)) && shm_receiver_peer_closed(c)) {
+         /* writer crashed and there is nothing left to read */
+         shm_receiver_detach(c);
+      }
+   }
+   return TRAP_E_TERMINATED;
+}
+
+static void shm_receiver_terminate(void *priv)
+{
+   if (priv != NULL) {
+      ((shm_receiver_private_t *) priv)->is_terminated = 1;
+   } else {
+      VERBOSE(CL_ERROR, "SHM IFC: attempt to terminate IFC that is probably not initialized.");
+   }
+}
+
+static void shm_receiver_destroy(void *priv)
+{
+   shm_receiver_private_t *c = (shm_receiver_private_t *) priv;
+
+   if (c == NULL) {
+      VERBOSE(CL_ERROR, "SHM IFC: attempt to destroy IFC that is probably not initialized.");
+      return;
+   }
+   shm_receiver_detach(c);
+   free(c->name);
+   free(c);
+}
+
+static void shm_receiver_create_dump(void *priv, uint32_t idx, const char *path)
+{
+   shm_receiver_private_t *c = (shm_receiver_private_t *) priv;
+   char *conf_file = NULL;
+   FILE *f = NULL;
+
+   if (asprintf(&conf_file, "%s/trap-i%02"PRIu32"-config.txt", path, idx) == -1) {
+      VERBOSE(CL_ERROR, "Not enough memory, dump failed. (%s:%d)", __FILE__, __LINE__);
+      return;
+   }
+   f = fopen(conf_file, "w");
+   if (f == NULL) {
+      VERBOSE(CL_ERROR, "Opening of dump file %s failed.", conf_file);
+      free(conf_file);
+      return;
+   }
+   fprintf(f, "Name: %s\nShared memory: %s\nAttached: %d\nReader: %"PRIu32"\nGeneration: %"PRIu32"\n"
+           "Read seq: %"PRIu64"\nTerminated: %d\n",
+           c->name, c->shm_name, c->attached, c->reader_idx, c->generation, c->read_seq, c->is_terminated);
+   fclose(f);
+   free(conf_file);
+}
+
+int create_shm_receiver_ifc(trap_ctx_priv_t *ctx, const char *params, trap_input_ifc_t *ifc, uint32_t idx)
+{
+   shm_receiver_private_t *c = NULL;
+
+   if (params == NULL) {
+      VERBOSE(CL_ERROR, "No parameters found for input IFC.");
+      return TRAP_E_BADPARAMS;
+   }
+
+   c = (shm_receiver_private_t *) calloc(1, sizeof(shm_receiver_private_t));
+   if (c == NULL) {
+      VERBOSE(CL_ERROR, "Failed to allocate internal memory for input IFC.");
+      return TRAP_E_MEMORY;
+   }
+   c->ctx = ctx;
+   c->ifc_idx = idx;
+   c->sd = -1;
+
+   trap_get_param_by_delimiter(params, &c->name, TRAP_IFC_PARAM_DELIMITER);
+   if ((c->name == NULL) || (strlen(c->name) == 0)) {
+      VERBOSE(CL_ERROR, "Missing 'name' for SHM IFC.");
+      free(c->name);
+      free(c);
+      return TRAP_E_BADPARAMS;
+   }
+   VERBOSE(CL_VERBOSE_ADVANCED, "config:\nname=\"%s\"", c->name);
+
+   ifc->recv = shm_receiver_recv;
+   ifc->destroy = shm_receiver_destroy;
+   ifc->terminate = shm_receiver_terminate;
+   ifc->create_dump = shm_receiver_create_dump;
+   ifc->priv = c;
+
+   return TRAP_E_OK;
+}
+
+/**
+ * @}
+ *//* shm_receiver */
+
+/**
+ * @}
+ *//* shm_ifc */
+
+/**
+ * @}
+ *//* trap_ifc */
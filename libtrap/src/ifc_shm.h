@@ -0,0 +1,167 @@
+/**
+ * \file ifc_shm.h
+ * \brief TRAP shared memory interfaces
+ */
+/*
+ * Copyright (C) 2026 CESNET
+ *
+ * LICENSE TERMS
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name of the Company nor the names of its contributors
+ *    may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ *
+ * ALTERNATIVELY, provided that this notice is retained in full, this
+ * product may be distributed under the terms of the GNU General Public
+ * License (GPL) version 2 or later, in which case the provisions
+ * of the GPL apply INSTEAD OF those given above.
+ *
+ * This software is provided ``as is'', and any express or implied
+ * warranties, including, but not limited to, the implied warranties of
+ * merchantability and fitness for a particular purpose are disclaimed.
+ * In no event shall the company or contributors be liable for any
+ * direct, indirect, incidental, special, exemplary, or consequential
+ * damages (including, but not limited to, procurement of substitute
+ * goods or services; loss of use, data, or profits; or business
+ * interruption) however caused and on any theory of liability, whether
+ * in contract, strict liability, or tort (including negligence or
+ * otherwise) arising in any way out of the use of this software, even
+ * if advised of the possibility of such damage.
+ *
+ */
+#ifndef _TRAP_IFC_SHM_H_
+#define _TRAP_IFC_SHM_H_
+
+#include <pthread.h>
+#include "trap_ifc.h"
+
+/**
+ * Output IFC listens on UNIX socket with this path (%s is replaced by
+ * name of the IFC).  The socket is used for negotiation and to pass
+ * the name of shared memory to input IFC, data are never sent through it.
+ */
+#define SHM_CTRL_PATH_FORMAT "/tmp/trap-shm-%s.sock"
+
+/**
+ * Name of POSIX shared memory object, %s is replaced by name of the IFC
+ * and %d by PID of the output module.
+ */
+#define SHM_NAME_FORMAT      "/trap-shm-%s-%d"
+
+#define SHM_NAME_MAXLEN      64         ///< Maximal length of shared memory name incl. '\0'
+#define SHM_RING_MAGIC       0x54524d52 ///< "TRMR", identification of ring header
+#define SHM_RING_VERSION     1          ///< Version of ring layout
+#define SHM_DEFAULT_SLOTS    16         ///< Default number of TRAP buffers in the ring
+#define SHM_DEFAULT_READERS  10         ///< Default maximal number of input IFCs
+#define SHM_CACHELINE        64
+
+/** State of the reader entry in the ring */
+enum shm_reader_state {
+   SHM_READER_FREE = 0, ///< unused entry
+   SHM_READER_ACTIVE    ///< attached reader, output IFC waits for it
+};
+
+/**
+ * Header placed at the beginning of shared memory.
+ *
+ * It is followed by max_readers of shm_ring_reader_t and slot_count slots
+ * of slot_size bytes.  Every slot contains one TRAP buffer
+ * (trap_buffer_header_t and data) as it was passed to send().
+ * Only output IFC writes into slots and write_seq, every reader advances
+ * its read_seq.  Slot of sequence number s is (s % slot_count).
+ */
+typedef struct shm_ring_header_s {
+   uint32_t magic;           ///< SHM_RING_MAGIC
+   uint32_t version;         ///< SHM_RING_VERSION
+   uint32_t slot_count;      ///< Number of slots
+   uint32_t slot_size;       ///< Size of slot in bytes
+   uint32_t max_readers;     ///< Number of reader entries
+   uint32_t writer_closed;   ///< Set when output IFC is destroyed
+   uint32_t data_futex;      ///< Incremented after every published buffer, readers wait on it
+   uint32_t space_futex;     ///< Incremented after reader released slot or reader (de)attached, writer waits on it
+   uint32_t readers_waiting; ///< Number of readers that sleep on data_futex
+   uint32_t writer_waiting;  ///< Non-zero when writer sleeps on space_futex
+   uint64_t write_seq __attribute__((aligned(SHM_CACHELINE))); ///< Sequence number of next buffer to write
+} __attribute__((aligned(SHM_CACHELINE))) shm_ring_header_t;
+
+/** Reader entry in shared memory, every reader owns a cache line */
+typedef struct shm_ring_reader_s {
+   uint32_t state;       ///< enum shm_reader_state
+   uint32_t generation;  ///< Incremented by writer on every attach/detach
+   uint64_t read_seq;    ///< Sequence number of next buffer to read
+} __attribute__((aligned(SHM_CACHELINE))) shm_ring_reader_t;
+
+/** Message sent by output IFC via control socket after successful negotiation */
+typedef struct shm_attach_msg_s {
+   uint32_t reader_idx;            ///< Index of reader entry assigned to input IFC
+   uint32_t generation;            ///< Generation of the entry at time of attach
+   char shm_name[SHM_NAME_MAXLEN]; ///< Name of shared memory object
+} shm_attach_msg_t;
+
+/** Connected input IFC from the point of view of output IFC */
+typedef struct shm_reader_conn_s {
+   int sd;        ///< Control socket, -1 when unused
+   char closing;  ///< Reader was detached by disconn_clients, socket will be closed by accept thread
+} shm_reader_conn_t;
+
+typedef struct shm_sender_private_s {
+   trap_ctx_priv_t *ctx;   ///< Libtrap context
+   uint32_t ifc_idx;       ///< Index of IFC in the context
+   char *name;             ///< Name of IFC given by user
+   char shm_name[SHM_NAME_MAXLEN]; ///< Name of shared memory object
+   char *sock_path;        ///< Path of control UNIX socket
+   int server_sd;          ///< Listening control socket
+   int wake_pipe[2];       ///< Pipe to wake up accept thread
+   shm_ring_header_t *ring; ///< Mapped shared memory
+   size_t ring_size;       ///< Size of mapped shared memory
+   shm_reader_conn_t *readers; ///< Control sockets of readers, max_readers items
+   uint64_t write_seq;     ///< Local copy of ring->write_seq
+   char is_terminated;
+   char accept_thread_running;
+   pthread_mutex_t lock;   ///< Protects attach/detach of readers
+   pthread_t accept_thread;
+} shm_sender_private_t;
+
+typedef struct shm_receiver_private_s {
+   trap_ctx_priv_t *ctx;   ///< Libtrap context
+   uint32_t ifc_idx;       ///< Index of IFC in the context
+   char *name;             ///< Name of IFC given by user
+   int sd;                 ///< Control socket, -1 when disconnected
+   char attached;          ///< Reader entry was assigned and shared memory is mapped
+   char is_terminated;
+   shm_ring_header_t *ring; ///< Mapped shared memory
+   size_t ring_size;       ///< Size of mapped shared memory
+   char shm_name[SHM_NAME_MAXLEN]; ///< Name of shared memory object received from output IFC
+   uint32_t reader_idx;    ///< Assigned reader entry
+   uint32_t generation;    ///< Generation of reader entry
+   uint64_t read_seq;      ///< Local copy of read_seq
+} shm_receiver_private_t;
+
+/** Create shared memory receive interface (input ifc).
+ *  @param[in] ctx   Pointer to the private libtrap context data (#trap_ctx_init()).
+ *  @param[in] params <name> of output IFC expected.
+ *  @param[out] ifc Created interface.
+ *  @param[in] idx  Index of IFC.
+ *  @return Error code (0 on success). Generated interface is returned in ifc.
+ */
+int create_shm_receiver_ifc(trap_ctx_priv_t *ctx, const char *params, trap_input_ifc_t *ifc, uint32_t idx);
+
+/** Create shared memory send interface (output ifc).
+ *  @param[in] ctx   Pointer to the private libtrap context data (#trap_ctx_init()).
+ *  @param[in] params <name>[:<max_readers>][:slots=<N>]
+ *  @param[out] ifc Created interface.
+ *  @param[in] idx  Index of IFC.
+ *  @return Error code (0 on success). Generated interface is returned in ifc.
+ */
+int create_shm_sender_ifc(trap_ctx_priv_t *ctx, const char *params, trap_output_ifc_t *ifc, uint32_t idx);
+
+#endif
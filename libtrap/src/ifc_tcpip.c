@@ -54,6 +54,7 @@
 #include <sys/un.h>
 #include <sys/types.h>
 #include <sys/stat.h>
+#include <sys/ioctl.h>
 #include <unistd.h>
 #include <fcntl.h>
 #include <inttypes.h>
@@ -62,6 +63,8 @@
 #include <errno.h>
 #include <semaphore.h>
 #include <assert.h>
+#include <stddef.h>
+#include <endian.h>
 
 #include "../include/libtrap/trap.h"
 #include "trap_internal.h"
@@ -69,6 +72,18 @@
 #include "trap_error.h"
 #include "ifc_tcpip.h"
 #include "ifc_tcpip_internal.h"
+#include "trap_uring.h"
+
+#ifdef HAVE_SYS_EPOLL_H
+#include <sys/epoll.h>
+#endif
+#ifdef HAVE_LINUX_ERRQUEUE_H
+#include <linux/errqueue.h>
+#endif
+
+#if defined(HAVE_LINUX_ERRQUEUE_H) && defined(MSG_ZEROCOPY) && defined(SO_ZEROCOPY) && defined(SO_EE_ORIGIN_ZEROCOPY)
+#define TCPIP_ZEROCOPY
+#endif
 
 /**
  * \addtogroup trap_ifc TRAP communication module interface
@@ -124,6 +139,32 @@ static void *get_in_addr(struct sockaddr *sa)
    return &(((struct sockaddr_in6*)sa)->sin6_addr);
 }
 
+/**
+ * Parse value of parameter "io" and check that the backend is available.
+ *
+ * \param[in] value     select, epoll or uring
+ * \param[out] backend  parsed backend, epoll is replaced by select when the platform lacks it
+ */
+static void parse_io_backend(const char *value, enum tcpip_io_backend *backend)
+{
+   if (strcmp(value, "select") == 0) {
+      (*backend) = IO_BACKEND_SELECT;
+   } else if (strcmp(value, "epoll") == 0) {
+      (*backend) = IO_BACKEND_EPOLL;
+   } else if (strcmp(value, "uring") == 0) {
+      (*backend) = IO_BACKEND_URING;
+   } else {
+      VERBOSE(CL_ERROR, "Unknown I/O backend '%s', using 'select'.", value);
+      (*backend) = IO_BACKEND_SELECT;
+   }
+#ifndef HAVE_SYS_EPOLL_H
+   if ((*backend) == IO_BACKEND_EPOLL) {
+      VERBOSE(CL_ERROR, "I/O backend 'epoll' is not supported on this platform, using 'select'.");
+      (*backend) = IO_BACKEND_SELECT;
+   }
+#endif
+}
+
 /**
  * \addtogroup tcpip_receiver
  * @{
@@ -159,9 +200,11 @@ static int receive_part(void *priv, void **data, uint32_t *size, struct timeval
        * With timeout 0,0 - non-blocking
        */
       retval = select(config->sd + 1, &set, NULL, NULL, tm);
+      config->wait_calls++;
       if (retval > 0) {
          if (FD_ISSET(config->sd, &set)) {
             do {
+               config->recv_calls++;
                if (tm != NULL) {
                   recvb = recv(config->sd, data_p, numbytes, MSG_NOSIGNAL | MSG_DONTWAIT);
                } else {
@@ -216,6 +259,318 @@ static int receive_part(void *priv, void **data, uint32_t *size, struct timeval
    return TRAP_E_TERMINATED;
 }
 
+#ifdef HAVE_SYS_EPOLL_H
+/**
+ * Wait until the socket is readable (readahead mode).
+ *
+ * \param[in] config  private IFC data
+ * \param[in] tm      timeout, NULL to block
+ * \return TRAP_E_OK when data is available, TRAP_E_TIMEOUT, TRAP_E_TERMINATED,
+ * or TRAP_E_IO_ERROR when the client was disconnected
+ */
+static int receive_ra_wait(tcpip_receiver_private_t *config, struct timeval *tm)
+{
+   struct epoll_event ev;
+   int retval, ms = -1;
+
+   if (config->ra_watched == 0) {
+      memset(&ev, 0, sizeof(ev));
+      ev.events = EPOLLIN;
+      ev.data.fd = config->sd;
+      if (epoll_ctl(config->epoll_fd, EPOLL_CTL_ADD, config->sd, &ev) != 0) {
+         VERBOSE(CL_ERROR, "epoll_ctl() failed: %s", strerror(errno));
+         client_socket_disconnect(config);
+         return TRAP_E_IO_ERROR;
+      }
+      config->ra_watched = 1;
+   }
+   if (tm != NULL) {
+      ms = tm->tv_sec * 1000 + (tm->tv_usec + 999) / 1000;
+   }
+   while (config->is_terminated == 0) {
+      retval = epoll_wait(config->epoll_fd, &ev, 1, ms);
+      config->wait_calls++;
+      if (retval > 0) {
+         return TRAP_E_OK;
+      } else if (retval == 0) {
+         return TRAP_E_TIMEOUT;
+      } else if (errno != EINTR) {
+         VERBOSE(CL_VERBOSE_OFF, "epoll_wait() returned %i (%s)", retval, strerror(errno));
+         client_socket_disconnect(config);
+         return TRAP_E_IO_ERROR;
+      }
+   }
+   return TRAP_E_TERMINATED;
+}
+
+/**
+ * Start multishot recv() of the connected socket if it is not active (io=uring).
+ *
+ * \param[in] config  private IFC data
+ * \return TRAP_E_OK on success, TRAP_E_IO_ERROR
+ */
+static int receive_uring_arm(tcpip_receiver_private_t *config)
+{
+   if (config->ur_armed == 0) {
+      if ((trap_uring_prep_recv_multishot(config->uring, config->sd, config->conn_gen) != TRAP_E_OK) ||
+          (trap_uring_submit(config->uring, 0, 0) != TRAP_E_OK)) {
+         return TRAP_E_IO_ERROR;
+      }
+      config->ur_armed = 1;
+   }
+   return TRAP_E_OK;
+}
+
+/**
+ * Move received data into the read-ahead buffer (io=uring).
+ *
+ * Data is taken from the provided buffer of the oldest completion of
+ * multishot recv(), the function waits for a completion when there is
+ * none.  The rest of provided buffer that does not fit is kept for the
+ * next call.  Completions of closed connections are skipped.
+ *
+ * \param[in] config  private IFC data
+ * \param[in] tm      timeout, NULL to block
+ * \return TRAP_E_OK when some data was moved, TRAP_E_TIMEOUT, TRAP_E_TERMINATED,
+ * or TRAP_E_IO_ERROR when the client was disconnected
+ */
+static int receive_ra_uring(tcpip_receiver_private_t *config, struct timeval *tm)
+{
+   trap_uring_cqe_t cqe;
+   uint32_t length;
+   int retval;
+
+   while (config->ur_length == 0) {
+      if (config->is_terminated != 0) {
+         return TRAP_E_TERMINATED;
+      }
+      if (receive_uring_arm(config) != TRAP_E_OK) {
+         VERBOSE(CL_ERROR, "Submission of recv() into io_uring failed.");
+         client_socket_disconnect(config);
+         return TRAP_E_IO_ERROR;
+      }
+      if (trap_uring_next(config->uring, &cqe) == 0) {
+         retval = trap_uring_submit(config->uring, 1, (tm != NULL ? (int64_t) tm->tv_sec * USEC_IN_SEC + tm->tv_usec : -1));
+         config->wait_calls++;
+         if (retval == TRAP_E_IO_ERROR) {
+            client_socket_disconnect(config);
+            return TRAP_E_IO_ERROR;
+         } else if ((retval == TRAP_E_TIMEOUT) && (tm != NULL) && (trap_uring_ready(config->uring) == 0)) {
+            return TRAP_E_TIMEOUT;
+         }
+         continue;
+      }
+      if (cqe.user_data != config->conn_gen) {
+         /* completion of closed connection or of cancellation */
+         if (cqe.buffer >= 0) {
+            trap_uring_pbuf_recycle(config->uring, cqe.buffer);
+         }
+         continue;
+      }
+      config->recv_calls++;
+      if (cqe.more == 0) {
+         config->ur_armed = 0;
+      }
+      if ((cqe.res > 0) && (cqe.buffer >= 0)) {
+         config->ur_buffer = cqe.buffer;
+         config->ur_offset = 0;
+         config->ur_length = cqe.res;
+      } else if (cqe.res != -ENOBUFS) {
+         /* all provided buffers are full for -ENOBUFS, recv() is started again after they are read */
+         if (cqe.buffer >= 0) {
+            trap_uring_pbuf_recycle(config->uring, cqe.buffer);
+         }
+         client_socket_disconnect(config);
+         return TRAP_E_IO_ERROR;
+      }
+   }
+   length = MIN(config->ur_length, config->ra_size - config->ra_end);
+   memcpy(config->ra_buffer + config->ra_end, trap_uring_pbuf(config->uring, config->ur_buffer) + config->ur_offset, length);
+   config->ra_end += length;
+   config->ur_offset += length;
+   config->ur_length -= length;
+   if (config->ur_length == 0) {
+      trap_uring_pbuf_recycle(config->uring, config->ur_buffer);
+      config->ur_buffer = -1;
+   }
+   return TRAP_E_OK;
+}
+
+/**
+ * Receive one TRAP buffer using the read-ahead buffer (readahead mode).
+ *
+ * Complete buffers are copied out of the read-ahead buffer, recv() is
+ * called only when it does not contain a complete buffer and it takes as
+ * much data as fits.  The function blocks (in epoll_wait()) only when the
+ * socket was emptied by the previous recv().  Incomplete buffer stays in
+ * the read-ahead buffer until the next call.  With io=uring, data comes
+ * from multishot recv() (receive_ra_uring()) instead of recv().
+ *
+ * \param[in] config  private IFC data
+ * \param[out] data   payload of received buffer
+ * \param[out] size   size of payload
+ * \param[in] tm      timeout, NULL to block
+ * \return TRAP_E_OK on success, TRAP_E_TIMEOUT, TRAP_E_TERMINATED,
+ * or TRAP_E_IO_ERROR when the client was disconnected
+ */
+static int receive_buffer_ra(tcpip_receiver_private_t *config, void *data, uint32_t *size, struct timeval *tm)
+{
+   uint32_t avail, length;
+#ifdef ENABLE_HEADER_TIMESTAMP
+   uint64_t stamp;
+#endif
+   ssize_t recvb;
+   int retval;
+
+   while (config->is_terminated == 0) {
+      avail = config->ra_end - config->ra_start;
+      if (avail >= sizeof(trap_buffer_header_t)) {
+         memcpy(&length, config->ra_buffer + config->ra_start, sizeof(length));
+         length = ntohl(length);
+         /* read-ahead buffer is never smaller than buffer of input IFC (receive_ra_resize()) */
+         if (length > config->ctx->in_ifc_list[config->ifc_idx].buffer_size) {
+            VERBOSE(CL_ERROR, "Received buffer is too big (%"PRIu32" B), disconnecting.", length);
+            client_socket_disconnect(config);
+            return TRAP_E_IO_ERROR;
+         }
+         if (avail >= sizeof(trap_buffer_header_t) + length) {
+            memcpy(data, config->ra_buffer + config->ra_start + sizeof(trap_buffer_header_t), length);
+#ifdef ENABLE_HEADER_TIMESTAMP
+            memcpy(&stamp, config->ra_buffer + config->ra_start + offsetof(trap_buffer_header_t, timestamp), sizeof(stamp));
+            config->ctx->in_ifc_list[config->ifc_idx].timestamp = be64toh(stamp);
+#endif
+            config->ra_start += sizeof(trap_buffer_header_t) + length;
+            if (config->ra_start == config->ra_end) {
+               config->ra_start = config->ra_end = 0;
+            }
+            config->ext_buffer = data;
+            config->ext_buffer_size = length;
+            (*size) = length;
+            return TRAP_E_OK;
+         }
+      }
+      /* move incomplete buffer to the beginning to receive as much as possible */
+      if (config->ra_start != 0) {
+         memmove(config->ra_buffer, config->ra_buffer + config->ra_start, avail);
+         config->ra_start = 0;
+         config->ra_end = avail;
+      }
+      if (config->uring != NULL) {
+         retval = receive_ra_uring(config, tm);
+         if (retval != TRAP_E_OK) {
+            return retval;
+         }
+         continue;
+      }
+      if (config->ra_drained != 0) {
+         retval = receive_ra_wait(config, tm);
+         if (retval != TRAP_E_OK) {
+            return retval;
+         }
+      }
+      recvb = recv(config->sd, config->ra_buffer + config->ra_end, config->ra_size - config->ra_end,
+                   MSG_NOSIGNAL | MSG_DONTWAIT);
+      config->recv_calls++;
+      if (recvb > 0) {
+         DEBUG_IFC(VERBOSE(CL_VERBOSE_LIBRARY, "receive_buffer_ra got %zd B", recvb));
+         config->ra_drained = (recvb < (ssize_t) (config->ra_size - config->ra_end));
+         config->ra_end += recvb;
+      } else if (recvb == 0) {
+         client_socket_disconnect(config);
+         return TRAP_E_IO_ERROR;
+      } else if ((errno == EAGAIN) || (errno == EWOULDBLOCK)) {
+         config->ra_drained = 1;
+      } else if (errno != EINTR) {
+         client_socket_disconnect(config);
+         return TRAP_E_IO_ERROR;
+      }
+   }
+   return TRAP_E_TERMINATED;
+}
+#endif
+
+/**
+ * Grow read-ahead buffer to hold the whole buffer of size announced during negotiation.
+ *
+ * \param[in,out] config  private IFC data, read-ahead buffer is empty after connection
+ * \return TRAP_E_OK on success, TRAP_E_MEMORY
+ */
+static int receive_ra_resize(tcpip_receiver_private_t *config)
+{
+#ifdef HAVE_SYS_EPOLL_H
+   uint32_t size = config->ctx->in_ifc_list[config->ifc_idx].buffer_size + sizeof(trap_buffer_header_t);
+   uint8_t *buffer;
+
+   if ((config->ra_buffer == NULL) || (config->ra_size >= size)) {
+      return TRAP_E_OK;
+   }
+   buffer = realloc(config->ra_buffer, size);
+   if (buffer == NULL) {
+      VERBOSE(CL_ERROR, "Not enough memory for read-ahead buffer of %"PRIu32" B.", size);
+      return TRAP_E_MEMORY;
+   }
+   config->ra_buffer = buffer;
+   config->ra_size = size;
+#endif
+   return TRAP_E_OK;
+}
+
+/**
+ * \brief Get socket of input IFC for waiting in trap_ctx_recv_any().
+ * \param[in] priv  pointer to module private data
+ * \param[out] fd   socket descriptor (descriptor of io_uring with io=uring), -1 when not connected
+ * \param[out] gen  generation of the socket
+ * \return 1 if read-ahead buffer contains a complete buffer, 0 otherwise
+ */
+static int tcpip_receiver_get_fd(void *priv, int *fd, uint32_t *gen)
+{
+   tcpip_receiver_private_t *config = (tcpip_receiver_private_t *) priv;
+
+   (*gen) = config->conn_gen;
+   if (config->connected == 0) {
+      (*fd) = -1;
+      return 0;
+   }
+   (*fd) = config->sd;
+#ifdef HAVE_SYS_EPOLL_H
+   if (config->uring != NULL) {
+      /* socket is read by multishot recv(), completions make the ring readable */
+      (*fd) = trap_uring_fd(config->uring);
+      if (receive_uring_arm(config) != TRAP_E_OK) {
+         (*fd) = -1;
+      }
+      if ((config->ur_length != 0) || trap_uring_ready(config->uring)) {
+         return 1;
+      }
+   }
+   if ((config->ra_buffer != NULL) && (config->ra_end - config->ra_start >= sizeof(trap_buffer_header_t))) {
+      uint32_t length;
+
+      memcpy(&length, config->ra_buffer + config->ra_start, sizeof(length));
+      return (config->ra_end - config->ra_start >= sizeof(trap_buffer_header_t) + ntohl(length));
+   }
+#endif
+   return 0;
+}
+
+/**
+ * \brief Get counters of syscalls of input IFC.
+ * \param[in] priv  pointer to module private data
+ * \return JSON object with counters
+ */
+static json_t *tcpip_receiver_get_stats(void *priv)
+{
+   tcpip_receiver_private_t *c = (tcpip_receiver_private_t *) priv;
+
+   if (c == NULL) {
+      return NULL;
+   }
+   return json_pack("{sssIsIsI}", "io", TCPIP_IO_BACKEND_STR(c->io_backend),
+                    "readahead", (json_int_t) c->ra_size,
+                    "recv-calls", (json_int_t) c->recv_calls,
+                    "wait-calls", (json_int_t) c->wait_calls);
+}
+
 /**
  * \brief Receive data from interface.
  *
@@ -390,6 +745,12 @@ conn_wait:
             return TRAP_E_FORMAT_MISMATCH;
          } else if (retval == TRAP_E_OK) {
             config->connected = 1;
+            /* negotiation may have reallocated buffer of input IFC for bigger buffers */
+            data = config->ctx->in_ifc_list[config->ifc_idx].buffer;
+            if (receive_ra_resize(config) != TRAP_E_OK) {
+               client_socket_disconnect(config);
+               return TRAP_E_MEMORY;
+            }
             /* ok, wait for header as we planned */
          } else {
             /* failed, reseting... */
@@ -405,6 +766,18 @@ conn_wait:
 head_wait:
       /* get and check header of message, next state can be MESS_WAIT or RESET */
       DEBUG_IFC(VERBOSE(CL_VERBOSE_LIBRARY, "recv HEAD_WAIT (%p)", p));
+#ifdef HAVE_SYS_EPOLL_H
+      if (config->ra_buffer != NULL) {
+         /* readahead mode receives the whole buffer at once */
+         retval = receive_buffer_ra(config, data, size, temptm);
+         if (retval == TRAP_E_OK) {
+            return TRAP_E_OK;
+         } else if (retval == TRAP_E_IO_ERROR) {
+            goto discard;
+         }
+         goto reset;
+      }
+#endif
       config->data_wait_size = sizeof(trap_buffer_header_t);
       retval = receive_part(config, &p, &config->data_wait_size, temptm);
       if (retval != TRAP_E_OK) {
@@ -418,8 +791,16 @@ head_wait:
       } else {
          /* we expect to receive data */
          messageframe.data_length = ntohl(messageframe.data_length);
+         if (messageframe.data_length > config->ctx->in_ifc_list[config->ifc_idx].buffer_size) {
+            VERBOSE(CL_ERROR, "Received buffer is too big (%"PRIu32" B), disconnecting.", messageframe.data_length);
+            client_socket_disconnect(config);
+            goto discard;
+         }
          config->data_wait_size = messageframe.data_length;
          config->ext_buffer_size = messageframe.data_length;
+#ifdef ENABLE_HEADER_TIMESTAMP
+         config->ctx->in_ifc_list[config->ifc_idx].timestamp = be64toh(messageframe.timestamp);
+#endif
 #ifdef ENABLE_CHECK_HEADER
          /* check if header is ok: */
          if (tcpip_check_header(&messageframe) == 0) {
@@ -486,6 +867,11 @@ p = NULL; \
       if (config->connected == 1) {
          close(config->sd);
       }
+      if (config->epoll_fd >= 0) {
+         close(config->epoll_fd);
+      }
+      trap_uring_destroy(config->uring);
+      X(config->ra_buffer);
       X(config->dest_addr);
       X(config->dest_port);
       X(config);
@@ -520,10 +906,12 @@ static void tcpip_receiver_create_dump(void *priv, uint32_t idx, const char *pat
            "Terminated: %d\nSocket descriptor: %d\nSocket type: %d\n"
            "Data pointer: %p\nData wait size: %"PRIu32"\nMessage header: %"PRIu32"\n"
            "Extern buffer pointer: %p\nExtern buffer data size: %"PRIu32"\n"
+           "Read-ahead: %"PRIu32"/%"PRIu32" B\n"
            "Timeout: %"PRId32"us (%s)\n",
            c->dest_addr, c->dest_port, c->connected, c->is_terminated, c->sd, c->socket_type,
            c->data_pointer, c->data_wait_size, c->int_mess_header.data_length,
            c->ext_buffer, c->ext_buffer_size,
+           c->ra_end - c->ra_start, c->ra_size,
            c->ctx->in_ifc_list[idx].datatimeout,
            TRAP_TIMEOUT_STR(c->ctx->in_ifc_list[idx].datatimeout));
    fclose(f);
@@ -560,7 +948,9 @@ exit:
  * \param[in,out] ctx   Pointer to the private libtrap context data (trap_ctx_init()).
  * \param[in] params    Configuration string containing space separated values of these parameters (in this exact order): *dest_addr* *dest_port*,
  * where dest_addr is destination address of output TCP/IP IFC module and
- * dest_port is the port where sender is listening.
+ * dest_port is the port where sender is listening.  Optional *readahead* or *readahead=size*
+ * enables receiving into a read-ahead buffer of the given size (in bytes).  Optional
+ * *io=select|epoll|uring* selects I/O backend, epoll and uring imply readahead.
  * \param[in,out] ifc   IFC interface used for calling TCP/IP module.
  * \param[in] idx       Index of IFC that is created.
  * \param [in] type     Select the type of socket (see #tcpip_ifc_sockettype for options).
@@ -575,6 +965,7 @@ int create_tcpip_receiver_ifc(trap_ctx_priv_t *ctx, char *params, trap_input_ifc
    char *param_iterator = NULL;
    char *dest_addr = NULL;
    char *dest_port = NULL;
+   char *param = NULL;
    tcpip_receiver_private_t *config = NULL;
 
    if (params == NULL) {
@@ -591,6 +982,9 @@ int create_tcpip_receiver_ifc(trap_ctx_priv_t *ctx, char *params, trap_input_ifc
    config->is_terminated = 0;
    config->socket_type = type;
    config->ifc_idx = idx;
+   config->epoll_fd = -1;
+   config->ra_drained = 1;
+   config->ur_buffer = -1;
 
    /* Parsing params */
    param_iterator = trap_get_param_by_delimiter(params, &dest_addr, TRAP_IFC_PARAM_DELIMITER);
@@ -602,7 +996,27 @@ int create_tcpip_receiver_ifc(trap_ctx_priv_t *ctx, char *params, trap_input_ifc
          goto failsafe_cleanup;
       }
    }
-   param_iterator = trap_get_param_by_delimiter(param_iterator, &dest_port, TRAP_IFC_PARAM_DELIMITER);
+   while (param_iterator != NULL) {
+      param_iterator = trap_get_param_by_delimiter(param_iterator, &param, TRAP_IFC_PARAM_DELIMITER);
+      if (param == NULL) {
+         break;
+      }
+      if ((strncmp(param, "readahead", 9) == 0) && ((param[9] == 0) || (param[9] == '='))) {
+         config->ra_size = TCPIP_READAHEAD_DEFAULT;
+         if ((param[9] == '=') && (sscanf(param + 10, "%"SCNu32, &config->ra_size) != 1)) {
+            VERBOSE(CL_ERROR, "Size of read-ahead buffer given, but it is probably in wrong format.");
+            config->ra_size = TCPIP_READAHEAD_DEFAULT;
+         }
+      } else if (strncmp(param, "io=", 3) == 0) {
+         parse_io_backend(param + 3, &config->io_backend);
+      } else if (dest_port == NULL) {
+         dest_port = param;
+         param = NULL;
+      } else {
+         VERBOSE(CL_ERROR, "Unknown parameter '%s' of %s IFC.", param, (type == TRAP_IFC_TCPIP ? "TCPIP" : "UNIX socket"));
+      }
+      X(param);
+   }
    if ((dest_port == NULL) || (strlen(dest_port) == 0)) {
       /* if 2nd param is missing, use localhost as addr and 1st param as "port" */
       free(dest_port);
@@ -618,6 +1032,37 @@ int create_tcpip_receiver_ifc(trap_ctx_priv_t *ctx, char *params, trap_input_ifc
    config->dest_addr = dest_addr;
    config->dest_port = dest_port;
 
+   if ((config->io_backend != IO_BACKEND_SELECT) && (config->ra_size == 0)) {
+      /* epoll and io_uring receive into read-ahead buffer */
+      config->ra_size = TCPIP_READAHEAD_DEFAULT;
+   }
+   if (config->ra_size != 0) {
+#ifdef HAVE_SYS_EPOLL_H
+      /* the whole buffer must fit */
+      config->ra_size = MAX(config->ra_size, TRAP_IFC_MESSAGEQ_SIZE + sizeof(trap_buffer_header_t));
+      config->ra_buffer = malloc(config->ra_size);
+      config->epoll_fd = epoll_create(1);
+      if ((config->ra_buffer == NULL) || (config->epoll_fd == -1)) {
+         VERBOSE(CL_ERROR, "Initialization of read-ahead buffer failed.");
+         result = TRAP_E_MEMORY;
+         goto failsafe_cleanup;
+      }
+      if (config->io_backend == IO_BACKEND_URING) {
+         config->uring = trap_uring_create(TCPIP_URING_ENTRIES);
+         if ((config->uring == NULL) ||
+             (trap_uring_pbuf_init(config->uring, TCPIP_URING_PBUF_COUNT, TCPIP_URING_PBUF_SIZE) != TRAP_E_OK)) {
+            VERBOSE(CL_ERROR, "I/O backend 'uring' is not available, using 'epoll'.");
+            trap_uring_destroy(config->uring);
+            config->uring = NULL;
+            config->io_backend = IO_BACKEND_EPOLL;
+         }
+      }
+#else
+      VERBOSE(CL_ERROR, "Read-ahead is not supported on this platform, using default mode.");
+      config->ra_size = 0;
+#endif
+   }
+
    if ((config->dest_addr == NULL) || (config->dest_port == NULL)) {
       /* no delimiter found even if we expect two parameters */
       VERBOSE(CL_ERROR, "Malformed params for input IFC, missing destination address and port.");
@@ -654,6 +1099,8 @@ int create_tcpip_receiver_ifc(trap_ctx_priv_t *ctx, char *params, trap_input_ifc
    ifc->destroy = tcpip_receiver_destroy;
    ifc->terminate = tcpip_receiver_terminate;
    ifc->create_dump = tcpip_receiver_create_dump;
+   ifc->get_stats = tcpip_receiver_get_stats;
+   ifc->get_fd = tcpip_receiver_get_fd;
    ifc->priv = config;
 
 #ifndef ENABLE_NEGOTIATION
@@ -669,6 +1116,11 @@ int create_tcpip_receiver_ifc(trap_ctx_priv_t *ctx, char *params, trap_input_ifc
 failsafe_cleanup:
    X(dest_addr);
    X(dest_port);
+   if (config->epoll_fd >= 0) {
+      close(config->epoll_fd);
+   }
+   trap_uring_destroy(config->uring);
+   X(config->ra_buffer);
    X(config);
    return result;
 #undef X
@@ -688,6 +1140,24 @@ static void client_socket_disconnect(void *priv)
       close(config->sd);
       config->connected = 0;
    }
+   if (config->uring != NULL) {
+      /* multishot recv() keeps the socket open, its completions are skipped since conn_gen changes */
+      if (config->ur_armed) {
+         trap_uring_prep_cancel(config->uring, config->conn_gen, TCPIP_URING_CANCEL);
+         trap_uring_submit(config->uring, 0, 0);
+         config->ur_armed = 0;
+      }
+      if (config->ur_buffer >= 0) {
+         trap_uring_pbuf_recycle(config->uring, config->ur_buffer);
+         config->ur_buffer = -1;
+      }
+      config->ur_length = 0;
+   }
+   /* data of the closed connection is useless, closed socket is removed from epoll automatically */
+   config->ra_start = config->ra_end = 0;
+   config->ra_drained = 1;
+   config->ra_watched = 0;
+   config->conn_gen++;
 }
 
 /**
@@ -904,20 +1374,31 @@ static void server_disconnected_client(tcpip_sender_private_t *c, int cl_id)
  * \param [in,out] data pointer to beginning of data
  * \param [in,out] size size of data to send and the rest unsent size of data
  * \param [in] block       1 if blocking, 0 if non-blocking
+ * \param [in,out] zc_sent  counter of zero-copy send() calls of client, NULL to copy data
  * \return TRAP_E_OK, TRAP_E_TIMEOUT, TRAP_E_TERMINATED, TRAP_E_IO_ERROR
  */
-static int send_all_data(tcpip_sender_private_t *c, int sd, void **data, uint32_t *size, char block)
+static int send_all_data(tcpip_sender_private_t *c, int sd, void **data, uint32_t *size, char block, uint32_t *zc_sent)
 {
    void *p = (*data);
    ssize_t numbytes = (*size), sent_b;
    int res = TRAP_E_TERMINATED;
+   int flags = MSG_NOSIGNAL | ((block == 0) ? MSG_DONTWAIT : 0);
 
 again:
-   if (block == 0) {
-      sent_b = send(sd, p, numbytes, MSG_NOSIGNAL | MSG_DONTWAIT);
-   } else {
-      sent_b = send(sd, p, numbytes, MSG_NOSIGNAL);
-   }
+#ifdef TCPIP_ZEROCOPY
+   if (zc_sent != NULL) {
+      sent_b = send(sd, p, numbytes, flags | MSG_ZEROCOPY);
+      if (sent_b > 0) {
+         /* kernel numbers every zero-copy send() that queued some data */
+         (*zc_sent)++;
+         c->zc_sends++;
+      } else if ((sent_b == -1) && (errno == ENOBUFS)) {
+         /* limit of pinned memory was reached, copy this part */
+         sent_b = send(sd, p, numbytes, flags);
+      }
+   } else
+#endif
+   sent_b = send(sd, p, numbytes, flags);
    if (sent_b == -1) {
       switch (errno) {
       case EBADF:
@@ -962,6 +1443,85 @@ failure:
    return res;
 }
 
+#ifdef TCPIP_ZEROCOPY
+/**
+ * Enable zero-copy send() on socket of a new client.
+ * \param[in] c   private data
+ * \param[in,out] cl  client
+ */
+static void zerocopy_enable(tcpip_sender_private_t *c, struct client_s *cl)
+{
+   int one = 1;
+
+   cl->zc_sent = cl->zc_done = 0;
+   cl->zerocopy = 0;
+   if (c->zerocopy == 0) {
+      return;
+   }
+   if (setsockopt(cl->sd, SOL_SOCKET, SO_ZEROCOPY, &one, sizeof(one)) == 0) {
+      cl->zerocopy = 1;
+   } else {
+      VERBOSE(CL_VERBOSE_LIBRARY, "Zero-copy send() is not supported by socket (%d).", errno);
+   }
+}
+
+/**
+ * \brief Receive completions of zero-copy send() from error queue of client socket.
+ *
+ * Completion means that kernel does not use the sent buffer anymore.  When
+ * kernel reports that it had to copy data anyway (e.g. loopback), zero-copy
+ * is not used for the client since it adds only overhead.
+ *
+ * \param[in,out] c   private data
+ * \param[in,out] cl  client
+ * \return number of received completions
+ */
+static uint32_t zerocopy_reap(tcpip_sender_private_t *c, struct client_s *cl)
+{
+   char control[128];
+   struct msghdr msg;
+   struct cmsghdr *cm;
+   struct sock_extended_err *serr;
+   uint32_t done, count = 0;
+
+   while (cl->zc_done != cl->zc_sent) {
+      memset(&msg, 0, sizeof(msg));
+      msg.msg_control = control;
+      msg.msg_controllen = sizeof(control);
+      if (recvmsg(cl->sd, &msg, MSG_ERRQUEUE | MSG_DONTWAIT) == -1) {
+         break;
+      }
+      for (cm = CMSG_FIRSTHDR(&msg); cm != NULL; cm = CMSG_NXTHDR(&msg, cm)) {
+         serr = (struct sock_extended_err *) CMSG_DATA(cm);
+         if ((serr->ee_origin != SO_EE_ORIGIN_ZEROCOPY) || (serr->ee_errno != 0)) {
+            continue;
+         }
+         /* range of numbers of completed send() calls */
+         done = serr->ee_data - serr->ee_info + 1;
+         cl->zc_done += done;
+         count += done;
+         if ((serr->ee_code & SO_EE_CODE_ZEROCOPY_COPIED) && cl->zerocopy) {
+            VERBOSE(CL_VERBOSE_LIBRARY, "Kernel copied data of zero-copy send(), client gets copied data.");
+            c->zc_copied += done;
+            cl->zerocopy = 0;
+         }
+      }
+   }
+   return count;
+}
+#else
+static inline void zerocopy_enable(tcpip_sender_private_t *c, struct client_s *cl)
+{
+   cl->zc_sent = cl->zc_done = 0;
+   cl->zerocopy = 0;
+}
+
+static inline uint32_t zerocopy_reap(tcpip_sender_private_t *c, struct client_s *cl)
+{
+   return 0;
+}
+#endif
+
 /**
  * Check if any client is connected.
  * \return non-zero if there is a connected client
@@ -1021,59 +1581,1430 @@ static inline int tcpip_sender_conn_phase(tcpip_sender_private_t *config, struct
 }
 
 /**
- * \brief Send data to all connected clients.
+ * \defgroup tcpip_sender_queue Queue mode of TCPIP output IFC
  *
- * All clients are in 'current' buffer or in 'backup' buffer.
- * All clients get messages from current buffer at first.
- * * When all buffer is successfully sent to all clients
- * in 'current' buffer, everything is alright.
- *
- * * When everybody fails due to timeout, everything
- * is alright, everybody stays in 'current' buffer.
- *
- * * When somebody fails and somebody is successful, failing clients are moved into 'backup' buffer and they have chance to receive the rest of message later. We disconnect all clients that were in 'backup' buffer before moving new ones from 'current' buffer.
- *
- * * All successful clients from 'backup' buffer are moved back into 'current' buffer.
- *
- * \param[in] priv  pointer to module private data
- * \param[in] data  pointer to data to send
- * \param[in] size  size of data to send
- * \param[in] timeout  timeout in microseconds
- * \return 0 on success (TRAP_E_OK), TRAP_E_BAD_FPARAMS if sender was not properly initialized, TRAP_E_TERMINATED if interface was terminated.
+ * Every client has its own bounded queue of shared buffers.  send() just
+ * enqueues a copy of buffer for all clients and returns, send_thread sends
+ * the queues independently using non-blocking sockets driven by epoll.
+ * A client whose queue is full is handled according to lag_policy.
+ * @{
  */
-int tcpip_sender_send(void *priv, const void *data, uint32_t size, int timeout)
-{
-   uint8_t buffer[DEFAULT_MAX_DATA_LENGTH];
-   int result = TRAP_E_TIMEOUT;
-   tcpip_sender_private_t *c = (tcpip_sender_private_t *) priv;
-   /* timeout for blocking mode */
-   struct timeval tm;
-   /* timout for nonblocking mode */
-   struct timespec tmnblk;
-   /* pointer to timeout for select() */
-   struct timeval *temptm;
-   /* pointer to timeout for select() */
-   struct timespec *temptmblk;
-   fd_set set, disset;
-   int maxsd = -1;
-   struct client_s *cl;
-   uint32_t i, j, failed, passed;
-   struct timeval sectm;
-   int retval;
-   ssize_t readbytes;
-   char block;
-
-   /* correct module will pass only possitive timeout or TRAP_WAIT, TRAP_HALFWAIT */
-   assert(timeout >= TRAP_HALFWAIT);
 
-   /* I. Init phase: set timeout and double-send switch */
-   trap_set_timeouts(timeout, &tm, NULL);
-   temptm = (((timeout==TRAP_WAIT) || (timeout==TRAP_HALFWAIT))?NULL:&tm);
+/** epoll data of the wake-up pipe of send_thread */
+#define QUEUE_EV_WAKE         UINT64_MAX
+/** epoll data of client socket - index of client and its socket descriptor */
+#define QUEUE_EV_CLIENT(idx, sd) ((((uint64_t) (uint32_t) (sd)) << 32) | (uint32_t) (idx))
+/** Max number of events processed by one epoll_wait() */
+#define QUEUE_EPOLL_EVENTS    32
 
-   switch (timeout) {
-   case TRAP_WAIT:
-      trap_set_abs_timespec(1000000, &tm, &tmnblk);
-      break;
+/**
+ * Return buffer into the list of free buffers or free it.
+ * \param[in,out] c  private data, lock must be held
+ * \param[in] b      unused buffer
+ */
+static void queue_put_buffer(tcpip_sender_private_t *c, struct tcpip_qbuf *b)
+{
+   if (c->free_qbufs_count < c->queue_size) {
+      b->next = c->free_qbufs;
+      c->free_qbufs = b;
+      c->free_qbufs_count++;
+   } else {
+      free(b);
+   }
+}
+
+/**
+ * Remove all buffers from queue of client.
+ * \param[in,out] c  private data, lock must be held
+ * \param[in,out] cl client
+ */
+static void queue_release_client(tcpip_sender_private_t *c, struct client_s *cl)
+{
+   struct tcpip_qbuf *b;
+
+   while (cl->queue_count > 0) {
+      b = cl->queue[cl->queue_head];
+      cl->queue[cl->queue_head] = NULL;
+      cl->queue_head = (cl->queue_head + 1) % c->queue_size;
+      cl->queue_count--;
+      if (--b->refcount == 0) {
+         queue_put_buffer(c, b);
+      }
+   }
+   cl->queue_head = 0;
+   cl->queue_offset = 0;
+   cl->queue_bytes = 0;
+   cl->wait_out = 0;
+}
+
+/**
+ * Disconnect client and drop its queue.
+ * \param[in,out] c  private data, lock must be held
+ * \param[in,out] cl client
+ */
+static void queue_disconnect_client(tcpip_sender_private_t *c, struct client_s *cl)
+{
+   queue_release_client(c, cl);
+   /* closed descriptor is removed from epoll automatically */
+   close(cl->sd);
+   cl->sd = -1;
+   cl->client_state = CURRENT_IDLE;
+   c->connected_clients--;
+   if (c->dist_mode != DIST_MODE_BROADCAST) {
+      pthread_cond_broadcast(&c->queue_cond);
+   }
+}
+
+#ifdef HAVE_SYS_EPOLL_H
+/**
+ * Send queued buffers to client until the queue is empty or the socket is full.
+ * \param[in,out] c  private data, lock must be held
+ * \param[in,out] cl client
+ * \return TRAP_E_OK when queue is empty, TRAP_E_TIMEOUT when socket would block,
+ * TRAP_E_IO_ERROR when client is disconnected
+ */
+static int queue_send_client(tcpip_sender_private_t *c, struct client_s *cl)
+{
+   struct tcpip_qbuf *b;
+   ssize_t sent_b;
+
+   while (cl->queue_count > 0) {
+      b = cl->queue[cl->queue_head];
+      sent_b = send(cl->sd, b->data + cl->queue_offset, b->size - cl->queue_offset, MSG_NOSIGNAL | MSG_DONTWAIT);
+      if (sent_b == -1) {
+         if ((errno == EAGAIN) || (errno == EWOULDBLOCK)) {
+            return TRAP_E_TIMEOUT;
+         } else if (errno == EINTR) {
+            continue;
+         }
+         return TRAP_E_IO_ERROR;
+      }
+      cl->queue_offset += sent_b;
+      if (cl->queue_offset == b->size) {
+         /* whole buffer was sent */
+         cl->queue[cl->queue_head] = NULL;
+         cl->queue_head = (cl->queue_head + 1) % c->queue_size;
+         cl->queue_count--;
+         cl->queue_offset = 0;
+         cl->queue_bytes -= b->size;
+         cl->sent_buffers++;
+         if (--b->refcount == 0) {
+            queue_put_buffer(c, b);
+         }
+      }
+   }
+   return TRAP_E_OK;
+}
+
+/**
+ * Change set of events watched for client socket.
+ * \param[in] c   private data
+ * \param[in] idx index of client
+ * \param[in] out non-zero to wait for EPOLLOUT
+ */
+static void queue_watch_client(tcpip_sender_private_t *c, uint32_t idx, int out)
+{
+   struct epoll_event ev;
+
+   memset(&ev, 0, sizeof(ev));
+   ev.events = EPOLLIN | EPOLLRDHUP | (out ? EPOLLOUT : 0);
+   ev.data.u64 = QUEUE_EV_CLIENT(idx, c->clients[idx].sd);
+   if (epoll_ctl(c->epoll_fd, EPOLL_CTL_MOD, c->clients[idx].sd, &ev) == -1) {
+      VERBOSE(CL_ERROR, "Changing of epoll events failed (%d): %s", errno, strerror(errno));
+   }
+}
+
+/**
+ * Register new client into epoll of send_thread.
+ * \param[in,out] c  private data, lock must be held
+ * \param[in] idx    index of client
+ */
+static void queue_add_client(tcpip_sender_private_t *c, uint32_t idx)
+{
+   struct epoll_event ev;
+   struct client_s *cl = &c->clients[idx];
+
+   cl->queue_head = 0;
+   cl->queue_count = 0;
+   cl->queue_offset = 0;
+   cl->queue_bytes = 0;
+   cl->max_lag = 0;
+   cl->wait_out = 0;
+   cl->sent_buffers = 0;
+   cl->dropped_buffers = 0;
+
+   memset(&ev, 0, sizeof(ev));
+   ev.events = EPOLLIN | EPOLLRDHUP;
+   ev.data.u64 = QUEUE_EV_CLIENT(idx, cl->sd);
+   if (epoll_ctl(c->epoll_fd, EPOLL_CTL_ADD, cl->sd, &ev) == -1) {
+      VERBOSE(CL_ERROR, "Adding of client into epoll failed (%d): %s", errno, strerror(errno));
+   }
+}
+
+/**
+ * \brief Thread sending queues of clients.
+ *
+ * After termination of IFC, the thread tries to send the rest of queues
+ * once more without blocking and exits.
+ * \param[in] arg  tcpip_sender_private_t structure (private data)
+ * \return NULL
+ */
+static void *queue_send_thread(void *arg)
+{
+   tcpip_sender_private_t *c = (tcpip_sender_private_t *) arg;
+   struct epoll_event events[QUEUE_EPOLL_EVENTS];
+   struct client_s *cl;
+   char drain[64];
+   ssize_t readbytes;
+   int i, n, res;
+   uint32_t idx;
+
+   while (1) {
+      n = epoll_wait(c->epoll_fd, events, QUEUE_EPOLL_EVENTS, -1);
+      if (n == -1) {
+         if (errno == EINTR) {
+            continue;
+         }
+         VERBOSE(CL_ERROR, "epoll_wait failed (%d): %s", errno, strerror(errno));
+         break;
+      }
+
+      pthread_mutex_lock(&c->lock);
+      for (i = 0; i < n; i++) {
+         if (events[i].data.u64 == QUEUE_EV_WAKE) {
+            while (read(c->wake_pipe[0], drain, sizeof(drain)) > 0);
+            continue;
+         }
+         idx = (uint32_t) events[i].data.u64;
+         if (idx >= c->clients_arr_size) {
+            continue;
+         }
+         cl = &c->clients[idx];
+         if (cl->sd != (int) (events[i].data.u64 >> 32)) {
+            /* event of client that was disconnected meanwhile */
+            continue;
+         }
+         if (events[i].events & (EPOLLIN | EPOLLRDHUP | EPOLLHUP | EPOLLERR)) {
+            /* receivers do not send anything, readable socket means disconnection */
+            readbytes = recv(cl->sd, drain, sizeof(drain), MSG_NOSIGNAL | MSG_DONTWAIT);
+            if ((readbytes == 0) || ((readbytes == -1) && (errno != EAGAIN) && (errno != EWOULDBLOCK) && (errno != EINTR))) {
+               VERBOSE(CL_VERBOSE_LIBRARY, "Disconnected client.");
+               queue_disconnect_client(c, cl);
+               continue;
+            }
+         }
+         if ((events[i].events & EPOLLOUT) && (cl->wait_out != 0)) {
+            cl->wait_out = 0;
+            queue_watch_client(c, idx, 0);
+         }
+      }
+
+      for (idx = 0; idx < c->clients_arr_size; idx++) {
+         cl = &c->clients[idx];
+         if ((cl->sd < 0) || (cl->queue_count == 0) || (cl->wait_out != 0)) {
+            continue;
+         }
+         res = queue_send_client(c, cl);
+         if (res == TRAP_E_IO_ERROR) {
+            VERBOSE(CL_VERBOSE_LIBRARY, "Disconnected client.");
+            queue_disconnect_client(c, cl);
+         } else if (res == TRAP_E_TIMEOUT) {
+            cl->wait_out = 1;
+            queue_watch_client(c, idx, 1);
+         }
+      }
+      if (c->dist_mode != DIST_MODE_BROADCAST) {
+         /* queues got space, wake up send() waiting for it */
+         pthread_cond_broadcast(&c->queue_cond);
+      }
+      if (c->is_terminated != 0) {
+         pthread_mutex_unlock(&c->lock);
+         break;
+      }
+      pthread_mutex_unlock(&c->lock);
+   }
+   pthread_exit(NULL);
+}
+
+/**
+ * Initialize queues, epoll and start send_thread.
+ * \param[in,out] c  private data
+ * \return TRAP_E_OK on success
+ */
+static int queue_init(tcpip_sender_private_t *c)
+{
+   struct epoll_event ev;
+   int32_t i;
+
+   for (i = 0; i < c->clients_arr_size; i++) {
+      c->clients[i].queue = calloc(c->queue_size, sizeof(struct tcpip_qbuf *));
+      if (c->clients[i].queue == NULL) {
+         return TRAP_E_MEMORY;
+      }
+   }
+   if (pipe(c->wake_pipe) != 0) {
+      c->wake_pipe[0] = c->wake_pipe[1] = -1;
+      return TRAP_E_IO_ERROR;
+   }
+   fcntl(c->wake_pipe[0], F_SETFL, O_NONBLOCK | fcntl(c->wake_pipe[0], F_GETFL));
+   fcntl(c->wake_pipe[1], F_SETFL, O_NONBLOCK | fcntl(c->wake_pipe[1], F_GETFL));
+
+   c->epoll_fd = epoll_create1(0);
+   if (c->epoll_fd == -1) {
+      return TRAP_E_IO_ERROR;
+   }
+   memset(&ev, 0, sizeof(ev));
+   ev.events = EPOLLIN;
+   ev.data.u64 = QUEUE_EV_WAKE;
+   if (epoll_ctl(c->epoll_fd, EPOLL_CTL_ADD, c->wake_pipe[0], &ev) == -1) {
+      return TRAP_E_IO_ERROR;
+   }
+   if (pthread_create(&c->send_thread, NULL, queue_send_thread, c) != 0) {
+      return TRAP_E_IO_ERROR;
+   }
+   c->send_thread_running = 1;
+   return TRAP_E_OK;
+}
+#endif
+
+/**
+ * Wake up send_thread.
+ * \param[in] c  private data
+ */
+static inline void queue_wake(tcpip_sender_private_t *c)
+{
+   if ((c->wake_pipe[1] != -1) && (write(c->wake_pipe[1], "", 1) == -1) && (errno != EAGAIN)) {
+      VERBOSE(CL_ERROR, "Waking up of send thread failed (%d): %s", errno, strerror(errno));
+   }
+}
+
+/**
+ * Stop send_thread and release all queues.
+ * \param[in,out] c  private data
+ */
+static void queue_destroy(tcpip_sender_private_t *c)
+{
+   struct tcpip_qbuf *b;
+   int32_t i;
+
+   if (c->send_thread_running) {
+      c->is_terminated = 1;
+      queue_wake(c);
+      pthread_join(c->send_thread, NULL);
+      c->send_thread_running = 0;
+   }
+   pthread_mutex_lock(&c->lock);
+   if (c->clients != NULL) {
+      for (i = 0; i < c->clients_arr_size; i++) {
+         if (c->clients[i].queue != NULL) {
+            queue_release_client(c, &c->clients[i]);
+            free(c->clients[i].queue);
+            c->clients[i].queue = NULL;
+         }
+      }
+   }
+   while (c->free_qbufs != NULL) {
+      b = c->free_qbufs;
+      c->free_qbufs = b->next;
+      free(b);
+   }
+   c->free_qbufs_count = 0;
+   pthread_mutex_unlock(&c->lock);
+
+   if (c->epoll_fd != -1) {
+      close(c->epoll_fd);
+      c->epoll_fd = -1;
+   }
+   for (i = 0; i < 2; i++) {
+      if (c->wake_pipe[i] != -1) {
+         close(c->wake_pipe[i]);
+         c->wake_pipe[i] = -1;
+      }
+   }
+}
+
+/**
+ * \brief Wait for a connected client.
+ *
+ * \param[in] c        private data
+ * \param[in] timeout  timeout in microseconds
+ * \return TRAP_E_OK when a client is connected, TRAP_E_TIMEOUT when there is
+ * no client, TRAP_E_TERMINATED if interface was terminated.
+ */
+static int queue_wait_client(tcpip_sender_private_t *c, int timeout)
+{
+   struct timeval tm;
+   struct timespec tmnblk;
+   int result;
+
+   do {
+      if (c->is_terminated) {
+         return TRAP_E_TERMINATED;
+      }
+      if (timeout == TRAP_WAIT) {
+         tm.tv_sec = 1;
+         tm.tv_usec = 0;
+         trap_set_abs_timespec(timeout, &tm, &tmnblk);
+      } else {
+         trap_set_timeouts(timeout, &tm, &tmnblk);
+      }
+      result = tcpip_sender_conn_phase(c, &tmnblk);
+   } while ((result == TRAP_E_TIMEOUT) && (timeout == TRAP_WAIT));
+   return result;
+}
+
+/**
+ * Take a buffer from the list of free buffers or allocate a new one.
+ * \param[in,out] c  private data, lock must not be held
+ * \return empty buffer or NULL when there is not enough memory
+ */
+static struct tcpip_qbuf *queue_get_buffer(tcpip_sender_private_t *c)
+{
+   struct tcpip_qbuf *b;
+
+   pthread_mutex_lock(&c->lock);
+   b = c->free_qbufs;
+   if (b != NULL) {
+      c->free_qbufs = b->next;
+      c->free_qbufs_count--;
+   }
+   pthread_mutex_unlock(&c->lock);
+   if (b == NULL) {
+      b = malloc(sizeof(*b) + c->int_mess_header.data_length + sizeof(trap_buffer_header_t));
+      if (b == NULL) {
+         return NULL;
+      }
+   }
+   b->size = 0;
+   b->refcount = 0;
+   b->next = NULL;
+   return b;
+}
+
+/**
+ * Append buffer to queue of client, the queue must not be full.
+ * \param[in,out] c  private data, lock must be held
+ * \param[in,out] cl client
+ * \param[in] b      buffer
+ * \return non-zero if the queue was empty, i.e. send_thread must be woken up
+ */
+static int queue_push(tcpip_sender_private_t *c, struct client_s *cl, struct tcpip_qbuf *b)
+{
+   cl->queue[(cl->queue_head + cl->queue_count) % c->queue_size] = b;
+   cl->queue_count++;
+   cl->queue_bytes += b->size;
+   if (cl->queue_count > cl->max_lag) {
+      cl->max_lag = cl->queue_count;
+   }
+   b->refcount++;
+   return (cl->queue_count == 1);
+}
+
+/**
+ * Handle client whose queue is full according to lag_policy.
+ * \param[in,out] c  private data, lock must be held
+ * \param[in,out] cl client
+ */
+static void queue_lagging_client(tcpip_sender_private_t *c, struct client_s *cl)
+{
+   if (c->lag_policy == LAG_POLICY_DISCONNECT) {
+      VERBOSE(CL_VERBOSE_LIBRARY, "Disconnected lagging client.");
+      queue_disconnect_client(c, cl);
+      c->lag_disconnects++;
+   } else {
+      cl->dropped_buffers++;
+   }
+}
+
+/**
+ * \brief Enqueue copy of buffer for all connected clients (queue mode).
+ *
+ * \param[in] c        private data
+ * \param[in] data     pointer to data to send
+ * \param[in] size     size of data to send
+ * \param[in] timeout  timeout in microseconds used when there is no client
+ * \return TRAP_E_OK when buffer was handed over to send_thread, TRAP_E_TIMEOUT
+ * when there is no client, TRAP_E_TERMINATED if interface was terminated.
+ */
+static int tcpip_sender_queue_send(tcpip_sender_private_t *c, const void *data, uint32_t size, int timeout)
+{
+   struct tcpip_qbuf *b;
+   struct client_s *cl;
+   char wake = 0;
+   int32_t i;
+   int result;
+
+   assert(size <= c->int_mess_header.data_length + sizeof(trap_buffer_header_t));
+
+   result = queue_wait_client(c, timeout);
+   if (result != TRAP_E_OK) {
+      return result;
+   }
+
+   b = queue_get_buffer(c);
+   if (b == NULL) {
+      return TRAP_E_MEMORY;
+   }
+   /* copy is made outside of lock not to block send_thread */
+   memcpy(b->data, data, size);
+   b->size = size;
+
+   pthread_mutex_lock(&c->lock);
+   for (i = 0; i < c->clients_arr_size; i++) {
+      cl = &c->clients[i];
+      if (cl->sd < 0) {
+         continue;
+      }
+      if (cl->queue_count == c->queue_size) {
+         queue_lagging_client(c, cl);
+         continue;
+      }
+      wake |= queue_push(c, cl, b);
+   }
+   if (b->refcount == 0) {
+      queue_put_buffer(c, b);
+   }
+   pthread_mutex_unlock(&c->lock);
+
+   if (wake) {
+      queue_wake(c);
+   }
+   return TRAP_E_OK;
+}
+
+/**
+ * @}
+ */
+
+/**
+ * \defgroup tcpip_sender_dist Distribution mode of TCPIP output IFC
+ *
+ * Buffers are not broadcast, every buffer (or message in hash mode) is
+ * given to exactly one client.  Distribution is built on the queue mode:
+ * the chosen client gets the buffer into its queue and send_thread sends
+ * it.  When the queue of the chosen client is full, send() waits for
+ * send_thread on queue_cond.
+ *
+ * Hash mode splits buffer into parts by FNV-1a hash of key fields, so all
+ * messages with the same key go to the same client as long as the set of
+ * connected clients does not change.  The key must consist of static
+ * UniRec fields, otherwise buffers are distributed round-robin.
+ * @{
+ */
+
+#define DIST_FNV_OFFSET 2166136261U ///< FNV-1a offset basis (32 bits)
+#define DIST_FNV_PRIME  16777619U   ///< FNV-1a prime (32 bits)
+
+/**
+ * Compute absolute deadline of waiting for queue space.
+ * \param[in] timeout  libtrap timeout of send()
+ * \param[out] ts      deadline (CLOCK_REALTIME)
+ * \return ts or NULL when send() should wait without limit
+ */
+static struct timespec *dist_deadline(int timeout, struct timespec *ts)
+{
+   if ((timeout == TRAP_WAIT) || (timeout == TRAP_HALFWAIT)) {
+      return NULL;
+   }
+   clock_gettime(CLOCK_REALTIME, ts);
+   if (timeout > 0) {
+      ts->tv_sec += timeout / 1000000;
+      ts->tv_nsec += (long) (timeout % 1000000) * 1000;
+      if (ts->tv_nsec >= 1000000000) {
+         ts->tv_sec++;
+         ts->tv_nsec -= 1000000000;
+      }
+   }
+   return ts;
+}
+
+/**
+ * Wait until send_thread sends some buffer or the set of clients changes.
+ * \param[in] c         private data, lock must be held
+ * \param[in] deadline  absolute time, NULL to wait without limit
+ * \return 0 when woken up, ETIMEDOUT after deadline
+ */
+static int dist_wait(tcpip_sender_private_t *c, const struct timespec *deadline)
+{
+   if (deadline == NULL) {
+      return pthread_cond_wait(&c->queue_cond, &c->lock);
+   }
+   return pthread_cond_timedwait(&c->queue_cond, &c->lock, deadline);
+}
+
+/**
+ * Get amount of data of client that was not sent yet.
+ *
+ * It counts the queue and the send buffer of socket (if the system can tell).
+ * \param[in] c   private data, lock must be held
+ * \param[in] cl  client
+ * \return number of bytes
+ */
+static uint64_t dist_client_load(tcpip_sender_private_t *c, struct client_s *cl)
+{
+   uint64_t load = cl->queue_bytes - cl->queue_offset;
+#ifdef TIOCOUTQ
+   int outq = 0;
+
+   if (ioctl(cl->sd, TIOCOUTQ, &outq) == 0) {
+      load += outq;
+   }
+#endif
+   return load;
+}
+
+/**
+ * Choose client for the next buffer (round-robin or least-loaded).
+ * \param[in,out] c  private data, lock must be held
+ * \param[in] mode   DIST_MODE_RR or DIST_MODE_LEAST
+ * \return connected client with space in queue, NULL if there is none
+ */
+static struct client_s *dist_select_client(tcpip_sender_private_t *c, enum tcpip_dist_mode mode)
+{
+   struct client_s *cl, *best = NULL;
+   uint64_t load, best_load = UINT64_MAX;
+   uint32_t i, j;
+
+   for (j = 0; j < c->clients_arr_size; j++) {
+      i = (c->dist_next + j) % c->clients_arr_size;
+      cl = &c->clients[i];
+      if ((cl->sd < 0) || (cl->queue_count == c->queue_size)) {
+         continue;
+      }
+      if (mode == DIST_MODE_RR) {
+         c->dist_next = i + 1;
+         return cl;
+      }
+      load = dist_client_load(c, cl);
+      if (load < best_load) {
+         best = cl;
+         best_load = load;
+         if (load == 0) {
+            /* idle client, nobody can be better */
+            break;
+         }
+      }
+   }
+   if (best != NULL) {
+      /* ties are resolved in turn */
+      c->dist_next = (best - c->clients) + 1;
+   }
+   return best;
+}
+
+/**
+ * \brief Give copy of buffer to one client (round-robin or least-loaded).
+ *
+ * \param[in] c        private data
+ * \param[in] data     pointer to data to send
+ * \param[in] size     size of data to send
+ * \param[in] timeout  timeout in microseconds
+ * \param[in] mode     DIST_MODE_RR or DIST_MODE_LEAST
+ * \return TRAP_E_OK when buffer was handed over to send_thread, TRAP_E_TIMEOUT
+ * when all queues stay full or there is no client, TRAP_E_TERMINATED if
+ * interface was terminated.
+ */
+static int dist_send_buffer(tcpip_sender_private_t *c, const void *data, uint32_t size, int timeout, enum tcpip_dist_mode mode)
+{
+   struct timespec ts, *deadline;
+   struct tcpip_qbuf *b;
+   struct client_s *cl;
+   int result = TRAP_E_OK, wake = 0;
+
+   b = queue_get_buffer(c);
+   if (b == NULL) {
+      return TRAP_E_MEMORY;
+   }
+   memcpy(b->data, data, size);
+   b->size = size;
+
+   deadline = dist_deadline(timeout, &ts);
+   pthread_mutex_lock(&c->lock);
+   while (1) {
+      if (c->is_terminated) {
+         result = TRAP_E_TERMINATED;
+         break;
+      }
+      cl = dist_select_client(c, mode);
+      if (cl != NULL) {
+         wake = queue_push(c, cl, b);
+         break;
+      }
+      if (dist_wait(c, deadline) == ETIMEDOUT) {
+         result = TRAP_E_TIMEOUT;
+         break;
+      }
+   }
+   if (b->refcount == 0) {
+      queue_put_buffer(c, b);
+   }
+   pthread_mutex_unlock(&c->lock);
+
+   if (wake) {
+      queue_wake(c);
+   }
+   return result;
+}
+
+/**
+ * Find key fields of hash distribution in data format specifier of IFC.
+ *
+ * Offsets are cached until the data format specifier changes.
+ * \param[in,out] c  private data
+ * \return non-zero if the key can be used
+ */
+static int dist_prepare_key(tcpip_sender_private_t *c)
+{
+   trap_output_ifc_t *ifc = &c->ctx->out_ifc_list[c->ifc_idx];
+   char *key, *name, *next;
+   uint32_t fsize, end;
+
+   if ((ifc->data_type != TRAP_FMT_UNIREC) || (ifc->data_fmt_spec == NULL) || (ifc->compress != NULL)) {
+      /* messages cannot be inspected */
+      if (c->dist_fallback_buffers == 0) {
+         VERBOSE(CL_ERROR, "Hash distribution of output IFC %"PRIu32" needs uncompressed UniRec data, "
+                 "buffers are distributed round-robin.", c->ifc_idx);
+      }
+      if (c->dist_spec != NULL) {
+         free(c->dist_spec);
+         c->dist_spec = NULL;
+         c->dist_key_count = 0;
+      }
+      return 0;
+   }
+   if ((c->dist_spec != NULL) && (strcmp(c->dist_spec, ifc->data_fmt_spec) == 0)) {
+      return (c->dist_key_count != 0);
+   }
+
+   free(c->dist_spec);
+   c->dist_spec = strdup(ifc->data_fmt_spec);
+   c->dist_key_count = 0;
+   c->dist_key_end = 0;
+   key = strdup(c->dist_key);
+   if ((c->dist_spec == NULL) || (key == NULL)) {
+      free(key);
+      return 0;
+   }
+   for (name = key; name != NULL; name = next) {
+      next = strchr(name, '+');
+      if (next != NULL) {
+         *next++ = '\0';
+      }
+      if (c->dist_key_count == TCPIP_DIST_MAX_KEYS) {
+         VERBOSE(CL_ERROR, "Too many key fields of hash distribution, the rest is ignored.");
+         break;
+      }
+      c->dist_key_offset[c->dist_key_count] = trap_ur_field_offset(c->dist_spec, name, NULL, &fsize);
+      if (c->dist_key_offset[c->dist_key_count] < 0) {
+         VERBOSE(CL_ERROR, "Key field '%s' is not a static field of the format of output IFC %"PRIu32", "
+                 "buffers are distributed round-robin.", name, c->ifc_idx);
+         c->dist_key_count = 0;
+         break;
+      }
+      c->dist_key_size[c->dist_key_count] = fsize;
+      end = c->dist_key_offset[c->dist_key_count] + fsize;
+      if (end > c->dist_key_end) {
+         c->dist_key_end = end;
+      }
+      c->dist_key_count++;
+   }
+   free(key);
+   return (c->dist_key_count != 0);
+}
+
+/**
+ * Compute hash of key fields of message.
+ * \param[in] c     private data
+ * \param[in] msg   message (UniRec record)
+ * \param[in] size  size of message
+ * \return hash value
+ */
+static uint32_t dist_hash_message(tcpip_sender_private_t *c, const uint8_t *msg, uint16_t size)
+{
+   uint32_t h = DIST_FNV_OFFSET, i, k;
+   const uint8_t *field;
+
+   if (size < c->dist_key_end) {
+      /* truncated record, all of them go to one client */
+      return h;
+   }
+   for (k = 0; k < c->dist_key_count; k++) {
+      field = msg + c->dist_key_offset[k];
+      for (i = 0; i < c->dist_key_size[k]; i++) {
+         h = (h ^ field[i]) * DIST_FNV_PRIME;
+      }
+   }
+   return h;
+}
+
+/**
+ * \brief Split buffer by hash of key fields and give parts to clients.
+ *
+ * When the queue of some client stays full until timeout, its part is
+ * handled according to lag_policy, because other parts were already
+ * enqueued and the buffer cannot be sent again.  Trace record of a traced
+ * buffer is copied into every part.
+ *
+ * \param[in] c        private data
+ * \param[in] data     pointer to data to send
+ * \param[in] timeout  timeout in microseconds
+ * \return TRAP_E_OK when all parts were handled, TRAP_E_TIMEOUT when there
+ * is no client, TRAP_E_TERMINATED if interface was terminated.
+ */
+static int dist_send_hash(tcpip_sender_private_t *c, const void *data, int timeout)
+{
+   const trap_buffer_header_t *hdr = (const trap_buffer_header_t *) data;
+   uint32_t data_length = ntohl(hdr->data_length);
+   uint32_t trace = (c->ctx->out_ifc_list[c->ifc_idx].trace ? TRAP_TRACE_SIZE : 0);
+   trap_buffer_header_t *part_hdr;
+   struct timespec ts, *deadline;
+   struct tcpip_qbuf *part;
+   struct client_s *cl;
+   uint32_t i = 0, k, n = 0;
+   uint16_t msize;
+   int result = TRAP_E_OK, wake = 0;
+
+   pthread_mutex_lock(&c->lock);
+   for (k = 0; k < c->clients_arr_size; k++) {
+      if (c->clients[k].sd >= 0) {
+         c->dist_clients[n++] = k;
+      }
+   }
+   pthread_mutex_unlock(&c->lock);
+   if (n == 0) {
+      return TRAP_E_TIMEOUT;
+   }
+
+   /* split messages, the copy is made outside of lock not to block send_thread */
+   data_length = (data_length >= trace) ? data_length - trace : 0;
+   while (i + sizeof(uint16_t) <= data_length) {
+      msize = *((const uint16_t *) &hdr->data[i]);
+      k = dist_hash_message(c, &hdr->data[i + sizeof(uint16_t)], msize) % n;
+      part = c->dist_parts[k];
+      if (part == NULL) {
+         part = c->dist_parts[k] = queue_get_buffer(c);
+         if (part == NULL) {
+            result = TRAP_E_MEMORY;
+            goto release_parts;
+         }
+         memcpy(part->data, hdr, sizeof(trap_buffer_header_t));
+         part->size = sizeof(trap_buffer_header_t);
+      }
+      memcpy(part->data + part->size, &hdr->data[i], sizeof(uint16_t) + msize);
+      part->size += sizeof(uint16_t) + msize;
+      i += sizeof(uint16_t) + msize;
+   }
+
+   deadline = dist_deadline(timeout, &ts);
+   pthread_mutex_lock(&c->lock);
+   for (k = 0; k < n; k++) {
+      part = c->dist_parts[k];
+      if (part == NULL) {
+         continue;
+      }
+      c->dist_parts[k] = NULL;
+      /* every part carries the trace record of the whole buffer */
+      memcpy(part->data + part->size, &hdr->data[data_length], trace);
+      part->size += trace;
+      part_hdr = (trap_buffer_header_t *) part->data;
+      part_hdr->data_length = htonl(part->size - sizeof(trap_buffer_header_t));
+      cl = &c->clients[c->dist_clients[k]];
+      while ((cl->sd >= 0) && (cl->queue_count == c->queue_size) && (c->is_terminated == 0)) {
+         if (dist_wait(c, deadline) == ETIMEDOUT) {
+            break;
+         }
+      }
+      if (cl->sd < 0) {
+         /* client disconnected meanwhile, its messages are lost */
+      } else if (cl->queue_count == c->queue_size) {
+         queue_lagging_client(c, cl);
+      } else {
+         wake |= queue_push(c, cl, part);
+      }
+      if (part->refcount == 0) {
+         queue_put_buffer(c, part);
+      }
+   }
+   if (c->is_terminated) {
+      result = TRAP_E_TERMINATED;
+   }
+   pthread_mutex_unlock(&c->lock);
+
+   if (wake) {
+      queue_wake(c);
+   }
+   return result;
+
+release_parts:
+   pthread_mutex_lock(&c->lock);
+   for (k = 0; k < n; k++) {
+      if (c->dist_parts[k] != NULL) {
+         queue_put_buffer(c, c->dist_parts[k]);
+         c->dist_parts[k] = NULL;
+      }
+   }
+   pthread_mutex_unlock(&c->lock);
+   return result;
+}
+
+/**
+ * \brief Give buffer (or its messages) to clients according to dist_mode.
+ *
+ * \param[in] c        private data
+ * \param[in] data     pointer to data to send
+ * \param[in] size     size of data to send
+ * \param[in] timeout  timeout in microseconds
+ * \return TRAP_E_OK on success, TRAP_E_TIMEOUT when the buffer could not be
+ * handed over, TRAP_E_TERMINATED if interface was terminated.
+ */
+static int tcpip_sender_dist_send(tcpip_sender_private_t *c, const void *data, uint32_t size, int timeout)
+{
+   int result;
+
+   assert(size <= c->int_mess_header.data_length + sizeof(trap_buffer_header_t));
+
+   result = queue_wait_client(c, timeout);
+   if (result != TRAP_E_OK) {
+      return result;
+   }
+
+   if (c->dist_mode == DIST_MODE_HASH) {
+      if (dist_prepare_key(c)) {
+         return dist_send_hash(c, data, timeout);
+      }
+      c->dist_fallback_buffers++;
+   }
+   return dist_send_buffer(c, data, size, timeout, c->dist_mode == DIST_MODE_LEAST ? DIST_MODE_LEAST : DIST_MODE_RR);
+}
+
+/**
+ * \brief Get statistics of clients in queue mode or counters of I/O backend.
+ * \param[in] priv  pointer to module private data
+ * \return JSON object with lag and drop counters of every connected client,
+ * counters of epoll or io_uring backend, NULL in default mode with select()
+ */
+static json_t *tcpip_sender_get_stats(void *priv)
+{
+   tcpip_sender_private_t *c = (tcpip_sender_private_t *) priv;
+   json_t *clients, *cl_cnts;
+   struct client_s *cl;
+   int32_t i;
+
+   if (c == NULL) {
+      return NULL;
+   }
+   if (c->queue_size == 0) {
+      if ((c->io_backend == IO_BACKEND_SELECT) && (c->zerocopy == 0)) {
+         return NULL;
+      }
+      return json_pack("{sssIsIsbsIsI}", "io", TCPIP_IO_BACKEND_STR(c->io_backend),
+                       "io-requests", (json_int_t) c->io_requests,
+                       "io-waits", (json_int_t) c->io_waits,
+                       "zerocopy", (int) (c->uring_zc || c->zerocopy),
+                       "zerocopy-sends", (json_int_t) c->zc_sends,
+                       "zerocopy-copied", (json_int_t) c->zc_copied);
+   }
+   clients = json_array();
+   if (clients == NULL) {
+      return NULL;
+   }
+   pthread_mutex_lock(&c->lock);
+   for (i = 0; i < c->clients_arr_size; i++) {
+      cl = &c->clients[i];
+      if (cl->sd < 0) {
+         continue;
+      }
+      cl_cnts = json_pack("{sisIsIsIsIsI}", "id", i,
+                          "lag", (json_int_t) cl->queue_count,
+                          "queued-bytes", (json_int_t) cl->queue_bytes,
+                          "max-lag", (json_int_t) cl->max_lag,
+                          "sent-buffers", (json_int_t) cl->sent_buffers,
+                          "dropped-buffers", (json_int_t) cl->dropped_buffers);
+      if (json_array_append_new(clients, cl_cnts) == -1) {
+         VERBOSE(CL_ERROR, "Could not append client counters.");
+      }
+   }
+   pthread_mutex_unlock(&c->lock);
+
+   return json_pack("{sIsssIsssIso}", "queue-size", (json_int_t) c->queue_size,
+                    "lag-policy", TCPIP_LAG_POLICY_STR(c->lag_policy),
+                    "lag-disconnects", (json_int_t) c->lag_disconnects,
+                    "distribution", TCPIP_DIST_MODE_STR(c->dist_mode),
+                    "dist-fallback-buffers", (json_int_t) c->dist_fallback_buffers,
+                    "clients", clients);
+}
+
+/**
+ * @}
+ */
+
+/**
+ * \defgroup tcpip_sender_io epoll and io_uring backends of TCPIP output IFC
+ *
+ * Parameter "io" selects how send() of the default broadcast mode waits
+ * for clients.  Both backends try to send to all clients that did not get
+ * the buffer yet, then they wait for the clients that could not take it
+ * whole and continue with them.  Unlike select(), the number of client
+ * sockets is not limited by FD_SETSIZE.
+ *
+ * Epoll backend sends by non-blocking send(), a client with full socket
+ * is watched for EPOLLOUT until it takes the rest.  Io_uring backend
+ * submits send() requests of all clients by one system call and waits
+ * for their completions.  Buffers of output IFC are registered into the
+ * ring, so that TCP sockets send them by zero-copy send().
+ * @{
+ */
+
+/**
+ * Get time to wait for sockets in one step of send().
+ * \param[in] deadline  absolute time (CLOCK_REALTIME) from dist_deadline(), NULL to wait without limit
+ * \return microseconds, at most one second so that termination of IFC is noticed
+ */
+static int64_t io_wait_time(const struct timespec *deadline)
+{
+   struct timespec now;
+   int64_t left;
+
+   if (deadline == NULL) {
+      return USEC_IN_SEC;
+   }
+   clock_gettime(CLOCK_REALTIME, &now);
+   left = (int64_t) (deadline->tv_sec - now.tv_sec) * USEC_IN_SEC + (deadline->tv_nsec - now.tv_nsec) / 1000;
+   if (left < 0) {
+      return 0;
+   }
+   return MIN(left, USEC_IN_SEC);
+}
+
+/**
+ * Finish sending of buffer to all connected clients.
+ * \param[in,out] c  private data
+ * \return TRAP_E_OK, TRAP_E_IO_ERROR when there is no client left
+ */
+static int io_send_finish(tcpip_sender_private_t *c)
+{
+   struct client_s *cl;
+   int32_t i;
+
+   if (c->connected_clients == 0) {
+      return TRAP_E_IO_ERROR;
+   }
+   for (i = 0; i < c->clients_arr_size; i++) {
+      cl = &c->clients[i];
+      if (cl->client_state == CURRENT_COMPLETE) {
+         cl->client_state = CURRENT_IDLE;
+      }
+   }
+   return TRAP_E_OK;
+}
+
+#ifdef HAVE_SYS_EPOLL_H
+/**
+ * Prepare epoll of the epoll backend, clients are added when they connect.
+ * \param[in,out] c  private data
+ * \return TRAP_E_OK on success, TRAP_E_IO_ERROR
+ */
+static int io_epoll_init(tcpip_sender_private_t *c)
+{
+   c->epoll_fd = epoll_create1(0);
+   if (c->epoll_fd == -1) {
+      VERBOSE(CL_ERROR, "epoll_create1() failed (%d): %s", errno, strerror(errno));
+      return TRAP_E_IO_ERROR;
+   }
+   return TRAP_E_OK;
+}
+
+/**
+ * Watch term_pipe by epoll of the epoll backend.
+ * \param[in,out] c  private data
+ */
+static void io_epoll_watch_term(tcpip_sender_private_t *c)
+{
+   struct epoll_event ev;
+
+   memset(&ev, 0, sizeof(ev));
+   ev.events = EPOLLIN;
+   ev.data.u64 = QUEUE_EV_WAKE;
+   if (epoll_ctl(c->epoll_fd, EPOLL_CTL_ADD, c->term_pipe[0], &ev) == -1) {
+      VERBOSE(CL_ERROR, "Adding of term_pipe into epoll failed (%d): %s", errno, strerror(errno));
+   }
+}
+
+/**
+ * \brief Send buffer to all clients using non-blocking send() and epoll.
+ *
+ * \param[in,out] c      private data
+ * \param[in] data       pointer to data to send
+ * \param[in] size       size of data to send
+ * \param[in] deadline   absolute timeout (CLOCK_REALTIME), NULL to wait without limit
+ * \return TRAP_E_OK, TRAP_E_TIMEOUT, TRAP_E_TERMINATED, TRAP_E_IO_ERROR when there is no client left
+ */
+static int io_epoll_send(tcpip_sender_private_t *c, const void *data, uint32_t size, const struct timespec *deadline)
+{
+   struct epoll_event events[QUEUE_EPOLL_EVENTS];
+   struct client_s *cl;
+   char drain[64];
+   ssize_t readbytes;
+   uint32_t idx, waiting;
+   int32_t i;
+   int n;
+
+   while (c->is_terminated == 0) {
+      waiting = 0;
+      pthread_mutex_lock(&c->sending_lock);
+      for (i = 0; i < c->clients_arr_size; i++) {
+         cl = &c->clients[i];
+         if ((cl->sd < 0) || (cl->client_state == CURRENT_COMPLETE)) {
+            continue;
+         }
+         if (cl->wait_out) {
+            waiting++;
+            continue;
+         }
+         if ((cl->sending_pointer == NULL) || (cl->pending_bytes == 0)) {
+            cl->sending_pointer = (void *) data;
+            cl->pending_bytes = size;
+         }
+         c->io_requests++;
+         switch (send_all_data(c, cl->sd, &cl->sending_pointer, &cl->pending_bytes, 0, NULL)) {
+         case TRAP_E_OK:
+            cl->client_state = CURRENT_COMPLETE;
+            break;
+         case TRAP_E_TIMEOUT:
+            cl->client_state = CURRENT_PAYLOAD;
+            cl->wait_out = 1;
+            queue_watch_client(c, i, 1);
+            waiting++;
+            break;
+         default:
+            server_disconnected_client(c, i);
+            break;
+         }
+      }
+      pthread_mutex_unlock(&c->sending_lock);
+      if (waiting == 0) {
+         return io_send_finish(c);
+      }
+
+      n = epoll_wait(c->epoll_fd, events, QUEUE_EPOLL_EVENTS, (int) ((io_wait_time(deadline) + 999) / 1000));
+      c->io_waits++;
+      if ((n == -1) && (errno != EINTR)) {
+         VERBOSE(CL_ERROR, "epoll_wait failed (%d): %s", errno, strerror(errno));
+         return TRAP_E_IO_ERROR;
+      }
+      pthread_mutex_lock(&c->sending_lock);
+      for (i = 0; i < n; i++) {
+         if (events[i].data.u64 == QUEUE_EV_WAKE) {
+            pthread_mutex_unlock(&c->sending_lock);
+            return TRAP_E_TERMINATED;
+         }
+         idx = (uint32_t) events[i].data.u64;
+         cl = &c->clients[idx];
+         if (cl->sd != (int) (events[i].data.u64 >> 32)) {
+            /* event of closed socket */
+            continue;
+         }
+         if (events[i].events & (EPOLLIN | EPOLLRDHUP | EPOLLHUP | EPOLLERR)) {
+            readbytes = recv(cl->sd, drain, sizeof(drain), MSG_NOSIGNAL | MSG_DONTWAIT);
+            if ((readbytes == 0) || ((readbytes == -1) && (errno != EAGAIN) && (errno != EWOULDBLOCK))) {
+               VERBOSE(CL_VERBOSE_LIBRARY, "Disconnected client.");
+               cl->wait_out = 0;
+               server_disconnected_client(c, idx);
+               continue;
+            }
+         }
+         if ((events[i].events & EPOLLOUT) && cl->wait_out) {
+            cl->wait_out = 0;
+            queue_watch_client(c, idx, 0);
+         }
+      }
+      pthread_mutex_unlock(&c->sending_lock);
+      if ((n == 0) && (deadline != NULL) && (io_wait_time(deadline) == 0)) {
+         return TRAP_E_TIMEOUT;
+      }
+   }
+   return TRAP_E_TERMINATED;
+}
+#endif
+
+/**
+ * Create io_uring of the io_uring backend.
+ * \param[in,out] c  private data
+ * \return TRAP_E_OK on success, TRAP_E_IO_ERROR when io_uring is not available
+ */
+static int io_uring_init(tcpip_sender_private_t *c)
+{
+   c->uring = trap_uring_create(MIN(MAX(c->clients_arr_size, 8), 4096));
+   if (c->uring == NULL) {
+      return TRAP_E_IO_ERROR;
+   }
+   return TRAP_E_OK;
+}
+
+/**
+ * \brief Register buffers of output IFC into io_uring (see ifc_register_buffers_func_t).
+ *
+ * Registered buffers are useful for zero-copy send() that is supported by TCP sockets only.
+ * \param[in] priv   pointer to module private data
+ * \param[in] iov    buffers
+ * \param[in] count  number of buffers
+ */
+static void tcpip_sender_register_buffers(void *priv, const struct iovec *iov, uint32_t count)
+{
+   tcpip_sender_private_t *c = (tcpip_sender_private_t *) priv;
+
+   if ((c->uring == NULL) || (c->socket_type != TRAP_IFC_TCPIP)) {
+      return;
+   }
+   pthread_mutex_lock(&c->sending_lock);
+   c->uring_zc = (trap_uring_register_buffers(c->uring, iov, count) == TRAP_E_OK);
+   if (c->uring_zc == 0) {
+      VERBOSE(CL_VERBOSE_BASIC, "Buffers of output IFC %"PRIu32" could not be registered into io_uring.", c->ifc_idx);
+   }
+   pthread_mutex_unlock(&c->sending_lock);
+}
+
+/**
+ * Process completions of io_uring backend.
+ * \param[in,out] c  private data, sending_lock must be held
+ */
+static void io_uring_complete(tcpip_sender_private_t *c)
+{
+   trap_uring_cqe_t cqe;
+   struct client_s *cl;
+
+   while (trap_uring_next(c->uring, &cqe)) {
+      if (cqe.notif) {
+         c->uring_notifs--;
+         continue;
+      }
+      if (cqe.more) {
+         /* notification of zero-copy send() follows */
+         c->uring_notifs++;
+      }
+      if (cqe.user_data == TCPIP_URING_CANCEL) {
+         continue;
+      }
+      cl = &c->clients[(uint32_t) cqe.user_data];
+      cl->in_flight = 0;
+      if (cl->sd != (int) (cqe.user_data >> 32)) {
+         /* completion of closed socket */
+         continue;
+      }
+      if (cqe.res >= 0) {
+         cl->sending_pointer = (uint8_t *) cl->sending_pointer + cqe.res;
+         cl->pending_bytes -= cqe.res;
+         if (cl->pending_bytes == 0) {
+            cl->sending_pointer = NULL;
+            cl->client_state = CURRENT_COMPLETE;
+         } else {
+            cl->client_state = CURRENT_PAYLOAD;
+         }
+      } else if ((cqe.res == -EOPNOTSUPP) && c->uring_zc) {
+         VERBOSE(CL_VERBOSE_BASIC, "Zero-copy send() is not supported, registered buffers are not used.");
+         c->uring_zc = 0;
+      } else if ((cqe.res != -ECANCELED) && (cqe.res != -EINTR) && (cqe.res != -EAGAIN)) {
+         VERBOSE(CL_VERBOSE_LIBRARY, "Disconnected client (%d).", -cqe.res);
+         server_disconnected_client(c, (uint32_t) cqe.user_data);
+      }
+   }
+}
+
+/**
+ * Cancel requests in flight and wait for their completions and notifications.
+ * \param[in,out] c  private data, sending_lock must be held
+ */
+static void io_uring_cancel(tcpip_sender_private_t *c)
+{
+   int32_t i, attempts, in_flight;
+
+   trap_uring_prep_cancel_all(c->uring, TCPIP_URING_CANCEL);
+   for (attempts = 0; attempts < 100; attempts++) {
+      in_flight = 0;
+      for (i = 0; i < c->clients_arr_size; i++) {
+         in_flight += c->clients[i].in_flight;
+      }
+      if ((in_flight == 0) && (c->uring_notifs == 0)) {
+         return;
+      }
+      if (trap_uring_submit(c->uring, 1, 10000) == TRAP_E_IO_ERROR) {
+         break;
+      }
+      io_uring_complete(c);
+   }
+   VERBOSE(CL_ERROR, "Requests of io_uring were not cancelled.");
+}
+
+/**
+ * \brief Send buffer to all clients by one batch of io_uring requests.
+ *
+ * Every client has at most one send() request in flight, the request is
+ * submitted again until the client gets the whole buffer.  Requests that
+ * do not complete before deadline are cancelled.  When zero-copy send()
+ * is used, the function returns after its notifications, so data can be
+ * modified by the caller.
+ *
+ * \param[in,out] c      private data
+ * \param[in] data       pointer to data to send
+ * \param[in] size       size of data to send
+ * \param[in] deadline   absolute timeout (CLOCK_REALTIME), NULL to wait without limit
+ * \return TRAP_E_OK, TRAP_E_TIMEOUT, TRAP_E_TERMINATED, TRAP_E_IO_ERROR when there is no client left
+ */
+static int io_uring_send(tcpip_sender_private_t *c, const void *data, uint32_t size, const struct timespec *deadline)
+{
+   struct client_s *cl;
+   uint32_t in_flight;
+   int32_t i;
+   int result = TRAP_E_TERMINATED;
+
+   pthread_mutex_lock(&c->sending_lock);
+   while (c->is_terminated == 0) {
+      in_flight = 0;
+      for (i = 0; i < c->clients_arr_size; i++) {
+         cl = &c->clients[i];
+         if (cl->in_flight) {
+            in_flight++;
+            continue;
+         }
+         if ((cl->sd < 0) || (cl->client_state == CURRENT_COMPLETE)) {
+            continue;
+         }
+         if ((cl->sending_pointer == NULL) || (cl->pending_bytes == 0)) {
+            cl->sending_pointer = (void *) data;
+            cl->pending_bytes = size;
+         }
+         if (trap_uring_prep_send(c->uring, cl->sd, cl->sending_pointer, cl->pending_bytes, c->uring_zc,
+                                  QUEUE_EV_CLIENT(i, cl->sd)) != TRAP_E_OK) {
+            break;
+         }
+         c->io_requests++;
+         cl->in_flight = 1;
+         in_flight++;
+      }
+      if ((in_flight == 0) && (c->uring_notifs == 0)) {
+         result = io_send_finish(c);
+         break;
+      }
+
+      /* submit the whole batch and wait for completions */
+      result = trap_uring_submit(c->uring, 1, io_wait_time(deadline));
+      c->io_waits++;
+      if (result == TRAP_E_IO_ERROR) {
+         break;
+      }
+      io_uring_complete(c);
+      if ((result == TRAP_E_TIMEOUT) && (deadline != NULL) && (io_wait_time(deadline) == 0)) {
+         break;
+      }
+      result = TRAP_E_TERMINATED;
+   }
+   if (result != TRAP_E_OK) {
+      /* data must not be used by kernel after return */
+      io_uring_cancel(c);
+   }
+   pthread_mutex_unlock(&c->sending_lock);
+   return result;
+}
+
+/**
+ * \brief Send buffer to all clients by epoll or io_uring backend.
+ *
+ * \param[in] c        private data
+ * \param[in] data     pointer to data to send
+ * \param[in] size     size of data to send
+ * \param[in] timeout  timeout in microseconds
+ * \return TRAP_E_OK on success, TRAP_E_TIMEOUT, TRAP_E_TERMINATED if interface
+ * was terminated, TRAP_E_IO_ERROR when all clients disconnected.
+ */
+static int tcpip_sender_io_send(tcpip_sender_private_t *c, const void *data, uint32_t size, int timeout)
+{
+   struct timespec ts, *deadline;
+   int result;
+
+   deadline = dist_deadline(timeout, &ts);
+   do {
+      result = queue_wait_client(c, timeout);
+      if (result != TRAP_E_OK) {
+         return result;
+      }
+#ifdef HAVE_SYS_EPOLL_H
+      if (c->io_backend == IO_BACKEND_EPOLL) {
+         result = io_epoll_send(c, data, size, deadline);
+         continue;
+      }
+#endif
+      result = io_uring_send(c, data, size, deadline);
+   } while ((result == TRAP_E_IO_ERROR) && (timeout == TRAP_WAIT));
+   return result;
+}
+
+/**
+ * @}
+ */
+
+/**
+ * \brief Send data to all connected clients.
+ *
+ * All clients are in 'current' buffer or in 'backup' buffer.
+ * All clients get messages from current buffer at first.
+ * * When all buffer is successfully sent to all clients
+ * in 'current' buffer, everything is alright.
+ *
+ * * When everybody fails due to timeout, everything
+ * is alright, everybody stays in 'current' buffer.
+ *
+ * * When somebody fails and somebody is successful, failing clients are moved into 'backup' buffer and they have chance to receive the rest of message later. We disconnect all clients that were in 'backup' buffer before moving new ones from 'current' buffer.
+ *
+ * * All successful clients from 'backup' buffer are moved back into 'current' buffer.
+ *
+ * \param[in] priv  pointer to module private data
+ * \param[in] data  pointer to data to send
+ * \param[in] size  size of data to send
+ * \param[in] timeout  timeout in microseconds
+ * \return 0 on success (TRAP_E_OK), TRAP_E_BAD_FPARAMS if sender was not properly initialized, TRAP_E_TERMINATED if interface was terminated.
+ */
+int tcpip_sender_send(void *priv, const void *data, uint32_t size, int timeout)
+{
+   uint8_t buffer[DEFAULT_MAX_DATA_LENGTH];
+   int result = TRAP_E_TIMEOUT;
+   tcpip_sender_private_t *c = (tcpip_sender_private_t *) priv;
+   /* timeout for blocking mode */
+   struct timeval tm;
+   /* timout for nonblocking mode */
+   struct timespec tmnblk;
+   /* pointer to timeout for select() */
+   struct timeval *temptm;
+   /* pointer to timeout for select() */
+   struct timespec *temptmblk;
+   fd_set set, disset;
+   int maxsd = -1;
+   struct client_s *cl;
+   uint32_t i, j, failed, passed;
+   struct timeval sectm;
+   int retval;
+   ssize_t readbytes;
+   uint32_t reaped;
+   char block, zc_pending;
+
+   /* correct module will pass only possitive timeout or TRAP_WAIT, TRAP_HALFWAIT */
+   assert(timeout >= TRAP_HALFWAIT);
+
+   if (c->dist_mode != DIST_MODE_BROADCAST) {
+      return tcpip_sender_dist_send(c, data, size, timeout);
+   } else if (c->queue_size != 0) {
+      return tcpip_sender_queue_send(c, data, size, timeout);
+   } else if (c->io_backend != IO_BACKEND_SELECT) {
+      return tcpip_sender_io_send(c, data, size, timeout);
+   }
+
+   /* I. Init phase: set timeout and double-send switch */
+   trap_set_timeouts(timeout, &tm, NULL);
+   temptm = (((timeout==TRAP_WAIT) || (timeout==TRAP_HALFWAIT))?NULL:&tm);
+
+   switch (timeout) {
+   case TRAP_WAIT:
+      trap_set_abs_timespec(1000000, &tm, &tmnblk);
+      break;
    case TRAP_HALFWAIT:
       trap_set_abs_timespec(0, &tm, &tmnblk);
       break;
@@ -1162,9 +3093,10 @@ blocking_repeat:
          continue;
       }
       if (FD_ISSET(cl->sd, &disset)) {
-         /* client disconnects */
+         /* client disconnects or completions of zero-copy send() arrived */
+         reaped = (cl->zc_done != cl->zc_sent) ? zerocopy_reap(c, cl) : 0;
          readbytes = recv(cl->sd, buffer, DEFAULT_MAX_DATA_LENGTH, MSG_NOSIGNAL | MSG_DONTWAIT);
-         if (readbytes < 1) {
+         if ((readbytes < 1) && ((reaped == 0) || (readbytes == 0) || ((errno != EAGAIN) && (errno != EWOULDBLOCK)))) {
             VERBOSE(CL_VERBOSE_LIBRARY, "Disconnected client.");
             result = TRAP_E_IO_ERROR;
             server_disconnected_client(c, i);
@@ -1181,7 +3113,8 @@ blocking_repeat:
             cl->sending_pointer = (void *) data;
             cl->pending_bytes = size;
          }
-         result = send_all_data(c, cl->sd, &cl->sending_pointer, &cl->pending_bytes, block);
+         result = send_all_data(c, cl->sd, &cl->sending_pointer, &cl->pending_bytes, block,
+                                ((cl->zerocopy != 0) && (size >= TCPIP_ZEROCOPY_MIN)) ? &cl->zc_sent : NULL);
          switch (result) {
          case TRAP_E_IO_ERROR:
             server_disconnected_client(c, i);
@@ -1213,9 +3146,15 @@ blocking_repeat:
    if (failed != 0) {
       result = TRAP_E_TIMEOUT;
    } else {
+      zc_pending = 0;
       for (i = 0, passed = 0; i < c->clients_arr_size; ++i) {
          cl = &c->clients[i];
          if ((cl->sd > 0) && (cl->client_state == CURRENT_COMPLETE) && (cl->sending_pointer == NULL)) {
+            if (cl->zc_done != cl->zc_sent) {
+               /* kernel still uses the buffer, wait for completion in select() */
+               zc_pending = 1;
+               continue;
+            }
             passed++;
             if (passed == c->connected_clients) {
                break;
@@ -1236,7 +3175,7 @@ blocking_repeat:
          }
          result = TRAP_E_OK;
       } else {
-         if (timeout == TRAP_WAIT) {
+         if ((timeout == TRAP_WAIT) || (zc_pending != 0)) {
             goto blocking_repeat;
          }
       }
@@ -1261,6 +3200,14 @@ void tcpip_sender_terminate(void *priv)
       c->is_terminated = 1;
       close(c->term_pipe[1]);
       VERBOSE(CL_VERBOSE_LIBRARY, "Closed term_pipe, it should break select()");
+      if (c->send_thread_running) {
+         queue_wake(c);
+      }
+      if (c->dist_mode != DIST_MODE_BROADCAST) {
+         pthread_mutex_lock(&c->lock);
+         pthread_cond_broadcast(&c->queue_cond);
+         pthread_mutex_unlock(&c->lock);
+      }
    } else {
       VERBOSE(CL_ERROR, "Destroying IFC that is probably not initialized.");
    }
@@ -1303,6 +3250,8 @@ void tcpip_sender_destroy(void *priv)
       /* close server socket */
       close(c->server_sd);
 
+      queue_destroy(c);
+
       /* disconnect all clients */
       pthread_mutex_lock(&c->lock);
       if (c->clients != NULL) {
@@ -1319,10 +3268,16 @@ void tcpip_sender_destroy(void *priv)
          c->clients = NULL;
       }
       pthread_mutex_unlock(&c->lock);
+      trap_uring_destroy(c->uring);
       pthread_mutex_destroy(&c->lock);
       pthread_mutex_destroy(&c->sending_lock);
+      pthread_cond_destroy(&c->queue_cond);
       sem_destroy(&c->have_clients);
 
+      X(c->dist_key)
+      X(c->dist_spec)
+      X(c->dist_parts)
+      X(c->dist_clients)
       X(c->backup_buffer)
       X(c)
    }
@@ -1370,6 +3325,7 @@ static void tcpip_sender_create_dump(void *priv, uint32_t idx, const char *path)
            "Buffering layer buffer size: %"PRIu32"\n"
            "Backup buffer: %p\nTerminated: %d\nInitialized: %d\nSocket type: %s\n"
            "Message size: %"PRIu32"\nTimeout: %"PRId32"us (%s)\n"
+           "Queue size: %"PRIu32"\nDistribution: %s\n"
            "Clients:\n",
            c->server_port, c->server_sd, c->connected_clients, c->clients_arr_size,
            c->ctx->out_ifc_list[idx].buffer,
@@ -1378,7 +3334,8 @@ static void tcpip_sender_create_dump(void *priv, uint32_t idx, const char *path)
            c->initialized, TCPIP_SOCKETTYPE_STR(c->socket_type),
            c->int_mess_header.data_length,
            c->ctx->out_ifc_list[idx].datatimeout,
-           TRAP_TIMEOUT_STR(c->ctx->out_ifc_list[idx].datatimeout));
+           TRAP_TIMEOUT_STR(c->ctx->out_ifc_list[idx].datatimeout),
+           c->queue_size, TCPIP_DIST_MODE_STR(c->dist_mode));
    for (i = 0; i < c->clients_arr_size; i++) {
       cl = &c->clients[i];
       fprintf(f, "\t{%"PRId32", %s, %p, %"PRIu32"}\n",
@@ -1433,6 +3390,9 @@ void server_disconnect_all_clients(void *priv)
       for (i = 0; i < c->clients_arr_size; i++) {
          cl = &c->clients[i];
          if (cl->sd > 0) {
+            if (cl->queue != NULL) {
+               queue_release_client(c, cl);
+            }
             close(cl->sd);
             cl->sd = -1;
             c->connected_clients--;
@@ -1462,6 +3422,7 @@ int create_tcpip_sender_ifc(trap_ctx_priv_t *ctx, const char *params, trap_outpu
    char *param_iterator = NULL;
    char *server_port = NULL;
    char *max_clients = NULL;
+   char *param = NULL;
    tcpip_sender_private_t *priv = NULL;
    unsigned int max_num_client = 10;
    uint32_t i;
@@ -1486,6 +3447,9 @@ int create_tcpip_sender_ifc(trap_ctx_priv_t *ctx, const char *params, trap_outpu
    priv->ctx = ctx;
    priv->socket_type = type;
    priv->ifc_idx = idx;
+   priv->epoll_fd = -1;
+   priv->wake_pipe[0] = priv->wake_pipe[1] = -1;
+   pthread_cond_init(&priv->queue_cond, NULL);
 
    /* Parsing params */
    param_iterator = trap_get_param_by_delimiter(params, &server_port, TRAP_IFC_PARAM_DELIMITER);
@@ -1494,11 +3458,84 @@ int create_tcpip_sender_ifc(trap_ctx_priv_t *ctx, const char *params, trap_outpu
       result = TRAP_E_BADPARAMS;
       goto failsafe_cleanup;
    }
-   if (param_iterator != NULL) {
+   while (param_iterator != NULL) {
       /* still having something to parse... */
-      param_iterator = trap_get_param_by_delimiter(param_iterator, &max_clients, TRAP_IFC_PARAM_DELIMITER
-);
+      param_iterator = trap_get_param_by_delimiter(param_iterator, &param, TRAP_IFC_PARAM_DELIMITER);
+      if (param == NULL) {
+         break;
+      }
+      if (strncmp(param, "queue=", 6) == 0) {
+         if (sscanf(param + 6, "%"SCNu32, &priv->queue_size) != 1) {
+            VERBOSE(CL_ERROR, "Length of client queue given, but it is probably in wrong format.");
+            priv->queue_size = 0;
+         }
+      } else if (strncmp(param, "lag=", 4) == 0) {
+         if (strcmp(param + 4, "drop") == 0) {
+            priv->lag_policy = LAG_POLICY_DROP;
+         } else if (strcmp(param + 4, "disconnect") == 0) {
+            priv->lag_policy = LAG_POLICY_DISCONNECT;
+         } else {
+            VERBOSE(CL_ERROR, "Unknown lag policy '%s', using 'drop'.", param + 4);
+         }
+      } else if (strncmp(param, "dist=", 5) == 0) {
+         if (strcmp(param + 5, "rr") == 0) {
+            priv->dist_mode = DIST_MODE_RR;
+         } else if (strcmp(param + 5, "least") == 0) {
+            priv->dist_mode = DIST_MODE_LEAST;
+         } else if (strcmp(param + 5, "hash") == 0) {
+            priv->dist_mode = DIST_MODE_HASH;
+         } else if (strcmp(param + 5, "broadcast") == 0) {
+            priv->dist_mode = DIST_MODE_BROADCAST;
+         } else {
+            VERBOSE(CL_ERROR, "Unknown distribution '%s', using 'broadcast'.", param + 5);
+         }
+      } else if (strncmp(param, "key=", 4) == 0) {
+         free(priv->dist_key);
+         priv->dist_key = strdup(param + 4);
+      } else if (strncmp(param, "io=", 3) == 0) {
+         parse_io_backend(param + 3, &priv->io_backend);
+      } else if (strcmp(param, "zerocopy") == 0) {
+         priv->zerocopy = 1;
+      } else if (max_clients == NULL) {
+         max_clients = param;
+         param = NULL;
+      } else {
+         VERBOSE(CL_ERROR, "Unknown parameter '%s' of %s IFC.", param, (type == TRAP_IFC_TCPIP ? "TCPIP" : "UNIX socket"));
+      }
+      X(param);
+   }
+   if (priv->dist_mode == DIST_MODE_HASH) {
+      if ((priv->dist_key == NULL) || (priv->dist_key[0] == '\0')) {
+         VERBOSE(CL_ERROR, "Hash distribution requires key=FIELD[+FIELD...], using 'rr'.");
+         priv->dist_mode = DIST_MODE_RR;
+      }
+   } else if (priv->dist_key != NULL) {
+      VERBOSE(CL_ERROR, "Parameter 'key' is used by hash distribution only, it is ignored.");
+   }
+   if ((priv->dist_mode != DIST_MODE_BROADCAST) && (priv->queue_size == 0)) {
+      priv->queue_size = TCPIP_DIST_QUEUE_DEFAULT;
+   }
+#ifndef HAVE_SYS_EPOLL_H
+   if (priv->queue_size != 0) {
+      VERBOSE(CL_ERROR, "Client queues are not supported on this platform, using default mode.");
+      priv->queue_size = 0;
+      priv->dist_mode = DIST_MODE_BROADCAST;
+   }
+#endif
+   if ((priv->io_backend != IO_BACKEND_SELECT) && (priv->queue_size != 0)) {
+      VERBOSE(CL_VERBOSE_BASIC, "Parameter 'io' is used by the default mode only, client queues are sent using epoll.");
+      priv->io_backend = IO_BACKEND_SELECT;
    }
+   if ((priv->zerocopy != 0) && ((type != TRAP_IFC_TCPIP) || (priv->queue_size != 0) || (priv->io_backend != IO_BACKEND_SELECT))) {
+      VERBOSE(CL_VERBOSE_BASIC, "Parameter 'zerocopy' is used by TCP IFC in the default mode with io=select only, it is ignored.");
+      priv->zerocopy = 0;
+   }
+#ifndef TCPIP_ZEROCOPY
+   if (priv->zerocopy != 0) {
+      VERBOSE(CL_ERROR, "Zero-copy send() is not supported on this platform, data are copied.");
+      priv->zerocopy = 0;
+   }
+#endif
    if (max_clients == NULL) {
       /* 2nd parameter became optional, set default value when missing */
       max_num_client = TRAP_IFC_DEFAULT_MAX_CLIENTS;
@@ -1509,8 +3546,8 @@ int create_tcpip_sender_ifc(trap_ctx_priv_t *ctx, const char *params, trap_outpu
       }
    }
 
-   /* set global buffer size */
-   priv->int_mess_header.data_length = TRAP_IFC_MESSAGEQ_SIZE;
+   /* set global buffer size (setter "bufsize"), service IFC has no context */
+   priv->int_mess_header.data_length = (ctx != NULL) ? ctx->out_ifc_list[idx].buffer_size : TRAP_IFC_MESSAGEQ_SIZE;
    /* Parsing params ended */
 
    priv->clients_arr_size = max_num_client;
@@ -1520,8 +3557,16 @@ int create_tcpip_sender_ifc(trap_ctx_priv_t *ctx, const char *params, trap_outpu
       result = TRAP_E_MEMORY;
       goto failsafe_cleanup;
    }
+   if (priv->dist_mode == DIST_MODE_HASH) {
+      priv->dist_parts = calloc(max_num_client, sizeof(struct tcpip_qbuf *));
+      priv->dist_clients = calloc(max_num_client, sizeof(uint32_t));
+      if ((priv->dist_parts == NULL) || (priv->dist_clients == NULL)) {
+         result = TRAP_E_MEMORY;
+         goto failsafe_cleanup;
+      }
+   }
 
-   /* allocate buffer according to TRAP_IFC_MESSAGEQ_SIZE with additional space for message header */
+   /* allocate buffer according to size of buffers with additional space for message header */
    //priv->message_buffer = (void *) calloc(1, priv->int_mess_header.data_length +
    //                        sizeof(trap_buffer_header_t));
    priv->backup_buffer = (void *) calloc(1, priv->int_mess_header.data_length +
@@ -1536,7 +3581,7 @@ int create_tcpip_sender_ifc(trap_ctx_priv_t *ctx, const char *params, trap_outpu
       priv->clients[i].client_state = CURRENT_IDLE;
       /* all clients are disconnected */
       priv->clients[i].sd = -1;
-      priv->clients[i].buffer = calloc(TRAP_IFC_MESSAGEQ_SIZE + 4, 1);
+      priv->clients[i].buffer = calloc(priv->int_mess_header.data_length + 4, 1);
    }
 
    priv->connected_clients = 0;
@@ -1546,8 +3591,11 @@ int create_tcpip_sender_ifc(trap_ctx_priv_t *ctx, const char *params, trap_outpu
    pthread_mutex_init(&priv->sending_lock, NULL);
 
    VERBOSE(CL_VERBOSE_ADVANCED, "config:\nserver_port=\"%s\"\nmax_clients=\"%s\"\n"
-      "TDU size: %u\n(max_clients_num=\"%u\")", priv->server_port, max_clients,
-      priv->int_mess_header.data_length, priv->clients_arr_size);
+      "TDU size: %u\n(max_clients_num=\"%u\")\nqueue=%"PRIu32" lag=%s dist=%s key=%s io=%s zerocopy=%d", priv->server_port, max_clients,
+      priv->int_mess_header.data_length, priv->clients_arr_size,
+      priv->queue_size, TCPIP_LAG_POLICY_STR(priv->lag_policy),
+      TCPIP_DIST_MODE_STR(priv->dist_mode), (priv->dist_key != NULL ? priv->dist_key : "-"),
+      TCPIP_IO_BACKEND_STR(priv->io_backend), priv->zerocopy);
    X(max_clients);
 
    if (sem_init(&priv->have_clients, 0, 0) == -1) {
@@ -1555,6 +3603,33 @@ int create_tcpip_sender_ifc(trap_ctx_priv_t *ctx, const char *params, trap_outpu
       goto failsafe_cleanup;
    }
 
+#ifdef HAVE_SYS_EPOLL_H
+   if (priv->queue_size != 0) {
+      result = queue_init(priv);
+      if (result != TRAP_E_OK) {
+         VERBOSE(CL_ERROR, "Initialization of client queues failed.");
+         goto failsafe_cleanup;
+      }
+   }
+#endif
+   if ((priv->io_backend == IO_BACKEND_URING) && (io_uring_init(priv) != TRAP_E_OK)) {
+#ifdef HAVE_SYS_EPOLL_H
+      VERBOSE(CL_ERROR, "I/O backend 'uring' is not available, using 'epoll'.");
+      priv->io_backend = IO_BACKEND_EPOLL;
+#else
+      VERBOSE(CL_ERROR, "I/O backend 'uring' is not available, using 'select'.");
+      priv->io_backend = IO_BACKEND_SELECT;
+#endif
+   }
+#ifdef HAVE_SYS_EPOLL_H
+   if (priv->io_backend == IO_BACKEND_EPOLL) {
+      result = io_epoll_init(priv);
+      if (result != TRAP_E_OK) {
+         goto failsafe_cleanup;
+      }
+   }
+#endif
+
    result = server_socket_open(priv);
    if (result != TRAP_E_OK) {
       VERBOSE(CL_ERROR, "Socket could not be opened on given port '%s'.", server_port);
@@ -1565,6 +3640,11 @@ int create_tcpip_sender_ifc(trap_ctx_priv_t *ctx, const char *params, trap_outpu
       VERBOSE(CL_ERROR, "Opening of pipe failed. Using stdin as a fall back.");
       priv->term_pipe[0] = 0;
    }
+#ifdef HAVE_SYS_EPOLL_H
+   if ((priv->io_backend == IO_BACKEND_EPOLL) && (priv->term_pipe[0] != 0)) {
+      io_epoll_watch_term(priv);
+   }
+#endif
 
    // Fill struct defining the interface
    ifc->disconn_clients = server_disconnect_all_clients;
@@ -1573,6 +3653,8 @@ int create_tcpip_sender_ifc(trap_ctx_priv_t *ctx, const char *params, trap_outpu
    ifc->destroy = tcpip_sender_destroy;
    ifc->get_client_count = tcpip_sender_get_client_count;
    ifc->create_dump = tcpip_sender_create_dump;
+   ifc->get_stats = tcpip_sender_get_stats;
+   ifc->register_buffers = tcpip_sender_register_buffers;
    ifc->priv = priv;
 
    return result;
@@ -1581,6 +3663,8 @@ failsafe_cleanup:
    X(server_port);
    X(max_clients);
    if (priv != NULL) {
+      queue_destroy(priv);
+      trap_uring_destroy(priv->uring);
       X(priv->backup_buffer);
       if (priv->clients != NULL) {
          for (i = 0; i < max_num_client; i++) {
@@ -1588,8 +3672,12 @@ failsafe_cleanup:
          }
       }
       X(priv->clients);
+      X(priv->dist_key);
+      X(priv->dist_parts);
+      X(priv->dist_clients);
       pthread_mutex_destroy(&priv->lock);
       pthread_mutex_destroy(&priv->sending_lock);
+      pthread_cond_destroy(&priv->queue_cond);
       X(priv);
    }
 #undef X
@@ -1679,7 +3767,17 @@ static void *accept_clients_thread(void *arg)
                cl->client_state = CURRENT_IDLE;
                cl->sending_pointer = NULL;
                cl->pending_bytes = 0;
+               cl->wait_out = 0;
+               zerocopy_enable(c, cl);
                c->connected_clients++;
+#ifdef HAVE_SYS_EPOLL_H
+               if ((c->queue_size != 0) || (c->io_backend == IO_BACKEND_EPOLL)) {
+                  queue_add_client(c, i);
+               }
+#endif
+               if (c->dist_mode != DIST_MODE_BROADCAST) {
+                  pthread_cond_broadcast(&c->queue_cond);
+               }
 
                if (sem_post(&c->have_clients) == -1) {
                   VERBOSE(CL_ERROR, "Semaphore post failed.");
@@ -60,6 +60,18 @@
  * @{
  */
 
+/**
+ * I/O backend of socket (parameter "io").
+ */
+enum tcpip_io_backend {
+   IO_BACKEND_SELECT, /**< select() with blocking or non-blocking send()/recv() (default) */
+   IO_BACKEND_EPOLL, /**< epoll with non-blocking send()/recv() */
+   IO_BACKEND_URING /**< io_uring (see \ref trap_uring), epoll is used when it is not available */
+};
+
+#define TCPIP_IO_BACKEND_STR(b) ((b) == IO_BACKEND_SELECT ? "select" : \
+((b) == IO_BACKEND_EPOLL ? "epoll" : "uring"))
+
  /**
  * \defgroup tcpip_sender TCPIP output IFC
  * @{
@@ -73,12 +85,66 @@ enum client_send_state {
    BACKUP_BUFFER /**< timeout in backup buffer */
 };
 
+/**
+ * Policy for clients whose queue is full (see queue mode of output IFC).
+ */
+enum tcpip_lag_policy {
+   LAG_POLICY_DROP, /**< drop new buffers for the lagging client */
+   LAG_POLICY_DISCONNECT /**< disconnect the lagging client */
+};
+
+#define TCPIP_LAG_POLICY_STR(p) ((p) == LAG_POLICY_DROP ? "drop" : "disconnect")
+
+/**
+ * Distribution of buffers among clients (see distribution mode of output IFC).
+ */
+enum tcpip_dist_mode {
+   DIST_MODE_BROADCAST, /**< every client gets every buffer (default) */
+   DIST_MODE_RR, /**< buffers are given to clients in turn */
+   DIST_MODE_LEAST, /**< buffer is given to the client with the least unsent data */
+   DIST_MODE_HASH /**< every message is given to the client chosen by hash of key fields */
+};
+
+#define TCPIP_DIST_MODE_STR(m) ((m) == DIST_MODE_BROADCAST ? "broadcast" : \
+((m) == DIST_MODE_RR ? "rr" : \
+((m) == DIST_MODE_LEAST ? "least" : "hash")))
+
+#define TCPIP_DIST_QUEUE_DEFAULT 16 ///< Length of client queues in distribution mode when queue= is not given
+#define TCPIP_DIST_MAX_KEYS 8 ///< Maximal number of key fields of hash distribution
+#define TCPIP_ZEROCOPY_MIN 16384 ///< Minimal size of buffer sent with MSG_ZEROCOPY, smaller buffers are copied
+
+/**
+ * Copy of buffer shared by queues of all clients (queue mode).
+ *
+ * The buffer is returned into the list of free buffers when refcount drops to 0.
+ */
+struct tcpip_qbuf {
+   struct tcpip_qbuf *next; /**< Next item in the list of free buffers */
+   uint32_t refcount; /**< Number of client queues that contain the buffer */
+   uint32_t size; /**< Size of data (buffer header and payload) */
+   uint8_t data[0]; /**< Buffer header and payload */
+};
+
 struct client_s {
    int sd; /**< Socket descriptor */
    void *sending_pointer; /**< Array of pointers into buffer */
    void *buffer; /**< separate message buffer */
    uint32_t pending_bytes; /**< The size of data that must be sent */
    enum client_send_state client_state; /**< State of sending */
+
+   struct tcpip_qbuf **queue; /**< Ring of buffers waiting for sending (queue mode) */
+   uint32_t queue_head; /**< Index of the oldest buffer in queue */
+   uint32_t queue_count; /**< Number of buffers in queue, i.e. current lag of client */
+   uint32_t queue_offset; /**< Already sent bytes of the oldest buffer */
+   uint64_t queue_bytes; /**< Size of all buffers in queue */
+   uint32_t max_lag; /**< Maximal observed lag */
+   char wait_out; /**< Socket is full, sending continues after EPOLLOUT */
+   char in_flight; /**< send() was submitted to io_uring and it did not complete yet (io=uring) */
+   char zerocopy; /**< Large buffers are sent with MSG_ZEROCOPY (SO_ZEROCOPY is enabled on socket) */
+   uint32_t zc_sent; /**< Number of send() calls with MSG_ZEROCOPY, counted by kernel as well */
+   uint32_t zc_done; /**< Number of zero-copy send() calls whose completion was received */
+   uint64_t sent_buffers; /**< Number of buffers sent to client */
+   uint64_t dropped_buffers; /**< Number of buffers dropped for client due to lag */
 };
 
 typedef struct tcpip_sender_private_s {
@@ -117,6 +183,56 @@ typedef struct tcpip_sender_private_s {
    pthread_mutex_t  sending_lock;
    pthread_t        accept_thread;
    uint32_t ifc_idx;
+
+   /**
+    * Length of per-client queues, 0 means the default mode when send()
+    * waits for all clients.  Otherwise, buffers are enqueued for every client
+    * and sent independently by send_thread.
+    */
+   uint32_t queue_size;
+   enum tcpip_lag_policy lag_policy; /**< What to do with client whose queue is full */
+   struct tcpip_qbuf *free_qbufs; /**< List of unused buffers */
+   uint32_t free_qbufs_count; /**< Number of buffers in free_qbufs */
+   uint64_t lag_disconnects; /**< Number of clients disconnected due to lag */
+   int epoll_fd; /**< epoll descriptor of send_thread */
+   int wake_pipe[2]; /**< Pipe to wake up send_thread when new buffer is enqueued */
+   char send_thread_running; /**< send_thread was started */
+   pthread_t        send_thread;
+
+   enum tcpip_dist_mode dist_mode; /**< Distribution of buffers among clients, it requires queues */
+   uint32_t dist_next; /**< Index of client where round-robin continues */
+   pthread_cond_t queue_cond; /**< Signalled when a queue gets space or the set of clients changes (distribution mode) */
+   char *dist_key; /**< Key fields of hash distribution separated by '+' */
+   char *dist_spec; /**< Data format specifier that dist_key_offset was computed for */
+   uint32_t dist_key_count; /**< Number of key fields in dist_key_offset, 0 when the key cannot be used */
+   int32_t dist_key_offset[TCPIP_DIST_MAX_KEYS]; /**< Offsets of key fields in record */
+   uint32_t dist_key_size[TCPIP_DIST_MAX_KEYS]; /**< Sizes of key fields */
+   uint32_t dist_key_end; /**< Minimal size of record that contains all key fields */
+   struct tcpip_qbuf **dist_parts; /**< Parts of buffer for every client (hash distribution) */
+   uint32_t *dist_clients; /**< Indexes of clients that get dist_parts (hash distribution) */
+   uint64_t dist_fallback_buffers; /**< Buffers distributed round-robin because the key could not be used */
+
+   /**
+    * I/O backend of the default broadcast mode.  Queue and distribution
+    * modes always send by send_thread driven by epoll.  Epoll backend uses
+    * epoll_fd, clients are registered when they connect.
+    */
+   enum tcpip_io_backend io_backend;
+   struct trap_uring_s *uring; /**< io_uring of io=uring, NULL otherwise */
+   char uring_zc; /**< Registered buffers are sent by zero-copy send() (TCP socket with registered buffers) */
+   uint32_t uring_notifs; /**< Notifications of zero-copy send() that did not arrive yet */
+   uint64_t io_requests; /**< Number of send() calls (epoll) or send requests (io_uring) */
+   uint64_t io_waits; /**< Number of epoll_wait() or io_uring_enter() calls that waited */
+
+   /**
+    * Send buffers of at least TCPIP_ZEROCOPY_MIN bytes with MSG_ZEROCOPY
+    * (TCP, default mode with io=select).  Kernel keeps pages of the buffer
+    * until it reports completion into the error queue of socket, so
+    * send() returns only after all completions arrived.
+    */
+   char zerocopy;
+   uint64_t zc_sends; /**< Number of send() calls with MSG_ZEROCOPY */
+   uint64_t zc_copied; /**< Number of zero-copy send() calls that kernel completed by copying data */
 } tcpip_sender_private_t;
 
 #define TCPIP_SENDER_STATE_STR(st) (st == CURRENT_IDLE ? "CURRENT_IDLE": \
@@ -133,6 +249,12 @@ typedef struct tcpip_sender_private_s {
  * \defgroup tcpip_receiver TCPIP input IFC
  * @{
  */
+#define TCPIP_READAHEAD_DEFAULT (4 * (TRAP_IFC_MESSAGEQ_SIZE + sizeof(trap_buffer_header_t))) ///< Default size of read-ahead buffer
+#define TCPIP_URING_ENTRIES 8 ///< Size of submission queue of io_uring of input IFC
+#define TCPIP_URING_PBUF_COUNT 16 ///< Number of provided buffers of multishot recv()
+#define TCPIP_URING_PBUF_SIZE 32768 ///< Size of provided buffer of multishot recv()
+#define TCPIP_URING_CANCEL UINT64_MAX ///< user_data of cancellation requests
+
 typedef struct tcpip_receiver_private_s {
    trap_ctx_priv_t *ctx; /**< Libtrap context */
    char *dest_addr;
@@ -147,6 +269,34 @@ typedef struct tcpip_receiver_private_s {
    uint32_t ext_buffer_size; /** size of content of the extbuffer */
    trap_buffer_header_t int_mess_header; /**< Internal message header - used for message_buffer payload size \note message_buffer size is sizeof(tcpip_tdu_header_t) + payload size */
    uint32_t ifc_idx;
+
+   /**
+    * Read-ahead buffer (readahead mode), NULL in default mode.  Every recv()
+    * takes as many bytes as the socket has, complete TRAP buffers are then
+    * copied out of it without further syscalls.
+    */
+   uint8_t *ra_buffer;
+   uint32_t ra_size; /**< Capacity of ra_buffer */
+   uint32_t ra_start; /**< Offset of the first unread byte in ra_buffer */
+   uint32_t ra_end; /**< Offset after the last received byte in ra_buffer */
+   char ra_drained; /**< The last recv() emptied the socket, wait for data before the next one */
+   char ra_watched; /**< sd was added into epoll_fd */
+   int epoll_fd; /**< epoll descriptor to wait for data in readahead mode */
+   uint64_t recv_calls; /**< Number of recv() calls */
+   uint64_t wait_calls; /**< Number of select() / epoll_wait() calls */
+   uint32_t conn_gen; /**< Incremented when sd is closed (see ifc_get_fd_func_t) */
+
+   /**
+    * I/O backend, epoll and io_uring use the read-ahead buffer.  With
+    * io_uring, multishot recv() (user_data is conn_gen) fills provided
+    * buffers and their data is copied into the read-ahead buffer.
+    */
+   enum tcpip_io_backend io_backend;
+   struct trap_uring_s *uring; /**< io_uring of io=uring, NULL otherwise */
+   char ur_armed; /**< Multishot recv() is active */
+   int32_t ur_buffer; /**< Provided buffer with data that was not copied yet, -1 if none */
+   uint32_t ur_offset; /**< Offset of the first byte of ur_buffer that was not copied */
+   uint32_t ur_length; /**< Number of bytes of ur_buffer that were not copied */
 } tcpip_receiver_private_t;
 
 /**
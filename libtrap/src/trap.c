@@ -61,6 +61,12 @@
 #include <sys/socket.h>
 #include <arpa/inet.h>
 #include <sys/ioctl.h>
+#include <sys/timerfd.h>
+#include <time.h>
+#include <endian.h>
+#ifdef HAVE_SYS_EPOLL_H
+#include <sys/epoll.h>
+#endif
 #include <stdint.h>
 #include <inttypes.h>
 #include <assert.h>
@@ -73,6 +79,8 @@
 #include "ifc_tcpip.h"
 #include "ifc_tcpip_internal.h"
 #include "ifc_file.h"
+#include "ifc_shm.h"
+#include "trap_compress.h"
 
 /**
  * Version of libtrap
@@ -103,6 +111,7 @@ char trap_ifc_type_supported[] = {
    TRAP_IFC_TYPE_UNIX,
    TRAP_IFC_TYPE_SERVICE,
    TRAP_IFC_TYPE_FILE,
+   TRAP_IFC_TYPE_SHM,
    0
 };
 
@@ -123,7 +132,6 @@ const char *trap_last_error_msg = NULL;
 #define ifcdir2str(type) (((type) == TRAPIFC_OUTPUT) ? "Output" : "Input")
 
 static inline char *get_param_by_delimiter(const char *source, char **dest, const char delimiter);
-static int compare_timeouts(const void *a, const void *b);
 int trap_ctx_multi_recv(trap_ctx_t *ctx, uint32_t ifc_mask, const void **data, uint16_t *size);
 void *service_thread_routine(void *arg);
 
@@ -172,7 +180,7 @@ int trap_check_buffer_content(void *buffer, uint32_t buffer_size)
    int errors = 0;
    void *check_mess_pointer;
    for (offset = 0, check_mess_header = check_mess_pointer = buffer;
-         ((offset < buffer_size) && (offset < TRAP_IFC_MESSAGEQ_SIZE));) {
+         (offset < buffer_size);) {
       check_mess_counter++;
       /* go to next size, skip header + payload */
       offset += sizeof(*check_mess_header) + (*check_mess_header);
@@ -188,37 +196,131 @@ int trap_check_buffer_content(void *buffer, uint32_t buffer_size)
 }
 
 /**
- * Read data from buffer or receive data into buffer if buffer is empty
+ * Replace compressed content of buffer of input interface by decompressed payload.
+ *
+ * The caller must hold ifc_mtx of the interface.
+ *
+ * \param[in,out] ifc  input interface
+ * \param[in,out] size  size of received frame, size of payload on return
+ * \return TRAP_E_OK on success, TRAP_E_MEMORY or TRAP_E_IO_ERROR (buffer is dropped)
+ */
+static int trap_decompress_input_buffer(trap_input_ifc_t *ifc, uint32_t *size)
+{
+   char *tmp;
+   int result;
+
+   if ((ifc->compress != NULL) && (ifc->compress->buffer_size < ifc->buffer_size)) {
+      /* output IFC announced bigger buffers */
+      trap_compress_destroy(ifc->compress);
+      ifc->compress = NULL;
+   }
+   if (ifc->compress == NULL) {
+      ifc->compress = trap_compress_create(ifc->codec, 0, ifc->buffer_size);
+      if (ifc->compress == NULL) {
+         VERBOSE(CL_ERROR, "Not enough memory for decompression of buffers.");
+         return TRAP_E_MEMORY;
+      }
+   }
+   result = trap_decompress_buffer(ifc->compress, (const unsigned char *) ifc->buffer, *size, size);
+   if (result == TRAP_E_OK) {
+      /* decompressed payload becomes the buffer of interface */
+      tmp = ifc->buffer;
+      ifc->buffer = (char *) ifc->compress->buffer;
+      ifc->compress->buffer = (unsigned char *) tmp;
+   }
+   return result;
+}
+
+/**
+ * Get current time of CLOCK_MONOTONIC in nanoseconds.
+ *
+ * \return current time
+ */
+static inline uint64_t trap_monotonic_ns(void)
+{
+   struct timespec ts;
+
+   clock_gettime(CLOCK_MONOTONIC, &ts);
+   return (uint64_t) ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+#ifdef ENABLE_HEADER_TIMESTAMP
+/**
+ * Get current time of CLOCK_REALTIME in microseconds (timestamp of buffer header).
+ *
+ * \return current time
+ */
+static inline uint64_t trap_realtime_us(void)
+{
+   struct timespec ts;
+
+   clock_gettime(CLOCK_REALTIME, &ts);
+   return (uint64_t) ts.tv_sec * 1000000ULL + ts.tv_nsec / 1000;
+}
+#endif
+
+/**
+ * Receive new data into buffer of input interface if the buffer is empty.
+ *
+ * The caller must hold ifc_mtx of the interface.
  *
  * \param[in,out] ctx   pointer to the private libtrap context data (trap_ctx_init())
  * \param[in] ifc_idx   index of input interface
- * \param[out] data     pointer to received message
- * \param[out] size     size of message
  * \param[in] timeout   TRAP_WAIT | TRAP_NO_WAIT | timeout
+ * \return TRAP_E_OK when there are data in buffer, result of recv() otherwise
  */
-static inline int trap_read_from_buffer(trap_ctx_priv_t *ctx, uint32_t ifc_idx, const void **data, uint16_t *size, int timeout)
+static inline int trap_fill_input_buffer(trap_ctx_priv_t *ctx, uint32_t ifc_idx, int timeout)
 {
-   int result = TRAP_E_TIMEOUT;
+   int result = TRAP_E_OK;
+   trap_in_counters_t *cnt;
+   uint64_t start;
    /* pointer to current message header */
    uint32_t tempbufheader = 0;
 
    /* pointer to current message payload */
    void *bp = ctx->in_ifc_list[ifc_idx].buffer;
-   pthread_mutex_lock(&ctx->in_ifc_list[ifc_idx].ifc_mtx);
-   if ((ctx->in_ifc_list[ifc_idx].buffer_full == 0) || (ctx->in_ifc_list[ifc_idx].buffer_full > TRAP_IFC_MESSAGEQ_SIZE)) {
+   if ((ctx->in_ifc_list[ifc_idx].buffer_full == 0) || (ctx->in_ifc_list[ifc_idx].buffer_full > ctx->in_ifc_list[ifc_idx].buffer_size)) {
       /* get new data and store into buffer, set buffer_full size */
       ctx->in_ifc_list[ifc_idx].buffer_pointer = ctx->in_ifc_list[ifc_idx].buffer;
+      cnt = trap_counters_in(&ctx->counters, ifc_idx);
+      start = trap_monotonic_ns();
       result = ctx->in_ifc_list[ifc_idx].recv(ctx->in_ifc_list[ifc_idx].priv, bp, &tempbufheader, timeout);
+      trap_hist_add(&cnt->wait, trap_monotonic_ns() - start);
       if (result == TRAP_E_FORMAT_MISMATCH) {
-         goto exit;
+         return result;
       }
 #ifdef BUFFERING_CHECK_HEADERS
+      /* negotiation in recv() may have reallocated the buffer */
+      bp = ctx->in_ifc_list[ifc_idx].buffer;
       if (trap_check_buffer_content(bp, tempbufheader) != 0) {
          VERBOSE(CL_ERROR, "Buffer is not valid.");
       }
 #endif
+      if ((result == TRAP_E_OK) && (ctx->in_ifc_list[ifc_idx].codec != TRAP_CODEC_NONE)) {
+         result = trap_decompress_input_buffer(&ctx->in_ifc_list[ifc_idx], &tempbufheader);
+      }
+      if ((result == TRAP_E_OK) && (ctx->in_ifc_list[ifc_idx].trace != 0)) {
+         /* decompression may have replaced the buffer */
+         if (tempbufheader >= TRAP_TRACE_SIZE) {
+            tempbufheader -= TRAP_TRACE_SIZE;
+            trap_trace_receive(&ctx->trace, cnt, (unsigned char *) ctx->in_ifc_list[ifc_idx].buffer + tempbufheader);
+         } else {
+            VERBOSE(CL_ERROR, "Received buffer of IFC %"PRIu32" has no trace record, buffer is dropped.", ifc_idx);
+            tempbufheader = 0;
+         }
+      }
       if (result == TRAP_E_OK) {
-         ctx->counter_recv_buffer[ifc_idx]++;
+         TRAP_CNT_ADD(cnt->buffers, 1);
+         TRAP_CNT_ADD(cnt->bytes, tempbufheader);
+#ifdef ENABLE_HEADER_TIMESTAMP
+         if ((ctx->in_ifc_list[ifc_idx].timestamp != 0) && (ctx->in_ifc_list[ifc_idx].trace == 0)) {
+            /* trace record gives latency from the first module of chain */
+            start = trap_realtime_us();
+            /* clocks of hosts may differ, negative latency is counted as 0 */
+            trap_hist_add(&cnt->latency, (start > ctx->in_ifc_list[ifc_idx].timestamp) ?
+                          start - ctx->in_ifc_list[ifc_idx].timestamp : 0);
+         }
+#endif
 
          ctx->in_ifc_list[ifc_idx].buffer_full = tempbufheader;
          ctx->in_ifc_list[ifc_idx].buffer_pointer = ctx->in_ifc_list[ifc_idx].buffer;
@@ -228,10 +330,29 @@ static inline int trap_read_from_buffer(trap_ctx_priv_t *ctx, uint32_t ifc_idx,
          #ifdef TESTBUFFERING
          VERBOSE(CL_VERBOSE_OFF, "Received buffer of size %u.", ctx->in_ifc_list[ifc_idx].buffer_full);
          #endif
-      } else {
-         goto exit;
       }
    }
+   return result;
+}
+
+/**
+ * Read data from buffer or receive data into buffer if buffer is empty
+ *
+ * \param[in,out] ctx   pointer to the private libtrap context data (trap_ctx_init())
+ * \param[in] ifc_idx   index of input interface
+ * \param[out] data     pointer to received message
+ * \param[out] size     size of message
+ * \param[in] timeout   TRAP_WAIT | TRAP_NO_WAIT | timeout
+ */
+static inline int trap_read_from_buffer(trap_ctx_priv_t *ctx, uint32_t ifc_idx, const void **data, uint16_t *size, int timeout)
+{
+   int result = TRAP_E_TIMEOUT;
+
+   pthread_mutex_lock(&ctx->in_ifc_list[ifc_idx].ifc_mtx);
+   result = trap_fill_input_buffer(ctx, ifc_idx, timeout);
+   if (result != TRAP_E_OK) {
+      goto exit;
+   }
 
    if (ctx->in_ifc_list[ifc_idx].buffer_full > 0) {
       /* get message from buffer */
@@ -252,25 +373,1327 @@ static inline int trap_read_from_buffer(trap_ctx_priv_t *ctx, uint32_t ifc_idx,
 exit:
    pthread_mutex_unlock(&ctx->in_ifc_list[ifc_idx].ifc_mtx);
    if (result == TRAP_E_OK) {
-      ctx->counter_recv_message[ifc_idx]++;
+      TRAP_CNT_ADD(trap_counters_in(&ctx->counters, ifc_idx)->messages, 1);
       if (ctx->in_ifc_list[ifc_idx].client_state == FMT_CHANGED) {
          ctx->in_ifc_list[ifc_idx].client_state = FMT_OK;
          return TRAP_E_FORMAT_CHANGED;
       }
    }
-   return result;
+   return result;
+}
+
+/**
+ * Read all messages that remain in buffer or receive data into buffer if buffer is empty
+ *
+ * Whole buffer is parsed under one lock and counters are updated once.
+ *
+ * \param[in,out] ctx   pointer to the private libtrap context data (trap_ctx_init())
+ * \param[in] ifc_idx   index of input interface
+ * \param[out] data     array of pointers to received messages
+ * \param[out] sizes    array of sizes of messages
+ * \param[in] max       size of data and sizes arrays
+ * \param[out] count    number of returned messages
+ * \param[in] timeout   TRAP_WAIT | TRAP_NO_WAIT | timeout
+ */
+static inline int trap_read_bulk_from_buffer(trap_ctx_priv_t *ctx, uint32_t ifc_idx, const void **data, uint16_t *sizes, uint32_t max, uint32_t *count, int timeout)
+{
+   int result = TRAP_E_TIMEOUT;
+   trap_input_ifc_t *ifc = &ctx->in_ifc_list[ifc_idx];
+   uint32_t n = 0, msize;
+
+   pthread_mutex_lock(&ifc->ifc_mtx);
+   result = trap_fill_input_buffer(ctx, ifc_idx, timeout);
+   if (result != TRAP_E_OK) {
+      goto exit;
+   }
+
+   while ((n < max) && (ifc->buffer_full > 0)) {
+      sizes[n] = *((uint16_t *) ifc->buffer_pointer);
+      msize = sizes[n] + sizeof(uint16_t);
+      if (msize > ifc->buffer_full) {
+         VERBOSE(CL_ERROR, "Malformed message header in buffer, rest of buffer is skipped.");
+         ifc->buffer_full = 0;
+         break;
+      }
+      data[n] = ifc->buffer_pointer + sizeof(uint16_t);
+      ifc->buffer_full -= msize;
+      ifc->buffer_pointer += msize;
+      n++;
+   }
+   DEBUG_BUF(VERBOSE(CL_VERBOSE_LIBRARY, "read %"PRIu32" messages from buffer, new bf %"PRIu32" %p",
+             n, ifc->buffer_full, ifc->buffer_pointer));
+exit:
+   pthread_mutex_unlock(&ifc->ifc_mtx);
+   (*count) = n;
+   if (result == TRAP_E_OK) {
+      TRAP_CNT_ADD(trap_counters_in(&ctx->counters, ifc_idx)->messages, n);
+      if (ifc->client_state == FMT_CHANGED) {
+         ifc->client_state = FMT_OK;
+         return TRAP_E_FORMAT_CHANGED;
+      }
+   }
+   return result;
+}
+
+/**
+ * Get space for messages in buffer of output interface.
+ *
+ * \param[in] o  output interface
+ * \return size of payload of full buffer, trace record is excluded
+ */
+static inline uint32_t trap_buffer_capacity(const trap_output_ifc_t *o)
+{
+   return o->buffer_size - sizeof(trap_buffer_header_t) - (o->trace ? TRAP_TRACE_SIZE : 0);
+}
+
+/**
+ * Get free space in the current buffer of output interface.
+ *
+ * Buffer is sent when the next message does not fit into flush_limit,
+ * an empty buffer accepts every message that fits into its capacity.
+ *
+ * \param[in] o  output interface
+ * \return number of free bytes
+ */
+static inline uint32_t trap_buffer_freespace(const trap_output_ifc_t *o)
+{
+   uint32_t limit = (o->buffer_index == 0) ? trap_buffer_capacity(o) : o->flush_limit;
+
+   return (o->buffer_index < limit) ? limit - o->buffer_index : 0;
+}
+
+/**
+ * Adapt flush_limit of output interface with "bufsize=auto" to rate of messages.
+ *
+ * Rate is taken from the current buffer: its payload and time since its
+ * first message (autoflush deadline minus timeout).  The limit moves towards
+ * the payload that arrives in 1/#TRAP_IFC_ADAPT_FILL_DIV of autoflush timeout,
+ * so buffers grow with high rate (fewer syscalls) and shrink with low rate
+ * (shorter delay of messages).  Without autoflush the limit is not changed.
+ *
+ * The caller must hold ifc_mtx of the interface, it is called when the
+ * current buffer is going to be sent.
+ *
+ * \param[in,out] o  output interface
+ */
+static inline void trap_buffer_adapt(trap_output_ifc_t *o)
+{
+   uint64_t timeout_ns, fill_ns, limit, now;
+
+   if ((o->buffer_adaptive == 0) || (o->flush_deadline == 0) || (o->timeout <= 0)) {
+      return;
+   }
+   now = trap_monotonic_ns();
+   timeout_ns = (uint64_t) o->timeout * 1000;
+   fill_ns = (now + timeout_ns > o->flush_deadline) ? now + timeout_ns - o->flush_deadline : 0;
+   if (fill_ns == 0) {
+      limit = trap_buffer_capacity(o);
+   } else {
+      limit = (uint64_t) o->buffer_index * (timeout_ns / TRAP_IFC_ADAPT_FILL_DIV) / fill_ns;
+   }
+   if (limit > trap_buffer_capacity(o)) {
+      limit = trap_buffer_capacity(o);
+   } else if (limit < TRAP_IFC_ADAPT_MIN) {
+      limit = TRAP_IFC_ADAPT_MIN;
+   }
+   /* smooth changes, a single burst or pause does not switch the size */
+   o->flush_limit = (3 * (uint64_t) o->flush_limit + limit) / 4;
+}
+
+static void insert_into_buffer(trap_output_ifc_t *priv, const void *data, const uint16_t size)
+{
+   assert(priv->buffer_index <= trap_buffer_capacity(priv));
+   if (priv->buffer_occupied == 0) {
+      uint16_t *msize = (uint16_t *) &priv->buffer[priv->buffer_index];
+      (*msize) = size;
+      memcpy((void *) (msize + 1), data, size);
+      priv->buffer_index += size + sizeof size;
+   }
+}
+
+/**
+ * Pass buffer to send() of output interface, compress it first if it is enabled.
+ *
+ * Sent buffers, bytes, fill ratio and time spent in send() are counted here
+ * for all ways of sending.  Trace record is appended here when tracing is
+ * enabled, buffers have space for it (see trap_buffer_capacity()).
+ *
+ * The caller must hold ifc_mtx of the interface or be the sender thread of pool.
+ *
+ * \param[in,out] ctx   pointer to the private libtrap context data (trap_ctx_init())
+ * \param[in] ifc  index of output interface
+ * \param[in] buffer_header  buffer header followed by payload
+ * \param[in] size  size of buffer incl. header
+ * \param[in] timeout  TRAP_WAIT | TRAP_NO_WAIT | timeout
+ * \return result of send() of the interface
+ */
+static inline int trap_ifc_send_buffer(trap_ctx_priv_t *ctx, uint32_t ifc, unsigned char *buffer_header, uint32_t size, int timeout)
+{
+   trap_output_ifc_t *o = &ctx->out_ifc_list[ifc];
+   trap_out_counters_t *cnt = trap_counters_out(&ctx->counters, ifc);
+   trap_buffer_header_t *hdr = (trap_buffer_header_t *) buffer_header;
+   uint32_t payload = size - sizeof(trap_buffer_header_t);
+   uint32_t fill;
+   uint64_t start;
+   int result;
+
+#ifdef ENABLE_HEADER_TIMESTAMP
+   hdr->timestamp = htobe64(trap_realtime_us());
+#endif
+   if ((o->pool == NULL) && (o->mpsc == NULL)) {
+      /* synchronous sending, the caller holds ifc_mtx */
+      trap_buffer_adapt(o);
+   }
+   if (o->trace) {
+      trap_trace_stamp(&ctx->trace, buffer_header + size);
+      size += TRAP_TRACE_SIZE;
+      hdr->data_length = htonl(payload + TRAP_TRACE_SIZE);
+   }
+   start = trap_monotonic_ns();
+   if (o->compress == NULL) {
+      result = o->send(o->priv, buffer_header, size, timeout);
+   } else {
+      size = trap_compress_buffer(o->compress, buffer_header, size);
+      result = o->send(o->priv, o->compress->buffer, size, timeout);
+      if ((result != TRAP_E_TIMEOUT) || (o->pool != NULL) || (o->mpsc != NULL)) {
+         /* unsent buffer is kept for the next attempt in synchronous mode only */
+         trap_compress_release(o->compress);
+      }
+   }
+   trap_hist_add(&cnt->wait, trap_monotonic_ns() - start);
+   if (o->trace) {
+      /* buffer can be sent again or its messages counted as dropped */
+      hdr->data_length = htonl(payload);
+   }
+   if (result == TRAP_E_OK) {
+      fill = (uint64_t) payload * TRAP_FILL_BUCKETS / trap_buffer_capacity(o);
+      TRAP_CNT_ADD(cnt->buffers, 1);
+      TRAP_CNT_ADD(cnt->bytes, payload);
+      TRAP_CNT_ADD(cnt->fill[(fill < TRAP_FILL_BUCKETS) ? fill : TRAP_FILL_BUCKETS - 1], 1);
+   }
+   return result;
+}
+
+/**
+ * Count messages stored in a buffer (used to update counter of dropped messages).
+ *
+ * \param[in] buffer_header  buffer with header followed by payload
+ * \return number of messages
+ */
+static uint32_t trap_count_buffer_messages(const unsigned char *buffer_header)
+{
+   const trap_buffer_header_t *h = (const trap_buffer_header_t *) buffer_header;
+   uint32_t data_length = ntohl(h->data_length);
+   uint32_t i = 0, count = 0;
+
+   while (i + sizeof(uint16_t) <= data_length) {
+      i += sizeof(uint16_t) + *((const uint16_t *) &h->data[i]);
+      count++;
+   }
+   return count;
+}
+
+/**
+ * Sender thread of output interface with pool of buffers.
+ *
+ * Thread takes full buffers from the queue and sends them using send() of
+ * the interface, sent or dropped buffers are returned into free_list.
+ * Thread exits when termination is requested and the queue is empty.
+ *
+ * \param[in] arg  pointer to trap_buffer_pool_t
+ * \return NULL
+ */
+static void *trap_buffer_pool_sender_thr(void *arg)
+{
+   trap_buffer_pool_t *p = (trap_buffer_pool_t *) arg;
+   trap_ctx_priv_t *ctx = (trap_ctx_priv_t *) p->ctx;
+   trap_output_ifc_t *o = &ctx->out_ifc_list[p->ifc];
+   trap_pool_item_t item;
+   int result;
+
+   pthread_mutex_lock(&p->lock);
+   while (1) {
+      while ((p->queue_count == 0) && (p->terminate == 0)) {
+         pthread_cond_wait(&p->cond_queued, &p->lock);
+      }
+      if (p->queue_count == 0) {
+         /* termination was requested and there is nothing to send */
+         break;
+      }
+      item = p->queue[p->queue_head];
+      p->queue_head = (p->queue_head + 1) % p->count;
+      p->queue_count--;
+      p->in_flight = 1;
+      pthread_mutex_unlock(&p->lock);
+
+      DEBUG_BUF(VERBOSE(CL_VERBOSE_LIBRARY, "sender thread: sending %"PRIu32" B from %p", item.size, item.buffer_header));
+      result = trap_ifc_send_buffer(ctx, p->ifc, item.buffer_header, item.size, o->datatimeout);
+
+      pthread_mutex_lock(&p->lock);
+      if (result != TRAP_E_OK) {
+         p->dropped_messages += trap_count_buffer_messages(item.buffer_header);
+         if (result != TRAP_E_TERMINATED) {
+            VERBOSE(CL_VERBOSE_LIBRARY, "Sender thread of ifc %"PRIu32" dropped buffer (%d).", p->ifc, result);
+         }
+      }
+      p->free_list[p->free_count++] = item.buffer_header;
+      p->in_flight = 0;
+      pthread_cond_broadcast(&p->cond_released);
+   }
+   pthread_mutex_unlock(&p->lock);
+
+   pthread_exit(NULL);
+}
+
+/**
+ * Create pool of buffers and start sender thread of output interface.
+ *
+ * The current buffer of interface becomes the first buffer of the pool,
+ * pool_size - 1 buffers are allocated.
+ *
+ * \param[in,out] ctx   pointer to the private libtrap context data (trap_ctx_init())
+ * \param[in] ifc       index of output interface
+ * \return TRAP_E_OK on success, TRAP_E_MEMORY on error
+ */
+static int trap_buffer_pool_create(trap_ctx_priv_t *ctx, unsigned int ifc)
+{
+   trap_output_ifc_t *o = &ctx->out_ifc_list[ifc];
+   trap_buffer_pool_t *p;
+   uint32_t i;
+
+   p = (trap_buffer_pool_t *) calloc(1, sizeof(trap_buffer_pool_t));
+   if (p == NULL) {
+      return trap_errorf(ctx, TRAP_E_MEMORY, "Not enough memory for pool of output buffers.");
+   }
+   p->count = o->pool_size;
+   p->ctx = ctx;
+   p->ifc = ifc;
+   p->buffers = (unsigned char **) calloc(p->count, sizeof(unsigned char *));
+   p->free_list = (unsigned char **) calloc(p->count, sizeof(unsigned char *));
+   p->queue = (trap_pool_item_t *) calloc(p->count, sizeof(trap_pool_item_t));
+   if ((p->buffers == NULL) || (p->free_list == NULL) || (p->queue == NULL)) {
+      goto free_pool;
+   }
+   for (i = 1; i < p->count; i++) {
+      p->buffers[i] = (unsigned char *) calloc(1, o->buffer_size + sizeof(trap_buffer_header_t) + 1);
+      if (p->buffers[i] == NULL) {
+         goto free_buffers;
+      }
+      p->free_list[p->free_count++] = p->buffers[i];
+   }
+   if (pthread_mutex_init(&p->lock, NULL) != 0) {
+      goto free_buffers;
+   }
+   if (pthread_cond_init(&p->cond_queued, NULL) != 0) {
+      goto free_mutex;
+   }
+   if (pthread_cond_init(&p->cond_released, NULL) != 0) {
+      goto free_cond_queued;
+   }
+   if (pthread_create(&p->thread, NULL, trap_buffer_pool_sender_thr, (void *) p) != 0) {
+      goto free_cond_released;
+   }
+   p->buffers[0] = o->buffer_header;
+   o->pool = p;
+   VERBOSE(CL_VERBOSE_LIBRARY, "Output ifc %u uses %"PRIu32" buffers and sender thread.", ifc, p->count);
+   return TRAP_E_OK;
+
+free_cond_released:
+   pthread_cond_destroy(&p->cond_released);
+free_cond_queued:
+   pthread_cond_destroy(&p->cond_queued);
+free_mutex:
+   pthread_mutex_destroy(&p->lock);
+free_buffers:
+   for (i = 1; i < p->count; i++) {
+      free(p->buffers[i]);
+   }
+free_pool:
+   free(p->buffers);
+   free(p->free_list);
+   free(p->queue);
+   free(p);
+   return trap_errorf(ctx, TRAP_E_MEMORY, "Creation of pool of output buffers failed.");
+}
+
+/**
+ * Announce buffers of output interface to the IFC (see ifc_register_buffers_func_t).
+ *
+ * It passes the buffers of pool (or the only buffer) and the buffer of
+ * compression.  Staging buffers of multiple producers are created later
+ * by producer threads, so they are not announced.
+ *
+ * \param[in] o  output interface
+ */
+static void trap_output_register_buffers(trap_output_ifc_t *o)
+{
+   struct iovec *iov;
+   uint32_t i, count = 0, size = o->buffer_size + sizeof(trap_buffer_header_t) + 1;
+
+   if (o->register_buffers == NULL) {
+      return;
+   }
+   iov = (struct iovec *) calloc((o->pool != NULL ? o->pool->count : 1) + 1, sizeof(struct iovec));
+   if (iov == NULL) {
+      return;
+   }
+   if (o->pool != NULL) {
+      for (i = 0; i < o->pool->count; i++) {
+         iov[count].iov_base = o->pool->buffers[i];
+         iov[count++].iov_len = size;
+      }
+   } else {
+      iov[count].iov_base = o->buffer_header;
+      iov[count++].iov_len = size;
+   }
+   if (o->compress != NULL) {
+      iov[count].iov_base = o->compress->buffer;
+      iov[count++].iov_len = size;
+   }
+   o->register_buffers(o->priv, iov, count);
+   free(iov);
+}
+
+/**
+ * Stop sender thread and free pool of buffers of output interface.
+ *
+ * Buffers that are still queued are passed to send() of the interface
+ * before the thread exits, i.e. the interface should be terminated first
+ * unless the queue is empty.  All buffers including the current one
+ * (buffer_header) are freed.
+ *
+ * \param[in,out] o  output interface
+ */
+static void trap_buffer_pool_destroy(trap_output_ifc_t *o)
+{
+   trap_buffer_pool_t *p = o->pool;
+   uint32_t i;
+
+   if (p == NULL) {
+      return;
+   }
+   pthread_mutex_lock(&p->lock);
+   p->terminate = 1;
+   pthread_cond_broadcast(&p->cond_queued);
+   pthread_mutex_unlock(&p->lock);
+   pthread_join(p->thread, NULL);
+
+   for (i = 0; i < p->count; i++) {
+      free(p->buffers[i]);
+   }
+   o->buffer_header = NULL;
+   o->buffer = NULL;
+   pthread_cond_destroy(&p->cond_released);
+   pthread_cond_destroy(&p->cond_queued);
+   pthread_mutex_destroy(&p->lock);
+   free(p->buffers);
+   free(p->free_list);
+   free(p->queue);
+   free(p);
+   o->pool = NULL;
+}
+
+/**
+ * Hand the current buffer over to the sender thread and continue with an empty one.
+ *
+ * The caller must hold ifc_mtx of the interface.  When all buffers of the
+ * pool are queued, it waits for a buffer released by the sender thread
+ * according to timeout.
+ *
+ * \param[in,out] ctx   pointer to the private libtrap context data (trap_ctx_init())
+ * \param[in] ifc       index of output interface
+ * \param[in] timeout   TRAP_WAIT | TRAP_NO_WAIT | timeout, TRAP_HALFWAIT waits as TRAP_WAIT
+ * \return TRAP_E_OK when the buffer was queued (or it was empty),
+ * TRAP_E_TIMEOUT when there is no free buffer, the current buffer is left untouched,
+ * TRAP_E_TERMINATED when there is no free buffer and libtrap was terminated.
+ */
+static int trap_buffer_pool_handoff(trap_ctx_priv_t *ctx, unsigned int ifc, int timeout)
+{
+   trap_output_ifc_t *o = &ctx->out_ifc_list[ifc];
+   trap_buffer_pool_t *p = o->pool;
+   trap_buffer_header_t *h = (trap_buffer_header_t *) o->buffer_header;
+   struct timespec deadline;
+   uint32_t tail;
+   int result = TRAP_E_OK;
+
+   if (o->buffer_index == 0) {
+      return TRAP_E_OK;
+   }
+   if (timeout > 0) {
+      clock_gettime(CLOCK_REALTIME, &deadline);
+      deadline.tv_sec += timeout / 1000000;
+      deadline.tv_nsec += (long) (timeout % 1000000) * 1000;
+      if (deadline.tv_nsec >= 1000000000) {
+         deadline.tv_sec++;
+         deadline.tv_nsec -= 1000000000;
+      }
+   }
+
+   pthread_mutex_lock(&p->lock);
+   while (p->free_count == 0) {
+      if (ctx->terminated != 0) {
+         result = TRAP_E_TERMINATED;
+         goto unlock;
+      } else if (timeout == TRAP_NO_WAIT) {
+         result = TRAP_E_TIMEOUT;
+         goto unlock;
+      } else if (timeout > 0) {
+         if ((pthread_cond_timedwait(&p->cond_released, &p->lock, &deadline) == ETIMEDOUT) && (p->free_count == 0)) {
+            result = TRAP_E_TIMEOUT;
+            goto unlock;
+         }
+      } else {
+         pthread_cond_wait(&p->cond_released, &p->lock);
+      }
+   }
+
+   trap_buffer_adapt(o);
+   h->data_length = htonl(o->buffer_index);
+   tail = (p->queue_head + p->queue_count) % p->count;
+   p->queue[tail].buffer_header = o->buffer_header;
+   p->queue[tail].size = o->buffer_index + sizeof(trap_buffer_header_t);
+   p->queue_count++;
+   pthread_cond_signal(&p->cond_queued);
+
+   o->buffer_header = p->free_list[--p->free_count];
+   o->buffer = ((trap_buffer_header_t *) o->buffer_header)->data;
+   o->buffer_index = 0;
+   o->flush_deadline = 0;
+
+unlock:
+   /* counters are updated by module's thread only */
+   TRAP_CNT_ADD(trap_counters_out(&ctx->counters, ifc)->dropped, p->dropped_messages);
+   p->dropped_messages = 0;
+   pthread_mutex_unlock(&p->lock);
+   return result;
+}
+
+/**
+ * Wait until the sender thread sends all queued buffers.
+ *
+ * \param[in] p  pool of output buffers
+ */
+static void trap_buffer_pool_wait_sent(trap_buffer_pool_t *p)
+{
+   pthread_mutex_lock(&p->lock);
+   while ((p->queue_count != 0) || (p->in_flight != 0)) {
+      pthread_cond_wait(&p->cond_released, &p->lock);
+   }
+   pthread_mutex_unlock(&p->lock);
+}
+
+/**
+ * Send the current content of output buffer and reset it.
+ *
+ * The caller must hold ifc_mtx of the interface.  The buffer is emptied
+ * when it was sent (TRAP_E_OK) or when there is no client to receive it
+ * (TRAP_E_IO_ERROR), otherwise it stays untouched for the next attempt.
+ *
+ * \param[in,out] ctx   pointer to the private libtrap context data (trap_ctx_init())
+ * \param[in] ifc       index of output interface
+ * \param[in] timeout   TRAP_WAIT | TRAP_NO_WAIT | timeout
+ * \return result of send() of the interface, TRAP_E_OK for an empty buffer
+ */
+static inline int trap_send_whole_buffer(trap_ctx_priv_t *ctx, unsigned int ifc, int timeout)
+{
+   trap_output_ifc_t *o = &ctx->out_ifc_list[ifc];
+   trap_buffer_header_t *h = (trap_buffer_header_t *) o->buffer_header;
+   int result;
+
+   if (o->buffer_index == 0) {
+      o->buffer_occupied = 0;
+      return TRAP_E_OK;
+   }
+   if (o->pool != NULL) {
+      return trap_buffer_pool_handoff(ctx, ifc, timeout);
+   }
+
+   o->buffer_occupied = 1;
+   h->data_length = htonl(o->buffer_index);
+   result = trap_ifc_send_buffer(ctx, ifc, o->buffer_header, o->buffer_index + sizeof(trap_buffer_header_t), timeout);
+
+   if (result == TRAP_E_OK || result == TRAP_E_IO_ERROR) {
+      o->buffer_index = 0;
+      o->buffer_occupied = 0;
+      o->flush_deadline = 0;
+   } else if (trap_ctx_get_client_count(ctx, ifc) == 0) {
+      o->buffer_occupied = 0;
+   }
+   return result;
+}
+
+/**
+ * \defgroup autoflush Autoflush of output buffers
+ *
+ * Every output interface with autoflush enabled has an absolute deadline
+ * (flush_deadline) that is set when the first message is stored into its
+ * empty buffer and cleared whenever the buffer is sent.  The autoflush
+ * thread sleeps on a timerfd armed to the nearest deadline of all
+ * interfaces, so a message never waits in a partially filled buffer longer
+ * than the autoflush timeout of its interface.
+ * @{
+ */
+
+/**
+ * Arm the autoflush timer to the deadline unless it is already armed to an earlier time.
+ *
+ * \param[in,out] ctx   pointer to the private libtrap context data (trap_ctx_init())
+ * \param[in] deadline  absolute time (CLOCK_MONOTONIC, ns)
+ */
+static void trap_autoflush_arm(trap_ctx_priv_t *ctx, uint64_t deadline)
+{
+   struct itimerspec its;
+
+   if (ctx->autoflush_fd == -1) {
+      return;
+   }
+   pthread_mutex_lock(&ctx->autoflush_mtx);
+   if (deadline < ctx->autoflush_next) {
+      ctx->autoflush_next = deadline;
+      memset(&its, 0, sizeof(its));
+      its.it_value.tv_sec = deadline / 1000000000ULL;
+      its.it_value.tv_nsec = deadline % 1000000000ULL;
+      if (timerfd_settime(ctx->autoflush_fd, TFD_TIMER_ABSTIME, &its, NULL) != 0) {
+         VERBOSE(CL_ERROR, "Arming of autoflush timer failed: %s", strerror(errno));
+      }
+   }
+   pthread_mutex_unlock(&ctx->autoflush_mtx);
+}
+
+/**
+ * Schedule autoflush of the output buffer if it contains data and no flush is scheduled yet.
+ *
+ * The caller must hold ifc_mtx of the interface.
+ *
+ * \param[in,out] ctx   pointer to the private libtrap context data (trap_ctx_init())
+ * \param[in] ifc       index of output interface
+ */
+static inline void trap_autoflush_schedule(trap_ctx_priv_t *ctx, unsigned int ifc)
+{
+   trap_output_ifc_t *o = &ctx->out_ifc_list[ifc];
+
+   if ((o->flush_deadline != 0) || (o->buffer_index == 0) ||
+       (o->timeout == TRAP_NO_AUTO_FLUSH) || (o->bufferswitch == 0)) {
+      return;
+   }
+   o->flush_deadline = trap_monotonic_ns() + (uint64_t) o->timeout * 1000;
+   trap_autoflush_arm(ctx, o->flush_deadline);
+}
+
+/**
+ * Send the buffer of output interface if its autoflush deadline has elapsed.
+ *
+ * Interface locked by module (sending or trap_ctx_send_reserve()) is
+ * skipped and checked again after TRAP_AUTOFLUSH_RETRY.  When the buffer
+ * could not be sent, the next attempt is made after the autoflush timeout.
+ *
+ * \param[in,out] ctx   pointer to the private libtrap context data (trap_ctx_init())
+ * \param[in] ifc       index of output interface
+ * \param[in] now       current time (CLOCK_MONOTONIC, ns)
+ * \return the next deadline of the interface, 0 if there is none
+ */
+static uint64_t trap_autoflush_ifc(trap_ctx_priv_t *ctx, unsigned int ifc, uint64_t now)
+{
+   trap_output_ifc_t *o = &ctx->out_ifc_list[ifc];
+   uint64_t deadline;
+   int result;
+
+   if (pthread_mutex_trylock(&o->ifc_mtx) != 0) {
+      /* unlocked read is only a hint, module reschedules the flush itself when the buffer is sent */
+      deadline = o->flush_deadline;
+      if ((deadline != 0) && (deadline <= now)) {
+         deadline = now + TRAP_AUTOFLUSH_RETRY * 1000ULL;
+      }
+      return deadline;
+   }
+   deadline = o->flush_deadline;
+   if ((deadline == 0) || (o->buffer_index == 0) || (o->timeout == TRAP_NO_AUTO_FLUSH)) {
+      o->flush_deadline = 0;
+      deadline = 0;
+   } else if (deadline <= now) {
+      DEBUG_BUF(VERBOSE(CL_VERBOSE_LIBRARY, "sending by autoflush %"PRIu32" B from %p", o->buffer_index, o->buffer));
+      result = trap_send_whole_buffer(ctx, ifc, o->datatimeout);
+      if (result == TRAP_E_OK) {
+         TRAP_CNT_ADD(trap_counters_out(&ctx->counters, ifc)->autoflushes, 1);
+      } else {
+         VERBOSE(CL_VERBOSE_LIBRARY, "Autoflush was not successful.");
+      }
+      if (o->buffer_index != 0) {
+         o->flush_deadline = now + (uint64_t) o->timeout * 1000;
+      }
+      deadline = o->flush_deadline;
+   }
+   pthread_mutex_unlock(&o->ifc_mtx);
+   return deadline;
+}
+
+/**
+ * @}
+ */
+
+/**
+ * \defgroup mpsc Multi-producer sending
+ *
+ * Output interface with setter "mpsc=N" can be used by trap_ctx_send() from
+ * many threads without serialization on ifc_mtx.  Every thread stores
+ * messages into its own stage of N buffers (see trap_mpsc_stage_t), full
+ * buffers are queued into a lock-free MPSC queue and sent by a sender thread
+ * of the interface.  Messages of one thread are sent in order, messages of
+ * different threads are interleaved by whole buffers.
+ * @{
+ */
+
+/**
+ * Append item to MPSC queue, it can be called by many threads concurrently.
+ *
+ * \param[in,out] m  multi-producer sending of output interface
+ * \param[in] item   item to append
+ */
+static inline void trap_mpsc_push(trap_mpsc_t *m, trap_mpsc_item_t *item)
+{
+   trap_mpsc_item_t *prev;
+
+   __atomic_store_n(&item->next, NULL, __ATOMIC_RELAXED);
+   prev = __atomic_exchange_n(&m->head, item, __ATOMIC_ACQ_REL);
+   /* the queue is disconnected until the next line, pop sees it as empty meanwhile */
+   __atomic_store_n(&prev->next, item, __ATOMIC_RELEASE);
+}
+
+/**
+ * Take the oldest item from MPSC queue, it can be called by the sender thread only.
+ *
+ * \param[in,out] m  multi-producer sending of output interface
+ * \return item or NULL when the queue is empty or a producer has not finished trap_mpsc_push() yet
+ */
+static trap_mpsc_item_t *trap_mpsc_pop(trap_mpsc_t *m)
+{
+   trap_mpsc_item_t *tail = m->tail;
+   trap_mpsc_item_t *next = __atomic_load_n(&tail->next, __ATOMIC_ACQUIRE);
+
+   if (tail == &m->stub) {
+      if (next == NULL) {
+         return NULL;
+      }
+      m->tail = next;
+      tail = next;
+      next = __atomic_load_n(&tail->next, __ATOMIC_ACQUIRE);
+   }
+   if (next != NULL) {
+      m->tail = next;
+      return tail;
+   }
+   if (tail != __atomic_load_n(&m->head, __ATOMIC_ACQUIRE)) {
+      return NULL;
+   }
+   /* tail is the last item, put stub behind it to be able to take it */
+   trap_mpsc_push(m, &m->stub);
+   next = __atomic_load_n(&tail->next, __ATOMIC_ACQUIRE);
+   if (next != NULL) {
+      m->tail = next;
+      return tail;
+   }
+   return NULL;
+}
+
+/**
+ * Wake up threads waiting for a buffer returned by the sender thread.
+ *
+ * \param[in,out] m  multi-producer sending of output interface
+ */
+static inline void trap_mpsc_wake_producers(trap_mpsc_t *m)
+{
+   if (__atomic_load_n(&m->producers_waiting, __ATOMIC_SEQ_CST) != 0) {
+      pthread_mutex_lock(&m->lock);
+      pthread_cond_broadcast(&m->cond_released);
+      pthread_mutex_unlock(&m->lock);
+   }
+}
+
+/**
+ * Sender thread of output interface with multi-producer sending.
+ *
+ * Thread takes buffers from MPSC queue, sends them using send() of the
+ * interface and returns them to their stages.  It exits when termination is
+ * requested and the queue is empty.
+ *
+ * \param[in] arg  pointer to trap_mpsc_t
+ * \return NULL
+ */
+static void *trap_mpsc_sender_thr(void *arg)
+{
+   trap_mpsc_t *m = (trap_mpsc_t *) arg;
+   trap_ctx_priv_t *ctx = (trap_ctx_priv_t *) m->ctx;
+   trap_output_ifc_t *o = &ctx->out_ifc_list[m->ifc];
+   trap_mpsc_item_t *item;
+   int result;
+
+   while (1) {
+      item = trap_mpsc_pop(m);
+      if (item == NULL) {
+         pthread_mutex_lock(&m->lock);
+         /* producer that queues a buffer after this store wakes us up */
+         __atomic_store_n(&m->sender_waiting, 1, __ATOMIC_SEQ_CST);
+         __atomic_thread_fence(__ATOMIC_SEQ_CST);
+         item = trap_mpsc_pop(m);
+         if (item == NULL) {
+            if (m->terminate != 0) {
+               pthread_mutex_unlock(&m->lock);
+               break;
+            }
+            pthread_cond_wait(&m->cond_queued, &m->lock);
+         }
+         __atomic_store_n(&m->sender_waiting, 0, __ATOMIC_SEQ_CST);
+         pthread_mutex_unlock(&m->lock);
+         if (item == NULL) {
+            continue;
+         }
+      }
+
+      DEBUG_BUF(VERBOSE(CL_VERBOSE_LIBRARY, "mpsc sender thread: sending %"PRIu32" B from %p", item->size, item->buffer_header));
+      result = trap_ifc_send_buffer(ctx, m->ifc, item->buffer_header, item->size, o->datatimeout);
+      if (result != TRAP_E_OK) {
+         TRAP_CNT_ADD(trap_counters_out(&ctx->counters, m->ifc)->dropped, item->messages);
+         if (result != TRAP_E_TERMINATED) {
+            VERBOSE(CL_VERBOSE_LIBRARY, "Sender thread of ifc %"PRIu32" dropped buffer (%d).", m->ifc, result);
+         }
+      }
+      __atomic_store_n(&item->busy, 0, __ATOMIC_SEQ_CST);
+      __atomic_sub_fetch(&m->pending, 1, __ATOMIC_SEQ_CST);
+      trap_mpsc_wake_producers(m);
+   }
+
+   pthread_exit(NULL);
+}
+
+/**
+ * Hand the current buffer of stage over to the sender thread.
+ *
+ * The caller must hold lock of the stage.  The next buffer of the stage
+ * becomes current, it can be still busy (see trap_mpsc_wait_item()).
+ *
+ * \param[in,out] m  multi-producer sending of output interface
+ * \param[in,out] s  stage
+ */
+static void trap_mpsc_submit(trap_mpsc_t *m, trap_mpsc_stage_t *s)
+{
+   trap_ctx_priv_t *ctx = (trap_ctx_priv_t *) m->ctx;
+   trap_mpsc_item_t *item = &s->items[s->current];
+   trap_buffer_header_t *h = (trap_buffer_header_t *) item->buffer_header;
+
+   if (s->buffer_index == 0) {
+      return;
+   }
+   h->data_length = htonl(s->buffer_index);
+   item->size = s->buffer_index + sizeof(trap_buffer_header_t);
+   item->messages = s->messages;
+   __atomic_store_n(&item->busy, 1, __ATOMIC_RELAXED);
+   TRAP_CNT_ADD(trap_counters_out(&ctx->counters, m->ifc)->messages, s->messages);
+   __atomic_add_fetch(&m->pending, 1, __ATOMIC_SEQ_CST);
+   trap_mpsc_push(m, item);
+
+   s->current = (s->current + 1) % s->count;
+   s->buffer_index = 0;
+   s->messages = 0;
+   __atomic_store_n(&s->flush_deadline, 0, __ATOMIC_RELAXED);
+
+   /* pairs with the store of sender_waiting before the sender thread checks the queue again */
+   __atomic_thread_fence(__ATOMIC_SEQ_CST);
+   if (__atomic_load_n(&m->sender_waiting, __ATOMIC_SEQ_CST) != 0) {
+      pthread_mutex_lock(&m->lock);
+      pthread_cond_signal(&m->cond_queued);
+      pthread_mutex_unlock(&m->lock);
+   }
+}
+
+/**
+ * Wait until the sender thread returns a buffer of stage.
+ *
+ * \param[in] ctx      pointer to the private libtrap context data (trap_ctx_init())
+ * \param[in,out] m    multi-producer sending of output interface
+ * \param[in] item     buffer of stage
+ * \param[in] timeout  TRAP_WAIT | TRAP_NO_WAIT | timeout, TRAP_HALFWAIT waits as TRAP_WAIT
+ * \return TRAP_E_OK, TRAP_E_TIMEOUT or TRAP_E_TERMINATED
+ */
+static int trap_mpsc_wait_item(trap_ctx_priv_t *ctx, trap_mpsc_t *m, trap_mpsc_item_t *item, int timeout)
+{
+   struct timespec deadline;
+   int result = TRAP_E_OK;
+
+   if (__atomic_load_n(&item->busy, __ATOMIC_ACQUIRE) == 0) {
+      return TRAP_E_OK;
+   }
+   if (timeout == TRAP_NO_WAIT) {
+      return TRAP_E_TIMEOUT;
+   }
+   if (timeout > 0) {
+      clock_gettime(CLOCK_REALTIME, &deadline);
+      deadline.tv_sec += timeout / 1000000;
+      deadline.tv_nsec += (long) (timeout % 1000000) * 1000;
+      if (deadline.tv_nsec >= 1000000000) {
+         deadline.tv_sec++;
+         deadline.tv_nsec -= 1000000000;
+      }
+   }
+
+   __atomic_add_fetch(&m->producers_waiting, 1, __ATOMIC_SEQ_CST);
+   pthread_mutex_lock(&m->lock);
+   while (__atomic_load_n(&item->busy, __ATOMIC_SEQ_CST) != 0) {
+      if (ctx->terminated != 0) {
+         result = TRAP_E_TERMINATED;
+         break;
+      } else if (timeout > 0) {
+         if ((pthread_cond_timedwait(&m->cond_released, &m->lock, &deadline) == ETIMEDOUT) &&
+             (__atomic_load_n(&item->busy, __ATOMIC_SEQ_CST) != 0)) {
+            result = TRAP_E_TIMEOUT;
+            break;
+         }
+      } else {
+         pthread_cond_wait(&m->cond_released, &m->lock);
+      }
+   }
+   pthread_mutex_unlock(&m->lock);
+   __atomic_sub_fetch(&m->producers_waiting, 1, __ATOMIC_SEQ_CST);
+   return result;
+}
+
+/**
+ * Allocate stage of buffers for a producer thread.
+ *
+ * \param[in] m  multi-producer sending of output interface
+ * \return new stage or NULL on error
+ */
+static trap_mpsc_stage_t *trap_mpsc_stage_create(trap_mpsc_t *m)
+{
+   trap_output_ifc_t *o = &((trap_ctx_priv_t *) m->ctx)->out_ifc_list[m->ifc];
+   trap_mpsc_stage_t *s;
+   uint32_t i;
+
+   if (posix_memalign((void **) &s, 64, sizeof(trap_mpsc_stage_t)) != 0) {
+      return NULL;
+   }
+   memset(s, 0, sizeof(trap_mpsc_stage_t));
+   s->count = m->stage_buffers;
+   s->mpsc = m;
+   s->items = (trap_mpsc_item_t *) calloc(s->count, sizeof(trap_mpsc_item_t));
+   if (s->items == NULL) {
+      goto free_stage;
+   }
+   for (i = 0; i < s->count; i++) {
+      s->items[i].buffer_header = (unsigned char *) calloc(1, o->buffer_size + sizeof(trap_buffer_header_t) + 1);
+      if (s->items[i].buffer_header == NULL) {
+         goto free_items;
+      }
+   }
+   if (pthread_mutex_init(&s->lock, NULL) != 0) {
+      goto free_items;
+   }
+   return s;
+
+free_items:
+   for (i = 0; i < s->count; i++) {
+      free(s->items[i].buffer_header);
+   }
+   free(s->items);
+free_stage:
+   free(s);
+   return NULL;
+}
+
+/**
+ * Destructor of thread-specific stage, called when the thread exits.
+ *
+ * The current buffer is handed over and the stage is left for another thread.
+ *
+ * \param[in] arg  stage of the thread
+ */
+static void trap_mpsc_stage_detach(void *arg)
+{
+   trap_mpsc_stage_t *s = (trap_mpsc_stage_t *) arg;
+   trap_mpsc_t *m = s->mpsc;
+
+   pthread_mutex_lock(&s->lock);
+   trap_mpsc_submit(m, s);
+   pthread_mutex_unlock(&s->lock);
+
+   pthread_mutex_lock(&m->stages_lock);
+   s->attached = 0;
+   pthread_mutex_unlock(&m->stages_lock);
+}
+
+/**
+ * Get stage of the calling thread, a detached or new stage is assigned on the first call.
+ *
+ * \param[in,out] m  multi-producer sending of output interface
+ * \return stage or NULL when there is not enough memory
+ */
+static inline trap_mpsc_stage_t *trap_mpsc_stage_get(trap_mpsc_t *m)
+{
+   trap_mpsc_stage_t *s = (trap_mpsc_stage_t *) pthread_getspecific(m->key);
+
+   if (s != NULL) {
+      return s;
+   }
+   pthread_mutex_lock(&m->stages_lock);
+   for (s = m->stages; s != NULL; s = s->next) {
+      if (s->attached == 0) {
+         break;
+      }
+   }
+   if (s == NULL) {
+      s = trap_mpsc_stage_create(m);
+      if (s != NULL) {
+         s->next = m->stages;
+         m->stages = s;
+      }
+   }
+   if (s != NULL) {
+      s->attached = 1;
+      pthread_setspecific(m->key, s);
+   }
+   pthread_mutex_unlock(&m->stages_lock);
+   return s;
+}
+
+/**
+ * Make room for a message in the current buffer of stage.
+ *
+ * The caller must hold lock of the stage.  The current buffer is handed
+ * over when there is not enough space in it, then the function waits for
+ * the next buffer of stage according to timeout of the interface.
+ *
+ * \param[in,out] ctx  pointer to the private libtrap context data (trap_ctx_init())
+ * \param[in] o        output interface
+ * \param[in,out] s    stage
+ * \param[in] needed_size  size of message incl. its header
+ * \return TRAP_E_OK, TRAP_E_TIMEOUT or TRAP_E_TERMINATED
+ */
+static int trap_mpsc_stage_reserve(trap_ctx_priv_t *ctx, trap_output_ifc_t *o, trap_mpsc_stage_t *s, uint32_t needed_size)
+{
+   if (s->buffer_index + needed_size > trap_buffer_capacity(o)) {
+      trap_mpsc_submit(o->mpsc, s);
+   }
+   return trap_mpsc_wait_item(ctx, o->mpsc, &s->items[s->current], o->datatimeout);
+}
+
+/**
+ * Finish message written into the current buffer of stage.
+ *
+ * The caller must hold lock of the stage.  Buffer is handed over
+ * immediately when buffering is disabled, otherwise autoflush is scheduled
+ * for the first message of buffer.
+ *
+ * \param[in,out] ctx  pointer to the private libtrap context data (trap_ctx_init())
+ * \param[in] o        output interface
+ * \param[in,out] s    stage
+ * \param[in] size     size of message
+ */
+static void trap_mpsc_stage_commit(trap_ctx_priv_t *ctx, trap_output_ifc_t *o, trap_mpsc_stage_t *s, uint16_t size)
+{
+   unsigned char *buffer = ((trap_buffer_header_t *) s->items[s->current].buffer_header)->data;
+
+   *((uint16_t *) &buffer[s->buffer_index]) = size;
+   s->buffer_index += size + sizeof(size);
+   s->messages++;
+
+   if (o->bufferswitch == 0) {
+      trap_mpsc_submit(o->mpsc, s);
+   } else if ((s->flush_deadline == 0) && (o->timeout != TRAP_NO_AUTO_FLUSH)) {
+      /* autoflush reads the deadline without lock when the stage is locked */
+      __atomic_store_n(&s->flush_deadline, trap_monotonic_ns() + (uint64_t) o->timeout * 1000, __ATOMIC_RELAXED);
+      trap_autoflush_arm(ctx, s->flush_deadline);
+   }
+}
+
+/**
+ * Store message into the stage of the calling thread.
+ *
+ * \param[in,out] ctx  pointer to the private libtrap context data (trap_ctx_init())
+ * \param[in] ifc      index of output interface
+ * \param[in] data     message
+ * \param[in] size     size of message
+ * \return TRAP_E_OK, TRAP_E_TIMEOUT or TRAP_E_TERMINATED when the message was dropped,
+ * TRAP_E_MEMORY on error
+ */
+static int trap_mpsc_store(trap_ctx_priv_t *ctx, unsigned int ifc, const void *data, uint16_t size)
+{
+   trap_output_ifc_t *o = &ctx->out_ifc_list[ifc];
+   trap_mpsc_stage_t *s;
+   unsigned char *buffer;
+   int result;
+
+   if (size + sizeof(size) > trap_buffer_capacity(o)) {
+      return trap_errorf(ctx, TRAP_E_MEMORY, "Buffer is too small for this message. Skipping...");
+   }
+   s = trap_mpsc_stage_get(o->mpsc);
+   if (s == NULL) {
+      return trap_errorf(ctx, TRAP_E_MEMORY, "Not enough memory for staging buffers.");
+   }
+
+   pthread_mutex_lock(&s->lock);
+   result = trap_mpsc_stage_reserve(ctx, o, s, size + sizeof(size));
+   if (result == TRAP_E_OK) {
+      buffer = ((trap_buffer_header_t *) s->items[s->current].buffer_header)->data;
+      memcpy(buffer + s->buffer_index + sizeof(size), data, size);
+      trap_mpsc_stage_commit(ctx, o, s, size);
+   } else {
+      TRAP_CNT_ADD(trap_counters_out(&ctx->counters, ifc)->dropped, 1);
+   }
+   pthread_mutex_unlock(&s->lock);
+   return result;
+}
+
+/**
+ * Reserve space for a message in the stage of the calling thread (see trap_ctx_send_reserve()).
+ *
+ * Lock of the stage stays locked until trap_mpsc_commit().
+ *
+ * \param[in,out] ctx  pointer to the private libtrap context data (trap_ctx_init())
+ * \param[in] ifc      index of output interface
+ * \param[in] max_size maximal size of message
+ * \param[out] data    pointer to the reserved space
+ * \return TRAP_E_OK on success, TRAP_E_TIMEOUT or TRAP_E_TERMINATED when there is no free buffer,
+ * TRAP_E_MEMORY on error
+ */
+static int trap_mpsc_reserve(trap_ctx_priv_t *ctx, unsigned int ifc, uint16_t max_size, void **data)
+{
+   trap_output_ifc_t *o = &ctx->out_ifc_list[ifc];
+   trap_mpsc_stage_t *s;
+   int result;
+
+   if (max_size + sizeof(max_size) > trap_buffer_capacity(o)) {
+      return trap_errorf(ctx, TRAP_E_MEMORY, "Buffer is too small for this message.");
+   }
+   s = trap_mpsc_stage_get(o->mpsc);
+   if (s == NULL) {
+      return trap_errorf(ctx, TRAP_E_MEMORY, "Not enough memory for staging buffers.");
+   }
+   pthread_mutex_lock(&s->lock);
+   result = trap_mpsc_stage_reserve(ctx, o, s, max_size + sizeof(max_size));
+   if (result != TRAP_E_OK) {
+      TRAP_CNT_ADD(trap_counters_out(&ctx->counters, ifc)->dropped, 1);
+      pthread_mutex_unlock(&s->lock);
+      return result;
+   }
+   s->reserved_size = max_size + sizeof(max_size);
+   (*data) = ((trap_buffer_header_t *) s->items[s->current].buffer_header)->data + s->buffer_index + sizeof(max_size);
+   return TRAP_E_OK;
+}
+
+/**
+ * Finish message reserved by trap_mpsc_reserve() (see trap_ctx_send_commit()).
+ *
+ * \param[in,out] ctx  pointer to the private libtrap context data (trap_ctx_init())
+ * \param[in] ifc      index of output interface
+ * \param[in] size     size of message
+ * \return TRAP_E_OK on success, TRAP_E_BAD_FPARAMS when nothing was reserved or message is too big
+ */
+static int trap_mpsc_commit(trap_ctx_priv_t *ctx, unsigned int ifc, uint16_t size)
+{
+   trap_output_ifc_t *o = &ctx->out_ifc_list[ifc];
+   trap_mpsc_stage_t *s = (trap_mpsc_stage_t *) pthread_getspecific(o->mpsc->key);
+
+   if ((s == NULL) || (s->reserved_size == 0)) {
+      return trap_errorf(ctx, TRAP_E_BAD_FPARAMS, "Nothing was reserved by trap_ctx_send_reserve().");
+   }
+   if (size + sizeof(size) > s->reserved_size) {
+      s->reserved_size = 0;
+      pthread_mutex_unlock(&s->lock);
+      return trap_errorf(ctx, TRAP_E_BAD_FPARAMS, "Committed message is bigger than reserved space, skipping.");
+   }
+   s->reserved_size = 0;
+   trap_mpsc_stage_commit(ctx, o, s, size);
+   pthread_mutex_unlock(&s->lock);
+   return TRAP_E_OK;
+}
+
+/**
+ * Hand over current buffers of all stages and wait until all buffers are sent.
+ *
+ * \param[in,out] m  multi-producer sending of output interface
+ */
+static void trap_mpsc_flush(trap_mpsc_t *m)
+{
+   trap_mpsc_stage_t *s;
+
+   pthread_mutex_lock(&m->stages_lock);
+   for (s = m->stages; s != NULL; s = s->next) {
+      pthread_mutex_lock(&s->lock);
+      trap_mpsc_submit(m, s);
+      pthread_mutex_unlock(&s->lock);
+   }
+   pthread_mutex_unlock(&m->stages_lock);
+
+   __atomic_add_fetch(&m->producers_waiting, 1, __ATOMIC_SEQ_CST);
+   pthread_mutex_lock(&m->lock);
+   while (__atomic_load_n(&m->pending, __ATOMIC_SEQ_CST) != 0) {
+      pthread_cond_wait(&m->cond_released, &m->lock);
+   }
+   pthread_mutex_unlock(&m->lock);
+   __atomic_sub_fetch(&m->producers_waiting, 1, __ATOMIC_SEQ_CST);
+}
+
+/**
+ * Hand over buffers of stages whose autoflush deadline has elapsed.
+ *
+ * Stage locked by its thread is skipped and checked again after
+ * TRAP_AUTOFLUSH_RETRY.
+ *
+ * \param[in,out] ctx   pointer to the private libtrap context data (trap_ctx_init())
+ * \param[in] ifc       index of output interface
+ * \param[in] now       current time (CLOCK_MONOTONIC, ns)
+ * \return the nearest deadline of stages, 0 if there is none
+ */
+static uint64_t trap_mpsc_autoflush(trap_ctx_priv_t *ctx, unsigned int ifc, uint64_t now)
+{
+   trap_output_ifc_t *o = &ctx->out_ifc_list[ifc];
+   trap_mpsc_t *m = o->mpsc;
+   trap_mpsc_stage_t *s;
+   uint64_t deadline, next = 0;
+
+   pthread_mutex_lock(&m->stages_lock);
+   for (s = m->stages; s != NULL; s = s->next) {
+      if (pthread_mutex_trylock(&s->lock) != 0) {
+         deadline = __atomic_load_n(&s->flush_deadline, __ATOMIC_RELAXED);
+         if ((deadline != 0) && (deadline <= now)) {
+            deadline = now + TRAP_AUTOFLUSH_RETRY * 1000ULL;
+         }
+      } else {
+         deadline = s->flush_deadline;
+         if ((deadline == 0) || (s->buffer_index == 0) || (o->timeout == TRAP_NO_AUTO_FLUSH)) {
+            s->flush_deadline = 0;
+            deadline = 0;
+         } else if (deadline <= now) {
+            trap_mpsc_submit(m, s);
+            TRAP_CNT_ADD(trap_counters_out(&ctx->counters, ifc)->autoflushes, 1);
+            deadline = 0;
+         }
+         pthread_mutex_unlock(&s->lock);
+      }
+      if ((deadline != 0) && ((next == 0) || (deadline < next))) {
+         next = deadline;
+      }
+   }
+   pthread_mutex_unlock(&m->stages_lock);
+   return next;
 }
 
-static void insert_into_buffer(trap_output_ifc_t *priv, const void *data, const uint16_t size)
+/**
+ * Enable multi-producer sending of output interface and start its sender thread.
+ *
+ * The caller must hold ifc_mtx of the interface, content of the interface
+ * buffer is sent first.
+ *
+ * \param[in,out] ctx   pointer to the private libtrap context data (trap_ctx_init())
+ * \param[in] ifc       index of output interface
+ * \param[in] buffers   number of staging buffers of every thread
+ * \return TRAP_E_OK on success, TRAP_E_MEMORY on error
+ */
+static int trap_mpsc_create(trap_ctx_priv_t *ctx, unsigned int ifc, uint32_t buffers)
 {
-   assert(priv->buffer_index <= (TRAP_IFC_MESSAGEQ_SIZE - sizeof(trap_buffer_header_t)));
-   if (priv->buffer_occupied == 0) {
-      uint16_t *msize = (uint16_t *) &priv->buffer[priv->buffer_index];
-      (*msize) = size;
-      memcpy((void *) (msize + 1), data, size);
-      priv->buffer_index += size + sizeof size;
+   trap_output_ifc_t *o = &ctx->out_ifc_list[ifc];
+   trap_mpsc_t *m;
+
+   trap_send_whole_buffer(ctx, ifc, o->datatimeout);
+   if (o->pool != NULL) {
+      trap_buffer_pool_wait_sent(o->pool);
+   }
+
+   m = (trap_mpsc_t *) calloc(1, sizeof(trap_mpsc_t));
+   if (m == NULL) {
+      return trap_errorf(ctx, TRAP_E_MEMORY, "Not enough memory for multi-producer sending.");
+   }
+   m->head = &m->stub;
+   m->tail = &m->stub;
+   m->stage_buffers = buffers;
+   m->ctx = ctx;
+   m->ifc = ifc;
+   if (pthread_key_create(&m->key, trap_mpsc_stage_detach) != 0) {
+      goto free_mpsc;
+   }
+   if (pthread_mutex_init(&m->stages_lock, NULL) != 0) {
+      goto free_key;
+   }
+   if (pthread_mutex_init(&m->lock, NULL) != 0) {
+      goto free_stages_lock;
+   }
+   if (pthread_cond_init(&m->cond_queued, NULL) != 0) {
+      goto free_lock;
+   }
+   if (pthread_cond_init(&m->cond_released, NULL) != 0) {
+      goto free_cond_queued;
+   }
+   if (pthread_create(&m->thread, NULL, trap_mpsc_sender_thr, (void *) m) != 0) {
+      goto free_cond_released;
+   }
+   o->mpsc = m;
+   o->mpsc_size = buffers;
+   VERBOSE(CL_VERBOSE_LIBRARY, "Output ifc %u uses multi-producer sending with %"PRIu32" buffers per thread.", ifc, buffers);
+   return TRAP_E_OK;
+
+free_cond_released:
+   pthread_cond_destroy(&m->cond_released);
+free_cond_queued:
+   pthread_cond_destroy(&m->cond_queued);
+free_lock:
+   pthread_mutex_destroy(&m->lock);
+free_stages_lock:
+   pthread_mutex_destroy(&m->stages_lock);
+free_key:
+   pthread_key_delete(m->key);
+free_mpsc:
+   free(m);
+   return trap_errorf(ctx, TRAP_E_MEMORY, "Creation of multi-producer sending failed.");
+}
+
+/**
+ * Stop sender thread and free stages of output interface.
+ *
+ * Queued buffers are passed to send() of the interface before the thread
+ * exits, content of current buffers of stages is lost (see trap_mpsc_flush()).
+ * Threads must not send into the interface anymore.
+ *
+ * \param[in,out] o  output interface
+ */
+static void trap_mpsc_destroy(trap_output_ifc_t *o)
+{
+   trap_mpsc_t *m = o->mpsc;
+   trap_mpsc_stage_t *s;
+   uint32_t i;
+
+   if (m == NULL) {
+      return;
    }
+   /* stages of running threads are freed below, no destructor must be called */
+   pthread_key_delete(m->key);
+
+   pthread_mutex_lock(&m->lock);
+   m->terminate = 1;
+   pthread_cond_signal(&m->cond_queued);
+   pthread_mutex_unlock(&m->lock);
+   pthread_join(m->thread, NULL);
+
+   while (m->stages != NULL) {
+      s = m->stages;
+      m->stages = s->next;
+      for (i = 0; i < s->count; i++) {
+         free(s->items[i].buffer_header);
+      }
+      free(s->items);
+      pthread_mutex_destroy(&s->lock);
+      free(s);
+   }
+   pthread_cond_destroy(&m->cond_released);
+   pthread_cond_destroy(&m->cond_queued);
+   pthread_mutex_destroy(&m->lock);
+   pthread_mutex_destroy(&m->stages_lock);
+   free(m);
+   o->mpsc = NULL;
 }
+
+/**
+ * @}
+ */
+
 static inline int trap_store_into_buffer(trap_ctx_priv_t *ctx, unsigned int ifc, const void *data, uint16_t size, int timeout, char flush)
 {
    /* Declaration of variables, we can have small buffer, initialization after checking the condition. */
@@ -282,7 +1705,7 @@ static inline int trap_store_into_buffer(trap_ctx_priv_t *ctx, unsigned int ifc,
    }
 
    /* Can we put message at least into empty buffer? In the worst case, we could end up with SEGFAULT -> rather skip with error */
-   if (needed_size > TRAP_IFC_MESSAGEQ_SIZE) {
+   if (needed_size > trap_buffer_capacity(&ctx->out_ifc_list[ifc])) {
       return trap_errorf(ctx, TRAP_E_MEMORY, "Buffer is too small for this message. Skipping...");
    }
 
@@ -296,11 +1719,7 @@ static inline int trap_store_into_buffer(trap_ctx_priv_t *ctx, unsigned int ifc,
       pthread_mutex_lock(&ctx->out_ifc_list[ifc].ifc_mtx);
    }
    /* initialization in locked section, otherwise autoflush can send buffer which has been already sent */
-   if (ctx->out_ifc_list[ifc].buffer_index <= (TRAP_IFC_MESSAGEQ_SIZE - sizeof(trap_buffer_header_t))) {
-      freespace = TRAP_IFC_MESSAGEQ_SIZE - ctx->out_ifc_list[ifc].buffer_index - sizeof(trap_buffer_header_t);
-   } else {
-      freespace = 0;
-   }
+   freespace = trap_buffer_freespace(&ctx->out_ifc_list[ifc]);
    result = TRAP_E_TIMEOUT;
 
    /* Is this a autoflush call? If we have empty buffer, we do not send anything. */
@@ -311,18 +1730,22 @@ static inline int trap_store_into_buffer(trap_ctx_priv_t *ctx, unsigned int ifc,
             VERBOSE(CL_ERROR, "Buffer is not valid.");
          }
 #endif
+         if (ctx->out_ifc_list[ifc].pool != NULL) {
+            result = trap_buffer_pool_handoff(ctx, ifc, timeout);
+            goto fn_exit;
+         }
          DEBUG_BUF(VERBOSE(CL_VERBOSE_LIBRARY, "sending by autoflush %"PRIu32" B from %p", ctx->out_ifc_list[ifc].buffer_index, ctx->out_ifc_list[ifc].buffer));
 
          ctx->out_ifc_list[ifc].buffer_occupied = 1;
          trap_buffer_header_t *h = (trap_buffer_header_t *) ctx->out_ifc_list[ifc].buffer_header;
          h->data_length = htonl(ctx->out_ifc_list[ifc].buffer_index);
-         result = ctx->out_ifc_list[ifc].send(ctx->out_ifc_list[ifc].priv, ctx->out_ifc_list[ifc].buffer_header,
-                                              ctx->out_ifc_list[ifc].buffer_index + sizeof(trap_buffer_header_t), timeout);
+         result = trap_ifc_send_buffer(ctx, ifc, ctx->out_ifc_list[ifc].buffer_header,
+                                       ctx->out_ifc_list[ifc].buffer_index + sizeof(trap_buffer_header_t), timeout);
 
          if (result == TRAP_E_OK) {
-            ctx->counter_send_buffer[ifc]++;
             ctx->out_ifc_list[ifc].buffer_index = 0;
             ctx->out_ifc_list[ifc].buffer_occupied = 0;
+            ctx->out_ifc_list[ifc].flush_deadline = 0;
             DEBUG_BUF(VERBOSE(CL_VERBOSE_LIBRARY, "Sending partial buffer invoked by autoflush timeout on interface %d", ifc));
          } else {
             VERBOSE(CL_VERBOSE_LIBRARY, "Autoflush was not successful.");
@@ -333,9 +1756,6 @@ static inline int trap_store_into_buffer(trap_ctx_priv_t *ctx, unsigned int ifc,
       }
       goto fn_exit;
    }
-   /* we send buffer before timeout, no need to flush it */
-   ctx->out_ifc_list[ifc].bufferflush = 1;
-
    if ((freespace >= needed_size) && (ctx->out_ifc_list[ifc].bufferswitch == 1)) {
       /* we have enough space, buffering is enabled and size is not "flush" */
 
@@ -356,7 +1776,7 @@ static inline int trap_store_into_buffer(trap_ctx_priv_t *ctx, unsigned int ifc,
 
 #ifdef BUFFERING_CREATE_DUMPS
       char *n = NULL;
-      if (asprintf(&n, "store-buffers-dump%04"PRIu64, ctx->counter_send_buffer[ifc]) != -1) {
+      if (asprintf(&n, "store-buffers-dump%04"PRIu64, trap_counters_out(&ctx->counters, ifc)->buffers) != -1) {
          mkdir(n, 0700);
          ctx->out_ifc_list[ifc].create_dump(ctx->out_ifc_list[ifc].priv, ifc, n);
          free(n);
@@ -367,27 +1787,39 @@ static inline int trap_store_into_buffer(trap_ctx_priv_t *ctx, unsigned int ifc,
          insert_into_buffer(&ctx->out_ifc_list[ifc], data, size);
       }
 
+      if (ctx->out_ifc_list[ifc].pool != NULL) {
+         /* sender thread sends the buffer, current message goes into a fresh one */
+         result = trap_buffer_pool_handoff(ctx, ifc, timeout);
+         if (result == TRAP_E_OK) {
+            if (ctx->out_ifc_list[ifc].bufferswitch == 1) {
+               insert_into_buffer(&ctx->out_ifc_list[ifc], data, size);
+            }
+         } else {
+            if (ctx->out_ifc_list[ifc].bufferswitch == 0) {
+               /* message was not handed over, remove it */
+               ctx->out_ifc_list[ifc].buffer_index -= needed_size;
+            }
+            TRAP_CNT_ADD(trap_counters_out(&ctx->counters, ifc)->dropped, 1);
+         }
+         goto fn_exit;
+      }
+
       ctx->out_ifc_list[ifc].buffer_occupied = 1;
       trap_buffer_header_t *h = (trap_buffer_header_t *) ctx->out_ifc_list[ifc].buffer_header;
       h->data_length = htonl(ctx->out_ifc_list[ifc].buffer_index);
-      result = ctx->out_ifc_list[ifc].send(ctx->out_ifc_list[ifc].priv, ctx->out_ifc_list[ifc].buffer_header,
-                                           ctx->out_ifc_list[ifc].buffer_index + sizeof(trap_buffer_header_t), timeout);
+      result = trap_ifc_send_buffer(ctx, ifc, ctx->out_ifc_list[ifc].buffer_header,
+                                    ctx->out_ifc_list[ifc].buffer_index + sizeof(trap_buffer_header_t), timeout);
 
       /* if the buffer was successfully sent OR we have no client: */
       if (result == TRAP_E_OK || result == TRAP_E_IO_ERROR) {
-         if (result == TRAP_E_OK) {
-            /*
-             * buffer was successfully sent but we still have current message pending/not stored
-             * it will be the first message in buffer
-             */
-            ctx->counter_send_buffer[ifc]++;
-         } else {
+         if (result == TRAP_E_IO_ERROR) {
             /* we had no client but we can propagate either OK or TIMEOUT: */
             result = TRAP_E_TIMEOUT;
          }
          /* buffer will be cleaned */
          ctx->out_ifc_list[ifc].buffer_index = 0;
          ctx->out_ifc_list[ifc].buffer_occupied = 0;
+         ctx->out_ifc_list[ifc].flush_deadline = 0;
          /* buffer was successfully sent but we still have current message pending/not stored
           * it will be the first message in buffer */
          if (ctx->out_ifc_list[ifc].bufferswitch == 1) {
@@ -395,7 +1827,7 @@ static inline int trap_store_into_buffer(trap_ctx_priv_t *ctx, unsigned int ifc,
          }
       } else {
          if (result == TRAP_E_TIMEOUT) {
-            ctx->counter_dropped_message[ifc]++;
+            TRAP_CNT_ADD(trap_counters_out(&ctx->counters, ifc)->dropped, 1);
          }
          if (trap_ctx_get_client_count(ctx, ifc) == 0) {
             ctx->out_ifc_list[ifc].buffer_occupied = 0;
@@ -404,6 +1836,7 @@ static inline int trap_store_into_buffer(trap_ctx_priv_t *ctx, unsigned int ifc,
    }
 
 fn_exit:
+   trap_autoflush_schedule(ctx, ifc);
    pthread_mutex_unlock(&ctx->out_ifc_list[ifc].ifc_mtx);
    return result;
 }
@@ -479,53 +1912,31 @@ void *reader_threads_fn(void *arg)
    pthread_exit(NULL);
 }
 
-/**
- * Function to initialize or change the array of structures with information about timeouts
- * on output interfaces.
- *
- * @param[in,out] ctx         pointer to the private libtrap context data (trap_ctx_init())
- * @return Number of output interfaces, where the timeout is set.
- */
-static inline int trap_init_ifcs_timeouts(trap_ctx_priv_t *ctx)
-{
-   int i, idx, res;
-   struct out_ifc_timeout_s *out_ifc_timeout = ctx->ifc_autoflush_timeout;
-   idx = 0;
-   for (i = 0; i < ctx->num_ifc_out; i++) {
-      if ((ctx->out_ifc_list[i].timeout != TRAP_NO_AUTO_FLUSH) && (ctx->out_ifc_list[i].bufferswitch != 0)) {
-         out_ifc_timeout[idx].idx = i;
-         // Try lock updating of timeout, it could be changing, do not block
-         res = pthread_mutex_trylock(&ctx->out_ifc_list[i].ifc_mtx);
-         out_ifc_timeout[idx].tm = ctx->out_ifc_list[i].timeout;
-         if (res == 0)
-            pthread_mutex_unlock(&ctx->out_ifc_list[i].ifc_mtx);
-         idx++;
-      }
-   }
-   // All changes updated, set to zero
-   if (pthread_rwlock_wrlock(&ctx->context_lock) != 0) {
-      VERBOSE(CL_ERROR, "Locking of context failed. %s", __func__);
-   }
-   ctx->ifc_change = 0;
-   pthread_rwlock_unlock(&ctx->context_lock);
-   return idx;
-}
-
 /**
  * Handle the timeouts on output interfaces and flush buffer after timeout is reached.
  *
+ * The thread waits on the autoflush timer (timerfd armed to the nearest
+ * flush_deadline), sends buffers whose deadline has elapsed and re-arms
+ * the timer to the nearest remaining deadline.  It is cancelled by
+ * trap_ctx_finalize() while it waits on the timer.
  *
  * @return NULL
  */
 static void *trap_automatic_flush_thr(void *arg)
 {
-   int i, n;
-   int64_t usec;
+   int i;
+   uint64_t expirations, now, next, deadline;
    trap_ctx_priv_t *ctx = (trap_ctx_priv_t *) arg;
 
-   n = trap_init_ifcs_timeouts(ctx);
-
    while (1) {
+      if (read(ctx->autoflush_fd, &expirations, sizeof(expirations)) == -1) {
+         if (errno != EINTR && errno != EAGAIN) {
+            VERBOSE(CL_ERROR, "Waiting for autoflush timer failed: %s", strerror(errno));
+            break;
+         }
+         continue;
+      }
+      pthread_setcancelstate(PTHREAD_CANCEL_DISABLE, NULL);
       if (pthread_rwlock_rdlock(&ctx->context_lock) != 0) {
          VERBOSE(CL_ERROR, "Locking of context failed. %s", __func__);
          break;
@@ -534,74 +1945,29 @@ static void *trap_automatic_flush_thr(void *arg)
          pthread_rwlock_unlock(&ctx->context_lock);
          break;
       }
-      // Checking if automatic flushing or buffering was changed or disabled
-      if (ctx->ifc_change == 1) {
-         pthread_rwlock_unlock(&ctx->context_lock);
-         n = trap_init_ifcs_timeouts(ctx);
-      } else {
-         pthread_rwlock_unlock(&ctx->context_lock);
-      }
+      pthread_rwlock_unlock(&ctx->context_lock);
 
-      // Sort array by timeout if we have more than one output interface
-      if (n != 0) {
-         if (n > 1) {
-            qsort(ctx->ifc_autoflush_timeout, n, sizeof(struct out_ifc_timeout_s), compare_timeouts);
-         }
-         usec = ctx->ifc_autoflush_timeout[0].tm;
-         VERBOSE(CL_VERBOSE_LIBRARY, "Autoflush thread is going to sleep for %ld microseconds.", usec);
-         if (sleep(usec/1000000) != 0) {
-            if (pthread_rwlock_rdlock(&ctx->context_lock) != 0) {
-               VERBOSE(CL_ERROR, "Locking of context failed. %s", __func__);
-               break;
-            }
-            if (ctx->terminated == 1) {
-               pthread_rwlock_unlock(&ctx->context_lock);
-               break;
-            }
-            pthread_rwlock_unlock(&ctx->context_lock);
-         }
-         if (usleep(usec%1000000) == -1) {
-            if (pthread_rwlock_rdlock(&ctx->context_lock) != 0) {
-               VERBOSE(CL_ERROR, "Locking of context failed. %s", __func__);
-               break;
-            }
-            if (ctx->terminated == 1) {
-               pthread_rwlock_unlock(&ctx->context_lock);
-               break;
-            }
-            pthread_rwlock_unlock(&ctx->context_lock);
-         }
-
-         // Check all interfaces if timeout has elapsed, otherwise break
-         for (i = 0; i < n; i++) {
-            ctx->ifc_autoflush_timeout[i].tm -= usec;
-            if (ctx->ifc_autoflush_timeout[i].tm == 0) {
-               pthread_mutex_lock(&ctx->out_ifc_list[i].ifc_mtx);
-               if (ctx->out_ifc_list[ctx->ifc_autoflush_timeout[i].idx].bufferflush == 0) {
-                  pthread_mutex_unlock(&ctx->out_ifc_list[i].ifc_mtx);
-                  // No event on the interface, flushing the buffer
-                  trap_ctx_send_flush((trap_ctx_t *) ctx, i);
-                  ctx->counter_autoflush[ctx->ifc_autoflush_timeout[i].idx]++;
-               }
-               else {
-                  // Buffer was sent before timeout has elapsed, no need to flush the buffer
-                  ctx->out_ifc_list[ctx->ifc_autoflush_timeout[i].idx].bufferflush = 0;
-                  pthread_mutex_unlock(&ctx->out_ifc_list[i].ifc_mtx);
-               }
-               // Updating of timeout, it could be changing
-               pthread_mutex_lock(&ctx->out_ifc_list[i].ifc_mtx);
-               ctx->ifc_autoflush_timeout[i].tm = ctx->out_ifc_list[ctx->ifc_autoflush_timeout[i].idx].timeout;
-               pthread_mutex_unlock(&ctx->out_ifc_list[i].ifc_mtx);
-            } else {
-               continue;
-            }
+      /* deadlines scheduled from now on re-arm the timer themselves */
+      pthread_mutex_lock(&ctx->autoflush_mtx);
+      ctx->autoflush_next = UINT64_MAX;
+      pthread_mutex_unlock(&ctx->autoflush_mtx);
+
+      now = trap_monotonic_ns();
+      next = UINT64_MAX;
+      for (i = 0; i < ctx->num_ifc_out; i++) {
+         if (ctx->out_ifc_list[i].mpsc != NULL) {
+            deadline = trap_mpsc_autoflush(ctx, i, now);
+         } else {
+            deadline = trap_autoflush_ifc(ctx, i, now);
          }
-      } else {
-         // Sleep for defined time, default 2 seconds
-         if (sleep(TRAP_NO_IFC_SLEEP)) {
-            break;
+         if ((deadline != 0) && (deadline < next)) {
+            next = deadline;
          }
       }
+      if (next != UINT64_MAX) {
+         trap_autoflush_arm(ctx, next);
+      }
+      pthread_setcancelstate(PTHREAD_CANCEL_ENABLE, NULL);
    }
 
    pthread_exit(NULL);
@@ -945,6 +2311,24 @@ int trap_recv(uint32_t ifcidx, const void **data, uint16_t *size)
 }
 
 
+int trap_recv_bulk(uint32_t ifcidx, const void **data, uint16_t *sizes, uint32_t max, uint32_t *count)
+{
+   int res;
+   res = trap_ctx_recv_bulk((trap_ctx_t *) trap_glob_ctx, ifcidx, data, sizes, max, count);
+   trap_last_error_msg = trap_glob_ctx->trap_last_error_msg;
+   trap_last_error = trap_glob_ctx->trap_last_error;
+   return res;
+}
+
+int trap_recv_any(uint32_t ifc_mask, uint32_t *ifcidx, const void **data, uint16_t *size, int timeout)
+{
+   int res;
+   res = trap_ctx_recv_any((trap_ctx_t *) trap_glob_ctx, ifc_mask, ifcidx, data, size, timeout);
+   trap_last_error_msg = trap_glob_ctx->trap_last_error_msg;
+   trap_last_error = trap_glob_ctx->trap_last_error;
+   return res;
+}
+
 /** Set verbosity level.
  * Verbosity levels are:
  *   - -3 - errors
@@ -1425,6 +2809,8 @@ output:
       puts("\nEnvironment variables that affects output:\n------------------------------------------");
       X("  LIBTRAP_OUTPUT_FORMAT", "If set to \"json\", information about module is printed in JSON format.",
         align_def, cols - align_def);
+      X("  LIBTRAP_TRACE", "If set (and not 0), buffers of all output IFCs carry trace of latency (see setter \"trace\").",
+        align_def, cols - align_def);
       X("  PAGER", "Show the help output in the set PAGER.",
         align_def, cols - align_def);
 
@@ -1546,11 +2932,6 @@ void trap_send_flush(uint32_t ifc)
    trap_ctx_send_flush((trap_ctx_t *) trap_glob_ctx, ifc);
 }
 
-static int compare_timeouts (const void *a, const void *b)
-{
-   return ((*(struct out_ifc_timeout_s *)a).tm - (*(struct out_ifc_timeout_s *)b).tm);
-}
-
 /**
  * \addtogroup contextapi Context API
  * @{
@@ -1560,6 +2941,12 @@ trap_ctx_priv_t *trap_create_ctx_t()
 {
         trap_ctx_priv_t *ctx = calloc(1, sizeof(trap_ctx_priv_t));
         /* space for vars init with non-zero values */
+        if (ctx != NULL) {
+           ctx->autoflush_fd = -1;
+           ctx->autoflush_next = UINT64_MAX;
+           ctx->recv_any_epfd = -1;
+           pthread_mutex_init(&ctx->autoflush_mtx, NULL);
+        }
         return ctx;
 }
 
@@ -1576,20 +2963,6 @@ void trap_free_ctx_t(trap_ctx_priv_t **ctx)
       return;
    }
 
-   /* free allocated counters */
-   free(c->counter_autoflush);
-   c->counter_autoflush = NULL;
-   free(c->counter_send_buffer);
-   c->counter_send_buffer = NULL;
-   free(c->counter_recv_message);
-   c->counter_recv_message = NULL;
-   free(c->counter_send_message);
-   c->counter_send_message = NULL;
-   free(c->counter_recv_buffer);
-   c->counter_recv_buffer = NULL;
-   free(c->counter_dropped_message);
-   c->counter_dropped_message = NULL;
-
    // Destroy all interfaces
    if ((c->num_ifc_in > 0) && (c->in_ifc_list != NULL)) {
       for (i = 0; i < c->num_ifc_in; i++) {
@@ -1605,6 +2978,8 @@ void trap_free_ctx_t(trap_ctx_priv_t **ctx)
             free(c->in_ifc_list[i].req_data_fmt_spec);
             c->in_ifc_list[i].req_data_fmt_spec = NULL;
          }
+         trap_compress_destroy(c->in_ifc_list[i].compress);
+         c->in_ifc_list[i].compress = NULL;
          if (c->in_ifc_list[i].destroy != NULL) {
             c->in_ifc_list[i].destroy(c->in_ifc_list[i].priv);
          }
@@ -1619,6 +2994,9 @@ void trap_free_ctx_t(trap_ctx_priv_t **ctx)
 
    if ((c->num_ifc_out > 0) && (c->out_ifc_list != NULL)) {
       for (i = 0; i < c->num_ifc_out; i++) {
+         /* sender thread uses the interface, stop it first */
+         trap_mpsc_destroy(&c->out_ifc_list[i]);
+         trap_buffer_pool_destroy(&c->out_ifc_list[i]);
          if (c->out_ifc_list[i].destroy != NULL) {
             c->out_ifc_list[i].destroy(c->out_ifc_list[i].priv);
          }
@@ -1630,13 +3008,22 @@ void trap_free_ctx_t(trap_ctx_priv_t **ctx)
             free(c->out_ifc_list[i].data_fmt_spec);
             c->out_ifc_list[i].data_fmt_spec = NULL;
          }
+         trap_compress_destroy(c->out_ifc_list[i].compress);
+         c->out_ifc_list[i].compress = NULL;
          pthread_mutex_destroy(&c->out_ifc_list[i].ifc_mtx);
       }
       free(c->out_ifc_list);
       c->out_ifc_list = NULL;
-      free(c->ifc_autoflush_timeout);
-      c->ifc_autoflush_timeout = NULL;
    }
+   if (c->recv_any_epfd != -1) {
+      close(c->recv_any_epfd);
+      c->recv_any_epfd = -1;
+   }
+   if (c->autoflush_fd != -1) {
+      close(c->autoflush_fd);
+      c->autoflush_fd = -1;
+   }
+   pthread_mutex_destroy(&c->autoflush_mtx);
 
    // Free threads and semaphores
    if (c->reader_threads != NULL) {
@@ -1653,6 +3040,10 @@ void trap_free_ctx_t(trap_ctx_priv_t **ctx)
       c->in_ifc_results = NULL;
    }
 
+   /* free counters, there is no thread that could update them */
+   trap_counters_destroy(&c->counters);
+   trap_trace_destroy(&c->trace);
+
    c->terminated = 1;
    pthread_rwlock_destroy(&c->context_lock);
 
@@ -1715,7 +3106,7 @@ int trap_ctx_recv(trap_ctx_t *ctx, uint32_t ifcidx, const void **data, uint16_t
       uint32_t newsize = 0;
       ret_val = c->in_ifc_list[ifcidx].recv(c->in_ifc_list[ifcidx].priv, c->in_ifc_list[ifcidx].buffer, &newsize, c->in_ifc_list[ifcidx].datatimeout);
       if (ret_val == TRAP_E_OK) {
-         c->counter_recv_message[ifcidx]++;
+         TRAP_CNT_ADD(trap_counters_in(&c->counters, ifcidx)->messages, 1);
          if (c->in_ifc_list[ifcidx].client_state == FMT_CHANGED) {
             c->in_ifc_list[ifcidx].client_state = FMT_OK;
             return TRAP_E_FORMAT_CHANGED;
@@ -1732,6 +3123,47 @@ int trap_ctx_recv(trap_ctx_t *ctx, uint32_t ifcidx, const void **data, uint16_t
    }
 }
 
+int trap_ctx_recv_bulk(trap_ctx_t *ctx, uint32_t ifcidx, const void **data, uint16_t *sizes, uint32_t max, uint32_t *count)
+{
+   int ret_val = 0;
+   trap_ctx_priv_t *c = (trap_ctx_priv_t *) ctx;
+   if ((c == NULL) || (c->initialized == 0)) {
+      return trap_error(c, TRAP_E_NOT_INITIALIZED);
+   }
+   if ((data == NULL) || (sizes == NULL) || (count == NULL) || (max == 0)) {
+      return trap_error(c, TRAP_E_BAD_FPARAMS);
+   }
+   (*count) = 0;
+   if (pthread_rwlock_rdlock(&c->context_lock) != 0) {
+      VERBOSE(CL_ERROR, "Locking of context failed. %s", __func__);
+      if (c->terminated == 1) {
+         return trap_error(c, TRAP_E_TERMINATED);
+      }
+   }
+   if (c->terminated) {
+      pthread_rwlock_unlock(&c->context_lock);
+      return trap_error(c, TRAP_E_TERMINATED);
+   }
+   pthread_rwlock_unlock(&c->context_lock);
+   if (ifcidx >= c->num_ifc_in) {
+      return trap_errorf(c, TRAP_E_NOT_SELECTED, "No input ifc to get data from...");
+   }
+   if ((c->in_ifc_list[ifcidx].recv != NULL) && (c->in_ifc_list[ifcidx].priv != NULL)) {
+#ifndef DISABLE_BUFFERING
+      ret_val = trap_read_bulk_from_buffer(c, ifcidx, data, sizes, max, count, c->in_ifc_list[ifcidx].datatimeout);
+#else
+      /* there is no buffer, every received data block is just one message */
+      ret_val = trap_ctx_recv(ctx, ifcidx, &data[0], &sizes[0]);
+      if ((ret_val == TRAP_E_OK) || (ret_val == TRAP_E_FORMAT_CHANGED)) {
+         (*count) = 1;
+      }
+#endif
+      return ret_val;
+   } else {
+      return trap_error(c, TRAP_E_NOT_INITIALIZED);
+   }
+}
+
 int trap_ctx_multi_recv(trap_ctx_t *ctx, uint32_t ifc_mask, const void **data, uint16_t *size)
 {
    uint32_t counter = 0;
@@ -1788,17 +3220,287 @@ int trap_ctx_multi_recv(trap_ctx_t *ctx, uint32_t ifc_mask, const void **data, u
          if (c->get_data_timeout > c->in_ifc_list[selected_ifc_arr[counter]].datatimeout) {
             c->get_data_timeout = c->in_ifc_list[selected_ifc_arr[counter]].datatimeout;
          }
-         sem_post(&c->reader_threads[selected_ifc_arr[counter]].sem);
+         sem_post(&c->reader_threads[selected_ifc_arr[counter]].sem);
+      }
+      sem_wait(&c->sem_collector);
+
+      (*data) = c->in_ifc_results;
+      (*size) = IN_IFC_RESULTS_SIZE(c);
+      return trap_error(c, TRAP_E_OK);
+   }
+   return trap_errorf(c, TRAP_E_NOT_SELECTED, "No input ifc to get data from...");
+}
+
+/**
+ * \defgroup recv_any Receiving from any input interface
+ *
+ * trap_ctx_recv_any() takes messages from buffers of input IFCs at first,
+ * then it receives from IFCs that are known to have data (epoll reported
+ * their descriptors or get_fd() says so) and blocks in epoll_wait() only
+ * when there is nothing to receive.  IFCs are visited in turn starting
+ * with the IFC of the last message, which keeps draining one buffer
+ * before switching to another one unless recv_quota says otherwise.
+ * @{
+ */
+
+/** epoll data of input IFC: index and generation of its descriptor */
+#define RECV_ANY_EV(idx, gen) ((((uint64_t) (gen)) << 32) | (uint32_t) (idx))
+
+/** Max number of events processed by one epoll_wait() of trap_ctx_recv_any() */
+#define RECV_ANY_EVENTS 32
+
+/**
+ * Take a message from input IFC without waiting.
+ *
+ * \param[in,out] c  context
+ * \param[in] idx    index of input IFC
+ * \param[out] data  pointer to received message
+ * \param[out] size  size of message
+ * \return result of trap_ctx_recv() with TRAP_NO_WAIT
+ */
+static inline int trap_recv_any_read(trap_ctx_priv_t *c, uint32_t idx, const void **data, uint16_t *size)
+{
+#ifndef DISABLE_BUFFERING
+   return trap_read_from_buffer(c, idx, data, size, TRAP_NO_WAIT);
+#else
+   uint32_t newsize = 0;
+   int ret_val = c->in_ifc_list[idx].recv(c->in_ifc_list[idx].priv, c->in_ifc_list[idx].buffer, &newsize, TRAP_NO_WAIT);
+   if (ret_val == TRAP_E_OK) {
+      TRAP_CNT_ADD(trap_counters_in(&c->counters, idx)->messages, 1);
+      if (c->in_ifc_list[idx].client_state == FMT_CHANGED) {
+         c->in_ifc_list[idx].client_state = FMT_OK;
+         ret_val = TRAP_E_FORMAT_CHANGED;
+      }
+   }
+   (*size) = newsize;
+   (*data) = c->in_ifc_list[idx].buffer;
+   return ret_val;
+#endif
+}
+
+/**
+ * Check whether input IFC should be asked for data and keep its descriptor in epoll set.
+ *
+ * \param[in,out] c  context
+ * \param[in] idx    index of input IFC
+ * \param[out] polled  set to 1 if the IFC has no descriptor to wait for
+ * \return non-zero if recv() of the IFC is worth calling now
+ */
+static int trap_recv_any_check(trap_ctx_priv_t *c, uint32_t idx, int *polled)
+{
+   trap_input_ifc_t *ifc = &c->in_ifc_list[idx];
+   int fd = -1, has_data = 0;
+   uint32_t gen = 0;
+
+   if (ifc->get_fd != NULL) {
+      has_data = ifc->get_fd(ifc->priv, &fd, &gen);
+   }
+#ifdef HAVE_SYS_EPOLL_H
+   if ((fd != -1) && ((fd != ifc->any_fd) || (gen != ifc->any_gen))) {
+      struct epoll_event ev;
+
+      /* closed descriptors leave epoll set automatically, the new one is added */
+      memset(&ev, 0, sizeof(ev));
+      ev.events = EPOLLIN;
+      ev.data.u64 = RECV_ANY_EV(idx, gen);
+      if ((epoll_ctl(c->recv_any_epfd, EPOLL_CTL_ADD, fd, &ev) == -1) &&
+          ((errno != EEXIST) || (epoll_ctl(c->recv_any_epfd, EPOLL_CTL_MOD, fd, &ev) == -1))) {
+         VERBOSE(CL_ERROR, "Adding of input IFC %"PRIu32" into epoll failed (%d): %s", idx, errno, strerror(errno));
+         fd = -1;
+      } else {
+         /* data may have arrived before registration */
+         ifc->any_ready = 1;
+      }
+   }
+#endif
+   ifc->any_fd = fd;
+   ifc->any_gen = gen;
+   if (fd == -1) {
+      (*polled) = 1;
+      return 1;
+   }
+   return (has_data || ifc->any_ready);
+}
+
+/**
+ * Wait for descriptors of input IFCs.
+ *
+ * \param[in,out] c   context
+ * \param[in] wait_us maximal time of waiting in microseconds, 0 to check without waiting
+ * \return number of ready IFCs, -1 on error
+ */
+static int trap_recv_any_wait(trap_ctx_priv_t *c, uint64_t wait_us)
+{
+#ifdef HAVE_SYS_EPOLL_H
+   struct epoll_event events[RECV_ANY_EVENTS];
+   trap_input_ifc_t *ifc;
+   uint32_t idx;
+   int i, n;
+
+   n = epoll_wait(c->recv_any_epfd, events, RECV_ANY_EVENTS, (int) ((wait_us + 999) / 1000));
+   if (n == -1) {
+      return (errno == EINTR ? 0 : -1);
+   }
+   for (i = 0; i < n; i++) {
+      idx = (uint32_t) events[i].data.u64;
+      ifc = &c->in_ifc_list[idx];
+      if ((idx < c->num_ifc_in) && (ifc->any_gen == (uint32_t) (events[i].data.u64 >> 32))) {
+         ifc->any_ready = 1;
+      }
+   }
+   return n;
+#else
+   struct timespec ts;
+
+   ts.tv_sec = wait_us / 1000000;
+   ts.tv_nsec = (wait_us % 1000000) * 1000;
+   nanosleep(&ts, NULL);
+   return 0;
+#endif
+}
+
+/**
+ * Get current time for deadlines of trap_ctx_recv_any().
+ * \return CLOCK_MONOTONIC time in microseconds
+ */
+static inline uint64_t trap_recv_any_now(void)
+{
+   struct timespec ts;
+
+   clock_gettime(CLOCK_MONOTONIC, &ts);
+   return (uint64_t) ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+int trap_ctx_recv_any(trap_ctx_t *ctx, uint32_t ifc_mask, uint32_t *ifc, const void **data, uint16_t *size, int timeout)
+{
+   trap_ctx_priv_t *c = (trap_ctx_priv_t *) ctx;
+   uint32_t j, idx, skip, start;
+   uint64_t deadline = 0, now, wait_us;
+   int ret, polled, refreshed = 0;
+
+   if ((c == NULL) || (c->initialized == 0)) {
+      return trap_error(c, TRAP_E_NOT_INITIALIZED);
+   }
+   if ((ifc == NULL) || (data == NULL) || (size == NULL)) {
+      return trap_error(c, TRAP_E_BAD_FPARAMS);
+   }
+   if (c->num_ifc_in < sizeof(ifc_mask) * 8) {
+      ifc_mask &= (1U << c->num_ifc_in) - 1;
+   }
+   if (ifc_mask == 0) {
+      return trap_errorf(c, TRAP_E_NOT_SELECTED, "No input ifc to get data from...");
+   }
+#ifdef HAVE_SYS_EPOLL_H
+   if (c->recv_any_epfd == -1) {
+      c->recv_any_epfd = epoll_create1(EPOLL_CLOEXEC);
+      if (c->recv_any_epfd == -1) {
+         return trap_errorf(c, TRAP_E_IO_ERROR, "Creation of epoll set failed: %s", strerror(errno));
+      }
+   }
+#endif
+   if (timeout == TRAP_HALFWAIT) {
+      /* it is the same as TRAP_NO_WAIT for input IFCs */
+      timeout = TRAP_NO_WAIT;
+   }
+   if (timeout >= 0) {
+      deadline = trap_recv_any_now() + timeout;
+   }
+
+   while (1) {
+      if (c->terminated) {
+         return trap_error(c, TRAP_E_TERMINATED);
+      }
+      /* the last IFC continues unless it has used its quota */
+      start = c->recv_any_last % c->num_ifc_in;
+      skip = UINT32_MAX;
+      if ((c->in_ifc_list[start].recv_quota != 0) && (c->recv_any_burst >= c->in_ifc_list[start].recv_quota)) {
+         skip = start;
+         start = (start + 1) % c->num_ifc_in;
+      }
+
+      /* I. messages that are already in buffers, no syscall */
+      for (j = 0; j < c->num_ifc_in; j++) {
+         idx = (start + j) % c->num_ifc_in;
+         if (((ifc_mask & (1U << idx)) == 0) || (idx == skip)) {
+            continue;
+         }
+         if (c->in_ifc_list[idx].buffer_full > 0) {
+            goto receive;
+         }
+      }
+
+      /* II. IFCs that have data or cannot be waited for */
+      polled = 0;
+      for (j = 0; j < c->num_ifc_in; j++) {
+         idx = (start + j) % c->num_ifc_in;
+         if (((ifc_mask & (1U << idx)) == 0) || (idx == skip)) {
+            continue;
+         }
+         if (trap_recv_any_check(c, idx, &polled) == 0) {
+            continue;
+         }
+         c->in_ifc_list[idx].any_ready = 0;
+         ret = trap_recv_any_read(c, idx, data, size);
+         if (ret != TRAP_E_TIMEOUT) {
+            goto result;
+         }
+      }
+
+      if (skip != UINT32_MAX) {
+         if (refreshed == 0) {
+            /* find out whether other IFCs have data before the quota is renewed */
+            if (trap_recv_any_wait(c, 0) > 0) {
+               refreshed = 1;
+               continue;
+            }
+         }
+         /* nobody else has data */
+         c->recv_any_burst = 0;
+         refreshed = 0;
+         continue;
+      }
+
+      /* III. wait for data */
+      if (timeout >= 0) {
+         now = trap_recv_any_now();
+         if (now >= deadline) {
+            return trap_error(c, TRAP_E_TIMEOUT);
+         }
+         wait_us = deadline - now;
+      } else {
+         wait_us = UINT64_MAX;
       }
-      sem_wait(&c->sem_collector);
+      if ((polled != 0) && (wait_us > TRAP_RECV_ANY_POLL)) {
+         wait_us = TRAP_RECV_ANY_POLL;
+      } else if (wait_us > 1000000) {
+         /* termination from another thread does not interrupt epoll_wait() */
+         wait_us = 1000000;
+      }
+      if (trap_recv_any_wait(c, wait_us) == -1) {
+         return trap_errorf(c, TRAP_E_IO_ERROR, "Waiting for input IFCs failed: %s", strerror(errno));
+      }
+      refreshed = 1;
+   }
 
-      (*data) = c->in_ifc_results;
-      (*size) = IN_IFC_RESULTS_SIZE(c);
-      return trap_error(c, TRAP_E_OK);
+receive:
+   ret = trap_recv_any_read(c, idx, data, size);
+result:
+   (*ifc) = idx;
+   if ((ret == TRAP_E_OK) || (ret == TRAP_E_FORMAT_CHANGED)) {
+      if (idx == c->recv_any_last) {
+         c->recv_any_burst++;
+      } else {
+         c->recv_any_last = idx;
+         c->recv_any_burst = 1;
+      }
    }
-   return trap_errorf(c, TRAP_E_NOT_SELECTED, "No input ifc to get data from...");
+   return trap_error(c, ret);
 }
 
+/**
+ * @}
+ */
+
 /** Cleanup function.
  * Disconnect all interfaces and do all necessary cleanup.
  * @return Error code
@@ -1866,6 +3568,13 @@ int trap_ctx_send(trap_ctx_t *ctx, unsigned int ifc, const void *data, uint16_t
    if (!c || !c->initialized) {
       return trap_error(c, TRAP_E_NOT_INITIALIZED);
    }
+   if ((ifc < c->num_ifc_out) && (c->out_ifc_list[ifc].mpsc != NULL)) {
+      /* producer threads share nothing but the queue, the context lock is not taken */
+      if (__atomic_load_n(&c->terminated, __ATOMIC_ACQUIRE) != 0) {
+         return trap_error(c, TRAP_E_TERMINATED);
+      }
+      return trap_mpsc_store(c, ifc, data, size);
+   }
    if (pthread_rwlock_rdlock(&c->context_lock) != 0) {
       VERBOSE(CL_ERROR, "Locking of context failed. %s", __func__);
       if (c->terminated == 1) {
@@ -1885,18 +3594,136 @@ int trap_ctx_send(trap_ctx_t *ctx, unsigned int ifc, const void *data, uint16_t
    /* handle buffering */
    ret_val = trap_store_into_buffer(c, ifc, data, size, c->out_ifc_list[ifc].datatimeout, 0);
    if (ret_val == TRAP_E_OK) {
-      c->counter_send_message[ifc]++;
+      TRAP_CNT_ADD(trap_counters_out(&c->counters, ifc)->messages, 1);
    }
    return ret_val;
    #else
    ret_val = c->out_ifc_list[ifc].send(c->out_ifc_list[ifc].priv, data, size, c->out_ifc_list[ifc].datatimeout);
    if (ret_val == TRAP_E_OK) {
-      c->counter_send_message[ifc]++;
+      TRAP_CNT_ADD(trap_counters_out(&c->counters, ifc)->messages, 1);
    }
    return ret_val;
    #endif
 }
 
+int trap_ctx_send_reserve(trap_ctx_t *ctx, unsigned int ifc, uint16_t max_size, void **data)
+{
+   int ret_val = TRAP_E_OK;
+   uint32_t freespace, needed_size = max_size + sizeof(max_size);
+   trap_ctx_priv_t *c = (trap_ctx_priv_t *) ctx;
+   trap_output_ifc_t *o;
+
+   if (!c || !c->initialized) {
+      return trap_error(c, TRAP_E_NOT_INITIALIZED);
+   }
+   if (data == NULL) {
+      return trap_error(c, TRAP_E_BAD_FPARAMS);
+   }
+   (*data) = NULL;
+   if (pthread_rwlock_rdlock(&c->context_lock) != 0) {
+      VERBOSE(CL_ERROR, "Locking of context failed. %s", __func__);
+      if (c->terminated == 1) {
+         return trap_error(c, TRAP_E_TERMINATED);
+      }
+   }
+   if (c->terminated) {
+      pthread_rwlock_unlock(&c->context_lock);
+      return trap_error(c, TRAP_E_TERMINATED);
+   }
+   pthread_rwlock_unlock(&c->context_lock);
+   if (ifc >= c->num_ifc_out) {
+      return trap_error(c, TRAP_E_BAD_IFC_INDEX);
+   }
+   o = &c->out_ifc_list[ifc];
+   if (needed_size > trap_buffer_capacity(o)) {
+      return trap_errorf(c, TRAP_E_MEMORY, "Buffer is too small for this message.");
+   }
+
+   if (o->mpsc != NULL) {
+      return trap_mpsc_reserve(c, ifc, max_size, data);
+   }
+   /* ifc_mtx stays locked until trap_ctx_send_commit(), autoflush just skips this interface meanwhile */
+   pthread_mutex_lock(&o->ifc_mtx);
+
+   freespace = trap_buffer_freespace(o);
+
+   /*
+    * The message must be written into a buffer that can be modified:
+    * send the pending buffer when it is occupied by unsuccessful send,
+    * when there is not enough space or when buffering is disabled.
+    */
+   if ((o->buffer_occupied != 0) || (freespace < needed_size) ||
+       ((o->bufferswitch == 0) && (o->buffer_index != 0))) {
+      ret_val = trap_send_whole_buffer(c, ifc, o->datatimeout);
+      if ((ret_val != TRAP_E_OK) && (ret_val != TRAP_E_IO_ERROR)) {
+         if (ret_val == TRAP_E_TIMEOUT) {
+            TRAP_CNT_ADD(trap_counters_out(&c->counters, ifc)->dropped, 1);
+         }
+         pthread_mutex_unlock(&o->ifc_mtx);
+         return ret_val;
+      }
+      ret_val = TRAP_E_OK;
+   }
+
+   o->reserved_size = needed_size;
+   (*data) = (void *) (o->buffer + o->buffer_index + sizeof(max_size));
+   return ret_val;
+}
+
+int trap_ctx_send_commit(trap_ctx_t *ctx, unsigned int ifc, uint16_t size)
+{
+   int ret_val = TRAP_E_OK;
+   trap_ctx_priv_t *c = (trap_ctx_priv_t *) ctx;
+   trap_output_ifc_t *o;
+
+   if (!c || !c->initialized) {
+      return trap_error(c, TRAP_E_NOT_INITIALIZED);
+   }
+   if (ifc >= c->num_ifc_out) {
+      return trap_error(c, TRAP_E_BAD_IFC_INDEX);
+   }
+   o = &c->out_ifc_list[ifc];
+   if (o->mpsc != NULL) {
+      return trap_mpsc_commit(c, ifc, size);
+   }
+   if (o->reserved_size == 0) {
+      return trap_errorf(c, TRAP_E_BAD_FPARAMS, "Nothing was reserved by trap_ctx_send_reserve().");
+   }
+   if (size + sizeof(size) > o->reserved_size) {
+      o->reserved_size = 0;
+      pthread_mutex_unlock(&o->ifc_mtx);
+      return trap_errorf(c, TRAP_E_BAD_FPARAMS, "Committed message is bigger than reserved space, skipping.");
+   }
+   o->reserved_size = 0;
+
+   if (o->ifc_type != TRAP_IFC_TYPE_BLACKHOLE) {
+#ifndef DISABLE_BUFFERING
+      /* payload is already in place, fix up its header */
+      *((uint16_t *) &o->buffer[o->buffer_index]) = size;
+      o->buffer_index += size + sizeof(size);
+
+      if (o->bufferswitch == 0) {
+         ret_val = trap_send_whole_buffer(c, ifc, o->datatimeout);
+         if (ret_val == TRAP_E_IO_ERROR) {
+            /* we had no client, message is lost */
+            ret_val = TRAP_E_TIMEOUT;
+         } else if (ret_val == TRAP_E_TIMEOUT) {
+            TRAP_CNT_ADD(trap_counters_out(&c->counters, ifc)->dropped, 1);
+         }
+      }
+      trap_autoflush_schedule(c, ifc);
+#else
+      ret_val = o->send(o->priv, o->buffer + sizeof(size), size, o->datatimeout);
+#endif
+   }
+   pthread_mutex_unlock(&o->ifc_mtx);
+
+   if (ret_val == TRAP_E_OK) {
+      TRAP_CNT_ADD(trap_counters_out(&c->counters, ifc)->messages, 1);
+   }
+   return ret_val;
+}
+
 /**
  * Remove setter starting from params string.
  *
@@ -1954,6 +3781,54 @@ static inline void handle_inifc_setters(trap_input_ifc_t *ifc, char *params)
       /* clean the parameter because it was processed */
       remove_setter_from_param(params, p);
    }
+
+   /* codec is announced by output IFC, compress setter is accepted to allow the same IFC spec on both sides */
+   p = strstr(params, "compress=");
+   if (p != NULL) {
+      remove_setter_from_param(params, p);
+   }
+   /* trace is announced by output IFC as well */
+   p = strstr(params, "trace=");
+   if (p != NULL) {
+      remove_setter_from_param(params, p);
+   }
+   /* size of buffers is announced by output IFC as well */
+   p = strstr(params, "bufsize=");
+   if (p != NULL) {
+      remove_setter_from_param(params, p);
+   }
+}
+
+/**
+ * Parse size of buffer from value of setter "bufsize".
+ *
+ * \param[in] str   number of bytes with optional suffix k or M, terminated by ':' or '\0'
+ * \param[out] size parsed size
+ * \return TRAP_E_OK on success, TRAP_E_BADPARAMS when the value is not valid or out of range
+ */
+static int trap_parse_buffer_size(const char *str, uint32_t *size)
+{
+   unsigned long value;
+   char *end;
+
+   errno = 0;
+   value = strtoul(str, &end, 10);
+   if ((end == str) || (errno != 0)) {
+      return TRAP_E_BADPARAMS;
+   }
+   if (*end == 'k') {
+      value *= 1024;
+      end++;
+   } else if (*end == 'M') {
+      value *= 1024 * 1024;
+      end++;
+   }
+   if (((*end != ':') && (*end != 0)) ||
+       (value < TRAP_IFC_BUFFER_SIZE_MIN) || (value > TRAP_IFC_BUFFER_SIZE_MAX)) {
+      return TRAP_E_BADPARAMS;
+   }
+   *size = (uint32_t) value;
+   return TRAP_E_OK;
 }
 
 /**
@@ -1972,7 +3847,7 @@ static inline int trapifc_in_construct(trap_ctx_priv_t *ctx, trap_ifc_spec_t *if
    switch (ifc_spec->types[idx]) {
    case TRAP_IFC_TYPE_GENERATOR:
       /* if (create_generator_ifc("\x10||==::test::==||", &ctx->in_ifc_list[idx]) != TRAP_E_OK)  */
-      if (create_generator_ifc(ctx, ifc_spec->params[idx], &ctx->in_ifc_list[idx]) != TRAP_E_OK) {
+      if (create_generator_ifc(ctx, ifc_spec->params[idx], &ctx->in_ifc_list[idx], idx) != TRAP_E_OK) {
          VERBOSE(CL_ERROR, "Initialization of GENERATOR input interface no. %i failed.", idx);
          goto error;
       }
@@ -1995,6 +3870,12 @@ static inline int trapifc_in_construct(trap_ctx_priv_t *ctx, trap_ifc_spec_t *if
          goto error;
       }
       break;
+   case TRAP_IFC_TYPE_SHM:
+      if (create_shm_receiver_ifc(ctx, ifc_spec->params[idx], &ctx->in_ifc_list[idx], idx) != TRAP_E_OK) {
+         VERBOSE(CL_ERROR, "Initialization of SHM input interface no. %i failed.", idx);
+         goto error;
+      }
+      break;
    default:
       VERBOSE(CL_ERROR, "Unknown input interface type '%c'.", ifc_spec->types[idx]);
       goto error;
@@ -2014,6 +3895,8 @@ error:
 static inline void handle_outifc_setters(trap_output_ifc_t *ifc, char *params)
 {
    char *strval, *p;
+   uint8_t codec;
+   int level;
 
    /* look for timeout setter and set the datatimeout if found */
    p = strstr(params, "timeout=");
@@ -2061,6 +3944,106 @@ static inline void handle_outifc_setters(trap_output_ifc_t *ifc, char *params)
       remove_setter_from_param(params, p);
    }
 
+   /* look for buffers setter and set the number of output buffers if found */
+   p = strstr(params, "buffers=");
+   if (p != NULL) {
+      strval = p + sizeof("buffers=") - 1;
+      if ((sscanf(strval, "%"SCNu32, &ifc->pool_size) != 1) || (ifc->pool_size == 0) ||
+          (ifc->pool_size > TRAP_IFC_MAX_BUFFERS)) {
+         VERBOSE(CL_ERROR, "Bad value for setter \"buffers\", expected 1 to %d.", TRAP_IFC_MAX_BUFFERS);
+         ifc->pool_size = 0;
+      }
+      /* clean the parameter because it was processed */
+      remove_setter_from_param(params, p);
+   }
+
+   /* look for mpsc setter and enable staging buffers of producer threads if found */
+   p = strstr(params, "mpsc=");
+   if (p != NULL) {
+      strval = p + sizeof("mpsc=") - 1;
+      if ((sscanf(strval, "%"SCNu32, &ifc->mpsc_size) != 1) || (ifc->mpsc_size == 0) ||
+          (ifc->mpsc_size > TRAP_IFC_MAX_BUFFERS)) {
+         VERBOSE(CL_ERROR, "Bad value for setter \"mpsc\", expected 1 to %d.", TRAP_IFC_MAX_BUFFERS);
+         ifc->mpsc_size = 0;
+      }
+#ifdef DISABLE_BUFFERING
+      if (ifc->mpsc_size != 0) {
+         VERBOSE(CL_ERROR, "Setter \"mpsc\" needs buffering, it is disabled.");
+         ifc->mpsc_size = 0;
+      }
+#endif
+      /* clean the parameter because it was processed */
+      remove_setter_from_param(params, p);
+   }
+
+   /* look for bufsize setter and set size of buffers if found, it must precede compress */
+   p = strstr(params, "bufsize=");
+   if (p != NULL) {
+      strval = p + sizeof("bufsize=") - 1;
+#if defined(DISABLE_BUFFERING) || !defined(ENABLE_NEGOTIATION)
+      VERBOSE(CL_ERROR, "Setter \"bufsize\" needs buffering and negotiation, default size is used.");
+#else
+      if (strncmp(strval, "auto", 4) == 0) {
+         /* adaptive size with the maximum given optionally as auto-N */
+         strval += 4;
+         ifc->buffer_size = TRAP_IFC_BUFFER_SIZE_MAX;
+         if ((*strval == '-') && (trap_parse_buffer_size(strval + 1, &ifc->buffer_size) != TRAP_E_OK)) {
+            VERBOSE(CL_ERROR, "Bad value for setter \"bufsize\", expected auto-N with N from %d to %d.",
+                    TRAP_IFC_BUFFER_SIZE_MIN, TRAP_IFC_BUFFER_SIZE_MAX);
+            ifc->buffer_size = TRAP_IFC_MESSAGEQ_SIZE;
+         } else {
+            ifc->buffer_adaptive = 1;
+         }
+      } else if (trap_parse_buffer_size(strval, &ifc->buffer_size) != TRAP_E_OK) {
+         VERBOSE(CL_ERROR, "Bad value for setter \"bufsize\", expected auto or %d to %d (suffix k or M).",
+                 TRAP_IFC_BUFFER_SIZE_MIN, TRAP_IFC_BUFFER_SIZE_MAX);
+         ifc->buffer_size = TRAP_IFC_MESSAGEQ_SIZE;
+      }
+#endif
+      /* clean the parameter because it was processed */
+      remove_setter_from_param(params, p);
+   }
+
+   /* look for compress setter and enable compression of buffers if found */
+   p = strstr(params, "compress=");
+   if (p != NULL) {
+      strval = p + sizeof("compress=") - 1;
+      if (trap_compress_parse(strval, &codec, &level) != TRAP_E_OK) {
+         VERBOSE(CL_ERROR, "Unknown or unavailable codec for setter \"compress\".");
+      } else if (codec != TRAP_CODEC_NONE) {
+#if defined(DISABLE_BUFFERING) || !defined(ENABLE_NEGOTIATION)
+         VERBOSE(CL_ERROR, "Setter \"compress\" needs buffering and negotiation, compression is disabled.");
+#else
+         trap_compress_destroy(ifc->compress);
+         ifc->compress = trap_compress_create(codec, level, ifc->buffer_size);
+         if (ifc->compress == NULL) {
+            VERBOSE(CL_ERROR, "Not enough memory for compression of buffers.");
+         }
+#endif
+      }
+      /* clean the parameter because it was processed */
+      remove_setter_from_param(params, p);
+   }
+
+   /* look for trace setter and enable tracing of buffers if found */
+   p = strstr(params, "trace=");
+   if (p != NULL) {
+      strval = p + sizeof("trace=") - 1;
+      if (strncmp(strval, "on", 2) == 0) {
+#if defined(DISABLE_BUFFERING) || !defined(ENABLE_NEGOTIATION)
+         VERBOSE(CL_ERROR, "Setter \"trace\" needs buffering and negotiation, tracing is disabled.");
+#else
+         ifc->trace = 1;
+#endif
+      } else if (strncmp(strval, "off", 3) == 0) {
+         ifc->trace = 0;
+      } else {
+         VERBOSE(CL_ERROR, "Unknown value for setter \"trace\".");
+      }
+      /* clean the parameter because it was processed */
+      remove_setter_from_param(params, p);
+   }
+
    /* look for autoflush setter and set the it if found */
    p = strstr(params, "autoflush=");
    if (p != NULL) {
@@ -2088,9 +4071,17 @@ static inline void handle_outifc_setters(trap_output_ifc_t *ifc, char *params)
  */
 static inline int trapifc_out_construct(trap_ctx_priv_t *ctx, trap_ifc_spec_t *ifc_spec, int idx)
 {
+#if !defined(DISABLE_BUFFERING) && defined(ENABLE_NEGOTIATION)
+   /* tracing of all output IFCs can be requested by environment, setter "trace=off" disables it */
+   if ((ifc_spec->types[ctx->num_ifc_in + idx] != TRAP_IFC_TYPE_BLACKHOLE) && trap_trace_env()) {
+      ctx->out_ifc_list[idx].trace = 1;
+   }
+#endif
    /* Common setters - this should be done before the constructor */
    handle_outifc_setters(&ctx->out_ifc_list[idx],
                          ifc_spec->params[ctx->num_ifc_in + idx]);
+   /* type is needed by the blackhole shortcut of trap_store_into_buffer() and by the buffer pool */
+   ctx->out_ifc_list[idx].ifc_type = ifc_spec->types[ctx->num_ifc_in + idx];
 
    /* call correct constructor of interface */
    switch (ifc_spec->types[ctx->num_ifc_in + idx]) {
@@ -2120,6 +4111,12 @@ static inline int trapifc_out_construct(trap_ctx_priv_t *ctx, trap_ifc_spec_t *i
          goto error;
       }
       break;
+   case TRAP_IFC_TYPE_SHM:
+      if (create_shm_sender_ifc(ctx, ifc_spec->params[ctx->num_ifc_in + idx], &ctx->out_ifc_list[idx], idx) != TRAP_E_OK) {
+         VERBOSE(CL_ERROR, "Initialization of SHM output interface no. %i failed.", idx);
+         goto error;
+      }
+      break;
    default:
       VERBOSE(CL_ERROR, "Unknown output interface type '%c'.", ifc_spec->types[ctx->num_ifc_in + idx]);
       goto error;
@@ -2178,12 +4175,11 @@ trap_ctx_t *trap_ctx_init(trap_module_info_t *module_info, trap_ifc_spec_t ifc_s
       return ctx;
    }
 
-   ctx->counter_send_message = (uint64_t *) calloc(ctx->num_ifc_out, sizeof(uint64_t));
-   ctx->counter_recv_message = (uint64_t *) calloc(ctx->num_ifc_in, sizeof(uint64_t));
-   ctx->counter_send_buffer = (uint64_t *) calloc(ctx->num_ifc_out, sizeof(uint64_t));
-   ctx->counter_autoflush = (uint64_t *) calloc(ctx->num_ifc_out, sizeof(uint64_t));
-   ctx->counter_recv_buffer = (uint64_t *) calloc(ctx->num_ifc_in, sizeof(uint64_t));
-   ctx->counter_dropped_message = (uint64_t *) calloc(ctx->num_ifc_out, sizeof(uint64_t));
+   trap_trace_init(&ctx->trace);
+   if (trap_counters_init(&ctx->counters, ctx->num_ifc_in, ctx->num_ifc_out) != TRAP_E_OK) {
+      trap_error(ctx, TRAP_E_MEMORY);
+      goto alloc_counter_failed;
+   }
 
    // Create input interfaces
    if (ctx->num_ifc_in > 0) {
@@ -2226,6 +4222,7 @@ trap_ctx_t *trap_ctx_init(trap_module_info_t *module_info, trap_ifc_spec_t ifc_s
 
       ctx->in_ifc_list[i].req_data_type = TRAP_FMT_UNKNOWN;
       ctx->in_ifc_list[i].req_data_fmt_spec = NULL;
+      ctx->in_ifc_list[i].any_fd = -1;
 
       if (pthread_mutex_init(&ctx->in_ifc_list[i].ifc_mtx, NULL) != 0) {
          goto freein_readers;
@@ -2258,6 +4255,8 @@ trap_ctx_t *trap_ctx_init(trap_module_info_t *module_info, trap_ifc_spec_t ifc_s
       }
       ctx->in_ifc_list[i].buffer_full = 0;
       ctx->in_ifc_list[i].buffer_pointer = ctx->in_ifc_list[i].buffer;
+      /* grows during negotiation when output IFC announces bigger buffers */
+      ctx->in_ifc_list[i].buffer_size = TRAP_IFC_MESSAGEQ_SIZE;
 
       /* call input IFC constructor */
       if (trapifc_in_construct(ctx, &ifc_spec, i) == EXIT_FAILURE) {
@@ -2282,29 +4281,52 @@ trap_ctx_t *trap_ctx_init(trap_module_info_t *module_info, trap_ifc_spec_t ifc_s
       ctx->out_ifc_list[i].data_type = TRAP_FMT_UNKNOWN;
       ctx->out_ifc_list[i].data_fmt_spec = NULL;
 
-      ctx->out_ifc_list[i].buffer_header = (void *) calloc(1, TRAP_IFC_MESSAGEQ_SIZE + sizeof(trap_buffer_header_t) + 1);
-      if (ctx->out_ifc_list[i].buffer_header == NULL) {
-         trap_errorf(ctx, TRAP_E_MEMORY, "Not enough memory for input ifc buffer.");
-         goto freein_on_failed;
-      }
-      ctx->out_ifc_list[i].buffer = ((trap_buffer_header_t *) ctx->out_ifc_list[i].buffer_header)->data;
       ctx->out_ifc_list[i].buffer_index = 0;
-      ctx->out_ifc_list[i].bufferflush = 0;
+      ctx->out_ifc_list[i].flush_deadline = 0;
       if (pthread_mutex_init(&ctx->out_ifc_list[i].ifc_mtx, NULL) != 0) {
          goto freein_on_failed;
       }
       ctx->out_ifc_list[i].timeout = TRAP_IFC_TIMEOUT;
       ctx->out_ifc_list[i].bufferswitch = 1;
+      ctx->out_ifc_list[i].buffer_size = TRAP_IFC_MESSAGEQ_SIZE;
 
       /* call output IFC constructor */
       if (trapifc_out_construct(ctx, &ifc_spec, i) == EXIT_FAILURE) {
          goto freeall_on_failed;
       }
 
+      /* size of buffer is known after setters */
+      ctx->out_ifc_list[i].buffer_header = (void *) calloc(1, ctx->out_ifc_list[i].buffer_size + sizeof(trap_buffer_header_t) + 1);
+      if (ctx->out_ifc_list[i].buffer_header == NULL) {
+         trap_errorf(ctx, TRAP_E_MEMORY, "Not enough memory for output ifc buffer.");
+         goto freeall_on_failed;
+      }
+      ctx->out_ifc_list[i].buffer = ((trap_buffer_header_t *) ctx->out_ifc_list[i].buffer_header)->data;
+      ctx->out_ifc_list[i].flush_limit = trap_buffer_capacity(&ctx->out_ifc_list[i]);
+
+      /* start sender thread if more buffers were requested */
+      if ((ctx->out_ifc_list[i].pool_size > 1) && (ctx->out_ifc_list[i].mpsc_size == 0) &&
+          (ctx->out_ifc_list[i].ifc_type != TRAP_IFC_TYPE_BLACKHOLE)) {
+         if (trap_buffer_pool_create(ctx, i) != TRAP_E_OK) {
+            goto freeall_on_failed;
+         }
+      }
+      /* start sender thread of staging buffers if multiple producers were requested */
+      if (ctx->out_ifc_list[i].mpsc_size > 0) {
+         if (trap_mpsc_create(ctx, i, ctx->out_ifc_list[i].mpsc_size) != TRAP_E_OK) {
+            goto freeall_on_failed;
+         }
+      }
+      trap_output_register_buffers(&ctx->out_ifc_list[i]);
+
    }
 
    if (ctx->num_ifc_out > 0) {
-      ctx->ifc_autoflush_timeout = calloc(ctx->num_ifc_out, sizeof(struct out_ifc_timeout_s));
+      ctx->autoflush_fd = timerfd_create(CLOCK_MONOTONIC, TFD_CLOEXEC);
+      if (ctx->autoflush_fd == -1) {
+         trap_errorf(ctx, TRAP_E_IO_ERROR, "Creation of autoflush timer failed: %s", strerror(errno));
+         goto freeall_on_failed;
+      }
       // Create thread for handling timeouts outputs interfaces
       if (pthread_create(&ctx->timeout_thread, NULL, trap_automatic_flush_thr, (void *) ctx) != 0) {
          VERBOSE(CL_ERROR, "Creation of timeout handler thread failed.");
@@ -2332,6 +4354,10 @@ trap_ctx_t *trap_ctx_init(trap_module_info_t *module_info, trap_ifc_spec_t ifc_s
 
 freeall_on_failed:
    for (i=0; i<ctx->num_ifc_out; ++i) {
+      trap_mpsc_destroy(&ctx->out_ifc_list[i]);
+      trap_buffer_pool_destroy(&ctx->out_ifc_list[i]);
+      trap_compress_destroy(ctx->out_ifc_list[i].compress);
+      ctx->out_ifc_list[i].compress = NULL;
       pthread_mutex_destroy(&ctx->out_ifc_list[i].ifc_mtx);
       if (ctx->out_ifc_list != NULL && ctx->out_ifc_list[i].destroy != NULL) {
          if (ctx->out_ifc_list[i].priv != NULL) {
@@ -2381,30 +4407,6 @@ freein_list:
       ctx->in_ifc_list = NULL;
    }
 alloc_counter_failed:
-   if (ctx->counter_send_message) {
-      free(ctx->counter_send_message);
-      ctx->counter_send_message = NULL;
-   }
-   if (ctx->counter_recv_message) {
-      free(ctx->counter_recv_message);
-      ctx->counter_recv_message = NULL;
-   }
-   if (ctx->counter_send_buffer) {
-      free(ctx->counter_send_buffer);
-      ctx->counter_send_buffer = NULL;
-   }
-   if (ctx->counter_autoflush) {
-      free(ctx->counter_autoflush);
-      ctx->counter_autoflush = NULL;
-   }
-   if (ctx->counter_recv_buffer) {
-      free(ctx->counter_recv_buffer);
-      ctx->counter_recv_buffer = NULL;
-   }
-   if (ctx->counter_dropped_message) {
-      free(ctx->counter_dropped_message);
-      ctx->counter_dropped_message = NULL;
-   }
    trap_free_ctx_t(&ctx);
    return ctx;
 }
@@ -2424,6 +4426,7 @@ int trap_ctx_vifcctl(trap_ctx_t *ctx, int8_t type, uint32_t ifcidx, int32_t requ
    char en_dis_switch = 0;
    uint64_t timeout = 0;
    int32_t datatimeout;
+   uint32_t buffers;
    trap_ctx_priv_t *c = ctx;
 
    if ((ifcidx >= c->num_ifc_out) && (ifcidx >= c->num_ifc_in)) {
@@ -2449,7 +4452,9 @@ int trap_ctx_vifcctl(trap_ctx_t *ctx, int8_t type, uint32_t ifcidx, int32_t requ
          pthread_mutex_lock(&c->out_ifc_list[ifcidx].ifc_mtx);
          if (c->out_ifc_list[ifcidx].timeout_fixed == 0) {
             c->out_ifc_list[ifcidx].timeout = timeout;
-            c->ifc_change = 1;
+            /* the new timeout applies to data already in the buffer */
+            c->out_ifc_list[ifcidx].flush_deadline = 0;
+            trap_autoflush_schedule(c, ifcidx);
          }
          pthread_mutex_unlock(&c->out_ifc_list[ifcidx].ifc_mtx);
       }
@@ -2462,7 +4467,7 @@ int trap_ctx_vifcctl(trap_ctx_t *ctx, int8_t type, uint32_t ifcidx, int32_t requ
          pthread_mutex_lock(&c->out_ifc_list[ifcidx].ifc_mtx);
          if (c->out_ifc_list[ifcidx].bufferswitch_fixed == 0) {
             c->out_ifc_list[ifcidx].bufferswitch = en_dis_switch;
-            c->ifc_change = 1;
+            trap_autoflush_schedule(c, ifcidx);
          }
          pthread_mutex_unlock(&c->out_ifc_list[ifcidx].ifc_mtx);
       }
@@ -2485,6 +4490,33 @@ int trap_ctx_vifcctl(trap_ctx_t *ctx, int8_t type, uint32_t ifcidx, int32_t requ
          }
       }
       break;
+   case TRAPCTL_MPSC:
+      buffers = (uint32_t) va_arg(ap, uint32_t);
+      VERBOSE(CL_VERBOSE_BASIC, "%s ifc %d: Enabling multi-producer sending with %"PRIu32" buffers.",
+              ifcdir2str(type), (int) ifcidx, buffers);
+#ifndef DISABLE_BUFFERING
+      if ((type == TRAPIFC_OUTPUT) && (ifcidx < c->num_ifc_out) && (buffers > 0) && (buffers <= TRAP_IFC_MAX_BUFFERS)) {
+         pthread_mutex_lock(&c->out_ifc_list[ifcidx].ifc_mtx);
+         if (c->out_ifc_list[ifcidx].mpsc == NULL) {
+            trap_mpsc_create(c, ifcidx, buffers);
+         }
+         pthread_mutex_unlock(&c->out_ifc_list[ifcidx].ifc_mtx);
+      } else {
+         VERBOSE(CL_ERROR, "Multi-producer sending can be enabled on output interface with 1 to %d buffers only.", TRAP_IFC_MAX_BUFFERS);
+      }
+#else
+      VERBOSE(CL_ERROR, "Multi-producer sending needs buffering, it is disabled.");
+#endif
+      break;
+   case TRAPCTL_RECV_QUOTA:
+      if ((type == TRAPIFC_INPUT) && (ifcidx < c->num_ifc_in)) {
+         c->in_ifc_list[ifcidx].recv_quota = (uint32_t) va_arg(ap, uint32_t);
+         VERBOSE(CL_VERBOSE_BASIC, "%s ifc %d: Setting receive quota to %"PRIu32".",
+                 ifcdir2str(type), (int) ifcidx, c->in_ifc_list[ifcidx].recv_quota);
+      } else {
+         VERBOSE(CL_ERROR, "Receive quota can be set on input interface only.");
+      }
+      break;
 
    default:
       VERBOSE(CL_ERROR, "Unknown type of request.");
@@ -2512,6 +4544,12 @@ void trap_ctx_send_flush(trap_ctx_t *ctx, uint32_t ifc)
       return;
    }
    trap_store_into_buffer(c, ifc, (void *) c, 0, c->out_ifc_list[ifc].datatimeout, 1);
+   if (c->out_ifc_list[ifc].pool != NULL) {
+      trap_buffer_pool_wait_sent(c->out_ifc_list[ifc].pool);
+   }
+   if (c->out_ifc_list[ifc].mpsc != NULL) {
+      trap_mpsc_flush(c->out_ifc_list[ifc].mpsc);
+   }
 }
 
 /**
@@ -2587,8 +4625,10 @@ int encode_cnts_to_json(char **data, trap_ctx_priv_t *ctx)
 {
    uint x = 0;
 
+   trap_counters_block_t *sum = NULL;
    json_t *in_ifc_cnts  = NULL;
    json_t *out_ifc_cnts = NULL;
+   json_t *ifc_stats = NULL;
 
    json_t *in_ifces_arr = json_array();
    if (in_ifces_arr == NULL) {
@@ -2603,8 +4643,30 @@ int encode_cnts_to_json(char **data, trap_ctx_priv_t *ctx)
 
    json_t *result_json = NULL;
 
+   /* counters of all threads are summed only here, on request of supervisor */
+   sum = trap_counters_sum(&ctx->counters);
+   if (sum == NULL) {
+      VERBOSE(CL_ERROR, "Service thread - could not allocate memory for sum of counters.");
+      goto clean_up;
+   }
+
    for (x = 0; x < ctx->num_ifc_in; x++) {
-      in_ifc_cnts = json_pack("{sisi}", "messages", ctx->counter_recv_message[x], "buffers", ctx->counter_recv_buffer[x]);
+      in_ifc_cnts = trap_counters_in_json(&sum->in[x]);
+      if ((in_ifc_cnts != NULL) && (ctx->in_ifc_list[x].get_stats != NULL)) {
+         /* add counters specific for the type of IFC */
+         ifc_stats = ctx->in_ifc_list[x].get_stats(ctx->in_ifc_list[x].priv);
+         if (ifc_stats != NULL) {
+            json_object_update(in_ifc_cnts, ifc_stats);
+            json_decref(ifc_stats);
+         }
+      }
+      if ((in_ifc_cnts != NULL) && (ctx->in_ifc_list[x].compress != NULL)) {
+         ifc_stats = trap_compress_get_stats(ctx->in_ifc_list[x].compress);
+         if (ifc_stats != NULL) {
+            json_object_update(in_ifc_cnts, ifc_stats);
+            json_decref(ifc_stats);
+         }
+      }
       if (json_array_append_new(in_ifces_arr, in_ifc_cnts) == -1) {
          VERBOSE(CL_ERROR, "Service thread - could not append new item to out_ifces_arr while creating json string with counters..\n");
          goto clean_up;
@@ -2612,7 +4674,22 @@ int encode_cnts_to_json(char **data, trap_ctx_priv_t *ctx)
    }
 
    for (x = 0; x < ctx->num_ifc_out; x++) {
-      out_ifc_cnts = json_pack("{sisisisi}", "sent-messages", ctx->counter_send_message[x], "dropped-messages", ctx->counter_dropped_message[x], "buffers", ctx->counter_send_buffer[x], "autoflushes", ctx->counter_autoflush[x]);
+      out_ifc_cnts = trap_counters_out_json(&sum->out[x]);
+      if ((out_ifc_cnts != NULL) && (ctx->out_ifc_list[x].get_stats != NULL)) {
+         /* add counters specific for the type of IFC */
+         ifc_stats = ctx->out_ifc_list[x].get_stats(ctx->out_ifc_list[x].priv);
+         if (ifc_stats != NULL) {
+            json_object_update(out_ifc_cnts, ifc_stats);
+            json_decref(ifc_stats);
+         }
+      }
+      if ((out_ifc_cnts != NULL) && (ctx->out_ifc_list[x].compress != NULL)) {
+         ifc_stats = trap_compress_get_stats(ctx->out_ifc_list[x].compress);
+         if (ifc_stats != NULL) {
+            json_object_update(out_ifc_cnts, ifc_stats);
+            json_decref(ifc_stats);
+         }
+      }
       if (json_array_append_new(out_ifces_arr, out_ifc_cnts) == -1) {
          VERBOSE(CL_ERROR, "Service thread - could not append new item to out_ifces_arr while creating json string with counters..\n");
          goto clean_up;
@@ -2626,10 +4703,12 @@ int encode_cnts_to_json(char **data, trap_ctx_priv_t *ctx)
    }
    *data =  json_dumps(result_json, 0);
    json_decref(result_json);
+   free(sum);
    return 0;
 
 
 clean_up:
+   free(sum);
    return -1;
 }
 
@@ -2647,7 +4726,7 @@ void *service_thread_routine(void *arg)
    struct timeval tv;
    msg_header_t *header = (msg_header_t *) calloc(1, sizeof(msg_header_t));
    char *json_data = NULL;
-   int ret_val, y, supervisor_sd;
+   int ret_val, supervisor_sd;
    trap_output_ifc_t *service_ifc = (trap_output_ifc_t *) calloc(1, sizeof(trap_output_ifc_t));
    tcpip_sender_private_t *priv;
    int i; /* loop var */
@@ -2763,30 +4842,9 @@ void *service_thread_routine(void *arg)
                      continue;
                   }
 
-                     VERBOSE(CL_VERBOSE_ADVANCED,"counter_recv_message:  ");
-                     for (y=0; y<g_ctx->num_ifc_in; ++y) {
-                        VERBOSE(CL_VERBOSE_ADVANCED,"%"PRIu64"  ", g_ctx->counter_recv_message[y]);
-                     }
-                     VERBOSE(CL_VERBOSE_ADVANCED,"counter_recv_buffer:  ");
-                     for (y=0; y<g_ctx->num_ifc_in; ++y) {
-                        VERBOSE(CL_VERBOSE_ADVANCED,"%"PRIu64"  ", g_ctx->counter_recv_buffer[y]);
-                     }
-                     VERBOSE(CL_VERBOSE_ADVANCED,"counter_send_message:  ");
-                     for (y=0;y<g_ctx->num_ifc_out; ++y) {
-                        VERBOSE(CL_VERBOSE_ADVANCED,"%"PRIu64"  ", g_ctx->counter_send_message[y]);
-                     }
-                     VERBOSE(CL_VERBOSE_ADVANCED,"counter_send_buffer:  ");
-                     for (y=0; y<g_ctx->num_ifc_out; ++y) {
-                        VERBOSE(CL_VERBOSE_ADVANCED,"%"PRIu64"  ", g_ctx->counter_send_buffer[y]);
-                     }
-                     VERBOSE(CL_VERBOSE_ADVANCED,"counter_autoflush:  ");
-                     for (y=0; y<g_ctx->num_ifc_out; ++y) {
-                        VERBOSE(CL_VERBOSE_ADVANCED,"%"PRIu64"  ", g_ctx->counter_autoflush[y]);
-                     }
-                     VERBOSE(CL_VERBOSE_ADVANCED,"counter_dropped_message:  ");
-                     for (y=0; y<g_ctx->num_ifc_out; ++y) {
-                        VERBOSE(CL_VERBOSE_ADVANCED,"%"PRIu64"  ", g_ctx->counter_dropped_message[y]);
-                     }
+                  VERBOSE(CL_VERBOSE_ADVANCED, "Service sent counters: %s", json_data);
+                  free(json_data);
+                  json_data = NULL;
                }
             }
          }
@@ -2816,11 +4874,13 @@ accept_success:
       }
    }
 
+   service_ifc->terminate(service_ifc->priv);
+   service_ifc->destroy(service_ifc->priv);
+
 exit_service_thread:
+   /* errors before creation of the service IFC jump here, its terminate() and destroy() are NULL */
    free(header);
    free(data);
-   service_ifc->terminate(service_ifc->priv);
-   service_ifc->destroy(service_ifc->priv);
    free(service_ifc);
    pthread_exit(NULL);
 }
@@ -3159,7 +5219,7 @@ int output_ifc_negotiation(void *ifc_priv_data, char ifc_type, int sock_d)
    VERBOSE(CL_VERBOSE_LIBRARY, "--- Output IFC negotiation ---");
 
    hello_msg_header_t *hello_msg_header = NULL;
-   uint32_t size_of_buffer = sizeof(hello_msg_header_t);
+   uint32_t size_of_buffer = sizeof(hello_msg_header_t) + sizeof(uint32_t);
    char *buffer = (char *) calloc(size_of_buffer, sizeof(char));
    char *p = NULL;
    uint32_t size = 0;
@@ -3168,9 +5228,11 @@ int output_ifc_negotiation(void *ifc_priv_data, char ifc_type, int sock_d)
    int compare = 0;
    file_private_t *file_ifc_priv = NULL;
    tcpip_sender_private_t *tcp_ifc_priv = NULL;
+   shm_sender_private_t *shm_ifc_priv = NULL;
    uint8_t data_type = TRAP_FMT_UNKNOWN;
    char *data_fmt_spec = NULL;
    uint32_t ifc_idx = 0;
+   trap_ctx_priv_t *ctx_priv = NULL;
 
    // Decide which structure can be used for interfaces private data
    if (ifc_type == TRAP_IFC_TYPE_FILE) {
@@ -3178,11 +5240,19 @@ int output_ifc_negotiation(void *ifc_priv_data, char ifc_type, int sock_d)
       data_type = file_ifc_priv->ctx->out_ifc_list[file_ifc_priv->ifc_idx].data_type;
       data_fmt_spec = file_ifc_priv->ctx->out_ifc_list[file_ifc_priv->ifc_idx].data_fmt_spec;
       ifc_idx = file_ifc_priv->ifc_idx;
+      ctx_priv = file_ifc_priv->ctx;
    } else if (ifc_type == TRAP_IFC_TYPE_TCPIP || ifc_type == TRAP_IFC_TYPE_UNIX) {
       tcp_ifc_priv = (tcpip_sender_private_t *) ifc_priv_data;
       data_type = tcp_ifc_priv->ctx->out_ifc_list[tcp_ifc_priv->ifc_idx].data_type;
       data_fmt_spec = tcp_ifc_priv->ctx->out_ifc_list[tcp_ifc_priv->ifc_idx].data_fmt_spec;
       ifc_idx = tcp_ifc_priv->ifc_idx;
+      ctx_priv = tcp_ifc_priv->ctx;
+   } else if (ifc_type == TRAP_IFC_TYPE_SHM) {
+      shm_ifc_priv = (shm_sender_private_t *) ifc_priv_data;
+      data_type = shm_ifc_priv->ctx->out_ifc_list[shm_ifc_priv->ifc_idx].data_type;
+      data_fmt_spec = shm_ifc_priv->ctx->out_ifc_list[shm_ifc_priv->ifc_idx].data_fmt_spec;
+      ifc_idx = shm_ifc_priv->ifc_idx;
+      ctx_priv = shm_ifc_priv->ctx;
    } else {
       neg_result = NEG_RES_FAILED;
       goto out_neg_exit;
@@ -3200,13 +5270,22 @@ int output_ifc_negotiation(void *ifc_priv_data, char ifc_type, int sock_d)
       neg_result = NEG_RES_FMT_UNKNOWN;
       if (ifc_type == TRAP_IFC_TYPE_FILE) {
          goto out_neg_exit;
-      } else if (ifc_type == TRAP_IFC_TYPE_TCPIP || ifc_type == TRAP_IFC_TYPE_UNIX) {
+      } else if (ifc_type == TRAP_IFC_TYPE_TCPIP || ifc_type == TRAP_IFC_TYPE_UNIX || ifc_type == TRAP_IFC_TYPE_SHM) {
          VERBOSE(CL_VERBOSE_LIBRARY, "Output interface negotiation - gonna send header with TRAP_FMT_UNKNOWN.");
          hello_msg_header->data_type = TRAP_FMT_UNKNOWN;
          hello_msg_header->data_fmt_spec_size = 0;
       }
    } else {
       hello_msg_header->data_type = data_type;
+      if (ctx_priv->out_ifc_list[ifc_idx].compress != NULL) {
+         hello_msg_header->codec = ctx_priv->out_ifc_list[ifc_idx].compress->codec;
+      }
+      if (ctx_priv->out_ifc_list[ifc_idx].trace) {
+         hello_msg_header->flags |= TRAP_HELLO_TRACE;
+      }
+      if (ctx_priv->out_ifc_list[ifc_idx].buffer_size != TRAP_IFC_MESSAGEQ_SIZE) {
+         hello_msg_header->flags |= TRAP_HELLO_BUFFER_SIZE;
+      }
       if (data_type == TRAP_FMT_RAW) {
          hello_msg_header->data_fmt_spec_size = 0;
       } else {
@@ -3216,6 +5295,11 @@ int output_ifc_negotiation(void *ifc_priv_data, char ifc_type, int sock_d)
 
    memcpy(buffer, hello_msg_header, sizeof(hello_msg_header_t));
    size = sizeof(hello_msg_header_t);
+   if (hello_msg_header->flags & TRAP_HELLO_BUFFER_SIZE) {
+      /* size of buffers follows the header */
+      memcpy(buffer + size, &ctx_priv->out_ifc_list[ifc_idx].buffer_size, sizeof(uint32_t));
+      size += sizeof(uint32_t);
+   }
    p = buffer;
 
 
@@ -3223,7 +5307,7 @@ int output_ifc_negotiation(void *ifc_priv_data, char ifc_type, int sock_d)
    if (ifc_type == TRAP_IFC_TYPE_FILE) {
       ret_val = fwrite((void *) p, sizeof(char), size, file_ifc_priv->fd);
       compare = size;
-   } else if (ifc_type == TRAP_IFC_TYPE_TCPIP || ifc_type == TRAP_IFC_TYPE_UNIX) {
+   } else if (ifc_type == TRAP_IFC_TYPE_TCPIP || ifc_type == TRAP_IFC_TYPE_UNIX || ifc_type == TRAP_IFC_TYPE_SHM) {
       ret_val = service_send_data(sock_d, size, (void **)&p);
       compare = TRAP_E_OK;
    }
@@ -3256,7 +5340,7 @@ int output_ifc_negotiation(void *ifc_priv_data, char ifc_type, int sock_d)
       if (ifc_type == TRAP_IFC_TYPE_FILE) {
          ret_val = fwrite((void *) p, sizeof(char), size, file_ifc_priv->fd);
          compare = size;
-      } else if (ifc_type == TRAP_IFC_TYPE_TCPIP || ifc_type == TRAP_IFC_TYPE_UNIX) {
+      } else if (ifc_type == TRAP_IFC_TYPE_TCPIP || ifc_type == TRAP_IFC_TYPE_UNIX || ifc_type == TRAP_IFC_TYPE_SHM) {
          ret_val = service_send_data(sock_d, size, (void **)&p);
          compare = TRAP_E_OK;
       }
@@ -3284,11 +5368,45 @@ out_neg_exit:
 }
 
 
+/**
+ * Grow buffer of input interface to receive buffers of the given size.
+ *
+ * Buffer is never shrunk, so data of the previous output IFC (e.g. previous file)
+ * still fit.  Interfaces must take in_ifc->buffer again after negotiation because
+ * it can be reallocated.
+ *
+ * \param[in,out] ifc  input interface, its buffer is empty during negotiation
+ * \param[in] size     size of buffers announced by output interface
+ * \return TRAP_E_OK on success, TRAP_E_BADPARAMS when size is too big, TRAP_E_MEMORY
+ */
+static int trap_input_buffer_resize(trap_input_ifc_t *ifc, uint32_t size)
+{
+   void *buffer;
+
+   if (size <= ifc->buffer_size) {
+      return TRAP_E_OK;
+   }
+   if (size > TRAP_IFC_BUFFER_SIZE_MAX) {
+      return TRAP_E_BADPARAMS;
+   }
+   /* extra byte as in trap_ctx_init() */
+   buffer = realloc(ifc->buffer, size + 1);
+   if (buffer == NULL) {
+      return TRAP_E_MEMORY;
+   }
+   ifc->buffer = buffer;
+   ifc->buffer_pointer = buffer;
+   ifc->buffer_full = 0;
+   ifc->buffer_size = size;
+   return TRAP_E_OK;
+}
+
 int input_ifc_negotiation(void *ifc_priv_data, char ifc_type)
 {
    VERBOSE(CL_VERBOSE_LIBRARY, "--- Input IFC negotiation ---");
 
    uint32_t size = 0;
+   uint32_t buffer_size = TRAP_IFC_MESSAGEQ_SIZE;
    hello_msg_header_t *hello_msg_header = calloc(1, sizeof(hello_msg_header_t));
    int ret_val = 0;
    void *p_p = NULL;
@@ -3297,6 +5415,10 @@ int input_ifc_negotiation(void *ifc_priv_data, char ifc_type)
 
    file_private_t *file_ifc_priv = NULL;
    tcpip_receiver_private_t *tcp_ifc_priv = NULL;
+   shm_receiver_private_t *shm_ifc_priv = NULL;
+   trap_input_ifc_t *sock_ifc = NULL;
+   trap_input_ifc_t *in_ifc = NULL;
+   int sock_d = -1;
    uint8_t req_data_type = TRAP_FMT_UNKNOWN;
    char *req_data_fmt_spec = NULL;
    char *current_data_fmt_spec = NULL;
@@ -3308,11 +5430,23 @@ int input_ifc_negotiation(void *ifc_priv_data, char ifc_type)
       req_data_type = file_ifc_priv->ctx->in_ifc_list[file_ifc_priv->ifc_idx].req_data_type;
       req_data_fmt_spec = file_ifc_priv->ctx->in_ifc_list[file_ifc_priv->ifc_idx].req_data_fmt_spec;
       current_data_fmt_spec = file_ifc_priv->ctx->in_ifc_list[file_ifc_priv->ifc_idx].data_fmt_spec;
+      in_ifc = &file_ifc_priv->ctx->in_ifc_list[file_ifc_priv->ifc_idx];
    } else if (ifc_type == TRAP_IFC_TYPE_TCPIP || ifc_type == TRAP_IFC_TYPE_UNIX) {
       tcp_ifc_priv = (tcpip_receiver_private_t *) ifc_priv_data;
       req_data_type = tcp_ifc_priv->ctx->in_ifc_list[tcp_ifc_priv->ifc_idx].req_data_type;
       req_data_fmt_spec = tcp_ifc_priv->ctx->in_ifc_list[tcp_ifc_priv->ifc_idx].req_data_fmt_spec;
       current_data_fmt_spec = tcp_ifc_priv->ctx->in_ifc_list[tcp_ifc_priv->ifc_idx].data_fmt_spec;
+      sock_ifc = &tcp_ifc_priv->ctx->in_ifc_list[tcp_ifc_priv->ifc_idx];
+      in_ifc = sock_ifc;
+      sock_d = tcp_ifc_priv->sd;
+   } else if (ifc_type == TRAP_IFC_TYPE_SHM) {
+      shm_ifc_priv = (shm_receiver_private_t *) ifc_priv_data;
+      req_data_type = shm_ifc_priv->ctx->in_ifc_list[shm_ifc_priv->ifc_idx].req_data_type;
+      req_data_fmt_spec = shm_ifc_priv->ctx->in_ifc_list[shm_ifc_priv->ifc_idx].req_data_fmt_spec;
+      current_data_fmt_spec = shm_ifc_priv->ctx->in_ifc_list[shm_ifc_priv->ifc_idx].data_fmt_spec;
+      sock_ifc = &shm_ifc_priv->ctx->in_ifc_list[shm_ifc_priv->ifc_idx];
+      in_ifc = sock_ifc;
+      sock_d = shm_ifc_priv->sd;
    } else {
       neg_result = NEG_RES_FAILED;
       goto in_neg_exit;
@@ -3327,8 +5461,8 @@ int input_ifc_negotiation(void *ifc_priv_data, char ifc_type)
    if (ifc_type == TRAP_IFC_TYPE_FILE) {
       ret_val = fread(p_p, sizeof(char), size, file_ifc_priv->fd);
       compare = size;
-   } else if (ifc_type == TRAP_IFC_TYPE_TCPIP || ifc_type == TRAP_IFC_TYPE_UNIX) {
-      ret_val = service_get_data(tcp_ifc_priv->sd, size, &p_p);
+   } else if (ifc_type == TRAP_IFC_TYPE_TCPIP || ifc_type == TRAP_IFC_TYPE_UNIX || ifc_type == TRAP_IFC_TYPE_SHM) {
+      ret_val = service_get_data(sock_d, size, &p_p);
       compare = TRAP_E_OK;
    }
    if (ret_val != compare) {
@@ -3336,8 +5470,8 @@ int input_ifc_negotiation(void *ifc_priv_data, char ifc_type)
       VERBOSE(CL_VERBOSE_LIBRARY, "ERROR");
       if (ifc_type == TRAP_IFC_TYPE_FILE) {
          file_ifc_priv->ctx->in_ifc_list[file_ifc_priv->ifc_idx].client_state = FMT_WAITING;
-      } else if (ifc_type == TRAP_IFC_TYPE_TCPIP || ifc_type == TRAP_IFC_TYPE_UNIX) {
-         tcp_ifc_priv->ctx->in_ifc_list[tcp_ifc_priv->ifc_idx].client_state = FMT_WAITING;
+      } else if (ifc_type == TRAP_IFC_TYPE_TCPIP || ifc_type == TRAP_IFC_TYPE_UNIX || ifc_type == TRAP_IFC_TYPE_SHM) {
+         sock_ifc->client_state = FMT_WAITING;
       }
       neg_result = NEG_RES_FAILED;
       goto in_neg_exit;
@@ -3346,7 +5480,46 @@ int input_ifc_negotiation(void *ifc_priv_data, char ifc_type)
       VERBOSE(CL_VERBOSE_LIBRARY, "sender's data_type: %"PRIu8, hello_msg_header->data_type);
       VERBOSE(CL_VERBOSE_LIBRARY, "sender's data_fmt_spec_size: %"PRIu32, hello_msg_header->data_fmt_spec_size);
       VERBOSE(CL_VERBOSE_LIBRARY, "receiver's data_type: %"PRIu8, req_data_type);
+      VERBOSE(CL_VERBOSE_LIBRARY, "sender's codec: %s", trap_codec_name(hello_msg_header->codec));
+      VERBOSE(CL_VERBOSE_LIBRARY, "sender's flags: %#"PRIx8, hello_msg_header->flags);
+   }
+
+   /** Receive size of buffers if it is not the default one */
+   if (hello_msg_header->flags & TRAP_HELLO_BUFFER_SIZE) {
+      size = sizeof(uint32_t);
+      p_p = (void *) &buffer_size;
+      if (ifc_type == TRAP_IFC_TYPE_FILE) {
+         ret_val = fread(p_p, sizeof(char), size, file_ifc_priv->fd);
+         compare = size;
+      } else {
+         ret_val = service_get_data(sock_d, size, &p_p);
+         compare = TRAP_E_OK;
+      }
+      if (ret_val != compare) {
+         VERBOSE(CL_VERBOSE_LIBRARY, "ERROR - could not receive size of buffers");
+         in_ifc->client_state = FMT_WAITING;
+         neg_result = NEG_RES_FAILED;
+         goto in_neg_exit;
+      }
+      VERBOSE(CL_VERBOSE_LIBRARY, "sender's buffer size: %"PRIu32, buffer_size);
+   }
+   if (trap_input_buffer_resize(in_ifc, buffer_size) != TRAP_E_OK) {
+      VERBOSE(CL_ERROR, "Output interface uses buffers of %"PRIu32" B, input buffer could not be resized.", buffer_size);
+      in_ifc->client_state = FMT_MISMATCH;
+      neg_result = NEG_RES_FAILED;
+      goto in_neg_exit;
+   }
+
+   /** Check codec of buffers */
+   if (trap_codec_available(hello_msg_header->codec) == 0) {
+      VERBOSE(CL_ERROR, "Output interface compresses buffers by codec \"%s\" that is not available in this build of libtrap.",
+              trap_codec_name(hello_msg_header->codec));
+      in_ifc->client_state = FMT_MISMATCH;
+      neg_result = NEG_RES_FMT_MISMATCH;
+      goto in_neg_exit;
    }
+   in_ifc->codec = hello_msg_header->codec;
+   in_ifc->trace = ((hello_msg_header->flags & TRAP_HELLO_TRACE) != 0);
 
 
    /** Compare data_type */
@@ -3357,8 +5530,8 @@ int input_ifc_negotiation(void *ifc_priv_data, char ifc_type)
       VERBOSE(CL_VERBOSE_LIBRARY, "ERROR - sender's output interface has unknown data format");
       if (ifc_type == TRAP_IFC_TYPE_FILE) {
          file_ifc_priv->ctx->in_ifc_list[file_ifc_priv->ifc_idx].client_state = FMT_WAITING;
-      } else if (ifc_type == TRAP_IFC_TYPE_TCPIP || ifc_type == TRAP_IFC_TYPE_UNIX) {
-         tcp_ifc_priv->ctx->in_ifc_list[tcp_ifc_priv->ifc_idx].client_state = FMT_WAITING;
+      } else if (ifc_type == TRAP_IFC_TYPE_TCPIP || ifc_type == TRAP_IFC_TYPE_UNIX || ifc_type == TRAP_IFC_TYPE_SHM) {
+         sock_ifc->client_state = FMT_WAITING;
       }
       neg_result = NEG_RES_FMT_UNKNOWN;
       goto in_neg_exit;
@@ -3367,8 +5540,8 @@ int input_ifc_negotiation(void *ifc_priv_data, char ifc_type)
       VERBOSE(CL_VERBOSE_LIBRARY, "ERROR - mismatch of sender's output and receiver's input interface data types");
       if (ifc_type == TRAP_IFC_TYPE_FILE) {
          file_ifc_priv->ctx->in_ifc_list[file_ifc_priv->ifc_idx].client_state = FMT_MISMATCH;
-      } else if (ifc_type == TRAP_IFC_TYPE_TCPIP || ifc_type == TRAP_IFC_TYPE_UNIX) {
-         tcp_ifc_priv->ctx->in_ifc_list[tcp_ifc_priv->ifc_idx].client_state = FMT_MISMATCH;
+      } else if (ifc_type == TRAP_IFC_TYPE_TCPIP || ifc_type == TRAP_IFC_TYPE_UNIX || ifc_type == TRAP_IFC_TYPE_SHM) {
+         sock_ifc->client_state = FMT_MISMATCH;
       }
       neg_result = NEG_RES_FMT_MISMATCH;
       goto in_neg_exit;
@@ -3376,8 +5549,8 @@ int input_ifc_negotiation(void *ifc_priv_data, char ifc_type)
       // Both interfaces (senders output and receivers input) have RAW data format -> receive message with the data right after negotiation
       if (ifc_type == TRAP_IFC_TYPE_FILE) {
          file_ifc_priv->ctx->in_ifc_list[file_ifc_priv->ifc_idx].client_state = FMT_OK;
-      } else if (ifc_type == TRAP_IFC_TYPE_TCPIP || ifc_type == TRAP_IFC_TYPE_UNIX) {
-         tcp_ifc_priv->ctx->in_ifc_list[tcp_ifc_priv->ifc_idx].client_state = FMT_OK;
+      } else if (ifc_type == TRAP_IFC_TYPE_TCPIP || ifc_type == TRAP_IFC_TYPE_UNIX || ifc_type == TRAP_IFC_TYPE_SHM) {
+         sock_ifc->client_state = FMT_OK;
       }
       neg_result = NEG_RES_CONT;
    } else {
@@ -3387,8 +5560,8 @@ int input_ifc_negotiation(void *ifc_priv_data, char ifc_type)
          VERBOSE(CL_VERBOSE_LIBRARY, "ERROR - received zero size of UNIREC data format specifier.");
          if (ifc_type == TRAP_IFC_TYPE_FILE) {
             file_ifc_priv->ctx->in_ifc_list[file_ifc_priv->ifc_idx].client_state = FMT_MISMATCH;
-         } else if (ifc_type == TRAP_IFC_TYPE_TCPIP || ifc_type == TRAP_IFC_TYPE_UNIX) {
-            tcp_ifc_priv->ctx->in_ifc_list[tcp_ifc_priv->ifc_idx].client_state = FMT_MISMATCH;
+         } else if (ifc_type == TRAP_IFC_TYPE_TCPIP || ifc_type == TRAP_IFC_TYPE_UNIX || ifc_type == TRAP_IFC_TYPE_SHM) {
+            sock_ifc->client_state = FMT_MISMATCH;
          }
          neg_result = NEG_RES_FMT_MISMATCH;
          goto in_neg_exit;
@@ -3409,8 +5582,8 @@ int input_ifc_negotiation(void *ifc_priv_data, char ifc_type)
          if (ifc_type == TRAP_IFC_TYPE_FILE) {
             ret_val = fread(p_p, sizeof(char), size, file_ifc_priv->fd);
             compare = size;
-         } else if (ifc_type == TRAP_IFC_TYPE_TCPIP || ifc_type == TRAP_IFC_TYPE_UNIX) {
-            ret_val = service_get_data(tcp_ifc_priv->sd, size, &p_p);
+         } else if (ifc_type == TRAP_IFC_TYPE_TCPIP || ifc_type == TRAP_IFC_TYPE_UNIX || ifc_type == TRAP_IFC_TYPE_SHM) {
+            ret_val = service_get_data(sock_d, size, &p_p);
             compare = TRAP_E_OK;
          }
       
@@ -3419,8 +5592,8 @@ int input_ifc_negotiation(void *ifc_priv_data, char ifc_type)
             VERBOSE(CL_VERBOSE_LIBRARY, "ERROR");
             if (ifc_type == TRAP_IFC_TYPE_FILE) {
                file_ifc_priv->ctx->in_ifc_list[file_ifc_priv->ifc_idx].client_state = FMT_WAITING;
-            } else if (ifc_type == TRAP_IFC_TYPE_TCPIP || ifc_type == TRAP_IFC_TYPE_UNIX) {
-               tcp_ifc_priv->ctx->in_ifc_list[tcp_ifc_priv->ifc_idx].client_state = FMT_WAITING;
+            } else if (ifc_type == TRAP_IFC_TYPE_TCPIP || ifc_type == TRAP_IFC_TYPE_UNIX || ifc_type == TRAP_IFC_TYPE_SHM) {
+               sock_ifc->client_state = FMT_WAITING;
             }
             neg_result = NEG_RES_FAILED;
             free(recv_data_fmt_spec);
@@ -3453,8 +5626,8 @@ int input_ifc_negotiation(void *ifc_priv_data, char ifc_type)
          VERBOSE(CL_VERBOSE_LIBRARY, "ERROR");
          if (ifc_type == TRAP_IFC_TYPE_FILE) {
             file_ifc_priv->ctx->in_ifc_list[file_ifc_priv->ifc_idx].client_state = FMT_MISMATCH;
-         } else if (ifc_type == TRAP_IFC_TYPE_TCPIP || ifc_type == TRAP_IFC_TYPE_UNIX) {
-            tcp_ifc_priv->ctx->in_ifc_list[tcp_ifc_priv->ifc_idx].client_state = FMT_MISMATCH;
+         } else if (ifc_type == TRAP_IFC_TYPE_TCPIP || ifc_type == TRAP_IFC_TYPE_UNIX || ifc_type == TRAP_IFC_TYPE_SHM) {
+            sock_ifc->client_state = FMT_MISMATCH;
          }
          neg_result = NEG_RES_FMT_MISMATCH;
          free(recv_data_fmt_spec);
@@ -3464,16 +5637,16 @@ int input_ifc_negotiation(void *ifc_priv_data, char ifc_type)
          VERBOSE(CL_VERBOSE_LIBRARY, "OK");
          if (ifc_type == TRAP_IFC_TYPE_FILE) {
             file_ifc_priv->ctx->in_ifc_list[file_ifc_priv->ifc_idx].client_state = FMT_CHANGED;
-         } else if (ifc_type == TRAP_IFC_TYPE_TCPIP || ifc_type == TRAP_IFC_TYPE_UNIX) {
-            tcp_ifc_priv->ctx->in_ifc_list[tcp_ifc_priv->ifc_idx].client_state = FMT_CHANGED;
+         } else if (ifc_type == TRAP_IFC_TYPE_TCPIP || ifc_type == TRAP_IFC_TYPE_UNIX || ifc_type == TRAP_IFC_TYPE_SHM) {
+            sock_ifc->client_state = FMT_CHANGED;
          }
          neg_result = NEG_RES_RECEIVER_FMT_SUBSET;
       } else {
          VERBOSE(CL_VERBOSE_LIBRARY, "OK");
          if (ifc_type == TRAP_IFC_TYPE_FILE) {
             file_ifc_priv->ctx->in_ifc_list[file_ifc_priv->ifc_idx].client_state = FMT_OK;
-         } else if (ifc_type == TRAP_IFC_TYPE_TCPIP || ifc_type == TRAP_IFC_TYPE_UNIX) {
-            tcp_ifc_priv->ctx->in_ifc_list[tcp_ifc_priv->ifc_idx].client_state = FMT_OK;
+         } else if (ifc_type == TRAP_IFC_TYPE_TCPIP || ifc_type == TRAP_IFC_TYPE_UNIX || ifc_type == TRAP_IFC_TYPE_SHM) {
+            sock_ifc->client_state = FMT_OK;
          }
          neg_result = NEG_RES_CONT;
          if (current_data_fmt_spec != NULL) {
@@ -3489,8 +5662,8 @@ int input_ifc_negotiation(void *ifc_priv_data, char ifc_type)
                VERBOSE(CL_VERBOSE_LIBRARY, "CHANGE");
                if (ifc_type == TRAP_IFC_TYPE_FILE) {
                   file_ifc_priv->ctx->in_ifc_list[file_ifc_priv->ifc_idx].client_state = FMT_CHANGED;
-               } else if (ifc_type == TRAP_IFC_TYPE_TCPIP || ifc_type == TRAP_IFC_TYPE_UNIX) {
-                  tcp_ifc_priv->ctx->in_ifc_list[tcp_ifc_priv->ifc_idx].client_state = FMT_CHANGED;
+               } else if (ifc_type == TRAP_IFC_TYPE_TCPIP || ifc_type == TRAP_IFC_TYPE_UNIX || ifc_type == TRAP_IFC_TYPE_SHM) {
+                  sock_ifc->client_state = FMT_CHANGED;
                }
                if (hello_msg_header->data_type == TRAP_FMT_UNIREC) {
                   neg_result = NEG_RES_SENDER_FMT_SUBSET;
@@ -3511,19 +5684,19 @@ int input_ifc_negotiation(void *ifc_priv_data, char ifc_type)
          free(file_ifc_priv->ctx->in_ifc_list[file_ifc_priv->ifc_idx].data_fmt_spec);
       }
       file_ifc_priv->ctx->in_ifc_list[file_ifc_priv->ifc_idx].data_fmt_spec = recv_data_fmt_spec;
-   } else if (ifc_type == TRAP_IFC_TYPE_TCPIP || ifc_type == TRAP_IFC_TYPE_UNIX) {
-      tcp_ifc_priv->ctx->in_ifc_list[tcp_ifc_priv->ifc_idx].data_type = hello_msg_header->data_type;
-      if (tcp_ifc_priv->ctx->in_ifc_list[tcp_ifc_priv->ifc_idx].data_fmt_spec != NULL) {
-         free(tcp_ifc_priv->ctx->in_ifc_list[tcp_ifc_priv->ifc_idx].data_fmt_spec);
+   } else if (ifc_type == TRAP_IFC_TYPE_TCPIP || ifc_type == TRAP_IFC_TYPE_UNIX || ifc_type == TRAP_IFC_TYPE_SHM) {
+      sock_ifc->data_type = hello_msg_header->data_type;
+      if (sock_ifc->data_fmt_spec != NULL) {
+         free(sock_ifc->data_fmt_spec);
       }
-      tcp_ifc_priv->ctx->in_ifc_list[tcp_ifc_priv->ifc_idx].data_fmt_spec = recv_data_fmt_spec;
+      sock_ifc->data_fmt_spec = recv_data_fmt_spec;
    }
 
 in_neg_exit:
    if (ifc_type == TRAP_IFC_TYPE_FILE) {
       VERBOSE(CL_VERBOSE_LIBRARY, "input ifc state after connecting: %d", file_ifc_priv->ctx->in_ifc_list[file_ifc_priv->ifc_idx].client_state);
-   } else if (ifc_type == TRAP_IFC_TYPE_TCPIP || ifc_type == TRAP_IFC_TYPE_UNIX) {
-      VERBOSE(CL_VERBOSE_LIBRARY, "input ifc state after connecting: %d", tcp_ifc_priv->ctx->in_ifc_list[tcp_ifc_priv->ifc_idx].client_state);
+   } else if (ifc_type == TRAP_IFC_TYPE_TCPIP || ifc_type == TRAP_IFC_TYPE_UNIX || ifc_type == TRAP_IFC_TYPE_SHM) {
+      VERBOSE(CL_VERBOSE_LIBRARY, "input ifc state after connecting: %d", sock_ifc->client_state);
    }
 
    if (hello_msg_header != NULL) {
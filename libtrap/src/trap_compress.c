@@ -0,0 +1,451 @@
+/**
+ * \file trap_compress.c
+ * \brief Compression of TRAP buffers
+ */
+/*
+ * Copyright (C) 2026 CESNET
+ *
+ * LICENSE TERMS
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name of the Company nor the names of its contributors
+ *    may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ *
+ * ALTERNATIVELY, provided that this notice is retained in full, this
+ * product may be distributed under the terms of the GNU General Public
+ * License (GPL) version 2 or later, in which case the provisions
+ * of the GPL apply INSTEAD OF those given above.
+ *
+ * This software is provided ``as is'', and any express or implied
+ * warranties, including, but not limited to, the implied warranties of
+ * merchantability and fitness for a particular purpose are disclaimed.
+ * In no event shall the company or contributors be liable for any
+ * direct, indirect, incidental, special, exemplary, or consequential
+ * damages (including, but not limited to, procurement of substitute
+ * goods or services; loss of use, data, or profits; or business
+ * interruption) however caused and on any theory of liability, whether
+ * in contract, strict liability, or tort (including negligence or
+ * otherwise) arising in any way out of the use of this software, even
+ * if advised of the possibility of such damage.
+ *
+ */
+#include <stdlib.h>
+#include <string.h>
+#include <inttypes.h>
+#include <time.h>
+#include <arpa/inet.h>
+
+#include "../include/libtrap/trap.h"
+#include "trap_internal.h"
+#include "trap_compress.h"
+
+#ifdef HAVE_LZ4
+#include <lz4.h>
+#endif
+#ifdef HAVE_ZSTD
+#include <zstd.h>
+#endif
+#ifdef HAVE_ZLIB
+#include <zlib.h>
+#endif
+
+/**
+ * \addtogroup trap_compress
+ * @{
+ */
+
+#define TRAP_COMPRESS_MAX_RAW 0xFFFFFF ///< Maximal payload that fits into frame header
+
+#define ZSTD_DEFAULT_LEVEL 1 ///< Fast level, buffers are compressed on the fly
+#define ZLIB_DEFAULT_LEVEL 1 ///< Fast level, buffers are compressed on the fly
+
+/**
+ * Names of codecs, index is TRAP_CODEC_*.
+ */
+static const char *codec_names[] = {"none", "lz4", "zstd", "zlib"};
+
+#define CODEC_COUNT (sizeof(codec_names) / sizeof(codec_names[0]))
+
+static inline uint64_t cputime_ns(void)
+{
+   struct timespec ts;
+   clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+   return (uint64_t) ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+int trap_codec_available(uint8_t codec)
+{
+   switch (codec) {
+   case TRAP_CODEC_NONE:
+      return 1;
+#ifdef HAVE_LZ4
+   case TRAP_CODEC_LZ4:
+      return 1;
+#endif
+#ifdef HAVE_ZSTD
+   case TRAP_CODEC_ZSTD:
+      return 1;
+#endif
+#ifdef HAVE_ZLIB
+   case TRAP_CODEC_ZLIB:
+      return 1;
+#endif
+   default:
+      return 0;
+   }
+}
+
+const char *trap_codec_name(uint8_t codec)
+{
+   if (codec < CODEC_COUNT) {
+      return codec_names[codec];
+   }
+   return "unknown";
+}
+
+int trap_compress_parse(const char *value, uint8_t *codec, int *level)
+{
+   size_t len;
+   uint8_t i;
+   char *end;
+
+   len = strcspn(value, "-:");
+   for (i = 0; i < CODEC_COUNT; i++) {
+      if ((strlen(codec_names[i]) == len) && (strncmp(value, codec_names[i], len) == 0)) {
+         break;
+      }
+   }
+   if ((i == CODEC_COUNT) || (trap_codec_available(i) == 0)) {
+      return TRAP_E_BADPARAMS;
+   }
+   *codec = i;
+   *level = 0;
+   if (value[len] == '-') {
+      *level = strtol(value + len + 1, &end, 10);
+      if ((end == value + len + 1) || ((*end != 0) && (*end != ':'))) {
+         return TRAP_E_BADPARAMS;
+      }
+   }
+   return TRAP_E_OK;
+}
+
+/**
+ * Free contexts of the current codec.
+ *
+ * \param[in,out] z  state of compression
+ */
+static void codec_free_ctx(trap_compress_t *z)
+{
+   switch (z->codec) {
+#ifdef HAVE_ZSTD
+   case TRAP_CODEC_ZSTD:
+      ZSTD_freeCCtx((ZSTD_CCtx *) z->cctx);
+      ZSTD_freeDCtx((ZSTD_DCtx *) z->dctx);
+      break;
+#endif
+#ifdef HAVE_ZLIB
+   case TRAP_CODEC_ZLIB:
+      if (z->cctx != NULL) {
+         deflateEnd((z_stream *) z->cctx);
+         free(z->cctx);
+      }
+      if (z->dctx != NULL) {
+         inflateEnd((z_stream *) z->dctx);
+         free(z->dctx);
+      }
+      break;
+#endif
+   default:
+      break;
+   }
+   z->cctx = NULL;
+   z->dctx = NULL;
+}
+
+/**
+ * Compress data using z->codec.
+ *
+ * \param[in,out] z  state of compression
+ * \param[in] src  data to compress
+ * \param[in] src_size  size of src
+ * \param[out] dst  output
+ * \param[in] dst_size  capacity of dst
+ * \return size of compressed data, 0 if compression failed or output does not fit
+ */
+static uint32_t codec_compress(trap_compress_t *z, const uint8_t *src, uint32_t src_size, uint8_t *dst, uint32_t dst_size)
+{
+   switch (z->codec) {
+#ifdef HAVE_LZ4
+   case TRAP_CODEC_LZ4:
+   {
+      int res = LZ4_compress_fast((const char *) src, (char *) dst, src_size, dst_size, z->level > 0 ? z->level : 1);
+      return (res > 0) ? (uint32_t) res : 0;
+   }
+#endif
+#ifdef HAVE_ZSTD
+   case TRAP_CODEC_ZSTD:
+   {
+      size_t res;
+      if (z->cctx == NULL) {
+         z->cctx = ZSTD_createCCtx();
+         if (z->cctx == NULL) {
+            return 0;
+         }
+      }
+      res = ZSTD_compressCCtx((ZSTD_CCtx *) z->cctx, dst, dst_size, src, src_size,
+                              z->level != 0 ? z->level : ZSTD_DEFAULT_LEVEL);
+      return ZSTD_isError(res) ? 0 : (uint32_t) res;
+   }
+#endif
+#ifdef HAVE_ZLIB
+   case TRAP_CODEC_ZLIB:
+   {
+      z_stream *s = (z_stream *) z->cctx;
+      if (s == NULL) {
+         s = (z_stream *) calloc(1, sizeof(z_stream));
+         if (s == NULL) {
+            return 0;
+         }
+         if (deflateInit(s, z->level != 0 ? z->level : ZLIB_DEFAULT_LEVEL) != Z_OK) {
+            free(s);
+            return 0;
+         }
+         z->cctx = s;
+      } else if (deflateReset(s) != Z_OK) {
+         return 0;
+      }
+      s->next_in = (Bytef *) src;
+      s->avail_in = src_size;
+      s->next_out = dst;
+      s->avail_out = dst_size;
+      if (deflate(s, Z_FINISH) != Z_STREAM_END) {
+         return 0;
+      }
+      return dst_size - s->avail_out;
+   }
+#endif
+   default:
+      return 0;
+   }
+}
+
+/**
+ * Decompress data using z->codec.
+ *
+ * \param[in,out] z  state of compression
+ * \param[in] src  compressed data
+ * \param[in] src_size  size of src
+ * \param[out] dst  output
+ * \param[in] dst_size  expected size of decompressed data
+ * \return size of decompressed data, 0 on error
+ */
+static uint32_t codec_decompress(trap_compress_t *z, const uint8_t *src, uint32_t src_size, uint8_t *dst, uint32_t dst_size)
+{
+   switch (z->codec) {
+#ifdef HAVE_LZ4
+   case TRAP_CODEC_LZ4:
+   {
+      int res = LZ4_decompress_safe((const char *) src, (char *) dst, src_size, dst_size);
+      return (res > 0) ? (uint32_t) res : 0;
+   }
+#endif
+#ifdef HAVE_ZSTD
+   case TRAP_CODEC_ZSTD:
+   {
+      size_t res;
+      if (z->dctx == NULL) {
+         z->dctx = ZSTD_createDCtx();
+         if (z->dctx == NULL) {
+            return 0;
+         }
+      }
+      res = ZSTD_decompressDCtx((ZSTD_DCtx *) z->dctx, dst, dst_size, src, src_size);
+      return ZSTD_isError(res) ? 0 : (uint32_t) res;
+   }
+#endif
+#ifdef HAVE_ZLIB
+   case TRAP_CODEC_ZLIB:
+   {
+      z_stream *s = (z_stream *) z->dctx;
+      if (s == NULL) {
+         s = (z_stream *) calloc(1, sizeof(z_stream));
+         if (s == NULL) {
+            return 0;
+         }
+         if (inflateInit(s) != Z_OK) {
+            free(s);
+            return 0;
+         }
+         z->dctx = s;
+      } else if (inflateReset(s) != Z_OK) {
+         return 0;
+      }
+      s->next_in = (Bytef *) src;
+      s->avail_in = src_size;
+      s->next_out = dst;
+      s->avail_out = dst_size;
+      if (inflate(s, Z_FINISH) != Z_STREAM_END) {
+         return 0;
+      }
+      return dst_size - s->avail_out;
+   }
+#endif
+   default:
+      return 0;
+   }
+}
+
+trap_compress_t *trap_compress_create(uint8_t codec, int level, uint32_t buffer_size)
+{
+   trap_compress_t *z;
+
+   if (trap_codec_available(codec) == 0) {
+      return NULL;
+   }
+   z = (trap_compress_t *) calloc(1, sizeof(trap_compress_t));
+   if (z == NULL) {
+      return NULL;
+   }
+   /* output IFC needs room for buffer header, input IFC for the whole payload */
+   z->buffer = (unsigned char *) malloc(sizeof(trap_buffer_header_t) + buffer_size + 1);
+   if (z->buffer == NULL) {
+      free(z);
+      return NULL;
+   }
+   z->buffer_size = buffer_size;
+   z->codec = codec;
+   z->level = level;
+   return z;
+}
+
+void trap_compress_destroy(trap_compress_t *z)
+{
+   if (z == NULL) {
+      return;
+   }
+   codec_free_ctx(z);
+   free(z->buffer);
+   free(z);
+}
+
+uint32_t trap_compress_buffer(trap_compress_t *z, const unsigned char *buffer_header, uint32_t size)
+{
+   const trap_buffer_header_t *h = (const trap_buffer_header_t *) buffer_header;
+   trap_buffer_header_t *fh = (trap_buffer_header_t *) z->buffer;
+   uint8_t *frame = fh->data;
+   uint32_t raw_size = size - sizeof(trap_buffer_header_t);
+   uint32_t frame_size;
+   uint8_t codec = z->codec;
+   uint64_t start;
+
+   if ((z->pending_src == buffer_header) && (z->pending_size == size)) {
+      /* the same buffer again, frame was not sent yet */
+      return z->frame_size;
+   }
+
+   start = cputime_ns();
+   /* compressed data must be smaller than the original payload */
+   frame_size = codec_compress(z, h->data, raw_size, frame + TRAP_COMPRESS_FRAME_HDR, raw_size);
+   if (frame_size == 0) {
+      codec = TRAP_CODEC_NONE;
+      memcpy(frame + TRAP_COMPRESS_FRAME_HDR, h->data, raw_size);
+      frame_size = raw_size;
+      z->stored_buffers++;
+   }
+   z->cpu_time += cputime_ns() - start;
+
+   frame_size += TRAP_COMPRESS_FRAME_HDR;
+   *((uint32_t *) frame) = htonl(((uint32_t) codec << 24) | raw_size);
+   memcpy(fh, h, sizeof(trap_buffer_header_t));
+   fh->data_length = htonl(frame_size);
+
+   z->raw_bytes += raw_size;
+   z->wire_bytes += frame_size;
+   z->pending_src = buffer_header;
+   z->pending_size = size;
+   z->frame_size = frame_size + sizeof(trap_buffer_header_t);
+   return z->frame_size;
+}
+
+void trap_compress_release(trap_compress_t *z)
+{
+   z->pending_src = NULL;
+   z->pending_size = 0;
+}
+
+int trap_decompress_buffer(trap_compress_t *z, const unsigned char *frame, uint32_t size, uint32_t *raw_size)
+{
+   uint32_t frame_hdr, expected;
+   uint8_t codec;
+   uint64_t start;
+
+   if (size < TRAP_COMPRESS_FRAME_HDR) {
+      VERBOSE(CL_ERROR, "Received compressed buffer is too short (%"PRIu32" B).", size);
+      return TRAP_E_IO_ERROR;
+   }
+   frame_hdr = ntohl(*((const uint32_t *) frame));
+   codec = frame_hdr >> 24;
+   expected = frame_hdr & TRAP_COMPRESS_MAX_RAW;
+   frame += TRAP_COMPRESS_FRAME_HDR;
+   size -= TRAP_COMPRESS_FRAME_HDR;
+   if (expected > z->buffer_size) {
+      VERBOSE(CL_ERROR, "Received compressed buffer is bigger than message buffer (%"PRIu32" B).", expected);
+      return TRAP_E_IO_ERROR;
+   }
+
+   start = cputime_ns();
+   if (codec == TRAP_CODEC_NONE) {
+      if (size != expected) {
+         VERBOSE(CL_ERROR, "Malformed uncompressed frame (%"PRIu32" B, expected %"PRIu32" B).", size, expected);
+         return TRAP_E_IO_ERROR;
+      }
+      memcpy(z->buffer, frame, size);
+      z->stored_buffers++;
+   } else {
+      if (codec != z->codec) {
+         if (trap_codec_available(codec) == 0) {
+            VERBOSE(CL_ERROR, "Received buffer compressed by unsupported codec %"PRIu8".", codec);
+            return TRAP_E_IO_ERROR;
+         }
+         codec_free_ctx(z);
+         z->codec = codec;
+      }
+      if (codec_decompress(z, frame, size, z->buffer, expected) != expected) {
+         VERBOSE(CL_ERROR, "Decompression of received buffer (%s) failed.", trap_codec_name(codec));
+         return TRAP_E_IO_ERROR;
+      }
+   }
+   z->cpu_time += cputime_ns() - start;
+   z->raw_bytes += expected;
+   z->wire_bytes += size + TRAP_COMPRESS_FRAME_HDR;
+   *raw_size = expected;
+   return TRAP_E_OK;
+}
+
+json_t *trap_compress_get_stats(const trap_compress_t *z)
+{
+   double ratio = 0.0;
+
+   if (z->wire_bytes > 0) {
+      ratio = (double) z->raw_bytes / z->wire_bytes;
+   }
+   return json_pack("{sssIsIsIsfsI}", "codec", trap_codec_name(z->codec),
+                    "raw-bytes", (json_int_t) z->raw_bytes,
+                    "wire-bytes", (json_int_t) z->wire_bytes,
+                    "stored-buffers", (json_int_t) z->stored_buffers,
+                    "compress-ratio", ratio,
+                    "codec-cpu-us", (json_int_t) (z->cpu_time / 1000));
+}
+
+/**
+ * @}
+ */
@@ -0,0 +1,179 @@
+/**
+ * \file trap_compress.h
+ * \brief Compression of TRAP buffers
+ */
+/*
+ * Copyright (C) 2026 CESNET
+ *
+ * LICENSE TERMS
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name of the Company nor the names of its contributors
+ *    may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ *
+ * ALTERNATIVELY, provided that this notice is retained in full, this
+ * product may be distributed under the terms of the GNU General Public
+ * License (GPL) version 2 or later, in which case the provisions
+ * of the GPL apply INSTEAD OF those given above.
+ *
+ * This software is provided ``as is'', and any express or implied
+ * warranties, including, but not limited to, the implied warranties of
+ * merchantability and fitness for a particular purpose are disclaimed.
+ * In no event shall the company or contributors be liable for any
+ * direct, indirect, incidental, special, exemplary, or consequential
+ * damages (including, but not limited to, procurement of substitute
+ * goods or services; loss of use, data, or profits; or business
+ * interruption) however caused and on any theory of liability, whether
+ * in contract, strict liability, or tort (including negligence or
+ * otherwise) arising in any way out of the use of this software, even
+ * if advised of the possibility of such damage.
+ *
+ */
+#ifndef _TRAP_COMPRESS_H_
+#define _TRAP_COMPRESS_H_
+
+#include <stdint.h>
+#include "../include/libtrap/jansson.h"
+
+/**
+ * \defgroup trap_compress Compression of buffers
+ *
+ * Output IFC with setter "compress=<codec>" compresses every buffer before
+ * it is passed to send() of the IFC.  The codec is announced in the hello
+ * message during negotiation, input IFC decompresses received buffers
+ * before messages are read from them.
+ *
+ * Compressed buffer is sent as a regular buffer (trap_buffer_header_t
+ * with data_length of the frame).  Payload of the buffer (frame) starts
+ * with #TRAP_COMPRESS_FRAME_HDR bytes in network byte order: codec in the
+ * upper 8 bits and size of the original payload in the lower 24 bits.
+ * Buffers that do not shrink are sent with #TRAP_CODEC_NONE in the frame
+ * header, so a frame is never bigger than the buffer of IFC.
+ * @{
+ */
+
+#define TRAP_CODEC_NONE 0 ///< No compression (stored frame)
+#define TRAP_CODEC_LZ4  1 ///< LZ4 block format
+#define TRAP_CODEC_ZSTD 2 ///< Zstandard
+#define TRAP_CODEC_ZLIB 3 ///< zlib (deflate)
+
+#define TRAP_COMPRESS_FRAME_HDR 4 ///< Size of frame header
+
+/**
+ * State of compression of one IFC.
+ *
+ * Output IFC uses it from the thread that sends buffers (ifc_mtx held or
+ * the sender thread of pool), input IFC under ifc_mtx.  Counters are read
+ * without locking by the service thread.
+ */
+typedef struct trap_compress_s {
+   uint8_t codec;              ///< Codec of output IFC or the last codec received by input IFC
+   int level;                  ///< Compression level, 0 means default level of codec
+   unsigned char *buffer;      ///< Output IFC: buffer header followed by frame, input IFC: decompressed payload
+   uint32_t buffer_size;       ///< Size of buffer of IFC (see trap_output_ifc_t::buffer_size)
+   void *cctx;                 ///< Compression context of codec (if it needs one)
+   void *dctx;                 ///< Decompression context of codec (if it needs one)
+   const unsigned char *pending_src; ///< Buffer whose frame is in buffer but was not sent yet
+   uint32_t pending_size;      ///< Size of pending_src
+   uint32_t frame_size;        ///< Size of data in buffer incl. buffer header
+   uint64_t raw_bytes;         ///< Payload bytes before compression / after decompression
+   uint64_t wire_bytes;        ///< Frame bytes sent / received
+   uint64_t stored_buffers;    ///< Number of buffers that were not compressed
+   uint64_t cpu_time;          ///< CPU time spent in codec (nanoseconds)
+} trap_compress_t;
+
+/**
+ * Parse value of compress setter.
+ *
+ * \param[in] value  "<codec>[-<level>]", terminated by '\0' or ':'
+ * \param[out] codec  TRAP_CODEC_*
+ * \param[out] level  compression level, 0 for default
+ * \return TRAP_E_OK on success, TRAP_E_BADPARAMS for unknown or unavailable codec
+ */
+int trap_compress_parse(const char *value, uint8_t *codec, int *level);
+
+/**
+ * Check whether the codec was compiled in.
+ *
+ * \param[in] codec  TRAP_CODEC_*
+ * \return 1 if codec can be used, 0 otherwise
+ */
+int trap_codec_available(uint8_t codec);
+
+/**
+ * Get name of codec.
+ *
+ * \param[in] codec  TRAP_CODEC_*
+ * \return static string
+ */
+const char *trap_codec_name(uint8_t codec);
+
+/**
+ * Allocate state of compression.
+ *
+ * \param[in] codec  TRAP_CODEC_*
+ * \param[in] level  compression level, 0 for default
+ * \param[in] buffer_size  size of buffers of IFC
+ * \return pointer to allocated state or NULL on error
+ */
+trap_compress_t *trap_compress_create(uint8_t codec, int level, uint32_t buffer_size);
+
+/**
+ * Free state of compression.
+ *
+ * \param[in] z  state allocated by trap_compress_create(), can be NULL
+ */
+void trap_compress_destroy(trap_compress_t *z);
+
+/**
+ * Compress buffer into z->buffer.
+ *
+ * When the same buffer is passed again (previous send() timed out), the
+ * frame is reused until trap_compress_release() is called.
+ *
+ * \param[in,out] z  state of compression of output IFC
+ * \param[in] buffer_header  buffer header followed by payload
+ * \param[in] size  size of buffer incl. header
+ * \return size of frame in z->buffer incl. buffer header
+ */
+uint32_t trap_compress_buffer(trap_compress_t *z, const unsigned char *buffer_header, uint32_t size);
+
+/**
+ * Forget the frame in z->buffer, the next buffer is compressed again.
+ *
+ * \param[in,out] z  state of compression of output IFC
+ */
+void trap_compress_release(trap_compress_t *z);
+
+/**
+ * Decompress received frame into z->buffer.
+ *
+ * \param[in,out] z  state of compression of input IFC
+ * \param[in] frame  received payload
+ * \param[in] size  size of frame
+ * \param[out] raw_size  size of decompressed payload
+ * \return TRAP_E_OK on success, TRAP_E_IO_ERROR for a malformed frame
+ */
+int trap_decompress_buffer(trap_compress_t *z, const unsigned char *frame, uint32_t size, uint32_t *raw_size);
+
+/**
+ * Get counters of compression.
+ *
+ * \param[in] z  state of compression
+ * \return JSON object with counters (new reference)
+ */
+json_t *trap_compress_get_stats(const trap_compress_t *z);
+
+/**
+ * @}
+ */
+#endif
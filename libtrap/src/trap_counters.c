@@ -0,0 +1,304 @@
+/**
+ * \file trap_counters.c
+ * \brief Per-thread counters of IFCs
+ */
+/*
+ * Copyright (C) 2026 CESNET
+ *
+ * LICENSE TERMS
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name of the Company nor the names of its contributors
+ *    may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ *
+ * ALTERNATIVELY, provided that this notice is retained in full, this
+ * product may be distributed under the terms of the GNU General Public
+ * License (GPL) version 2 or later, in which case the provisions
+ * of the GPL apply INSTEAD OF those given above.
+ *
+ * This software is provided ``as is'', and any express or implied
+ * warranties, including, but not limited to, the implied warranties of
+ * merchantability and fitness for a particular purpose are disclaimed.
+ * In no event shall the company or contributors be liable for any
+ * direct, indirect, incidental, special, exemplary, or consequential
+ * damages (including, but not limited to, procurement of substitute
+ * goods or services; loss of use, data, or profits; or business
+ * interruption) however caused and on any theory of liability, whether
+ * in contract, strict liability, or tort (including negligence or
+ * otherwise) arising in any way out of the use of this software, even
+ * if advised of the possibility of such damage.
+ *
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+#include "../include/libtrap/trap.h"
+#include "trap_counters.h"
+
+/**
+ * \addtogroup trap_counters
+ * @{
+ */
+
+/**
+ * Size of block header, counters of IFCs follow it.
+ */
+#define BLOCK_HDR_SIZE (((sizeof(trap_counters_block_t) + TRAP_CACHE_LINE - 1) / TRAP_CACHE_LINE) * TRAP_CACHE_LINE)
+
+/**
+ * Allocate zeroed block of counters.
+ *
+ * \param[in] c  counters
+ * \return new block or NULL on error
+ */
+static trap_counters_block_t *block_create(trap_counters_t *c)
+{
+   trap_counters_block_t *b;
+   size_t size = BLOCK_HDR_SIZE + c->num_in * sizeof(trap_in_counters_t) +
+                 c->num_out * sizeof(trap_out_counters_t);
+
+   if (posix_memalign((void **) &b, TRAP_CACHE_LINE, size) != 0) {
+      return NULL;
+   }
+   memset(b, 0, size);
+   b->in = (trap_in_counters_t *) ((char *) b + BLOCK_HDR_SIZE);
+   b->out = (trap_out_counters_t *) (b->in + c->num_in);
+   return b;
+}
+
+/**
+ * Destructor of thread-specific key, the block of exiting thread can be
+ * reused by another thread.
+ *
+ * \param[in] arg  block of the thread
+ */
+static void block_detach(void *arg)
+{
+   trap_counters_block_t *b = (trap_counters_block_t *) arg;
+
+   if (b->attached > 0) {
+      pthread_mutex_lock(&b->owner->lock);
+      b->attached = 0;
+      pthread_mutex_unlock(&b->owner->lock);
+   }
+}
+
+int trap_counters_init(trap_counters_t *c, uint32_t num_in, uint32_t num_out)
+{
+   memset(c, 0, sizeof(*c));
+   c->num_in = num_in;
+   c->num_out = num_out;
+   c->shared = block_create(c);
+   if (c->shared == NULL) {
+      return TRAP_E_MEMORY;
+   }
+   c->shared->owner = c;
+   c->shared->attached = -1;
+   c->blocks = c->shared;
+   if (pthread_key_create(&c->key, block_detach) != 0) {
+      free(c->shared);
+      c->shared = NULL;
+      c->blocks = NULL;
+      return TRAP_E_MEMORY;
+   }
+   pthread_mutex_init(&c->lock, NULL);
+   c->initialized = 1;
+   return TRAP_E_OK;
+}
+
+void trap_counters_destroy(trap_counters_t *c)
+{
+   trap_counters_block_t *b;
+
+   if (c->initialized == 0) {
+      return;
+   }
+   pthread_key_delete(c->key);
+   while (c->blocks != NULL) {
+      b = c->blocks;
+      c->blocks = b->next;
+      free(b);
+   }
+   pthread_mutex_destroy(&c->lock);
+   c->shared = NULL;
+   c->initialized = 0;
+}
+
+trap_counters_block_t *trap_counters_attach(trap_counters_t *c)
+{
+   trap_counters_block_t *b;
+
+   pthread_mutex_lock(&c->lock);
+   for (b = c->blocks; b != NULL; b = b->next) {
+      if (b->attached == 0) {
+         break;
+      }
+   }
+   if (b == NULL) {
+      b = block_create(c);
+      if (b != NULL) {
+         b->owner = c;
+         b->next = c->blocks;
+         c->blocks = b;
+      } else {
+         /* counters of the thread can lose concurrent updates */
+         b = c->shared;
+      }
+   }
+   if (b->attached == 0) {
+      b->attached = 1;
+   }
+   pthread_mutex_unlock(&c->lock);
+   pthread_setspecific(c->key, b);
+   return b;
+}
+
+/**
+ * Add counters read from another thread to the sum.  All members of the
+ * counter structures are uint64_t, padding is zeroed.
+ *
+ * \param[in,out] dst  sum
+ * \param[in] src  counters of one thread
+ * \param[in] size  size of counters in bytes
+ */
+static void add_words(void *dst, const void *src, size_t size)
+{
+   uint64_t *d = (uint64_t *) dst;
+   const uint64_t *s = (const uint64_t *) src;
+   size_t i;
+
+   for (i = 0; i < size / sizeof(uint64_t); i++) {
+      d[i] += __atomic_load_n(&s[i], __ATOMIC_RELAXED);
+   }
+}
+
+trap_counters_block_t *trap_counters_sum(trap_counters_t *c)
+{
+   trap_counters_block_t *sum, *b;
+
+   sum = block_create(c);
+   if (sum == NULL) {
+      return NULL;
+   }
+   pthread_mutex_lock(&c->lock);
+   for (b = c->blocks; b != NULL; b = b->next) {
+      add_words(sum->in, b->in, c->num_in * sizeof(trap_in_counters_t));
+      add_words(sum->out, b->out, c->num_out * sizeof(trap_out_counters_t));
+   }
+   pthread_mutex_unlock(&c->lock);
+   return sum;
+}
+
+/**
+ * Encode array of counters, trailing zeros are omitted.
+ *
+ * \param[in] values  counters
+ * \param[in] count  number of counters
+ * \return json array, NULL on error
+ */
+static json_t *array_json(const uint64_t *values, uint32_t count)
+{
+   json_t *arr = json_array();
+   uint32_t i;
+
+   if (arr == NULL) {
+      return NULL;
+   }
+   while ((count > 0) && (values[count - 1] == 0)) {
+      count--;
+   }
+   for (i = 0; i < count; i++) {
+      if (json_array_append_new(arr, json_integer((json_int_t) values[i])) == -1) {
+         json_decref(arr);
+         return NULL;
+      }
+   }
+   return arr;
+}
+
+/**
+ * Encode histogram: {"count": n, "sum": s, "buckets": [...]}.
+ *
+ * \param[in] h  histogram
+ * \return json object, NULL on error
+ */
+static json_t *hist_json(const trap_hist_t *h)
+{
+   return json_pack("{sIsIso}", "count", (json_int_t) h->count, "sum", (json_int_t) h->sum,
+                    "buckets", array_json(h->buckets, TRAP_HIST_BUCKETS));
+}
+
+/**
+ * Encode traced delays of hops: [{"link-us": hist, "module-us": hist}, ...].
+ * Hops that were never traced are omitted from the end.
+ *
+ * \param[in] in  counters
+ * \return json array, NULL on error
+ */
+static json_t *hops_json(const trap_in_counters_t *in)
+{
+   json_t *arr = json_array(), *hop;
+   int i, count = TRAP_TRACE_MAX_HOPS + 1;
+
+   if (arr == NULL) {
+      return NULL;
+   }
+   while ((count > 0) && (in->hop_link[count - 1].count == 0)) {
+      count--;
+   }
+   for (i = 0; i < count; i++) {
+      if (i < TRAP_TRACE_MAX_HOPS) {
+         hop = json_pack("{soso}", "link-us", hist_json(&in->hop_link[i]), "module-us", hist_json(&in->hop_module[i]));
+      } else {
+         hop = json_pack("{so}", "link-us", hist_json(&in->hop_link[i]));
+      }
+      if (json_array_append_new(arr, hop) == -1) {
+         json_decref(arr);
+         return NULL;
+      }
+   }
+   return arr;
+}
+
+json_t *trap_counters_in_json(const trap_in_counters_t *in)
+{
+   json_t *result;
+
+   result = json_pack("{sIsIsIso}", "messages", (json_int_t) in->messages,
+                      "buffers", (json_int_t) in->buffers, "bytes", (json_int_t) in->bytes,
+                      "wait-ns", hist_json(&in->wait));
+   if ((result != NULL) && (in->latency.count != 0)) {
+      /* buffers carry time of sending (trace or ENABLE_HEADER_TIMESTAMP) */
+      json_object_set_new(result, "latency-us", hist_json(&in->latency));
+      if (in->hop_link[0].count != 0) {
+         json_object_set_new(result, "hops", hops_json(in));
+      }
+   }
+   return result;
+}
+
+json_t *trap_counters_out_json(const trap_out_counters_t *out)
+{
+   return json_pack("{sIsIsIsIsIsoso}", "sent-messages", (json_int_t) out->messages,
+                    "dropped-messages", (json_int_t) out->dropped,
+                    "buffers", (json_int_t) out->buffers, "bytes", (json_int_t) out->bytes,
+                    "autoflushes", (json_int_t) out->autoflushes,
+                    "fill", array_json(out->fill, TRAP_FILL_BUCKETS),
+                    "wait-ns", hist_json(&out->wait));
+}
+
+/**
+ * @}
+ */
+
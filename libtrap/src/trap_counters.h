@@ -0,0 +1,259 @@
+/**
+ * \file trap_counters.h
+ * \brief Per-thread counters of IFCs
+ */
+/*
+ * Copyright (C) 2026 CESNET
+ *
+ * LICENSE TERMS
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name of the Company nor the names of its contributors
+ *    may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ *
+ * ALTERNATIVELY, provided that this notice is retained in full, this
+ * product may be distributed under the terms of the GNU General Public
+ * License (GPL) version 2 or later, in which case the provisions
+ * of the GPL apply INSTEAD OF those given above.
+ *
+ * This software is provided ``as is'', and any express or implied
+ * warranties, including, but not limited to, the implied warranties of
+ * merchantability and fitness for a particular purpose are disclaimed.
+ * In no event shall the company or contributors be liable for any
+ * direct, indirect, incidental, special, exemplary, or consequential
+ * damages (including, but not limited to, procurement of substitute
+ * goods or services; loss of use, data, or profits; or business
+ * interruption) however caused and on any theory of liability, whether
+ * in contract, strict liability, or tort (including negligence or
+ * otherwise) arising in any way out of the use of this software, even
+ * if advised of the possibility of such damage.
+ *
+ */
+#ifndef _TRAP_COUNTERS_H_
+#define _TRAP_COUNTERS_H_
+
+#include <stdint.h>
+#include <pthread.h>
+#include "../include/libtrap/jansson.h"
+#include "trap_trace.h"
+
+/**
+ * \defgroup trap_counters Counters of IFCs
+ *
+ * Counters of IFCs are updated on every sent or received message, possibly
+ * from many threads (see mpsc setter).  Every thread therefore gets its own
+ * block of counters and counters of every IFC start on their own cache line,
+ * so updates never share a cache line with another thread and need neither
+ * a lock nor an atomic read-modify-write.  Blocks are summed only when the
+ * counters are requested via service IFC (#SERVICE_GET_COM).
+ *
+ * A block of a thread is found by thread-specific key of the context.  When
+ * the thread exits, its block is detached and reused by the next thread, so
+ * no count is lost and the number of blocks is bounded by the maximal number
+ * of threads that use the context at once.
+ *
+ * Histograms have power-of-two buckets: bucket i counts values from 2^i to
+ * 2^(i+1) - 1 (bucket 0 counts also 0), the last bucket counts also all
+ * greater values.
+ * @{
+ */
+
+#define TRAP_HIST_BUCKETS 32 ///< Number of buckets of histogram
+#define TRAP_FILL_BUCKETS 10 ///< Number of buckets of histogram of buffer fill ratio (10 % each)
+#define TRAP_CACHE_LINE   64 ///< Alignment of counters of one IFC
+
+/**
+ * Histogram of values with power-of-two buckets.
+ */
+typedef struct trap_hist_s {
+   uint64_t count;                      ///< Number of values
+   uint64_t sum;                        ///< Sum of values
+   uint64_t buckets[TRAP_HIST_BUCKETS]; ///< Number of values in bucket
+} trap_hist_t;
+
+/**
+ * Counters of input IFC.
+ */
+typedef struct trap_in_counters_s {
+   uint64_t messages;       ///< Received messages
+   uint64_t buffers;        ///< Received buffers
+   uint64_t bytes;          ///< Received bytes of payload (after decompression)
+   trap_hist_t wait;        ///< Time spent in recv() of IFC (nanoseconds)
+   trap_hist_t latency;     ///< Delivery latency of buffers from sending by the first module to receiving (microseconds)
+   trap_hist_t hop_link[TRAP_TRACE_MAX_HOPS + 1]; ///< Traced delay of links between modules (microseconds), see \ref trap_trace
+   trap_hist_t hop_module[TRAP_TRACE_MAX_HOPS];   ///< Traced delay in forwarding modules (microseconds)
+} __attribute__ ((aligned (TRAP_CACHE_LINE))) trap_in_counters_t;
+
+/**
+ * Counters of output IFC.
+ */
+typedef struct trap_out_counters_s {
+   uint64_t messages;       ///< Sent messages
+   uint64_t dropped;        ///< Dropped messages
+   uint64_t buffers;        ///< Sent buffers
+   uint64_t bytes;          ///< Sent bytes of payload (before compression)
+   uint64_t autoflushes;    ///< Buffers flushed by autoflush
+   uint64_t fill[TRAP_FILL_BUCKETS]; ///< Sent buffers by fill ratio
+   trap_hist_t wait;        ///< Time spent in send() of IFC (nanoseconds)
+} __attribute__ ((aligned (TRAP_CACHE_LINE))) trap_out_counters_t;
+
+/**
+ * Counters of all IFCs owned by one thread.
+ */
+typedef struct trap_counters_block_s {
+   struct trap_counters_block_s *next; ///< Next block of the context
+   struct trap_counters_s *owner;      ///< Counters of the context the block belongs to
+   int attached;                       ///< 1 if owned by a running thread, 0 if free, -1 for shared block
+   trap_in_counters_t *in;             ///< Counters of input IFCs
+   trap_out_counters_t *out;           ///< Counters of output IFCs
+} trap_counters_block_t;
+
+/**
+ * Counters of a context.
+ */
+typedef struct trap_counters_s {
+   pthread_key_t key;              ///< Block of the current thread
+   pthread_mutex_t lock;           ///< Protects the list of blocks
+   trap_counters_block_t *blocks;  ///< List of all blocks
+   trap_counters_block_t *shared;  ///< Block used by threads that failed to allocate their own
+   uint32_t num_in;                ///< Number of input IFCs
+   uint32_t num_out;               ///< Number of output IFCs
+   int initialized;                ///< key and lock were created
+} trap_counters_t;
+
+/**
+ * Add to a counter owned by the current thread.
+ *
+ * The counter has a single writer, a relaxed store only makes the update
+ * visible to a concurrent reader without tearing.
+ */
+#define TRAP_CNT_ADD(cnt, n) __atomic_store_n(&(cnt), (cnt) + (n), __ATOMIC_RELAXED)
+
+/**
+ * Initialize counters of a context.
+ *
+ * \param[out] c  counters
+ * \param[in] num_in  number of input IFCs
+ * \param[in] num_out  number of output IFCs
+ * \return TRAP_E_OK on success, TRAP_E_MEMORY on error
+ */
+int trap_counters_init(trap_counters_t *c, uint32_t num_in, uint32_t num_out);
+
+/**
+ * Free all blocks of counters.  No thread may update counters anymore.
+ *
+ * \param[in,out] c  counters initialized by trap_counters_init(), can be uninitialized (zeroed)
+ */
+void trap_counters_destroy(trap_counters_t *c);
+
+/**
+ * Attach a block to the current thread (slow path of trap_counters_get()).
+ *
+ * \param[in,out] c  counters
+ * \return block of the thread, shared block when allocation failed
+ */
+trap_counters_block_t *trap_counters_attach(trap_counters_t *c);
+
+/**
+ * Get block of counters of the current thread.
+ *
+ * \param[in,out] c  counters
+ * \return block of the thread
+ */
+static inline trap_counters_block_t *trap_counters_get(trap_counters_t *c)
+{
+   trap_counters_block_t *b = (trap_counters_block_t *) pthread_getspecific(c->key);
+
+   if (__builtin_expect(b != NULL, 1)) {
+      return b;
+   }
+   return trap_counters_attach(c);
+}
+
+/**
+ * Get counters of input IFC of the current thread.
+ */
+static inline trap_in_counters_t *trap_counters_in(trap_counters_t *c, uint32_t ifc)
+{
+   return &trap_counters_get(c)->in[ifc];
+}
+
+/**
+ * Get counters of output IFC of the current thread.
+ */
+static inline trap_out_counters_t *trap_counters_out(trap_counters_t *c, uint32_t ifc)
+{
+   return &trap_counters_get(c)->out[ifc];
+}
+
+/**
+ * Get index of histogram bucket of value.
+ *
+ * \param[in] value  value
+ * \return index of bucket
+ */
+static inline uint32_t trap_hist_bucket(uint64_t value)
+{
+   uint32_t b;
+
+   if (value < 2) {
+      return 0;
+   }
+   b = 63 - __builtin_clzll(value);
+   return (b < TRAP_HIST_BUCKETS) ? b : TRAP_HIST_BUCKETS - 1;
+}
+
+/**
+ * Add value into histogram owned by the current thread.
+ *
+ * \param[in,out] h  histogram
+ * \param[in] value  value
+ */
+static inline void trap_hist_add(trap_hist_t *h, uint64_t value)
+{
+   TRAP_CNT_ADD(h->count, 1);
+   TRAP_CNT_ADD(h->sum, value);
+   TRAP_CNT_ADD(h->buckets[trap_hist_bucket(value)], 1);
+}
+
+/**
+ * Sum blocks of all threads.
+ *
+ * Counters are read while other threads update them, so the sum is not an
+ * atomic snapshot (e.g. messages can be counted before their buffer).
+ *
+ * \param[in] c  counters
+ * \return newly allocated block with sums (free() it), NULL on error
+ */
+trap_counters_block_t *trap_counters_sum(trap_counters_t *c);
+
+/**
+ * Encode summed counters of input IFC for service IFC.
+ *
+ * \param[in] in  counters
+ * \return json object, NULL on error
+ */
+json_t *trap_counters_in_json(const trap_in_counters_t *in);
+
+/**
+ * Encode summed counters of output IFC for service IFC.
+ *
+ * \param[in] out  counters
+ * \return json object, NULL on error
+ */
+json_t *trap_counters_out_json(const trap_out_counters_t *out);
+
+/**
+ * @}
+ */
+
+#endif
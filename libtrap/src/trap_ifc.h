@@ -50,8 +50,11 @@
 
 #include <stdint.h>
 #include <sys/time.h>
+#include <sys/uio.h>
 #include <pthread.h>
 #include <semaphore.h>
+#include "../include/libtrap/jansson.h"
+#include "trap_compress.h"
 
 /** \defgroup trap_ifc TRAP communication module interface
  * @{
@@ -136,6 +139,43 @@ typedef void (*ifc_create_dump_func_t)(void *p, uint32_t i, const char *d);
  */
 typedef int32_t (*ifc_get_client_count_func_t)(void *p);
 
+/**
+ * Get statistics specific for the IFC (optional).
+ *
+ * Returned JSON object is merged into counters of the interface
+ * that are sent via service IFC.
+ *
+ * \param[in] p   pointer to IFC's private memory allocated by constructor
+ * \returns new JSON object or NULL when there is nothing to report
+ */
+typedef json_t *(*ifc_get_stats_func_t)(void *p);
+
+/**
+ * Get descriptor that signals new data of input IFC (optional).
+ *
+ * It is used by trap_ctx_recv_any() to wait for data of several IFCs in one
+ * epoll set.  IFCs without this function are polled.
+ *
+ * \param[in] p     pointer to IFC's private memory allocated by constructor
+ * \param[out] fd   descriptor that becomes readable when new data arrive, -1 if there is none now (e.g. not connected)
+ * \param[out] gen  number that changes whenever the descriptor is closed, so that a reused number is registered again
+ * \returns 1 if IFC holds already received data and recv() would not wait, 0 otherwise
+ */
+typedef int (*ifc_get_fd_func_t)(void *p, int *fd, uint32_t *gen);
+
+/**
+ * Announce buffers that will be passed to send() of output IFC (optional).
+ *
+ * IFC can prepare them for faster sending, e.g. io_uring registers them
+ * into kernel.  It is called once the buffers of output IFC are allocated,
+ * send() can still get data from other memory.
+ *
+ * \param[in] p      pointer to IFC's private memory allocated by constructor
+ * \param[in] iov    buffers (buffer header followed by payload)
+ * \param[in] count  number of buffers
+ */
+typedef void (*ifc_register_buffers_func_t)(void *p, const struct iovec *iov, uint32_t count);
+
 /**
  * @}
  */
@@ -146,10 +186,13 @@ typedef struct trap_input_ifc_s {
    ifc_terminate_func_t terminate; ///< Pointer to terminate function
    ifc_destroy_func_t destroy;     ///< Pointer to destructor function
    ifc_create_dump_func_t create_dump; ///< Pointer to function for generating of dump
+   ifc_get_stats_func_t get_stats;  ///< Pointer to get_stats function (optional, can be NULL)
+   ifc_get_fd_func_t get_fd;       ///< Pointer to get_fd function (optional, can be NULL)
    void *priv;                     ///< Pointer to instance's private data
    char *buffer;                   ///< Internal pointer to buffer for messages
    char *buffer_pointer;           ///< Internal pointer to current message in buffer
    uint32_t buffer_full;           ///< Internal used space in message buffer (0 for empty buffer)
+   uint32_t buffer_size;           ///< Size of buffer (the biggest size announced by output IFC, #TRAP_IFC_MESSAGEQ_SIZE by default)
    int32_t datatimeout;            ///< Timeout for *_recv() calls
 
    /**
@@ -191,8 +234,115 @@ typedef struct trap_input_ifc_s {
     * data_fmt_spec contains e.g. UniRec template specifier (string representation)
     */
    char *req_data_fmt_spec;
+
+   uint8_t codec;                  ///< Codec announced by output IFC in hello message (TRAP_CODEC_*)
+   trap_compress_t *compress;      ///< Decompression of received buffers, allocated with the first compressed buffer
+   char trace;                     ///< Output IFC announced that buffers end with trace record (\ref trap_trace)
+
+   uint32_t recv_quota;            ///< Max consecutive messages of trap_ctx_recv_any() while other IFCs have data, 0 for whole buffer (#TRAPCTL_RECV_QUOTA)
+   int any_fd;                     ///< Descriptor registered into epoll set of trap_ctx_recv_any(), -1 if none
+   uint32_t any_gen;               ///< Generation of any_fd given by get_fd()
+   char any_ready;                 ///< epoll reported any_fd as readable
+#ifdef ENABLE_HEADER_TIMESTAMP
+   uint64_t timestamp;             ///< Timestamp from header of the last received buffer (us), set by IFC, 0 if unknown
+#endif
 } trap_input_ifc_t;
 
+/**
+ * Buffer filled by the module and queued for sending by the sender thread.
+ */
+typedef struct trap_pool_item_s {
+   unsigned char *buffer_header;   ///< Buffer with header followed by payload
+   uint32_t size;                  ///< Number of bytes to send (incl. header)
+} trap_pool_item_t;
+
+/**
+ * Pool of output buffers of an output interface (setter "buffers=N").
+ *
+ * While the sender thread sends full buffers, the module continues with
+ * filling a free one.  Buffers are exchanged under lock; buffer that is
+ * being filled is accessed under ifc_mtx of the interface only.
+ */
+typedef struct trap_buffer_pool_s {
+   uint32_t count;                 ///< Number of buffers in the pool
+   unsigned char **buffers;        ///< All allocated buffers (for free())
+   unsigned char **free_list;      ///< Stack of empty buffers
+   uint32_t free_count;            ///< Number of buffers in free_list
+   trap_pool_item_t *queue;        ///< Ring of full buffers waiting for sending
+   uint32_t queue_head;            ///< Index of the oldest buffer in queue
+   uint32_t queue_count;           ///< Number of buffers in queue
+   char in_flight;                 ///< 1 while the sender thread sends a buffer
+   char terminate;                 ///< Request to exit the sender thread
+   uint64_t dropped_messages;      ///< Messages dropped by sender thread, moved into counters by module's thread
+   pthread_mutex_t lock;           ///< Lock of the whole structure
+   pthread_cond_t cond_queued;     ///< Signalled when a buffer is queued or termination is requested
+   pthread_cond_t cond_released;   ///< Signalled when the sender thread returns a buffer into free_list
+   pthread_t thread;               ///< Sender thread
+   void *ctx;                      ///< Pointer to the private libtrap context data (trap_ctx_priv_t)
+   uint32_t ifc;                   ///< Index of output interface
+} trap_buffer_pool_t;
+
+/**
+ * Staging buffer of a producer thread, it is an item of MPSC queue when it is full.
+ */
+typedef struct trap_mpsc_item_s {
+   struct trap_mpsc_item_s *next;  ///< Next item in MPSC queue
+   unsigned char *buffer_header;   ///< Buffer with header followed by payload
+   uint32_t size;                  ///< Number of bytes to send (incl. header)
+   uint32_t messages;              ///< Number of messages in the buffer
+   char busy;                      ///< 1 from hand-over until the sender thread sends the buffer
+} trap_mpsc_item_t;
+
+/**
+ * Staging buffers of one producer thread (thread-specific data of the interface).
+ *
+ * Stage is accessed by its thread only except autoflush and trap_ctx_send_flush(),
+ * so its lock is uncontended.  Stages are cache-line aligned not to share
+ * cache lines between threads.
+ */
+typedef struct trap_mpsc_stage_s {
+   pthread_mutex_t lock;           ///< Lock of the stage
+   trap_mpsc_item_t *items;        ///< Ring of staging buffers
+   uint32_t count;                 ///< Number of staging buffers
+   uint32_t current;               ///< Index of the buffer being filled
+   uint32_t buffer_index;          ///< Index in the current buffer for new message
+   uint32_t messages;              ///< Number of messages in the current buffer
+   uint32_t reserved_size;         ///< Space (incl. message header) reserved by trap_ctx_send_reserve(), 0 if none
+   uint64_t flush_deadline;        ///< Absolute time (CLOCK_MONOTONIC, ns) of autoflush of the current buffer, 0 if not scheduled
+   char attached;                  ///< 1 while the stage belongs to a running thread
+   struct trap_mpsc_stage_s *next; ///< Next stage of the interface
+   struct trap_mpsc_s *mpsc;       ///< Owner
+} trap_mpsc_stage_t;
+
+/**
+ * Multi-producer sending of an output interface (setter "mpsc=N").
+ *
+ * Every thread calling trap_ctx_send() fills its own stage of N buffers,
+ * full buffers are handed over to the sender thread through a lock-free
+ * MPSC queue (intrusive list of D. Vyukov), so messages of one thread keep
+ * their order.  Sender thread returns sent buffers by clearing their busy
+ * flag, locks are used only for sleeping of the threads.
+ */
+typedef struct trap_mpsc_s {
+   trap_mpsc_item_t *head;         ///< Last queued item, producers exchange it atomically
+   trap_mpsc_item_t *tail;         ///< The oldest item, used by the sender thread only
+   trap_mpsc_item_t stub;          ///< Stub item of empty queue
+   uint32_t stage_buffers;         ///< Number of buffers of every stage
+   pthread_key_t key;              ///< Key of thread-specific stage
+   trap_mpsc_stage_t *stages;      ///< List of all stages
+   pthread_mutex_t stages_lock;    ///< Lock of the list of stages
+   uint64_t pending;               ///< Number of queued buffers that were not sent yet
+   int sender_waiting;             ///< Sender thread sleeps on cond_queued
+   int producers_waiting;          ///< Number of threads sleeping on cond_released
+   char terminate;                 ///< Request to exit the sender thread
+   pthread_mutex_t lock;           ///< Lock of sleeping on conditions
+   pthread_cond_t cond_queued;     ///< Signalled when a buffer is queued or termination is requested
+   pthread_cond_t cond_released;   ///< Signalled when the sender thread returns a buffer
+   pthread_t thread;               ///< Sender thread
+   void *ctx;                      ///< Pointer to the private libtrap context data (trap_ctx_priv_t)
+   uint32_t ifc;                   ///< Index of output interface
+} trap_mpsc_t;
+
 /** Struct to hold an instance of some output interface. */
 typedef struct trap_output_ifc_s {
    ifc_disconn_clients_func_t disconn_clients; ///< Pointer to disconnect_clients function
@@ -201,11 +351,23 @@ typedef struct trap_output_ifc_s {
    ifc_destroy_func_t destroy;     ///< Pointer to destructor function
    ifc_create_dump_func_t create_dump; ///< Pointer to function for generating of dump
    ifc_get_client_count_func_t get_client_count;  ///< Pointer to get_client_count function
+   ifc_get_stats_func_t get_stats;  ///< Pointer to get_stats function (optional, can be NULL)
+   ifc_register_buffers_func_t register_buffers; ///< Pointer to register_buffers function (optional, can be NULL)
    void *priv;                     ///< Pointer to instance's private data
    unsigned char *buffer;          ///< Internal pointer to buffer for messages
    unsigned char *buffer_header;   ///< Internal pointer to header of buffer followed by payload
    uint32_t buffer_index;          ///< Internal index in buffer for new message
+   uint32_t buffer_size;           ///< Size of buffers incl. header (setter "bufsize=N"), #TRAP_IFC_MESSAGEQ_SIZE by default
+   uint32_t flush_limit;           ///< Payload size when buffer is sent, adapted to rate of messages with "bufsize=auto"
+   char buffer_adaptive;           ///< Adapt flush_limit to rate of messages (setter "bufsize=auto")
    uint8_t buffer_occupied;        ///< If 0, buffer can be modified, otherwise drop message and don't move with buffer.
+   uint32_t reserved_size;         ///< Space (incl. message header) reserved by trap_ctx_send_reserve(), 0 if none.
+   uint32_t pool_size;             ///< Number of output buffers requested by setter "buffers=N", 0 or 1 means synchronous sending.
+   trap_buffer_pool_t *pool;       ///< Pool of output buffers with sender thread, NULL for synchronous sending.
+   uint32_t mpsc_size;             ///< Number of staging buffers per thread requested by setter "mpsc=N", 0 if disabled.
+   trap_mpsc_t *mpsc;              ///< Multi-producer sending with per-thread staging buffers, NULL if disabled.
+   trap_compress_t *compress;      ///< Compression of buffers requested by setter "compress=codec", NULL if disabled.
+   char trace;                     ///< Append trace record to every buffer (setter "trace" or LIBTRAP_TRACE), see \ref trap_trace
    pthread_mutex_t ifc_mtx;        ///< Locking mutex for interface.
    int64_t timeout;                ///< Internal structure to send partial data after timeout (autoflush).
 
@@ -223,7 +385,7 @@ typedef struct trap_output_ifc_s {
     */
    char bufferswitch_fixed;
 
-   char bufferflush;               ///< Flag (1) whether the buffer was sent before timeout has elapsed or not (0)
+   uint64_t flush_deadline;        ///< Absolute time (CLOCK_MONOTONIC, ns) when autoflush sends the buffer, 0 if not scheduled
    int32_t datatimeout;            ///< Timeout for *_send() calls
 
    /**
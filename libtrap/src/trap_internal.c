@@ -48,6 +48,7 @@
  *
  */
 #include <stdio.h>
+#include <string.h>
 #include "trap_internal.h"
 
 /**
@@ -111,3 +112,63 @@ void trap_verbose_msg(int level, char *string)
    fflush(stderr);
    string[0] = 0;
 }
+
+/**
+ * Sizes of static UniRec types.
+ */
+static const struct {
+   const char *name;
+   uint32_t size;
+} trap_ur_types[] = {
+   {"char", 1}, {"uint8", 1}, {"int8", 1}, {"uint16", 2}, {"int16", 2},
+   {"uint32", 4}, {"int32", 4}, {"uint64", 8}, {"int64", 8}, {"float", 4},
+   {"double", 8}, {"ipaddr", 16}, {"time", 8}, {NULL, 0}
+};
+
+int32_t trap_ur_type_size(const char *type, size_t len)
+{
+   int i;
+
+   for (i = 0; trap_ur_types[i].name != NULL; i++) {
+      if ((strlen(trap_ur_types[i].name) == len) && (strncmp(trap_ur_types[i].name, type, len) == 0)) {
+         return trap_ur_types[i].size;
+      }
+   }
+   return -1;
+}
+
+int32_t trap_ur_field_offset(const char *spec, const char *name, const char **type, uint32_t *size)
+{
+   const char *p = spec, *fname, *next;
+   size_t type_len, name_len = strlen(name), fname_len;
+   int32_t offset = 0, fsize;
+
+   while ((p != NULL) && (*p != '\0')) {
+      fname = strchr(p, ' ');
+      if (fname == NULL) {
+         return -1;
+      }
+      type_len = fname - p;
+      fname++;
+      next = strchr(fname, ',');
+      fname_len = (next == NULL ? strlen(fname) : (size_t) (next - fname));
+
+      fsize = trap_ur_type_size(p, type_len);
+      if (fsize < 0) {
+         /* dynamic or unknown type, no static field follows */
+         return -1;
+      }
+      if ((fname_len == name_len) && (strncmp(fname, name, name_len) == 0)) {
+         if (type != NULL) {
+            (*type) = p;
+         }
+         if (size != NULL) {
+            (*size) = fsize;
+         }
+         return offset;
+      }
+      offset += fsize;
+      p = (next == NULL ? NULL : next + 1);
+   }
+   return -1;
+}
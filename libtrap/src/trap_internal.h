@@ -55,6 +55,7 @@
 #include <pthread.h>
 #include "../include/libtrap/trap.h"
 #include "trap_ifc.h"
+#include "trap_counters.h"
 
 #define MAX_ERROR_MSG_BUFF_SIZE 1024
 
@@ -104,13 +105,26 @@ extern trap_ctx_priv_t * trap_glob_ctx;
 
 /**
  * Hello message header structure (used during the output and input interface negotiation).
- * Contains data format and data specifier size of the output interface which is making the negotiation.
+ * Contains data format, codec of buffers and data specifier size of the output interface which is making the negotiation.
  */
 typedef struct hello_msg_header_s {
    uint8_t data_type;
+   uint8_t codec;  ///< Compression of buffers (TRAP_CODEC_*), fills former padding so 0 is sent by older versions
+   uint8_t flags;  ///< Features of buffers (TRAP_HELLO_*), fills former padding as well
    uint32_t data_fmt_spec_size;
 } hello_msg_header_t;
 
+/**
+ * Flag of hello message: buffers end with trace record (see \ref trap_trace).
+ */
+#define TRAP_HELLO_TRACE 0x01
+
+/**
+ * Flag of hello message: size of buffers (uint32_t) follows the header, it is sent
+ * only when output IFC does not use the default #TRAP_IFC_MESSAGEQ_SIZE.
+ */
+#define TRAP_HELLO_BUFFER_SIZE 0x02
+
 
 /*!
 \brief VERBOSE/MSG levels
@@ -127,10 +141,22 @@ typedef enum trap_verbose_level {
 /**
  * \name Timeouts handling
  * @{*/
-#define TRAP_NO_IFC_SLEEP 2 ///< seconds to sleep, when autoflushing is not active
+#define TRAP_AUTOFLUSH_RETRY 1000 ///< microseconds to wait before autoflush retries an interface locked by module
+#define TRAP_RECV_ANY_POLL 10000 ///< microseconds between polls of input IFCs without descriptor in trap_ctx_recv_any()
 #define TRAP_IFC_TIMEOUT 500000 ///< size of default timeout on output interfaces in microseconds
 /**@}*/
 
+#define TRAP_IFC_MAX_BUFFERS 64 ///< maximal number of output buffers of an interface (setter "buffers=N")
+
+/**
+ * \name Size of buffers (setter "bufsize")
+ * @{*/
+#define TRAP_IFC_BUFFER_SIZE_MIN 4096              ///< minimal size of buffer incl. header
+#define TRAP_IFC_BUFFER_SIZE_MAX (4 * 1024 * 1024) ///< maximal size of buffer incl. header, default maximum of "bufsize=auto"
+#define TRAP_IFC_ADAPT_FILL_DIV 4                  ///< adaptive size is set to fill buffer in 1/N of autoflush timeout
+#define TRAP_IFC_ADAPT_MIN 2048                    ///< minimal flush limit (payload) of "bufsize=auto"
+/**@}*/
+
 #ifdef DEBUG
    /*! \brief Debug message macro if DEBUG macro is defined
     *
@@ -204,17 +230,6 @@ struct reader_threads_s {
    sem_t sem;        /**< semaphore used when thread is ought to sleep */
 };
 
-/**
- * List of all output interfaces and their timeouts.
- *
- * It is used by automatic flush buffer thread to send buffer after
- * a timeout on one of the output interfaces has elapsed.
- */
-struct out_ifc_timeout_s {
-   int idx;            /**< index of output interface */
-   int64_t tm;        /**< timeout to be elapsed */
-};
-
 /**
  * Libtrap context structure.
  *
@@ -231,11 +246,6 @@ struct trap_ctx_priv_s {
     */
    int terminated;
 
-   /**
-    * Is output interface parameter changed? (0 ~ false, should run)
-    */
-   int ifc_change;
-
    /**
     * Code of last error (one of the codes above)
     */
@@ -305,6 +315,10 @@ struct trap_ctx_priv_s {
     */
    int32_t readers_count;
 
+   int recv_any_epfd;          ///< epoll set of trap_ctx_recv_any(), -1 until the first call
+   uint32_t recv_any_last;     ///< Input IFC of the last message returned by trap_ctx_recv_any()
+   uint32_t recv_any_burst;    ///< Number of consecutive messages returned from recv_any_last
+
    /**
     * Thread to handle timeouts on output interfaces.
     */
@@ -316,9 +330,21 @@ struct trap_ctx_priv_s {
    int timeout_thread_initialized;
 
    /**
-    * Timeouts for autoflush
+    * Timer (timerfd, CLOCK_MONOTONIC) that wakes the autoflush thread at the
+    * nearest flush_deadline of output interfaces, -1 if not created.
+    */
+   int autoflush_fd;
+
+   /**
+    * Absolute time (ns) the autoflush timer is armed to, UINT64_MAX if no
+    * deadline is pending.  Protected by autoflush_mtx.
+    */
+   uint64_t autoflush_next;
+
+   /**
+    * Mutex that serializes arming of the autoflush timer.
     */
-   struct out_ifc_timeout_s *ifc_autoflush_timeout;
+   pthread_mutex_t autoflush_mtx;
 
    /**
     * Service thread that enables communication with module
@@ -331,38 +357,16 @@ struct trap_ctx_priv_s {
    int service_thread_initialized;
 
    /**
-    * \defgroup ctxifccounters IFC counters
+    * Counters of IFCs (see \ref trap_counters).
     *
     * The counters are sent by service_thread_routine() via service IFC (e.g. to supervisor).
-    * @{
-    */
-   /**
-    * counter_send_message is incremented within trap_ctx_send().
-    */
-   uint64_t *counter_send_message;
-   /**
-    * counter_dropped_message is incremented within trap_ctx_send().
-    */
-   uint64_t *counter_dropped_message;
-   /**
-    * counter_recv_message is incremented within trap_ctx_recv().
-    */
-   uint64_t *counter_recv_message;
-   /**
-    * counter_send_buffer is incremented within trap_store_into_buffer() after sending buffer.
-    */
-   uint64_t *counter_send_buffer;
-   /**
-    * counter_autoflush is incremented within trap_automatic_flush_thr() after flushing buffer.
     */
-   uint64_t *counter_autoflush;
-   /**
-    * counter_recv_buffer is incremented within trap_read_from_buffer() after successful receiving buffer.
-    */
-   uint64_t *counter_recv_buffer;
+   trap_counters_t counters;
+
    /**
-    * @}
+    * State of tracing of buffers (see \ref trap_trace), it links received and sent trace records.
     */
+   trap_trace_state_t trace;
 
    /**
     * Lock context (this structure)
@@ -381,6 +385,29 @@ struct trap_ctx_priv_s {
 
 trap_ctx_priv_t *trap_create_ctx_t();
 
+/**
+ * \brief Find static field of UniRec record described by data format specifier.
+ *
+ * Fields in data format specifier are listed in the order of the record,
+ * dynamic fields are the last ones.
+ *
+ * \param[in] spec   data format specifier ("type NAME,type NAME,...")
+ * \param[in] name   name of field
+ * \param[out] type  type of the field (not terminated, points into spec), can be NULL
+ * \param[out] size  size of the field, can be NULL
+ * \return offset of the field in record, -1 if it is not a static field of the record
+ */
+int32_t trap_ur_field_offset(const char *spec, const char *name, const char **type, uint32_t *size);
+
+/**
+ * \brief Get size of static UniRec type.
+ *
+ * \param[in] type  name of type (need not be terminated)
+ * \param[in] len   length of name
+ * \return size of the type, -1 for dynamic or unknown type
+ */
+int32_t trap_ur_type_size(const char *type, size_t len);
+
 struct trap_buffer_header_s {
    uint32_t data_length;  /**< size of data in the data unit */
 #ifdef ENABLE_HEADER_TIMESTAMP
@@ -0,0 +1,171 @@
+/**
+ * \file trap_trace.c
+ * \brief Tracing of latency of buffers across chains of modules
+ */
+/*
+ * Copyright (C) 2026 CESNET
+ *
+ * LICENSE TERMS
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name of the Company nor the names of its contributors
+ *    may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ *
+ * ALTERNATIVELY, provided that this notice is retained in full, this
+ * product may be distributed under the terms of the GNU General Public
+ * License (GPL) version 2 or later, in which case the provisions
+ * of the GPL apply INSTEAD OF those given above.
+ *
+ * This software is provided ``as is'', and any express or implied
+ * warranties, including, but not limited to, the implied warranties of
+ * merchantability and fitness for a particular purpose are disclaimed.
+ * In no event shall the company or contributors be liable for any
+ * direct, indirect, incidental, special, exemplary, or consequential
+ * damages (including, but not limited to, procurement of substitute
+ * goods or services; loss of use, data, or profits; or business
+ * interruption) however caused and on any theory of liability, whether
+ * in contract, strict liability, or tort (including negligence or
+ * otherwise) arising in any way out of the use of this software, even
+ * if advised of the possibility of such damage.
+ *
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <endian.h>
+#include <arpa/inet.h>
+
+#include "trap_trace.h"
+#include "trap_counters.h"
+
+/**
+ * \addtogroup trap_trace
+ * @{
+ */
+
+/**
+ * Get current time of CLOCK_REALTIME in microseconds.
+ *
+ * \return current time
+ */
+static uint64_t trace_now(void)
+{
+   struct timespec ts;
+
+   clock_gettime(CLOCK_REALTIME, &ts);
+   return (uint64_t) ts.tv_sec * 1000000ULL + ts.tv_nsec / 1000;
+}
+
+/**
+ * Get delay between two times, negative delay is 0.
+ *
+ * \param[in] from  the first time
+ * \param[in] to  the second time
+ * \return delay in microseconds
+ */
+static uint32_t trace_delay(uint64_t from, uint64_t to)
+{
+   if (to <= from) {
+      return 0;
+   }
+   return (to - from < UINT32_MAX) ? (uint32_t) (to - from) : UINT32_MAX;
+}
+
+void trap_trace_init(trap_trace_state_t *t)
+{
+   memset(t, 0, sizeof(*t));
+   pthread_mutex_init(&t->lock, NULL);
+}
+
+void trap_trace_destroy(trap_trace_state_t *t)
+{
+   pthread_mutex_destroy(&t->lock);
+}
+
+int trap_trace_env(void)
+{
+   const char *value = getenv("LIBTRAP_TRACE");
+
+   return ((value != NULL) && (value[0] != '\0') && (strcmp(value, "0") != 0));
+}
+
+void trap_trace_stamp(trap_trace_state_t *t, unsigned char *record)
+{
+   trap_trace_t r;
+   uint64_t now = trace_now();
+   int i;
+
+   pthread_mutex_lock(&t->lock);
+   if (t->valid != 0) {
+      /* continue the trace of the last received buffer, its link is already set */
+      r = t->last;
+      if (r.hops < TRAP_TRACE_MAX_HOPS) {
+         r.module[r.hops] = trace_delay(t->received, now);
+      }
+      if (r.hops < UINT8_MAX) {
+         r.hops++;
+      }
+   } else {
+      memset(&r, 0, sizeof(r));
+      r.origin = now;
+   }
+   pthread_mutex_unlock(&t->lock);
+   r.sent = now;
+
+   r.origin = htobe64(r.origin);
+   r.sent = htobe64(r.sent);
+   for (i = 0; i < TRAP_TRACE_MAX_HOPS; i++) {
+      r.link[i] = htonl(r.link[i]);
+      r.module[i] = htonl(r.module[i]);
+   }
+   memcpy(record, &r, sizeof(r));
+}
+
+void trap_trace_receive(trap_trace_state_t *t, struct trap_in_counters_s *cnt, const unsigned char *record)
+{
+   trap_trace_t r;
+   uint64_t now = trace_now();
+   uint32_t link;
+   int i, hops;
+
+   memcpy(&r, record, sizeof(r));
+   r.origin = be64toh(r.origin);
+   r.sent = be64toh(r.sent);
+   hops = (r.hops < TRAP_TRACE_MAX_HOPS) ? r.hops : TRAP_TRACE_MAX_HOPS;
+   for (i = 0; i < TRAP_TRACE_MAX_HOPS; i++) {
+      r.link[i] = ntohl(r.link[i]);
+      r.module[i] = ntohl(r.module[i]);
+      if (i < hops) {
+         trap_hist_add(&cnt->hop_link[i], r.link[i]);
+         trap_hist_add(&cnt->hop_module[i], r.module[i]);
+      }
+   }
+   /* link to this module is the last hop, or the extra item for longer chains */
+   link = trace_delay(r.sent, now);
+   trap_hist_add(&cnt->hop_link[hops], link);
+   trap_hist_add(&cnt->latency, trace_delay(r.origin, now));
+   if (r.hops < TRAP_TRACE_MAX_HOPS) {
+      r.link[r.hops] = link;
+   }
+
+   pthread_mutex_lock(&t->lock);
+   t->last = r;
+   t->received = now;
+   t->valid = 1;
+   pthread_mutex_unlock(&t->lock);
+}
+
+/**
+ * @}
+ */
+
@@ -0,0 +1,146 @@
+/**
+ * \file trap_trace.h
+ * \brief Tracing of latency of buffers across chains of modules
+ */
+/*
+ * Copyright (C) 2026 CESNET
+ *
+ * LICENSE TERMS
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name of the Company nor the names of its contributors
+ *    may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ *
+ * ALTERNATIVELY, provided that this notice is retained in full, this
+ * product may be distributed under the terms of the GNU General Public
+ * License (GPL) version 2 or later, in which case the provisions
+ * of the GPL apply INSTEAD OF those given above.
+ *
+ * This software is provided ``as is'', and any express or implied
+ * warranties, including, but not limited to, the implied warranties of
+ * merchantability and fitness for a particular purpose are disclaimed.
+ * In no event shall the company or contributors be liable for any
+ * direct, indirect, incidental, special, exemplary, or consequential
+ * damages (including, but not limited to, procurement of substitute
+ * goods or services; loss of use, data, or profits; or business
+ * interruption) however caused and on any theory of liability, whether
+ * in contract, strict liability, or tort (including negligence or
+ * otherwise) arising in any way out of the use of this software, even
+ * if advised of the possibility of such damage.
+ *
+ */
+#ifndef _TRAP_TRACE_H_
+#define _TRAP_TRACE_H_
+
+#include <stdint.h>
+#include <pthread.h>
+
+/**
+ * \defgroup trap_trace Latency tracing
+ *
+ * Output IFC with setter "trace" (or every output IFC when environment
+ * variable LIBTRAP_TRACE is set) appends a trace record to every buffer
+ * when the buffer is sent.  The trace record is announced to input IFC by
+ * #TRAP_HELLO_TRACE in the hello message during negotiation, input IFC
+ * removes it before messages are read from the buffer, so buffers of
+ * IFCs without trace keep their format.
+ *
+ * Trace record holds the time when the first module of the chain sent the
+ * buffer (origin) and the delays added by every module on the way.  Each
+ * module that forwards data (receives traced buffers and sends traced
+ * buffers) keeps the origin of the last received buffer and adds one hop:
+ * delay of the link from the previous module (sending to receiving) and
+ * delay spent in the module itself (receiving to sending).  The receiving
+ * module records end-to-end latency and delays of all hops into counters
+ * of input IFC that are available via service IFC.
+ *
+ * Times are CLOCK_REALTIME in microseconds, delays of links and end-to-end
+ * latency are correct only if clocks of hosts are synchronized, delays
+ * spent in modules do not depend on clocks of other hosts.  Delays that
+ * would be negative because of clock differences are counted as 0.
+ * @{
+ */
+
+#define TRAP_TRACE_MAX_HOPS 8 ///< Max number of hops stored in trace record
+
+/**
+ * Trace record appended to payload of buffer (in network byte order).
+ */
+typedef struct trap_trace_s {
+   uint64_t origin;                       ///< Time when the first module sent the buffer
+   uint64_t sent;                         ///< Time when the previous module sent the buffer
+   uint32_t link[TRAP_TRACE_MAX_HOPS];    ///< Delay from sending by module to receiving by the next one
+   uint32_t module[TRAP_TRACE_MAX_HOPS];  ///< Delay from receiving to sending in forwarding module
+   uint8_t hops;                          ///< Number of forwarding modules (can exceed #TRAP_TRACE_MAX_HOPS)
+   uint8_t reserved[7];                   ///< Zero
+} __attribute__ ((__packed__)) trap_trace_t;
+
+#define TRAP_TRACE_SIZE sizeof(trap_trace_t) ///< Size of trace record in buffer
+
+/**
+ * Trace of the last received buffer, shared by all IFCs of a context.
+ */
+typedef struct trap_trace_state_s {
+   pthread_mutex_t lock;    ///< Protects the rest of the structure
+   int valid;               ///< A traced buffer was received
+   trap_trace_t last;       ///< Trace record of the last received buffer (host byte order), incl. link to this module
+   uint64_t received;       ///< Time when the last traced buffer was received
+} trap_trace_state_t;
+
+struct trap_in_counters_s;
+
+/**
+ * Initialize state of tracing.
+ *
+ * \param[out] t  state
+ */
+void trap_trace_init(trap_trace_state_t *t);
+
+/**
+ * Free state of tracing.
+ *
+ * \param[in,out] t  state
+ */
+void trap_trace_destroy(trap_trace_state_t *t);
+
+/**
+ * Check whether tracing of all output IFCs is requested by environment (LIBTRAP_TRACE).
+ *
+ * \return 1 if tracing is requested, 0 otherwise
+ */
+int trap_trace_env(void);
+
+/**
+ * Write trace record of a buffer that is being sent.
+ *
+ * The record continues the trace of the last received buffer or starts a new one.
+ *
+ * \param[in] t  state
+ * \param[out] record  space for #TRAP_TRACE_SIZE bytes after payload of buffer
+ */
+void trap_trace_stamp(trap_trace_state_t *t, unsigned char *record);
+
+/**
+ * Process trace record of a received buffer: update histograms of input IFC
+ * and remember the trace for sending.
+ *
+ * \param[in,out] t  state
+ * \param[in,out] cnt  counters of input IFC of the current thread
+ * \param[in] record  trace record at the end of payload of buffer
+ */
+void trap_trace_receive(trap_trace_state_t *t, struct trap_in_counters_s *cnt, const unsigned char *record);
+
+/**
+ * @}
+ */
+
+#endif
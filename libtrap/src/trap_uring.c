@@ -0,0 +1,561 @@
+/**
+ * \file trap_uring.c
+ * \brief Minimal io_uring wrapper for socket IFCs
+ */
+/*
+ * Copyright (C) 2026 CESNET
+ *
+ * LICENSE TERMS
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name of the Company nor the names of its contributors
+ *    may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ *
+ * ALTERNATIVELY, provided that this notice is retained in full, this
+ * product may be distributed under the terms of the GNU General Public
+ * License (GPL) version 2 or later, in which case the provisions
+ * of the GPL apply INSTEAD OF those given above.
+ *
+ * This software is provided ``as is'', and any express or implied
+ * warranties, including, but not limited to, the implied warranties of
+ * merchantability and fitness for a particular purpose are disclaimed.
+ * In no event shall the company or contributors be liable for any
+ * direct, indirect, incidental, special, exemplary, or consequential
+ * damages (including, but not limited to, procurement of substitute
+ * goods or services; loss of use, data, or profits; or business
+ * interruption) however caused and on any theory of liability, whether
+ * in contract, strict liability, or tort (including negligence or
+ * otherwise) arising in any way out of the use of this software, even
+ * if advised of the possibility of such damage.
+ *
+ */
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+
+#include "../include/libtrap/trap.h"
+#include "trap_internal.h"
+#include "trap_uring.h"
+
+#ifdef HAVE_LINUX_IO_URING_H
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+#include <linux/io_uring.h>
+#endif
+
+/**
+ * \addtogroup trap_uring
+ * @{
+ */
+
+#if defined(HAVE_LINUX_IO_URING_H) && defined(IORING_RECV_MULTISHOT) && defined(__NR_io_uring_setup)
+
+#define URING_PBUF_GROUP 0 ///< Group id of provided buffers
+
+struct trap_uring_s {
+   int fd;                     ///< Descriptor of the ring
+   uint32_t sq_entries;        ///< Size of submission queue
+   uint32_t *sq_head;          ///< Head of submission queue (kernel)
+   uint32_t *sq_tail;          ///< Tail of submission queue (shared)
+   uint32_t sq_mask;           ///< Mask of submission queue indexes
+   uint32_t *sq_array;         ///< Indexes of SQEs
+   uint32_t sqe_tail;          ///< Tail including prepared requests that are not published yet
+   struct io_uring_sqe *sqes;  ///< Submission queue entries
+   uint32_t *cq_head;          ///< Head of completion queue (shared)
+   uint32_t *cq_tail;          ///< Tail of completion queue (kernel)
+   uint32_t cq_mask;           ///< Mask of completion queue indexes
+   struct io_uring_cqe *cqes;  ///< Completion queue entries
+   void *sq_ring;              ///< Mapping of submission queue ring
+   size_t sq_ring_size;        ///< Size of sq_ring
+   void *cq_ring;              ///< Mapping of completion queue ring, the same as sq_ring with IORING_FEAT_SINGLE_MMAP
+   size_t cq_ring_size;        ///< Size of cq_ring
+   size_t sqes_size;           ///< Size of sqes mapping
+   struct iovec *fixed;        ///< Registered buffers, NULL if none
+   uint32_t fixed_count;       ///< Number of registered buffers
+   struct io_uring_buf_ring *pbuf_ring; ///< Ring of provided buffers
+   size_t pbuf_ring_size;      ///< Size of pbuf_ring mapping
+   uint8_t *pbuf_data;         ///< Memory of provided buffers
+   uint32_t pbuf_count;        ///< Number of provided buffers
+   uint32_t pbuf_size;         ///< Size of one provided buffer
+   uint16_t pbuf_tail;         ///< Tail of pbuf_ring
+};
+
+static inline int sys_io_uring_setup(uint32_t entries, struct io_uring_params *p)
+{
+   return (int) syscall(__NR_io_uring_setup, entries, p);
+}
+
+static inline int sys_io_uring_enter(int fd, uint32_t to_submit, uint32_t min_complete, uint32_t flags, void *arg, size_t argsz)
+{
+   return (int) syscall(__NR_io_uring_enter, fd, to_submit, min_complete, flags, arg, argsz);
+}
+
+static inline int sys_io_uring_register(int fd, uint32_t opcode, const void *arg, uint32_t nr_args)
+{
+   return (int) syscall(__NR_io_uring_register, fd, opcode, arg, nr_args);
+}
+
+/**
+ * Check that kernel supports all operations used by IFCs.
+ *
+ * Multishot recv() and provided buffer rings come with the same kernel
+ * as IORING_OP_SEND_ZC, so it is used as a mark of sufficient version.
+ * \param[in] r  instance
+ * \return 1 if kernel is sufficient, 0 otherwise
+ */
+static int uring_probe(trap_uring_t *r)
+{
+   struct io_uring_probe *probe;
+   int ok = 0;
+
+   probe = calloc(1, sizeof(struct io_uring_probe) + 256 * sizeof(struct io_uring_probe_op));
+   if (probe == NULL) {
+      return 0;
+   }
+   if (sys_io_uring_register(r->fd, IORING_REGISTER_PROBE, probe, 256) == 0) {
+      ok = (probe->last_op >= IORING_OP_SEND_ZC) &&
+           (probe->ops[IORING_OP_SEND].flags & IO_URING_OP_SUPPORTED) &&
+           (probe->ops[IORING_OP_RECV].flags & IO_URING_OP_SUPPORTED) &&
+           (probe->ops[IORING_OP_SEND_ZC].flags & IO_URING_OP_SUPPORTED);
+   }
+   free(probe);
+   return ok;
+}
+
+trap_uring_t *trap_uring_create(uint32_t entries)
+{
+   struct io_uring_params p;
+   trap_uring_t *r;
+
+   r = (trap_uring_t *) calloc(1, sizeof(trap_uring_t));
+   if (r == NULL) {
+      return NULL;
+   }
+   r->sq_ring = r->cq_ring = MAP_FAILED;
+   r->sqes = MAP_FAILED;
+   memset(&p, 0, sizeof(p));
+   p.flags = IORING_SETUP_CQSIZE;
+   p.cq_entries = entries * 4;
+   r->fd = sys_io_uring_setup(entries, &p);
+   if (r->fd == -1) {
+      VERBOSE(CL_VERBOSE_LIBRARY, "io_uring_setup() failed (%d): %s", errno, strerror(errno));
+      free(r);
+      return NULL;
+   }
+   if (((p.features & IORING_FEAT_EXT_ARG) == 0) || (uring_probe(r) == 0)) {
+      VERBOSE(CL_VERBOSE_LIBRARY, "io_uring of this kernel does not support needed operations.");
+      goto failure;
+   }
+
+   r->sq_ring_size = p.sq_off.array + p.sq_entries * sizeof(uint32_t);
+   r->cq_ring_size = p.cq_off.cqes + p.cq_entries * sizeof(struct io_uring_cqe);
+   if (p.features & IORING_FEAT_SINGLE_MMAP) {
+      if (r->cq_ring_size > r->sq_ring_size) {
+         r->sq_ring_size = r->cq_ring_size;
+      }
+      r->cq_ring_size = r->sq_ring_size;
+   }
+   r->sq_ring = mmap(NULL, r->sq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, r->fd, IORING_OFF_SQ_RING);
+   if (r->sq_ring == MAP_FAILED) {
+      goto failure;
+   }
+   if (p.features & IORING_FEAT_SINGLE_MMAP) {
+      r->cq_ring = r->sq_ring;
+   } else {
+      r->cq_ring = mmap(NULL, r->cq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, r->fd, IORING_OFF_CQ_RING);
+      if (r->cq_ring == MAP_FAILED) {
+         goto failure;
+      }
+   }
+   r->sqes_size = p.sq_entries * sizeof(struct io_uring_sqe);
+   r->sqes = mmap(NULL, r->sqes_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, r->fd, IORING_OFF_SQES);
+   if (r->sqes == MAP_FAILED) {
+      goto failure;
+   }
+
+   r->sq_entries = p.sq_entries;
+   r->sq_head = (uint32_t *) ((char *) r->sq_ring + p.sq_off.head);
+   r->sq_tail = (uint32_t *) ((char *) r->sq_ring + p.sq_off.tail);
+   r->sq_mask = *(uint32_t *) ((char *) r->sq_ring + p.sq_off.ring_mask);
+   r->sq_array = (uint32_t *) ((char *) r->sq_ring + p.sq_off.array);
+   r->sqe_tail = *r->sq_tail;
+   r->cq_head = (uint32_t *) ((char *) r->cq_ring + p.cq_off.head);
+   r->cq_tail = (uint32_t *) ((char *) r->cq_ring + p.cq_off.tail);
+   r->cq_mask = *(uint32_t *) ((char *) r->cq_ring + p.cq_off.ring_mask);
+   r->cqes = (struct io_uring_cqe *) ((char *) r->cq_ring + p.cq_off.cqes);
+   return r;
+
+failure:
+   trap_uring_destroy(r);
+   return NULL;
+}
+
+void trap_uring_destroy(trap_uring_t *r)
+{
+   if (r == NULL) {
+      return;
+   }
+   /* closing of the ring cancels requests in flight */
+   close(r->fd);
+   if (r->sqes != MAP_FAILED) {
+      munmap(r->sqes, r->sqes_size);
+   }
+   if ((r->cq_ring != MAP_FAILED) && (r->cq_ring != r->sq_ring)) {
+      munmap(r->cq_ring, r->cq_ring_size);
+   }
+   if (r->sq_ring != MAP_FAILED) {
+      munmap(r->sq_ring, r->sq_ring_size);
+   }
+   if (r->pbuf_ring != NULL) {
+      munmap(r->pbuf_ring, r->pbuf_ring_size);
+   }
+   free(r->pbuf_data);
+   free(r->fixed);
+   free(r);
+}
+
+int trap_uring_fd(const trap_uring_t *r)
+{
+   return r->fd;
+}
+
+/**
+ * Get free submission queue entry, the queue is submitted when it is full.
+ * \param[in,out] r  instance
+ * \return cleared entry or NULL
+ */
+static struct io_uring_sqe *uring_get_sqe(trap_uring_t *r)
+{
+   struct io_uring_sqe *sqe;
+
+   if (r->sqe_tail - __atomic_load_n(r->sq_head, __ATOMIC_ACQUIRE) >= r->sq_entries) {
+      if ((trap_uring_submit(r, 0, 0) != TRAP_E_OK) ||
+          (r->sqe_tail - __atomic_load_n(r->sq_head, __ATOMIC_ACQUIRE) >= r->sq_entries)) {
+         return NULL;
+      }
+   }
+   sqe = &r->sqes[r->sqe_tail & r->sq_mask];
+   memset(sqe, 0, sizeof(*sqe));
+   r->sq_array[r->sqe_tail & r->sq_mask] = r->sqe_tail & r->sq_mask;
+   r->sqe_tail++;
+   return sqe;
+}
+
+int trap_uring_register_buffers(trap_uring_t *r, const struct iovec *iov, uint32_t count)
+{
+   if (r->fixed != NULL) {
+      sys_io_uring_register(r->fd, IORING_UNREGISTER_BUFFERS, NULL, 0);
+      free(r->fixed);
+      r->fixed = NULL;
+      r->fixed_count = 0;
+   }
+   if (count == 0) {
+      return TRAP_E_OK;
+   }
+   r->fixed = (struct iovec *) malloc(count * sizeof(struct iovec));
+   if (r->fixed == NULL) {
+      return TRAP_E_MEMORY;
+   }
+   memcpy(r->fixed, iov, count * sizeof(struct iovec));
+   if (sys_io_uring_register(r->fd, IORING_REGISTER_BUFFERS, iov, count) != 0) {
+      VERBOSE(CL_VERBOSE_LIBRARY, "Registration of buffers into io_uring failed (%d): %s", errno, strerror(errno));
+      goto failure;
+   }
+   r->fixed_count = count;
+   return TRAP_E_OK;
+
+failure:
+   free(r->fixed);
+   r->fixed = NULL;
+   r->fixed_count = 0;
+   return TRAP_E_IO_ERROR;
+}
+
+int trap_uring_pbuf_init(trap_uring_t *r, uint32_t count, uint32_t size)
+{
+   struct io_uring_buf_reg reg;
+   uint32_t i;
+
+   if ((count == 0) || ((count & (count - 1)) != 0) || (count > 32768) || (r->pbuf_ring != NULL)) {
+      return TRAP_E_BAD_FPARAMS;
+   }
+   r->pbuf_ring_size = count * sizeof(struct io_uring_buf);
+   r->pbuf_ring = mmap(NULL, r->pbuf_ring_size, PROT_READ | PROT_WRITE, MAP_ANONYMOUS | MAP_PRIVATE, -1, 0);
+   if (r->pbuf_ring == MAP_FAILED) {
+      r->pbuf_ring = NULL;
+      return TRAP_E_MEMORY;
+   }
+   r->pbuf_data = (uint8_t *) malloc((size_t) count * size);
+   if (r->pbuf_data == NULL) {
+      goto failure;
+   }
+   memset(&reg, 0, sizeof(reg));
+   reg.ring_addr = (uintptr_t) r->pbuf_ring;
+   reg.ring_entries = count;
+   reg.bgid = URING_PBUF_GROUP;
+   if (sys_io_uring_register(r->fd, IORING_REGISTER_PBUF_RING, &reg, 1) != 0) {
+      VERBOSE(CL_VERBOSE_LIBRARY, "Registration of provided buffers into io_uring failed (%d): %s", errno, strerror(errno));
+      goto failure;
+   }
+   r->pbuf_count = count;
+   r->pbuf_size = size;
+   for (i = 0; i < count; i++) {
+      trap_uring_pbuf_recycle(r, i);
+   }
+   return TRAP_E_OK;
+
+failure:
+   munmap(r->pbuf_ring, r->pbuf_ring_size);
+   r->pbuf_ring = NULL;
+   free(r->pbuf_data);
+   r->pbuf_data = NULL;
+   return TRAP_E_IO_ERROR;
+}
+
+uint8_t *trap_uring_pbuf(trap_uring_t *r, int32_t id)
+{
+   return r->pbuf_data + (size_t) id * r->pbuf_size;
+}
+
+void trap_uring_pbuf_recycle(trap_uring_t *r, int32_t id)
+{
+   struct io_uring_buf *b = &r->pbuf_ring->bufs[r->pbuf_tail & (r->pbuf_count - 1)];
+
+   b->addr = (uintptr_t) trap_uring_pbuf(r, id);
+   b->len = r->pbuf_size;
+   b->bid = id;
+   r->pbuf_tail++;
+   __atomic_store_n(&r->pbuf_ring->tail, r->pbuf_tail, __ATOMIC_RELEASE);
+}
+
+int trap_uring_prep_send(trap_uring_t *r, int fd, const void *data, uint32_t size, int zerocopy, uint64_t user_data)
+{
+   struct io_uring_sqe *sqe = uring_get_sqe(r);
+   uint32_t i;
+
+   if (sqe == NULL) {
+      return TRAP_E_IO_ERROR;
+   }
+   sqe->opcode = IORING_OP_SEND;
+   sqe->fd = fd;
+   sqe->addr = (uintptr_t) data;
+   sqe->len = size;
+   sqe->msg_flags = MSG_NOSIGNAL;
+   sqe->user_data = user_data;
+   if (zerocopy == 0) {
+      return TRAP_E_OK;
+   }
+   /* plain send() does not accept registered buffers, zero-copy send() does */
+   for (i = 0; i < r->fixed_count; i++) {
+      if (((const uint8_t *) data >= (const uint8_t *) r->fixed[i].iov_base) &&
+          ((const uint8_t *) data + size <= (const uint8_t *) r->fixed[i].iov_base + r->fixed[i].iov_len)) {
+         sqe->opcode = IORING_OP_SEND_ZC;
+         sqe->ioprio = IORING_RECVSEND_FIXED_BUF;
+         sqe->buf_index = i;
+         break;
+      }
+   }
+   return TRAP_E_OK;
+}
+
+int trap_uring_prep_recv_multishot(trap_uring_t *r, int fd, uint64_t user_data)
+{
+   struct io_uring_sqe *sqe = uring_get_sqe(r);
+
+   if ((sqe == NULL) || (r->pbuf_ring == NULL)) {
+      return TRAP_E_IO_ERROR;
+   }
+   sqe->opcode = IORING_OP_RECV;
+   sqe->fd = fd;
+   sqe->ioprio = IORING_RECV_MULTISHOT;
+   sqe->flags = IOSQE_BUFFER_SELECT;
+   sqe->buf_group = URING_PBUF_GROUP;
+   sqe->user_data = user_data;
+   return TRAP_E_OK;
+}
+
+int trap_uring_prep_cancel(trap_uring_t *r, uint64_t target, uint64_t user_data)
+{
+   struct io_uring_sqe *sqe = uring_get_sqe(r);
+
+   if (sqe == NULL) {
+      return TRAP_E_IO_ERROR;
+   }
+   sqe->opcode = IORING_OP_ASYNC_CANCEL;
+   sqe->fd = -1;
+   sqe->addr = target;
+   sqe->user_data = user_data;
+   return TRAP_E_OK;
+}
+
+int trap_uring_prep_cancel_all(trap_uring_t *r, uint64_t user_data)
+{
+   struct io_uring_sqe *sqe = uring_get_sqe(r);
+
+   if (sqe == NULL) {
+      return TRAP_E_IO_ERROR;
+   }
+   sqe->opcode = IORING_OP_ASYNC_CANCEL;
+   sqe->fd = -1;
+   sqe->cancel_flags = IORING_ASYNC_CANCEL_ANY;
+   sqe->user_data = user_data;
+   return TRAP_E_OK;
+}
+
+int trap_uring_submit(trap_uring_t *r, uint32_t wait_nr, int64_t timeout)
+{
+   struct io_uring_getevents_arg arg;
+   struct __kernel_timespec ts;
+   uint32_t to_submit, flags = 0;
+   int ret;
+
+   /* entries that kernel did not consume yet are submitted again */
+   to_submit = r->sqe_tail - __atomic_load_n(r->sq_head, __ATOMIC_ACQUIRE);
+   __atomic_store_n(r->sq_tail, r->sqe_tail, __ATOMIC_RELEASE);
+   if ((wait_nr > 0) && (trap_uring_ready(r) != 0)) {
+      /* do not wait when a completion is already available */
+      wait_nr = 0;
+   }
+   if ((to_submit == 0) && (wait_nr == 0)) {
+      return TRAP_E_OK;
+   }
+   memset(&arg, 0, sizeof(arg));
+   if (wait_nr > 0) {
+      flags = IORING_ENTER_GETEVENTS | IORING_ENTER_EXT_ARG;
+      if (timeout >= 0) {
+         ts.tv_sec = timeout / 1000000;
+         ts.tv_nsec = (timeout % 1000000) * 1000;
+         arg.ts = (uintptr_t) &ts;
+      }
+   }
+   ret = sys_io_uring_enter(r->fd, to_submit, wait_nr, flags, (flags != 0 ? &arg : NULL), (flags != 0 ? sizeof(arg) : 0));
+   if (ret == -1) {
+      if ((errno == ETIME) || (errno == EINTR)) {
+         return TRAP_E_TIMEOUT;
+      }
+      VERBOSE(CL_ERROR, "io_uring_enter() failed (%d): %s", errno, strerror(errno));
+      return TRAP_E_IO_ERROR;
+   }
+   return TRAP_E_OK;
+}
+
+int trap_uring_next(trap_uring_t *r, trap_uring_cqe_t *cqe)
+{
+   struct io_uring_cqe *c;
+   uint32_t head = *r->cq_head;
+
+   if (head == __atomic_load_n(r->cq_tail, __ATOMIC_ACQUIRE)) {
+      return 0;
+   }
+   c = &r->cqes[head & r->cq_mask];
+   cqe->user_data = c->user_data;
+   cqe->res = c->res;
+   cqe->buffer = (c->flags & IORING_CQE_F_BUFFER) ? (int32_t) (c->flags >> IORING_CQE_BUFFER_SHIFT) : -1;
+   cqe->more = ((c->flags & IORING_CQE_F_MORE) != 0);
+   cqe->notif = ((c->flags & IORING_CQE_F_NOTIF) != 0);
+   __atomic_store_n(r->cq_head, head + 1, __ATOMIC_RELEASE);
+   return 1;
+}
+
+int trap_uring_ready(const trap_uring_t *r)
+{
+   return (*r->cq_head != __atomic_load_n(r->cq_tail, __ATOMIC_ACQUIRE));
+}
+
+int trap_uring_fixed_buffers(const trap_uring_t *r)
+{
+   return (r->fixed_count > 0);
+}
+
+#else
+
+trap_uring_t *trap_uring_create(uint32_t entries)
+{
+   VERBOSE(CL_VERBOSE_LIBRARY, "libtrap was built without io_uring support.");
+   return NULL;
+}
+
+void trap_uring_destroy(trap_uring_t *r)
+{
+}
+
+int trap_uring_fd(const trap_uring_t *r)
+{
+   return -1;
+}
+
+int trap_uring_register_buffers(trap_uring_t *r, const struct iovec *iov, uint32_t count)
+{
+   return TRAP_E_IO_ERROR;
+}
+
+int trap_uring_pbuf_init(trap_uring_t *r, uint32_t count, uint32_t size)
+{
+   return TRAP_E_IO_ERROR;
+}
+
+uint8_t *trap_uring_pbuf(trap_uring_t *r, int32_t id)
+{
+   return NULL;
+}
+
+void trap_uring_pbuf_recycle(trap_uring_t *r, int32_t id)
+{
+}
+
+int trap_uring_prep_send(trap_uring_t *r, int fd, const void *data, uint32_t size, int zerocopy, uint64_t user_data)
+{
+   return TRAP_E_IO_ERROR;
+}
+
+int trap_uring_prep_recv_multishot(trap_uring_t *r, int fd, uint64_t user_data)
+{
+   return TRAP_E_IO_ERROR;
+}
+
+int trap_uring_prep_cancel(trap_uring_t *r, uint64_t target, uint64_t user_data)
+{
+   return TRAP_E_IO_ERROR;
+}
+
+int trap_uring_prep_cancel_all(trap_uring_t *r, uint64_t user_data)
+{
+   return TRAP_E_IO_ERROR;
+}
+
+int trap_uring_submit(trap_uring_t *r, uint32_t wait_nr, int64_t timeout)
+{
+   return TRAP_E_IO_ERROR;
+}
+
+int trap_uring_next(trap_uring_t *r, trap_uring_cqe_t *cqe)
+{
+   return 0;
+}
+
+int trap_uring_ready(const trap_uring_t *r)
+{
+   return 0;
+}
+
+int trap_uring_fixed_buffers(const trap_uring_t *r)
+{
+   return 0;
+}
+
+#endif
+
+/**
+ * @}
+ */
@@ -0,0 +1,227 @@
+/**
+ * \file trap_uring.h
+ * \brief Minimal io_uring wrapper for socket IFCs
+ */
+/*
+ * Copyright (C) 2026 CESNET
+ *
+ * LICENSE TERMS
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name of the Company nor the names of its contributors
+ *    may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ *
+ * ALTERNATIVELY, provided that this notice is retained in full, this
+ * product may be distributed under the terms of the GNU General Public
+ * License (GPL) version 2 or later, in which case the provisions
+ * of the GPL apply INSTEAD OF those given above.
+ *
+ * This software is provided ``as is'', and any express or implied
+ * warranties, including, but not limited to, the implied warranties of
+ * merchantability and fitness for a particular purpose are disclaimed.
+ * In no event shall the company or contributors be liable for any
+ * direct, indirect, incidental, special, exemplary, or consequential
+ * damages (including, but not limited to, procurement of substitute
+ * goods or services; loss of use, data, or profits; or business
+ * interruption) however caused and on any theory of liability, whether
+ * in contract, strict liability, or tort (including negligence or
+ * otherwise) arising in any way out of the use of this software, even
+ * if advised of the possibility of such damage.
+ *
+ */
+#ifndef _TRAP_URING_H_
+#define _TRAP_URING_H_
+
+#include <stdint.h>
+#include <sys/uio.h>
+
+/**
+ * \defgroup trap_uring io_uring wrapper
+ *
+ * Thin wrapper of io_uring system calls used by TCP/UNIX socket IFCs
+ * (parameter "io=uring"), it does not need liburing.  Output IFC submits
+ * send() to all clients as one batch.  It registers its buffers, so that
+ * TCP sockets send them by zero-copy send() without mapping of pages for
+ * every request.  Input IFC receives with a multishot recv() into a ring
+ * of provided buffers.
+ *
+ * The ring is used by one thread at a time.  When the kernel or the build
+ * does not support the needed features, trap_uring_create() returns NULL
+ * and the IFC falls back to epoll.
+ * @{
+ */
+
+/**
+ * Opaque state of one io_uring instance.
+ */
+typedef struct trap_uring_s trap_uring_t;
+
+/**
+ * Completion of a request.
+ */
+typedef struct trap_uring_cqe_s {
+   uint64_t user_data;         ///< Value given when the request was prepared
+   int32_t res;                ///< Result of the operation, -errno on error
+   int32_t buffer;             ///< Id of provided buffer with received data, -1 if none
+   char more;                  ///< Request produces more completions (multishot recv(), notification of zero-copy send())
+   char notif;                 ///< Notification of zero-copy send(), data of the request can be modified since now
+} trap_uring_cqe_t;
+
+/**
+ * Create io_uring instance.
+ *
+ * \param[in] entries  size of submission queue (rounded up to power of 2 by kernel)
+ * \return new instance or NULL when io_uring is not available
+ */
+trap_uring_t *trap_uring_create(uint32_t entries);
+
+/**
+ * Release io_uring instance, requests in flight are cancelled by kernel.
+ *
+ * \param[in] r  instance, can be NULL
+ */
+void trap_uring_destroy(trap_uring_t *r);
+
+/**
+ * Get descriptor of the ring, it is readable when a completion is available.
+ *
+ * \param[in] r  instance
+ * \return file descriptor
+ */
+int trap_uring_fd(const trap_uring_t *r);
+
+/**
+ * Register buffers, zero-copy send() of data inside them avoids mapping of pages.
+ *
+ * Previously registered buffers are replaced.
+ *
+ * \param[in,out] r   instance
+ * \param[in] iov     buffers
+ * \param[in] count   number of buffers
+ * \return TRAP_E_OK on success, TRAP_E_IO_ERROR when kernel refused them (e.g. RLIMIT_MEMLOCK)
+ */
+int trap_uring_register_buffers(trap_uring_t *r, const struct iovec *iov, uint32_t count);
+
+/**
+ * Allocate and register ring of provided buffers for multishot receiving.
+ *
+ * \param[in,out] r   instance
+ * \param[in] count   number of buffers, power of 2
+ * \param[in] size    size of every buffer
+ * \return TRAP_E_OK on success, TRAP_E_MEMORY, TRAP_E_IO_ERROR
+ */
+int trap_uring_pbuf_init(trap_uring_t *r, uint32_t count, uint32_t size);
+
+/**
+ * Get data of provided buffer.
+ *
+ * \param[in] r   instance
+ * \param[in] id  trap_uring_cqe_t::buffer
+ * \return pointer to the buffer
+ */
+uint8_t *trap_uring_pbuf(trap_uring_t *r, int32_t id);
+
+/**
+ * Return provided buffer into the ring after its data was processed.
+ *
+ * \param[in,out] r  instance
+ * \param[in] id     trap_uring_cqe_t::buffer
+ */
+void trap_uring_pbuf_recycle(trap_uring_t *r, int32_t id);
+
+/**
+ * Prepare send() of data, it never raises SIGPIPE.
+ *
+ * With zerocopy, data inside a registered buffer is sent by zero-copy
+ * send() from the registered buffer.  Its completion has trap_uring_cqe_t::more
+ * set and it is followed by a notification (trap_uring_cqe_t::notif), the
+ * data must not be modified until the notification.  Zero-copy send() is
+ * supported by TCP sockets only.
+ *
+ * \param[in,out] r      instance
+ * \param[in] fd         socket
+ * \param[in] data       data to send
+ * \param[in] size       size of data
+ * \param[in] zerocopy   non-zero to use zero-copy send() for registered buffers
+ * \param[in] user_data  identification of the request in its completion(s)
+ * \return TRAP_E_OK on success, TRAP_E_IO_ERROR when submission queue is full and cannot be submitted
+ */
+int trap_uring_prep_send(trap_uring_t *r, int fd, const void *data, uint32_t size, int zerocopy, uint64_t user_data);
+
+/**
+ * Prepare multishot recv() into provided buffers (see trap_uring_pbuf_init()).
+ *
+ * \param[in,out] r      instance
+ * \param[in] fd         socket
+ * \param[in] user_data  identification of the request in its completions
+ * \return TRAP_E_OK on success, TRAP_E_IO_ERROR
+ */
+int trap_uring_prep_recv_multishot(trap_uring_t *r, int fd, uint64_t user_data);
+
+/**
+ * Prepare cancellation of a request.
+ *
+ * \param[in,out] r      instance
+ * \param[in] target     user_data of the request to cancel
+ * \param[in] user_data  identification of the cancellation in its completion
+ * \return TRAP_E_OK on success, TRAP_E_IO_ERROR
+ */
+int trap_uring_prep_cancel(trap_uring_t *r, uint64_t target, uint64_t user_data);
+
+/**
+ * Prepare cancellation of all requests in flight.
+ *
+ * \param[in,out] r      instance
+ * \param[in] user_data  identification of the cancellation in its completion
+ * \return TRAP_E_OK on success, TRAP_E_IO_ERROR
+ */
+int trap_uring_prep_cancel_all(trap_uring_t *r, uint64_t user_data);
+
+/**
+ * Submit prepared requests and wait for completions.
+ *
+ * \param[in,out] r    instance
+ * \param[in] wait_nr  minimal number of completions to wait for, 0 to submit only
+ * \param[in] timeout  maximal time of waiting in microseconds, -1 to block
+ * \return TRAP_E_OK, TRAP_E_TIMEOUT (also when interrupted by signal), TRAP_E_IO_ERROR
+ */
+int trap_uring_submit(trap_uring_t *r, uint32_t wait_nr, int64_t timeout);
+
+/**
+ * Take the oldest completion.
+ *
+ * \param[in,out] r  instance
+ * \param[out] cqe   completion
+ * \return 1 if a completion was taken, 0 if there is none
+ */
+int trap_uring_next(trap_uring_t *r, trap_uring_cqe_t *cqe);
+
+/**
+ * Check whether a completion is available.
+ *
+ * \param[in] r  instance
+ * \return non-zero if trap_uring_next() would take a completion
+ */
+int trap_uring_ready(const trap_uring_t *r);
+
+/**
+ * Check whether buffers are registered.
+ *
+ * \param[in] r  instance
+ * \return non-zero if trap_uring_register_buffers() succeeded
+ */
+int trap_uring_fixed_buffers(const trap_uring_t *r);
+
+/**
+ * @}
+ */
+#endif
@@ -0,0 +1,246 @@
+/**
+ * \file test_autoflush_latency.c
+ * \brief Test: delay of messages of a trickle stream is bounded by autoflush timeout
+ */
+/*
+ * Copyright (C) 2026 CESNET
+ *
+ * LICENSE TERMS
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name of the Company nor the names of its contributors
+ *    may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ *
+ * ALTERNATIVELY, provided that this notice is retained in full, this
+ * product may be distributed under the terms of the GNU General Public
+ * License (GPL) version 2 or later, in which case the provisions
+ * of the GPL apply INSTEAD OF those given above.
+ *
+ * This software is provided ``as is'', and any express or implied
+ * warranties, including, but not limited to, the implied warranties of
+ * merchantability and fitness for a particular purpose are disclaimed.
+ * In no event shall the company or contributors be liable for any
+ * direct, indirect, incidental, special, exemplary, or consequential
+ * damages (including, but not limited to, procurement of substitute
+ * goods or services; loss of use, data, or profits; or business
+ * interruption) however caused and on any theory of liability, whether
+ * in contract, strict liability, or tort (including negligence or
+ * otherwise) arising in any way out of the use of this software, even
+ * if advised of the possibility of such damage.
+ *
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <stdint.h>
+#include <inttypes.h>
+#include <pthread.h>
+#include <time.h>
+#include <libtrap/trap.h>
+
+#define MESSAGES 200        ///< Default number of messages
+#define PERIOD 7000         ///< Default period of messages (microseconds)
+#define AUTOFLUSH 20000     ///< Default autoflush timeout (microseconds)
+#define SLACK 30000         ///< Allowed scheduling delay above autoflush timeout (microseconds)
+
+trap_module_info_t out_module_info = {
+   "Autoflush latency test sender", // Module name
+   // Module description
+   "\n",
+   0, // Number of input interfaces
+   1, // Number of output interfaces
+};
+
+trap_module_info_t in_module_info = {
+   "Autoflush latency test receiver", // Module name
+   // Module description
+   "\n",
+   1, // Number of input interfaces
+   0, // Number of output interfaces
+};
+
+struct receiver_arg {
+   trap_ctx_t *ctx;
+   uint32_t messages;
+   uint64_t *delays;     ///< Send-to-receive delay of every message (nanoseconds)
+   uint32_t received;
+};
+
+static uint64_t now_ns(void)
+{
+   struct timespec ts;
+
+   clock_gettime(CLOCK_MONOTONIC, &ts);
+   return (uint64_t) ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static trap_ctx_t *init_ctx(trap_module_info_t *info, char *ifc)
+{
+   char *argv[] = {"test", "-i", ifc};
+   int argc = 3;
+   trap_ifc_spec_t ifc_spec;
+   trap_ctx_t *ctx;
+
+   if (trap_parse_params(&argc, argv, &ifc_spec) != TRAP_E_OK) {
+      fprintf(stderr, "Error in parsing of parameters for TRAP: %s\n", trap_last_error_msg);
+      return NULL;
+   }
+   ctx = trap_ctx_init(info, ifc_spec);
+   trap_free_ifc_spec(ifc_spec);
+   if ((ctx != NULL) && (trap_ctx_get_last_error(ctx) != TRAP_E_OK)) {
+      fprintf(stderr, "Error in TRAP initialization: %s\n", trap_ctx_get_last_error_msg(ctx));
+      trap_ctx_finalize(&ctx);
+      return NULL;
+   }
+   return ctx;
+}
+
+static void *receiver(void *arg)
+{
+   struct receiver_arg *r = (struct receiver_arg *) arg;
+   const void *data;
+   uint16_t size;
+   uint64_t sent;
+   int ret;
+
+   while (r->received < r->messages) {
+      ret = trap_ctx_recv(r->ctx, 0, &data, &size);
+      if (ret == TRAP_E_TIMEOUT) {
+         fprintf(stderr, "No message received within timeout after %"PRIu32" messages.\n", r->received);
+         break;
+      }
+      TRAP_DEFAULT_RECV_ERROR_HANDLING(ret, continue, break);
+      if (size != sizeof(sent)) {
+         fprintf(stderr, "Unexpected message size %"PRIu16".\n", size);
+         break;
+      }
+      memcpy(&sent, data, sizeof(sent));
+      r->delays[r->received++] = now_ns() - sent;
+   }
+   return NULL;
+}
+
+static int compare_delays(const void *a, const void *b)
+{
+   uint64_t x = *((const uint64_t *) a), y = *((const uint64_t *) b);
+   return (x > y) - (x < y);
+}
+
+static double percentile(const uint64_t *sorted, uint32_t count, int p)
+{
+   return sorted[(uint64_t) (count - 1) * p / 100] / 1000.0;
+}
+
+int main(int argc, char **argv)
+{
+   int opt, result = EXIT_FAILURE;
+   uint32_t i, messages = MESSAGES;
+   uint64_t period = PERIOD, autoflush = AUTOFLUSH, stamp, start;
+   char ifc[64];
+   pthread_t thread;
+   struct receiver_arg r;
+   trap_ctx_t *out_ctx, *in_ctx;
+
+   while ((opt = getopt(argc, argv, "n:p:t:")) != -1) {
+      switch (opt) {
+      case 'n':
+         messages = strtoul(optarg, NULL, 10);
+         break;
+      case 'p':
+         period = strtoull(optarg, NULL, 10);
+         break;
+      case 't':
+         autoflush = strtoull(optarg, NULL, 10);
+         break;
+      default:
+         fprintf(stderr, "Usage: %s [-n messages] [-p period_us] [-t autoflush_us]\n", argv[0]);
+         return EXIT_FAILURE;
+      }
+   }
+   if (messages == 0) {
+      fprintf(stderr, "Number of messages must be positive.\n");
+      return EXIT_FAILURE;
+   }
+
+   snprintf(ifc, sizeof(ifc), "u:test_autoflush_latency_%d", (int) getpid());
+   out_ctx = init_ctx(&out_module_info, ifc);
+   if (out_ctx == NULL) {
+      return EXIT_FAILURE;
+   }
+   trap_ctx_set_data_fmt(out_ctx, 0, TRAP_FMT_RAW);
+   trap_ctx_ifcctl(out_ctx, TRAPIFC_OUTPUT, 0, TRAPCTL_AUTOFLUSH_TIMEOUT, autoflush);
+
+   in_ctx = init_ctx(&in_module_info, ifc);
+   if (in_ctx == NULL) {
+      goto finalize_out;
+   }
+   trap_ctx_set_required_fmt(in_ctx, 0, TRAP_FMT_RAW);
+   trap_ctx_ifcctl(in_ctx, TRAPIFC_INPUT, 0, TRAPCTL_SETTIMEOUT, (int32_t) (autoflush + 2000000));
+
+   r.ctx = in_ctx;
+   r.messages = messages;
+   r.received = 0;
+   r.delays = calloc(messages, sizeof(uint64_t));
+   if (r.delays == NULL) {
+      fprintf(stderr, "Not enough memory.\n");
+      goto finalize_in;
+   }
+   if (pthread_create(&thread, NULL, receiver, &r) != 0) {
+      fprintf(stderr, "Creation of receiver thread failed.\n");
+      goto free_delays;
+   }
+
+   /* send at absolute times so that the stream rate does not depend on the cost of send */
+   start = now_ns();
+   for (i = 0; i < messages; i++) {
+      struct timespec next;
+      stamp = start + i * period * 1000;
+      next.tv_sec = stamp / 1000000000ULL;
+      next.tv_nsec = stamp % 1000000000ULL;
+      while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &next, NULL) != 0);
+      stamp = now_ns();
+      if (trap_ctx_send(out_ctx, 0, &stamp, sizeof(stamp)) != TRAP_E_OK) {
+         fprintf(stderr, "Sending failed: %s\n", trap_ctx_get_last_error_msg(out_ctx));
+         break;
+      }
+   }
+   pthread_join(thread, NULL);
+
+   if (r.received != messages) {
+      fprintf(stderr, "Received %"PRIu32" messages instead of %"PRIu32".\n", r.received, messages);
+      goto free_delays;
+   }
+   /* the first message waits for connection of the receiver */
+   qsort(r.delays + 1, messages - 1, sizeof(uint64_t), compare_delays);
+   if (messages > 1) {
+      printf("Delay of %"PRIu32" messages (period %"PRIu64" us, autoflush %"PRIu64" us) [us]:\n"
+             "min %.1f  p50 %.1f  p90 %.1f  p99 %.1f  max %.1f\n",
+             messages - 1, period, autoflush,
+             r.delays[1] / 1000.0, percentile(r.delays + 1, messages - 1, 50),
+             percentile(r.delays + 1, messages - 1, 90), percentile(r.delays + 1, messages - 1, 99),
+             r.delays[messages - 1] / 1000.0);
+      if (r.delays[messages - 1] > (autoflush + SLACK) * 1000) {
+         fprintf(stderr, "Maximal delay exceeds autoflush timeout.\n");
+         goto free_delays;
+      }
+   }
+   result = EXIT_SUCCESS;
+
+free_delays:
+   free(r.delays);
+finalize_in:
+   trap_ctx_finalize(&in_ctx);
+finalize_out:
+   trap_ctx_finalize(&out_ctx);
+   return result;
+}
@@ -0,0 +1,238 @@
+/**
+ * \file test_buffers.c
+ * \brief Benchmark: throughput of output IFC with one buffer vs. pool of buffers (setter buffers=N)
+ */
+/*
+ * Copyright (C) 2026 CESNET
+ *
+ * LICENSE TERMS
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name of the Company nor the names of its contributors
+ *    may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ *
+ * ALTERNATIVELY, provided that this notice is retained in full, this
+ * product may be distributed under the terms of the GNU General Public
+ * License (GPL) version 2 or later, in which case the provisions
+ * of the GPL apply INSTEAD OF those given above.
+ *
+ * This software is provided ``as is'', and any express or implied
+ * warranties, including, but not limited to, the implied warranties of
+ * merchantability and fitness for a particular purpose are disclaimed.
+ * In no event shall the company or contributors be liable for any
+ * direct, indirect, incidental, special, exemplary, or consequential
+ * damages (including, but not limited to, procurement of substitute
+ * goods or services; loss of use, data, or profits; or business
+ * interruption) however caused and on any theory of liability, whether
+ * in contract, strict liability, or tort (including negligence or
+ * otherwise) arising in any way out of the use of this software, even
+ * if advised of the possibility of such damage.
+ *
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <getopt.h>
+#include <unistd.h>
+#include <stdint.h>
+#include <inttypes.h>
+#include <pthread.h>
+#include <libtrap/trap.h>
+
+#define ERRARG -1
+
+// Struct with information about module
+trap_module_info_t module_info = {
+   "Output buffers benchmark", // Module name
+   // Module description
+   "Send messages from output IFC to input IFC of the same module and measure throughput.\n",
+   1, // Number of input interfaces
+   1, // Number of output interfaces
+};
+
+trap_ctx_t *ctx = NULL;
+
+void help(const char *progname)
+{
+   printf("%s -i ifcspec [-h] [-c count] [-n size] [-w work] [-r usec]\n"
+          "\t-i\tlibtrap IFC spec of input and output, e.g. u:bench,u:bench:buffers=4\n"
+          "\t-c\tnumber of messages (default 10000000)\n"
+          "\t-n\tsize of message in bytes (default 100)\n"
+          "\t-w\tsimulated work of the module per message (default 50 iterations)\n"
+          "\t-r\treceiver stalls for usec after every 1000 messages (default 0), i.e. bursty consumer\n",
+          progname);
+}
+
+struct rx_result {
+   uint64_t received;
+   uint64_t lost;
+   uint32_t stall;
+};
+
+/**
+ * Receiver thread: count messages and check their sequence numbers.
+ */
+static void *receiver_thr(void *arg)
+{
+   struct rx_result *res = (struct rx_result *) arg;
+   const void *data;
+   uint16_t size;
+   uint64_t expected = 0, seq;
+   int ret;
+
+   while (1) {
+      ret = trap_ctx_recv(ctx, 0, &data, &size);
+      if (ret != TRAP_E_OK) {
+         fprintf(stderr, "trap_ctx_recv() failed: %d\n", ret);
+         break;
+      }
+      if (size <= 1) {
+         break;
+      }
+      seq = *((const uint64_t *) data);
+      if (seq != expected) {
+         res->lost += seq - expected;
+      }
+      expected = seq + 1;
+      res->received++;
+      if ((res->stall != 0) && (res->received % 1000 == 0)) {
+         usleep(res->stall);
+      }
+   }
+   return NULL;
+}
+
+/**
+ * Simulate processing of a record in module, e.g. parsing or aggregation.
+ */
+static inline uint64_t do_work(uint64_t seed, uint32_t work)
+{
+   uint32_t i;
+   for (i = 0; i < work; i++) {
+      seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+   }
+   return seed;
+}
+
+static double elapsed_ns(const struct timespec *start, const struct timespec *end)
+{
+   return (end->tv_sec - start->tv_sec) * 1e9 + (end->tv_nsec - start->tv_nsec);
+}
+
+int main(int argc, char **argv)
+{
+   int ret;
+   signed char opt;
+   uint64_t i, count = 10000000;
+   uint16_t payload_size = 100;
+   uint32_t work = 50;
+   uint8_t *payload = NULL;
+   struct timespec start, end, t1, t2;
+   double ns, send_ns = 0, max_send_ns = 0, d;
+   pthread_t rx_thread;
+   struct rx_result rx = {0, 0, 0};
+   trap_ifc_spec_t ifc_spec;
+
+   ret = trap_parse_params(&argc, argv, &ifc_spec);
+   if (ret != TRAP_E_OK) {
+      if (ret == TRAP_E_HELP) {
+         help(argv[0]);
+         return 0;
+      }
+      fprintf(stderr, "ERROR in parsing of parameters for TRAP: %s\n", trap_last_error_msg);
+      return 1;
+   }
+
+   while ((opt = getopt(argc, argv, "hc:n:w:r:")) != ERRARG) {
+      switch (opt) {
+      case 'c':
+         sscanf(optarg, "%"SCNu64, &count);
+         break;
+      case 'n':
+         sscanf(optarg, "%"SCNu16, &payload_size);
+         break;
+      case 'w':
+         sscanf(optarg, "%"SCNu32, &work);
+         break;
+      case 'r':
+         sscanf(optarg, "%"SCNu32, &rx.stall);
+         break;
+      case 'h':
+         help(argv[0]);
+         return 0;
+      }
+   }
+   if (payload_size < sizeof(uint64_t)) {
+      payload_size = sizeof(uint64_t);
+   }
+
+   ctx = trap_ctx_init(&module_info, ifc_spec);
+   trap_free_ifc_spec(ifc_spec);
+   if (ctx == NULL || trap_ctx_get_last_error(ctx) != TRAP_E_OK) {
+      fprintf(stderr, "Trap_ctx_init failed.\n");
+      return 1;
+   }
+   trap_ctx_set_data_fmt(ctx, 0, TRAP_FMT_RAW);
+   trap_ctx_set_required_fmt(ctx, 0, TRAP_FMT_RAW);
+   trap_ctx_ifcctl(ctx, TRAPIFC_OUTPUT, 0, TRAPCTL_SETTIMEOUT, TRAP_WAIT);
+   trap_ctx_ifcctl(ctx, TRAPIFC_INPUT, 0, TRAPCTL_SETTIMEOUT, TRAP_WAIT);
+
+   payload = (uint8_t *) calloc(1, payload_size);
+   if (payload == NULL) {
+      fprintf(stderr, "Allocation of payload buffer failed.\n");
+      ret = 1;
+      goto exit;
+   }
+   if (pthread_create(&rx_thread, NULL, receiver_thr, &rx) != 0) {
+      fprintf(stderr, "Creation of receiver thread failed.\n");
+      ret = 1;
+      goto exit;
+   }
+
+   clock_gettime(CLOCK_MONOTONIC, &start);
+   for (i = 0; i < count; i++) {
+      *((uint64_t *) payload) = i;
+      *((uint64_t *) (payload + payload_size - sizeof(uint64_t))) ^= do_work(i, work);
+      clock_gettime(CLOCK_MONOTONIC, &t1);
+      ret = trap_ctx_send(ctx, 0, payload, payload_size);
+      clock_gettime(CLOCK_MONOTONIC, &t2);
+      d = elapsed_ns(&t1, &t2);
+      send_ns += d;
+      if (d > max_send_ns) {
+         max_send_ns = d;
+      }
+      if (ret != TRAP_E_OK) {
+         fprintf(stderr, "trap_ctx_send() failed: %d\n", ret);
+         break;
+      }
+   }
+   /* ending message */
+   trap_ctx_send(ctx, 0, payload, 1);
+   trap_ctx_send_flush(ctx, 0);
+   pthread_join(rx_thread, NULL);
+   clock_gettime(CLOCK_MONOTONIC, &end);
+   ns = elapsed_ns(&start, &end);
+
+   printf("Messages: %"PRIu64" x %"PRIu16" B, received %"PRIu64", lost %"PRIu64"\n"
+          "Time: %.3f s, %.2f Mmsg/s, %.1f MB/s\n"
+          "Producer in trap_ctx_send(): %.3f s total, %.1f us max\n",
+          count, payload_size, rx.received, rx.lost,
+          ns / 1e9, rx.received / ns * 1e3, rx.received * payload_size / ns * 1e3,
+          send_ns / 1e9, max_send_ns / 1e3);
+   ret = (rx.received == count) ? 0 : 1;
+
+exit:
+   trap_ctx_finalize(&ctx);
+   free(payload);
+   return ret;
+}
@@ -0,0 +1,408 @@
+/**
+ * \file test_bufsize.c
+ * \brief Test of negotiated and adaptive size of buffers
+ */
+/*
+ * Copyright (C) 2026 CESNET
+ *
+ * LICENSE TERMS
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name of the Company nor the names of its contributors
+ *    may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ *
+ * ALTERNATIVELY, provided that this notice is retained in full, this
+ * product may be distributed under the terms of the GNU General Public
+ * License (GPL) version 2 or later, in which case the provisions
+ * of the GPL apply INSTEAD OF those given above.
+ *
+ * This software is provided ``as is'', and any express or implied
+ * warranties, including, but not limited to, the implied warranties of
+ * merchantability and fitness for a particular purpose are disclaimed.
+ * In no event shall the company or contributors be liable for any
+ * direct, indirect, incidental, special, exemplary, or consequential
+ * damages (including, but not limited to, procurement of substitute
+ * goods or services; loss of use, data, or profits; or business
+ * interruption) however caused and on any theory of liability, whether
+ * in contract, strict liability, or tort (including negligence or
+ * otherwise) arising in any way out of the use of this software, even
+ * if advised of the possibility of such damage.
+ *
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <stdint.h>
+#include <inttypes.h>
+#include <pthread.h>
+#include <time.h>
+#include <libtrap/trap.h>
+#include "trap_internal.h"
+#include "trap_counters.h"
+
+#define MESSAGES 200000     ///< Number of messages of transfer tests and of the burst of adaptive test
+#define MAX_SIZE 500        ///< Maximal size of messages of transfer tests (minimum is 8)
+#define LOW_RATE_SEC 2      ///< Duration of low rate phase of adaptive test (seconds)
+#define WAIT_SEC 20         ///< Time limit of connecting and receiving (seconds)
+
+trap_module_info_t src_module_info = {
+   "Bufsize test source", // Module name
+   // Module description
+   "\n",
+   0, // Number of input interfaces
+   1, // Number of output interfaces
+};
+
+trap_module_info_t dst_module_info = {
+   "Bufsize test destination", // Module name
+   // Module description
+   "\n",
+   1, // Number of input interfaces
+   0, // Number of output interfaces
+};
+
+struct module_arg {
+   trap_ctx_t *ctx;
+   uint16_t size;     ///< size of all messages, 0 for message_size()
+   uint32_t received;
+   int errors;
+};
+
+static trap_ctx_t *init_ctx(trap_module_info_t *info, char *ifc)
+{
+   char *argv[] = {"test", "-i", ifc};
+   int argc = 3;
+   trap_ifc_spec_t ifc_spec;
+   trap_ctx_t *ctx;
+
+   if (trap_parse_params(&argc, argv, &ifc_spec) != TRAP_E_OK) {
+      fprintf(stderr, "Error in parsing of parameters for TRAP: %s\n", trap_last_error_msg);
+      return NULL;
+   }
+   ctx = trap_ctx_init(info, ifc_spec);
+   trap_free_ifc_spec(ifc_spec);
+   if ((ctx != NULL) && (trap_ctx_get_last_error(ctx) != TRAP_E_OK)) {
+      fprintf(stderr, "Error in TRAP initialization: %s\n", trap_ctx_get_last_error_msg(ctx));
+      trap_ctx_finalize(&ctx);
+      return NULL;
+   }
+   return ctx;
+}
+
+static double now_s(void)
+{
+   struct timespec ts;
+
+   clock_gettime(CLOCK_MONOTONIC, &ts);
+   return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static uint16_t message_size(uint32_t seq)
+{
+   return 8 + seq % (MAX_SIZE - 7);
+}
+
+/**
+ * Destination module: check sequence numbers and sizes of messages.
+ */
+static void *destination(void *arg)
+{
+   struct module_arg *m = (struct module_arg *) arg;
+   const void *data;
+   uint16_t size;
+   uint32_t seq;
+   double start = now_s();
+   int ret;
+
+   while ((m->received < MESSAGES) && (now_s() - start < WAIT_SEC)) {
+      ret = trap_ctx_recv(m->ctx, 0, &data, &size);
+      if (ret == TRAP_E_TIMEOUT) {
+         continue;
+      }
+      TRAP_DEFAULT_RECV_ERROR_HANDLING(ret, continue, break);
+      if (size < sizeof(seq)) {
+         /* end of file */
+         break;
+      }
+      memcpy(&seq, data, sizeof(seq));
+      if ((seq != m->received) || (size != ((m->size != 0) ? m->size : message_size(seq)))) {
+         if (m->errors++ == 0) {
+            fprintf(stderr, "Message %"PRIu32" is corrupted (size %"PRIu16", sequence %"PRIu32").\n", m->received, size, seq);
+         }
+      }
+      m->received++;
+   }
+   return NULL;
+}
+
+static int send_message(trap_ctx_t *ctx, uint32_t seq, uint16_t size)
+{
+   char msg[MAX_SIZE];
+
+   memset(msg, (int) seq, size);
+   memcpy(msg, &seq, sizeof(seq));
+   if (trap_ctx_send(ctx, 0, msg, size) != TRAP_E_OK) {
+      fprintf(stderr, "Sending of message %"PRIu32" failed.\n", seq);
+      return 1;
+   }
+   return 0;
+}
+
+static uint32_t flush_limit(trap_ctx_t *ctx)
+{
+   trap_output_ifc_t *o = &((trap_ctx_priv_t *) ctx)->out_ifc_list[0];
+   uint32_t limit;
+
+   pthread_mutex_lock(&o->ifc_mtx);
+   limit = o->flush_limit;
+   pthread_mutex_unlock(&o->ifc_mtx);
+   return limit;
+}
+
+/**
+ * Check that input IFC enlarged its buffer and received buffers bigger than the default size.
+ *
+ * \return number of errors
+ */
+static int check_received(trap_ctx_t *ctx, uint32_t buffer_size)
+{
+   trap_counters_block_t *sum = trap_counters_sum(&((trap_ctx_priv_t *) ctx)->counters);
+   uint32_t size = ((trap_ctx_priv_t *) ctx)->in_ifc_list[0].buffer_size;
+   int errors = 0;
+
+   if (sum == NULL) {
+      fprintf(stderr, "Sum of counters failed.\n");
+      return 1;
+   }
+   printf("  input buffer %"PRIu32" B, %"PRIu64" buffers, %"PRIu64" B per buffer\n", size,
+          sum->in[0].buffers, (sum->in[0].buffers != 0) ? sum->in[0].bytes / sum->in[0].buffers : 0);
+   if (size != buffer_size) {
+      fprintf(stderr, "Size of input buffer is %"PRIu32" B, expected %"PRIu32" B.\n", size, buffer_size);
+      errors++;
+   }
+   if ((sum->in[0].buffers == 0) || (sum->in[0].bytes / sum->in[0].buffers <= TRAP_IFC_MESSAGEQ_SIZE)) {
+      fprintf(stderr, "Received buffers are not bigger than the default size.\n");
+      errors++;
+   }
+   free(sum);
+   return errors;
+}
+
+/**
+ * Send messages from output IFC with "bufsize" to input IFC with the default size.
+ *
+ * \param[in] ifc_src  IFC_SPEC of output IFC
+ * \param[in] ifc_dst  IFC_SPEC of input IFC
+ * \param[in] buffer_size  size of buffers set by ifc_src
+ * \param[in] sync     wait for client before sending (sockets), otherwise the whole file is written first
+ * \return number of errors
+ */
+static int transfer(char *ifc_src, char *ifc_dst, uint32_t buffer_size, int sync)
+{
+   trap_ctx_t *src;
+   struct module_arg dst;
+   pthread_t dst_thread;
+   int dst_started = 0, errors = 1;
+   uint32_t i;
+   double start;
+
+   printf("%s -> %s\n", ifc_src, ifc_dst);
+   memset(&dst, 0, sizeof(dst));
+   src = init_ctx(&src_module_info, ifc_src);
+   if (src == NULL) {
+      return 1;
+   }
+   trap_ctx_set_data_fmt(src, 0, TRAP_FMT_RAW);
+   trap_ctx_ifcctl(src, TRAPIFC_OUTPUT, 0, TRAPCTL_SETTIMEOUT, TRAP_WAIT);
+
+   if (sync == 0) {
+      for (i = 0; i < MESSAGES; i++) {
+         if (send_message(src, i, message_size(i)) != 0) {
+            goto finalize;
+         }
+      }
+      trap_ctx_finalize(&src);
+   }
+
+   dst.ctx = init_ctx(&dst_module_info, ifc_dst);
+   if (dst.ctx == NULL) {
+      goto finalize;
+   }
+   trap_ctx_set_required_fmt(dst.ctx, 0, TRAP_FMT_RAW);
+   trap_ctx_ifcctl(dst.ctx, TRAPIFC_INPUT, 0, TRAPCTL_SETTIMEOUT, 100000);
+   if (pthread_create(&dst_thread, NULL, destination, &dst) != 0) {
+      fprintf(stderr, "Creation of destination thread failed.\n");
+      goto finalize;
+   }
+   dst_started = 1;
+
+   if (sync != 0) {
+      start = now_s();
+      while (trap_ctx_get_client_count(src, 0) < 1) {
+         if (now_s() - start > WAIT_SEC) {
+            fprintf(stderr, "Modules did not connect.\n");
+            goto finalize;
+         }
+         usleep(10000);
+      }
+      for (i = 0; i < MESSAGES; i++) {
+         if (send_message(src, i, message_size(i)) != 0) {
+            goto finalize;
+         }
+      }
+      trap_ctx_send_flush(src, 0);
+   }
+   pthread_join(dst_thread, NULL);
+   dst_started = 0;
+
+   errors = dst.errors;
+   if (dst.received != MESSAGES) {
+      fprintf(stderr, "Destination received %"PRIu32" messages, expected %d.\n", dst.received, MESSAGES);
+      errors++;
+   }
+   errors += check_received(dst.ctx, buffer_size);
+
+finalize:
+   if (dst_started != 0) {
+      trap_ctx_terminate(dst.ctx);
+      pthread_join(dst_thread, NULL);
+   }
+   if (dst.ctx != NULL) {
+      trap_ctx_finalize(&dst.ctx);
+   }
+   if (src != NULL) {
+      trap_ctx_finalize(&src);
+   }
+   return errors;
+}
+
+/**
+ * Check that flush limit of "bufsize=auto" follows rate of messages.
+ *
+ * \param[in] ifc_src  IFC_SPEC of output IFC with "bufsize=auto-N" and autoflush
+ * \param[in] ifc_dst  IFC_SPEC of input IFC
+ * \return number of errors
+ */
+static int adaptive(char *ifc_src, char *ifc_dst)
+{
+   trap_ctx_t *src;
+   trap_output_ifc_t *o;
+   struct module_arg dst;
+   pthread_t dst_thread;
+   int dst_started = 0, errors = 1;
+   uint32_t i, low, high, capacity;
+   double start;
+
+   printf("%s -> %s\n", ifc_src, ifc_dst);
+   memset(&dst, 0, sizeof(dst));
+   dst.size = 100;
+   src = init_ctx(&src_module_info, ifc_src);
+   dst.ctx = init_ctx(&dst_module_info, ifc_dst);
+   if ((src == NULL) || (dst.ctx == NULL)) {
+      goto finalize;
+   }
+   o = &((trap_ctx_priv_t *) src)->out_ifc_list[0];
+   capacity = o->buffer_size - sizeof(trap_buffer_header_t);
+   trap_ctx_set_data_fmt(src, 0, TRAP_FMT_RAW);
+   trap_ctx_ifcctl(src, TRAPIFC_OUTPUT, 0, TRAPCTL_SETTIMEOUT, TRAP_WAIT);
+   trap_ctx_set_required_fmt(dst.ctx, 0, TRAP_FMT_RAW);
+   trap_ctx_ifcctl(dst.ctx, TRAPIFC_INPUT, 0, TRAPCTL_SETTIMEOUT, 100000);
+   if (pthread_create(&dst_thread, NULL, destination, &dst) != 0) {
+      fprintf(stderr, "Creation of destination thread failed.\n");
+      goto finalize;
+   }
+   dst_started = 1;
+   start = now_s();
+   while (trap_ctx_get_client_count(src, 0) < 1) {
+      if (now_s() - start > WAIT_SEC) {
+         fprintf(stderr, "Modules did not connect.\n");
+         goto finalize;
+      }
+      usleep(10000);
+   }
+
+   /* about 100 kB/s, the limit should go down to a few kB per 1/4 of autoflush timeout */
+   start = now_s();
+   for (i = 0; now_s() - start < LOW_RATE_SEC; i++) {
+      if (send_message(src, i, dst.size) != 0) {
+         goto finalize;
+      }
+      usleep(1000);
+   }
+   low = flush_limit(src);
+   /* as fast as possible, the limit should go up to the capacity */
+   for (; i < MESSAGES; i++) {
+      if (send_message(src, i, dst.size) != 0) {
+         goto finalize;
+      }
+   }
+   high = flush_limit(src);
+   trap_ctx_send_flush(src, 0);
+   pthread_join(dst_thread, NULL);
+   dst_started = 0;
+
+   printf("  capacity %"PRIu32" B, flush limit %"PRIu32" B with low rate, %"PRIu32" B with high rate\n",
+          capacity, low, high);
+   errors = dst.errors;
+   if (dst.received != MESSAGES) {
+      fprintf(stderr, "Destination received %"PRIu32" messages, expected %d.\n", dst.received, MESSAGES);
+      errors++;
+   }
+   if (low > capacity / 8) {
+      fprintf(stderr, "Flush limit did not shrink with low rate of messages.\n");
+      errors++;
+   }
+   if (high < capacity / 2) {
+      fprintf(stderr, "Flush limit did not grow with high rate of messages.\n");
+      errors++;
+   }
+
+finalize:
+   if (dst_started != 0) {
+      trap_ctx_terminate(dst.ctx);
+      pthread_join(dst_thread, NULL);
+   }
+   if (dst.ctx != NULL) {
+      trap_ctx_finalize(&dst.ctx);
+   }
+   if (src != NULL) {
+      trap_ctx_finalize(&src);
+   }
+   return errors;
+}
+
+int main(int argc, char **argv)
+{
+   char ifc_src[128], ifc_dst[128], path[64];
+   int errors = 0;
+
+   snprintf(ifc_src, sizeof(ifc_src), "u:test_bufsize_%d:bufsize=1M", (int) getpid());
+   snprintf(ifc_dst, sizeof(ifc_dst), "u:test_bufsize_%d", (int) getpid());
+   errors += transfer(ifc_src, ifc_dst, 1024 * 1024, 1);
+
+   snprintf(path, sizeof(path), "/tmp/test_bufsize_%d.dat", (int) getpid());
+   snprintf(ifc_src, sizeof(ifc_src), "f:%s:w:bufsize=512k", path);
+   snprintf(ifc_dst, sizeof(ifc_dst), "f:%s", path);
+   errors += transfer(ifc_src, ifc_dst, 512 * 1024, 0);
+   unlink(path);
+
+   snprintf(ifc_src, sizeof(ifc_src), "u:test_bufsize_%d:bufsize=auto-256k:autoflush=100000", (int) getpid());
+   snprintf(ifc_dst, sizeof(ifc_dst), "u:test_bufsize_%d", (int) getpid());
+   errors += adaptive(ifc_src, ifc_dst);
+
+   if (errors != 0) {
+      fprintf(stderr, "%d errors.\n", errors);
+      return EXIT_FAILURE;
+   }
+   return EXIT_SUCCESS;
+}
@@ -0,0 +1,320 @@
+/**
+ * \file test_counters.c
+ * \brief Test of per-thread counters of IFCs
+ */
+/*
+ * Copyright (C) 2026 CESNET
+ *
+ * LICENSE TERMS
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name of the Company nor the names of its contributors
+ *    may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ *
+ * ALTERNATIVELY, provided that this notice is retained in full, this
+ * product may be distributed under the terms of the GNU General Public
+ * License (GPL) version 2 or later, in which case the provisions
+ * of the GPL apply INSTEAD OF those given above.
+ *
+ * This software is provided ``as is'', and any express or implied
+ * warranties, including, but not limited to, the implied warranties of
+ * merchantability and fitness for a particular purpose are disclaimed.
+ * In no event shall the company or contributors be liable for any
+ * direct, indirect, incidental, special, exemplary, or consequential
+ * damages (including, but not limited to, procurement of substitute
+ * goods or services; loss of use, data, or profits; or business
+ * interruption) however caused and on any theory of liability, whether
+ * in contract, strict liability, or tort (including negligence or
+ * otherwise) arising in any way out of the use of this software, even
+ * if advised of the possibility of such damage.
+ *
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <stdint.h>
+#include <inttypes.h>
+#include <pthread.h>
+#include <time.h>
+#include <libtrap/trap.h>
+#include "trap_internal.h"
+#include "trap_counters.h"
+
+#define MESSAGES 50000      ///< Number of messages of every sender thread
+#define SENDERS 3           ///< Number of sender threads in one round
+#define ROUNDS 2            ///< Rounds of sender threads (threads of a round exit before the next one)
+#define WAIT_SEC 10         ///< Time limit of connecting and receiving (seconds)
+
+trap_module_info_t out_module_info = {
+   "Counters test sender", // Module name
+   // Module description
+   "\n",
+   0, // Number of input interfaces
+   1, // Number of output interfaces
+};
+
+trap_module_info_t in_module_info = {
+   "Counters test receiver", // Module name
+   // Module description
+   "\n",
+   1, // Number of input interfaces
+   0, // Number of output interfaces
+};
+
+struct receiver_arg {
+   trap_ctx_t *ctx;
+   uint64_t received;
+   volatile int stop;
+};
+
+static trap_ctx_t *init_ctx(trap_module_info_t *info, char *ifc)
+{
+   char *argv[] = {"test", "-i", ifc};
+   int argc = 3;
+   trap_ifc_spec_t ifc_spec;
+   trap_ctx_t *ctx;
+
+   if (trap_parse_params(&argc, argv, &ifc_spec) != TRAP_E_OK) {
+      fprintf(stderr, "Error in parsing of parameters for TRAP: %s\n", trap_last_error_msg);
+      return NULL;
+   }
+   ctx = trap_ctx_init(info, ifc_spec);
+   trap_free_ifc_spec(ifc_spec);
+   if ((ctx != NULL) && (trap_ctx_get_last_error(ctx) != TRAP_E_OK)) {
+      fprintf(stderr, "Error in TRAP initialization: %s\n", trap_ctx_get_last_error_msg(ctx));
+      trap_ctx_finalize(&ctx);
+      return NULL;
+   }
+   return ctx;
+}
+
+static double now_s(void)
+{
+   struct timespec ts;
+
+   clock_gettime(CLOCK_MONOTONIC, &ts);
+   return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void *receiver(void *arg)
+{
+   struct receiver_arg *r = (struct receiver_arg *) arg;
+   const void *data;
+   uint16_t size;
+   int ret;
+
+   while (r->stop == 0) {
+      ret = trap_ctx_recv(r->ctx, 0, &data, &size);
+      if (ret == TRAP_E_TIMEOUT) {
+         continue;
+      }
+      TRAP_DEFAULT_RECV_ERROR_HANDLING(ret, continue, break);
+      __sync_fetch_and_add(&r->received, 1);
+   }
+   return NULL;
+}
+
+static void *sender(void *arg)
+{
+   trap_ctx_t *ctx = (trap_ctx_t *) arg;
+   char buffer[100];
+   uint64_t i;
+
+   memset(buffer, 0, sizeof(buffer));
+   for (i = 0; i < MESSAGES; i++) {
+      if (trap_ctx_send(ctx, 0, buffer, 20 + i % 80) != TRAP_E_OK) {
+         break;
+      }
+   }
+   return NULL;
+}
+
+/**
+ * Check buckets of histogram.
+ *
+ * \return number of errors
+ */
+static int check_buckets(void)
+{
+   static const struct {
+      uint64_t value;
+      uint32_t bucket;
+   } cases[] = {{0, 0}, {1, 0}, {2, 1}, {3, 1}, {4, 2}, {1023, 9}, {1024, 10},
+                {(1ULL << 31) - 1, 30}, {1ULL << 31, 31}, {UINT64_MAX, 31}};
+   int i, errors = 0;
+
+   for (i = 0; i < sizeof(cases) / sizeof(cases[0]); i++) {
+      if (trap_hist_bucket(cases[i].value) != cases[i].bucket) {
+         fprintf(stderr, "Value %"PRIu64" is in bucket %"PRIu32", expected %"PRIu32".\n",
+                 cases[i].value, trap_hist_bucket(cases[i].value), cases[i].bucket);
+         errors++;
+      }
+   }
+   return errors;
+}
+
+/**
+ * Sum histogram buckets.
+ */
+static uint64_t sum_array(const uint64_t *values, int count)
+{
+   uint64_t sum = 0;
+   int i;
+
+   for (i = 0; i < count; i++) {
+      sum += values[i];
+   }
+   return sum;
+}
+
+/**
+ * Send messages from several rounds of threads and compare summed counters
+ * of sender and receiver.
+ *
+ * \return number of errors
+ */
+static int check_counters(void)
+{
+   char ifc_out[64], ifc_in[64];
+   trap_ctx_t *out_ctx;
+   trap_counters_t *counters;
+   trap_counters_block_t *out_sum = NULL, *in_sum = NULL, *b;
+   trap_out_counters_t *o;
+   trap_in_counters_t *in;
+   struct receiver_arg r;
+   pthread_t rx_thread, threads[SENDERS];
+   uint64_t total = (uint64_t) MESSAGES * SENDERS * ROUNDS;
+   json_t *json;
+   json_int_t bytes = 0;
+   int n, round, blocks = 0, rx_started = 0, errors = 1;
+   double start;
+
+   memset(&r, 0, sizeof(r));
+   snprintf(ifc_in, sizeof(ifc_in), "u:test_counters_%d", (int) getpid());
+   snprintf(ifc_out, sizeof(ifc_out), "%s:autoflush=off", ifc_in);
+   out_ctx = init_ctx(&out_module_info, ifc_out);
+   if (out_ctx == NULL) {
+      return 1;
+   }
+   trap_ctx_set_data_fmt(out_ctx, 0, TRAP_FMT_RAW);
+   trap_ctx_ifcctl(out_ctx, TRAPIFC_OUTPUT, 0, TRAPCTL_SETTIMEOUT, TRAP_WAIT);
+
+   r.ctx = init_ctx(&in_module_info, ifc_in);
+   if (r.ctx == NULL) {
+      goto finalize;
+   }
+   trap_ctx_set_required_fmt(r.ctx, 0, TRAP_FMT_RAW);
+   trap_ctx_ifcctl(r.ctx, TRAPIFC_INPUT, 0, TRAPCTL_SETTIMEOUT, 100000);
+   if (pthread_create(&rx_thread, NULL, receiver, &r) != 0) {
+      fprintf(stderr, "Creation of receiver thread failed.\n");
+      goto finalize;
+   }
+   rx_started = 1;
+
+   start = now_s();
+   while (trap_ctx_get_client_count(out_ctx, 0) < 1) {
+      if (now_s() - start > WAIT_SEC) {
+         fprintf(stderr, "Receiver did not connect.\n");
+         goto finalize;
+      }
+      usleep(10000);
+   }
+
+   for (round = 0; round < ROUNDS; round++) {
+      for (n = 0; n < SENDERS; n++) {
+         if (pthread_create(&threads[n], NULL, sender, out_ctx) != 0) {
+            fprintf(stderr, "Creation of sender thread failed.\n");
+            exit(EXIT_FAILURE);
+         }
+      }
+      for (n = 0; n < SENDERS; n++) {
+         pthread_join(threads[n], NULL);
+      }
+   }
+   trap_ctx_send_flush(out_ctx, 0);
+   while ((r.received < total) && (now_s() - start < WAIT_SEC)) {
+      usleep(1000);
+   }
+
+   errors = 0;
+   counters = &((trap_ctx_priv_t *) out_ctx)->counters;
+   for (b = counters->blocks; b != NULL; b = b->next) {
+      blocks++;
+   }
+   /* shared block, block of main thread and blocks reused by rounds of senders */
+   if (blocks > SENDERS + 2) {
+      fprintf(stderr, "Blocks of exited threads were not reused (%d blocks).\n", blocks);
+      errors++;
+   }
+
+   out_sum = trap_counters_sum(counters);
+   in_sum = trap_counters_sum(&((trap_ctx_priv_t *) r.ctx)->counters);
+   if ((out_sum == NULL) || (in_sum == NULL)) {
+      fprintf(stderr, "Sum of counters failed.\n");
+      errors++;
+      goto finalize;
+   }
+   o = &out_sum->out[0];
+   in = &in_sum->in[0];
+   printf("Sent %"PRIu64" messages in %"PRIu64" buffers (%"PRIu64" B), received %"PRIu64" messages in %"PRIu64" buffers (%"PRIu64" B)\n",
+          o->messages, o->buffers, o->bytes, in->messages, in->buffers, in->bytes);
+   if ((o->messages != total) || (in->messages != total) || (r.received != total)) {
+      fprintf(stderr, "Counters of messages do not match (expected %"PRIu64").\n", total);
+      errors++;
+   }
+   if ((o->buffers != in->buffers) || (o->bytes != in->bytes) || (o->buffers == 0)) {
+      fprintf(stderr, "Counters of buffers and bytes of sender and receiver differ.\n");
+      errors++;
+   }
+   if (sum_array(o->fill, TRAP_FILL_BUCKETS) != o->buffers) {
+      fprintf(stderr, "Histogram of fill ratio does not count every buffer.\n");
+      errors++;
+   }
+   if ((o->wait.count < o->buffers) || (sum_array(o->wait.buckets, TRAP_HIST_BUCKETS) != o->wait.count) ||
+       (in->wait.count < in->buffers) || (sum_array(in->wait.buckets, TRAP_HIST_BUCKETS) != in->wait.count)) {
+      fprintf(stderr, "Histograms of blocking time are not consistent.\n");
+      errors++;
+   }
+
+   json = trap_counters_out_json(o);
+   if ((json == NULL) || (json_unpack(json, "{sI}", "bytes", &bytes) != 0) || (bytes != o->bytes)) {
+      fprintf(stderr, "Counters are not encoded for service IFC.\n");
+      errors++;
+   }
+   json_decref(json);
+
+finalize:
+   free(out_sum);
+   free(in_sum);
+   r.stop = 1;
+   if (rx_started != 0) {
+      pthread_join(rx_thread, NULL);
+   }
+   if (r.ctx != NULL) {
+      trap_ctx_finalize(&r.ctx);
+   }
+   trap_ctx_finalize(&out_ctx);
+   return errors;
+}
+
+int main(int argc, char **argv)
+{
+   int errors = check_buckets();
+
+   errors += check_counters();
+   if (errors != 0) {
+      fprintf(stderr, "%d errors.\n", errors);
+      return EXIT_FAILURE;
+   }
+   return EXIT_SUCCESS;
+}
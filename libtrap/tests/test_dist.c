@@ -0,0 +1,327 @@
+/**
+ * \file test_dist.c
+ * \brief Test of distribution modes of TCPIP output IFC (rr, least, hash)
+ */
+/*
+ * Copyright (C) 2026 CESNET
+ *
+ * LICENSE TERMS
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name of the Company nor the names of its contributors
+ *    may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ *
+ * ALTERNATIVELY, provided that this notice is retained in full, this
+ * product may be distributed under the terms of the GNU General Public
+ * License (GPL) version 2 or later, in which case the provisions
+ * of the GPL apply INSTEAD OF those given above.
+ *
+ * This software is provided ``as is'', and any express or implied
+ * warranties, including, but not limited to, the implied warranties of
+ * merchantability and fitness for a particular purpose are disclaimed.
+ * In no event shall the company or contributors be liable for any
+ * direct, indirect, incidental, special, exemplary, or consequential
+ * damages (including, but not limited to, procurement of substitute
+ * goods or services; loss of use, data, or profits; or business
+ * interruption) however caused and on any theory of liability, whether
+ * in contract, strict liability, or tort (including negligence or
+ * otherwise) arising in any way out of the use of this software, even
+ * if advised of the possibility of such damage.
+ *
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <stdint.h>
+#include <inttypes.h>
+#include <pthread.h>
+#include <time.h>
+#include <libtrap/trap.h>
+
+#define MESSAGES 300000     ///< Default number of messages
+#define RECEIVERS 3         ///< Default number of receivers
+#define KEYS 64             ///< Number of distinct values of SRC_IP
+#define MAX_RECEIVERS 16    ///< Maximal number of receivers
+#define WAIT_SEC 10         ///< Time limit of connecting and receiving (seconds)
+
+#define FMT_SPEC "ipaddr SRC_IP,uint64 SEQ"
+
+trap_module_info_t out_module_info = {
+   "Distribution test sender", // Module name
+   // Module description
+   "\n",
+   0, // Number of input interfaces
+   1, // Number of output interfaces
+};
+
+trap_module_info_t in_module_info = {
+   "Distribution test receiver", // Module name
+   // Module description
+   "\n",
+   1, // Number of input interfaces
+   0, // Number of output interfaces
+};
+
+/** Record of the test (layout given by FMT_SPEC) */
+struct record {
+   uint8_t src_ip[16];
+   uint64_t seq;
+} __attribute__ ((__packed__));
+
+struct shared {
+   uint32_t messages;
+   uint8_t *seen;           ///< Number of receptions of every message
+   int owner[KEYS];         ///< Receiver of every key, -1 if not received yet
+   uint32_t key_conflicts;  ///< Messages of a key received by another receiver than the first one
+   uint32_t received;       ///< Total number of received messages
+   volatile int stop;
+};
+
+struct receiver_arg {
+   int id;
+   trap_ctx_t *ctx;
+   struct shared *sh;
+   uint32_t received;
+};
+
+static trap_ctx_t *init_ctx(trap_module_info_t *info, char *ifc)
+{
+   char *argv[] = {"test", "-i", ifc};
+   int argc = 3;
+   trap_ifc_spec_t ifc_spec;
+   trap_ctx_t *ctx;
+
+   if (trap_parse_params(&argc, argv, &ifc_spec) != TRAP_E_OK) {
+      fprintf(stderr, "Error in parsing of parameters for TRAP: %s\n", trap_last_error_msg);
+      return NULL;
+   }
+   ctx = trap_ctx_init(info, ifc_spec);
+   trap_free_ifc_spec(ifc_spec);
+   if ((ctx != NULL) && (trap_ctx_get_last_error(ctx) != TRAP_E_OK)) {
+      fprintf(stderr, "Error in TRAP initialization: %s\n", trap_ctx_get_last_error_msg(ctx));
+      trap_ctx_finalize(&ctx);
+      return NULL;
+   }
+   return ctx;
+}
+
+static void *receiver(void *arg)
+{
+   struct receiver_arg *r = (struct receiver_arg *) arg;
+   struct shared *sh = r->sh;
+   struct record rec;
+   const void *data;
+   uint16_t size;
+   uint32_t key;
+   int ret, owner;
+
+   while (sh->stop == 0) {
+      ret = trap_ctx_recv(r->ctx, 0, &data, &size);
+      if (ret == TRAP_E_TIMEOUT) {
+         continue;
+      }
+      TRAP_DEFAULT_RECV_ERROR_HANDLING(ret, continue, break);
+      if (size != sizeof(rec)) {
+         fprintf(stderr, "Unexpected message size %"PRIu16".\n", size);
+         break;
+      }
+      memcpy(&rec, data, sizeof(rec));
+      if (rec.seq >= sh->messages) {
+         fprintf(stderr, "Unexpected sequence number %"PRIu64".\n", rec.seq);
+         break;
+      }
+      __sync_fetch_and_add(&sh->seen[rec.seq], 1);
+      memcpy(&key, rec.src_ip + 12, sizeof(key));
+      owner = __sync_val_compare_and_swap(&sh->owner[key % KEYS], -1, r->id);
+      if ((owner != -1) && (owner != r->id)) {
+         __sync_fetch_and_add(&sh->key_conflicts, 1);
+      }
+      __sync_fetch_and_add(&sh->received, 1);
+      r->received++;
+   }
+   return NULL;
+}
+
+static double now_s(void)
+{
+   struct timespec ts;
+
+   clock_gettime(CLOCK_MONOTONIC, &ts);
+   return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/**
+ * Send messages through output IFC with given distribution to receivers.
+ *
+ * \param[in] dist       value of dist= parameter
+ * \param[in] messages   number of messages
+ * \param[in] receivers  number of receivers
+ * \return 0 on success
+ */
+static int run(const char *dist, uint32_t messages, int receivers)
+{
+   char ifc_out[128], ifc_in[64];
+   trap_ctx_t *out_ctx;
+   struct receiver_arg r[MAX_RECEIVERS];
+   pthread_t threads[MAX_RECEIVERS];
+   struct shared sh;
+   struct record rec;
+   uint32_t i, missing = 0, duplicates = 0, min_share = messages;
+   int n, started = 0, result = 1;
+   double start, elapsed;
+
+   memset(&sh, 0, sizeof(sh));
+   memset(r, 0, sizeof(r));
+   sh.messages = messages;
+   sh.seen = calloc(messages, 1);
+   if (sh.seen == NULL) {
+      fprintf(stderr, "Not enough memory.\n");
+      return 1;
+   }
+   for (i = 0; i < KEYS; i++) {
+      sh.owner[i] = -1;
+   }
+
+   snprintf(ifc_in, sizeof(ifc_in), "u:test_dist_%d_%s", (int) getpid(), dist);
+   snprintf(ifc_out, sizeof(ifc_out), "%s:dist=%s%s", ifc_in, dist, (strcmp(dist, "hash") == 0 ? ":key=SRC_IP" : ""));
+   out_ctx = init_ctx(&out_module_info, ifc_out);
+   if (out_ctx == NULL) {
+      free(sh.seen);
+      return 1;
+   }
+   trap_ctx_set_data_fmt(out_ctx, 0, TRAP_FMT_UNIREC, FMT_SPEC);
+   trap_ctx_ifcctl(out_ctx, TRAPIFC_OUTPUT, 0, TRAPCTL_SETTIMEOUT, TRAP_WAIT);
+
+   for (n = 0; n < receivers; n++) {
+      r[n].id = n;
+      r[n].sh = &sh;
+      r[n].ctx = init_ctx(&in_module_info, ifc_in);
+      if (r[n].ctx == NULL) {
+         goto finalize;
+      }
+      trap_ctx_set_required_fmt(r[n].ctx, 0, TRAP_FMT_UNIREC, FMT_SPEC);
+      trap_ctx_ifcctl(r[n].ctx, TRAPIFC_INPUT, 0, TRAPCTL_SETTIMEOUT, 100000);
+      if (pthread_create(&threads[n], NULL, receiver, &r[n]) != 0) {
+         fprintf(stderr, "Creation of receiver thread failed.\n");
+         trap_ctx_finalize(&r[n].ctx);
+         goto finalize;
+      }
+      started++;
+   }
+
+   /* all receivers must be connected, otherwise the first buffers go to some of them only */
+   start = now_s();
+   while (trap_ctx_get_client_count(out_ctx, 0) < receivers) {
+      if (now_s() - start > WAIT_SEC) {
+         fprintf(stderr, "Receivers did not connect.\n");
+         goto finalize;
+      }
+      usleep(10000);
+   }
+
+   start = now_s();
+   memset(&rec, 0, sizeof(rec));
+   for (i = 0; i < messages; i++) {
+      uint32_t key = i % KEYS;
+      memcpy(rec.src_ip + 12, &key, sizeof(key));
+      rec.seq = i;
+      if (trap_ctx_send(out_ctx, 0, &rec, sizeof(rec)) != TRAP_E_OK) {
+         fprintf(stderr, "Sending failed: %s\n", trap_ctx_get_last_error_msg(out_ctx));
+         goto finalize;
+      }
+   }
+   trap_ctx_send_flush(out_ctx, 0);
+   while ((sh.received < messages) && (now_s() - start < WAIT_SEC)) {
+      usleep(1000);
+   }
+   elapsed = now_s() - start;
+
+   for (i = 0; i < messages; i++) {
+      if (sh.seen[i] == 0) {
+         missing++;
+      } else if (sh.seen[i] > 1) {
+         duplicates++;
+      }
+   }
+   printf("dist=%s: %"PRIu32" messages in %.3f s, shares:", dist, messages, elapsed);
+   for (n = 0; n < receivers; n++) {
+      printf(" %"PRIu32, r[n].received);
+      if (r[n].received < min_share) {
+         min_share = r[n].received;
+      }
+   }
+   printf(", missing %"PRIu32", duplicates %"PRIu32", key conflicts %"PRIu32"\n",
+          missing, duplicates, sh.key_conflicts);
+
+   if ((missing != 0) || (duplicates != 0)) {
+      fprintf(stderr, "Every message must be received exactly once.\n");
+   } else if ((strcmp(dist, "hash") == 0) && (sh.key_conflicts != 0)) {
+      fprintf(stderr, "Messages with the same key were received by different receivers.\n");
+   } else if (min_share == 0) {
+      fprintf(stderr, "Some receiver got no messages.\n");
+   } else if ((strcmp(dist, "rr") == 0) && (min_share < messages / receivers / 2)) {
+      fprintf(stderr, "Round-robin distribution is not balanced.\n");
+   } else {
+      result = 0;
+   }
+
+finalize:
+   sh.stop = 1;
+   for (n = 0; n < started; n++) {
+      pthread_join(threads[n], NULL);
+      trap_ctx_finalize(&r[n].ctx);
+   }
+   trap_ctx_finalize(&out_ctx);
+   free(sh.seen);
+   return result;
+}
+
+int main(int argc, char **argv)
+{
+   int opt, receivers = RECEIVERS, result = EXIT_SUCCESS;
+   uint32_t messages = MESSAGES;
+   const char *modes[] = {"rr", "least", "hash", NULL};
+   const char *only = NULL;
+   int i;
+
+   while ((opt = getopt(argc, argv, "d:n:r:")) != -1) {
+      switch (opt) {
+      case 'd':
+         only = optarg;
+         break;
+      case 'n':
+         messages = strtoul(optarg, NULL, 10);
+         break;
+      case 'r':
+         receivers = atoi(optarg);
+         break;
+      default:
+         fprintf(stderr, "Usage: %s [-d rr|least|hash] [-n messages] [-r receivers]\n", argv[0]);
+         return EXIT_FAILURE;
+      }
+   }
+   if ((messages == 0) || (receivers < 1) || (receivers > MAX_RECEIVERS)) {
+      fprintf(stderr, "Number of messages must be positive, number of receivers 1-%d.\n", MAX_RECEIVERS);
+      return EXIT_FAILURE;
+   }
+
+   for (i = 0; modes[i] != NULL; i++) {
+      if ((only != NULL) && (strcmp(only, modes[i]) != 0)) {
+         continue;
+      }
+      if (run(modes[i], messages, receivers) != 0) {
+         result = EXIT_FAILURE;
+      }
+   }
+   return result;
+}
@@ -59,7 +59,8 @@ trap_module_info_t module_info = {
    "TCPIP Example client module", // Module name
    // Module description
    "Parameters: \n"
-   " -n X   X = size of data to send for testing \n",
+   " -n X   X = size of data to send for testing \n"
+   " -d X   X = delay in microseconds after every sent message (default 0) \n",
    0, // Number of input interfaces
    1, // Number of output interfaces
 };
@@ -83,8 +84,9 @@ int main(int argc, char **argv)
    uint64_t iteration = 0;
    time_t duration;
    uint16_t payload_size = sizeof(counter);
+   uint32_t delay = 0;
 
-   const char *options = "n:";
+   const char *options = "n:d:";
    char opt;
 
    char *payload = NULL;
@@ -132,6 +134,10 @@ int main(int argc, char **argv)
          case 'n':
             sscanf(optarg, "%hu", &payload_size);
             payload = (char *) calloc(1, payload_size);
+            break;
+         case 'd':
+            sscanf(optarg, "%u", &delay);
+            break;
          }
       }
    }
@@ -147,6 +153,9 @@ int main(int argc, char **argv)
       ret = trap_ctx_send(ctx, 0, (void *) payload, payload_size);
       if (ret == TRAP_E_OK) {
          counter++;
+         if (delay != 0) {
+            usleep(delay);
+         }
       } else {
          // CANNOT GET LAST ERROR MSG NOW
          fprintf(stderr, "ERROR in getting data. %d\n", ret);
@@ -0,0 +1,316 @@
+/**
+ * \file test_file_index.c
+ * \brief Test of sidecar index of file IFC and seeking by start=/end=
+ */
+/*
+ * Copyright (C) 2026 CESNET
+ *
+ * LICENSE TERMS
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name of the Company nor the names of its contributors
+ *    may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ *
+ * ALTERNATIVELY, provided that this notice is retained in full, this
+ * product may be distributed under the terms of the GNU General Public
+ * License (GPL) version 2 or later, in which case the provisions
+ * of the GPL apply INSTEAD OF those given above.
+ *
+ * This software is provided ``as is'', and any express or implied
+ * warranties, including, but not limited to, the implied warranties of
+ * merchantability and fitness for a particular purpose are disclaimed.
+ * In no event shall the company or contributors be liable for any
+ * direct, indirect, incidental, special, exemplary, or consequential
+ * damages (including, but not limited to, procurement of substitute
+ * goods or services; loss of use, data, or profits; or business
+ * interruption) however caused and on any theory of liability, whether
+ * in contract, strict liability, or tort (including negligence or
+ * otherwise) arising in any way out of the use of this software, even
+ * if advised of the possibility of such damage.
+ *
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <stdint.h>
+#include <inttypes.h>
+#include <time.h>
+#include <sys/stat.h>
+#include <libtrap/trap.h>
+
+#define DATA_FILE "test_file_index.data"
+#define INDEX_FILE DATA_FILE ".idx"
+#define MESSAGES 100000
+/** Fields are listed in the order of UniRec record: SRC_IP at 0, TIME_FIRST at 16, PACKETS at 24 */
+#define SPEC "ipaddr SRC_IP,time TIME_FIRST,uint32 PACKETS"
+#define RECORD_SIZE 28
+#define TIME_OFFSET 16
+/** 2016-10-18 12:00:00 UTC */
+#define BASE_TIME 1476792000
+#define WINDOW_START (BASE_TIME + 300)
+#define WINDOW_END (BASE_TIME + 400)
+
+/* layout of index, see ifc_file.h */
+typedef struct {
+   char magic[8];
+   uint32_t key;
+   uint32_t reserved;
+} index_header_t;
+
+typedef struct {
+   uint64_t offset;
+   uint64_t first;
+   uint64_t last;
+   uint32_t messages;
+   uint32_t reserved;
+} index_entry_t;
+
+trap_module_info_t out_module_info = {
+   "File index test sender", // Module name
+   // Module description
+   "\n",
+   0, // Number of input interfaces
+   1, // Number of output interfaces
+};
+
+trap_module_info_t in_module_info = {
+   "File index test receiver", // Module name
+   // Module description
+   "\n",
+   1, // Number of input interfaces
+   0, // Number of output interfaces
+};
+
+/**
+ * TIME_FIRST of message (UniRec time), messages are slightly out of order
+ * like flow records are.
+ */
+static inline uint64_t message_time(uint64_t seq)
+{
+   uint64_t ms = seq * 10 + (seq * 7919) % 500;
+
+   return ((uint64_t) (BASE_TIME + ms / 1000) << 32) | (((ms % 1000) << 32) / 1000);
+}
+
+static inline int in_window(uint64_t t)
+{
+   return (t >= ((uint64_t) WINDOW_START << 32)) && (t <= ((uint64_t) WINDOW_END << 32));
+}
+
+static trap_ctx_t *init_ctx(trap_module_info_t *info, char *ifc)
+{
+   char *argv[] = {"test", "-i", ifc};
+   int argc = 3;
+   trap_ifc_spec_t ifc_spec;
+   trap_ctx_t *ctx;
+
+   if (trap_parse_params(&argc, argv, &ifc_spec) != TRAP_E_OK) {
+      fprintf(stderr, "Error in parsing of parameters for TRAP: %s\n", trap_last_error_msg);
+      return NULL;
+   }
+   ctx = trap_ctx_init(info, ifc_spec);
+   trap_free_ifc_spec(ifc_spec);
+   if ((ctx != NULL) && (trap_ctx_get_last_error(ctx) != TRAP_E_OK)) {
+      fprintf(stderr, "Error in TRAP initialization: %s\n", trap_ctx_get_last_error_msg(ctx));
+      trap_ctx_finalize(&ctx);
+      return NULL;
+   }
+   return ctx;
+}
+
+static int write_data(void)
+{
+   uint8_t record[RECORD_SIZE] = { 0 };
+   uint64_t seq, t;
+   uint32_t packets;
+   trap_ctx_t *ctx;
+
+   ctx = init_ctx(&out_module_info, "f:" DATA_FILE ":w:index");
+   if (ctx == NULL) {
+      return 1;
+   }
+   trap_ctx_set_data_fmt(ctx, 0, TRAP_FMT_UNIREC, SPEC);
+   for (seq = 0; seq < MESSAGES; seq++) {
+      t = message_time(seq);
+      packets = seq;
+      memcpy(record + TIME_OFFSET, &t, sizeof(t));
+      memcpy(record + TIME_OFFSET + sizeof(t), &packets, sizeof(packets));
+      if (trap_ctx_send(ctx, 0, record, RECORD_SIZE) != TRAP_E_OK) {
+         fprintf(stderr, "Sending failed.\n");
+         trap_ctx_finalize(&ctx);
+         return 1;
+      }
+   }
+   trap_ctx_finalize(&ctx);
+   return 0;
+}
+
+/**
+ * Check that the index covers all messages and the times match the data.
+ */
+static int check_index(uint32_t *max_messages)
+{
+   index_header_t hdr;
+   index_entry_t e;
+   uint64_t messages = 0, prev_offset = 0;
+   uint32_t buffers = 0;
+   FILE *f;
+
+   f = fopen(INDEX_FILE, "rb");
+   if (f == NULL) {
+      fprintf(stderr, "Index %s was not created.\n", INDEX_FILE);
+      return 1;
+   }
+   if ((fread(&hdr, sizeof(hdr), 1, f) != 1) || (memcmp(hdr.magic, "TRAPIDX1", 8) != 0) || (hdr.key != 1)) {
+      fprintf(stderr, "Bad header of index (the key must be TIME_FIRST).\n");
+      fclose(f);
+      return 1;
+   }
+   *max_messages = 0;
+   while (fread(&e, sizeof(e), 1, f) == 1) {
+      if ((buffers > 0) && (e.offset <= prev_offset)) {
+         fprintf(stderr, "Offsets in index are not increasing.\n");
+         fclose(f);
+         return 1;
+      }
+      /* messages of the buffer are messages + [0, messages) */
+      if ((e.first > e.last) || (e.first < message_time(messages) - (1ULL << 31)) ||
+          (e.last > message_time(messages + e.messages - 1) + (1ULL << 31))) {
+         fprintf(stderr, "Bad times of buffer %"PRIu32" in index.\n", buffers);
+         fclose(f);
+         return 1;
+      }
+      if (e.messages > *max_messages) {
+         *max_messages = e.messages;
+      }
+      messages += e.messages;
+      prev_offset = e.offset;
+      buffers++;
+   }
+   fclose(f);
+   if (messages != MESSAGES) {
+      fprintf(stderr, "Index covers %"PRIu64" messages instead of %d.\n", messages, MESSAGES);
+      return 1;
+   }
+   printf("Index: %"PRIu32" buffers, at most %"PRIu32" messages per buffer.\n", buffers, *max_messages);
+   return 0;
+}
+
+/**
+ * Replay the file with time window, check that all messages of the window
+ * are received in order and that buffers outside the window were skipped.
+ */
+static int read_window(const char *params, uint64_t expected, uint32_t max_messages, uint64_t *received)
+{
+   char ifc[256];
+   const void *data;
+   uint16_t size;
+   uint64_t seq, prev = 0, matching = 0, t;
+   uint32_t packets;
+   trap_ctx_t *ctx;
+   int ret, result = 1;
+
+   snprintf(ifc, sizeof(ifc), "f:" DATA_FILE ":%s", params);
+   ctx = init_ctx(&in_module_info, ifc);
+   if (ctx == NULL) {
+      return 1;
+   }
+   trap_ctx_set_required_fmt(ctx, 0, TRAP_FMT_UNIREC, SPEC);
+
+   *received = 0;
+   while (1) {
+      ret = trap_ctx_recv(ctx, 0, &data, &size);
+      if ((ret != TRAP_E_OK) && (ret != TRAP_E_FORMAT_CHANGED)) {
+         fprintf(stderr, "trap_ctx_recv() failed: %s\n", trap_ctx_get_last_error_msg(ctx));
+         goto finalize;
+      }
+      if (size <= 1) {
+         break;
+      }
+      if (size != RECORD_SIZE) {
+         fprintf(stderr, "Unexpected size of message: %"PRIu16"\n", size);
+         goto finalize;
+      }
+      memcpy(&t, (const uint8_t *) data + TIME_OFFSET, sizeof(t));
+      memcpy(&packets, (const uint8_t *) data + TIME_OFFSET + sizeof(t), sizeof(packets));
+      seq = packets;
+      if (t != message_time(seq)) {
+         fprintf(stderr, "Corrupted message %"PRIu64".\n", seq);
+         goto finalize;
+      }
+      if ((*received > 0) && (seq <= prev)) {
+         fprintf(stderr, "Messages are not in order (%"PRIu64" after %"PRIu64").\n", seq, prev);
+         goto finalize;
+      }
+      prev = seq;
+      matching += in_window(t);
+      (*received)++;
+   }
+   if (matching != expected) {
+      fprintf(stderr, "%s: received %"PRIu64" messages of the window instead of %"PRIu64".\n", params, matching, expected);
+      goto finalize;
+   }
+   /* only buffers overlapping the window may be returned */
+   if (*received > expected + 2 * max_messages) {
+      fprintf(stderr, "%s: received %"PRIu64" messages, buffers outside the window were not skipped.\n", params, *received);
+      goto finalize;
+   }
+   printf("%s: %"PRIu64" messages received, %"PRIu64" in the window.\n", params, *received, matching);
+   result = 0;
+
+finalize:
+   trap_ctx_finalize(&ctx);
+   return result;
+}
+
+int main(int argc, char **argv)
+{
+   char params[128], end_str[32];
+   time_t end_time = WINDOW_END;
+   uint64_t seq, expected = 0, received, indexed;
+   uint32_t max_messages;
+   int result = EXIT_FAILURE;
+
+   for (seq = 0; seq < MESSAGES; seq++) {
+      expected += in_window(message_time(seq));
+   }
+
+   if ((write_data() != 0) || (check_index(&max_messages) != 0)) {
+      goto exit;
+   }
+
+   /* seek by index, both formats of time */
+   strftime(end_str, sizeof(end_str), "%Y%m%dT%H%M%SZ", gmtime(&end_time));
+   snprintf(params, sizeof(params), "start=%d:end=%s", WINDOW_START, end_str);
+   if (read_window(params, expected, max_messages, &indexed) != 0) {
+      goto exit;
+   }
+   snprintf(params, sizeof(params), "start=%d:end=%d:io=mmap", WINDOW_START, WINDOW_END);
+   if ((read_window(params, expected, max_messages, &received) != 0) || (received != indexed)) {
+      goto exit;
+   }
+
+   /* without index, buffers are checked while they are read, the result must be the same */
+   unlink(INDEX_FILE);
+   snprintf(params, sizeof(params), "start=%d:end=%d", WINDOW_START, WINDOW_END);
+   if ((read_window(params, expected, max_messages, &received) != 0) || (received != indexed)) {
+      fprintf(stderr, "Replay without index differs from replay with index.\n");
+      goto exit;
+   }
+   result = EXIT_SUCCESS;
+
+exit:
+   unlink(DATA_FILE);
+   unlink(INDEX_FILE);
+   return result;
+}
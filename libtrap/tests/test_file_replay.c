@@ -0,0 +1,341 @@
+/**
+ * \file test_file_replay.c
+ * \brief Benchmark: throughput (MB/s) of file IFC I/O engines on a large generated file
+ */
+/*
+ * Copyright (C) 2026 CESNET
+ *
+ * LICENSE TERMS
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name of the Company nor the names of its contributors
+ *    may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ *
+ * ALTERNATIVELY, provided that this notice is retained in full, this
+ * product may be distributed under the terms of the GNU General Public
+ * License (GPL) version 2 or later, in which case the provisions
+ * of the GPL apply INSTEAD OF those given above.
+ *
+ * This software is provided ``as is'', and any express or implied
+ * warranties, including, but not limited to, the implied warranties of
+ * merchantability and fitness for a particular purpose are disclaimed.
+ * In no event shall the company or contributors be liable for any
+ * direct, indirect, incidental, special, exemplary, or consequential
+ * damages (including, but not limited to, procurement of substitute
+ * goods or services; loss of use, data, or profits; or business
+ * interruption) however caused and on any theory of liability, whether
+ * in contract, strict liability, or tort (including negligence or
+ * otherwise) arising in any way out of the use of this software, even
+ * if advised of the possibility of such damage.
+ *
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <getopt.h>
+#include <unistd.h>
+#include <stdint.h>
+#include <inttypes.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <dirent.h>
+#include <sys/stat.h>
+#include <libtrap/trap.h>
+
+#define ERRARG -1
+
+trap_module_info_t writer_info = {
+   "File replay benchmark (writer)", // Module name
+   "Generate a file using file output IFC.\n",
+   0, // Number of input interfaces
+   1, // Number of output interfaces
+};
+
+trap_module_info_t reader_info = {
+   "File replay benchmark (reader)", // Module name
+   "Replay the generated file using file input IFC.\n",
+   1, // Number of input interfaces
+   0, // Number of output interfaces
+};
+
+void help(const char *progname)
+{
+   printf("%s [-h] [-f file] [-s MB] [-n size] [-c] [-r rotation]\n"
+          "Writes the file by every output I/O engine of file IFC (io=stdio, io=batch)\n"
+          "and replays it by every input I/O engine (io=stdio, io=mmap).\n"
+          "\t-f\tpath of generated file (default /tmp/trap-file-replay.dat)\n"
+          "\t-s\tsize of generated data in MB (default 512)\n"
+          "\t-n\tsize of message in bytes (default 100)\n"
+          "\t-c\tdrop the file from page cache before replay (cold cache)\n"
+          "\t-r\trotation of output, e.g. size=64M or time=1, file is a directory of slices then\n",
+          progname);
+}
+
+static double elapsed_s(const struct timespec *start, const struct timespec *end)
+{
+   return (end->tv_sec - start->tv_sec) + (end->tv_nsec - start->tv_nsec) / 1e9;
+}
+
+/**
+ * Create context with one file IFC given by params.
+ */
+static trap_ctx_t *init_file_ifc(trap_module_info_t *info, const char *params)
+{
+   trap_ifc_spec_t ifc_spec;
+   trap_ctx_t *ctx;
+
+   ifc_spec.types = strdup("f");
+   ifc_spec.params = (char **) calloc(1, sizeof(char *));
+   if ((ifc_spec.types == NULL) || (ifc_spec.params == NULL)) {
+      return NULL;
+   }
+   ifc_spec.params[0] = strdup(params);
+
+   ctx = trap_ctx_init(info, ifc_spec);
+   trap_free_ifc_spec(ifc_spec);
+   if ((ctx != NULL) && (trap_ctx_get_last_error(ctx) != TRAP_E_OK)) {
+      fprintf(stderr, "trap_ctx_init(%s) failed: %s\n", params, trap_ctx_get_last_error_msg(ctx));
+      trap_ctx_finalize(&ctx);
+      return NULL;
+   }
+   return ctx;
+}
+
+/**
+ * Write messages with sequence numbers until total_bytes are stored.
+ * \return throughput in MB/s, negative on error
+ */
+static double write_file(const char *file, const char *io, const char *rotation, uint64_t total_bytes, uint16_t payload_size)
+{
+   char params[4096];
+   struct timespec start, end;
+   uint64_t seq, bytes = 0;
+   uint8_t *payload;
+   trap_ctx_t *ctx;
+   int ret;
+
+   if (rotation != NULL) {
+      snprintf(params, sizeof(params), "%s/slice:%s:io=%s", file, rotation, io);
+   } else {
+      snprintf(params, sizeof(params), "%s:w:io=%s", file, io);
+   }
+   ctx = init_file_ifc(&writer_info, params);
+   payload = (uint8_t *) calloc(1, payload_size);
+   if ((ctx == NULL) || (payload == NULL)) {
+      free(payload);
+      return -1;
+   }
+   trap_ctx_set_data_fmt(ctx, 0, TRAP_FMT_RAW);
+   trap_ctx_ifcctl(ctx, TRAPIFC_OUTPUT, 0, TRAPCTL_SETTIMEOUT, TRAP_WAIT);
+
+   clock_gettime(CLOCK_MONOTONIC, &start);
+   for (seq = 0; bytes < total_bytes; seq++) {
+      *((uint64_t *) payload) = seq;
+      ret = trap_ctx_send(ctx, 0, payload, payload_size);
+      if (ret != TRAP_E_OK) {
+         fprintf(stderr, "trap_ctx_send() failed: %d\n", ret);
+         break;
+      }
+      bytes += payload_size;
+   }
+   /* end of data */
+   trap_ctx_send(ctx, 0, payload, 1);
+   trap_ctx_send_flush(ctx, 0);
+   /* the file is complete after finalize */
+   trap_ctx_finalize(&ctx);
+   clock_gettime(CLOCK_MONOTONIC, &end);
+
+   free(payload);
+   return bytes / 1e6 / elapsed_s(&start, &end);
+}
+
+/**
+ * Replay the file and check sequence numbers.
+ * \return throughput in MB/s, negative on error
+ */
+static double read_file(const char *file, const char *io, uint64_t *messages, uint64_t *errors)
+{
+   char params[4096];
+   struct timespec start, end;
+   uint64_t expected = 0, bytes = 0;
+   const void *data;
+   uint16_t size;
+   trap_ctx_t *ctx;
+   int ret;
+
+   snprintf(params, sizeof(params), "%s:io=%s", file, io);
+   ctx = init_file_ifc(&reader_info, params);
+   if (ctx == NULL) {
+      return -1;
+   }
+   trap_ctx_set_required_fmt(ctx, 0, TRAP_FMT_RAW);
+   trap_ctx_ifcctl(ctx, TRAPIFC_INPUT, 0, TRAPCTL_SETTIMEOUT, TRAP_WAIT);
+
+   *messages = *errors = 0;
+   clock_gettime(CLOCK_MONOTONIC, &start);
+   while (1) {
+      ret = trap_ctx_recv(ctx, 0, &data, &size);
+      if (ret != TRAP_E_OK) {
+         fprintf(stderr, "trap_ctx_recv() failed: %d\n", ret);
+         break;
+      }
+      if (size <= 1) {
+         break;
+      }
+      if (*((const uint64_t *) data) != expected) {
+         (*errors)++;
+      }
+      expected = *((const uint64_t *) data) + 1;
+      bytes += size;
+      (*messages)++;
+   }
+   clock_gettime(CLOCK_MONOTONIC, &end);
+   trap_ctx_finalize(&ctx);
+
+   return bytes / 1e6 / elapsed_s(&start, &end);
+}
+
+/**
+ * Call fn for every file in directory of slices, return number of files.
+ */
+static int for_each_slice(const char *dir, void (*fn)(const char *))
+{
+   char path[4096];
+   struct dirent *e;
+   DIR *d;
+   int cnt = 0;
+
+   d = opendir(dir);
+   if (d == NULL) {
+      return 0;
+   }
+   while ((e = readdir(d)) != NULL) {
+      if ((strcmp(e->d_name, ".") == 0) || (strcmp(e->d_name, "..") == 0)) {
+         continue;
+      }
+      snprintf(path, sizeof(path), "%s/%s", dir, e->d_name);
+      fn(path);
+      cnt++;
+   }
+   closedir(d);
+   return cnt;
+}
+
+static void count_slice(const char *file)
+{
+}
+
+static void remove_slice(const char *file)
+{
+   unlink(file);
+}
+
+static void drop_cache(const char *file)
+{
+   int fd = open(file, O_RDONLY);
+   if (fd != -1) {
+      fdatasync(fd);
+      posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+      close(fd);
+   }
+}
+
+int main(int argc, char **argv)
+{
+   const char *write_engines[] = { "stdio", "batch" };
+   const char *read_engines[] = { "stdio", "mmap" };
+   const char *file = "/tmp/trap-file-replay.dat";
+   const char *rotation = NULL;
+   uint64_t mbytes = 512, messages, errors;
+   uint16_t payload_size = 100;
+   char cold = 0;
+   signed char opt;
+   double mbps;
+   int i, ret = 0;
+
+   while ((opt = getopt(argc, argv, "hf:s:n:cr:")) != ERRARG) {
+      switch (opt) {
+      case 'f':
+         file = optarg;
+         break;
+      case 's':
+         sscanf(optarg, "%"SCNu64, &mbytes);
+         break;
+      case 'n':
+         sscanf(optarg, "%"SCNu16, &payload_size);
+         break;
+      case 'c':
+         cold = 1;
+         break;
+      case 'r':
+         rotation = optarg;
+         break;
+      case 'h':
+      default:
+         help(argv[0]);
+         return 0;
+      }
+   }
+   if (payload_size < sizeof(uint64_t)) {
+      payload_size = sizeof(uint64_t);
+   }
+
+   printf("Data: %"PRIu64" MB in messages of %"PRIu16" B, %s cache\n", mbytes, payload_size, (cold ? "cold" : "warm"));
+   if ((rotation != NULL) && (mkdir(file, 0777) == -1) && (errno != EEXIST)) {
+      perror(file);
+      return 1;
+   }
+   for (i = 0; i < 2; i++) {
+      if (rotation != NULL) {
+         /* the last written data are replayed */
+         for_each_slice(file, remove_slice);
+      }
+      mbps = write_file(file, write_engines[i], rotation, mbytes * 1000000, payload_size);
+      if (mbps < 0) {
+         ret = 1;
+         goto exit;
+      }
+      printf("write io=%-5s %10.1f MB/s", write_engines[i], mbps);
+      if (rotation != NULL) {
+         printf(" (%d slices)", for_each_slice(file, count_slice));
+      }
+      printf("\n");
+   }
+   for (i = 0; i < 2; i++) {
+      if (cold) {
+         if (rotation != NULL) {
+            for_each_slice(file, drop_cache);
+         } else {
+            drop_cache(file);
+         }
+      }
+      mbps = read_file(file, read_engines[i], &messages, &errors);
+      if (mbps < 0) {
+         ret = 1;
+         goto exit;
+      }
+      printf("read  io=%-5s %10.1f MB/s (%"PRIu64" messages, %"PRIu64" errors)\n", read_engines[i], mbps, messages, errors);
+      if (errors != 0) {
+         ret = 1;
+      }
+   }
+
+exit:
+   if (rotation != NULL) {
+      for_each_slice(file, remove_slice);
+      rmdir(file);
+   } else {
+      unlink(file);
+   }
+   return ret;
+}
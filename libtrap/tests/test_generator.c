@@ -0,0 +1,314 @@
+/**
+ * \file test_generator.c
+ * \brief Test of generator IFC: synthesised records, replay of capture and pacing
+ */
+/*
+ * Copyright (C) 2026 CESNET
+ *
+ * LICENSE TERMS
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name of the Company nor the names of its contributors
+ *    may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ *
+ * ALTERNATIVELY, provided that this notice is retained in full, this
+ * product may be distributed under the terms of the GNU General Public
+ * License (GPL) version 2 or later, in which case the provisions
+ * of the GPL apply INSTEAD OF those given above.
+ *
+ * This software is provided ``as is'', and any express or implied
+ * warranties, including, but not limited to, the implied warranties of
+ * merchantability and fitness for a particular purpose are disclaimed.
+ * In no event shall the company or contributors be liable for any
+ * direct, indirect, incidental, special, exemplary, or consequential
+ * damages (including, but not limited to, procurement of substitute
+ * goods or services; loss of use, data, or profits; or business
+ * interruption) however caused and on any theory of liability, whether
+ * in contract, strict liability, or tort (including negligence or
+ * otherwise) arising in any way out of the use of this software, even
+ * if advised of the possibility of such damage.
+ *
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <stdint.h>
+#include <inttypes.h>
+#include <time.h>
+#include <arpa/inet.h>
+#include <libtrap/trap.h>
+
+#define DATA_FILE "test_generator.data"
+#define RECORDS 1000
+#define LOOPS 3
+/** Fields of template in arbitrary order, the generator sorts them like UniRec does */
+#define TEMPLATE "uint32 PACKETS+ipaddr SRC_IP+string URL+time TIME_FIRST+uint16 SRC_PORT"
+#define TEMPLATE_SPEC "ipaddr SRC_IP,time TIME_FIRST,uint32 PACKETS,uint16 SRC_PORT,string URL"
+#define TEMPLATE_SIZE (16 + 8 + 4 + 2 + 4)
+#define CAPTURE_SPEC "uint64 SEQ"
+#define RATE_RECORDS 10000
+#define RATE 20000
+
+trap_module_info_t out_module_info = {
+   "Generator test sender", // Module name
+   // Module description
+   "\n",
+   0, // Number of input interfaces
+   1, // Number of output interfaces
+};
+
+trap_module_info_t in_module_info = {
+   "Generator test receiver", // Module name
+   // Module description
+   "\n",
+   1, // Number of input interfaces
+   0, // Number of output interfaces
+};
+
+static trap_ctx_t *init_ctx(trap_module_info_t *info, char *ifc)
+{
+   char *argv[] = {"test", "-i", ifc};
+   int argc = 3;
+   trap_ifc_spec_t ifc_spec;
+   trap_ctx_t *ctx;
+
+   if (trap_parse_params(&argc, argv, &ifc_spec) != TRAP_E_OK) {
+      fprintf(stderr, "Error in parsing of parameters for TRAP: %s\n", trap_last_error_msg);
+      return NULL;
+   }
+   ctx = trap_ctx_init(info, ifc_spec);
+   trap_free_ifc_spec(ifc_spec);
+   if ((ctx != NULL) && (trap_ctx_get_last_error(ctx) != TRAP_E_OK)) {
+      fprintf(stderr, "Error in TRAP initialization: %s\n", trap_ctx_get_last_error_msg(ctx));
+      trap_ctx_finalize(&ctx);
+      return NULL;
+   }
+   return ctx;
+}
+
+/**
+ * Synthesised records: data format of the template, subset is accepted,
+ * every pass returns the same records.
+ */
+static int check_template(void)
+{
+   uint8_t first[RECORDS][TEMPLATE_SIZE];
+   const void *data;
+   const char *spec;
+   uint8_t data_type;
+   uint16_t size;
+   uint32_t addr;
+   uint64_t received = 0;
+   int ret, changed = 0, result = 1;
+   trap_ctx_t *ctx;
+
+   ctx = init_ctx(&in_module_info, "g:template=" TEMPLATE ":count=1000:loop=3:seed=7");
+   if (ctx == NULL) {
+      return 1;
+   }
+   trap_ctx_set_required_fmt(ctx, 0, TRAP_FMT_UNIREC, "ipaddr SRC_IP,uint32 PACKETS");
+   while (1) {
+      ret = trap_ctx_recv(ctx, 0, &data, &size);
+      if (ret == TRAP_E_FORMAT_CHANGED) {
+         changed++;
+      } else if (ret != TRAP_E_OK) {
+         fprintf(stderr, "trap_ctx_recv() failed: %s\n", trap_ctx_get_last_error_msg(ctx));
+         goto finalize;
+      }
+      if (size <= 1) {
+         break;
+      }
+      if (size != TEMPLATE_SIZE) {
+         fprintf(stderr, "Unexpected size of record: %"PRIu16"\n", size);
+         goto finalize;
+      }
+      /* SRC_IP is the first field, IPv4 from 10.0.0.0/8 */
+      memcpy(&addr, (const uint8_t *) data + 8, sizeof(addr));
+      if ((ntohl(addr) >> 24) != 10) {
+         fprintf(stderr, "Unexpected SRC_IP of record %"PRIu64".\n", received);
+         goto finalize;
+      }
+      if (received < RECORDS) {
+         memcpy(first[received], data, TEMPLATE_SIZE);
+      } else if (memcmp(first[received % RECORDS], data, TEMPLATE_SIZE) != 0) {
+         fprintf(stderr, "Record %"PRIu64" differs from the first pass.\n", received);
+         goto finalize;
+      }
+      received++;
+   }
+   if ((received != RECORDS * LOOPS) || (changed != 1)) {
+      fprintf(stderr, "Received %"PRIu64" records (expected %d), format changed %d times.\n", received, RECORDS * LOOPS, changed);
+      goto finalize;
+   }
+   if ((trap_ctx_get_data_fmt(ctx, TRAPIFC_INPUT, 0, &data_type, &spec) != TRAP_E_OK) ||
+       (data_type != TRAP_FMT_UNIREC) || (strcmp(spec, TEMPLATE_SPEC) != 0)) {
+      fprintf(stderr, "Unexpected data format of generator.\n");
+      goto finalize;
+   }
+   printf("template: %"PRIu64" records received.\n", received);
+   result = 0;
+
+finalize:
+   trap_ctx_finalize(&ctx);
+   return result;
+}
+
+/**
+ * Template that does not contain the required fields is refused.
+ */
+static int check_mismatch(void)
+{
+   const void *data;
+   uint16_t size;
+   trap_ctx_t *ctx;
+   int ret;
+
+   ctx = init_ctx(&in_module_info, "g:template=uint32 PACKETS:count=10");
+   if (ctx == NULL) {
+      return 1;
+   }
+   trap_ctx_set_required_fmt(ctx, 0, TRAP_FMT_UNIREC, "uint64 BYTES");
+   ret = trap_ctx_recv(ctx, 0, &data, &size);
+   trap_ctx_finalize(&ctx);
+   if (ret != TRAP_E_FORMAT_MISMATCH) {
+      fprintf(stderr, "Mismatching template was not refused (%d).\n", ret);
+      return 1;
+   }
+   return 0;
+}
+
+/**
+ * Records are returned at the given rate.
+ */
+static int check_rate(void)
+{
+   struct timespec start, end;
+   const void *data;
+   uint16_t size;
+   uint64_t received = 0;
+   double duration;
+   trap_ctx_t *ctx;
+   int ret, result = 1;
+   char ifc[128];
+
+   snprintf(ifc, sizeof(ifc), "g:template=uint32 PACKETS:count=%d:rate=%d", RATE_RECORDS, RATE);
+   ctx = init_ctx(&in_module_info, ifc);
+   if (ctx == NULL) {
+      return 1;
+   }
+   trap_ctx_set_required_fmt(ctx, 0, TRAP_FMT_UNIREC, "uint32 PACKETS");
+   clock_gettime(CLOCK_MONOTONIC, &start);
+   while (1) {
+      ret = trap_ctx_recv(ctx, 0, &data, &size);
+      if ((ret != TRAP_E_OK) && (ret != TRAP_E_FORMAT_CHANGED)) {
+         fprintf(stderr, "trap_ctx_recv() failed: %s\n", trap_ctx_get_last_error_msg(ctx));
+         goto finalize;
+      }
+      if (size <= 1) {
+         break;
+      }
+      received++;
+   }
+   clock_gettime(CLOCK_MONOTONIC, &end);
+   duration = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+   /* the last chunk is due at (RATE_RECORDS - RATE / 100) / RATE seconds */
+   if ((received != RATE_RECORDS) || (duration < 0.45) || (duration > 2.0)) {
+      fprintf(stderr, "rate: %"PRIu64" records in %.3f s, expected %d in 0.5 s.\n", received, duration, RATE_RECORDS);
+      goto finalize;
+   }
+   printf("rate: %"PRIu64" records in %.3f s.\n", received, duration);
+   result = 0;
+
+finalize:
+   trap_ctx_finalize(&ctx);
+   return result;
+}
+
+static int write_capture(void)
+{
+   uint64_t seq;
+   trap_ctx_t *ctx;
+
+   ctx = init_ctx(&out_module_info, "f:" DATA_FILE ":w");
+   if (ctx == NULL) {
+      return 1;
+   }
+   trap_ctx_set_data_fmt(ctx, 0, TRAP_FMT_UNIREC, CAPTURE_SPEC);
+   for (seq = 0; seq < RECORDS; seq++) {
+      if (trap_ctx_send(ctx, 0, &seq, sizeof(seq)) != TRAP_E_OK) {
+         fprintf(stderr, "Sending failed.\n");
+         trap_ctx_finalize(&ctx);
+         return 1;
+      }
+   }
+   trap_ctx_finalize(&ctx);
+   return 0;
+}
+
+/**
+ * Capture is replayed in order LOOPS times.
+ */
+static int check_replay(void)
+{
+   const void *data;
+   uint16_t size;
+   uint64_t seq, received = 0;
+   trap_ctx_t *ctx;
+   int ret, result = 1;
+   char ifc[128];
+
+   if (write_capture() != 0) {
+      return 1;
+   }
+   snprintf(ifc, sizeof(ifc), "g:file=" DATA_FILE ":loop=%d", LOOPS);
+   ctx = init_ctx(&in_module_info, ifc);
+   if (ctx == NULL) {
+      return 1;
+   }
+   trap_ctx_set_required_fmt(ctx, 0, TRAP_FMT_UNIREC, CAPTURE_SPEC);
+   while (1) {
+      ret = trap_ctx_recv(ctx, 0, &data, &size);
+      if ((ret != TRAP_E_OK) && (ret != TRAP_E_FORMAT_CHANGED)) {
+         fprintf(stderr, "trap_ctx_recv() failed: %s\n", trap_ctx_get_last_error_msg(ctx));
+         goto finalize;
+      }
+      if (size <= 1) {
+         break;
+      }
+      memcpy(&seq, data, sizeof(seq));
+      if ((size != sizeof(seq)) || (seq != received % RECORDS)) {
+         fprintf(stderr, "Unexpected message %"PRIu64" (size %"PRIu16").\n", received, size);
+         goto finalize;
+      }
+      received++;
+   }
+   if (received != RECORDS * LOOPS) {
+      fprintf(stderr, "replay: received %"PRIu64" messages instead of %d.\n", received, RECORDS * LOOPS);
+      goto finalize;
+   }
+   printf("replay: %"PRIu64" messages received.\n", received);
+   result = 0;
+
+finalize:
+   trap_ctx_finalize(&ctx);
+   unlink(DATA_FILE);
+   return result;
+}
+
+int main(int argc, char **argv)
+{
+   if ((check_template() != 0) || (check_mismatch() != 0) || (check_rate() != 0) || (check_replay() != 0)) {
+      return EXIT_FAILURE;
+   }
+   return EXIT_SUCCESS;
+}
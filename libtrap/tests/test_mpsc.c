@@ -0,0 +1,468 @@
+/**
+ * \file test_mpsc.c
+ * \brief Test and benchmark of multi-producer sending (setter mpsc=N) of output IFC
+ */
+/*
+ * Copyright (C) 2026 CESNET
+ *
+ * LICENSE TERMS
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name of the Company nor the names of its contributors
+ *    may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ *
+ * ALTERNATIVELY, provided that this notice is retained in full, this
+ * product may be distributed under the terms of the GNU General Public
+ * License (GPL) version 2 or later, in which case the provisions
+ * of the GPL apply INSTEAD OF those given above.
+ *
+ * This software is provided ``as is'', and any express or implied
+ * warranties, including, but not limited to, the implied warranties of
+ * merchantability and fitness for a particular purpose are disclaimed.
+ * In no event shall the company or contributors be liable for any
+ * direct, indirect, incidental, special, exemplary, or consequential
+ * damages (including, but not limited to, procurement of substitute
+ * goods or services; loss of use, data, or profits; or business
+ * interruption) however caused and on any theory of liability, whether
+ * in contract, strict liability, or tort (including negligence or
+ * otherwise) arising in any way out of the use of this software, even
+ * if advised of the possibility of such damage.
+ *
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <stdint.h>
+#include <inttypes.h>
+#include <pthread.h>
+#include <time.h>
+#include <libtrap/trap.h>
+
+#define MESSAGES 200000     ///< Default number of messages of every producer (check)
+#define PRODUCERS 4         ///< Default number of producers (check)
+#define BENCH_MESSAGES 4000000 ///< Default number of messages of every benchmark run
+#define MAX_PRODUCERS 64    ///< Maximal number of producers
+#define WAIT_SEC 10         ///< Time limit of connecting and receiving (seconds)
+
+trap_module_info_t out_module_info = {
+   "MPSC test sender", // Module name
+   // Module description
+   "\n",
+   0, // Number of input interfaces
+   1, // Number of output interfaces
+};
+
+trap_module_info_t in_module_info = {
+   "MPSC test receiver", // Module name
+   // Module description
+   "\n",
+   1, // Number of input interfaces
+   0, // Number of output interfaces
+};
+
+/** Message of the test, payload of benchmark is padded to the requested size */
+struct record {
+   uint32_t producer;
+   uint32_t reserved;
+   uint64_t seq;
+};
+
+struct receiver_arg {
+   trap_ctx_t *ctx;
+   uint64_t expected[MAX_PRODUCERS]; ///< The next sequence number of every producer
+   uint64_t received;
+   uint64_t errors;
+   volatile int stop;
+};
+
+struct producer_arg {
+   trap_ctx_t *ctx;
+   uint32_t id;
+   uint64_t messages;
+   uint16_t size;
+   int reserve;             ///< Use trap_ctx_send_reserve() instead of trap_ctx_send()
+   pthread_barrier_t *barrier;
+   int failed;
+};
+
+static trap_ctx_t *init_ctx(trap_module_info_t *info, char *ifc)
+{
+   char *argv[] = {"test", "-i", ifc};
+   int argc = 3;
+   trap_ifc_spec_t ifc_spec;
+   trap_ctx_t *ctx;
+
+   if (trap_parse_params(&argc, argv, &ifc_spec) != TRAP_E_OK) {
+      fprintf(stderr, "Error in parsing of parameters for TRAP: %s\n", trap_last_error_msg);
+      return NULL;
+   }
+   ctx = trap_ctx_init(info, ifc_spec);
+   trap_free_ifc_spec(ifc_spec);
+   if ((ctx != NULL) && (trap_ctx_get_last_error(ctx) != TRAP_E_OK)) {
+      fprintf(stderr, "Error in TRAP initialization: %s\n", trap_ctx_get_last_error_msg(ctx));
+      trap_ctx_finalize(&ctx);
+      return NULL;
+   }
+   return ctx;
+}
+
+static double now_s(void)
+{
+   struct timespec ts;
+
+   clock_gettime(CLOCK_MONOTONIC, &ts);
+   return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/**
+ * Receiver thread: check that messages of every producer come in order.
+ */
+static void *receiver(void *arg)
+{
+   struct receiver_arg *r = (struct receiver_arg *) arg;
+   struct record rec;
+   const void *data;
+   uint16_t size;
+   int ret;
+
+   while (r->stop == 0) {
+      ret = trap_ctx_recv(r->ctx, 0, &data, &size);
+      if (ret == TRAP_E_TIMEOUT) {
+         continue;
+      }
+      TRAP_DEFAULT_RECV_ERROR_HANDLING(ret, continue, break);
+      if (size < sizeof(rec)) {
+         r->errors++;
+         continue;
+      }
+      memcpy(&rec, data, sizeof(rec));
+      if ((rec.producer >= MAX_PRODUCERS) || (rec.seq != r->expected[rec.producer])) {
+         if (r->errors++ < 10) {
+            fprintf(stderr, "Producer %"PRIu32": got %"PRIu64", expected %"PRIu64".\n", rec.producer,
+                    rec.seq, (rec.producer < MAX_PRODUCERS ? r->expected[rec.producer] : 0));
+         }
+      }
+      if (rec.producer < MAX_PRODUCERS) {
+         r->expected[rec.producer] = rec.seq + 1;
+      }
+      __sync_fetch_and_add(&r->received, 1);
+   }
+   return NULL;
+}
+
+/**
+ * Producer thread: send numbered messages, the thread exits without flush.
+ */
+static void *producer(void *arg)
+{
+   struct producer_arg *p = (struct producer_arg *) arg;
+   uint8_t buffer[UINT16_MAX];
+   struct record *rec = (struct record *) buffer;
+   void *space;
+   uint64_t i;
+
+   memset(buffer, 0, sizeof(buffer));
+   rec->producer = p->id;
+   if (p->barrier != NULL) {
+      pthread_barrier_wait(p->barrier);
+   }
+   for (i = 0; i < p->messages; i++) {
+      rec->seq = i;
+      if (p->reserve != 0) {
+         if (trap_ctx_send_reserve(p->ctx, 0, p->size, &space) != TRAP_E_OK) {
+            p->failed = 1;
+            break;
+         }
+         memcpy(space, buffer, p->size);
+         if (trap_ctx_send_commit(p->ctx, 0, p->size) != TRAP_E_OK) {
+            p->failed = 1;
+            break;
+         }
+      } else if (trap_ctx_send(p->ctx, 0, buffer, p->size) != TRAP_E_OK) {
+         p->failed = 1;
+         break;
+      }
+   }
+   return NULL;
+}
+
+/**
+ * Send messages from several producer threads to one receiver and check
+ * that messages of every producer are received completely and in order.
+ *
+ * Autoflush is disabled, so the last buffers of producers are handed over
+ * when the producer threads exit.
+ *
+ * \param[in] producers  number of producer threads
+ * \param[in] messages   number of messages of every producer
+ * \return 0 on success
+ */
+static int run_check(int producers, uint64_t messages)
+{
+   char ifc_out[64], ifc_in[64];
+   trap_ctx_t *out_ctx;
+   struct receiver_arg r;
+   struct producer_arg p[MAX_PRODUCERS];
+   pthread_t rx_thread, threads[MAX_PRODUCERS];
+   uint64_t total = messages * producers;
+   int n, started = 0, rx_started = 0, result = 1;
+   double start;
+
+   memset(&r, 0, sizeof(r));
+   memset(p, 0, sizeof(p));
+   snprintf(ifc_in, sizeof(ifc_in), "u:test_mpsc_%d", (int) getpid());
+   snprintf(ifc_out, sizeof(ifc_out), "%s:mpsc=2:autoflush=off", ifc_in);
+   out_ctx = init_ctx(&out_module_info, ifc_out);
+   if (out_ctx == NULL) {
+      return 1;
+   }
+   trap_ctx_set_data_fmt(out_ctx, 0, TRAP_FMT_RAW);
+   trap_ctx_ifcctl(out_ctx, TRAPIFC_OUTPUT, 0, TRAPCTL_SETTIMEOUT, TRAP_WAIT);
+
+   r.ctx = init_ctx(&in_module_info, ifc_in);
+   if (r.ctx == NULL) {
+      goto finalize;
+   }
+   trap_ctx_set_required_fmt(r.ctx, 0, TRAP_FMT_RAW);
+   trap_ctx_ifcctl(r.ctx, TRAPIFC_INPUT, 0, TRAPCTL_SETTIMEOUT, 100000);
+   if (pthread_create(&rx_thread, NULL, receiver, &r) != 0) {
+      fprintf(stderr, "Creation of receiver thread failed.\n");
+      goto finalize;
+   }
+   rx_started = 1;
+
+   start = now_s();
+   while (trap_ctx_get_client_count(out_ctx, 0) < 1) {
+      if (now_s() - start > WAIT_SEC) {
+         fprintf(stderr, "Receiver did not connect.\n");
+         goto finalize;
+      }
+      usleep(10000);
+   }
+
+   start = now_s();
+   for (n = 0; n < producers; n++) {
+      p[n].ctx = out_ctx;
+      p[n].id = n;
+      p[n].messages = messages;
+      p[n].size = sizeof(struct record) + n * 8;
+      p[n].reserve = n % 2;
+      if (pthread_create(&threads[n], NULL, producer, &p[n]) != 0) {
+         fprintf(stderr, "Creation of producer thread failed.\n");
+         break;
+      }
+      started++;
+   }
+   for (n = 0; n < started; n++) {
+      pthread_join(threads[n], NULL);
+      if (p[n].failed != 0) {
+         fprintf(stderr, "Producer %d failed: %s\n", n, trap_ctx_get_last_error_msg(out_ctx));
+         goto finalize;
+      }
+   }
+   if (started != producers) {
+      goto finalize;
+   }
+   /* no flush: buffers of exited threads must be sent anyway */
+   while ((r.received < total) && (now_s() - start < WAIT_SEC)) {
+      usleep(1000);
+   }
+   printf("%d producers: %"PRIu64" of %"PRIu64" messages received in %.3f s, %"PRIu64" out of order\n",
+          producers, r.received, total, now_s() - start, r.errors);
+   if (r.received != total) {
+      fprintf(stderr, "Every message must be received.\n");
+   } else if (r.errors != 0) {
+      fprintf(stderr, "Messages of every producer must be received in order.\n");
+   } else {
+      result = 0;
+   }
+
+finalize:
+   r.stop = 1;
+   if (rx_started != 0) {
+      pthread_join(rx_thread, NULL);
+   }
+   if (r.ctx != NULL) {
+      trap_ctx_finalize(&r.ctx);
+   }
+   trap_ctx_finalize(&out_ctx);
+   return result;
+}
+
+/**
+ * Measure throughput of producer threads sending into one output IFC.
+ *
+ * \param[in] type      'b' (blackhole) or 'u' (UNIX socket with a receiver)
+ * \param[in] mpsc      number of staging buffers per thread, 0 for sending under the IFC lock
+ * \param[in] producers number of producer threads
+ * \param[in] messages  number of messages of all producers together
+ * \param[in] size      size of message
+ * \return throughput in messages per second, negative on error
+ */
+static double run_bench(char type, uint32_t mpsc, int producers, uint64_t messages, uint16_t size)
+{
+   char ifc_out[64], ifc_in[64], setter[16] = "";
+   trap_ctx_t *out_ctx;
+   struct receiver_arg r;
+   struct producer_arg p[MAX_PRODUCERS];
+   pthread_t rx_thread, threads[MAX_PRODUCERS];
+   pthread_barrier_t barrier;
+   int n, started = 0, rx_started = 0;
+   double start, elapsed, result = -1;
+
+   memset(&r, 0, sizeof(r));
+   memset(p, 0, sizeof(p));
+   if (mpsc != 0) {
+      snprintf(setter, sizeof(setter), ":mpsc=%"PRIu32, mpsc);
+   }
+   snprintf(ifc_in, sizeof(ifc_in), "u:test_mpsc_%d_%c%"PRIu32"_%d", (int) getpid(), type, mpsc, producers);
+   if (type == 'b') {
+      snprintf(ifc_out, sizeof(ifc_out), "b:%s", setter + 1);
+   } else {
+      snprintf(ifc_out, sizeof(ifc_out), "%s%s", ifc_in, setter);
+   }
+   out_ctx = init_ctx(&out_module_info, ifc_out);
+   if (out_ctx == NULL) {
+      return -1;
+   }
+   trap_ctx_set_data_fmt(out_ctx, 0, TRAP_FMT_RAW);
+   trap_ctx_ifcctl(out_ctx, TRAPIFC_OUTPUT, 0, TRAPCTL_SETTIMEOUT, TRAP_WAIT);
+
+   if (type == 'u') {
+      r.ctx = init_ctx(&in_module_info, ifc_in);
+      if (r.ctx == NULL) {
+         goto finalize;
+      }
+      trap_ctx_set_required_fmt(r.ctx, 0, TRAP_FMT_RAW);
+      trap_ctx_ifcctl(r.ctx, TRAPIFC_INPUT, 0, TRAPCTL_SETTIMEOUT, 100000);
+      if (pthread_create(&rx_thread, NULL, receiver, &r) != 0) {
+         goto finalize;
+      }
+      rx_started = 1;
+      start = now_s();
+      while (trap_ctx_get_client_count(out_ctx, 0) < 1) {
+         if (now_s() - start > WAIT_SEC) {
+            fprintf(stderr, "Receiver did not connect.\n");
+            goto finalize;
+         }
+         usleep(10000);
+      }
+   }
+
+   pthread_barrier_init(&barrier, NULL, producers + 1);
+   for (n = 0; n < producers; n++) {
+      p[n].ctx = out_ctx;
+      p[n].id = n;
+      p[n].messages = messages / producers;
+      p[n].size = size;
+      p[n].barrier = &barrier;
+      if (pthread_create(&threads[n], NULL, producer, &p[n]) != 0) {
+         fprintf(stderr, "Creation of producer thread failed.\n");
+         exit(EXIT_FAILURE);
+      }
+      started++;
+   }
+   pthread_barrier_wait(&barrier);
+   start = now_s();
+   for (n = 0; n < started; n++) {
+      pthread_join(threads[n], NULL);
+   }
+   trap_ctx_send_flush(out_ctx, 0);
+   elapsed = now_s() - start;
+   pthread_barrier_destroy(&barrier);
+   result = (messages / producers) * producers / elapsed;
+   for (n = 0; n < started; n++) {
+      if (p[n].failed != 0) {
+         result = -1;
+      }
+   }
+
+finalize:
+   r.stop = 1;
+   if (rx_started != 0) {
+      pthread_join(rx_thread, NULL);
+   }
+   if (r.ctx != NULL) {
+      trap_ctx_finalize(&r.ctx);
+   }
+   trap_ctx_finalize(&out_ctx);
+   return result;
+}
+
+int main(int argc, char **argv)
+{
+   int opt, n, bench = 0, producers = PRODUCERS, max_threads = 16;
+   uint64_t messages = 0;
+   uint32_t mpsc = 4;
+   uint16_t size = 64;
+   const char types[] = {'b', 'u'};
+   double lock_rate, mpsc_rate;
+   int t;
+
+   while ((opt = getopt(argc, argv, "bm:n:p:s:t:")) != -1) {
+      switch (opt) {
+      case 'b':
+         bench = 1;
+         break;
+      case 'm':
+         mpsc = strtoul(optarg, NULL, 10);
+         break;
+      case 'n':
+         messages = strtoull(optarg, NULL, 10);
+         break;
+      case 'p':
+         producers = atoi(optarg);
+         break;
+      case 's':
+         size = atoi(optarg);
+         break;
+      case 't':
+         max_threads = atoi(optarg);
+         break;
+      default:
+         fprintf(stderr, "Usage: %s [-p producers] [-n messages]\n"
+                 "       %s -b [-n messages] [-s size] [-t max_threads] [-m mpsc_buffers]\n"
+                 "Without -b, check order of messages of producers, -b runs benchmark of\n"
+                 "1 to max_threads producers with and without mpsc on b: and u: IFC.\n",
+                 argv[0], argv[0]);
+         return EXIT_FAILURE;
+      }
+   }
+   if ((producers < 1) || (producers > MAX_PRODUCERS) || (max_threads < 1) || (max_threads > MAX_PRODUCERS) ||
+       (size < sizeof(struct record)) || (mpsc == 0)) {
+      fprintf(stderr, "Bad parameters, producers and threads must be 1-%d, size at least %d.\n",
+              MAX_PRODUCERS, (int) sizeof(struct record));
+      return EXIT_FAILURE;
+   }
+
+   if (bench == 0) {
+      return (run_check(producers, (messages != 0 ? messages : MESSAGES)) == 0 ? EXIT_SUCCESS : EXIT_FAILURE);
+   }
+
+   if (messages == 0) {
+      messages = BENCH_MESSAGES;
+   }
+   printf("ifc threads   lock Mmsg/s   mpsc=%"PRIu32" Mmsg/s\n", mpsc);
+   for (t = 0; t < (int) sizeof(types); t++) {
+      for (n = 1; n <= max_threads; n *= 2) {
+         lock_rate = run_bench(types[t], 0, n, messages, size);
+         mpsc_rate = run_bench(types[t], mpsc, n, messages, size);
+         if ((lock_rate < 0) || (mpsc_rate < 0)) {
+            fprintf(stderr, "Benchmark failed.\n");
+            return EXIT_FAILURE;
+         }
+         printf("%c:  %7d %13.2f %13.2f\n", types[t], n, lock_rate / 1e6, mpsc_rate / 1e6);
+      }
+   }
+   return EXIT_SUCCESS;
+}
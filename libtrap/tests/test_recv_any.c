@@ -0,0 +1,259 @@
+/**
+ * \file test_recv_any.c
+ * \brief Test of trap_ctx_recv_any(): completeness, order and fairness of inputs
+ */
+/*
+ * Copyright (C) 2026 CESNET
+ *
+ * LICENSE TERMS
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name of the Company nor the names of its contributors
+ *    may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ *
+ * ALTERNATIVELY, provided that this notice is retained in full, this
+ * product may be distributed under the terms of the GNU General Public
+ * License (GPL) version 2 or later, in which case the provisions
+ * of the GPL apply INSTEAD OF those given above.
+ *
+ * This software is provided ``as is'', and any express or implied
+ * warranties, including, but not limited to, the implied warranties of
+ * merchantability and fitness for a particular purpose are disclaimed.
+ * In no event shall the company or contributors be liable for any
+ * direct, indirect, incidental, special, exemplary, or consequential
+ * damages (including, but not limited to, procurement of substitute
+ * goods or services; loss of use, data, or profits; or business
+ * interruption) however caused and on any theory of liability, whether
+ * in contract, strict liability, or tort (including negligence or
+ * otherwise) arising in any way out of the use of this software, even
+ * if advised of the possibility of such damage.
+ *
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <stdint.h>
+#include <inttypes.h>
+#include <pthread.h>
+#include <time.h>
+#include <libtrap/trap.h>
+
+#define IFCS 3              ///< Number of interfaces, the first one is busy, the others are quiet
+#define HOT 1000000         ///< Default number of messages of the busy interface
+#define QUIET 100           ///< Default number of messages of every quiet interface
+#define PERIOD 3000         ///< Period of messages of quiet interfaces (microseconds)
+#define QUOTA 64            ///< Default receive quota of the busy interface
+#define MAX_DELAY 50000     ///< Allowed delay of quiet messages sent after connection of all interfaces (microseconds)
+#define RECV_TIMEOUT 5000000 ///< Timeout of trap_ctx_recv_any() (microseconds)
+
+trap_module_info_t out_module_info = {
+   "recv_any test sender", // Module name
+   // Module description
+   "\n",
+   0, // Number of input interfaces
+   IFCS, // Number of output interfaces
+};
+
+trap_module_info_t in_module_info = {
+   "recv_any test receiver", // Module name
+   // Module description
+   "\n",
+   IFCS, // Number of input interfaces
+   0, // Number of output interfaces
+};
+
+struct message {
+   uint64_t seq;
+   uint64_t stamp;   ///< Time of sending (CLOCK_MONOTONIC, nanoseconds)
+};
+
+struct sender_arg {
+   trap_ctx_t *ctx;
+   uint32_t ifc;
+   uint64_t messages;
+   uint64_t period;  ///< Pause after every message (microseconds), 0 to send as fast as possible
+};
+
+static uint64_t now_ns(void)
+{
+   struct timespec ts;
+
+   clock_gettime(CLOCK_MONOTONIC, &ts);
+   return (uint64_t) ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static trap_ctx_t *init_ctx(trap_module_info_t *info, char *ifc)
+{
+   char *argv[] = {"test", "-i", ifc};
+   int argc = 3;
+   trap_ifc_spec_t ifc_spec;
+   trap_ctx_t *ctx;
+
+   if (trap_parse_params(&argc, argv, &ifc_spec) != TRAP_E_OK) {
+      fprintf(stderr, "Error in parsing of parameters for TRAP: %s\n", trap_last_error_msg);
+      return NULL;
+   }
+   ctx = trap_ctx_init(info, ifc_spec);
+   trap_free_ifc_spec(ifc_spec);
+   if ((ctx != NULL) && (trap_ctx_get_last_error(ctx) != TRAP_E_OK)) {
+      fprintf(stderr, "Error in TRAP initialization: %s\n", trap_ctx_get_last_error_msg(ctx));
+      trap_ctx_finalize(&ctx);
+      return NULL;
+   }
+   return ctx;
+}
+
+static void *sender(void *arg)
+{
+   struct sender_arg *s = (struct sender_arg *) arg;
+   struct message m;
+   char end = 0;
+
+   for (m.seq = 0; m.seq < s->messages; m.seq++) {
+      m.stamp = now_ns();
+      if (trap_ctx_send(s->ctx, s->ifc, &m, sizeof(m)) != TRAP_E_OK) {
+         fprintf(stderr, "Sending to IFC %"PRIu32" failed.\n", s->ifc);
+         return NULL;
+      }
+      if (s->period != 0) {
+         trap_ctx_send_flush(s->ctx, s->ifc);
+         usleep(s->period);
+      }
+   }
+   /* ending message */
+   trap_ctx_send(s->ctx, s->ifc, &end, sizeof(end));
+   trap_ctx_send_flush(s->ctx, s->ifc);
+   return NULL;
+}
+
+int main(int argc, char **argv)
+{
+   int opt, ret, result = EXIT_FAILURE;
+   uint32_t i, ifc, mask = (1 << IFCS) - 1, quota = QUOTA;
+   uint64_t hot = HOT, quiet = QUIET, expected[IFCS], delay, max_delay = 0, quiet_during_hot = 0, calls = 0;
+   uint64_t ready_at = 0;
+   const void *data;
+   uint16_t size;
+   struct message m;
+   struct sender_arg s[IFCS];
+   pthread_t threads[IFCS];
+   char ifc_out[256], ifc_in[256];
+   trap_ctx_t *out_ctx, *in_ctx;
+   double start;
+
+   while ((opt = getopt(argc, argv, "n:q:Q:")) != -1) {
+      switch (opt) {
+      case 'n':
+         hot = strtoull(optarg, NULL, 10);
+         break;
+      case 'q':
+         quiet = strtoull(optarg, NULL, 10);
+         break;
+      case 'Q':
+         quota = strtoul(optarg, NULL, 10);
+         break;
+      default:
+         fprintf(stderr, "Usage: %s [-n busy_messages] [-q quiet_messages] [-Q quota]\n", argv[0]);
+         return EXIT_FAILURE;
+      }
+   }
+
+   snprintf(ifc_out, sizeof(ifc_out), "u:test_recv_any_%d_0,u:test_recv_any_%d_1,u:test_recv_any_%d_2",
+            (int) getpid(), (int) getpid(), (int) getpid());
+   strcpy(ifc_in, ifc_out);
+   out_ctx = init_ctx(&out_module_info, ifc_out);
+   if (out_ctx == NULL) {
+      return EXIT_FAILURE;
+   }
+   in_ctx = init_ctx(&in_module_info, ifc_in);
+   if (in_ctx == NULL) {
+      goto finalize_out;
+   }
+   for (i = 0; i < IFCS; i++) {
+      trap_ctx_set_data_fmt(out_ctx, i, TRAP_FMT_RAW);
+      trap_ctx_ifcctl(out_ctx, TRAPIFC_OUTPUT, i, TRAPCTL_SETTIMEOUT, TRAP_WAIT);
+      trap_ctx_set_required_fmt(in_ctx, i, TRAP_FMT_RAW);
+      expected[i] = 0;
+   }
+   trap_ctx_ifcctl(in_ctx, TRAPIFC_INPUT, 0, TRAPCTL_RECV_QUOTA, quota);
+
+   for (i = 0; i < IFCS; i++) {
+      s[i].ctx = out_ctx;
+      s[i].ifc = i;
+      s[i].messages = (i == 0 ? hot : quiet);
+      s[i].period = (i == 0 ? 0 : PERIOD);
+      if (pthread_create(&threads[i], NULL, sender, &s[i]) != 0) {
+         fprintf(stderr, "Creation of sender thread failed.\n");
+         goto finalize_in;
+      }
+   }
+
+   start = now_ns();
+   while (mask != 0) {
+      ret = trap_ctx_recv_any(in_ctx, mask, &ifc, &data, &size, RECV_TIMEOUT);
+      calls++;
+      if (ret == TRAP_E_TIMEOUT) {
+         fprintf(stderr, "No message received within timeout (mask %"PRIx32").\n", mask);
+         break;
+      }
+      TRAP_DEFAULT_RECV_ERROR_HANDLING(ret, continue, break);
+      if (size == 1) {
+         mask &= ~(1U << ifc);
+         continue;
+      }
+      if (size != sizeof(m)) {
+         fprintf(stderr, "Unexpected message size %"PRIu16" on IFC %"PRIu32".\n", size, ifc);
+         break;
+      }
+      memcpy(&m, data, sizeof(m));
+      if (m.seq != expected[ifc]) {
+         fprintf(stderr, "IFC %"PRIu32": expected message %"PRIu64", got %"PRIu64".\n", ifc, expected[ifc], m.seq);
+         break;
+      }
+      expected[ifc]++;
+      if ((ready_at == 0) && (expected[0] != 0) && (expected[1] != 0) && (expected[2] != 0)) {
+         /* all interfaces are connected, earlier messages waited for connection */
+         ready_at = now_ns();
+      }
+      if (ifc != 0) {
+         delay = now_ns() - m.stamp;
+         if ((ready_at != 0) && (m.stamp > ready_at) && (delay > max_delay)) {
+            max_delay = delay;
+         }
+         if (mask & 1) {
+            quiet_during_hot++;
+         }
+      }
+   }
+   for (i = 0; i < IFCS; i++) {
+      pthread_join(threads[i], NULL);
+   }
+
+   printf("Received %"PRIu64" + %"PRIu64" + %"PRIu64" messages in %.3f s (%.2f Mmsg/s), "
+          "quota %"PRIu32", quiet messages during busy stream: %"PRIu64", max delay of quiet messages: %.1f ms\n",
+          expected[0], expected[1], expected[2], (now_ns() - start) / 1e9,
+          calls / ((now_ns() - start) / 1e3), quota, quiet_during_hot, max_delay / 1e6);
+   if ((mask != 0) || (expected[0] != hot) || (expected[1] != quiet) || (expected[2] != quiet)) {
+      fprintf(stderr, "Not all messages were received.\n");
+   } else if ((quota != 0) && (max_delay > MAX_DELAY * 1000ULL)) {
+      fprintf(stderr, "Quiet interfaces were delayed by the busy one.\n");
+   } else {
+      result = EXIT_SUCCESS;
+   }
+
+finalize_in:
+   trap_ctx_finalize(&in_ctx);
+finalize_out:
+   trap_ctx_finalize(&out_ctx);
+   return result;
+}
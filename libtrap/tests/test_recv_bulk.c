@@ -0,0 +1,172 @@
+/**
+ * \file test_recv_bulk.c
+ * \brief Test: trap_ctx_recv_bulk() returns the same messages as trap_ctx_recv()
+ */
+/*
+ * Copyright (C) 2026 CESNET
+ *
+ * LICENSE TERMS
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name of the Company nor the names of its contributors
+ *    may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ *
+ * ALTERNATIVELY, provided that this notice is retained in full, this
+ * product may be distributed under the terms of the GNU General Public
+ * License (GPL) version 2 or later, in which case the provisions
+ * of the GPL apply INSTEAD OF those given above.
+ *
+ * This software is provided ``as is'', and any express or implied
+ * warranties, including, but not limited to, the implied warranties of
+ * merchantability and fitness for a particular purpose are disclaimed.
+ * In no event shall the company or contributors be liable for any
+ * direct, indirect, incidental, special, exemplary, or consequential
+ * damages (including, but not limited to, procurement of substitute
+ * goods or services; loss of use, data, or profits; or business
+ * interruption) however caused and on any theory of liability, whether
+ * in contract, strict liability, or tort (including negligence or
+ * otherwise) arising in any way out of the use of this software, even
+ * if advised of the possibility of such damage.
+ *
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <stdint.h>
+#include <inttypes.h>
+#include <libtrap/trap.h>
+
+#define DATA_FILE "test_recv_bulk.data"
+#define MESSAGES 20000
+#define BULK_MAX 64
+
+trap_module_info_t out_module_info = {
+   "Bulk receive test sender", // Module name
+   // Module description
+   "\n",
+   0, // Number of input interfaces
+   1, // Number of output interfaces
+};
+
+trap_module_info_t in_module_info = {
+   "Bulk receive test receiver", // Module name
+   // Module description
+   "\n",
+   1, // Number of input interfaces
+   0, // Number of output interfaces
+};
+
+static inline uint16_t message_size(uint64_t seq)
+{
+   return sizeof(seq) + (seq % 200);
+}
+
+static trap_ctx_t *init_ctx(trap_module_info_t *info, char *ifc)
+{
+   char *argv[] = {"test", "-i", ifc};
+   int argc = 3;
+   trap_ifc_spec_t ifc_spec;
+   trap_ctx_t *ctx;
+
+   if (trap_parse_params(&argc, argv, &ifc_spec) != TRAP_E_OK) {
+      fprintf(stderr, "Error in parsing of parameters for TRAP: %s\n", trap_last_error_msg);
+      return NULL;
+   }
+   ctx = trap_ctx_init(info, ifc_spec);
+   trap_free_ifc_spec(ifc_spec);
+   if ((ctx != NULL) && (trap_ctx_get_last_error(ctx) != TRAP_E_OK)) {
+      fprintf(stderr, "Error in TRAP initialization: %s\n", trap_ctx_get_last_error_msg(ctx));
+      trap_ctx_finalize(&ctx);
+      return NULL;
+   }
+   return ctx;
+}
+
+static int check_message(uint64_t seq, const void *data, uint16_t size)
+{
+   if ((size != message_size(seq)) || (*((const uint64_t *) data) != seq)) {
+      fprintf(stderr, "Message %"PRIu64" mismatch (size %"PRIu16").\n", seq, size);
+      return 1;
+   }
+   return 0;
+}
+
+int main(int argc, char **argv)
+{
+   int ret, result = EXIT_FAILURE;
+   uint64_t seq;
+   uint32_t i, count, bulks = 0;
+   uint8_t payload[sizeof(seq) + 200] = { 0 };
+   const void *data[BULK_MAX];
+   uint16_t sizes[BULK_MAX];
+   trap_ctx_t *ctx;
+
+   ctx = init_ctx(&out_module_info, "f:" DATA_FILE ":w");
+   if (ctx == NULL) {
+      return EXIT_FAILURE;
+   }
+   trap_ctx_set_data_fmt(ctx, 0, TRAP_FMT_RAW);
+   for (seq = 0; seq < MESSAGES; seq++) {
+      *((uint64_t *) payload) = seq;
+      if (trap_ctx_send(ctx, 0, payload, message_size(seq)) != TRAP_E_OK) {
+         fprintf(stderr, "Sending failed.\n");
+         trap_ctx_finalize(&ctx);
+         goto exit;
+      }
+   }
+   trap_ctx_finalize(&ctx);
+
+   ctx = init_ctx(&in_module_info, "f:" DATA_FILE);
+   if (ctx == NULL) {
+      goto exit;
+   }
+   trap_ctx_set_required_fmt(ctx, 0, TRAP_FMT_RAW);
+
+   /* the first message by the standard function, the rest in bulks */
+   ret = trap_ctx_recv(ctx, 0, &data[0], &sizes[0]);
+   TRAP_DEFAULT_RECV_ERROR_HANDLING(ret, goto finalize, goto finalize);
+   if (check_message(0, data[0], sizes[0]) != 0) {
+      goto finalize;
+   }
+   seq = 1;
+   while (seq < MESSAGES) {
+      ret = trap_ctx_recv_bulk(ctx, 0, data, sizes, BULK_MAX, &count);
+      TRAP_DEFAULT_RECV_ERROR_HANDLING(ret, goto finalize, goto finalize);
+      if ((count == 0) || (count > BULK_MAX)) {
+         fprintf(stderr, "Unexpected number of messages: %"PRIu32"\n", count);
+         goto finalize;
+      }
+      bulks++;
+      for (i = 0; i < count; i++, seq++) {
+         if ((sizes[i] <= 1) && (seq < MESSAGES)) {
+            fprintf(stderr, "Unexpected end of data after %"PRIu64" messages.\n", seq);
+            goto finalize;
+         }
+         if (check_message(seq, data[i], sizes[i]) != 0) {
+            goto finalize;
+         }
+      }
+   }
+   if (seq != MESSAGES) {
+      fprintf(stderr, "Received %"PRIu64" messages instead of %d.\n", seq, MESSAGES);
+      goto finalize;
+   }
+   printf("Received %"PRIu64" messages in %"PRIu32" bulks.\n", seq, bulks);
+   result = EXIT_SUCCESS;
+
+finalize:
+   trap_ctx_finalize(&ctx);
+exit:
+   unlink(DATA_FILE);
+   return result;
+}
@@ -0,0 +1,238 @@
+/**
+ * \file test_recv_readahead.c
+ * \brief Benchmark: syscalls and throughput of TCP/UNIX input IFC with and without read-ahead buffer
+ */
+/*
+ * Copyright (C) 2026 CESNET
+ *
+ * LICENSE TERMS
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name of the Company nor the names of its contributors
+ *    may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ *
+ * ALTERNATIVELY, provided that this notice is retained in full, this
+ * product may be distributed under the terms of the GNU General Public
+ * License (GPL) version 2 or later, in which case the provisions
+ * of the GPL apply INSTEAD OF those given above.
+ *
+ * This software is provided ``as is'', and any express or implied
+ * warranties, including, but not limited to, the implied warranties of
+ * merchantability and fitness for a particular purpose are disclaimed.
+ * In no event shall the company or contributors be liable for any
+ * direct, indirect, incidental, special, exemplary, or consequential
+ * damages (including, but not limited to, procurement of substitute
+ * goods or services; loss of use, data, or profits; or business
+ * interruption) however caused and on any theory of liability, whether
+ * in contract, strict liability, or tort (including negligence or
+ * otherwise) arising in any way out of the use of this software, even
+ * if advised of the possibility of such damage.
+ *
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <getopt.h>
+#include <unistd.h>
+#include <stdint.h>
+#include <inttypes.h>
+#include <pthread.h>
+#include <libtrap/trap.h>
+#include "trap_internal.h"
+#include "trap_ifc.h"
+
+#define ERRARG -1
+
+// Struct with information about module
+trap_module_info_t module_info = {
+   "Read-ahead receiver benchmark", // Module name
+   // Module description
+   "Send small flushed buffers from output IFC to input IFC of the same module and count syscalls of receiver.\n",
+   1, // Number of input interfaces
+   1, // Number of output interfaces
+};
+
+trap_ctx_t *ctx = NULL;
+
+void help(const char *progname)
+{
+   printf("%s -i ifcspec [-h] [-c count] [-n size] [-m messages]\n"
+          "\t-i\tlibtrap IFC spec of input and output, e.g. u:bench:readahead,u:bench\n"
+          "\t-c\tnumber of messages (default 1000000)\n"
+          "\t-n\tsize of message in bytes (default 64)\n"
+          "\t-m\tnumber of messages per buffer, the buffer is flushed after them (default 4)\n",
+          progname);
+}
+
+struct rx_result {
+   uint64_t received;
+   uint64_t lost;
+};
+
+/**
+ * Receiver thread: count messages and check their sequence numbers.
+ */
+static void *receiver_thr(void *arg)
+{
+   struct rx_result *res = (struct rx_result *) arg;
+   const void *data;
+   uint16_t size;
+   uint64_t expected = 0, seq;
+   int ret;
+
+   while (1) {
+      ret = trap_ctx_recv(ctx, 0, &data, &size);
+      if (ret != TRAP_E_OK) {
+         fprintf(stderr, "trap_ctx_recv() failed: %d\n", ret);
+         break;
+      }
+      if (size <= 1) {
+         break;
+      }
+      seq = *((const uint64_t *) data);
+      if (seq != expected) {
+         res->lost += seq - expected;
+      }
+      expected = seq + 1;
+      res->received++;
+   }
+   return NULL;
+}
+
+static double elapsed_ns(const struct timespec *start, const struct timespec *end)
+{
+   return (end->tv_sec - start->tv_sec) * 1e9 + (end->tv_nsec - start->tv_nsec);
+}
+
+int main(int argc, char **argv)
+{
+   int ret;
+   signed char opt;
+   uint64_t i, count = 1000000, buffers;
+   uint16_t payload_size = 64;
+   uint32_t per_buffer = 4;
+   uint8_t *payload = NULL;
+   struct timespec start, end;
+   double ns;
+   pthread_t rx_thread;
+   struct rx_result rx = {0, 0};
+   trap_ifc_spec_t ifc_spec;
+   trap_input_ifc_t *in;
+   json_t *stats = NULL;
+   trap_counters_block_t *sum;
+   json_int_t recv_calls = 0, wait_calls = 0, readahead = 0;
+
+   ret = trap_parse_params(&argc, argv, &ifc_spec);
+   if (ret != TRAP_E_OK) {
+      if (ret == TRAP_E_HELP) {
+         help(argv[0]);
+         return 0;
+      }
+      fprintf(stderr, "ERROR in parsing of parameters for TRAP: %s\n", trap_last_error_msg);
+      return 1;
+   }
+
+   while ((opt = getopt(argc, argv, "hc:n:m:")) != ERRARG) {
+      switch (opt) {
+      case 'c':
+         sscanf(optarg, "%"SCNu64, &count);
+         break;
+      case 'n':
+         sscanf(optarg, "%"SCNu16, &payload_size);
+         break;
+      case 'm':
+         sscanf(optarg, "%"SCNu32, &per_buffer);
+         break;
+      case 'h':
+         help(argv[0]);
+         return 0;
+      }
+   }
+   if (payload_size < sizeof(uint64_t)) {
+      payload_size = sizeof(uint64_t);
+   }
+   if (per_buffer == 0) {
+      per_buffer = 1;
+   }
+
+   ctx = trap_ctx_init(&module_info, ifc_spec);
+   trap_free_ifc_spec(ifc_spec);
+   if (ctx == NULL || trap_ctx_get_last_error(ctx) != TRAP_E_OK) {
+      fprintf(stderr, "Trap_ctx_init failed.\n");
+      return 1;
+   }
+   trap_ctx_set_data_fmt(ctx, 0, TRAP_FMT_RAW);
+   trap_ctx_set_required_fmt(ctx, 0, TRAP_FMT_RAW);
+   trap_ctx_ifcctl(ctx, TRAPIFC_OUTPUT, 0, TRAPCTL_SETTIMEOUT, TRAP_WAIT);
+   trap_ctx_ifcctl(ctx, TRAPIFC_INPUT, 0, TRAPCTL_SETTIMEOUT, TRAP_WAIT);
+
+   payload = (uint8_t *) calloc(1, payload_size);
+   if (payload == NULL) {
+      fprintf(stderr, "Allocation of payload buffer failed.\n");
+      ret = 1;
+      goto exit;
+   }
+   if (pthread_create(&rx_thread, NULL, receiver_thr, &rx) != 0) {
+      fprintf(stderr, "Creation of receiver thread failed.\n");
+      ret = 1;
+      goto exit;
+   }
+
+   clock_gettime(CLOCK_MONOTONIC, &start);
+   for (i = 0; i < count; i++) {
+      *((uint64_t *) payload) = i;
+      ret = trap_ctx_send(ctx, 0, payload, payload_size);
+      if (ret != TRAP_E_OK) {
+         fprintf(stderr, "trap_ctx_send() failed: %d\n", ret);
+         break;
+      }
+      /* small buffers like those of a low-rate autoflushed stream */
+      if ((i + 1) % per_buffer == 0) {
+         trap_ctx_send_flush(ctx, 0);
+      }
+   }
+   /* ending message */
+   trap_ctx_send(ctx, 0, payload, 1);
+   trap_ctx_send_flush(ctx, 0);
+   pthread_join(rx_thread, NULL);
+   clock_gettime(CLOCK_MONOTONIC, &end);
+   ns = elapsed_ns(&start, &end);
+
+   /* syscall counters of the input IFC (tcpip_receiver_get_stats()) */
+   in = &((trap_ctx_priv_t *) ctx)->in_ifc_list[0];
+   if (in->get_stats != NULL) {
+      stats = in->get_stats(in->priv);
+   }
+   if ((stats == NULL) || (json_unpack(stats, "{sIsIsI}", "readahead", &readahead,
+                                       "recv-calls", &recv_calls, "wait-calls", &wait_calls) != 0)) {
+      fprintf(stderr, "Input IFC does not provide syscall counters.\n");
+   }
+   json_decref(stats);
+   sum = trap_counters_sum(&((trap_ctx_priv_t *) ctx)->counters);
+   buffers = (sum != NULL) ? sum->in[0].buffers : 0;
+   free(sum);
+
+   printf("Messages: %"PRIu64" x %"PRIu16" B in %"PRIu64" buffers, received %"PRIu64", lost %"PRIu64"\n"
+          "Time: %.3f s, %.2f Mmsg/s, %.0f buffers/s\n"
+          "Read-ahead: %"PRId64" B, recv(): %"PRId64", wait: %"PRId64", syscalls per buffer: %.2f\n",
+          count, payload_size, buffers, rx.received, rx.lost,
+          ns / 1e9, rx.received / ns * 1e3, buffers / ns * 1e9,
+          (int64_t) readahead, (int64_t) recv_calls, (int64_t) wait_calls,
+          (buffers != 0) ? (double) (recv_calls + wait_calls) / buffers : 0.0);
+   ret = (rx.received == count) ? 0 : 1;
+
+exit:
+   trap_ctx_finalize(&ctx);
+   free(payload);
+   return ret;
+}
@@ -65,6 +65,7 @@ trap_module_info_t module_info = {
 static char stop = 0;
 static char start_tx_first = 0;
 static char enable_buffering = 0;
+static int wait_clients = 0;
 trap_ctx_t *ctx = NULL;
 
 void signal_handler(int signal)
@@ -78,11 +79,78 @@ void signal_handler(int signal)
 
 void help(const char *progname)
 {
-   printf("%s -i ifcspec [-bhs] -n [number]\n"
+   printf("%s -i ifcspec [-bhs] -n [number] [-m count] [-w clients]\n"
           "\t-i\tlibtrap IFC spec\n"
           "\t-n\tnumber - size of data to send for testing\n"
           "\t-s\toptional parameter to start sending at first.\n"
-          "\t-b\tenable buffering.\n", progname);
+          "\t-b\tenable buffering.\n"
+          "\t-m\tstream mode: sender (-s) sends count messages without waiting for replies,\n"
+          "\t\tthe other side receives them, both print rate (use -b, e.g. to compare setter bufsize).\n"
+          "\t-w\tstream mode: sender waits for the given number of connected clients before sending.\n", progname);
+}
+
+static double now_s(void)
+{
+   struct timespec ts;
+
+   clock_gettime(CLOCK_MONOTONIC, &ts);
+   return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/**
+ * Stream mode: send count messages as fast as possible, or receive them until termination message.
+ */
+static int stream(uint64_t count, char *payload, uint16_t payload_size)
+{
+   const void *recv_payload;
+   uint16_t recv_payload_size;
+   uint64_t messages = 0, disorder = 0;
+   double start = 0;
+   int ret = TRAP_E_OK;
+
+   if (start_tx_first == 1) {
+      while ((stop == 0) && (trap_ctx_get_client_count(ctx, 0) < wait_clients)) {
+         usleep(10000);
+      }
+      start = now_s();
+      for (messages = 0; (messages < count) && (stop == 0); messages++) {
+         *((uint64_t *) payload) = messages;
+         ret = trap_ctx_send(ctx, 0, (void *) payload, payload_size);
+         if (ret != TRAP_E_OK) {
+            fprintf(stderr, "ERROR in sending data. %d\n", ret);
+            break;
+         }
+      }
+      /* termination message */
+      trap_ctx_send(ctx, 0, (void *) payload, 1);
+      trap_ctx_send_flush(ctx, 0);
+   } else {
+      while (stop == 0) {
+         ret = trap_ctx_recv(ctx, 0, &recv_payload, &recv_payload_size);
+         if (ret != TRAP_E_OK) {
+            fprintf(stderr, "ERROR in getting data. %d\n", ret);
+            break;
+         }
+         if (recv_payload_size <= 1) {
+            break;
+         }
+         if (*((const uint64_t *) recv_payload) != messages) {
+            disorder++;
+         }
+         if (messages++ == 0) {
+            start = now_s();
+         }
+      }
+   }
+   start = now_s() - start;
+   printf("%s %"PRIu64" messages of %"PRIu16" B in %.3f s: %.0f msg/s, %.1f MB/s\n",
+          (start_tx_first == 1) ? "Sent" : "Received", messages, payload_size, start,
+          messages / start, messages * payload_size / start / 1e6);
+   if (disorder != 0) {
+      printf("%"PRIu64" messages out of sequence\n", disorder);
+      return 1;
+   }
+   return (ret == TRAP_E_OK) ? 0 : 1;
 }
 
 int main(int argc, char **argv)
@@ -90,11 +158,11 @@ int main(int argc, char **argv)
    int ret;
 
    uint64_t counter = 0, rxcounter = 0;
-   uint64_t iteration = 0, limit = 100;
+   uint64_t iteration = 0, limit = 100, stream_count = 0;
    time_t duration;
    uint16_t payload_size = sizeof(counter);
 
-   const char *options = "hbn:s";
+   const char *options = "hbn:sm:w:";
    char opt;
 
    char *payload = NULL;
@@ -147,6 +215,12 @@ int main(int argc, char **argv)
          case 'b':
             enable_buffering = 1;
             break;
+         case 'm':
+            sscanf(optarg, "%"SCNu64, &stream_count);
+            break;
+         case 'w':
+            wait_clients = atoi(optarg);
+            break;
          }
       }
    }
@@ -167,6 +241,13 @@ int main(int argc, char **argv)
       return 1;
    }
 
+   if (stream_count != 0) {
+      ret = stream(stream_count, payload, payload_size);
+      trap_ctx_finalize(&ctx);
+      free(payload);
+      return ret;
+   }
+
    // Read data from input, process them and write to output
    while(!stop) {
       if (send == 1) {
@@ -0,0 +1,191 @@
+/**
+ * \file test_send_reserve.c
+ * \brief Benchmark: per-message cost of trap_ctx_send() vs. trap_ctx_send_reserve()/commit()
+ */
+/*
+ * Copyright (C) 2026 CESNET
+ *
+ * LICENSE TERMS
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name of the Company nor the names of its contributors
+ *    may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ *
+ * ALTERNATIVELY, provided that this notice is retained in full, this
+ * product may be distributed under the terms of the GNU General Public
+ * License (GPL) version 2 or later, in which case the provisions
+ * of the GPL apply INSTEAD OF those given above.
+ *
+ * This software is provided ``as is'', and any express or implied
+ * warranties, including, but not limited to, the implied warranties of
+ * merchantability and fitness for a particular purpose are disclaimed.
+ * In no event shall the company or contributors be liable for any
+ * direct, indirect, incidental, special, exemplary, or consequential
+ * damages (including, but not limited to, procurement of substitute
+ * goods or services; loss of use, data, or profits; or business
+ * interruption) however caused and on any theory of liability, whether
+ * in contract, strict liability, or tort (including negligence or
+ * otherwise) arising in any way out of the use of this software, even
+ * if advised of the possibility of such damage.
+ *
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <getopt.h>
+#include <unistd.h>
+#include <stdint.h>
+#include <inttypes.h>
+#include <libtrap/trap.h>
+
+#define ERRARG -1
+
+// Struct with information about module
+trap_module_info_t module_info = {
+   "Zero-copy send benchmark", // Module name
+   // Module description
+   "Compare trap_ctx_send() with trap_ctx_send_reserve()/trap_ctx_send_commit().\n",
+   0, // Number of input interfaces
+   1, // Number of output interfaces
+};
+
+void help(const char *progname)
+{
+   printf("%s -i ifcspec [-h] [-c count] [-n size]\n"
+          "\t-i\tlibtrap IFC spec, e.g. f:/dev/null or b:\n"
+          "\t-c\tnumber of messages sent by each method (default 10000000)\n"
+          "\t-n\tsize of message in bytes (default 100)\n"
+          "Note: the blackhole IFC (b:) bypasses the buffering layer, trap_ctx_send() does\n"
+          "not copy anything there; use f:/dev/null to measure the whole buffering path.\n",
+          progname);
+}
+
+/**
+ * Fill message as a module would do it, e.g. UniRec record of a flow.
+ */
+static inline void build_record(uint8_t *rec, uint16_t size, uint64_t seq)
+{
+   uint16_t i;
+   *((uint64_t *) rec) = seq;
+   for (i = sizeof(seq); i < size; i++) {
+      rec[i] = (uint8_t) (seq + i);
+   }
+}
+
+static double elapsed_ns(const struct timespec *start, const struct timespec *end)
+{
+   return (end->tv_sec - start->tv_sec) * 1e9 + (end->tv_nsec - start->tv_nsec);
+}
+
+int main(int argc, char **argv)
+{
+   int ret;
+   signed char opt;
+   uint64_t i, count = 10000000;
+   uint16_t payload_size = 100;
+   uint8_t *scratch = NULL;
+   void *ptr;
+   struct timespec start, end;
+   double copy_ns, reserve_ns;
+   trap_ctx_t *ctx = NULL;
+   trap_ifc_spec_t ifc_spec;
+
+   ret = trap_parse_params(&argc, argv, &ifc_spec);
+   if (ret != TRAP_E_OK) {
+      if (ret == TRAP_E_HELP) {
+         help(argv[0]);
+         return 0;
+      }
+      fprintf(stderr, "ERROR in parsing of parameters for TRAP: %s\n", trap_last_error_msg);
+      return 1;
+   }
+
+   while ((opt = getopt(argc, argv, "hc:n:")) != ERRARG) {
+      switch (opt) {
+      case 'c':
+         sscanf(optarg, "%"SCNu64, &count);
+         break;
+      case 'n':
+         sscanf(optarg, "%"SCNu16, &payload_size);
+         break;
+      case 'h':
+         help(argv[0]);
+         return 0;
+      }
+   }
+   if (payload_size < sizeof(uint64_t)) {
+      payload_size = sizeof(uint64_t);
+   }
+
+   ctx = trap_ctx_init(&module_info, ifc_spec);
+   trap_free_ifc_spec(ifc_spec);
+   if (ctx == NULL || trap_ctx_get_last_error(ctx) != TRAP_E_OK) {
+      fprintf(stderr, "Trap_ctx_init failed.\n");
+      return 1;
+   }
+   trap_ctx_set_data_fmt(ctx, 0, TRAP_FMT_RAW);
+   trap_ctx_ifcctl(ctx, TRAPIFC_OUTPUT, 0, TRAPCTL_SETTIMEOUT, TRAP_WAIT);
+
+   scratch = (uint8_t *) calloc(1, payload_size);
+   if (scratch == NULL) {
+      fprintf(stderr, "Allocation of payload buffer failed.\n");
+      ret = 1;
+      goto exit;
+   }
+
+   /* build record in own memory and let libtrap copy it */
+   clock_gettime(CLOCK_MONOTONIC, &start);
+   for (i = 0; i < count; i++) {
+      build_record(scratch, payload_size, i);
+      ret = trap_ctx_send(ctx, 0, scratch, payload_size);
+      if (ret != TRAP_E_OK) {
+         fprintf(stderr, "trap_ctx_send() failed: %d\n", ret);
+         goto exit;
+      }
+   }
+   trap_ctx_send_flush(ctx, 0);
+   clock_gettime(CLOCK_MONOTONIC, &end);
+   copy_ns = elapsed_ns(&start, &end);
+
+   /* build record directly in output buffer */
+   clock_gettime(CLOCK_MONOTONIC, &start);
+   for (i = 0; i < count; i++) {
+      ret = trap_ctx_send_reserve(ctx, 0, payload_size, &ptr);
+      if (ret != TRAP_E_OK) {
+         fprintf(stderr, "trap_ctx_send_reserve() failed: %d\n", ret);
+         goto exit;
+      }
+      build_record((uint8_t *) ptr, payload_size, i);
+      ret = trap_ctx_send_commit(ctx, 0, payload_size);
+      if (ret != TRAP_E_OK) {
+         fprintf(stderr, "trap_ctx_send_commit() failed: %d\n", ret);
+         goto exit;
+      }
+   }
+   trap_ctx_send_flush(ctx, 0);
+   clock_gettime(CLOCK_MONOTONIC, &end);
+   reserve_ns = elapsed_ns(&start, &end);
+
+   printf("Messages: %"PRIu64" x %"PRIu16" B\n"
+          "send:           %8.2f ns/msg (%.2f Mmsg/s)\n"
+          "reserve/commit: %8.2f ns/msg (%.2f Mmsg/s)\n",
+          count, payload_size,
+          copy_ns / count, count / copy_ns * 1e3,
+          reserve_ns / count, count / reserve_ns * 1e3);
+   ret = 0;
+
+exit:
+   trap_ctx_finalize(&ctx);
+   free(scratch);
+   return ret;
+}
@@ -0,0 +1,155 @@
+/**
+ * \file test_service_stats.c
+ * \brief Print counters of a running module obtained from its service IFC.
+ * Output is line oriented to be easily parsed by test scripts:
+ *   in IFC messages N
+ *   out IFC sent-messages N lag-disconnects N
+ *   out IFC client ID lag N max-lag N sent-buffers N dropped-buffers N
+ */
+/*
+ * Copyright (C) 2026 CESNET
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name of the Company nor the names of its contributors
+ *    may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ *
+ * ALTERNATIVELY, provided that this notice is retained in full, this
+ * product may be distributed under the terms of the GNU General Public
+ * License (GPL) version 2 or later, in which case the provisions
+ * of the GPL apply INSTEAD OF those given above.
+ *
+ * This software is provided ``as is'', and any express or implied
+ * warranties, including, but not limited to, the implied warranties of
+ * merchantability and fitness for a particular purpose are disclaimed.
+ * In no event shall the company or contributors be liable for any
+ * direct, indirect, incidental, special, exemplary, or consequential
+ * damages (including, but not limited to, procurement of substitute
+ * goods or services; loss of use, data, or profits; or business
+ * interruption) however caused and on any theory of liability, whether
+ * in contract, strict liability, or tort (including negligence or
+ * otherwise) arising in any way out of the use of this software, even
+ * if advised of the possibility of such damage.
+ *
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <stdint.h>
+#include <inttypes.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/time.h>
+#include "trap_internal.h"
+#include "ifc_tcpip.h"
+
+/* Header sent before data in service interface, see service_thread_routine() */
+typedef struct msg_header_s {
+   uint8_t com;
+   uint32_t data_size;
+} msg_header_t;
+
+static int recv_all(int sd, void *data, size_t size)
+{
+   size_t total = 0;
+   ssize_t n;
+
+   while (total < size) {
+      n = recv(sd, (char *) data + total, size - total, 0);
+      if (n <= 0) {
+         return -1;
+      }
+      total += n;
+   }
+   return 0;
+}
+
+static json_int_t get_int(json_t *obj, const char *key)
+{
+   return json_integer_value(json_object_get(obj, key));
+}
+
+int main(int argc, char **argv)
+{
+   struct sockaddr_un addr;
+   struct timeval tv = {5, 0};
+   msg_header_t header;
+   json_t *stats, *ifc, *cl;
+   json_error_t error;
+   size_t i, j;
+   char sock_spec[32];
+   char *data;
+   int sd;
+
+   if (argc != 2) {
+      fprintf(stderr, "Usage: %s PID\n", argv[0]);
+      return 1;
+   }
+
+   memset(&addr, 0, sizeof(addr));
+   addr.sun_family = AF_UNIX;
+   snprintf(sock_spec, sizeof(sock_spec), "service_%s", argv[1]);
+   snprintf(addr.sun_path, sizeof(addr.sun_path), UNIX_PATH_FILENAME_FORMAT, sock_spec);
+
+   sd = socket(AF_UNIX, SOCK_STREAM, 0);
+   if (sd == -1) {
+      perror("socket");
+      return 1;
+   }
+   setsockopt(sd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+   if (connect(sd, (struct sockaddr *) &addr, sizeof(addr)) == -1) {
+      fprintf(stderr, "Could not connect to %s\n", addr.sun_path);
+      close(sd);
+      return 1;
+   }
+
+   memset(&header, 0, sizeof(header));
+   header.com = SERVICE_GET_COM;
+   if ((send(sd, &header, sizeof(header), 0) != sizeof(header)) ||
+       (recv_all(sd, &header, sizeof(header)) != 0) || (header.com != SERVICE_OK_REPLY)) {
+      fprintf(stderr, "Request of counters failed.\n");
+      close(sd);
+      return 1;
+   }
+   data = (char *) calloc(1, header.data_size + 1);
+   if ((data == NULL) || (recv_all(sd, data, header.data_size) != 0)) {
+      fprintf(stderr, "Receiving of counters failed.\n");
+      free(data);
+      close(sd);
+      return 1;
+   }
+   close(sd);
+
+   stats = json_loads(data, 0, &error);
+   free(data);
+   if (stats == NULL) {
+      fprintf(stderr, "Could not parse counters: %s\n", error.text);
+      return 1;
+   }
+   json_array_foreach(json_object_get(stats, "in"), i, ifc) {
+      printf("in %d messages %" PRIu64 "\n", (int) i, (uint64_t) get_int(ifc, "messages"));
+   }
+   json_array_foreach(json_object_get(stats, "out"), i, ifc) {
+      printf("out %d sent-messages %" PRIu64 " lag-disconnects %" PRIu64 "\n", (int) i,
+             (uint64_t) get_int(ifc, "sent-messages"), (uint64_t) get_int(ifc, "lag-disconnects"));
+      json_array_foreach(json_object_get(ifc, "clients"), j, cl) {
+         printf("out %d client %d lag %" PRIu64 " max-lag %" PRIu64 " sent-buffers %" PRIu64
+                " dropped-buffers %" PRIu64 "\n", (int) i, (int) get_int(cl, "id"),
+                (uint64_t) get_int(cl, "lag"), (uint64_t) get_int(cl, "max-lag"),
+                (uint64_t) get_int(cl, "sent-buffers"), (uint64_t) get_int(cl, "dropped-buffers"));
+      }
+   }
+   json_decref(stats);
+
+   return 0;
+}
+
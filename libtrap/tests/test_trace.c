@@ -0,0 +1,314 @@
+/**
+ * \file test_trace.c
+ * \brief Test of latency tracing across a chain of modules
+ */
+/*
+ * Copyright (C) 2026 CESNET
+ *
+ * LICENSE TERMS
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name of the Company nor the names of its contributors
+ *    may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ *
+ * ALTERNATIVELY, provided that this notice is retained in full, this
+ * product may be distributed under the terms of the GNU General Public
+ * License (GPL) version 2 or later, in which case the provisions
+ * of the GPL apply INSTEAD OF those given above.
+ *
+ * This software is provided ``as is'', and any express or implied
+ * warranties, including, but not limited to, the implied warranties of
+ * merchantability and fitness for a particular purpose are disclaimed.
+ * In no event shall the company or contributors be liable for any
+ * direct, indirect, incidental, special, exemplary, or consequential
+ * damages (including, but not limited to, procurement of substitute
+ * goods or services; loss of use, data, or profits; or business
+ * interruption) however caused and on any theory of liability, whether
+ * in contract, strict liability, or tort (including negligence or
+ * otherwise) arising in any way out of the use of this software, even
+ * if advised of the possibility of such damage.
+ *
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <stdint.h>
+#include <inttypes.h>
+#include <pthread.h>
+#include <time.h>
+#include <libtrap/trap.h>
+#include "trap_internal.h"
+#include "trap_counters.h"
+
+#define MESSAGES 20000      ///< Number of messages sent through the chain
+#define MSG_SIZE 100        ///< Size of messages
+#define WAIT_SEC 10         ///< Time limit of connecting and receiving (seconds)
+
+trap_module_info_t src_module_info = {
+   "Trace test source", // Module name
+   // Module description
+   "\n",
+   0, // Number of input interfaces
+   1, // Number of output interfaces
+};
+
+trap_module_info_t fwd_module_info = {
+   "Trace test forwarder", // Module name
+   // Module description
+   "\n",
+   1, // Number of input interfaces
+   1, // Number of output interfaces
+};
+
+trap_module_info_t dst_module_info = {
+   "Trace test destination", // Module name
+   // Module description
+   "\n",
+   1, // Number of input interfaces
+   0, // Number of output interfaces
+};
+
+struct module_arg {
+   trap_ctx_t *ctx;
+   uint32_t received;
+   int errors;
+};
+
+static trap_ctx_t *init_ctx(trap_module_info_t *info, char *ifc)
+{
+   char *argv[] = {"test", "-i", ifc};
+   int argc = 3;
+   trap_ifc_spec_t ifc_spec;
+   trap_ctx_t *ctx;
+
+   if (trap_parse_params(&argc, argv, &ifc_spec) != TRAP_E_OK) {
+      fprintf(stderr, "Error in parsing of parameters for TRAP: %s\n", trap_last_error_msg);
+      return NULL;
+   }
+   ctx = trap_ctx_init(info, ifc_spec);
+   trap_free_ifc_spec(ifc_spec);
+   if ((ctx != NULL) && (trap_ctx_get_last_error(ctx) != TRAP_E_OK)) {
+      fprintf(stderr, "Error in TRAP initialization: %s\n", trap_ctx_get_last_error_msg(ctx));
+      trap_ctx_finalize(&ctx);
+      return NULL;
+   }
+   return ctx;
+}
+
+static double now_s(void)
+{
+   struct timespec ts;
+
+   clock_gettime(CLOCK_MONOTONIC, &ts);
+   return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/**
+ * Forwarding module: send every received message to the output IFC.
+ */
+static void *forwarder(void *arg)
+{
+   struct module_arg *m = (struct module_arg *) arg;
+   const void *data;
+   uint16_t size;
+   double start = now_s();
+   int ret;
+
+   while ((m->received < MESSAGES) && (now_s() - start < WAIT_SEC)) {
+      ret = trap_ctx_recv(m->ctx, 0, &data, &size);
+      if (ret == TRAP_E_TIMEOUT) {
+         continue;
+      }
+      TRAP_DEFAULT_RECV_ERROR_HANDLING(ret, continue, break);
+      m->received++;
+      if (trap_ctx_send(m->ctx, 0, data, size) != TRAP_E_OK) {
+         m->errors++;
+         break;
+      }
+   }
+   trap_ctx_send_flush(m->ctx, 0);
+   return NULL;
+}
+
+/**
+ * Destination module: check sequence numbers of messages.
+ */
+static void *destination(void *arg)
+{
+   struct module_arg *m = (struct module_arg *) arg;
+   const void *data;
+   uint16_t size;
+   uint32_t seq;
+   double start = now_s();
+   int ret;
+
+   while ((m->received < MESSAGES) && (now_s() - start < WAIT_SEC)) {
+      ret = trap_ctx_recv(m->ctx, 0, &data, &size);
+      if (ret == TRAP_E_TIMEOUT) {
+         continue;
+      }
+      TRAP_DEFAULT_RECV_ERROR_HANDLING(ret, continue, break);
+      memcpy(&seq, data, sizeof(seq));
+      if ((size != MSG_SIZE) || (seq != m->received)) {
+         if (m->errors++ == 0) {
+            fprintf(stderr, "Message %"PRIu32" is corrupted (size %"PRIu16", sequence %"PRIu32").\n", m->received, size, seq);
+         }
+      }
+      m->received++;
+   }
+   return NULL;
+}
+
+/**
+ * Check traced latency of the destination against the sum of its hops.
+ *
+ * \return number of errors
+ */
+static int check_hops(trap_ctx_t *ctx)
+{
+   trap_counters_block_t *sum = trap_counters_sum(&((trap_ctx_priv_t *) ctx)->counters);
+   trap_in_counters_t *in;
+   uint64_t hops_sum;
+   json_t *json;
+   int errors = 0;
+
+   if (sum == NULL) {
+      fprintf(stderr, "Sum of counters failed.\n");
+      return 1;
+   }
+   in = &sum->in[0];
+   printf("Received %"PRIu64" buffers, latency %"PRIu64" us, hops %"PRIu64" + %"PRIu64" + %"PRIu64" us\n",
+          in->buffers, in->latency.sum, in->hop_link[0].sum, in->hop_module[0].sum, in->hop_link[1].sum);
+   if ((in->buffers == 0) || (in->latency.count != in->buffers) || (in->hop_link[0].count != in->buffers) ||
+       (in->hop_module[0].count != in->buffers) || (in->hop_link[1].count != in->buffers) ||
+       (in->hop_link[2].count != 0) || (in->hop_module[1].count != 0)) {
+      fprintf(stderr, "Every buffer should be traced over exactly one forwarding module.\n");
+      errors++;
+   }
+   hops_sum = in->hop_link[0].sum + in->hop_module[0].sum + in->hop_link[1].sum;
+   if (hops_sum != in->latency.sum) {
+      fprintf(stderr, "Latency %"PRIu64" us differs from sum of hops %"PRIu64" us.\n", in->latency.sum, hops_sum);
+      errors++;
+   }
+
+   json = trap_counters_in_json(in);
+   if ((json == NULL) || (json_array_size(json_object_get(json, "hops")) != 2) ||
+       (json_object_get(json, "latency-us") == NULL)) {
+      fprintf(stderr, "Trace is not encoded for service IFC.\n");
+      errors++;
+   }
+   json_decref(json);
+   free(sum);
+   return errors;
+}
+
+int main(int argc, char **argv)
+{
+   char ifc_src[64], ifc_fwd[128], ifc_dst[64];
+   char msg[MSG_SIZE];
+   trap_ctx_t *src = NULL;
+   struct module_arg fwd, dst;
+   pthread_t fwd_thread, dst_thread;
+   int fwd_started = 0, dst_started = 0, errors = 1;
+   uint32_t i;
+   double start;
+
+   memset(&fwd, 0, sizeof(fwd));
+   memset(&dst, 0, sizeof(dst));
+   memset(msg, 0, sizeof(msg));
+   snprintf(ifc_src, sizeof(ifc_src), "u:test_trace_a_%d:trace=on", (int) getpid());
+   snprintf(ifc_fwd, sizeof(ifc_fwd), "u:test_trace_a_%d,u:test_trace_b_%d:trace=on", (int) getpid(), (int) getpid());
+   snprintf(ifc_dst, sizeof(ifc_dst), "u:test_trace_b_%d", (int) getpid());
+
+   src = init_ctx(&src_module_info, ifc_src);
+   if (src == NULL) {
+      return EXIT_FAILURE;
+   }
+   trap_ctx_set_data_fmt(src, 0, TRAP_FMT_RAW);
+   trap_ctx_ifcctl(src, TRAPIFC_OUTPUT, 0, TRAPCTL_SETTIMEOUT, TRAP_WAIT);
+
+   fwd.ctx = init_ctx(&fwd_module_info, ifc_fwd);
+   dst.ctx = init_ctx(&dst_module_info, ifc_dst);
+   if ((fwd.ctx == NULL) || (dst.ctx == NULL)) {
+      goto finalize;
+   }
+   trap_ctx_set_required_fmt(fwd.ctx, 0, TRAP_FMT_RAW);
+   trap_ctx_set_data_fmt(fwd.ctx, 0, TRAP_FMT_RAW);
+   trap_ctx_ifcctl(fwd.ctx, TRAPIFC_INPUT, 0, TRAPCTL_SETTIMEOUT, 100000);
+   trap_ctx_ifcctl(fwd.ctx, TRAPIFC_OUTPUT, 0, TRAPCTL_SETTIMEOUT, TRAP_WAIT);
+   trap_ctx_set_required_fmt(dst.ctx, 0, TRAP_FMT_RAW);
+   trap_ctx_ifcctl(dst.ctx, TRAPIFC_INPUT, 0, TRAPCTL_SETTIMEOUT, 100000);
+
+   if (pthread_create(&fwd_thread, NULL, forwarder, &fwd) != 0) {
+      fprintf(stderr, "Creation of forwarder thread failed.\n");
+      goto finalize;
+   }
+   fwd_started = 1;
+   if (pthread_create(&dst_thread, NULL, destination, &dst) != 0) {
+      fprintf(stderr, "Creation of destination thread failed.\n");
+      goto finalize;
+   }
+   dst_started = 1;
+
+   start = now_s();
+   while ((trap_ctx_get_client_count(src, 0) < 1) || (trap_ctx_get_client_count(fwd.ctx, 0) < 1)) {
+      if (now_s() - start > WAIT_SEC) {
+         fprintf(stderr, "Modules did not connect.\n");
+         goto finalize;
+      }
+      usleep(10000);
+   }
+
+   for (i = 0; i < MESSAGES; i++) {
+      memcpy(msg, &i, sizeof(i));
+      if (trap_ctx_send(src, 0, msg, sizeof(msg)) != TRAP_E_OK) {
+         fprintf(stderr, "Sending of message %"PRIu32" failed.\n", i);
+         goto finalize;
+      }
+   }
+   trap_ctx_send_flush(src, 0);
+   pthread_join(fwd_thread, NULL);
+   fwd_started = 0;
+   pthread_join(dst_thread, NULL);
+   dst_started = 0;
+
+   errors = fwd.errors + dst.errors;
+   if ((fwd.received != MESSAGES) || (dst.received != MESSAGES)) {
+      fprintf(stderr, "Forwarder received %"PRIu32" and destination %"PRIu32" messages, expected %d.\n",
+              fwd.received, dst.received, MESSAGES);
+      errors++;
+   }
+   errors += check_hops(dst.ctx);
+
+finalize:
+   if (fwd_started != 0) {
+      trap_ctx_terminate(fwd.ctx);
+      pthread_join(fwd_thread, NULL);
+   }
+   if (dst_started != 0) {
+      trap_ctx_terminate(dst.ctx);
+      pthread_join(dst_thread, NULL);
+   }
+   if (dst.ctx != NULL) {
+      trap_ctx_finalize(&dst.ctx);
+   }
+   if (fwd.ctx != NULL) {
+      trap_ctx_finalize(&fwd.ctx);
+   }
+   trap_ctx_finalize(&src);
+   if (errors != 0) {
+      fprintf(stderr, "%d errors.\n", errors);
+      return EXIT_FAILURE;
+   }
+   return EXIT_SUCCESS;
+}
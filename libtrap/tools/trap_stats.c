@@ -45,12 +45,14 @@
 #include <netdb.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <sys/un.h>
 #include <sys/types.h>
 #include <getopt.h>
 #include <errno.h>
 #include <inttypes.h>
 #include <signal.h>
+#include <time.h>
 
 #include "../include/libtrap/trap.h"
 
@@ -58,6 +60,10 @@
 #define SERVICE_SET_COM 11
 #define SERVICE_OK_REPLY 12
 
+#define HIST_BUCKETS 32 ///< Buckets of histograms sent by libtrap (powers of two)
+#define FILL_BUCKETS 10 ///< Buckets of fill ratio of buffers (10 % each)
+#define TRACE_HOPS 9 ///< Hops of traced latency sent by libtrap (8 forwarding modules and the last link)
+
 typedef struct service_msg_header_s {
    uint8_t com;
    uint32_t data_size;
@@ -68,9 +74,27 @@ union tcpip_socket_addr {
    struct sockaddr_un unix_addr; ///< used for path of UNIX socket
 };
 
+/**
+ * Counters of one IFC from the previous request, rates and percentiles are
+ * computed from the difference.
+ */
+typedef struct ifc_sample_s {
+   uint64_t messages;
+   uint64_t bytes;
+   uint64_t wait[HIST_BUCKETS];    ///< Histogram of time spent in send()/recv() (ns)
+   uint64_t latency[HIST_BUCKETS]; ///< Histogram of delivery latency (us), input IFC only
+   uint64_t fill[FILL_BUCKETS];    ///< Histogram of fill ratio of sent buffers, output IFC only
+   uint64_t hop_link[TRACE_HOPS][HIST_BUCKETS];   ///< Histograms of traced delay of links (us), input IFC only
+   uint64_t hop_module[TRACE_HOPS][HIST_BUCKETS]; ///< Histograms of traced delay in modules (us), input IFC only
+} ifc_sample_t;
+
 /**************************/
 
 uint8_t prog_terminated = 0;
+ifc_sample_t *prev_in = NULL, *prev_out = NULL;
+size_t prev_in_count = 0, prev_out_count = 0;
+double prev_time = 0.0;
+double sample_time = 0.0;
 int sd = -1;
 char * dest_sock = NULL;
 
@@ -96,6 +120,245 @@ int connect_to_module_service_ifc()
    }
 }
 
+/**
+ * Print counters of compression of buffers if the interface uses it.
+ *
+ * \param[in] ifc_cnts  json object with counters of one interface
+ */
+void print_compress_cnts(json_t *ifc_cnts)
+{
+   json_t *codec = json_object_get(ifc_cnts, "codec");
+
+   if (codec == NULL) {
+      return;
+   }
+   printf("\t        codec: %s, ratio: %.2f, CPU: %" PRIu64 " us\n", json_string_value(codec),
+          json_real_value(json_object_get(ifc_cnts, "compress-ratio")),
+          (uint64_t) json_integer_value(json_object_get(ifc_cnts, "codec-cpu-us")));
+}
+
+/**
+ * Read json array of counters, missing items are zero.
+ *
+ * \param[in] arr  json array
+ * \param[out] values  counters
+ * \param[in] count  size of values
+ */
+void read_array(json_t *arr, uint64_t *values, size_t count)
+{
+   size_t i;
+
+   memset(values, 0, count * sizeof(uint64_t));
+   for (i = 0; (i < count) && (i < json_array_size(arr)); i++) {
+      values[i] = json_integer_value(json_array_get(arr, i));
+   }
+}
+
+/**
+ * Read counters of IFC needed for rates and percentiles.
+ *
+ * \param[in] ifc_cnts  json object with counters of one interface
+ * \param[in] msg_key  key of counter of messages
+ * \param[out] s  counters
+ */
+void read_sample(json_t *ifc_cnts, const char *msg_key, ifc_sample_t *s)
+{
+   json_t *hops;
+   size_t i;
+
+   s->messages = json_integer_value(json_object_get(ifc_cnts, msg_key));
+   s->bytes = json_integer_value(json_object_get(ifc_cnts, "bytes"));
+   read_array(json_object_get(json_object_get(ifc_cnts, "wait-ns"), "buckets"), s->wait, HIST_BUCKETS);
+   read_array(json_object_get(json_object_get(ifc_cnts, "latency-us"), "buckets"), s->latency, HIST_BUCKETS);
+   read_array(json_object_get(ifc_cnts, "fill"), s->fill, FILL_BUCKETS);
+   hops = json_object_get(ifc_cnts, "hops");
+   for (i = 0; i < TRACE_HOPS; i++) {
+      read_array(json_object_get(json_object_get(json_array_get(hops, i), "link-us"), "buckets"), s->hop_link[i], HIST_BUCKETS);
+      read_array(json_object_get(json_object_get(json_array_get(hops, i), "module-us"), "buckets"), s->hop_module[i], HIST_BUCKETS);
+   }
+}
+
+/**
+ * Format upper bound of histogram bucket.
+ *
+ * \param[out] str  output string
+ * \param[in] size  size of str
+ * \param[in] bucket  index of bucket, -1 if there is no value
+ * \param[in] ns  1 if values are nanoseconds, 0 for microseconds
+ */
+void format_bucket(char *str, size_t size, int bucket, int ns)
+{
+   static const char *units[] = {"ns", "us", "ms", "s"};
+   double value;
+   int unit = ns ? 0 : 1;
+
+   if (bucket < 0) {
+      snprintf(str, size, "-");
+      return;
+   }
+   if (bucket == HIST_BUCKETS - 1) {
+      value = (double) (1ULL << bucket);
+   } else {
+      value = (double) (1ULL << (bucket + 1));
+   }
+   while ((value >= 1000.0) && (unit < 3)) {
+      value /= 1000.0;
+      unit++;
+   }
+   snprintf(str, size, "%s%.3g %s", (bucket == HIST_BUCKETS - 1) ? ">" : "<", value, units[unit]);
+}
+
+/**
+ * Find bucket of percentile of values added into histogram since the previous request.
+ *
+ * \param[in] cur  current histogram
+ * \param[in] prev  histogram of the previous request
+ * \param[in] p  percentile (0.0 - 1.0)
+ * \return index of bucket, -1 if no value was added
+ */
+int percentile(const uint64_t *cur, const uint64_t *prev, double p)
+{
+   uint64_t total = 0, sum = 0;
+   int i;
+
+   for (i = 0; i < HIST_BUCKETS; i++) {
+      total += cur[i] - prev[i];
+   }
+   if (total == 0) {
+      return -1;
+   }
+   for (i = 0; i < HIST_BUCKETS; i++) {
+      sum += cur[i] - prev[i];
+      if (sum >= p * total) {
+         break;
+      }
+   }
+   return (i < HIST_BUCKETS) ? i : HIST_BUCKETS - 1;
+}
+
+/**
+ * Print p50, p90 and p99 of histogram since the previous request.
+ *
+ * \param[in] name  name of histogram
+ * \param[in] cur  current histogram
+ * \param[in] prev  histogram of the previous request
+ * \param[in] ns  1 if values are nanoseconds, 0 for microseconds
+ */
+void print_percentiles(const char *name, const uint64_t *cur, const uint64_t *prev, int ns)
+{
+   char p50[16], p90[16], p99[16];
+
+   format_bucket(p50, sizeof(p50), percentile(cur, prev, 0.5), ns);
+   format_bucket(p90, sizeof(p90), percentile(cur, prev, 0.9), ns);
+   format_bucket(p99, sizeof(p99), percentile(cur, prev, 0.99), ns);
+   printf(", %s p50/p90/p99: %s / %s / %s", name, p50, p90, p99);
+}
+
+/**
+ * Check whether values were added into histogram since the previous request.
+ *
+ * \param[in] cur  current histogram
+ * \param[in] prev  histogram of the previous request
+ * \return 1 if the histogram changed, 0 otherwise
+ */
+int hist_changed(const uint64_t *cur, const uint64_t *prev)
+{
+   return (memcmp(cur, prev, HIST_BUCKETS * sizeof(uint64_t)) != 0);
+}
+
+/**
+ * Print rates and percentiles of IFC since the previous request.
+ *
+ * \param[in] cur  current counters
+ * \param[in] prev  counters of the previous request
+ * \param[in] input  1 for input IFC, 0 for output IFC
+ */
+void print_rates(const ifc_sample_t *cur, const ifc_sample_t *prev, int input)
+{
+   double interval = sample_time - prev_time;
+   uint64_t buffers = 0, fill = 0;
+   int i;
+
+   if ((prev_time == 0.0) || (interval <= 0.0) || (cur->messages < prev->messages)) {
+      /* the first request or the module was restarted */
+      return;
+   }
+   printf("\t        rate: %.1f msg/s, %.3f MB/s", (cur->messages - prev->messages) / interval,
+          (cur->bytes - prev->bytes) / interval / 1e6);
+   if (input == 0) {
+      for (i = 0; i < FILL_BUCKETS; i++) {
+         buffers += cur->fill[i] - prev->fill[i];
+         fill += (cur->fill[i] - prev->fill[i]) * (i * 10 + 5);
+      }
+      if (buffers != 0) {
+         printf(", fill: %"PRIu64" %%", fill / buffers);
+      }
+   }
+   print_percentiles(input ? "recv wait" : "send wait", cur->wait, prev->wait, 1);
+   if (input && hist_changed(cur->latency, prev->latency)) {
+      print_percentiles("latency", cur->latency, prev->latency, 0);
+   }
+   printf("\n");
+   for (i = 0; input && (i < TRACE_HOPS) && hist_changed(cur->hop_link[i], prev->hop_link[i]); i++) {
+      /* hops of traced buffers, module delay is not known for the last link */
+      printf("\t        hop %d", i + 1);
+      print_percentiles("link", cur->hop_link[i], prev->hop_link[i], 0);
+      if (hist_changed(cur->hop_module[i], prev->hop_module[i])) {
+         print_percentiles("module", cur->hop_module[i], prev->hop_module[i], 0);
+      }
+      printf("\n");
+   }
+}
+
+/**
+ * Get stored counters of the previous request, resize the array when the
+ * number of IFCs changes.
+ *
+ * \param[in,out] arr  array of counters
+ * \param[in,out] count  size of array
+ * \param[in] idx  index of IFC
+ * \return counters of IFC, NULL on error
+ */
+ifc_sample_t *get_prev(ifc_sample_t **arr, size_t *count, size_t idx)
+{
+   ifc_sample_t *tmp;
+
+   if (idx >= *count) {
+      tmp = (ifc_sample_t *) realloc(*arr, (idx + 1) * sizeof(ifc_sample_t));
+      if (tmp == NULL) {
+         return NULL;
+      }
+      memset(tmp + *count, 0, (idx + 1 - *count) * sizeof(ifc_sample_t));
+      *arr = tmp;
+      *count = idx + 1;
+   }
+   return &(*arr)[idx];
+}
+
+/**
+ * Print rates of IFC and store its counters for the next request.
+ *
+ * \param[in] ifc_cnts  json object with counters of one interface
+ * \param[in] idx  index of IFC
+ * \param[in] input  1 for input IFC, 0 for output IFC
+ */
+void print_ifc_rates(json_t *ifc_cnts, size_t idx, int input)
+{
+   ifc_sample_t cur, *prev;
+
+   if (input) {
+      prev = get_prev(&prev_in, &prev_in_count, idx);
+   } else {
+      prev = get_prev(&prev_out, &prev_out_count, idx);
+   }
+   if (prev == NULL) {
+      return;
+   }
+   read_sample(ifc_cnts, input ? "messages" : "sent-messages", &cur);
+   print_rates(&cur, prev, input);
+   *prev = cur;
+}
+
 int decode_cnts_from_json(char **data)
 {
    size_t arr_idx = 0;
@@ -169,7 +432,10 @@ int decode_cnts_from_json(char **data)
       }
       ifc_cnts[buffers_idx] = json_integer_value(cnt);
 
-      printf("\tIFC %d> RM: %" PRIu64 ", RB: %" PRIu64 "\n", (int) arr_idx, ifc_cnts[msg_idx], ifc_cnts[buffers_idx]);
+      printf("\tIFC %d> RM: %" PRIu64 ", RB: %" PRIu64 ", BY: %" PRIu64 "\n", (int) arr_idx, ifc_cnts[msg_idx], ifc_cnts[buffers_idx],
+             (uint64_t) json_integer_value(json_object_get(in_ifc_cnts, "bytes")));
+      print_ifc_rates(in_ifc_cnts, arr_idx, 1);
+      print_compress_cnts(in_ifc_cnts);
       memset(ifc_cnts, 0, 2 * sizeof(uint64_t));
    }
 
@@ -228,11 +494,15 @@ int decode_cnts_from_json(char **data)
       }
       ifc_cnts[af_idx] = json_integer_value(cnt);
 
-      printf("\tIFC %d> SM: %" PRIu64 ", DM: %" PRIu64 ", SB: %" PRIu64 ", AF: %" PRIu64 "\n", (int) arr_idx, ifc_cnts[msg_idx], ifc_cnts[dropped_msg_idx], ifc_cnts[buffers_idx], ifc_cnts[af_idx]);
+      printf("\tIFC %d> SM: %" PRIu64 ", DM: %" PRIu64 ", SB: %" PRIu64 ", AF: %" PRIu64 ", BY: %" PRIu64 "\n", (int) arr_idx, ifc_cnts[msg_idx], ifc_cnts[dropped_msg_idx], ifc_cnts[buffers_idx], ifc_cnts[af_idx],
+             (uint64_t) json_integer_value(json_object_get(out_ifc_cnts, "bytes")));
+      print_ifc_rates(out_ifc_cnts, arr_idx, 0);
+      print_compress_cnts(out_ifc_cnts);
       memset(ifc_cnts, 0, 4 * sizeof(uint64_t));
    }
 
    json_decref(json_struct);
+   prev_time = sample_time;
    return 0;
 }
 
@@ -316,6 +586,7 @@ int main (int argc, char **argv)
    service_msg_header_t *header = (service_msg_header_t *) calloc(1, sizeof(service_msg_header_t));
    char c = 0;
    int original_argc = argc;
+   struct timespec now;
 
    // Parse program arguments
    while (1) {
@@ -339,7 +610,11 @@ int main (int argc, char **argv)
       return 0;
    } else {
       printf("\x1b[31;1m""Use Control+C to stop me...\n""\x1b[0m");
-      printf("Legend:\n\tRM (received messages)\n\tRB (received buffers)\n\tSM (sent messages)\n\tDM (dropped messages)\n\tSB (sent buffers)\n\tAF (autoflushes counter)\n- - - - - - - - - - - - - - - - -\n");
+      printf("Legend:\n\tRM (received messages)\n\tRB (received buffers)\n\tSM (sent messages)\n\tDM (dropped messages)\n\tSB (sent buffers)\n\tAF (autoflushes counter)\n\tBY (bytes of payload)\n"
+             "\trate (since the previous request), fill (average fill of sent buffers),\n"
+             "\twait (time spent in send() or recv() of IFC), latency (from sending to receiving of buffers),\n"
+             "\thop (traced delay of link to the next module and delay in the module, see setter trace)\n"
+             "\tpercentiles are upper bounds of power-of-two buckets\n- - - - - - - - - - - - - - - - -\n");
    }
 
 
@@ -388,6 +663,8 @@ int main (int argc, char **argv)
       }
 
       // Decode json and save stats into structures
+      clock_gettime(CLOCK_MONOTONIC, &now);
+      sample_time = now.tv_sec + now.tv_nsec / 1e9;
       if (decode_cnts_from_json(&buffer) == -1) {
          printf( "[SERVICE] Error while receiving stats from module.\n");
          break;
@@ -412,5 +689,8 @@ int main (int argc, char **argv)
       dest_sock = NULL;
    }
 
+   free(prev_in);
+   free(prev_out);
+
    return 0;
 }
\ No newline at end of file
@@ -296,6 +296,8 @@ lib.trap_send_data.argtypes = (c_uint, c_void_p, c_uint16, c_int)
 lib.trap_send_data.restype = errorCodeChecker
 lib.trap_recv.argtypes = (c_uint32, POINTER(c_void_p), POINTER(c_uint16))
 lib.trap_recv.restype = errorCodeChecker
+lib.trap_recv_bulk.argtypes = (c_uint32, POINTER(c_void_p), POINTER(c_uint16), c_uint32, POINTER(c_uint32))
+lib.trap_recv_bulk.restype = errorCodeChecker
 lib.trap_send.argtypes = (c_uint32, c_void_p, c_uint16)
 lib.trap_send.restype = errorCodeChecker
 lib.trap_send_flush.argtypes = (c_int,)
@@ -375,6 +377,27 @@ def recv(ifc):
     return data
 
 
+def recvBulk(ifc, max_count=1024):
+    """Receive and return a list of messages.
+
+       ifc - input IFC index
+       max_count - maximal number of returned messages
+       All messages of the current libtrap buffer (at most max_count)
+       are returned by one call instead of calling recv() for each of them.
+    """
+
+    data_ptrs = (c_void_p * max_count)()
+    data_sizes = (c_uint16 * max_count)()
+    count = c_uint32()
+    try:
+        lib.trap_recv_bulk(ifc, data_ptrs, data_sizes, max_count, byref(count))
+    except EFMTChanged as e:
+        data = [string_at(data_ptrs[i], data_sizes[i]) for i in range(count.value)]
+        raise EFMTChanged(e.code, data)
+
+    return [string_at(data_ptrs[i], data_sizes[i]) for i in range(count.value)]
+
+
 def sendData(ifc, data, timeout):
     """Send a message.
 
@@ -0,0 +1,197 @@
+/**
+ * \file test_batch_speed.c
+ * \brief Aggregation over records row by row (ur_get) and over columns of ur_batch_t
+ */
+/*
+ * Copyright (C) 2026 CESNET
+ *
+ * LICENSE TERMS
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name of the Company nor the names of its contributors
+ *    may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ *
+ * ALTERNATIVELY, provided that this notice is retained in full, this
+ * product may be distributed under the terms of the GNU General Public
+ * License (GPL) version 2 or later, in which case the provisions
+ * of the GPL apply INSTEAD OF those given above.
+ *
+ * This software is provided ``as is'', and any express or implied
+ * warranties, including, but not limited to, the implied warranties of
+ * merchantability and fitness for a particular purpose are disclaimed.
+ * In no event shall the company or contributors be liable for any
+ * direct, indirect, incidental, special, exemplary, or consequential
+ * damages (including, but not limited to, procurement of substitute
+ * goods or services; loss of use, data, or profits; or business
+ * interruption) however caused and on any theory of liability, whether
+ * in contract, strict liability, or tort (including negligence or
+ * otherwise) arising in any way out of the use of this software, even
+ * if advised of the possibility of such damage.
+ *
+ */
+
+#include <stdio.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <inttypes.h>
+#include <string.h>
+#include <time.h>
+
+#include "fields.h"
+
+UR_FIELDS(
+   ipaddr SRC_IP,
+   ipaddr DST_IP,
+   uint16 SRC_PORT,
+   uint16 DST_PORT,
+   uint8 PROTOCOL,
+   uint32 PACKETS,
+   uint64 BYTES,
+   string URL,
+)
+
+#define SPEC "SRC_IP,DST_IP,SRC_PORT,DST_PORT,PROTOCOL,PACKETS,BYTES,URL"
+#define BATCHES 100
+#define BATCH 1000
+#define PASSES 20
+/** Number of distinct SRC_IP (aggregation keys), keys are indexed by the last bits of address */
+#define KEYS 1024
+#define MAX_URL 32
+
+/* columns of the batch used for aggregation */
+enum {COL_SRC_IP, COL_PACKETS, COL_BYTES};
+
+static double elapsed(const struct timespec *start)
+{
+   struct timespec end;
+   clock_gettime(CLOCK_MONOTONIC, &end);
+   return (end.tv_sec - start->tv_sec) + (end.tv_nsec - start->tv_nsec) / 1e9;
+}
+
+int main(int argc, char **argv)
+{
+   ur_field_id_t ids[] = {F_SRC_IP, F_PACKETS, F_BYTES};
+   ur_field_id_t url_id = F_URL;
+   ur_template_t *tmplt = ur_create_template(SPEC, NULL);
+   ur_batch_t *batch = NULL, *url_batch = NULL;
+   char *data = NULL, *rec;
+   const void **recs = NULL;
+   uint16_t *sizes = NULL;
+   uint64_t row_bytes[KEYS] = {0}, row_packets[KEYS] = {0}, col_bytes[KEYS] = {0}, col_packets[KEYS] = {0};
+   char url[MAX_URL];
+   struct timespec start;
+   double t_row, t_fill = 0, t_col = 0;
+   uint32_t n = BATCHES * BATCH, key;
+   int result = 1;
+
+   if (tmplt == NULL) {
+      fprintf(stderr, "Error when creating UniRec template.\n");
+      return 1;
+   }
+   // records of all batches and an end of data message after them
+   data = calloc(n + 1, ur_rec_fixlen_size(tmplt) + MAX_URL);
+   recs = malloc((n + 1) * sizeof(void *));
+   sizes = malloc((n + 1) * sizeof(uint16_t));
+   batch = ur_create_batch(ids, sizeof(ids) / sizeof(ids[0]), BATCH / 2);
+   url_batch = ur_create_batch(&url_id, 1, 1);
+   if (data == NULL || recs == NULL || sizes == NULL || batch == NULL || url_batch == NULL) {
+      fprintf(stderr, "Allocation failed.\n");
+      goto exit;
+   }
+   rec = data;
+   for (uint32_t i = 0; i < n; i++) {
+      ur_set(tmplt, rec, F_SRC_IP, ip_from_int(0x0a000000 + (i * 7919) % KEYS));
+      ur_set(tmplt, rec, F_DST_IP, ip_from_int(0xc0a80001));
+      ur_set(tmplt, rec, F_SRC_PORT, i);
+      ur_set(tmplt, rec, F_DST_PORT, 80);
+      ur_set(tmplt, rec, F_PROTOCOL, 6);
+      ur_set(tmplt, rec, F_PACKETS, i % 10 + 1);
+      ur_set(tmplt, rec, F_BYTES, (i * 7) % 1500 + 40);
+      snprintf(url, sizeof(url), "http://example.com/%u", i % 1000);
+      ur_set_string(tmplt, rec, F_URL, url);
+      recs[i] = rec;
+      sizes[i] = ur_rec_size(tmplt, rec);
+      rec += sizes[i];
+   }
+   recs[n] = rec;
+   sizes[n] = 1;
+
+   // row by row
+   clock_gettime(CLOCK_MONOTONIC, &start);
+   for (int pass = 0; pass < PASSES; pass++) {
+      for (uint32_t i = 0; i < n; i++) {
+         key = ip_get_v4_as_int(ur_get_ptr(tmplt, recs[i], F_SRC_IP)) % KEYS;
+         row_bytes[key] += ur_get(tmplt, recs[i], F_BYTES);
+         row_packets[key] += ur_get(tmplt, recs[i], F_PACKETS);
+      }
+   }
+   t_row = elapsed(&start);
+
+   // by columns
+   for (int pass = 0; pass < PASSES; pass++) {
+      for (uint32_t b = 0; b < BATCHES; b++) {
+         clock_gettime(CLOCK_MONOTONIC, &start);
+         // the last batch contains end of data
+         if (ur_batch_fill(batch, tmplt, recs + b * BATCH, sizes + b * BATCH, BATCH + (b == BATCHES - 1)) != UR_OK) {
+            fprintf(stderr, "ur_batch_fill failed.\n");
+            goto exit;
+         }
+         t_fill += elapsed(&start);
+         if (batch->count != BATCH || batch->end != (b == BATCHES - 1)) {
+            fprintf(stderr, "Unexpected batch of %"PRIu32" records (end %d).\n", batch->count, batch->end);
+            goto exit;
+         }
+         clock_gettime(CLOCK_MONOTONIC, &start);
+         ip_addr_t *src_ip = ur_batch_get_column(batch, COL_SRC_IP, F_SRC_IP);
+         uint64_t *bytes = ur_batch_get_column(batch, COL_BYTES, F_BYTES);
+         uint32_t *packets = ur_batch_get_column(batch, COL_PACKETS, F_PACKETS);
+         for (uint32_t i = 0; i < batch->count; i++) {
+            key = ip_get_v4_as_int(&src_ip[i]) % KEYS;
+            col_bytes[key] += bytes[i];
+            col_packets[key] += packets[i];
+         }
+         t_col += elapsed(&start);
+      }
+   }
+
+   // results must be the same
+   if (memcmp(row_bytes, col_bytes, sizeof(row_bytes)) != 0 || memcmp(row_packets, col_packets, sizeof(row_packets)) != 0) {
+      fprintf(stderr, "Sums by columns differ from sums by rows.\n");
+      goto exit;
+   }
+   // values of variable-length column must match records
+   if (ur_batch_fill(url_batch, tmplt, recs, sizes, BATCH) != UR_OK) {
+      fprintf(stderr, "ur_batch_fill failed.\n");
+      goto exit;
+   }
+   for (uint32_t i = 0; i < url_batch->count; i++) {
+      const void *r = recs[i];
+      if (ur_batch_get_var_len(url_batch, 0, i) != ur_get_var_len(tmplt, r, F_URL) ||
+          memcmp(ur_batch_get_var_ptr(url_batch, 0, i), ur_get_ptr(tmplt, r, F_URL), ur_get_var_len(tmplt, r, F_URL)) != 0) {
+         fprintf(stderr, "Variable-length column differs from record %"PRIu32".\n", i);
+         goto exit;
+      }
+   }
+
+   printf("rows: %.2f ns/record\n", t_row * 1e9 / PASSES / n);
+   printf("columns: fill %.2f ns/record, aggregation %.2f ns/record\n", t_fill * 1e9 / PASSES / n, t_col * 1e9 / PASSES / n);
+   result = 0;
+exit:
+   ur_free_batch(batch);
+   ur_free_batch(url_batch);
+   free(data);
+   free(recs);
+   free(sizes);
+   ur_free_template(tmplt);
+   return result;
+}
@@ -0,0 +1,186 @@
+/**
+ * \file test_copy_speed.c
+ * \brief Comparison of ur_copy_fields and ur_copy_with_plan (results and speed)
+ */
+/*
+ * Copyright (C) 2026 CESNET
+ *
+ * LICENSE TERMS
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name of the Company nor the names of its contributors
+ *    may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ *
+ * ALTERNATIVELY, provided that this notice is retained in full, this
+ * product may be distributed under the terms of the GNU General Public
+ * License (GPL) version 2 or later, in which case the provisions
+ * of the GPL apply INSTEAD OF those given above.
+ *
+ * This software is provided ``as is'', and any express or implied
+ * warranties, including, but not limited to, the implied warranties of
+ * merchantability and fitness for a particular purpose are disclaimed.
+ * In no event shall the company or contributors be liable for any
+ * direct, indirect, incidental, special, exemplary, or consequential
+ * damages (including, but not limited to, procurement of substitute
+ * goods or services; loss of use, data, or profits; or business
+ * interruption) however caused and on any theory of liability, whether
+ * in contract, strict liability, or tort (including negligence or
+ * otherwise) arising in any way out of the use of this software, even
+ * if advised of the possibility of such damage.
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <inttypes.h>
+#include <string.h>
+#include <time.h>
+
+#include "fields.h"
+
+UR_FIELDS(
+   ipaddr SRC_IP,
+   ipaddr DST_IP,
+   uint16 SRC_PORT,
+   uint16 DST_PORT,
+   uint8 PROTOCOL,
+   uint32 PACKETS,
+   uint64 BYTES,
+   string URL,
+   string STR1,
+   string STR2,
+)
+
+#define SRC_SPEC "SRC_IP,DST_IP,SRC_PORT,DST_PORT,PROTOCOL,PACKETS,BYTES,URL,STR1"
+#define RECORDS 5000000
+
+/**
+ * Copy one record by ur_copy_fields and by ur_copy_with_plan and compare results.
+ * Destination records are prepared with STR2 set, it must be kept.
+ */
+static int check_copy(const ur_template_t *src_tmplt, const void *src, const char *dst_spec)
+{
+   ur_template_t *dst_tmplt = ur_create_template(dst_spec, NULL);
+   ur_copy_plan_t *plan = NULL;
+   void *dst1 = NULL, *dst2 = NULL;
+   int result = 1;
+
+   if (dst_tmplt == NULL) {
+      fprintf(stderr, "Error when creating UniRec template %s.\n", dst_spec);
+      return 1;
+   }
+   plan = ur_create_copy_plan(dst_tmplt, src_tmplt);
+   dst1 = ur_create_record(dst_tmplt, 256);
+   dst2 = ur_create_record(dst_tmplt, 256);
+   if (plan == NULL || dst1 == NULL || dst2 == NULL) {
+      fprintf(stderr, "Allocation failed.\n");
+      goto exit;
+   }
+   if (ur_is_present(dst_tmplt, F_STR2)) {
+      ur_set_string(dst_tmplt, dst1, F_STR2, "kept value");
+      ur_set_string(dst_tmplt, dst2, F_STR2, "kept value");
+   }
+   ur_copy_fields(dst_tmplt, dst1, src_tmplt, src);
+   ur_copy_with_plan(plan, dst2, src);
+   if (ur_rec_size(dst_tmplt, dst1) != ur_rec_size(dst_tmplt, dst2) ||
+       memcmp(dst1, dst2, ur_rec_size(dst_tmplt, dst1)) != 0) {
+      fprintf(stderr, "ur_copy_with_plan differs from ur_copy_fields for %s.\n", dst_spec);
+      goto exit;
+   }
+   printf("%s: %hu runs, %hu variable-length fields%s\n", dst_spec, plan->run_count, plan->var_count,
+          plan->whole ? ", whole record" : "");
+   result = 0;
+exit:
+   free(dst1);
+   free(dst2);
+   ur_free_copy_plan(plan);
+   ur_free_template(dst_tmplt);
+   return result;
+}
+
+static double elapsed(const struct timespec *start)
+{
+   struct timespec end;
+   clock_gettime(CLOCK_MONOTONIC, &end);
+   return (end.tv_sec - start->tv_sec) + (end.tv_nsec - start->tv_nsec) / 1e9;
+}
+
+int main(int argc, char **argv)
+{
+   ur_template_t *src_tmplt = ur_create_template(SRC_SPEC, NULL);
+   ur_template_t *dst_tmplt = ur_create_template("SRC_IP,DST_IP,DST_PORT,PROTOCOL,BYTES,URL", NULL);
+   ur_copy_plan_t *plan = NULL;
+   void *src = NULL, *dst = NULL;
+   struct timespec start;
+   double t_fields, t_plan;
+   uint64_t sum = 0;
+   int result = 1;
+
+   if (src_tmplt == NULL || dst_tmplt == NULL) {
+      fprintf(stderr, "Error when creating UniRec template.\n");
+      goto exit;
+   }
+   src = ur_create_record(src_tmplt, 256);
+   dst = ur_create_record(dst_tmplt, 256);
+   if (src == NULL || dst == NULL) {
+      goto exit;
+   }
+   ip_from_str("192.168.0.1", ur_get_ptr(src_tmplt, src, F_SRC_IP));
+   ip_from_str("10.0.0.1", ur_get_ptr(src_tmplt, src, F_DST_IP));
+   ur_set(src_tmplt, src, F_SRC_PORT, 12345);
+   ur_set(src_tmplt, src, F_DST_PORT, 80);
+   ur_set(src_tmplt, src, F_PROTOCOL, 6);
+   ur_set(src_tmplt, src, F_PACKETS, 10);
+   ur_set(src_tmplt, src, F_BYTES, 1500);
+   ur_set_string(src_tmplt, src, F_URL, "http://example.com/index.html");
+   ur_set_string(src_tmplt, src, F_STR1, "Mozilla/5.0");
+
+   // results must be the same: subset, the same fields, reordered, missing variable-length field
+   if (check_copy(src_tmplt, src, "SRC_IP,DST_IP,DST_PORT,PROTOCOL,BYTES,URL") != 0 ||
+       check_copy(src_tmplt, src, SRC_SPEC) != 0 ||
+       check_copy(src_tmplt, src, "STR1,PACKETS,BYTES,URL,SRC_PORT") != 0 ||
+       check_copy(src_tmplt, src, "DST_IP,STR2,URL,PACKETS") != 0) {
+      goto exit;
+   }
+
+   plan = ur_create_copy_plan(dst_tmplt, src_tmplt);
+   if (plan == NULL) {
+      goto exit;
+   }
+   clock_gettime(CLOCK_MONOTONIC, &start);
+   for (int i = 0; i < RECORDS; i++) {
+      ur_set(src_tmplt, src, F_BYTES, i);
+      ur_copy_fields(dst_tmplt, dst, src_tmplt, src);
+      sum += ur_get(dst_tmplt, dst, F_BYTES);
+   }
+   t_fields = elapsed(&start);
+   clock_gettime(CLOCK_MONOTONIC, &start);
+   for (int i = 0; i < RECORDS; i++) {
+      ur_set(src_tmplt, src, F_BYTES, i);
+      ur_copy_with_plan(plan, dst, src);
+      sum += ur_get(dst_tmplt, dst, F_BYTES);
+   }
+   t_plan = elapsed(&start);
+
+   printf("%"PRIu64"\n", sum);
+   printf("ur_copy_fields: %.1f ns/record\n", t_fields * 1e9 / RECORDS);
+   printf("ur_copy_with_plan: %.1f ns/record\n", t_plan * 1e9 / RECORDS);
+   result = 0;
+exit:
+   free(src);
+   free(dst);
+   ur_free_copy_plan(plan);
+   ur_free_template(src_tmplt);
+   ur_free_template(dst_tmplt);
+   return result;
+}
@@ -0,0 +1,209 @@
+/**
+ * \file test_field_lookup.c
+ * \brief Lookup of many dynamically defined fields and renegotiation of templates
+ */
+/*
+ * Copyright (C) 2026 CESNET
+ *
+ * LICENSE TERMS
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name of the Company nor the names of its contributors
+ *    may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ *
+ * ALTERNATIVELY, provided that this notice is retained in full, this
+ * product may be distributed under the terms of the GNU General Public
+ * License (GPL) version 2 or later, in which case the provisions
+ * of the GPL apply INSTEAD OF those given above.
+ *
+ * This software is provided ``as is'', and any express or implied
+ * warranties, including, but not limited to, the implied warranties of
+ * merchantability and fitness for a particular purpose are disclaimed.
+ * In no event shall the company or contributors be liable for any
+ * direct, indirect, incidental, special, exemplary, or consequential
+ * damages (including, but not limited to, procurement of substitute
+ * goods or services; loss of use, data, or profits; or business
+ * interruption) however caused and on any theory of liability, whether
+ * in contract, strict liability, or tort (including negligence or
+ * otherwise) arising in any way out of the use of this software, even
+ * if advised of the possibility of such damage.
+ *
+ */
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+
+#include "fields.h"
+
+UR_FIELDS(
+   uint32 FOO,
+   uint32 BAR,
+)
+
+/** Number of dynamically defined fields */
+#define FIELDS 3000
+/** Number of fields of the negotiated template */
+#define TMPLT_FIELDS 200
+#define LOOPS 1000
+#define NAME_LEN 16
+
+static const ur_field_type_t types[] = {UR_TYPE_UINT8, UR_TYPE_UINT16, UR_TYPE_UINT32, UR_TYPE_UINT64, UR_TYPE_DOUBLE, UR_TYPE_IP, UR_TYPE_STRING};
+
+static double elapsed(const struct timespec *start)
+{
+   struct timespec end;
+   clock_gettime(CLOCK_MONOTONIC, &end);
+   return (end.tv_sec - start->tv_sec) + (end.tv_nsec - start->tv_nsec) / 1e9;
+}
+
+int main(int argc, char **argv)
+{
+   static int ids[FIELDS];
+   char name[NAME_LEN];
+   char *fields = NULL, *spec = NULL;
+   ur_template_t *tmplt = NULL, *updated;
+   struct timespec start;
+   double t_lookup, t_create, t_update;
+   int result = 1, id;
+
+   // define fields
+   for (int i = 0; i < FIELDS; i++) {
+      snprintf(name, NAME_LEN, "DYN_%d", i);
+      ids[i] = ur_define_field(name, types[i % (sizeof(types) / sizeof(types[0]))]);
+      if (ids[i] < 0) {
+         fprintf(stderr, "Field %s was not defined (%d).\n", name, ids[i]);
+         goto exit;
+      }
+   }
+   if (ur_get_id_by_name("FOO") != F_FOO || ur_get_id_by_name("BAR") != F_BAR || ur_get_id_by_name("DYN_") != UR_E_INVALID_NAME) {
+      fprintf(stderr, "Lookup of a static or unknown field failed.\n");
+      goto exit;
+   }
+   if (ur_define_field("DYN_8", UR_TYPE_UINT8) != UR_E_TYPE_MISMATCH || ur_define_field("DYN_8", types[8 % 7]) != ids[8]) {
+      fprintf(stderr, "Redefinition of a field failed.\n");
+      goto exit;
+   }
+
+   // undefine every third field, IDs are reused by new fields
+   for (int i = 0; i < FIELDS; i += 3) {
+      snprintf(name, NAME_LEN, "DYN_%d", i);
+      if (ur_undefine_field(name) != UR_OK) {
+         fprintf(stderr, "Field %s was not undefined.\n", name);
+         goto exit;
+      }
+   }
+   if (ur_undefine_field("FOO") != UR_E_INVALID_NAME || ur_undefine_field("DYN_0") != UR_E_INVALID_NAME) {
+      fprintf(stderr, "Static or undefined field was undefined.\n");
+      goto exit;
+   }
+   for (int i = 0; i < FIELDS; i++) {
+      snprintf(name, NAME_LEN, "DYN_%d", i);
+      id = ur_get_id_by_name(name);
+      if ((i % 3 == 0 && id != UR_E_INVALID_NAME) || (i % 3 != 0 && id != ids[i])) {
+         fprintf(stderr, "Lookup of %s returned %d.\n", name, id);
+         goto exit;
+      }
+   }
+   for (int i = 0; i < FIELDS; i += 3) {
+      snprintf(name, NAME_LEN, "NEW_%d", i);
+      ids[i] = ur_define_field(name, UR_TYPE_INT32);
+      if (ids[i] < 0 || ur_get_id_by_name(name) != ids[i]) {
+         fprintf(stderr, "Field %s was not redefined.\n", name);
+         goto exit;
+      }
+   }
+
+   clock_gettime(CLOCK_MONOTONIC, &start);
+   for (int l = 0; l < LOOPS; l++) {
+      for (int i = 1; i < FIELDS; i += 3) {
+         snprintf(name, NAME_LEN, "DYN_%d", i);
+         if (ur_get_id_by_name(name) != ids[i]) {
+            fprintf(stderr, "Lookup of %s failed.\n", name);
+            goto exit;
+         }
+      }
+   }
+   t_lookup = elapsed(&start);
+
+   // template of fields defined at the end of the table
+   fields = malloc(TMPLT_FIELDS * NAME_LEN);
+   if (fields == NULL) {
+      fprintf(stderr, "Allocation failed.\n");
+      goto exit;
+   }
+   fields[0] = '\0';
+   for (int i = FIELDS - TMPLT_FIELDS; i < FIELDS; i++) {
+      snprintf(name, NAME_LEN, i % 3 ? "DYN_%d," : "NEW_%d,", i);
+      strcat(fields, name);
+   }
+   fields[strlen(fields) - 1] = '\0';
+   clock_gettime(CLOCK_MONOTONIC, &start);
+   for (int l = 0; l < LOOPS; l++) {
+      tmplt = ur_create_template(fields, NULL);
+      if (tmplt == NULL) {
+         fprintf(stderr, "Template was not created.\n");
+         goto exit;
+      }
+      if (l < LOOPS - 1) {
+         ur_free_template(tmplt);
+      }
+   }
+   t_create = elapsed(&start);
+
+   // negotiation of the same format keeps the template
+   spec = ur_template_string(tmplt);
+   if (spec == NULL) {
+      fprintf(stderr, "Allocation failed.\n");
+      goto exit;
+   }
+   clock_gettime(CLOCK_MONOTONIC, &start);
+   for (int l = 0; l < LOOPS; l++) {
+      updated = ur_define_fields_and_update_template(spec, tmplt);
+      if (updated != tmplt) {
+         fprintf(stderr, "Template was changed by the same format.\n");
+         goto exit;
+      }
+   }
+   t_update = elapsed(&start);
+
+   // a new field changes the template
+   char *longer_spec = realloc(spec, strlen(spec) + 32);
+   if (longer_spec == NULL) {
+      fprintf(stderr, "Allocation failed.\n");
+      goto exit;
+   }
+   spec = longer_spec;
+   strcat(spec, ",uint64 ANOTHER_FIELD");
+   updated = ur_define_fields_and_update_template(spec, tmplt);
+   if (updated == NULL || updated == tmplt || updated->count != TMPLT_FIELDS + 1 || !ur_is_present(updated, ur_get_id_by_name("ANOTHER_FIELD"))) {
+      fprintf(stderr, "Template was not updated by a new format.\n");
+      ur_free_template(updated);
+      tmplt = NULL;
+      goto exit;
+   }
+   tmplt = updated;
+
+   printf("lookup: %.1f ns/name\n", t_lookup * 1e9 / LOOPS / (FIELDS / 3));
+   printf("ur_create_template with %d fields: %.1f us\n", TMPLT_FIELDS, t_create * 1e6 / LOOPS);
+   printf("negotiation of the same format: %.1f us\n", t_update * 1e6 / LOOPS);
+   result = 0;
+exit:
+   free(fields);
+   free(spec);
+   ur_free_template(tmplt);
+   ur_finalize();
+   return result;
+}
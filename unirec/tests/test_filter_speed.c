@@ -0,0 +1,332 @@
+/**
+ * \file test_filter_speed.c
+ * \brief Compiled filter (ur_filter.h) compared with hand-written conditions
+ */
+/*
+ * Copyright (C) 2026 CESNET
+ *
+ * LICENSE TERMS
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name of the Company nor the names of its contributors
+ *    may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ *
+ * ALTERNATIVELY, provided that this notice is retained in full, this
+ * product may be distributed under the terms of the GNU General Public
+ * License (GPL) version 2 or later, in which case the provisions
+ * of the GPL apply INSTEAD OF those given above.
+ *
+ * This software is provided ``as is'', and any express or implied
+ * warranties, including, but not limited to, the implied warranties of
+ * merchantability and fitness for a particular purpose are disclaimed.
+ * In no event shall the company or contributors be liable for any
+ * direct, indirect, incidental, special, exemplary, or consequential
+ * damages (including, but not limited to, procurement of substitute
+ * goods or services; loss of use, data, or profits; or business
+ * interruption) however caused and on any theory of liability, whether
+ * in contract, strict liability, or tort (including negligence or
+ * otherwise) arising in any way out of the use of this software, even
+ * if advised of the possibility of such damage.
+ *
+ */
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <inttypes.h>
+#include <string.h>
+#include <time.h>
+
+#include "fields.h"
+#include <unirec/ur_filter.h>
+
+UR_FIELDS(
+   ipaddr SRC_IP,
+   ipaddr DST_IP,
+   uint16 DST_PORT,
+   uint8 PROTOCOL,
+   uint32 PACKETS,
+   uint64 BYTES,
+   int32 DELTA,
+   double SCORE,
+   string URL,
+)
+
+#define SPEC "SRC_IP,DST_IP,DST_PORT,PROTOCOL,PACKETS,BYTES,DELTA,SCORE,URL"
+/** Number of records, it is not a multiple of 64 on purpose */
+#define N 100003
+/** Number of records passed to ur_filter_eval_batch at once, a multiple of 64 keeps bitmaps of batches contiguous */
+#define BATCH 1024
+#define PASSES 50
+#define MAX_URL 32
+
+#define EXPR "PROTOCOL == 6 && DST_PORT in [80, 443] && SRC_IP in 10.0.0.0/8"
+
+static ur_template_t *tmplt;
+static ip_addr_t net10, net192, net6, host;
+
+static int in_prefix(const ip_addr_t *ip, const ip_addr_t *net, int bytes)
+{
+   // prefixes used by tests end on a byte boundary
+   if (ip_is4(net)) {
+      return ip_is4(ip) && memcmp((char *) ip + 8, (char *) net + 8, bytes) == 0;
+   }
+   return !ip_is4(ip) && memcmp(ip, net, bytes) == 0;
+}
+
+static int check_expr(const void *rec)
+{
+   uint16_t port = ur_get(tmplt, rec, F_DST_PORT);
+   return ur_get(tmplt, rec, F_PROTOCOL) == 6 && (port == 80 || port == 443) &&
+          in_prefix(ur_get_ptr(tmplt, rec, F_SRC_IP), &net10, 1);
+}
+
+static int check_not(const void *rec)
+{
+   return ur_get(tmplt, rec, F_PROTOCOL) != 6 || !(ur_get(tmplt, rec, F_DST_PORT) < 1024);
+}
+
+static int check_signed(const void *rec)
+{
+   int32_t d = ur_get(tmplt, rec, F_DELTA);
+   return (d >= -10 && d < 10) || (d >= -1000 && d <= -990) || (d >= 995 && d <= 1000);
+}
+
+static int check_double(const void *rec)
+{
+   double s = ur_get(tmplt, rec, F_SCORE);
+   return s > 0.5 && s <= 12.25;
+}
+
+static int check_wide(const void *rec)
+{
+   uint64_t b = ur_get(tmplt, rec, F_BYTES);
+   return b <= 99 || b >= 0xffffffff00000000ULL;
+}
+
+static int check_string(const void *rec)
+{
+   const char *url = ur_get_ptr(tmplt, rec, F_URL);
+   uint16_t len = ur_get_var_len(tmplt, rec, F_URL);
+   return (len == 10 && memcmp(url, "http://x/7", 10) == 0) || (len == 1 && (url[0] == 'a' || url[0] == 'b'));
+}
+
+static int check_not_string(const void *rec)
+{
+   return !(ur_get_var_len(tmplt, rec, F_URL) == 1 && *(char *) ur_get_ptr(tmplt, rec, F_URL) == 'a');
+}
+
+static int check_ip(const void *rec)
+{
+   const ip_addr_t *src = ur_get_ptr(tmplt, rec, F_SRC_IP);
+   return (in_prefix(src, &net6, 4) || in_prefix(src, &net192, 3)) &&
+          memcmp(ur_get_ptr(tmplt, rec, F_DST_IP), &host, sizeof(host)) == 0;
+}
+
+static int check_none(const void *rec)
+{
+   return 0;
+}
+
+static int check_all(const void *rec)
+{
+   return 1;
+}
+
+static const struct {
+   const char *expr;
+   int (*check)(const void *rec);
+} cases[] = {
+   {EXPR, check_expr},
+   {"PROTOCOL != 6 || !(DST_PORT < 1024)", check_not},
+   {"DELTA >= -10 && DELTA < 10 || DELTA in [-1000..-990, 995..1000]", check_signed},
+   {"SCORE > 0.5 && SCORE <= 12.25", check_double},
+   {"BYTES in [0..99, 0xffffffff00000000..0xffffffffffffffff]", check_wide},
+   {"URL == \"http://x/7\" || URL in [\"a\", \"b\"]", check_string},
+   {"URL != \"a\"", check_not_string},
+   {"(SRC_IP in [2001:db8::/32, 192.168.1.0/24]) && DST_IP == 10.0.0.1", check_ip},
+   {"PACKETS > 4294967295 || DELTA < -2147483648", check_none},
+   {"!(PACKETS > 4294967295)", check_all},
+};
+
+static const char *bad_exprs[] = {
+   "UNKNOWN_FIELD == 1",
+   "SRC_PORT == 80",
+   "PROTOCOL == 256",
+   "DST_PORT == -1",
+   "PROTOCOL ==",
+   "PROTOCOL 6",
+   "SRC_IP < 10.0.0.1",
+   "SRC_IP in 10.0.0.0/33",
+   "URL == abc",
+   "(PROTOCOL == 6",
+   "PROTOCOL == 6 &&",
+   "PROTOCOL == 6 )",
+   "DST_PORT in [80, 443",
+   "",
+};
+
+static double elapsed(const struct timespec *start)
+{
+   struct timespec end;
+   clock_gettime(CLOCK_MONOTONIC, &end);
+   return (end.tv_sec - start->tv_sec) + (end.tv_nsec - start->tv_nsec) / 1e9;
+}
+
+int main(int argc, char **argv)
+{
+   static const uint16_t ports[] = {80, 443, 53, 22, 8080, 1024};
+   static const uint8_t protocols[] = {6, 17, 1};
+   static const char *urls[] = {"a", "b", "http://x/7", "http://x/8", ""};
+   ur_filter_t *filter = NULL;
+   uint64_t *bitmap = NULL, *hand = NULL;
+   char *data = NULL, *rec, *errstr;
+   const void **recs = NULL;
+   uint32_t seed = 1, r, selected, expected;
+   ip_addr_t ip;
+   struct timespec start;
+   double t_hand, t_filter = 0;
+   int result = 1;
+
+   tmplt = ur_create_template(SPEC, NULL);
+   if (tmplt == NULL) {
+      fprintf(stderr, "Error when creating UniRec template.\n");
+      return 1;
+   }
+   ip_from_str("10.0.0.0", &net10);
+   ip_from_str("192.168.1.0", &net192);
+   ip_from_str("2001:db8::", &net6);
+   ip_from_str("10.0.0.1", &host);
+
+   data = calloc(N, ur_rec_fixlen_size(tmplt) + MAX_URL);
+   recs = malloc(N * sizeof(void *));
+   bitmap = malloc(UR_FILTER_BITMAP_WORDS(N) * sizeof(uint64_t));
+   hand = malloc(UR_FILTER_BITMAP_WORDS(N) * sizeof(uint64_t));
+   if (data == NULL || recs == NULL || bitmap == NULL || hand == NULL) {
+      fprintf(stderr, "Allocation failed.\n");
+      goto exit;
+   }
+   rec = data;
+   for (uint32_t i = 0; i < N; i++) {
+      seed = seed * 1103515245 + 12345;
+      r = seed >> 8;
+      switch (r % 4) {
+      case 0:
+         ip = ip_from_int(0x0a000000 + r % 65536);
+         break;
+      case 1:
+         ip = ip_from_int(0xc0a80000 + r % 512);
+         break;
+      case 2:
+         ip_from_str(r % 8 ? "2001:db8::1" : "2001:db9::1", &ip);
+         break;
+      default:
+         ip = ip_from_int(r);
+      }
+      ur_set(tmplt, rec, F_SRC_IP, ip);
+      ur_set(tmplt, rec, F_DST_IP, (r / 4) % 3 ? host : ip_from_int(r));
+      ur_set(tmplt, rec, F_DST_PORT, (r / 16) % 8 < 6 ? ports[(r / 16) % 8] : r % 65536);
+      ur_set(tmplt, rec, F_PROTOCOL, protocols[(r / 128) % 3]);
+      ur_set(tmplt, rec, F_PACKETS, r % 3 ? r : 0xffffffff);
+      ur_set(tmplt, rec, F_BYTES, r % 5 ? r % 1000 : 0xffffffffffffff00ULL + r % 256);
+      ur_set(tmplt, rec, F_DELTA, (int32_t) (r % 2001) - 1000);
+      ur_set(tmplt, rec, F_SCORE, (r % 1000) / 10.0 - 50);
+      ur_set_string(tmplt, rec, F_URL, urls[(r / 512) % 5]);
+      recs[i] = rec;
+      rec += ur_rec_size(tmplt, rec);
+   }
+
+   // invalid expressions
+   for (size_t c = 0; c < sizeof(bad_exprs) / sizeof(bad_exprs[0]); c++) {
+      errstr = NULL;
+      filter = ur_filter_compile(bad_exprs[c], tmplt, &errstr);
+      if (filter != NULL || errstr == NULL) {
+         fprintf(stderr, "Invalid filter \"%s\" was accepted.\n", bad_exprs[c]);
+         goto exit;
+      }
+      free(errstr);
+   }
+
+   // results of filters must be the same as results of hand-written conditions
+   for (size_t c = 0; c < sizeof(cases) / sizeof(cases[0]); c++) {
+      errstr = NULL;
+      filter = ur_filter_compile(cases[c].expr, tmplt, &errstr);
+      if (filter == NULL) {
+         fprintf(stderr, "Filter \"%s\" was not compiled: %s\n", cases[c].expr, errstr);
+         free(errstr);
+         goto exit;
+      }
+      selected = ur_filter_eval_batch(filter, recs, N, bitmap);
+      expected = 0;
+      for (uint32_t i = 0; i < N; i++) {
+         int match = cases[c].check(recs[i]);
+         expected += match;
+         if (ur_filter_is_selected(bitmap, i) != match || (ur_filter_eval(filter, recs[i]) != 0) != match) {
+            fprintf(stderr, "Filter \"%s\" differs for record %"PRIu32".\n", cases[c].expr, i);
+            goto exit;
+         }
+      }
+      if (selected != expected) {
+         fprintf(stderr, "Filter \"%s\" selected %"PRIu32" records instead of %"PRIu32".\n", cases[c].expr, selected, expected);
+         goto exit;
+      }
+      printf("%-66s %6"PRIu32" of %d\n", cases[c].expr, selected, N);
+      ur_filter_free(filter);
+      filter = NULL;
+   }
+
+   // hand-written condition evaluated record by record
+   clock_gettime(CLOCK_MONOTONIC, &start);
+   for (int pass = 0; pass < PASSES; pass++) {
+      memset(hand, 0, UR_FILTER_BITMAP_WORDS(N) * sizeof(uint64_t));
+      for (uint32_t i = 0; i < N; i++) {
+         const void *record = recs[i];
+         uint16_t port = ur_get(tmplt, record, F_DST_PORT);
+         if (ur_get(tmplt, record, F_PROTOCOL) == 6 && (port == 80 || port == 443) &&
+             ip_is4(ur_get_ptr(tmplt, record, F_SRC_IP)) && (ip_get_v4_as_int(ur_get_ptr(tmplt, record, F_SRC_IP)) >> 24) == 10) {
+            hand[i / 64] |= (uint64_t) 1 << (i % 64);
+         }
+      }
+   }
+   t_hand = elapsed(&start);
+
+   // compiled filter evaluated over batches of records
+   filter = ur_filter_compile(EXPR, tmplt, NULL);
+   if (filter == NULL) {
+      fprintf(stderr, "Filter \"%s\" was not compiled.\n", EXPR);
+      goto exit;
+   }
+   for (int pass = 0; pass < PASSES; pass++) {
+      clock_gettime(CLOCK_MONOTONIC, &start);
+      for (uint32_t i = 0; i < N; i += BATCH) {
+         ur_filter_eval_batch(filter, recs + i, N - i < BATCH ? N - i : BATCH, bitmap + i / 64);
+      }
+      t_filter += elapsed(&start);
+   }
+   if (memcmp(hand, bitmap, UR_FILTER_BITMAP_WORDS(N) * sizeof(uint64_t)) != 0) {
+      fprintf(stderr, "Filter differs from hand-written condition.\n");
+      goto exit;
+   }
+
+   printf("hand-written: %.2f ns/record\n", t_hand * 1e9 / PASSES / N);
+   printf("filter: %.2f ns/record\n", t_filter * 1e9 / PASSES / N);
+   result = 0;
+exit:
+   ur_filter_free(filter);
+   free(data);
+   free(recs);
+   free(bitmap);
+   free(hand);
+   ur_free_template(tmplt);
+   return result;
+}
@@ -60,6 +60,8 @@ UR_FIELDS(
    string URL,
 )
 
+UR_STATIC_TEMPLATE(flow, "SRC_IP,DST_IP,SRC_PORT,DST_PORT,PROTOCOL,PACKETS,BYTES,URL")
+
 struct flow_rec_s {
    ip_addr_t dst_ip;
    ip_addr_t src_ip;
@@ -83,6 +85,23 @@ int main(int argc, char **argv)
       fprintf(stderr, "Error when creating UniRec template.\n");
       return 1;
    }
+#ifdef UNIREC_STATIC
+   // constant offsets may be used only if the template matches the static template,
+   // a module would use ur_get etc. (or ur_fast_get) otherwise
+   if (!ur_static_match(flow, tmplt)) {
+      fprintf(stderr, "UniRec template does not match static template.\n");
+      ur_free_template(tmplt);
+      return 1;
+   }
+   ur_template_t *other = ur_create_template("SRC_IP,DST_IP,SRC_PORT,DST_PORT,PROTOCOL,PACKETS,URL", NULL);
+   if (other == NULL || ur_static_match(flow, other)) {
+      fprintf(stderr, "Different UniRec template matches static template.\n");
+      ur_free_template(other);
+      ur_free_template(tmplt);
+      return 1;
+   }
+   ur_free_template(other);
+#endif
 
    char *rec =
 #else
@@ -103,10 +122,36 @@ int main(int argc, char **argv)
    uint64_t z = 0;
    char tmp_str[20];
 
+#ifdef UNIREC_STATIC
+   // both ways of ur_fast_* must give the same values
+   for (int match = 0; match <= 1; match++) {
+      if (ur_fast_get(flow, match, tmplt, rec, F_BYTES) != ur_get(tmplt, rec, F_BYTES) ||
+          ur_fast_get(flow, match, tmplt, rec, F_PROTOCOL) != ur_get(tmplt, rec, F_PROTOCOL) ||
+          ur_fast_get_ptr(flow, match, tmplt, rec, F_DST_IP) != ur_get_ptr(tmplt, rec, F_DST_IP) ||
+          ur_fast_get_var_ptr(flow, match, tmplt, rec, F_URL) != ur_get_ptr(tmplt, rec, F_URL) ||
+          ur_fast_get_var_len(flow, match, tmplt, rec, F_URL) != ur_get_var_len(tmplt, rec, F_URL)) {
+         fprintf(stderr, "Static and dynamic access to UniRec fields differ.\n");
+         ur_free_template(tmplt);
+         return 1;
+      }
+   }
+#endif
+
    time_t start_time = time(NULL);
 
    for (int i = 0; i < 1000000000; i++) {
-#ifdef UNIREC
+#if defined(UNIREC) && defined(UNIREC_STATIC)
+      if (ip_is4(ur_static_get_ptr(flow, rec, F_SRC_IP)))
+         x += 1;
+      if (ip_is4(ur_static_get_ptr(flow, rec, F_DST_IP)))
+         x += 1;
+      y += ur_static_get(flow, rec, F_SRC_PORT);
+      y += ur_static_get(flow, rec, F_DST_PORT);
+      y += ur_static_get(flow, rec, F_PROTOCOL);
+      z += ur_static_get(flow, rec, F_PACKETS);
+      z += ur_static_get(flow, rec, F_BYTES);
+      memcpy(tmp_str, ur_static_get_var_ptr(flow, rec, F_URL), ur_static_get_var_len(flow, rec, F_URL));
+#elif defined(UNIREC)
       if (ip_is4(ur_get_ptr(tmplt, rec, F_SRC_IP)))
          x += 1;
       if (ip_is4(ur_get_ptr(tmplt, rec, F_DST_IP)))
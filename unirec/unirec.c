@@ -118,6 +118,141 @@ ur_static_field_specs_t UR_FIELD_SPECS_STATIC;
 
 const char UR_MEMORY_ERROR [] = "Memory allocation error";
 
+#define UR_NAME_INDEX_EMPTY -1      ///< Empty slot of the name index
+#define UR_NAME_INDEX_DELETED -2    ///< Slot of an undefined field
+#define UR_NAME_INDEX_INITIAL_SIZE 64 ///< Initial number of slots of the name index
+
+/** \brief Hash index of names of fields.
+ * Open addressing table of field IDs hashed by names. It is built by ur_init
+ * and updated by ur_define_field and ur_undefine_field_by_id, lookups only read
+ * it. Before ur_init (or when there was no memory for the index), names are
+ * searched linearly.
+ */
+static struct {
+	ur_field_id_t *slots; ///< IDs of fields, UR_NAME_INDEX_EMPTY or UR_NAME_INDEX_DELETED
+	int size;             ///< Number of slots (power of 2)
+	int used;             ///< Number of slots which are not empty
+	int valid;            ///< The index contains all fields of ur_field_specs
+} ur_name_index;
+
+// FNV-1a hash of a name of given length
+static uint32_t ur_name_hash(const char *name, size_t len)
+{
+	uint32_t hash = 2166136261U;
+	for (size_t i = 0; i < len; i++) {
+		hash = (hash ^ (uint8_t) name[i]) * 16777619U;
+	}
+	return hash;
+}
+
+static void ur_name_index_clear()
+{
+	free(ur_name_index.slots);
+	ur_name_index.slots = NULL;
+	ur_name_index.size = 0;
+	ur_name_index.used = 0;
+	ur_name_index.valid = 0;
+}
+
+// Insert a field into the index, there must be a free slot
+static void ur_name_index_put(ur_field_id_t id)
+{
+	const char *name = ur_field_specs.ur_field_names[id];
+	uint32_t i = ur_name_hash(name, strlen(name)) & (ur_name_index.size - 1);
+	while (ur_name_index.slots[i] >= 0) {
+		i = (i + 1) & (ur_name_index.size - 1);
+	}
+	if (ur_name_index.slots[i] == UR_NAME_INDEX_EMPTY) {
+		ur_name_index.used++;
+	}
+	ur_name_index.slots[i] = id;
+}
+
+// (Re)build the index of all defined fields with at least given number of slots
+static int ur_name_index_build(int size)
+{
+	ur_name_index_clear();
+	while (size < 2 * ur_field_specs.ur_last_id) {
+		size *= 2;
+	}
+	ur_name_index.slots = (ur_field_id_t*) malloc(sizeof(ur_field_id_t) * size);
+	if (ur_name_index.slots == NULL) {
+		return UR_E_MEMORY;
+	}
+	ur_name_index.size = size;
+	for (int i = 0; i < size; i++) {
+		ur_name_index.slots[i] = UR_NAME_INDEX_EMPTY;
+	}
+	for (int id = 0; id < ur_field_specs.ur_last_id; id++) {
+		if (ur_field_specs.ur_field_names[id] != NULL) {
+			ur_name_index_put(id);
+		}
+	}
+	ur_name_index.valid = 1;
+	return UR_OK;
+}
+
+// Add a newly defined field to the index (if the index is already built)
+static void ur_name_index_insert(ur_field_id_t id)
+{
+	if (!ur_name_index.valid) {
+		return;
+	}
+	// keep at least half of slots empty
+	if (2 * (ur_name_index.used + 1) > ur_name_index.size) {
+		if (ur_name_index_build(ur_name_index.size * 2) != UR_OK) {
+			ur_name_index_clear();
+		}
+		// rebuilt index already contains the new field
+		return;
+	}
+	ur_name_index_put(id);
+}
+
+// Remove a field from the index, name of the field must be still set
+static void ur_name_index_remove(ur_field_id_t id)
+{
+	if (!ur_name_index.valid) {
+		return;
+	}
+	const char *name = ur_field_specs.ur_field_names[id];
+	uint32_t i = ur_name_hash(name, strlen(name)) & (ur_name_index.size - 1);
+	while (ur_name_index.slots[i] != UR_NAME_INDEX_EMPTY) {
+		if (ur_name_index.slots[i] == id) {
+			ur_name_index.slots[i] = UR_NAME_INDEX_DELETED;
+			return;
+		}
+		i = (i + 1) & (ur_name_index.size - 1);
+	}
+}
+
+// Find ID of a field given by a name of given length (the name does not have to be terminated by 0)
+static int ur_get_id_by_name_len(const char *name, size_t len)
+{
+	if (!ur_name_index.valid) {
+		// index is not built, search all names
+		for (int id = 0; id < ur_field_specs.ur_last_id; id++) {
+			const char *f_name = ur_field_specs.ur_field_names[id];
+			if (f_name != NULL && strncmp(name, f_name, len) == 0 && f_name[len] == '\0') {
+				return id;
+			}
+		}
+		return UR_E_INVALID_NAME;
+	}
+	uint32_t i = ur_name_hash(name, len) & (ur_name_index.size - 1);
+	while (ur_name_index.slots[i] != UR_NAME_INDEX_EMPTY) {
+		ur_field_id_t id = ur_name_index.slots[i];
+		if (id >= 0) {
+			const char *f_name = ur_field_specs.ur_field_names[id];
+			if (strncmp(name, f_name, len) == 0 && f_name[len] == '\0') {
+				return id;
+			}
+		}
+		i = (i + 1) & (ur_name_index.size - 1);
+	}
+	return UR_E_INVALID_NAME;
+}
+
 int ur_init(ur_static_field_specs_t field_specs_static)
 {
 	int i, j;
@@ -161,6 +296,8 @@ int ur_init(ur_static_field_specs_t field_specs_static)
 		}
 		strcpy(ur_field_specs.ur_field_names[i], field_specs_static.ur_field_names[i]);
 	}
+	// if there is no memory for the index, names are searched linearly
+	ur_name_index_build(UR_NAME_INDEX_INITIAL_SIZE);
 	ur_field_specs.intialized = UR_INITIALIZED;
 	return UR_OK;
 }
@@ -493,9 +630,49 @@ int ur_define_set_of_fields(const char *ifc_data_fmt)
 	return UR_OK;
 }
 
+// Check whether template contains exactly the fields (of the same types) given by data format string
+static int ur_template_matches_ifc_spec(const ur_template_t *tmplt, const char *ifc_data_fmt)
+{
+	const char *type, *name, *type_str;
+	size_t type_len, name_len;
+	int id, count = 0;
+	while (*ifc_data_fmt != 0) {
+		type = ifc_data_fmt;
+		while (*ifc_data_fmt != 0 && *ifc_data_fmt != ' ') {
+			ifc_data_fmt++;
+		}
+		type_len = ifc_data_fmt - type;
+		if (*ifc_data_fmt == ' ') {
+			ifc_data_fmt++;
+		}
+		name = ifc_data_fmt;
+		while (*ifc_data_fmt != 0 && *ifc_data_fmt != ',') {
+			ifc_data_fmt++;
+		}
+		name_len = ifc_data_fmt - name;
+		if (*ifc_data_fmt == ',') {
+			ifc_data_fmt++;
+		}
+		id = ur_get_id_by_name_len(name, name_len);
+		if (id < 0 || !ur_is_present(tmplt, id)) {
+			return 0;
+		}
+		type_str = ur_field_type_str[ur_get_type(id)];
+		if (strncmp(type, type_str, type_len) != 0 || type_str[type_len] != 0) {
+			return 0;
+		}
+		count++;
+	}
+	return count == tmplt->count;
+}
+
 ur_template_t *ur_define_fields_and_update_template(const char *ifc_data_fmt, ur_template_t *tmplt)
 {
 	ur_template_t *new_tmplt;
+	// negotiation of the same format (e.g. reconnected sender) keeps the template
+	if (tmplt != NULL && ur_template_matches_ifc_spec(tmplt, ifc_data_fmt)) {
+		return tmplt;
+	}
 	if (ur_define_set_of_fields(ifc_data_fmt) < 0) {
 		return NULL;
 	}
@@ -547,16 +724,15 @@ int ur_define_field(const char *name, ur_field_type_t type)
 		}
 	}
 	//check if the field is already defined
-	for (int i = 0; i < ur_field_specs.ur_last_id; i++) {
-		if (ur_field_specs.ur_field_names[i] != NULL && strcmp(name, ur_field_specs.ur_field_names[i]) == 0) {
-			if (type == ur_field_specs.ur_field_types[i]) {
-				//name exists and type is equal
-				return i;
-			}
-			else {
-				//name exists, but type is different
-				return UR_E_TYPE_MISMATCH;
-			}
+	int defined_id = ur_get_id_by_name_len(name, name_len);
+	if (defined_id >= 0) {
+		if (type == ur_field_specs.ur_field_types[defined_id]) {
+			//name exists and type is equal
+			return defined_id;
+		}
+		else {
+			//name exists, but type is different
+			return UR_E_TYPE_MISMATCH;
 		}
 	}
 	//create new field
@@ -575,6 +751,7 @@ int ur_define_field(const char *name, ur_field_type_t type)
 	ur_field_specs.ur_field_names[insert_id] = name_copy;
 	ur_field_specs.ur_field_sizes[insert_id] = ur_size_of(type);
 	ur_field_specs.ur_field_types[insert_id] = type;
+	ur_name_index_insert(insert_id);
 	return insert_id;
 }
 
@@ -596,6 +773,7 @@ int ur_undefine_field_by_id(ur_field_id_t field_id)
 			//error during allocation
 			return UR_E_MEMORY;
 		}
+		ur_name_index_remove(field_id);
 		free(ur_field_specs.ur_field_names[field_id]);
 		ur_field_specs.ur_field_names[field_id] = NULL;
 		undefined_item->id = field_id;
@@ -607,12 +785,10 @@ int ur_undefine_field_by_id(ur_field_id_t field_id)
 
 int ur_undefine_field(const char *name)
 {
-	int i;
-	//find id of field
-	for (i = ur_field_specs.ur_last_statically_defined_id; i < ur_field_specs.ur_last_id; i++) {
-		if (ur_field_specs.ur_field_names[i] != NULL && strcmp(name, ur_field_specs.ur_field_names[i]) == 0) {
-			return ur_undefine_field_by_id(i);
-		}
+	//find id of field, statically defined fields cannot be undefined
+	int id = ur_get_id_by_name_len(name, strlen(name));
+	if (id >= ur_field_specs.ur_last_statically_defined_id) {
+		return ur_undefine_field_by_id(id);
 	}
 	//field with given name was not found
 	return  UR_E_INVALID_NAME;
@@ -625,6 +801,7 @@ void ur_finalize()
 		//there is no need for deallocation, because nothing has been allocated.
 		return;
 	}
+	ur_name_index_clear();
 	if (ur_field_specs.ur_field_names != NULL) {
 		for (int i=0; i < ur_field_specs.ur_last_id; i++) {
 			if (ur_field_specs.ur_field_names[i] != NULL) {
@@ -661,12 +838,7 @@ void ur_finalize()
 // Find field ID given its name
 int ur_get_id_by_name(const char *name)
 {
-   for (int id = 0; id < ur_field_specs.ur_last_id; id++) {
-      if (ur_field_specs.ur_field_names[id] != NULL && strcmp(name, ur_field_specs.ur_field_names[id]) == 0) {
-         return id;
-      }
-   }
-   return UR_E_INVALID_NAME;
+   return ur_get_id_by_name_len(name, strlen(name));
 }
 
 // Return -1 if f1 should go before f2, 0 if f1 is the same as f2, 1 otherwise
@@ -1134,6 +1306,278 @@ void ur_copy_fields(const ur_template_t *dst_tmplt, void* dst, const ur_template
 	}
 }
 
+ur_copy_plan_t *ur_create_copy_plan(const ur_template_t *dst_tmplt, const ur_template_t *src_tmplt)
+{
+	ur_copy_plan_t *plan = calloc(1, sizeof(ur_copy_plan_t));
+	ur_copy_run_t *run = NULL;
+	int id, size;
+	if (plan == NULL) {
+		return NULL;
+	}
+	plan->dst_tmplt = dst_tmplt;
+	plan->src_tmplt = src_tmplt;
+	//templates with the same fields have the same layout
+	if (src_tmplt == dst_tmplt || (src_tmplt->count == dst_tmplt->count && src_tmplt->static_size == dst_tmplt->static_size &&
+	    memcmp(src_tmplt->ids, dst_tmplt->ids, src_tmplt->count * sizeof(*src_tmplt->ids)) == 0)) {
+		plan->whole = 1;
+		return plan;
+	}
+	plan->runs = malloc(dst_tmplt->count * sizeof(ur_copy_run_t));
+	plan->vars = malloc(dst_tmplt->count * sizeof(ur_copy_var_t));
+	if (plan->runs == NULL || plan->vars == NULL) {
+		ur_free_copy_plan(plan);
+		return NULL;
+	}
+	// fields in order of destination record
+	for (int i = 0; i < dst_tmplt->count; i++) {
+		id = dst_tmplt->ids[i];
+		if (!ur_is_present(src_tmplt, id)) {
+			if (ur_is_varlen(id)) {
+				plan->keep_dst_var = 1;
+			}
+			continue;
+		}
+		size = ur_get_size(id);
+		if (size > 0) {
+			// static fields, join with the previous run if they follow it in both records
+			if (run != NULL && run->src_offset + run->len == src_tmplt->offset[id] &&
+			    run->dst_offset + run->len == dst_tmplt->offset[id]) {
+				run->len += size;
+			} else {
+				run = &plan->runs[plan->run_count++];
+				run->src_offset = src_tmplt->offset[id];
+				run->dst_offset = dst_tmplt->offset[id];
+				run->len = size;
+			}
+		} else {
+			// variable-size fields
+			plan->vars[plan->var_count].id = id;
+			plan->vars[plan->var_count].src_offset = src_tmplt->offset[id];
+			plan->vars[plan->var_count].dst_offset = dst_tmplt->offset[id];
+			plan->var_count++;
+		}
+	}
+	return plan;
+}
+
+void ur_copy_with_plan(const ur_copy_plan_t *plan, void *dst, const void *src)
+{
+	const ur_copy_run_t *run;
+	const ur_copy_var_t *var;
+	const uint16_t *src_var;
+	uint16_t *dst_var;
+	uint16_t offset = 0;
+	if (plan->whole) {
+		memcpy(dst, src, ur_rec_size(plan->src_tmplt, src));
+		return;
+	}
+	for (int i = 0; i < plan->run_count; i++) {
+		run = &plan->runs[i];
+		memcpy((char *) dst + run->dst_offset, (const char *) src + run->src_offset, run->len);
+	}
+	if (plan->keep_dst_var) {
+		// values of other fields in dst must be moved
+		for (int i = 0; i < plan->var_count; i++) {
+			var = &plan->vars[i];
+			ur_set_var(plan->dst_tmplt, dst, var->id, ur_get_ptr_by_id(plan->src_tmplt, src, var->id),
+			           ur_get_var_len(plan->src_tmplt, src, var->id));
+		}
+		return;
+	}
+	// all variable-length fields of dst are in src, build variable-length part of dst at once
+	for (int i = 0; i < plan->var_count; i++) {
+		var = &plan->vars[i];
+		src_var = (const uint16_t *) ((const char *) src + var->src_offset);
+		dst_var = (uint16_t *) ((char *) dst + var->dst_offset);
+		memcpy((char *) dst + plan->dst_tmplt->static_size + offset,
+		       (const char *) src + plan->src_tmplt->static_size + src_var[0], src_var[1]);
+		dst_var[0] = offset;
+		dst_var[1] = src_var[1];
+		offset += src_var[1];
+	}
+}
+
+void ur_free_copy_plan(ur_copy_plan_t *plan)
+{
+	if (plan == NULL) {
+		return;
+	}
+	free(plan->runs);
+	free(plan->vars);
+	free(plan);
+}
+
+ur_batch_t *ur_create_batch(const ur_field_id_t *ids, uint16_t count, uint32_t capacity)
+{
+	ur_batch_t *batch = calloc(1, sizeof(ur_batch_t));
+	if (batch == NULL) {
+		return NULL;
+	}
+	batch->columns = calloc(count, sizeof(ur_column_t));
+	if (batch->columns == NULL) {
+		free(batch);
+		return NULL;
+	}
+	batch->column_count = count;
+	for (int i = 0; i < count; i++) {
+		batch->columns[i].id = ids[i];
+		batch->columns[i].size = ur_get_size(ids[i]);
+	}
+	if (ur_batch_reserve(batch, capacity > 0 ? capacity : 1) != UR_OK) {
+		ur_free_batch(batch);
+		return NULL;
+	}
+	return batch;
+}
+
+int ur_batch_reserve(ur_batch_t *batch, uint32_t capacity)
+{
+	ur_column_t *col;
+	void *p;
+	if (capacity <= batch->capacity) {
+		return UR_OK;
+	}
+	p = realloc(batch->recs, capacity * sizeof(void *));
+	if (p == NULL) {
+		return UR_E_MEMORY;
+	}
+	batch->recs = p;
+	p = realloc(batch->sizes, capacity * sizeof(uint16_t));
+	if (p == NULL) {
+		return UR_E_MEMORY;
+	}
+	batch->sizes = p;
+	for (int i = 0; i < batch->column_count; i++) {
+		col = &batch->columns[i];
+		if (col->size > 0) {
+			p = realloc(col->values, capacity * col->size);
+			if (p == NULL) {
+				return UR_E_MEMORY;
+			}
+			col->values = p;
+			col->allocated = capacity * col->size;
+		} else {
+			p = realloc(col->offsets, (capacity + 1) * sizeof(uint32_t));
+			if (p == NULL) {
+				return UR_E_MEMORY;
+			}
+			col->offsets = p;
+		}
+	}
+	batch->capacity = capacity;
+	return UR_OK;
+}
+
+// Copy fixed-length field of all records into column, memcpy of constant size is inlined
+static inline void ur_batch_copy_fixlen(char *dst, const void **recs, uint32_t count, uint16_t offset, int size)
+{
+	switch (size) {
+	case 1:
+		for (uint32_t r = 0; r < count; r++) {
+			dst[r] = *((const char *) recs[r] + offset);
+		}
+		break;
+	case 2:
+		for (uint32_t r = 0; r < count; r++) {
+			memcpy(dst + r * 2, (const char *) recs[r] + offset, 2);
+		}
+		break;
+	case 4:
+		for (uint32_t r = 0; r < count; r++) {
+			memcpy(dst + r * 4, (const char *) recs[r] + offset, 4);
+		}
+		break;
+	case 8:
+		for (uint32_t r = 0; r < count; r++) {
+			memcpy(dst + r * 8, (const char *) recs[r] + offset, 8);
+		}
+		break;
+	case 16:
+		for (uint32_t r = 0; r < count; r++) {
+			memcpy(dst + r * 16, (const char *) recs[r] + offset, 16);
+		}
+		break;
+	default:
+		for (uint32_t r = 0; r < count; r++) {
+			memcpy(dst + r * size, (const char *) recs[r] + offset, size);
+		}
+	}
+}
+
+int ur_batch_fill(ur_batch_t *batch, const ur_template_t *tmplt, const void **recs, const uint16_t *sizes, uint32_t count)
+{
+	ur_column_t *col;
+	uint32_t total;
+	void *p;
+	batch->end = 0;
+	// end of data is not a record
+	for (uint32_t r = 0; r < count; r++) {
+		if (sizes[r] <= 1) {
+			count = r;
+			batch->end = 1;
+			break;
+		}
+	}
+	if (ur_batch_reserve(batch, count) != UR_OK) {
+		batch->count = 0;
+		return UR_E_MEMORY;
+	}
+	batch->count = count;
+	for (int i = 0; i < batch->column_count; i++) {
+		col = &batch->columns[i];
+		col->present = ur_is_present(tmplt, col->id);
+		if (col->size > 0) {
+			// fixed-length field
+			if (col->present) {
+				ur_batch_copy_fixlen(col->values, recs, count, tmplt->offset[col->id], col->size);
+			} else {
+				memset(col->values, 0, count * col->size);
+			}
+			continue;
+		}
+		// variable-length field, values are copied one after another
+		col->offsets[0] = 0;
+		if (!col->present) {
+			memset(col->offsets, 0, (count + 1) * sizeof(uint32_t));
+			continue;
+		}
+		total = 0;
+		for (uint32_t r = 0; r < count; r++) {
+			total += ur_get_var_len(tmplt, recs[r], col->id);
+			col->offsets[r + 1] = total;
+		}
+		if (total > col->allocated) {
+			p = realloc(col->values, total);
+			if (p == NULL) {
+				batch->count = 0;
+				return UR_E_MEMORY;
+			}
+			col->values = p;
+			col->allocated = total;
+		}
+		for (uint32_t r = 0; r < count; r++) {
+			memcpy((char *) col->values + col->offsets[r], ur_get_ptr_by_id(tmplt, recs[r], col->id),
+			       col->offsets[r + 1] - col->offsets[r]);
+		}
+	}
+	return UR_OK;
+}
+
+void ur_free_batch(ur_batch_t *batch)
+{
+	if (batch == NULL) {
+		return;
+	}
+	for (int i = 0; i < batch->column_count; i++) {
+		free(batch->columns[i].values);
+		free(batch->columns[i].offsets);
+	}
+	free(batch->columns);
+	free(batch->recs);
+	free(batch->sizes);
+	free(batch);
+}
+
 // Function for iterating over all fields in a given template
 ur_iter_t ur_iter_fields(const ur_template_t *tmplt, ur_iter_t id)
 {
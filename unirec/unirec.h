@@ -68,6 +68,7 @@ extern "C" {
 #define UR_INITIAL_SIZE_FIELDS_TABLE 5 ///< Initial size of free space in fields tables
 #define UR_FIELD_ID_MAX INT16_MAX       ///< Max ID of a field
 #define UR_FIELDS(...)        ///<  Definition of UniRec fields
+#define UR_STATIC_TEMPLATE(name, spec)  ///< Declaration of template with offsets known at compile-time (see ur_static_get)
 //Iteration constants
 #define UR_ITER_BEGIN (-1)  ///< First value in iterating through the fields
 #define UR_ITER_END INT16_MAX    ///< Last value in iterating through the fields
@@ -206,6 +207,43 @@ typedef struct {
 #define TRAP_CTX_RECEIVE(ctx, ifc_num, data, data_size, tmplt) \
 ({\
    int ret = trap_ctx_recv(ctx, ifc_num, &data, &data_size);\
+   UR_CTX_UPDATE_TEMPLATE(ctx, ret, ifc_num, tmplt);\
+   ret;\
+})
+
+/** \brief Receive batch of records from interface with given context
+ * Receive records that remain in the buffer of libtrap interface (see trap_ctx_recv_bulk)
+ * and store values of fields selected by ur_create_batch into columns of the batch.
+ * If the receiving template is subset of sending template, it will define new fields
+ * and expand receiving template like TRAP_CTX_RECEIVE does.
+ * \param[in] ctx context
+ * \param[in] ifc_num index of libtrap interface
+ * \param[in] tmplt pointer to input template
+ * \param[in] batch pointer to batch created by ur_create_batch, at most batch->capacity
+ *                  records are received
+ * \return return value of trap_ctx_recv_bulk, TRAP_E_MEMORY if columns could not be filled
+ */
+#define TRAP_CTX_RECEIVE_BATCH(ctx, ifc_num, tmplt, batch) \
+({\
+   uint32_t batch_count = 0;\
+   int ret = trap_ctx_recv_bulk(ctx, ifc_num, (batch)->recs, (batch)->sizes, (batch)->capacity, &batch_count);\
+   UR_CTX_UPDATE_TEMPLATE(ctx, ret, ifc_num, tmplt);\
+   if ((ret == TRAP_E_OK || ret == TRAP_E_FORMAT_CHANGED) && tmplt != NULL && \
+       ur_batch_fill(batch, tmplt, (batch)->recs, (batch)->sizes, batch_count) != UR_OK) {\
+      ret = TRAP_E_MEMORY;\
+   }\
+   ret;\
+})
+
+/** \brief Update template after change of data format (internal)
+ * Used by TRAP_CTX_RECEIVE and TRAP_CTX_RECEIVE_BATCH.
+ * \param[in] ctx context
+ * \param[in] ret return value of receive function
+ * \param[in] ifc_num index of libtrap interface
+ * \param[in] tmplt pointer to input template
+ */
+#define UR_CTX_UPDATE_TEMPLATE(ctx, ret, ifc_num, tmplt) \
+({\
    if (ret == TRAP_E_FORMAT_CHANGED) {\
       const char *spec = NULL;\
       uint8_t data_fmt;\
@@ -227,7 +265,6 @@ typedef struct {
          }\
       }\
    }\
-   ret;\
 })
 
 /** \brief Receive data from interface with given context
@@ -478,6 +515,124 @@ char *ur_template_string_delimiter(const ur_template_t * tmplt, int delimiter);
 #define ur_rec_size(tmplt, rec) \
    (ur_rec_fixlen_size(tmplt) + ur_rec_varlen_size(tmplt, rec))
 
+/** \brief Does template match a static template?
+ * Static template "name" is declared by UR_STATIC_TEMPLATE(name, "spec") and
+ * ur_processor.sh generates offsets of its fields into fields.h. The template
+ * matches when all fields of the static template are at the same offsets, e.g.
+ * it was created from the same specifier. Check it whenever the template changes
+ * (e.g. after TRAP_E_FORMAT_CHANGED) and use ur_static_* macros only if it matches.
+ * \param[in] name Name of static template (not a string)
+ * \param[in] tmplt Pointer to UniRec template
+ * \return non-zero if the template matches, zero otherwise
+ */
+#define ur_static_match(name, tmplt) \
+   ur_static_match_ ## name(tmplt)
+
+/** \brief Get value of UniRec field of a static template
+ * Like ur_get but the offset of the field is a constant.
+ * \param[in] name Name of static template (not a string)
+ * \param[in] data Pointer to the beginning of a record
+ * \param[in] field_id Identifier of a fixed-length field. It must be a token beginning with F_.
+ * \return Value of the field.
+ */
+#define ur_static_get(name, data, field_id) \
+   (*(field_id ## _T*)((char*)(data) + UR_TMPLT_ ## name ## _ ## field_id))
+
+/** \brief Set value of UniRec field of a static template
+ * Like ur_set but the offset of the field is a constant.
+ * \param[in] name Name of static template (not a string)
+ * \param[in] data Pointer to the beginning of a record
+ * \param[in] field_id Identifier of a fixed-length field. It must be a token beginning with F_.
+ * \param[in] value The value the field should be set to.
+ */
+#define ur_static_set(name, data, field_id, value) \
+   (*(field_id ## _T*)((char*)(data) + UR_TMPLT_ ## name ## _ ## field_id) = (value))
+
+/** \brief Get pointer to fixed-length UniRec field of a static template
+ * \param[in] name Name of static template (not a string)
+ * \param[in] data Pointer to the beginning of a record
+ * \param[in] field_id Identifier of a fixed-length field. It must be a token beginning with F_.
+ * \return Pointer to the field.
+ */
+#define ur_static_get_ptr(name, data, field_id) \
+   ((field_id ## _T*)((char*)(data) + UR_TMPLT_ ## name ## _ ## field_id))
+
+/** \brief Get pointer to variable-length UniRec field of a static template
+ * \param[in] name Name of static template (not a string)
+ * \param[in] data Pointer to the beginning of a record
+ * \param[in] field_id Identifier of a variable-length field. It must be a token beginning with F_.
+ * \return Pointer to the field.
+ */
+#define ur_static_get_var_ptr(name, data, field_id) \
+   ((field_id ## _T*)((char*)(data) + UR_TMPLT_ ## name ## _SIZE + \
+   *((uint16_t*)((char*)(data) + UR_TMPLT_ ## name ## _ ## field_id))))
+
+/** \brief Get length of variable-length UniRec field of a static template
+ * \param[in] name Name of static template (not a string)
+ * \param[in] data Pointer to the beginning of a record
+ * \param[in] field_id Identifier of a variable-length field. It must be a token beginning with F_.
+ * \return Length of the field in bytes.
+ */
+#define ur_static_get_var_len(name, data, field_id) \
+   (*((uint16_t*)((char*)(data) + UR_TMPLT_ ## name ## _ ## field_id + 2)))
+
+/** \brief Get value of UniRec field, use static template if it matches
+ * \param[in] name Name of static template (not a string)
+ * \param[in] match Result of ur_static_match for the template
+ * \param[in] tmplt Pointer to UniRec template
+ * \param[in] data Pointer to the beginning of a record
+ * \param[in] field_id Identifier of a fixed-length field. It must be a token beginning with F_.
+ * \return Value of the field.
+ */
+#define ur_fast_get(name, match, tmplt, data, field_id) \
+   (*(field_id ## _T*)((char*)(data) + ((match) ? UR_TMPLT_ ## name ## _ ## field_id : (tmplt)->offset[field_id])))
+
+/** \brief Set value of UniRec field, use static template if it matches
+ * \param[in] name Name of static template (not a string)
+ * \param[in] match Result of ur_static_match for the template
+ * \param[in] tmplt Pointer to UniRec template
+ * \param[in] data Pointer to the beginning of a record
+ * \param[in] field_id Identifier of a fixed-length field. It must be a token beginning with F_.
+ * \param[in] value The value the field should be set to.
+ */
+#define ur_fast_set(name, match, tmplt, data, field_id, value) \
+   (*(field_id ## _T*)((char*)(data) + ((match) ? UR_TMPLT_ ## name ## _ ## field_id : (tmplt)->offset[field_id])) = (value))
+
+/** \brief Get pointer to fixed-length UniRec field, use static template if it matches
+ * \param[in] name Name of static template (not a string)
+ * \param[in] match Result of ur_static_match for the template
+ * \param[in] tmplt Pointer to UniRec template
+ * \param[in] data Pointer to the beginning of a record
+ * \param[in] field_id Identifier of a fixed-length field. It must be a token beginning with F_.
+ * \return Pointer to the field.
+ */
+#define ur_fast_get_ptr(name, match, tmplt, data, field_id) \
+   ((field_id ## _T*)((char*)(data) + ((match) ? UR_TMPLT_ ## name ## _ ## field_id : (tmplt)->offset[field_id])))
+
+/** \brief Get pointer to variable-length UniRec field, use static template if it matches
+ * \param[in] name Name of static template (not a string)
+ * \param[in] match Result of ur_static_match for the template
+ * \param[in] tmplt Pointer to UniRec template
+ * \param[in] data Pointer to the beginning of a record
+ * \param[in] field_id Identifier of a variable-length field. It must be a token beginning with F_.
+ * \return Pointer to the field.
+ */
+#define ur_fast_get_var_ptr(name, match, tmplt, data, field_id) \
+   ((match) ? (field_id ## _T*)((char*)(data) + UR_TMPLT_ ## name ## _SIZE + \
+   *((uint16_t*)((char*)(data) + UR_TMPLT_ ## name ## _ ## field_id))) : \
+   (field_id ## _T*)((char*)(data) + (tmplt)->static_size + *((uint16_t*)((char*)(data) + (tmplt)->offset[field_id]))))
+
+/** \brief Get length of variable-length UniRec field, use static template if it matches
+ * \param[in] name Name of static template (not a string)
+ * \param[in] match Result of ur_static_match for the template
+ * \param[in] tmplt Pointer to UniRec template
+ * \param[in] data Pointer to the beginning of a record
+ * \param[in] field_id Identifier of a variable-length field. It must be a token beginning with F_.
+ * \return Length of the field in bytes.
+ */
+#define ur_fast_get_var_len(name, match, tmplt, data, field_id) \
+   (*((uint16_t*)((char*)(data) + ((match) ? UR_TMPLT_ ## name ## _ ## field_id : (tmplt)->offset[field_id]) + 2)))
+
 /** \brief Initialize UniRec structures
  * Initialize UniRec structures. Function is called during defining first own field.
  * \param[in] field_specs_static Structure of statically-known UniRec fields.
@@ -548,7 +703,9 @@ int ur_undefine_field(const char *name);
 void ur_finalize();
 
 /** \brief Get ID of a field by its name
- * Get ID of a field by its name.
+ * Get ID of a field by its name. Names are looked up in a hash index, which is
+ * built by ur_init and updated when fields are defined or undefined. The lookup
+ * does not modify the index, names are searched linearly before ur_init.
  * \param[in] name String with name of a field.
  * \return ID of a field. UR_E_INVALID_NAME (negative value) if the name is not known.
  */
@@ -709,6 +866,8 @@ ur_template_t *ur_expand_template(const char *ifc_data_fmt, ur_template_t * tmpl
  * Order of fields is not important (templates with the same set of fields are
  * equivalent).
  * In case of success the given template will be destroyed and new template will be returned.
+ * If the given template already contains exactly the fields of ifc_data_fmt
+ * (e.g. the same format is negotiated again), it is returned unchanged.
  * \param[in] ifc_data_fmt String with types and names of fields delimited by commas
  * \param[in] tmplt Pointer to an existing template.
  * \return Pointer to the updated template or NULL in case of error.
@@ -819,6 +978,168 @@ char *ur_get_var_as_str(const ur_template_t *tmplt, const void *rec, ur_field_id
  */
 void ur_copy_fields(const ur_template_t *dst_tmplt, void* dst, const ur_template_t *src_tmplt, const void* src);
 
+/** \brief Run of fixed-length fields copied by one memcpy (part of ur_copy_plan_t).
+ */
+typedef struct {
+   uint16_t src_offset;    ///< Offset of the run in source record
+   uint16_t dst_offset;    ///< Offset of the run in destination record
+   uint16_t len;           ///< Length of the run
+} ur_copy_run_t;
+
+/** \brief Variable-length field copied by a copy plan (part of ur_copy_plan_t).
+ */
+typedef struct {
+   ur_field_id_t id;       ///< ID of the field
+   uint16_t src_offset;    ///< Offset of the field (its offset/length header) in source record
+   uint16_t dst_offset;    ///< Offset of the field (its offset/length header) in destination record
+} ur_copy_var_t;
+
+/** \brief Precompiled copy of fields between two templates.
+ * Result of ur_create_copy_plan, it is used by ur_copy_with_plan. Fixed-length
+ * fields present in both templates are coalesced into runs that are adjacent in
+ * both records, variable-length fields are listed in order of destination record.
+ * The plan is valid as long as both templates are not changed (e.g. expanded).
+ */
+typedef struct {
+   const ur_template_t *dst_tmplt;  ///< Destination template
+   const ur_template_t *src_tmplt;  ///< Source template
+   uint8_t whole;          ///< Records have the same layout, whole record is copied by one memcpy
+   uint8_t keep_dst_var;   ///< Destination has variable-length fields missing in source, they must be kept
+   uint16_t run_count;     ///< Number of runs
+   uint16_t var_count;     ///< Number of variable-length fields
+   ur_copy_run_t *runs;    ///< Runs of fixed-length fields
+   ur_copy_var_t *vars;    ///< Variable-length fields present in both templates
+} ur_copy_plan_t;
+
+/**
+ * \brief Create plan of copying fields from one template to another.
+ * The plan makes ur_copy_with_plan equivalent to ur_copy_fields with the same
+ * templates but it does not search the templates for every record. Use it when
+ * many records are copied between the same templates.
+ * \param[in] dst_tmplt Pointer to destination UniRec template
+ * \param[in] src_tmplt Pointer to source UniRec template
+ * \return Pointer to the plan or NULL on allocation error. It should be freed
+ * using ur_free_copy_plan.
+ */
+ur_copy_plan_t *ur_create_copy_plan(const ur_template_t *dst_tmplt, const ur_template_t *src_tmplt);
+
+/**
+ * \brief Copy data from one UniRec record to another using a copy plan.
+ * Copies all fields present in both templates of the plan from src to dst
+ * like ur_copy_fields does. Variable-length part of dst is rebuilt in one
+ * pass unless dst contains variable-length fields that are not in src.
+ * "dst" must point to a memory of enough size.
+ * \param[in] plan Pointer to copy plan created by ur_create_copy_plan
+ * \param[in] dst Pointer to destination record
+ * \param[in] src Pointer to source record
+ */
+void ur_copy_with_plan(const ur_copy_plan_t *plan, void *dst, const void *src);
+
+/**
+ * \brief Free copy plan created by ur_create_copy_plan.
+ * \param[in] plan Pointer to copy plan (NULL is ignored)
+ */
+void ur_free_copy_plan(ur_copy_plan_t *plan);
+
+/** \brief Column of a batch of records (part of ur_batch_t).
+ * Values of a fixed-length field are stored in an array (value of i-th record is
+ * at index i). Values of a variable-length field are stored one after another,
+ * value of i-th record starts at offsets[i] and ends at offsets[i + 1].
+ */
+typedef struct {
+   ur_field_id_t id;       ///< ID of the field
+   int16_t size;           ///< Size of a value, -1 for variable-length field
+   uint8_t present;        ///< Field is present in template of the last batch (values are zero or empty otherwise)
+   void *values;           ///< Values of the field
+   uint32_t *offsets;      ///< Offsets of values of variable-length field (count + 1 items), NULL for fixed-length field
+   uint32_t allocated;     ///< Allocated size of values in bytes
+} ur_column_t;
+
+/** \brief Batch of records stored by columns.
+ * Values of selected fields of a batch of records (e.g. all records of a buffer
+ * received by trap_ctx_recv_bulk) are copied into contiguous arrays, so a loop
+ * over records reads only the needed memory and it can be vectorized. Columns
+ * are allocated by ur_create_batch and reused by all batches, they grow only
+ * when a batch has more records or longer variable-length values.
+ */
+typedef struct {
+   uint32_t count;         ///< Number of records in the batch
+   uint32_t capacity;      ///< Number of records the columns are allocated for
+   uint16_t column_count;  ///< Number of columns
+   uint8_t end;            ///< Batch ended by a message that is not a record (size <= 1, end of data)
+   ur_column_t *columns;   ///< Columns in order of fields given to ur_create_batch
+   const void **recs;      ///< Pointers to records (capacity items), used by TRAP_CTX_RECEIVE_BATCH
+   uint16_t *sizes;        ///< Sizes of records (capacity items), used by TRAP_CTX_RECEIVE_BATCH
+} ur_batch_t;
+
+/**
+ * \brief Create batch of records stored by columns.
+ * \param[in] ids Array of IDs of fields that are stored in columns
+ * \param[in] count Number of fields
+ * \param[in] capacity Initial number of records of a batch (it grows when needed)
+ * \return Pointer to the batch or NULL on allocation error. It should be freed
+ * using ur_free_batch.
+ */
+ur_batch_t *ur_create_batch(const ur_field_id_t *ids, uint16_t count, uint32_t capacity);
+
+/**
+ * \brief Enlarge columns of batch.
+ * Columns are enlarged to hold values of at least "capacity" records.
+ * Variable-length values are enlarged by ur_batch_fill when needed.
+ * \param[in,out] batch Pointer to batch created by ur_create_batch
+ * \param[in] capacity Number of records
+ * \return UR_OK on success, UR_E_MEMORY on allocation error.
+ */
+int ur_batch_reserve(ur_batch_t *batch, uint32_t capacity);
+
+/**
+ * \brief Fill columns of batch by values of records.
+ * Records are given as arrays of pointers and sizes (e.g. output of trap_ctx_recv_bulk).
+ * The first message of size 0 or 1 (end of data) ends the batch and sets batch->end.
+ * Columns of fields that are not present in the template contain zeros (or
+ * empty values) and their "present" is 0.
+ * \param[in,out] batch Pointer to batch created by ur_create_batch
+ * \param[in] tmplt Pointer to UniRec template of records
+ * \param[in] recs Array of pointers to records
+ * \param[in] sizes Array of sizes of records
+ * \param[in] count Number of records
+ * \return UR_OK on success, UR_E_MEMORY if columns could not be enlarged.
+ */
+int ur_batch_fill(ur_batch_t *batch, const ur_template_t *tmplt, const void **recs, const uint16_t *sizes, uint32_t count);
+
+/**
+ * \brief Free batch created by ur_create_batch.
+ * \param[in] batch Pointer to batch (NULL is ignored)
+ */
+void ur_free_batch(ur_batch_t *batch);
+
+/** \brief Get array of values of a fixed-length field of a batch
+ * \param[in] batch Pointer to batch
+ * \param[in] column Index of the column (order of fields given to ur_create_batch)
+ * \param[in] field_id Identifier of the field. It must be a token beginning with F_.
+ * \return Pointer to array of batch->count values of the field.
+ */
+#define ur_batch_get_column(batch, column, field_id) \
+   ((field_id ## _T*)(batch)->columns[column].values)
+
+/** \brief Get pointer to value of a variable-length field of i-th record of a batch
+ * \param[in] batch Pointer to batch
+ * \param[in] column Index of the column (order of fields given to ur_create_batch)
+ * \param[in] i Index of the record
+ * \return Pointer to the value (char*).
+ */
+#define ur_batch_get_var_ptr(batch, column, i) \
+   ((char*)(batch)->columns[column].values + (batch)->columns[column].offsets[i])
+
+/** \brief Get length of a variable-length field of i-th record of a batch
+ * \param[in] batch Pointer to batch
+ * \param[in] column Index of the column (order of fields given to ur_create_batch)
+ * \param[in] i Index of the record
+ * \return Length of the value in bytes.
+ */
+#define ur_batch_get_var_len(batch, column, i) \
+   ((batch)->columns[column].offsets[(i) + 1] - (batch)->columns[column].offsets[i])
+
 /**
  * \brief Copy data from one UniRec to another.
  * Procedure gets template and void pointer of source and destination.
@@ -0,0 +1,999 @@
+/**
+ * \file ur_filter.c
+ * \brief Compilation and evaluation of filters of UniRec records.
+ */
+/*
+ * Copyright (C) 2026 CESNET
+ *
+ * LICENSE TERMS
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name of the Company nor the names of its contributors
+ *    may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ *
+ * ALTERNATIVELY, provided that this notice is retained in full, this
+ * product may be distributed under the terms of the GNU General Public
+ * License (GPL) version 2 or later, in which case the provisions
+ * of the GPL apply INSTEAD OF those given above.
+ *
+ * This software is provided ``as is'', and any express or implied
+ * warranties, including, but not limited to, the implied warranties of
+ * merchantability and fitness for a particular purpose are disclaimed.
+ * In no event shall the company or contributors be liable for any
+ * direct, indirect, incidental, special, exemplary, or consequential
+ * damages (including, but not limited to, procurement of substitute
+ * goods or services; loss of use, data, or profits; or business
+ * interruption) however caused and on any theory of liability, whether
+ * in contract, strict liability, or tort (including negligence or
+ * otherwise) arising in any way out of the use of this software, even
+ * if advised of the possibility of such damage.
+ *
+ */
+
+#define _DEFAULT_SOURCE
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <ctype.h>
+#include <errno.h>
+#include <math.h>
+#include "unirec.h"
+#include "ur_filter.h"
+
+// defined in unirec.c
+extern const char UR_MEMORY_ERROR[];
+extern const int ur_field_type_size[];
+extern ur_field_specs_t ur_field_specs;
+
+/** Number of records evaluated at once by ur_filter_eval_batch. */
+#define UR_FILTER_BLOCK 1024
+/** Number of bitmap words of one block. */
+#define UR_FILTER_BLOCK_WORDS (UR_FILTER_BLOCK / 64)
+/** Maximal length of an error message. */
+#define UR_FILTER_ERR_LEN 256
+/** Maximal length of a value in the expression. */
+#define UR_FILTER_WORD_LEN 64
+/** Flipping the sign bit makes order of signed integers and unsigned keys the same. */
+#define UR_FILTER_SIGN_BIT 0x8000000000000000ULL
+
+/** Instructions of a compiled filter. */
+enum {
+	UR_FILTER_OP_LEAF, ///< push result of a predicate
+	UR_FILTER_OP_AND,  ///< pop two results, push their conjunction
+	UR_FILTER_OP_OR,   ///< pop two results, push their disjunction
+	UR_FILTER_OP_NOT,  ///< negate result on the top of the stack
+};
+
+/** Kinds of predicates. */
+enum {
+	UR_FILTER_NUMERIC, ///< key of the value is in one of ranges [lo, hi]
+	UR_FILTER_IP,      ///< address masked by one of masks equals a value
+	UR_FILTER_STRING,  ///< value equals one of strings
+};
+
+/** \brief Instruction of a compiled filter. */
+typedef struct {
+	uint8_t op;    ///< UR_FILTER_OP_*
+	uint32_t leaf; ///< index of the predicate for UR_FILTER_OP_LEAF
+} ur_filter_instr_t;
+
+/** \brief Predicate on a single field.
+ * Values of numeric fields are converted to uint64_t keys keeping their order,
+ * so every comparison becomes a test of membership in a set of ranges.
+ */
+typedef struct {
+	uint8_t kind;      ///< UR_FILTER_NUMERIC, UR_FILTER_IP or UR_FILTER_STRING
+	uint8_t type;      ///< type of the field
+	uint8_t negate;    ///< result is negated
+	uint16_t offset;   ///< offset of the field in the record
+	uint32_t count;    ///< number of ranges, prefixes or strings
+	uint32_t allocated; ///< allocated number of items
+	uint64_t *lo;      ///< low keys of ranges or masks of prefixes (2 words per prefix)
+	uint64_t *hi;      ///< high keys of ranges or values of prefixes (2 words per prefix)
+	char **str;        ///< strings
+	uint16_t *len;     ///< lengths of strings
+} ur_filter_leaf_t;
+
+struct ur_filter_s {
+	const ur_template_t *tmplt; ///< template the filter was compiled for
+	ur_filter_instr_t *code;    ///< program in postfix order
+	uint32_t code_count;        ///< number of instructions
+	uint32_t code_allocated;    ///< allocated number of instructions
+	ur_filter_leaf_t *leaves;   ///< predicates
+	uint32_t leaf_count;        ///< number of predicates
+	uint32_t leaf_allocated;    ///< allocated number of predicates
+	uint32_t depth;             ///< actual depth of stack during compilation
+	uint32_t max_depth;         ///< maximal depth of stack of bitmaps
+	uint64_t *stack;            ///< stack of bitmaps of one block
+	uint64_t *keys;             ///< keys of values of one block
+	uint8_t *mask;              ///< results of a predicate of one block
+};
+
+/** \brief State of the parser. */
+typedef struct {
+	const char *expr;           ///< the whole expression
+	const char *pos;            ///< actual position in the expression
+	ur_filter_t *filter;        ///< filter being compiled
+	char err[UR_FILTER_ERR_LEN]; ///< error message, empty if there is no error
+} ur_filter_parser_t;
+
+/* Conversion of values to keys */
+
+static inline uint64_t ur_filter_int_key(int64_t v)
+{
+	return (uint64_t) v ^ UR_FILTER_SIGN_BIT;
+}
+
+static inline uint32_t ur_filter_int32_key(int32_t v)
+{
+	return (uint32_t) v ^ 0x80000000U;
+}
+
+static inline uint64_t ur_filter_double_key(double d)
+{
+	uint64_t bits;
+	d += 0.0; // -0.0 becomes 0.0
+	memcpy(&bits, &d, sizeof(bits));
+	return (bits & UR_FILTER_SIGN_BIT) ? ~bits : (bits | UR_FILTER_SIGN_BIT);
+}
+
+static int ur_filter_is_signed(int type)
+{
+	return type == UR_TYPE_INT8 || type == UR_TYPE_INT16 || type == UR_TYPE_INT32 || type == UR_TYPE_INT64;
+}
+
+/** Keys of types with values of 64 bits are uint64_t, keys of smaller integers
+ * fit into uint32_t, which can be compared by vector instructions of any CPU. */
+static int ur_filter_is_wide(int type)
+{
+	return type == UR_TYPE_UINT64 || type == UR_TYPE_INT64 || type == UR_TYPE_FLOAT || type == UR_TYPE_DOUBLE;
+}
+
+/** Get the lowest and the highest key of values of a numeric type. */
+static void ur_filter_key_limits(int type, int size, uint64_t *min, uint64_t *max)
+{
+	if (type == UR_TYPE_FLOAT || type == UR_TYPE_DOUBLE) {
+		*min = ur_filter_double_key(-INFINITY);
+		*max = ur_filter_double_key(INFINITY);
+	} else if (ur_filter_is_signed(type)) {
+		if (size == 8) {
+			*min = ur_filter_int_key(INT64_MIN);
+			*max = ur_filter_int_key(INT64_MAX);
+		} else {
+			*min = ur_filter_int32_key(-((int32_t) 1 << (size * 8 - 1)));
+			*max = ur_filter_int32_key(((int64_t) 1 << (size * 8 - 1)) - 1);
+		}
+	} else {
+		*min = 0;
+		*max = size == 8 ? UINT64_MAX : ((uint64_t) 1 << (size * 8)) - 1;
+	}
+}
+
+/* Building of the filter */
+
+static void ur_filter_error(ur_filter_parser_t *p, const char *msg, const char *what)
+{
+	if (p->err[0] == '\0') {
+		snprintf(p->err, sizeof(p->err), "%s%s at position %d of filter", msg, what, (int) (p->pos - p->expr));
+	}
+}
+
+static int ur_filter_emit(ur_filter_parser_t *p, uint8_t op, uint32_t leaf)
+{
+	ur_filter_t *f = p->filter;
+	if (f->code_count == f->code_allocated) {
+		uint32_t allocated = f->code_allocated ? f->code_allocated * 2 : 16;
+		ur_filter_instr_t *code = realloc(f->code, allocated * sizeof(ur_filter_instr_t));
+		if (code == NULL) {
+			ur_filter_error(p, UR_MEMORY_ERROR, "");
+			return -1;
+		}
+		f->code = code;
+		f->code_allocated = allocated;
+	}
+	f->code[f->code_count].op = op;
+	f->code[f->code_count].leaf = leaf;
+	f->code_count++;
+	if (op == UR_FILTER_OP_LEAF) {
+		if (++f->depth > f->max_depth) {
+			f->max_depth = f->depth;
+		}
+	} else if (op != UR_FILTER_OP_NOT) {
+		f->depth--;
+	}
+	return 0;
+}
+
+static ur_filter_leaf_t *ur_filter_add_leaf(ur_filter_parser_t *p)
+{
+	ur_filter_t *f = p->filter;
+	if (f->leaf_count == f->leaf_allocated) {
+		uint32_t allocated = f->leaf_allocated ? f->leaf_allocated * 2 : 8;
+		ur_filter_leaf_t *leaves = realloc(f->leaves, allocated * sizeof(ur_filter_leaf_t));
+		if (leaves == NULL) {
+			ur_filter_error(p, UR_MEMORY_ERROR, "");
+			return NULL;
+		}
+		f->leaves = leaves;
+		f->leaf_allocated = allocated;
+	}
+	memset(&f->leaves[f->leaf_count], 0, sizeof(ur_filter_leaf_t));
+	return &f->leaves[f->leaf_count++];
+}
+
+/** Make space for one more item of a predicate. */
+static int ur_filter_reserve_item(ur_filter_parser_t *p, ur_filter_leaf_t *leaf)
+{
+	if (leaf->count < leaf->allocated) {
+		return 0;
+	}
+	uint32_t allocated = leaf->allocated ? leaf->allocated * 2 : 4;
+	uint64_t *lo = realloc(leaf->lo, 2 * allocated * sizeof(uint64_t));
+	if (lo != NULL) {
+		leaf->lo = lo;
+	}
+	uint64_t *hi = realloc(leaf->hi, 2 * allocated * sizeof(uint64_t));
+	if (hi != NULL) {
+		leaf->hi = hi;
+	}
+	char **str = realloc(leaf->str, allocated * sizeof(char *));
+	if (str != NULL) {
+		leaf->str = str;
+	}
+	uint16_t *len = realloc(leaf->len, allocated * sizeof(uint16_t));
+	if (len != NULL) {
+		leaf->len = len;
+	}
+	if (lo == NULL || hi == NULL || str == NULL || len == NULL) {
+		ur_filter_error(p, UR_MEMORY_ERROR, "");
+		return -1;
+	}
+	leaf->allocated = allocated;
+	return 0;
+}
+
+/* Parsing */
+
+static void ur_filter_skip_space(ur_filter_parser_t *p)
+{
+	while (isspace((unsigned char) *p->pos)) {
+		p->pos++;
+	}
+}
+
+/** Skip given token if it is at the actual position. */
+static int ur_filter_accept(ur_filter_parser_t *p, const char *token)
+{
+	size_t len = strlen(token);
+	ur_filter_skip_space(p);
+	if (strncmp(p->pos, token, len) != 0) {
+		return 0;
+	}
+	// "!" must not be a part of "!=" and "in" must be a whole word
+	if ((strcmp(token, "!") == 0 && p->pos[1] == '=') ||
+	    (isalpha((unsigned char) token[0]) && (isalnum((unsigned char) p->pos[len]) || p->pos[len] == '_'))) {
+		return 0;
+	}
+	p->pos += len;
+	return 1;
+}
+
+/** Read a value up to a delimiter into buffer word. */
+static int ur_filter_read_word(ur_filter_parser_t *p, char *word)
+{
+	size_t len = 0;
+	ur_filter_skip_space(p);
+	while (p->pos[len] != '\0' && !isspace((unsigned char) p->pos[len]) && strchr(",[]()&|!=<>\"", p->pos[len]) == NULL) {
+		len++;
+	}
+	if (len == 0) {
+		ur_filter_error(p, "Expected value", "");
+		return -1;
+	}
+	if (len >= UR_FILTER_WORD_LEN) {
+		ur_filter_error(p, "Too long value", "");
+		return -1;
+	}
+	memcpy(word, p->pos, len);
+	word[len] = '\0';
+	p->pos += len;
+	return 0;
+}
+
+/** Convert a numeric value in a string to a key. */
+static int ur_filter_parse_key(ur_filter_parser_t *p, const ur_filter_leaf_t *leaf, const char *word, uint64_t *key)
+{
+	int size = ur_size_of(leaf->type);
+	uint64_t min, max;
+	char *end;
+	errno = 0;
+	if (leaf->type == UR_TYPE_FLOAT || leaf->type == UR_TYPE_DOUBLE) {
+		double d = strtod(word, &end);
+		if (*end != '\0' || d != d) {
+			ur_filter_error(p, "Invalid number ", word);
+			return -1;
+		}
+		*key = ur_filter_double_key(d);
+		return 0;
+	}
+	int base = (word[0] == '0' && (word[1] == 'x' || word[1] == 'X')) ? 16 : 10;
+	ur_filter_key_limits(leaf->type, size, &min, &max);
+	if (ur_filter_is_signed(leaf->type)) {
+		long long v = strtoll(word, &end, base);
+		if (size == 8) {
+			*key = ur_filter_int_key(v);
+		} else if (v < -(1LL << (size * 8 - 1)) || v >= (1LL << (size * 8 - 1))) {
+			errno = ERANGE;
+		} else {
+			*key = ur_filter_int32_key(v);
+		}
+	} else {
+		unsigned long long v = strtoull(word, &end, base);
+		*key = v;
+		if (word[0] == '-') {
+			errno = ERANGE;
+		}
+	}
+	if (end == word || *end != '\0') {
+		ur_filter_error(p, "Invalid number ", word);
+		return -1;
+	}
+	if (errno == ERANGE || *key < min || *key > max) {
+		ur_filter_error(p, "Value out of range of the field ", word);
+		return -1;
+	}
+	return 0;
+}
+
+/** Add a range of keys to a numeric predicate, empty ranges are ignored. */
+static int ur_filter_add_range(ur_filter_parser_t *p, ur_filter_leaf_t *leaf, uint64_t lo, uint64_t hi)
+{
+	if (lo > hi) {
+		return 0;
+	}
+	if (ur_filter_reserve_item(p, leaf) != 0) {
+		return -1;
+	}
+	leaf->lo[leaf->count] = lo;
+	leaf->hi[leaf->count] = hi;
+	leaf->count++;
+	return 0;
+}
+
+/** Parse an address or a prefix and add it to an ipaddr predicate. */
+static int ur_filter_parse_prefix(ur_filter_parser_t *p, ur_filter_leaf_t *leaf)
+{
+	char word[UR_FILTER_WORD_LEN];
+	uint8_t mask[16] = {0};
+	ip_addr_t addr;
+	int bits, first, max_bits;
+	char *slash, *end;
+
+	if (ur_filter_read_word(p, word) != 0) {
+		return -1;
+	}
+	slash = strchr(word, '/');
+	if (slash != NULL) {
+		*slash = '\0';
+	}
+	if (!ip_from_str(word, &addr)) {
+		ur_filter_error(p, "Invalid IP address ", word);
+		return -1;
+	}
+	if (ip_is4(&addr)) {
+		// IPv4 address is stored in bytes 8 - 11, other bytes are constant
+		memset(mask, 0xff, 8);
+		memset(mask + 12, 0xff, 4);
+		first = 8;
+		max_bits = 32;
+	} else {
+		first = 0;
+		max_bits = 128;
+	}
+	bits = max_bits;
+	if (slash != NULL) {
+		bits = strtol(slash + 1, &end, 10);
+		if (slash[1] == '\0' || *end != '\0' || bits < 0 || bits > max_bits) {
+			ur_filter_error(p, "Invalid prefix length ", slash + 1);
+			return -1;
+		}
+	}
+	for (int i = 0; i < bits; i++) {
+		mask[first + i / 8] |= 0x80 >> (i % 8);
+	}
+	if (ur_filter_reserve_item(p, leaf) != 0) {
+		return -1;
+	}
+	memcpy(&leaf->lo[2 * leaf->count], mask, 16);
+	leaf->hi[2 * leaf->count] = addr.ui64[0] & leaf->lo[2 * leaf->count];
+	leaf->hi[2 * leaf->count + 1] = addr.ui64[1] & leaf->lo[2 * leaf->count + 1];
+	leaf->count++;
+	return 0;
+}
+
+/** Parse a string literal and add it to a string predicate. */
+static int ur_filter_parse_string(ur_filter_parser_t *p, ur_filter_leaf_t *leaf)
+{
+	const char *start;
+	char *str;
+	size_t len = 0;
+
+	ur_filter_skip_space(p);
+	if (*p->pos != '"') {
+		ur_filter_error(p, "Expected string", "");
+		return -1;
+	}
+	start = ++p->pos;
+	while (*p->pos != '"') {
+		if (*p->pos == '\0') {
+			ur_filter_error(p, "Unterminated string", "");
+			return -1;
+		}
+		if (*p->pos == '\\' && p->pos[1] != '\0') {
+			p->pos++;
+		}
+		p->pos++;
+		len++;
+	}
+	if (len > UINT16_MAX) {
+		ur_filter_error(p, "Too long string", "");
+		return -1;
+	}
+	if (ur_filter_reserve_item(p, leaf) != 0) {
+		return -1;
+	}
+	str = malloc(len + 1);
+	if (str == NULL) {
+		ur_filter_error(p, UR_MEMORY_ERROR, "");
+		return -1;
+	}
+	// copy without escaping backslashes
+	for (size_t i = 0; i < len; i++) {
+		if (*start == '\\') {
+			start++;
+		}
+		str[i] = *(start++);
+	}
+	str[len] = '\0';
+	p->pos++;
+	leaf->str[leaf->count] = str;
+	leaf->len[leaf->count] = len;
+	leaf->count++;
+	return 0;
+}
+
+/** Parse an item of a set: a value, a range of values, a prefix or a string. */
+static int ur_filter_parse_item(ur_filter_parser_t *p, ur_filter_leaf_t *leaf)
+{
+	char word[UR_FILTER_WORD_LEN];
+	uint64_t lo, hi;
+	char *dots;
+
+	if (leaf->kind == UR_FILTER_IP) {
+		return ur_filter_parse_prefix(p, leaf);
+	} else if (leaf->kind == UR_FILTER_STRING) {
+		return ur_filter_parse_string(p, leaf);
+	}
+	if (ur_filter_read_word(p, word) != 0) {
+		return -1;
+	}
+	dots = strstr(word, "..");
+	if (dots != NULL) {
+		*dots = '\0';
+		if (ur_filter_parse_key(p, leaf, word, &lo) != 0 || ur_filter_parse_key(p, leaf, dots + 2, &hi) != 0) {
+			return -1;
+		}
+	} else {
+		if (ur_filter_parse_key(p, leaf, word, &lo) != 0) {
+			return -1;
+		}
+		hi = lo;
+	}
+	return ur_filter_add_range(p, leaf, lo, hi);
+}
+
+/** Parse a predicate "FIELD op value" or "FIELD in set". */
+static int ur_filter_parse_predicate(ur_filter_parser_t *p)
+{
+	static const char *ops[] = {"==", "!=", "<=", ">=", "<", ">", "in"};
+	char name[UR_FILTER_WORD_LEN];
+	size_t len = 0;
+	int id, type, op;
+	uint64_t min, max, key;
+	ur_filter_leaf_t *leaf;
+
+	ur_filter_skip_space(p);
+	while (isalnum((unsigned char) p->pos[len]) || p->pos[len] == '_') {
+		len++;
+	}
+	if (len == 0 || len >= sizeof(name)) {
+		ur_filter_error(p, "Expected name of a field", "");
+		return -1;
+	}
+	memcpy(name, p->pos, len);
+	name[len] = '\0';
+	id = ur_get_id_by_name(name);
+	if (id < 0) {
+		ur_filter_error(p, "Unknown field ", name);
+		return -1;
+	}
+	if (!ur_is_present(p->filter->tmplt, id)) {
+		ur_filter_error(p, "Field is not in the template ", name);
+		return -1;
+	}
+	type = ur_get_type(id);
+	if (type == UR_TYPE_TIME) {
+		ur_filter_error(p, "Type time is not supported ", name);
+		return -1;
+	}
+	p->pos += len;
+	for (op = 0; op < (int) (sizeof(ops) / sizeof(ops[0])); op++) {
+		if (ur_filter_accept(p, ops[op])) {
+			break;
+		}
+	}
+	if (op == sizeof(ops) / sizeof(ops[0])) {
+		ur_filter_error(p, "Expected operator", "");
+		return -1;
+	}
+
+	leaf = ur_filter_add_leaf(p);
+	if (leaf == NULL) {
+		return -1;
+	}
+	leaf->type = type;
+	leaf->offset = p->filter->tmplt->offset[id];
+	if (type == UR_TYPE_IP) {
+		leaf->kind = UR_FILTER_IP;
+	} else if (type == UR_TYPE_STRING || type == UR_TYPE_BYTES) {
+		leaf->kind = UR_FILTER_STRING;
+	} else {
+		leaf->kind = UR_FILTER_NUMERIC;
+	}
+	if (leaf->kind != UR_FILTER_NUMERIC && op >= 2 && op <= 5) {
+		ur_filter_error(p, "Operator is not supported by type of field ", name);
+		return -1;
+	}
+
+	if (op == 6) {
+		// set of items
+		if (ur_filter_accept(p, "[")) {
+			do {
+				if (ur_filter_parse_item(p, leaf) != 0) {
+					return -1;
+				}
+			} while (ur_filter_accept(p, ","));
+			if (!ur_filter_accept(p, "]")) {
+				ur_filter_error(p, "Expected ]", "");
+				return -1;
+			}
+		} else if (ur_filter_parse_item(p, leaf) != 0) {
+			return -1;
+		}
+	} else if (leaf->kind != UR_FILTER_NUMERIC) {
+		if (ur_filter_parse_item(p, leaf) != 0) {
+			return -1;
+		}
+		leaf->negate = (op == 1);
+	} else {
+		// comparison is converted to a range of keys
+		char word[UR_FILTER_WORD_LEN];
+		if (ur_filter_read_word(p, word) != 0 || ur_filter_parse_key(p, leaf, word, &key) != 0) {
+			return -1;
+		}
+		ur_filter_key_limits(type, ur_size_of(type), &min, &max);
+		switch (op) {
+		case 0:
+			ur_filter_add_range(p, leaf, key, key);
+			break;
+		case 1:
+			ur_filter_add_range(p, leaf, key, key);
+			leaf->negate = 1;
+			break;
+		case 2:
+			ur_filter_add_range(p, leaf, min, key);
+			break;
+		case 3:
+			ur_filter_add_range(p, leaf, key, max);
+			break;
+		case 4:
+			if (key > min) {
+				ur_filter_add_range(p, leaf, min, key - 1);
+			}
+			break;
+		case 5:
+			if (key < max) {
+				ur_filter_add_range(p, leaf, key + 1, max);
+			}
+			break;
+		}
+	}
+	if (p->err[0] != '\0') {
+		return -1;
+	}
+	return ur_filter_emit(p, UR_FILTER_OP_LEAF, p->filter->leaf_count - 1);
+}
+
+static int ur_filter_parse_or(ur_filter_parser_t *p);
+
+static int ur_filter_parse_unary(ur_filter_parser_t *p)
+{
+	if (ur_filter_accept(p, "!")) {
+		if (ur_filter_parse_unary(p) != 0) {
+			return -1;
+		}
+		return ur_filter_emit(p, UR_FILTER_OP_NOT, 0);
+	}
+	if (ur_filter_accept(p, "(")) {
+		if (ur_filter_parse_or(p) != 0) {
+			return -1;
+		}
+		if (!ur_filter_accept(p, ")")) {
+			ur_filter_error(p, "Expected )", "");
+			return -1;
+		}
+		return 0;
+	}
+	return ur_filter_parse_predicate(p);
+}
+
+static int ur_filter_parse_and(ur_filter_parser_t *p)
+{
+	if (ur_filter_parse_unary(p) != 0) {
+		return -1;
+	}
+	while (ur_filter_accept(p, "&&")) {
+		if (ur_filter_parse_unary(p) != 0 || ur_filter_emit(p, UR_FILTER_OP_AND, 0) != 0) {
+			return -1;
+		}
+	}
+	return 0;
+}
+
+static int ur_filter_parse_or(ur_filter_parser_t *p)
+{
+	if (ur_filter_parse_and(p) != 0) {
+		return -1;
+	}
+	while (ur_filter_accept(p, "||")) {
+		if (ur_filter_parse_and(p) != 0 || ur_filter_emit(p, UR_FILTER_OP_OR, 0) != 0) {
+			return -1;
+		}
+	}
+	return 0;
+}
+
+ur_filter_t *ur_filter_compile(const char *expr, const ur_template_t *tmplt, char **errstr)
+{
+	ur_filter_parser_t p;
+	ur_filter_t *f;
+
+	memset(&p, 0, sizeof(p));
+	p.expr = p.pos = expr;
+	f = calloc(1, sizeof(ur_filter_t));
+	if (f == NULL) {
+		snprintf(p.err, sizeof(p.err), "%s", UR_MEMORY_ERROR);
+		goto error;
+	}
+	f->tmplt = tmplt;
+	p.filter = f;
+	if (expr == NULL || tmplt == NULL) {
+		snprintf(p.err, sizeof(p.err), "Missing filter or template");
+		goto error;
+	}
+	if (ur_filter_parse_or(&p) != 0) {
+		goto error;
+	}
+	ur_filter_skip_space(&p);
+	if (*p.pos != '\0') {
+		ur_filter_error(&p, "Unexpected characters", "");
+		goto error;
+	}
+	f->stack = malloc(f->max_depth * UR_FILTER_BLOCK_WORDS * sizeof(uint64_t));
+	f->keys = malloc(UR_FILTER_BLOCK * sizeof(uint64_t));
+	f->mask = malloc(UR_FILTER_BLOCK);
+	if (f->stack == NULL || f->keys == NULL || f->mask == NULL) {
+		snprintf(p.err, sizeof(p.err), "%s", UR_MEMORY_ERROR);
+		goto error;
+	}
+	return f;
+
+error:
+	if (errstr != NULL) {
+		*errstr = (char *) malloc(strlen(p.err) + 1);
+		if (*errstr != NULL) {
+			strcpy(*errstr, p.err);
+		}
+	}
+	ur_filter_free(f);
+	return NULL;
+}
+
+void ur_filter_free(ur_filter_t *filter)
+{
+	if (filter == NULL) {
+		return;
+	}
+	for (uint32_t i = 0; i < filter->leaf_count; i++) {
+		ur_filter_leaf_t *leaf = &filter->leaves[i];
+		if (leaf->kind == UR_FILTER_STRING) {
+			for (uint32_t j = 0; j < leaf->count; j++) {
+				free(leaf->str[j]);
+			}
+		}
+		free(leaf->lo);
+		free(leaf->hi);
+		free(leaf->str);
+		free(leaf->len);
+	}
+	free(filter->leaves);
+	free(filter->code);
+	free(filter->stack);
+	free(filter->keys);
+	free(filter->mask);
+	free(filter);
+}
+
+/* Evaluation */
+
+/** Get keys of values of an integer field of up to 32 bits of n records. */
+static void ur_filter_load_keys32(const ur_filter_leaf_t *leaf, const void **recs, uint32_t n, uint32_t *keys)
+{
+	uint16_t off = leaf->offset;
+	uint32_t i;
+
+	switch (leaf->type) {
+	case UR_TYPE_CHAR:
+	case UR_TYPE_UINT8:
+		for (i = 0; i < n; i++) {
+			keys[i] = *((const uint8_t *) recs[i] + off);
+		}
+		break;
+	case UR_TYPE_INT8:
+		for (i = 0; i < n; i++) {
+			keys[i] = ur_filter_int32_key(*(const int8_t *) ((const char *) recs[i] + off));
+		}
+		break;
+	case UR_TYPE_UINT16:
+		for (i = 0; i < n; i++) {
+			keys[i] = *(const uint16_t *) ((const char *) recs[i] + off);
+		}
+		break;
+	case UR_TYPE_INT16:
+		for (i = 0; i < n; i++) {
+			keys[i] = ur_filter_int32_key(*(const int16_t *) ((const char *) recs[i] + off));
+		}
+		break;
+	case UR_TYPE_UINT32:
+		for (i = 0; i < n; i++) {
+			keys[i] = *(const uint32_t *) ((const char *) recs[i] + off);
+		}
+		break;
+	case UR_TYPE_INT32:
+		for (i = 0; i < n; i++) {
+			keys[i] = ur_filter_int32_key(*(const int32_t *) ((const char *) recs[i] + off));
+		}
+		break;
+	}
+}
+
+/** Get keys of values of a 64-bit or floating point field of n records. */
+static void ur_filter_load_keys64(const ur_filter_leaf_t *leaf, const void **recs, uint32_t n, uint64_t *keys)
+{
+	uint16_t off = leaf->offset;
+	uint32_t i;
+
+	switch (leaf->type) {
+	case UR_TYPE_UINT64:
+		for (i = 0; i < n; i++) {
+			keys[i] = *(const uint64_t *) ((const char *) recs[i] + off);
+		}
+		break;
+	case UR_TYPE_INT64:
+		for (i = 0; i < n; i++) {
+			keys[i] = ur_filter_int_key(*(const int64_t *) ((const char *) recs[i] + off));
+		}
+		break;
+	case UR_TYPE_FLOAT:
+		for (i = 0; i < n; i++) {
+			keys[i] = ur_filter_double_key(*(const float *) ((const char *) recs[i] + off));
+		}
+		break;
+	case UR_TYPE_DOUBLE:
+		for (i = 0; i < n; i++) {
+			keys[i] = ur_filter_double_key(*(const double *) ((const char *) recs[i] + off));
+		}
+		break;
+	}
+}
+
+/* Kernels comparing keys of a block of records, they are written so that
+ * a compiler vectorizes them. lo <= key <= hi is tested by a single unsigned
+ * comparison (key - lo) <= (hi - lo). The first range sets the mask, other
+ * ranges are added to it. */
+
+static void ur_filter_range32(uint8_t *restrict mask, const uint32_t *restrict keys, uint32_t lo, uint32_t width, uint32_t n, int first)
+{
+	uint32_t i;
+	if (first) {
+		for (i = 0; i < n; i++) {
+			mask[i] = (keys[i] - lo) <= width;
+		}
+	} else {
+		for (i = 0; i < n; i++) {
+			mask[i] |= (keys[i] - lo) <= width;
+		}
+	}
+}
+
+static void ur_filter_range64(uint8_t *restrict mask, const uint64_t *restrict keys, uint64_t lo, uint64_t width, uint32_t n, int first)
+{
+	uint32_t i;
+	if (first) {
+		for (i = 0; i < n; i++) {
+			mask[i] = (keys[i] - lo) <= width;
+		}
+	} else {
+		for (i = 0; i < n; i++) {
+			mask[i] |= (keys[i] - lo) <= width;
+		}
+	}
+}
+
+/** Evaluate a predicate for n records, the result is stored in f->mask (one byte per record). */
+static void ur_filter_eval_leaf(ur_filter_t *f, const ur_filter_leaf_t *leaf, const void **recs, uint32_t n)
+{
+	const uint64_t *lo, *hi;
+	uint64_t *keys = f->keys;
+	uint8_t *mask = f->mask;
+	uint32_t i, j, count;
+	uint16_t off;
+
+	// rest of the last word is cleared for packing of the mask
+	memset(mask + n, 0, UR_FILTER_BITMAP_WORDS(n) * 64 - n);
+	switch (leaf->kind) {
+	case UR_FILTER_NUMERIC:
+		if (leaf->count == 0) {
+			memset(mask, 0, n);
+		} else if (ur_filter_is_wide(leaf->type)) {
+			ur_filter_load_keys64(leaf, recs, n, keys);
+			for (j = 0; j < leaf->count; j++) {
+				ur_filter_range64(mask, keys, leaf->lo[j], leaf->hi[j] - leaf->lo[j], n, j == 0);
+			}
+		} else {
+			ur_filter_load_keys32(leaf, recs, n, (uint32_t *) keys);
+			for (j = 0; j < leaf->count; j++) {
+				ur_filter_range32(mask, (uint32_t *) keys, leaf->lo[j], leaf->hi[j] - leaf->lo[j], n, j == 0);
+			}
+		}
+		break;
+	case UR_FILTER_IP:
+		// 64-bit comparisons are not vectorized without SSE4, so addresses are compared directly in records
+		// stores to mask may alias anything, so the predicate is kept in local variables
+		off = leaf->offset;
+		count = leaf->count;
+		lo = leaf->lo;
+		hi = leaf->hi;
+		if (count == 1) {
+			// a single prefix is the common case
+			uint64_t m0 = lo[0], m1 = lo[1], v0 = hi[0], v1 = hi[1];
+			for (i = 0; i < n; i++) {
+				const uint64_t *ip = (const uint64_t *) ((const char *) recs[i] + off);
+				mask[i] = ((ip[0] & m0) == v0) & ((ip[1] & m1) == v1);
+			}
+			break;
+		}
+		for (i = 0; i < n; i++) {
+			const uint64_t *ip = (const uint64_t *) ((const char *) recs[i] + off);
+			uint8_t match = 0;
+			for (j = 0; j < count; j++) {
+				match |= ((ip[0] & lo[2 * j]) == hi[2 * j]) & ((ip[1] & lo[2 * j + 1]) == hi[2 * j + 1]);
+			}
+			mask[i] = match;
+		}
+		break;
+	case UR_FILTER_STRING:
+		for (i = 0; i < n; i++) {
+			const char *rec = recs[i];
+			const uint16_t *var = (const uint16_t *) (rec + leaf->offset);
+			const char *value = rec + f->tmplt->static_size + var[0];
+			mask[i] = 0;
+			for (j = 0; j < leaf->count; j++) {
+				if (var[1] == leaf->len[j] && memcmp(value, leaf->str[j], var[1]) == 0) {
+					mask[i] = 1;
+					break;
+				}
+			}
+		}
+		break;
+	}
+}
+
+/** Pack 64 bytes of a mask (0 or 1) to bits of a word. */
+static inline uint64_t ur_filter_pack(const uint8_t *mask)
+{
+	uint64_t bits = 0;
+	for (int i = 0; i < 8; i++) {
+		const uint8_t *m = mask + i * 8;
+		uint64_t x = (uint64_t) m[0] | (uint64_t) m[1] << 8 | (uint64_t) m[2] << 16 | (uint64_t) m[3] << 24 |
+		             (uint64_t) m[4] << 32 | (uint64_t) m[5] << 40 | (uint64_t) m[6] << 48 | (uint64_t) m[7] << 56;
+		// the multiplication moves bit 0 of byte k to bit 56 + k, without carries
+		bits |= ((x * 0x0102040810204080ULL) >> 56) << (i * 8);
+	}
+	return bits;
+}
+
+/** Evaluate the program for a block of at most UR_FILTER_BLOCK records. */
+static uint32_t ur_filter_eval_block(ur_filter_t *f, const void **recs, uint32_t n, uint64_t *bitmap)
+{
+	uint32_t words = UR_FILTER_BITMAP_WORDS(n), sp = 0, w, selected = 0;
+	uint64_t *top = NULL;
+
+	for (uint32_t pc = 0; pc < f->code_count; pc++) {
+		const ur_filter_instr_t *instr = &f->code[pc];
+		switch (instr->op) {
+		case UR_FILTER_OP_LEAF: {
+			const ur_filter_leaf_t *leaf = &f->leaves[instr->leaf];
+			uint64_t negate = leaf->negate ? UINT64_MAX : 0;
+			ur_filter_eval_leaf(f, leaf, recs, n);
+			top = f->stack + sp++ * UR_FILTER_BLOCK_WORDS;
+			for (w = 0; w < words; w++) {
+				top[w] = ur_filter_pack(f->mask + w * 64) ^ negate;
+			}
+			break;
+		}
+		case UR_FILTER_OP_AND:
+			top = f->stack + (--sp - 1) * UR_FILTER_BLOCK_WORDS;
+			for (w = 0; w < words; w++) {
+				top[w] &= top[w + UR_FILTER_BLOCK_WORDS];
+			}
+			break;
+		case UR_FILTER_OP_OR:
+			top = f->stack + (--sp - 1) * UR_FILTER_BLOCK_WORDS;
+			for (w = 0; w < words; w++) {
+				top[w] |= top[w + UR_FILTER_BLOCK_WORDS];
+			}
+			break;
+		case UR_FILTER_OP_NOT:
+			for (w = 0; w < words; w++) {
+				top[w] = ~top[w];
+			}
+			break;
+		}
+	}
+	// bits after the last record may be set by negation
+	if (n % 64 != 0) {
+		top[words - 1] &= ((uint64_t) 1 << (n % 64)) - 1;
+	}
+	for (w = 0; w < words; w++) {
+		bitmap[w] = top[w];
+		selected += __builtin_popcountll(top[w]);
+	}
+	return selected;
+}
+
+uint32_t ur_filter_eval_batch(ur_filter_t *filter, const void **recs, uint32_t count, uint64_t *bitmap)
+{
+	uint32_t selected = 0;
+	for (uint32_t i = 0; i < count; i += UR_FILTER_BLOCK) {
+		uint32_t n = count - i < UR_FILTER_BLOCK ? count - i : UR_FILTER_BLOCK;
+		selected += ur_filter_eval_block(filter, recs + i, n, bitmap + i / 64);
+	}
+	return selected;
+}
+
+int ur_filter_eval(ur_filter_t *filter, const void *rec)
+{
+	uint64_t bitmap;
+	return ur_filter_eval_block(filter, &rec, 1, &bitmap);
+}
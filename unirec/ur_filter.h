@@ -0,0 +1,134 @@
+/**
+ * \file ur_filter.h
+ * \brief Filter of UniRec records compiled from an expression.
+ * Implementation is in ur_filter.c.
+ * An expression such as "PROTOCOL == 6 && DST_PORT in [80, 443] && SRC_IP in 10.0.0.0/8"
+ * is compiled against a template into a flat program, which is evaluated
+ * either for a single record or for a whole array of records at once. In the
+ * latter case, every predicate is evaluated over a block of records by a tight
+ * loop and results are combined as bitmaps.
+ */
+/*
+ * Copyright (C) 2026 CESNET
+ *
+ * LICENSE TERMS
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name of the Company nor the names of its contributors
+ *    may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ *
+ * ALTERNATIVELY, provided that this notice is retained in full, this
+ * product may be distributed under the terms of the GNU General Public
+ * License (GPL) version 2 or later, in which case the provisions
+ * of the GPL apply INSTEAD OF those given above.
+ *
+ * This software is provided ``as is'', and any express or implied
+ * warranties, including, but not limited to, the implied warranties of
+ * merchantability and fitness for a particular purpose are disclaimed.
+ * In no event shall the company or contributors be liable for any
+ * direct, indirect, incidental, special, exemplary, or consequential
+ * damages (including, but not limited to, procurement of substitute
+ * goods or services; loss of use, data, or profits; or business
+ * interruption) however caused and on any theory of liability, whether
+ * in contract, strict liability, or tort (including negligence or
+ * otherwise) arising in any way out of the use of this software, even
+ * if advised of the possibility of such damage.
+ *
+ */
+#ifndef _UNIREC_FILTER_H_
+#define _UNIREC_FILTER_H_
+
+/**
+ * \defgroup ur_filter Filter API
+ * @{
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include "unirec.h"
+
+/** \brief Number of uint64_t words of a bitmap for given number of records.
+ * \param[in] count Number of records.
+ */
+#define UR_FILTER_BITMAP_WORDS(count) (((count) + 63) / 64)
+
+/** \brief Compiled filter (opaque structure). */
+typedef struct ur_filter_s ur_filter_t;
+
+/** \brief Compile filter expression.
+ * Grammar of the expression:
+ * - expr: expr "||" expr, expr "&&" expr, "!" expr, "(" expr ")" or predicate
+ * - predicate: FIELD op value, where op is one of ==, !=, <, <=, >, >=
+ * - predicate: FIELD in [item, item, ...] or FIELD in item
+ * - item of a numeric field: value or range lo..hi (inclusive)
+ * - item of ipaddr field: address or prefix, e.g. 10.0.0.0/8 or 2001:db8::/32
+ * - item of string or bytes field: "literal" (only ==, != and in are allowed)
+ *
+ * Integers are decimal or hexadecimal with 0x prefix, char fields are
+ * compared as uint8. Fields of type time are not supported.
+ * Offsets of fields are taken from the template, the filter must be compiled
+ * again when the template changes.
+ * \param[in] expr Filter expression.
+ * \param[in] tmplt Template of filtered records.
+ * \param[out] errstr If not NULL, a description of an error is stored here.
+ *                    It has to be freed by the caller.
+ * \return Pointer to the compiled filter or NULL on error.
+ */
+ur_filter_t *ur_filter_compile(const char *expr, const ur_template_t *tmplt, char **errstr);
+
+/** \brief Evaluate filter for a single record.
+ * \param[in] filter Pointer to the compiled filter.
+ * \param[in] rec Pointer to the record.
+ * \return Non-zero if the record matches the filter, zero otherwise.
+ */
+int ur_filter_eval(ur_filter_t *filter, const void *rec);
+
+/** \brief Evaluate filter for an array of records.
+ * Bit (i % 64) of bitmap[i / 64] is set if i-th record matches the filter.
+ * Records are processed in blocks, a predicate is evaluated for all records
+ * of a block before the next predicate. The filter contains working memory
+ * used by the evaluation, so one filter must not be used by several threads
+ * at once.
+ * \param[in] filter Pointer to the compiled filter.
+ * \param[in] recs Array of pointers to records (e.g. filled by trap_ctx_recv_bulk).
+ * \param[in] count Number of records.
+ * \param[out] bitmap Array of UR_FILTER_BITMAP_WORDS(count) words.
+ * \return Number of matching records.
+ */
+uint32_t ur_filter_eval_batch(ur_filter_t *filter, const void **recs, uint32_t count, uint64_t *bitmap);
+
+/** \brief Destroy compiled filter.
+ * \param[in] filter Pointer to the filter (may be NULL).
+ */
+void ur_filter_free(ur_filter_t *filter);
+
+/** \brief Is i-th record selected in bitmap?
+ * \param[in] bitmap Bitmap filled by ur_filter_eval_batch.
+ * \param[in] i Index of the record.
+ * \return Non-zero if the record is selected.
+ */
+#define ur_filter_is_selected(bitmap, i) \
+   (((bitmap)[(i) / 64] >> ((i) % 64)) & 1)
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
+
+/**
+ * @}
+ */
+
+#endif
+// END OF ur_filter.h
@@ -124,6 +124,12 @@ if [ "$ret" -ne 0 ]; then
    exit "$ret"
 fi
 
+# get templates declared by UR_STATIC_TEMPLATE(name, "spec") as "name:spec"
+tmpltfile="`mktemp`"
+find "$inputdir" \( -name '*.c' -o -name '*.h' -o -name '*.cpp' \) -exec grep -h "^\s*UR_STATIC_TEMPLATE\s*(" {} \; |
+   sed 's/^\s*UR_STATIC_TEMPLATE\s*(\s*\([A-Za-z_][A-Za-z0-9_]*\)\s*,\s*"\([^"]*\)".*$/\1:\2/; s/\s//g' |
+   sort -u > "$tmpltfile"
+
 # generate fields.{c,h}
 awk -F' ' '
 BEGIN {
@@ -177,7 +183,8 @@ hfile=hfile"/************* THIS IS AUTOMATICALLY GENERATED FILE, DO NOT EDIT ***
 hfile=hfile"#include <unirec/unirec.h>\n";
 }
 
-{
+FILENAME == ARGV[1] {
+   types[$2]=$1;
    cnames=cnames"\n   \""$2"\",";
    csizes=csizes"\n   "size_table[$1]", /* "$2" */";
    cstatsizes=cstatsizes"\n   "type_table[$1]", /* "$2" */";
@@ -185,9 +192,58 @@ hfile=hfile"#include <unirec/unirec.h>\n";
    hfile=hfile"\n#define F_"$2"   "field_id;
    hfile=hfile"\n#define F_"$2"_T   "c_types[$1];
    field_id++;
+   next;
+}
+
+# static template, fields are sorted like ur_create_template() does to get constant offsets
+{
+   split($0, tmplt, ":");
+   if (tmplt[1] in tmplt_specs) {
+      printf("Conflicting specifications of UniRec static template (%s)\n", tmplt[1]) > "/dev/stderr";
+      failed=1;
+      exit 1;
+   }
+   tmplt_specs[tmplt[1]]=tmplt[2];
+   n=split(tmplt[2], names, ",");
+   count=0;
+   delete present;
+   for (i = 1; i <= n; i++) {
+      if ((names[i] == "") || (names[i] in present)) {
+         continue;
+      }
+      if (!(names[i] in types)) {
+         printf("UniRec field (%s) of static template (%s) is not defined by UR_FIELDS\n", names[i], tmplt[1]) > "/dev/stderr";
+         failed=1;
+         exit 1;
+      }
+      present[names[i]]=1;
+      size=size_table[types[names[i]]];
+      for (j = count; (j > 0) && ((sizes[j] < size) || ((sizes[j] == size) && (fields[j] > names[i]))); j--) {
+         sizes[j + 1]=sizes[j];
+         fields[j + 1]=fields[j];
+      }
+      sizes[j + 1]=size;
+      fields[j + 1]=names[i];
+      count++;
+   }
+   offset=0;
+   defines="";
+   checks="";
+   for (i = 1; i <= count; i++) {
+      defines=defines"\n#define UR_TMPLT_"tmplt[1]"_F_"fields[i]"   "offset;
+      checks=checks" &&\n          ur_is_present(tmplt, F_"fields[i]") && tmplt->offset[F_"fields[i]"] == "offset;
+      offset+=(sizes[i] < 0) ? 4 : sizes[i];
+   }
+   htmplts=htmplts"\n\n/* Static template "tmplt[1]": "tmplt[2]" */"defines;
+   htmplts=htmplts"\n#define UR_TMPLT_"tmplt[1]"_SIZE   "offset;
+   htmplts=htmplts"\nstatic inline int ur_static_match_"tmplt[1]"(const ur_template_t *tmplt)\n{";
+   htmplts=htmplts"\n   return (tmplt->static_size == "offset checks");\n}";
 }
 
 END {
+if (failed) {
+   exit 1;
+}
 cnames=cnames"\n};";
 csizes=csizes"\n};";
 cstatsizes=cstatsizes"\n};";
@@ -195,18 +251,21 @@ cstatsizes=cstatsizes"\n};";
 hfile=hfile"\n\nextern uint16_t ur_last_id;\n";
 hfile=hfile"extern ur_static_field_specs_t UR_FIELD_SPECS_STATIC;\n";
 hfile=hfile"extern ur_field_specs_t ur_field_specs;\n";
+hfile=hfile htmplts"\n";
 hfile=hfile"\n";
 hfile=hfile"#endif\n";
 
 cfile=cfile"\n"cnames"\n"csizes"\n"cstatsizes
-cfile=cfile"\nur_static_field_specs_t UR_FIELD_SPECS_STATIC = {ur_field_names_static, ur_field_sizes_static, ur_field_types_static, "NR"};\n"
-cfile=cfile"ur_field_specs_t ur_field_specs = {ur_field_names_static, ur_field_sizes_static, ur_field_types_static, "NR", "NR", "NR", NULL, UR_UNINITIALIZED};"
+cfile=cfile"\nur_static_field_specs_t UR_FIELD_SPECS_STATIC = {ur_field_names_static, ur_field_sizes_static, ur_field_types_static, "field_id"};\n"
+cfile=cfile"ur_field_specs_t ur_field_specs = {ur_field_names_static, ur_field_sizes_static, ur_field_types_static, "field_id", "field_id", "field_id", NULL, UR_UNINITIALIZED};"
 
 
 print hfile > "'"$outputdir/fields.h"'";
 print cfile > "'"$outputdir/fields.c"'";
 }
-' "$tempfile"
+' "$tempfile" "$tmpltfile"
 
-rm "$tempfile"
+ret=$?
+rm "$tempfile" "$tmpltfile"
+exit "$ret"
 